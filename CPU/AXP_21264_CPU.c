@@ -28,6 +28,25 @@
  *	V01.001		01-Jan-2018	Jonathan D. Belanger
  *	Added a call to pthread_once to make sure the mutex handling code has been
  *	initialized.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	The System is also given the address of the Cbox sleeping flag, so that an
+ *	interrupt only signals the Cbox when it is waiting.
+ *
+ *	V01.003		19-Oct-2026	Jonathan D. Belanger
+ *	The ROB no longer has a mutex to initialize.
+ *
+ *	V01.004		19-Oct-2026	Jonathan D. Belanger
+ *	The System now gives the CPU the address of its skid buffers, which is
+ *	where the CPU fills in the requests it queues up to the System.
+ *
+ *	V01.005		19-Oct-2026	Jonathan D. Belanger
+ *	The System also gives the CPU the address of its flag to redo the IRQ_H
+ *	bits, which the CPU sets when it takes IRQ<1>.
+ *
+ *	V01.006		19-Oct-2026	Jonathan D. Belanger
+ *	The System is given the address of the flag the CPU sets when it is
+ *	waiting for one of its skid buffers to be released.
  */
 #include "CPU/AXP_21264_CPUDefs.h"
 #include "CPU/Cbox/AXP_21264_Cbox.h"
@@ -76,8 +95,6 @@ void *AXP_21264_AllocateCPU(u64 cpuID)
       pthreadRet = pthread_mutex_init(&cpu->iBoxMutex, NULL);
   if (pthreadRet == 0)
       pthreadRet = pthread_mutex_init(&cpu->iBoxIPRMutex, NULL);
-  if (pthreadRet == 0)
-      pthreadRet = pthread_mutex_init(&cpu->robMutex, NULL);
   if (pthreadRet == 0)
       pthreadRet = pthread_mutex_init(&cpu->iCacheMutex, NULL);
   if (pthreadRet == 0)
@@ -315,13 +332,14 @@ void AXP_21264_Save_WHAMI(void *cpuPtr, u64 *cpuID)
  *	rq:
  *		A pointer to the System Interface request queue, where requests from
  *		the CPU will be queued up for processing by the System.
- *	rqStart:
- *		A pointer to the System Interface request queue starting entry.  This
- *		is the location where the System will remove entries for processing.
- *	rqEnd:
- *		A pointer to the System Interface request queue last entry.  This is
- *		incremented to the next location where the CPU will add entries to be
- *		processed by the System.
+ *	skidBuffers:
+ *		A pointer to the AXP_21264_CCHIP_RQ_LEN skid buffers set aside for this
+ *		CPU.  The CPU fills these in, in order, and inserts them onto the
+ *		request queue.  The System marks them as no longer in use once it has
+ *		processed them.
+ *	irqUpdate:
+ *		A pointer to the System's flag that has it redo the IRQ_H bits for
+ *		all the CPUs.
  *
  * Output Parameters:
  * 	cpuMutex:
@@ -345,6 +363,13 @@ void AXP_21264_Save_WHAMI(void *cpuPtr, u64 *cpuID)
  *	irq_H:
  *		A pointer to an unsigned 8-bit value where the System can store the
  *		interrupts for the CPU to process.
+ *	sleeping:
+ *		A pointer to a boolean the Cbox sets while it is waiting for something
+ *		to do.  The System only needs to signal the Cbox when this is set.
+ *	skidWait:
+ *		A pointer to a boolean the CPU sets when it found all its skid buffers
+ *		in use.  The System only needs to signal the Cbox, when it releases
+ *		one, if this is set.
  *
  * Return Values:
  *	None.
@@ -357,9 +382,13 @@ void AXP_21264_Save_SystemInterfaces(
     u8 **pqTop,
     u8 **pqBottom,
     u8 **irq_H,
+    bool **sleeping,
+    bool **skidWait,
     pthread_mutex_t *sysMutex,
     pthread_cond_t *sysCond,
-    AXP_QUEUE_HDR *rq)
+    AXP_QUEUE_HDR *rq,
+    void *skidBuffers,
+    bool *irqUpdate)
 {
     AXP_21264_CPU *cpu = (AXP_21264_CPU *) cpuPtr;
 
@@ -370,6 +399,10 @@ void AXP_21264_Save_SystemInterfaces(
     cpu->system.cond = sysCond;
     cpu->system.mutex = sysMutex;
     cpu->system.rq = rq;
+    cpu->system.skidBuffers = (AXP_21264_RQ_ENTRY *) skidBuffers;
+    cpu->system.irqUpdate = irqUpdate;
+    cpu->system.skidEnd = 0;
+    cpu->system.skidWait = false;
 
     /*
      * Finally, set the data needed for the System to be able to communicate
@@ -381,6 +414,8 @@ void AXP_21264_Save_SystemInterfaces(
     *pqTop = &cpu->pqTop;
     *pqBottom = &cpu->pqBottom;
     *irq_H = &cpu->irqH;
+    *sleeping = &cpu->cBoxSleeping;
+    *skidWait = &cpu->system.skidWait;
 
     /*
      * Return back to the caller.
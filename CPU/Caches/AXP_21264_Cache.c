@@ -56,6 +56,12 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.007 19-Oct-2026 Jonathan D. Belanger
+ *  Implemented the Icache line and set predictors.  Each fetch block is
+ *  trained with where the fetch after it came from, and the next line is
+ *  predicted in the set it is actually in.  Filling or flushing an Icache
+ *  block clears its predictions.
  */
 #include "CPU/Caches/AXP_21264_Cache.h"
 #include "CommonUtilities/AXP_Trace.h"
@@ -2126,6 +2132,10 @@ void AXP_IcacheAdd(AXP_21264_CPU *cpu,
     cpu->iCache[index][whichSet].pal = pc.pal;
     cpu->iCache[index][whichSet].vb = 1;
     cpu->iCache[index][whichSet].tag = tag;
+    for (ii = 0; ii < AXP_ICACHE_FETCH_BLKS; ii++)
+    {
+        cpu->iCache[index][whichSet].linePred[ii].vb = 0;
+    }
     for (ii = 0; ii < AXP_ICACHE_LINE_INS; ii++)
     {
         cpu->iCache[index][whichSet].instructions[ii].instr = nextInst[ii];
@@ -2207,6 +2217,10 @@ void AXP_IcacheFlush(AXP_21264_CPU *cpu, bool purgeAsm)
                 cpu->iCache[ii][0].pal = 0;
                 cpu->iCache[ii][0].vb = 0;
                 cpu->iCache[ii][0].tag = 0;
+                for (jj = 0; jj < AXP_ICACHE_FETCH_BLKS; jj++)
+                {
+                    cpu->iCache[ii][0].linePred[jj].vb = 0;
+                }
                 for (jj = 0; jj < AXP_ICACHE_LINE_INS; jj++)
                 {
                     memset(&cpu->iCache[ii][0].instructions[jj],
@@ -2233,6 +2247,10 @@ void AXP_IcacheFlush(AXP_21264_CPU *cpu, bool purgeAsm)
                 cpu->iCache[ii][1].pal = 0;
                 cpu->iCache[ii][1].vb = 0;
                 cpu->iCache[ii][1].tag = 0;
+                for (jj = 0; jj < AXP_ICACHE_FETCH_BLKS; jj++)
+                {
+                    cpu->iCache[ii][1].linePred[jj].vb = 0;
+                }
                 for (jj = 0; jj < AXP_ICACHE_LINE_INS; jj++)
                 {
                     memset(&cpu->iCache[ii][1].instructions[jj],
@@ -2286,7 +2304,10 @@ bool AXP_IcacheFetch(AXP_21264_CPU *cpu, AXP_PC pc, AXP_INS_LINE *next)
 {
     bool retVal = false;
     AXP_VPC vpc = {.pc = pc};
+    AXP_VPC nextVPC;
     AXP_PC tmpPC;
+    AXP_ICACHE_LINE_PRED *pred;
+    u32 block;
     u32 index = vpc.vpcFields.index;
     u64 tag = vpc.vpcFields.tag;
     u32 offset = vpc.vpcFields.offset % AXP_ICACHE_LINE_INS;
@@ -2357,46 +2378,78 @@ bool AXP_IcacheFetch(AXP_21264_CPU *cpu, AXP_PC pc, AXP_INS_LINE *next)
             tmpPC.pc++;
         }
 
+        /*
+         * Score and train the line and set predictors.  The prediction made
+         * on the previous fetch is compared against where this fetch actually
+         * came from, and then the fetch block that prediction was made for
+         * learns this location for the next time it is executed.
+         */
+        block = offset / AXP_NUM_FETCH_INS;
+        if (next->fetchValid == true)
+        {
+            if ((next->linePrediction == index) &&
+                (next->setPrediction == whichSet))
+            {
+                cpu->iCacheStats.linePredHits++;
+            }
+            else
+            {
+                cpu->iCacheStats.linePredMisses++;
+            }
+            pred = &cpu->iCache[next->fetchIndex % AXP_CACHE_ENTRIES]
+                               [next->fetchSet % AXP_2_WAY_CACHE]
+                               .linePred[next->fetchBlock %
+                                         AXP_ICACHE_FETCH_BLKS];
+            pred->index = index;
+            pred->set = whichSet;
+            pred->vb = 1;
+        }
+        next->fetchIndex = index;
+        next->fetchSet = whichSet;
+        next->fetchBlock = block;
+        next->fetchValid = true;
+
         /*
          * Line (index) and Set prediction, at this point, should indicate the
          * next instruction to be read from the cache (it could be the current
          * list and set).  The following logic is used:
          *
-         * If there are instructions left in the current cache line, then we
-         *       use the same line and set
+         * If this fetch block has been trained, then we use its prediction
          * Otherwise,
-         *   If we are only utilizing a single set, then we go to the next line
-         *       and the same set
+         *   If there are instructions left in the current cache line, then we
+         *       use the same line and set
          *   Otherwise,
-         *       If we are at the first set, then we go to the next set on the
-         *           same line
-         *       Otherwise,
-         *           We go to the next line and the first set.
+         *       We go to the next line, and the set that line is in (the
+         *           first set if it is not in the Icache).
          *
-         * NOTE: When the prediction code is run, it may recalculate these
-         *        values.
+         * The set prediction is used to pick the set that is looked at first
+         * on the next fetch.
          */
-        if ((offset + AXP_NUM_FETCH_INS + 1) < AXP_ICACHE_LINE_INS)
+        pred = &cpu->iCache[index][whichSet].linePred[block];
+        if (pred->vb == 1)
+        {
+            next->linePrediction = pred->index;
+            next->setPrediction = pred->set;
+        }
+        else if ((offset + AXP_NUM_FETCH_INS) < AXP_ICACHE_LINE_INS)
         {
             next->linePrediction = index; /* same line */
             next->setPrediction = whichSet; /* same set */
         }
         else
         {
-            if (sets == 1)
+            nextVPC.pc = pc;
+            nextVPC.pc.pc += AXP_ICACHE_LINE_INS - offset;
+            next->linePrediction = nextVPC.vpcFields.index; /* next line */
+            next->setPrediction = 0;
+            for (ii = 0; ii < sets; ii++)
             {
-                next->linePrediction = index + 1; /* next line */
-                next->setPrediction = 0; /* only set */
-            }
-            else if (whichSet == 0)
-            {
-                next->linePrediction = index + 1; /* same line */
-                next->setPrediction = 1; /* second set */
-            }
-            else
-            {
-                next->linePrediction = index + 1; /* next line */
-                next->setPrediction = 0; /* first set */
+                if ((cpu->iCache[nextVPC.vpcFields.index][ii].vb == 1) &&
+                    (cpu->iCache[nextVPC.vpcFields.index][ii].tag ==
+                     nextVPC.vpcFields.tag))
+                {
+                    next->setPrediction = ii;
+                }
             }
         }
     }
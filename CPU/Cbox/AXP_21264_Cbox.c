@@ -53,6 +53,35 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.007 19-Oct-2026 Jonathan D. Belanger
+ *  AXP_21264_Set_IRQ was locking the interface mutex a second time, instead
+ *  of unlocking it, so an interrupt could never wake a parked CPU.
+ *
+ *  V01.008 19-Oct-2026 Jonathan D. Belanger
+ *  The IRQ_H bits are set with an atomic OR, and the Cbox is only signaled
+ *  when it is waiting for something to do.
+ *
+ *  V01.009 19-Oct-2026 Jonathan D. Belanger
+ *  All the IOWB entries waiting to be processed are sent to the System each
+ *  time through the loop, rather than just the first one.
+ *
+ *  V01.010 19-Oct-2026 Jonathan D. Belanger
+ *  The same is now done for the MAF entries.  Initialize the MAF hash buckets
+ *  and statistics, and trace the statistics when shutting down.
+ *
+ *  V01.011 19-Oct-2026 Jonathan D. Belanger
+ *  A VDB entry the System does not have room for does not count as work done,
+ *  so the Cbox waits for the System to release a skid buffer, rather than
+ *  spinning.
+ *
+ *  V01.012 19-Oct-2026 Jonathan D. Belanger
+ *  The MAF entries are initialized as not sent, and the number of waiting
+ *  I-stream requests replaced by a newer one is traced at shutdown.
+ *
+ *  V01.013 19-Oct-2026 Jonathan D. Belanger
+ *  In the Sleep state, the Cbox waits for an interrupt to wake the CPU, rather
+ *  than spinning, and then marks the CPU busy again for the timers.
  */
 #include "CPU/Cbox/AXP_21264_Cbox.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -67,6 +96,7 @@
 #include "CPU/Ibox/AXP_21264_Ibox_PCHandling.h"
 #include "CommonUtilities/AXP_Trace.h"
 #include "CommonUtilities/AXP_Dumps.h"
+#include "CommonUtilities/AXP_TimerWheel.h"
 
 /*
  * Local Variables
@@ -755,8 +785,9 @@ AXP_21264_Process_IRQ(AXP_21264_CPU *cpu)
  *  This function is called by the system to set Interrupt Request Queue (IRQ)
  *  flags.
  *
- *  NOTE:   This function will lock the Cbox Interface Mutex, set the IRQ_H
- *          flags, signal the Cbox Interface Condition variable, and finally
+ *  NOTE:   This function will set the IRQ_H flags without a lock.  Only when
+ *          new flags were set and the Cbox is waiting, will it lock the Cbox
+ *          Interface Mutex, signal the Cbox Interface Condition variable, and
  *          unlock the mutex.
  *
  * Input Parameters:
@@ -775,26 +806,26 @@ AXP_21264_Process_IRQ(AXP_21264_CPU *cpu)
 void
 AXP_21264_Set_IRQ(AXP_21264_CPU *cpu, u8 flags)
 {
-
-    /*
-     * Before we do anything, lock the interface mutex to prevent multiple
-     * accessors.
-     */
-    pthread_mutex_lock(&cpu->cBoxInterfaceMutex);
+    u8 prev;
 
     /*
      * The Cbox may not have processed all the previous interrupts the system
      * sent to the Cbox, so OR the bits here with the ones that may have been
      * set previously.
      */
-    cpu->irqH |= flags;
+    prev = __atomic_fetch_or(&cpu->irqH, flags, __ATOMIC_SEQ_CST);
 
     /*
-     * Let the Cbox know there is something for it to process, then unlock the
-     * mutex so it can.
+     * If something new was set and the Cbox is waiting, let it know there is
+     * something for it to process.
      */
-    pthread_cond_signal(&cpu->cBoxInterfaceCond);
-    pthread_mutex_lock(&cpu->cBoxInterfaceMutex);
+    if (((prev & flags) != flags) &&
+        (__atomic_load_n(&cpu->cBoxSleeping, __ATOMIC_SEQ_CST) == true))
+    {
+        pthread_mutex_lock(&cpu->cBoxInterfaceMutex);
+        pthread_cond_signal(&cpu->cBoxInterfaceCond);
+        pthread_mutex_unlock(&cpu->cBoxInterfaceMutex);
+    }
 
     /*
      * Return back to the caller.
@@ -873,12 +904,20 @@ AXP_21264_Cbox_Init(AXP_21264_CPU *cpu)
         cpu->maf[ii].dataLen = 0;
         cpu->maf[ii].bufLen = 0;
         cpu->maf[ii].valid = false;
-        cpu->maf[ii].complete = false;
+        cpu->maf[ii].sent = false;
         cpu->maf[ii].shared = false;
         cpu->maf[ii].ioReq = false;
+        cpu->maf[ii].hashNext = -1;
         for (jj = 0; jj < AXP_21264_MBOX_MAX; jj++)
             cpu->maf[ii].lqSqEntry[jj] = 0;
     }
+    for (ii = 0; ii < AXP_21264_MAF_HASH_LEN; ii++)
+    {
+        cpu->mafHash[ii] = -1;
+    }
+    cpu->mafWaitTop = 0;
+    cpu->mafWaitCount = 0;
+    memset(&cpu->mafStats, 0, sizeof(cpu->mafStats));
     for (ii = 0; ii < AXP_21264_VDB_LEN; ii++)
     {
         cpu->vdb[ii].type = toBcache;
@@ -1238,19 +1277,17 @@ AXP_21264_CboxMain(void *voidPtr)
                  */
                 pthread_mutex_lock(&cpu->cBoxInterfaceMutex);
                 processed = false;
-                if ((entry = AXP_21264_MAF_Empty(cpu)) != -1)
+                if (AXP_21264_Drain_MAF(cpu) == true)
                 {
-                    AXP_21264_Process_MAF(cpu, entry);
                     processed = true;
                 }
-                if ((entry = AXP_21264_VDB_Empty(cpu)) != -1)
+                if (((entry = AXP_21264_VDB_Empty(cpu)) != -1) &&
+                    (AXP_21264_Process_VDB(cpu, entry) == true))
                 {
-                    AXP_21264_Process_VDB(cpu, entry);
                     processed = true;
                 }
-                if ((entry = AXP_21264_IOWB_Empty(cpu)) != -1)
+                if (AXP_21264_Drain_IOWB(cpu) == true)
                 {
-                    AXP_21264_Process_IOWB(cpu, entry);
                     processed = true;
                 }
                 if ((entry = AXP_21264_PQ_Empty(cpu)) != -1)
@@ -1258,7 +1295,13 @@ AXP_21264_CboxMain(void *voidPtr)
                     AXP_21264_Process_PQ(cpu, entry);
                     processed = true;
                 }
-                if (cpu->irqH != 0)
+
+                /*
+                 * If the CPU has gone to sleep, the interrupt is left for
+                 * the Sleep state to wake it up with.
+                 */
+                if ((__atomic_load_n(&cpu->irqH, __ATOMIC_SEQ_CST) != 0) &&
+                    (cpu->cpuState == Run))
                 {
                     AXP_21264_Process_IRQ(cpu);
                     processed = true;
@@ -1266,12 +1309,24 @@ AXP_21264_CboxMain(void *voidPtr)
 
                 /*
                  * If all the queues were empty, then wait for something to get
-                 * queued up and the condition variable signaled.
+                 * queued up and the condition variable signaled.  Interrupts
+                 * are posted without the mutex, so say we are sleeping, and
+                 * then look at the IRQ_H bits one last time.  Whoever posts
+                 * an interrupt after that sees the flag and signals us.
                  */
                 if (processed == false)
                 {
-                    pthread_cond_wait(&cpu->cBoxInterfaceCond,
-                                      &cpu->cBoxInterfaceMutex);
+                    __atomic_store_n(&cpu->cBoxSleeping,
+                                     true,
+                                     __ATOMIC_SEQ_CST);
+                    if (__atomic_load_n(&cpu->irqH, __ATOMIC_SEQ_CST) == 0)
+                    {
+                        pthread_cond_wait(&cpu->cBoxInterfaceCond,
+                                          &cpu->cBoxInterfaceMutex);
+                    }
+                    __atomic_store_n(&cpu->cBoxSleeping,
+                                     false,
+                                     __ATOMIC_SEQ_CST);
                 }
 
                 /*
@@ -1305,8 +1360,35 @@ AXP_21264_CboxMain(void *voidPtr)
 
                 /*
                  * Need to quiesce everything and put the world to sleep waiting
-                 * just for the wake-up signal.
+                 * just for the wake-up signal.  An interrupt wakes the CPU
+                 * up.  Writing the SLEEP IPR marked the CPU idle for the
+                 * timers, so mark it busy again, before it goes through its
+                 * self initialization and back to running.
                  */
+                pthread_mutex_lock(&cpu->cBoxInterfaceMutex);
+                __atomic_store_n(&cpu->cBoxSleeping, true, __ATOMIC_SEQ_CST);
+                while ((cpu->cpuState == Sleep) &&
+                       (__atomic_load_n(&cpu->irqH, __ATOMIC_SEQ_CST) == 0))
+                {
+                    pthread_cond_wait(&cpu->cBoxInterfaceCond,
+                                      &cpu->cBoxInterfaceMutex);
+                }
+                __atomic_store_n(&cpu->cBoxSleeping, false, __ATOMIC_SEQ_CST);
+                pthread_mutex_unlock(&cpu->cBoxInterfaceMutex);
+                if (cpu->cpuState == Sleep)
+                {
+                    if (AXP_CBOX_OPT2)
+                    {
+                        AXP_TRACE_BEGIN();
+                        AXP_TraceWrite("Cbox is waking up from Sleep State");
+                        AXP_TRACE_END();
+                    }
+                    AXP_TimerIdle(false);
+                    pthread_mutex_lock(&cpu->cpuMutex);
+                    cpu->cpuState = WaitBiSI;
+                    cpu->BiSTState = SystemReset;
+                    pthread_mutex_unlock(&cpu->cpuMutex);
+                }
                 break;
 
             case ShuttingDown:
@@ -1314,6 +1396,21 @@ AXP_21264_CboxMain(void *voidPtr)
                 {
                     AXP_TRACE_BEGIN();
                     AXP_TraceWrite("Cbox is Shutting Down.");
+                    AXP_TraceWrite("MAF allocated %llu, merged %llu, stalled "
+                                   "full %llu, replaced %llu",
+                                   cpu->mafStats.allocated,
+                                   cpu->mafStats.merged,
+                                   cpu->mafStats.fullStalls,
+                                   cpu->mafStats.replaced);
+                    AXP_TraceWrite("MAF average in use %llu.%02llu, most in "
+                                   "use %u",
+                                   (cpu->mafStats.allocated != 0) ?
+                                   (cpu->mafStats.occupancy /
+                                    cpu->mafStats.allocated) : 0,
+                                   (cpu->mafStats.allocated != 0) ?
+                                   ((cpu->mafStats.occupancy * 100 /
+                                     cpu->mafStats.allocated) % 100) : 0,
+                                   cpu->mafStats.maxInUse);
                     AXP_TRACE_END();
                 }
 
@@ -28,6 +28,15 @@
  *  GCC 7.4.0, and possibly earlier, turns on strict-aliasing rules by default.
  *  There are a number of issues in this module where the address of one
  *  variable is cast to extract a value in a different format.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added AXP_21264_Drain_IOWB, so that the Cbox sends all the IOWB entries
+ *  waiting to be processed to the System at once, rather than one each time
+ *  through its loop.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  An IOWB entry is only marked as processed once it has actually been sent to
+ *  the System.  When the System has no room for it, it is sent later.
  */
 #include "CPU/Cbox/AXP_21264_Cbox.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -105,9 +114,8 @@ int AXP_21264_IOWB_Empty(AXP_21264_CPU *cpu)
 }
 
 /*
- * AXP_21264_Process_IOWB
- *  This function is called to check the first unprocessed entry on the queue
- *  containing the IOWB records.
+ * AXP_21264_Build_IOWB
+ *  This function is called to build the System message for an IOWB entry.
  *
  * Input Parameters:
  *  cpu:
@@ -117,15 +125,17 @@ int AXP_21264_IOWB_Empty(AXP_21264_CPU *cpu)
  *      An integer value that is the entry in the IOWB to be processed.
  *
  * Output Parameters:
- *  None.
+ *  sys:
+ *      A pointer to the message to be sent to the System.
  *
  * Return Values:
  *  None.
  */
-void AXP_21264_Process_IOWB(AXP_21264_CPU *cpu, int entry)
+static void AXP_21264_Build_IOWB(AXP_21264_CPU *cpu,
+                                 int entry,
+                                 AXP_21264_SYSBUS_System *sys)
 {
     AXP_21264_CBOX_IOWB *iowb = &cpu->iowb[entry];
-    AXP_21264_SYSBUS_System sys;
 
     /*
      * Process the next IOWB entry that needs it.
@@ -133,44 +143,130 @@ void AXP_21264_Process_IOWB(AXP_21264_CPU *cpu, int entry)
     switch (iowb->storeLen)
     {
         case BYTE_LEN:
-            sys.cmd = WrBytes;
+            sys->cmd = WrBytes;
             break;
 
         case WORD_LEN:
-            sys.cmd = WrBytes;
+            sys->cmd = WrBytes;
             break;
 
         case LONG_LEN:
-            sys.cmd = WrLWs;
+            sys->cmd = WrLWs;
             break;
 
         case QUAD_LEN:
-            sys.cmd = WrQWs;
+            sys->cmd = WrQWs;
             break;
     }
 
     /*
      * Go check the Oldest pending PQ and set the flags for it here and now.
      */
-    AXP_21264_OldestPQFlags(cpu, &sys.m1, &sys.m2, &sys.ch);
+    AXP_21264_OldestPQFlags(cpu, &sys->m1, &sys->m2, &sys->ch);
 
     /*
-     * OK, send what we have to the System.
+     * OK, fill in what we have for the System.
      */
-    sys.id = entry;
-    sys.rv = true;
-    sys.mask = iowb->mask;
-    sys.pa = iowb->pa;
-    memcpy(sys.sysData, iowb->sysData, iowb->bufLen);
-    AXP_21264_SendToSystem(cpu, &sys);
+    sys->id = entry;
+    sys->rv = true;
+    sys->mask = iowb->mask;
+    sys->pa = iowb->pa;
+    memcpy(sys->sysData, iowb->sysData, iowb->bufLen);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21264_Process_IOWB
+ *  This function is called to check the first unprocessed entry on the queue
+ *  containing the IOWB records.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  entry:
+ *      An integer value that is the entry in the IOWB to be processed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_21264_Process_IOWB(AXP_21264_CPU *cpu, int entry)
+{
+    AXP_21264_SYSBUS_System sys;
+
+    AXP_21264_Build_IOWB(cpu, entry, &sys);
+    if (AXP_21264_SendToSystem(cpu, &sys) == true)
+    {
+        cpu->iowb[entry].processed = true;
+    }
 
     /*
-     * Indicate that the entry is now processed and return back to the caller.
+     * Return back to the caller.
      */
-    iowb->processed = true;
     return;
 }
 
+/*
+ * AXP_21264_Drain_IOWB
+ *  This function is called by the Cbox, with the interface mutex locked, to
+ *  send every IOWB entry that has not yet been processed to the System.  The
+ *  entries are taken from the top of the queue, which is the order the I/O
+ *  stores were made, and handed to the System together, so a burst of device
+ *  register writes only costs one trip through the Cbox loop.  If the System
+ *  does not have room for all of them, the ones that did not fit are left to
+ *  be sent the next time through.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   At least one IOWB entry was sent to the System.
+ *  false:  There were no IOWB entries to be processed, or the System did not
+ *          have room for any of them.
+ */
+bool AXP_21264_Drain_IOWB(AXP_21264_CPU *cpu)
+{
+    AXP_21264_SYSBUS_System sys[AXP_21264_IOWB_LEN];
+    int entries[AXP_21264_IOWB_LEN];
+    u32 count = 0;
+    u32 sent;
+    u32 ii;
+    int entry;
+
+    for (ii = 0; ii < AXP_21264_IOWB_LEN; ii++)
+    {
+        entry = (cpu->iowbTop + ii) % AXP_21264_IOWB_LEN;
+        if ((cpu->iowb[entry].valid == true) &&
+            (cpu->iowb[entry].processed == false))
+        {
+            entries[count] = entry;
+            AXP_21264_Build_IOWB(cpu, entry, &sys[count++]);
+        }
+    }
+    sent = AXP_21264_SendToSystemBatch(cpu, sys, count);
+    for (ii = 0; ii < sent; ii++)
+    {
+        cpu->iowb[entries[ii]].processed = true;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (sent > 0);
+}
+
 /*
  * AXP_21264_Merge_IOWB
  *  This function is called to attempt to merge an request for a new I/O Write
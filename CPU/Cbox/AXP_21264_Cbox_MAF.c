@@ -28,6 +28,25 @@
  *  GCC 7.4.0, and possibly earlier, turns on strict-aliasing rules by default.
  *  There are a number of issues in this module where the address of one
  *  variable is cast to extract a value in a different format.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  The MAF entries are chained into hash buckets by block address, so that
+ *  merging and probe checks do not have to look at every entry.  Requests
+ *  that arrive when every MAF entry is in use wait for one, rather than
+ *  overwriting one that is in use.  The Cbox sends all the MAF entries ready
+ *  to go to the System at once, D-stream before I-stream, and counts merges,
+ *  occupancy, and stalls for a full MAF.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  An MAF entry is only marked as sent once the System has taken it, so one
+ *  the System did not have room for is sent the next time through, rather
+ *  than being lost.  Requests waiting for an MAF entry are never dropped.  The
+ *  list is long enough for every LQ and SQ entry, and only the newest I-stream
+ *  request is kept on it, since that is the one the Ibox is waiting for.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Added AXP_21264_Prefetch_MAF, which only takes an Istream prefetch when an
+ *  MAF entry is free for it.
  */
 #include "CPU/Cbox/AXP_21264_Cbox.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -38,6 +57,433 @@
 #include "CPU/Ibox/AXP_21264_Ibox.h"
 #include "CPU/Cbox/SystemInterface/AXP_21264_to_System.h"
 
+/*
+ * The MAF entries are also chained into buckets, by the 64-byte block of their
+ * physical address, so that the ones for an address can be found without
+ * looking at all of them.
+ */
+#define AXP_21264_MAF_HASH(pa)  \
+    (((pa) >> 6) & (AXP_21264_MAF_HASH_LEN - 1))
+
+/*
+ * AXP_21264_MAF_Find
+ *  This function is called to find an MAF entry, not yet sent to the System,
+ *  into which a new request can be merged.  The request has to be to an
+ *  ascending address, within the maximum merge length, of the entry, so the
+ *  entry can only be in the bucket for the block of the request, or for the
+ *  block before it.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  type:
+ *      An enumerated value for the type of MAF entry being requested.
+ *  pa:
+ *      A value representing the physical address of the request.
+ *  dataLen:
+ *      A value indicating the length of the data being requested.
+ *  maxLen:
+ *      A value indicating the longest merged request that is allowed.
+ *  ioReq:
+ *      A boolean indicating that the request is to I/O address space.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL:   There is no MAF entry the request can be merged into.
+ *  !NULL:  A pointer to the MAF entry the request can be merged into.
+ */
+static AXP_21264_CBOX_MAF *AXP_21264_MAF_Find(AXP_21264_CPU *cpu,
+                                              AXP_CBOX_MAF_TYPE type,
+                                              u64 pa,
+                                              int dataLen,
+                                              int maxLen,
+                                              bool ioReq)
+{
+    AXP_21264_CBOX_MAF *maf;
+    AXP_21264_CBOX_MAF *retVal = NULL;
+    u64 paEnd;
+    u64 block[2] = {pa, pa - AXP_21264_SIZE_QUAD};
+    int ii;
+    int entry;
+
+    for (ii = 0; ((ii < 2) && (retVal == NULL)); ii++)
+    {
+        entry = cpu->mafHash[AXP_21264_MAF_HASH(block[ii])];
+        while ((entry != -1) && (retVal == NULL))
+        {
+            maf = &cpu->maf[entry];
+            if ((maf->valid == true) &&
+                (maf->ioReq == ioReq) &&
+                (maf->sent == false) &&
+                ((maf->type == type) ||
+                 ((ioReq == false) && (maf->type == STx) && (type == LDx))))
+            {
+                paEnd = maf->pa + maf->bufLen;
+                if ((paEnd <= pa) && ((pa + dataLen) <= (maf->pa + maxLen)))
+                {
+                    retVal = maf;
+                }
+            }
+            entry = maf->hashNext;
+        }
+    }
+
+    /*
+     * Return what we found, if anything, back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21264_MAF_Full
+ *  This function is called to determine if the next MAF entry to be allocated
+ *  is still in use.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   All the MAF entries are in use.
+ *  false:  An MAF entry can be allocated.
+ */
+static bool AXP_21264_MAF_Full(AXP_21264_CPU *cpu)
+{
+    u8 entry = cpu->mafBottom;
+
+    if (cpu->maf[entry].valid == true)
+    {
+        entry = (entry + 1) & 0x07;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (cpu->maf[entry].valid);
+}
+
+/*
+ * AXP_21264_MAF_Allocate
+ *  This function is called to put a request that could not be merged into the
+ *  next available MAF entry.  There must be one available.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  type:
+ *      An enumerated value for the type of MAF entry to add.
+ *  pa:
+ *      A value representing the physical address associated with this record.
+ *  lqSqEntry:
+ *      A value indicating the entry within the Mbox's LQ or SQ that is
+ *      associated with this MAF.
+ *  dataLen:
+ *      A value indicating the length of data that missed the caches.
+ *  shared:
+ *      A boolean value used to indicate that the MAF entry is part of a store
+ *      where the cache entry needs to be changed to dirty and not shared.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21264_MAF_Allocate(AXP_21264_CPU *cpu,
+                                   AXP_CBOX_MAF_TYPE type,
+                                   u64 pa,
+                                   i8 lqSqEntry,
+                                   int dataLen,
+                                   bool shared)
+{
+    AXP_21264_CBOX_MAF *maf;
+    u32 bucket = AXP_21264_MAF_HASH(pa);
+    int ii;
+
+    /*
+     * Add a record to the next available MAF.
+     */
+    if (cpu->maf[cpu->mafBottom].valid == true)
+    {
+        cpu->mafBottom = (cpu->mafBottom + 1) & 0x07;
+    }
+    maf = &cpu->maf[cpu->mafBottom];
+    maf->type = type;
+    maf->pa = pa;
+    maf->sent = false;
+    maf->lqSqEntry[0] = lqSqEntry;
+    for (ii = 1; ii < AXP_21264_MBOX_MAX; ii++)
+    {
+        maf->lqSqEntry[ii] = 0;
+    }
+    maf->ioReq = AXP_21264_IS_IO_ADDR(pa);
+    maf->dataLen = maf->bufLen = dataLen;
+    AXP_MaskReset((u8 *) &maf->mask);
+    AXP_MaskSet((u8 *) &maf->mask, maf->pa, pa, dataLen);
+    maf->shared = shared;
+    maf->valid = true;
+    maf->hashNext = cpu->mafHash[bucket];
+    cpu->mafHash[bucket] = cpu->mafBottom;
+
+    /*
+     * Keep track of how full the MAF has been.
+     */
+    cpu->mafStats.allocated++;
+    cpu->mafStats.occupancy += cpu->mafStats.inUse;
+    cpu->mafStats.inUse++;
+    if (cpu->mafStats.inUse > cpu->mafStats.maxInUse)
+    {
+        cpu->mafStats.maxInUse = cpu->mafStats.inUse;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21264_MAF_Merge
+ *  This function is called to try and merge a request into one of the MAF
+ *  entries that has not yet been sent to the System, following the merging
+ *  rules for memory or I/O, as appropriate.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  type:
+ *      An enumerated value for the type of MAF entry to add.
+ *  pa:
+ *      A value representing the physical address associated with this record.
+ *  lqSqEntry:
+ *      A value indicating the entry within the Mbox's LQ or SQ that is
+ *      associated with this MAF.
+ *  dataLen:
+ *      A value indicating the length of data that missed the caches.
+ *  shared:
+ *      A boolean value used to indicate that the MAF entry is part of a store
+ *      where the cache entry needs to be changed to dirty and not shared.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   A new MAF needs to be allocated.
+ *  false:  The request has been merged with an existing one.
+ */
+static bool AXP_21264_MAF_Merge(AXP_21264_CPU *cpu,
+                                AXP_CBOX_MAF_TYPE type,
+                                u64 pa,
+                                i8 lqSqEntry,
+                                int dataLen,
+                                bool shared)
+{
+    bool notMerged;
+
+    /*
+     * The merging rules are different for I/O reads versus memory reads.  Make
+     * sure we follow the right rules.
+     */
+    if (AXP_21264_IS_IO_ADDR(pa) == false)
+    {
+        if (type == MemoryBarrier)
+        {
+            notMerged = true;
+        }
+        else
+        {
+            notMerged = AXP_21264_Add_MAF_Mem(cpu,
+                                              type,
+                                              pa,
+                                              lqSqEntry,
+                                              dataLen,
+                                              shared);
+        }
+    }
+    else
+    {
+
+        /*
+         * Byte/Word I/O reads are not merged.  We need to allocate a new
+         * entry.
+         */
+        if ((dataLen == BYTE_LEN) || (dataLen == WORD_LEN))
+        {
+            notMerged = true;
+        }
+        else
+        {
+            notMerged = AXP_21264_Add_MAF_IO(cpu,
+                                             type,
+                                             pa,
+                                             lqSqEntry,
+                                             dataLen,
+                                             shared);
+        }
+    }
+    if (notMerged == false)
+    {
+        cpu->mafStats.merged++;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (notMerged);
+}
+
+/*
+ * AXP_21264_MAF_Wait
+ *  This function is called when a request cannot be merged and all the MAF
+ *  entries are in use, or other requests are already waiting for one.  The
+ *  Ibox and Mbox call us with their own mutex locked, and the Cbox needs
+ *  those mutexes to complete MAF entries, so the request cannot wait for an
+ *  entry where it is.  Instead, it is put at the end of the list of waiting
+ *  requests.
+ *
+ *  Each LQ and SQ entry has at most one request outstanding, and the list is
+ *  long enough for every one of them to have one on it.  The Ibox only waits
+ *  for the one Istream block it is fetching, and asks for it again each time
+ *  it finds it is still not in the Icache, so only the newest Istream request
+ *  is kept on the list.  It replaces any older one, in place.  Therefore, the
+ *  list can never overflow and no request is dropped.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  type:
+ *      An enumerated value for the type of MAF entry to add.
+ *  pa:
+ *      A value representing the physical address associated with this record.
+ *  lqSqEntry:
+ *      A value indicating the entry within the Mbox's LQ or SQ that is
+ *      associated with this MAF.
+ *  dataLen:
+ *      A value indicating the length of data that missed the caches.
+ *  shared:
+ *      A boolean value used to indicate that the MAF entry is part of a store
+ *      where the cache entry needs to be changed to dirty and not shared.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21264_MAF_Wait(AXP_21264_CPU *cpu,
+                               AXP_CBOX_MAF_TYPE type,
+                               u64 pa,
+                               i8 lqSqEntry,
+                               int dataLen,
+                               bool shared)
+{
+    AXP_21264_CBOX_MAF_WAIT *wait = NULL;
+    u32 ii;
+
+    /*
+     * If there is already an Istream request waiting, then this one takes its
+     * place.
+     */
+    if (type == Istream)
+    {
+        for (ii = 0; ((ii < cpu->mafWaitCount) && (wait == NULL)); ii++)
+        {
+            wait = &cpu->mafWait[(cpu->mafWaitTop + ii) %
+                                 AXP_21264_MAF_WAIT_LEN];
+            if (wait->type != Istream)
+            {
+                wait = NULL;
+            }
+        }
+    }
+    if (wait != NULL)
+    {
+        if (wait->pa == pa)
+        {
+            cpu->mafStats.merged++;
+        }
+        else
+        {
+            wait->pa = pa;
+            cpu->mafStats.replaced++;
+        }
+    }
+    else
+    {
+        wait = &cpu->mafWait[(cpu->mafWaitTop + cpu->mafWaitCount) %
+                             AXP_21264_MAF_WAIT_LEN];
+        wait->type = type;
+        wait->pa = pa;
+        wait->lqSqEntry = lqSqEntry;
+        wait->dataLen = dataLen;
+        wait->shared = shared;
+        cpu->mafWaitCount++;
+        cpu->mafStats.fullStalls++;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21264_MAF_Unwait
+ *  This function is called after an MAF entry has been freed, to move as many
+ *  of the waiting requests, in order, into the MAF as will now fit.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21264_MAF_Unwait(AXP_21264_CPU *cpu)
+{
+    AXP_21264_CBOX_MAF_WAIT *wait;
+
+    while ((cpu->mafWaitCount > 0) && (AXP_21264_MAF_Full(cpu) == false))
+    {
+        wait = &cpu->mafWait[cpu->mafWaitTop];
+        if (AXP_21264_MAF_Merge(cpu,
+                                wait->type,
+                                wait->pa,
+                                wait->lqSqEntry,
+                                wait->dataLen,
+                                wait->shared) == true)
+        {
+            AXP_21264_MAF_Allocate(cpu,
+                                   wait->type,
+                                   wait->pa,
+                                   wait->lqSqEntry,
+                                   wait->dataLen,
+                                   wait->shared);
+        }
+        cpu->mafWaitTop = (cpu->mafWaitTop + 1) % AXP_21264_MAF_WAIT_LEN;
+        cpu->mafWaitCount--;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
 /*
  * AXP_21264_MAF_Empty
  *  This function is called to determine of there is a record in the Missed
@@ -82,7 +528,7 @@ int AXP_21264_MAF_Empty(AXP_21264_CPU *cpu)
     while ((ii <= end) && (retVal == -1))
     {
         if ((cpu->maf[ii].type != MAFNotInUse) &&
-            (cpu->maf[ii].complete == false))
+            (cpu->maf[ii].sent == false))
         {
             retVal = ii;
         }
@@ -105,9 +551,8 @@ int AXP_21264_MAF_Empty(AXP_21264_CPU *cpu)
 }
 
 /*
- * AXP_21264_Process_MAF
- *  This function is called to check the first unprocessed entry on the queue
- *  containing the MAF records.
+ * AXP_21264_Build_MAF
+ *  This function is called to build the System message for an MAF entry.
  *
  * Input Parameters:
  *  cpu:
@@ -117,15 +562,17 @@ int AXP_21264_MAF_Empty(AXP_21264_CPU *cpu)
  *      An integer value that is the entry in the MAF to be processed.
  *
  * Output Parameters:
- *  None.
+ *  sys:
+ *      A pointer to the message to be sent to the System.
  *
  * Return Values:
  *  None.
  */
-void AXP_21264_Process_MAF(AXP_21264_CPU *cpu, int entry)
+static void AXP_21264_Build_MAF(AXP_21264_CPU *cpu,
+                                int entry,
+                                AXP_21264_SYSBUS_System *sys)
 {
     AXP_21264_CBOX_MAF *maf = &cpu->maf[entry];
-    AXP_21264_SYSBUS_System sys;
 
     /*
      * Process the next MAF entry that needs it.
@@ -140,62 +587,62 @@ void AXP_21264_Process_MAF(AXP_21264_CPU *cpu, int entry)
                 switch (maf->dataLen)
                 {
                     case BYTE_LEN:
-                        sys.cmd = ReadBytes;
+                        sys->cmd = ReadBytes;
                         break;
 
                     case WORD_LEN:
-                        sys.cmd = ReadBytes;
+                        sys->cmd = ReadBytes;
                         break;
 
                     case LONG_LEN:
-                        sys.cmd = ReadLWs;
+                        sys->cmd = ReadLWs;
                         break;
 
                     case QUAD_LEN:
-                        sys.cmd = ReadQWs;
+                        sys->cmd = ReadQWs;
                         break;
                 }
             }
             else
             {
-                sys.cmd = ReadBlk;
+                sys->cmd = ReadBlk;
             }
             break;
 
         case STx:
         case STx_C:
-            sys.cmd = ReadBlkMod;
+            sys->cmd = ReadBlkMod;
             break;
 
         case STxChangeToDirty:
             if (maf->shared == true)
             {
-                sys.cmd = SharedToDirty;
+                sys->cmd = SharedToDirty;
             }
             else
             {
-                sys.cmd = CleanToDirty;
+                sys->cmd = CleanToDirty;
             }
             break;
 
         case STxCChangeToDirty:
-            sys.cmd = STCChangeToDirty;
+            sys->cmd = STCChangeToDirty;
             break;
 
         case WH64:
-            sys.cmd = InvalToDirty;
+            sys->cmd = InvalToDirty;
             break;
 
         case ECB:
-            sys.cmd = Evict;
+            sys->cmd = Evict;
             break;
 
         case Istream:
-            sys.cmd = ReadBlkI;
+            sys->cmd = ReadBlkI;
             break;
 
         case MemoryBarrier:
-            sys.cmd = Sysbus_MB;
+            sys->cmd = Sysbus_MB;
             break;
 
         default:
@@ -205,23 +652,117 @@ void AXP_21264_Process_MAF(AXP_21264_CPU *cpu, int entry)
     /*
      * Go check the Oldest pending PQ and set the flags for it here and now.
      */
-    AXP_21264_OldestPQFlags(cpu, &sys.m1, &sys.m2, &sys.ch);
+    AXP_21264_OldestPQFlags(cpu, &sys->m1, &sys->m2, &sys->ch);
 
     /*
-     * OK, send what we have to the System.
+     * OK, fill in what we have for the System.
      */
-    sys.mask = maf->mask;
-    sys.pa = maf->pa;
-    sys.rv = true;
-    AXP_21264_SendToSystem(cpu, &sys);
+    sys->mask = maf->mask;
+    sys->pa = maf->pa;
+    sys->rv = true;
+    sys->id = entry;
 
     /*
-     * Indicate that the entry is now processed and return back to the caller.
+     * Return back to the caller.
      */
-    maf->complete = true;
     return;
 }
 
+/*
+ * AXP_21264_Process_MAF
+ *  This function is called to check the first unprocessed entry on the queue
+ *  containing the MAF records.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  entry:
+ *      An integer value that is the entry in the MAF to be processed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_21264_Process_MAF(AXP_21264_CPU *cpu, int entry)
+{
+    AXP_21264_SYSBUS_System sys;
+
+    AXP_21264_Build_MAF(cpu, entry, &sys);
+    if (AXP_21264_SendToSystem(cpu, &sys) == true)
+    {
+        cpu->maf[entry].sent = true;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21264_Drain_MAF
+ *  This function is called by the Cbox, with the interface mutex locked, to
+ *  send every MAF entry that has not yet been sent to the System.  The
+ *  D-stream requests, which have loads and stores waiting on them, go first,
+ *  each in the order they were allocated, followed by the I-stream fills.
+ *  They are all handed to the System together.  An entry is only marked as
+ *  sent once the System has taken it.  The ones it did not have room for are
+ *  sent the next time through.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   At least one MAF entry was sent to the System.
+ *  false:  There were no MAF entries to be sent, or the System did not have
+ *          room for any of them.
+ */
+bool AXP_21264_Drain_MAF(AXP_21264_CPU *cpu)
+{
+    AXP_21264_SYSBUS_System sys[AXP_21264_MAF_LEN];
+    int entries[AXP_21264_MAF_LEN];
+    u32 count = 0;
+    u32 sent;
+    u32 pass;
+    u32 ii;
+    int entry;
+    bool iStream;
+
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (ii = 0; ii < AXP_21264_MAF_LEN; ii++)
+        {
+            entry = (cpu->mafTop + ii) % AXP_21264_MAF_LEN;
+            iStream = cpu->maf[entry].type == Istream;
+            if ((cpu->maf[entry].valid == true) &&
+                (cpu->maf[entry].sent == false) &&
+                (iStream == (pass == 1)))
+            {
+                entries[count] = entry;
+                AXP_21264_Build_MAF(cpu, entry, &sys[count++]);
+            }
+        }
+    }
+    sent = AXP_21264_SendToSystemBatch(cpu, sys, count);
+    for (ii = 0; ii < sent; ii++)
+    {
+        cpu->maf[entries[ii]].sent = true;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (sent > 0);
+}
+
 /*
  * AXP_21264_Complete_MAF
  *  This function is called when a probe sent by the System indicates one of
@@ -792,50 +1333,29 @@ void AXP_21264_Complete_MAF(AXP_21264_CPU *cpu,
  */
 bool AXP_21265_Check_MAFAddrSent(AXP_21264_CPU *cpu, u64 pa, u8 *entry)
 {
+    AXP_21264_CBOX_MAF *maf;
     bool retVal = false;
     int ii;
-    int end, start1, start2 = -1, end1, end2 = 0;
-
-    if (cpu->mafTop > cpu->mafBottom)
-    {
-        start1 = cpu->mafTop;
-        end1 = AXP_21264_MAF_LEN - 1;
-        start2 = 0;
-        end2 = cpu->mafBottom;
-    }
-    else
-    {
-        start1 = cpu->mafTop;
-        end1 = cpu->mafBottom;
-    }
 
     /*
-     * Search through the list to find the first entry that is in-use with the
-     * same physical address and one of the change to dirty types.  If so, then
-     * we have what we are looking, so return this entry back to the caller.
+     * Search through the hash bucket for the block to find the first entry
+     * that is in-use with the same physical address and one of the change to
+     * dirty types.  If so, then we have what we are looking, so return this
+     * entry back to the caller.
      */
-    ii = start1;
-    end = end1;
-    while ((ii <= end) && (retVal == false))
+    ii = cpu->mafHash[AXP_21264_MAF_HASH(pa)];
+    while ((ii != -1) && (retVal == false))
     {
-        if ((cpu->maf[ii].valid == true) &&
-            (cpu->maf[ii].pa == pa) &&
-            ((cpu->maf[ii].type == STxChangeToDirty) ||
-             (cpu->maf[ii].type == STxCChangeToDirty)))
+        maf = &cpu->maf[ii];
+        if ((maf->valid == true) &&
+            (maf->pa == pa) &&
+            ((maf->type == STxChangeToDirty) ||
+             (maf->type == STxCChangeToDirty)))
         {
             *entry = ii;
             retVal = true;
         }
-        if ((retVal == false) && (start2 != -1) && (ii == end))
-        {
-            ii = start2;
-            end = end2;
-            start2 = -1;
-        }
-        else
-        {
-            ii++;
-        }
+        ii = maf->hashNext;
     }
 
     /*
@@ -887,9 +1407,7 @@ bool AXP_21264_Add_MAF_Mem(AXP_21264_CPU *cpu,
                            bool shared)
 {
     AXP_21264_CBOX_MAF *maf = NULL;
-    u64 paEnd;
     int ii;
-    int end, start1, start2 = -1, end1, end2 = 0;
     bool retVal = false;
 
     /*
@@ -919,22 +1437,8 @@ bool AXP_21264_Add_MAF_Mem(AXP_21264_CPU *cpu,
      * exception of load instructions merging with store instructions, are
      * merged.
      */
-    if (cpu->mafTop > cpu->mafBottom)
-    {
-        start1 = cpu->mafTop;
-        end1 = AXP_21264_MAF_LEN - 1;
-        start2 = 0;
-        end2 = cpu->mafBottom;
-    }
-    else
-    {
-        start1 = cpu->mafTop;
-        end1 = cpu->mafBottom;
-    }
-
     /*
-     * Search through the list to find the first entry that can be processed.
-     * We do this test in 3 stages:
+     * Look for an entry that can be merged.  We do this test in 3 stages:
      *
      *  1)    If the MAF is in-use and not completed
      *  2)    If the MAF type matches the new type, or we have a store and
@@ -942,37 +1446,12 @@ bool AXP_21264_Add_MAF_Mem(AXP_21264_CPU *cpu,
      *  3)    If the 64-byte block of the physical address includes the all
      *      the bytes for the data we are reading/writing.
      */
-    ii = start1;
-    end = end1;
-    while ((ii <= end) && (maf == NULL))
-    {
-        if ((cpu->maf[ii].type != MAFNotInUse) &&
-            (cpu->maf[ii].ioReq == false) &&
-            (cpu->maf[ii].complete == false))
-        {
-            if ((cpu->maf[ii].type == type) ||
-                ((cpu->maf[ii].type == STx) &&
-                 (type == LDx)))
-            {
-                paEnd = cpu->maf[ii].pa + cpu->maf[ii].bufLen;
-                if ((paEnd <= pa) &&
-                    ((pa + dataLen) <= (cpu->maf[ii].pa + AXP_21264_SIZE_QUAD)))
-                {
-                    maf = &cpu->maf[ii];
-                }
-            }
-        }
-        if ((maf == NULL) && (ii == end) && (start2 != -1))
-        {
-            ii = start2;
-            end = end2;
-            start2 = -1;
-        }
-        else
-        {
-            ii++;
-        }
-    }
+    maf = AXP_21264_MAF_Find(cpu,
+                             type,
+                             pa,
+                             dataLen,
+                             AXP_21264_SIZE_QUAD,
+                             false);
 
     if (maf != NULL)
     {
@@ -982,9 +1461,9 @@ bool AXP_21264_Add_MAF_Mem(AXP_21264_CPU *cpu,
         AXP_MaskSet((u8 *) &maf->mask, maf->pa, pa, dataLen);
         for (ii = 0; ((ii < AXP_21264_MBOX_MAX) && (done == false)); ii++)
         {
-            if (cpu->maf[cpu->mafBottom].lqSqEntry[ii] == 0)
+            if (maf->lqSqEntry[ii] == 0)
             {
-                cpu->maf[cpu->mafBottom].lqSqEntry[ii] = lqSqEntry;
+                maf->lqSqEntry[ii] = lqSqEntry;
                 done = true;
             }
         }
@@ -1041,9 +1520,7 @@ bool AXP_21264_Add_MAF_IO(AXP_21264_CPU *cpu,
                           bool shared)
 {
     AXP_21264_CBOX_MAF *maf = NULL;
-    u64 paEnd;
     int ii;
-    int end, start1, start2 = -1, end1, end2 = 0;
     int maxLen;
     bool retVal = false;
 
@@ -1093,52 +1570,11 @@ bool AXP_21264_Add_MAF_IO(AXP_21264_CPU *cpu,
      *    timer detects no I/O load instruction activity for 14 cycles, or zero
      *    cycles if the last QW/LW of the block is addressed.
      */
-    if (cpu->mafTop > cpu->mafBottom)
-    {
-        start1 = cpu->mafTop;
-        end1 = AXP_21264_MAF_LEN - 1;
-        start2 = 0;
-        end2 = cpu->mafBottom;
-    }
-    else
-    {
-        start1 = cpu->mafTop;
-        end1 = cpu->mafBottom;
-    }
-
     /*
-     * Search through all the in-use MAF entries looking for one that can be
-     * merged with the current request for one.
+     * Look for an in-use MAF entry that can be merged with the current request
+     * for one.
      */
-    ii = start1;
-    end = end1;
-    while ((ii <= end) && (maf == NULL))
-    {
-        if ((cpu->maf[ii].type != MAFNotInUse) &&
-            (cpu->maf[ii].ioReq == true) &&
-            (cpu->maf[ii].complete == false))
-        {
-            if (cpu->maf[ii].type == type)
-            {
-                paEnd = cpu->maf[ii].pa + cpu->maf[ii].bufLen;
-                if ((paEnd <= pa) && ((pa + dataLen) <=
-                    (cpu->maf[ii].pa + maxLen)))
-                {
-                    maf = &cpu->maf[ii];
-                }
-            }
-        }
-        if ((maf == NULL) && (start2 != -1) && ((ii == end)))
-        {
-            ii = start2;
-            end = end2;
-            start2 = -1;
-        }
-        else
-        {
-            ii++;
-        }
-    }
+    maf = AXP_21264_MAF_Find(cpu, type, pa, dataLen, maxLen, true);
 
     if (maf != NULL)
     {
@@ -1202,10 +1638,6 @@ void AXP_21264_Add_MAF(AXP_21264_CPU *cpu,
                        int dataLen,
                        bool shared)
 {
-    AXP_21264_CBOX_MAF *maf = NULL;
-    int ii;
-    bool ioRq = AXP_21264_IS_IO_ADDR(pa);
-    bool notMerged;
 
     /*
      * Before we do anything, lock the interface mutex to prevent multiple
@@ -1214,80 +1646,100 @@ void AXP_21264_Add_MAF(AXP_21264_CPU *cpu,
     pthread_mutex_lock(&cpu->cBoxInterfaceMutex);
 
     /*
-     * The merging rules are different for I/O reads versus memory reads.  Make
-     * sure we follow the right rules.
+     * If the request could not be merged, then it needs an MAF entry of its
+     * own.  If there is not one available, or other requests are already
+     * waiting for one, then this one has to wait too.
      */
-    if (ioRq == false)
+    if (AXP_21264_MAF_Merge(cpu, type, pa, lqSqEntry, dataLen, shared) == true)
     {
-        if (type == MemoryBarrier)
+        if ((cpu->mafWaitCount > 0) || (AXP_21264_MAF_Full(cpu) == true))
         {
-            notMerged = true;
+            AXP_21264_MAF_Wait(cpu, type, pa, lqSqEntry, dataLen, shared);
         }
         else
         {
-            notMerged = AXP_21264_Add_MAF_Mem(cpu,
-                                              type,
-                                              pa,
-                                              lqSqEntry,
-                                              dataLen,
-                                              shared);
+            AXP_21264_MAF_Allocate(cpu, type, pa, lqSqEntry, dataLen, shared);
         }
     }
-    else
-    {
 
-        /*
-         * Byte/Word I/O reads are not merged.  We need to allocate a new
-         * entry.
-         */
-        if ((dataLen == BYTE_LEN) || (dataLen == WORD_LEN))
+    /*
+     * Let the Cbox know there is something for it to process, then unlock the
+     * mutex so it can.
+     */
+    pthread_cond_signal(&cpu->cBoxInterfaceCond);
+    pthread_mutex_unlock(&cpu->cBoxInterfaceMutex);
+    return;
+}
+
+/*
+ * AXP_21264_Prefetch_MAF
+ *  This function is called to add an Miss Address File (MAF) entry for an
+ *  Istream prefetch.  Unlike a demand miss, a prefetch never waits for an MAF
+ *  entry.  If it cannot be merged, and there is no MAF entry free for it, or
+ *  other requests are already waiting for one, then it is not made.
+ *
+ *  NOTE:   The Ibox calls this function.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  pa:
+ *      A value representing the physical address of the Icache block to be
+ *      prefetched.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The prefetch was added to the MAF.
+ *  false:  The MAF was full and the prefetch was not made.
+ */
+bool AXP_21264_Prefetch_MAF(AXP_21264_CPU *cpu, u64 pa)
+{
+    bool retVal = true;
+
+    /*
+     * Before we do anything, lock the interface mutex to prevent multiple
+     * accessors.
+     */
+    pthread_mutex_lock(&cpu->cBoxInterfaceMutex);
+    if (AXP_21264_MAF_Merge(cpu,
+                            Istream,
+                            pa,
+                            0,
+                            AXP_ICACHE_BUF_LEN,
+                            false) == true)
+    {
+        if ((cpu->mafWaitCount > 0) || (AXP_21264_MAF_Full(cpu) == true))
         {
-            notMerged = true;
+            retVal = false;
         }
         else
         {
-            notMerged = AXP_21264_Add_MAF_IO(cpu,
-                                             type,
-                                             pa,
-                                             lqSqEntry,
-                                             dataLen,
-                                             shared);
+            AXP_21264_MAF_Allocate(cpu,
+                                   Istream,
+                                   pa,
+                                   0,
+                                   AXP_ICACHE_BUF_LEN,
+                                   false);
         }
     }
-    if (notMerged == true)
-    {
 
-        /*
-         * Add a record to the next available MAF.
-         */
-        if (cpu->maf[cpu->mafBottom].valid == true)
-        {
-            cpu->mafBottom = (cpu->mafBottom + 1) & 0x07;
-        }
-        maf = &cpu->maf[cpu->mafBottom];
-        maf->type = type;
-        maf->pa = pa;
-        maf->complete = false;
-        maf->lqSqEntry[0] = lqSqEntry;
-        for (ii = 1; ii < AXP_21264_MBOX_MAX; ii++)
-        {
-            maf->lqSqEntry[ii] = 0;
-        }
-        maf->ioReq = ioRq;
-        maf->dataLen = maf->bufLen = dataLen;
-        AXP_MaskReset((u8 *) &maf->mask);
-        AXP_MaskSet((u8 *) &maf->mask, maf->pa, pa, dataLen);
-        maf->shared = shared;
-        maf->valid = true;
+    /*
+     * If we added something, let the Cbox know there is something for it to
+     * process.  Then unlock the mutex so it can.
+     */
+    if (retVal == true)
+    {
+        pthread_cond_signal(&cpu->cBoxInterfaceCond);
     }
+    pthread_mutex_unlock(&cpu->cBoxInterfaceMutex);
 
     /*
-     * Let the Cbox know there is something for it to process, then unlock the
-     * mutex so it can.
+     * Return the results back to the caller.
      */
-    pthread_cond_signal(&cpu->cBoxInterfaceCond);
-    pthread_mutex_unlock(&cpu->cBoxInterfaceMutex);
-    return;
+    return (retVal);
 }
 
 /*
@@ -1312,14 +1764,28 @@ void AXP_21264_Add_MAF(AXP_21264_CPU *cpu,
 void AXP_21264_Free_MAF(AXP_21264_CPU *cpu, u8 entry)
 {
     AXP_21264_CBOX_MAF *maf = &cpu->maf[entry];
+    i8 *next = &cpu->mafHash[AXP_21264_MAF_HASH(maf->pa)];
     int ii;
     int end, start1, end1, start2 = -1, end2 = 0;
     bool done = false;
 
     /*
-     * First, clear the valid bit.
+     * First, clear the valid bit and take the entry out of its hash bucket.
      */
     maf->valid = false;
+    while (*next != -1)
+    {
+        if (*next == entry)
+        {
+            *next = maf->hashNext;
+        }
+        else
+        {
+            next = &cpu->maf[(int) *next].hashNext;
+        }
+    }
+    maf->hashNext = -1;
+    cpu->mafStats.inUse--;
 
     /*
      * We now have to see if we can adjust the top of the queue.
@@ -1364,6 +1830,12 @@ void AXP_21264_Free_MAF(AXP_21264_CPU *cpu, u8 entry)
         }
     }
 
+    /*
+     * Now that there is an MAF entry free, the requests that were waiting for
+     * one can have it.
+     */
+    AXP_21264_MAF_Unwait(cpu);
+
     /*
      * Return back to the caller.
      */
@@ -28,6 +28,14 @@
  *  GCC 7.4.0, and possibly earlier, turns on strict-aliasing rules by default.
  *  There are a number of issues in this module where the address of one
  *  variable is cast to extract a value in a different format.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  A probe response the System does not have room for is held as a pending
+ *  response, the same as when probe responses are not being sent.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Processing a probe wakes the Ibox, if it is parked in an idle loop that
+ *  polls memory, as the memory may have been changed.
  */
 #include "CPU/Cbox/AXP_21264_Cbox.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -346,6 +354,7 @@ void AXP_21264_Process_PQ(AXP_21264_CPU *cpu, int entry)
     bool vs = false;
     bool ms = false;
     bool miss = false;
+    bool probed = false;
 
     /*
      * Between the time when a probe request was queued up and this queue
@@ -384,6 +393,8 @@ void AXP_21264_Process_PQ(AXP_21264_CPU *cpu, int entry)
             AXP_DTAG_BLK *dtag;
             u32 dCacheIdx = ctag->dtagIndex;
 
+            probed = true;
+
             /*
              * Get the remaining status bits of the Dcache.  We don't call the
              * Mbox equivalent of these because we are just looking at the CTAG
@@ -501,6 +512,7 @@ void AXP_21264_Process_PQ(AXP_21264_CPU *cpu, int entry)
                 if (cpu->noProbeResponses == false)
                 {
                     AXP_21264_SYSBUS_System sys;
+                    bool held = false;
 
                     /*
                      * TODO:    This code is completely bogus.  It is only here
@@ -517,7 +529,17 @@ void AXP_21264_Process_PQ(AXP_21264_CPU *cpu, int entry)
                     sys.mask = maf;
                     if (probeStatus == HitSharedDirty)
                     {
-                        AXP_21264_SendToSystem(cpu, &sys);
+                        held = !AXP_21264_SendToSystem(cpu, &sys);
+                    }
+                    if (held == true)
+                    {
+                        pq->dm = dm;
+                        pq->vs = vs;
+                        pq->vdb = vdb;
+                        pq->ms = ms;
+                        pq->maf = maf;
+                        pq->probeStatus = probeStatus;
+                        pq->pendingRsp = true;
                     }
                 }
                 else
@@ -1000,6 +1022,15 @@ void AXP_21264_Process_PQ(AXP_21264_CPU *cpu, int entry)
     }
     pthread_mutex_unlock(&cpu->cBoxIPRMutex);
 
+    /*
+     * If the CPU is polling memory in an idle loop, the probe may be for what
+     * it is polling.
+     */
+    if (probed == true)
+    {
+        AXP_21264_Ibox_Wake(cpu);
+    }
+
     /*
      * Return back to the caller.
      */
@@ -31,6 +31,10 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  A VDB entry that is to be sent to the System is only marked as processed
+ *  once the System has room for it.
  */
 #include "CPU/Cbox/AXP_21264_Cbox.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -123,9 +127,10 @@ AXP_21264_VDB_Empty(AXP_21264_CPU *cpu)
  *  None.
  *
  * Return Values:
- *  None.
+ *  true:   The VDB entry was processed.
+ *  false:  The System did not have room for the VDB entry.
  */
-void
+bool
 AXP_21264_Process_VDB(AXP_21264_CPU *cpu, int entry)
 {
     AXP_21264_CBOX_VIC_BUF *vdb = &cpu->vdb[entry];
@@ -169,7 +174,15 @@ AXP_21264_Process_VDB(AXP_21264_CPU *cpu, int entry)
             sys.id = entry;
             sys.pa = vdb->pa;
             memcpy(sys.sysData, vdb->sysData, AXP_21264_SIZE_QUAD);
-            AXP_21264_SendToSystem(cpu, &sys);
+            if (AXP_21264_SendToSystem(cpu, &sys) == false)
+            {
+
+                /*
+                 * The System has no room for it yet.  Leave the entry as it
+                 * is, to be sent the next time through.
+                 */
+                return (false);
+            }
             break;
     }
 
@@ -177,7 +190,7 @@ AXP_21264_Process_VDB(AXP_21264_CPU *cpu, int entry)
      * Indicate that the entry is now processed and return back to the caller.
      */
     vdb->processed = true;
-    return;
+    return (true);
 }
 
 /*
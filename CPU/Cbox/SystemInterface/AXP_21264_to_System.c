@@ -28,94 +28,250 @@
  *  The clang-9 compiler is reporting some errors that GCC was not.  These will
  *  be fixed so that this software can compile cleanly with either GCC or
  *  clang.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added a function to send a number of messages to the System at once.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Messages are now copied, including the command, into the next of this
+ *  CPU's skid buffers, which is then inserted onto the System's request queue.
+ *  When all the skid buffers are still in use, the message is not sent and the
+ *  caller is told so, to try again later.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Added a function to let the System know the CPU has taken IRQ<1>.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  When all the skid buffers are in use, a flag is set so that the System
+ *  only signals the Cbox, when it releases one, if the Cbox is waiting for it.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/AXP_21264_CPU.h"
 
 /*
- * AXP_21264_SendToSystem
- *  This function is called with a pointer to the SysBus message and a pointer
- *  to the CPU structure, and sends the message to the CPU, locking the correct
- *  mutex and signaling the correct condition variable.
+ * AXP_21264_QueueToSystem
+ *  This function is called, with the System's mutex locked, to copy a SysBus
+ *  message into the next of this CPU's skid buffers and insert it at the end
+ *  of the System's request queue.  The skid buffers are used in order, and
+ *  the System processes the requests in the order they are queued, so they
+ *  are also released in order.  Therefore, if the next one is still in use,
+ *  they all are.  When they are, a flag is set to have the System signal the
+ *  Cbox when it releases one.
  *
  * Input Parameters:
  *  cpu:
  *      A pointer to the CPU structure for the emulation.
  *  msg:
- *      A pointer to the message to send to the specified CPU.
+ *      A pointer to the message to send to the System.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  true:   The message was queued up to the System.
+ *  false:  All of this CPU's skid buffers are in use.
  */
-void AXP_21264_SendToSystem(AXP_21264_CPU *cpu, AXP_21264_SYSBUS_System *msg)
+static bool AXP_21264_QueueToSystem(AXP_21264_CPU *cpu,
+                                    AXP_21264_SYSBUS_System *msg)
 {
     AXP_21264_RQ_ENTRY *rq;
 
     /*
-     * Lock the mutex so that no one else tries to manipulate the queue or the
-     * index into it.
+     * Get the next skid buffer.  The System releases it without holding its
+     * mutex, once it has finished processing it.
      */
-    pthread_mutex_lock(cpu->system.mutex);
+    rq = &cpu->system.skidBuffers[cpu->system.skidEnd];
+    if (__atomic_load_n(&rq->inUse, __ATOMIC_ACQUIRE) == true)
+    {
 
-    /*
-     * Queue up the next PQ entry for the CPU to process.
-    if (cpu->system.rq[*cpu->system.rqEnd].valid == true)
-        *cpu->system.rqEnd = (*cpu->system.rqEnd + 1) % AXP_21264_CCHIP_RQ_LEN;
-     *
-     * TODO:    The below is bogus.  We need to rationalize the interfaces
-     *          between components.  This is just to keep the compiler happy.
-     */
-    rq = (AXP_21264_RQ_ENTRY *) cpu->system.rq; /*[*cpu->system.rqEnd]; */
+        /*
+         * Say we are waiting and then look at the skid buffer one last time.
+         * If the System released it after that, it sees the flag and signals
+         * the Cbox, once the Cbox has unlocked its mutex by waiting.
+         */
+        __atomic_store_n(&cpu->system.skidWait, true, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&rq->inUse, __ATOMIC_SEQ_CST) == true)
+        {
+            return (false);
+        }
+    }
 
     /*
-     * Copy the data from the System structure and into the CPU structure.
+     * Copy the data from the System structure and into the skid buffer.
      *
      * TODO:    We need to do something about data movement, mask, deal with a
      *          probeResponse, and wrapping data.
-     *
-     * TODO:    There is way too much copying of data from one buffer to the
-     *          next.  We should look at defining a pool of buffers that can
-     *          be copied once and passed around as needed.  Buffers should
-     *          only be copied out of the source and copied into the
-     *          destination.
      */
+    rq->cmd = msg->cmd;
     rq->pa = msg->pa;
     rq->miss1 = msg->m1;
     rq->miss2 = msg->m2;
-    /* rq->status = msg->cmd;   TODO: Probably not correct */
+    rq->status = HitClean;
+    rq->phase = phase0;
     rq->cacheHit = msg->ch;
     rq->rqValid = msg->rv;
-    rq->valid = true;
     rq->waitVector = msg->id; /* TODO: Probably not correct */
+    rq->entry = msg->id;
+    rq->cpuID = cpu->whami;
     rq->mask = msg->mask;
+    rq->sysDataLen = 0;
     switch (msg->cmd)
     {
-        case ReadDataError:
-            memset(rq->sysData, 0xff, (AXP_21264_DATA_SIZE * sizeof(rq->sysData)));
-            /* rq->dm = true; */
-            break;
-
-        case ReadData:
-        case ReadDataDirty:
-        case ReadDataShared:
-        case ReadDataSharedDirty:
-            memcpy(rq->sysData, msg->sysData, AXP_21264_DATA_SIZE);
-            /* rq->dm = true;
-            rq->wrap = msg->wrap; */
+        case WrVictimBlk:
+        case CleanVictimBlk:
+        case WrBytes:
+        case WrLWs:
+        case WrQWs:
+            memcpy(rq->sysData, msg->sysData, sizeof(rq->sysData));
+            rq->sysDataLen = AXP_21264_DATA_SIZE;
             break;
 
         default:
-            /*        rq->dm = false; */
             break;
     }
+    rq->inUse = true;
 
     /*
-     * OK, we are done here.  Signal the CPU that it has something to process.
+     * Insert the skid buffer at the end of the request queue and move on to
+     * the next one.
      */
-    pthread_cond_signal(cpu->system.cond);
+    AXP_INSQUE(cpu->system.rq->blink, &rq->header);
+    cpu->system.skidEnd = (cpu->system.skidEnd + 1) % AXP_21264_CCHIP_RQ_LEN;
+
+    /*
+     * Return back to the caller.
+     */
+    return (true);
+}
+
+/*
+ * AXP_21264_SendToSystem
+ *  This function is called with a pointer to the SysBus message and a pointer
+ *  to the CPU structure, and sends the message to the System, locking the
+ *  correct mutex and signaling the correct condition variable.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulation.
+ *  msg:
+ *      A pointer to the message to send to the System.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  true:   The message was sent to the System.
+ *  false:  All of this CPU's skid buffers are in use.  The caller needs to
+ *          try again once the System has released one.
+ */
+bool AXP_21264_SendToSystem(AXP_21264_CPU *cpu, AXP_21264_SYSBUS_System *msg)
+{
+    bool retVal;
+
+    /*
+     * Lock the mutex so that no one else tries to manipulate the queue or the
+     * index into it.
+     */
+    pthread_mutex_lock(cpu->system.mutex);
+    retVal = AXP_21264_QueueToSystem(cpu, msg);
 
     /*
-     * Unlock the CPU's interface Mutex, so that the CPU can process the data
-     * we just queued up to it.
+     * If we queued something up, signal the System that it has something to
+     * process.
      */
+    if (retVal == true)
+    {
+        pthread_cond_signal(cpu->system.cond);
+    }
+
+    /*
+     * Unlock the System's interface Mutex, so that the System can process the
+     * data we just queued up to it.
+     */
+    pthread_mutex_unlock(cpu->system.mutex);
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21264_SendToSystemBatch
+ *  This function is called with an array of SysBus messages, which are sent
+ *  to the System, in order, under a single lock of its mutex, and with a
+ *  single signal of its condition variable, rather than one of each per
+ *  message.  Sending stops at the first message for which there is no skid
+ *  buffer available.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulation.
+ *  msg:
+ *      A pointer to the array of messages to send to the System.
+ *  count:
+ *      A value indicating the number of messages in the array.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  The number of messages, from the start of the array, that were sent.
+ */
+u32 AXP_21264_SendToSystemBatch(AXP_21264_CPU *cpu,
+                                AXP_21264_SYSBUS_System *msg,
+                                u32 count)
+{
+    u32 ii = 0;
+
+    if (count > 0)
+    {
+        pthread_mutex_lock(cpu->system.mutex);
+        while ((ii < count) && (AXP_21264_QueueToSystem(cpu, &msg[ii]) == true))
+        {
+            ii++;
+        }
+        if (ii > 0)
+        {
+            pthread_cond_signal(cpu->system.cond);
+        }
+        pthread_mutex_unlock(cpu->system.mutex);
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (ii);
+}
+
+/*
+ * AXP_21264_InterruptTaken
+ *  This function is called by the Ibox when the CPU has taken IRQ<1>, the
+ *  device interrupt line.  IRQ<1> is a level, but taking the interrupt clears
+ *  it in the CPU's copy of the IRQ_H bits.  So, the System is told to redo the
+ *  IRQ_H bits, which posts IRQ<1> again if a device is still asserting it.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulation.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_21264_InterruptTaken(AXP_21264_CPU *cpu)
+{
+
+    /*
+     * Set the flag before waking the System, so that it sees it when it wakes
+     * up.
+     */
+    __atomic_store_n(cpu->system.irqUpdate, true, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(cpu->system.mutex);
+    pthread_cond_signal(cpu->system.cond);
     pthread_mutex_unlock(cpu->system.mutex);
 
     /*
@@ -123,4 +279,3 @@ void AXP_21264_SendToSystem(AXP_21264_CPU *cpu, AXP_21264_SYSBUS_System *msg)
      */
     return;
 }
-
@@ -40,6 +40,10 @@
  *	V01.004		27-Feb-2018	Jonathan D. Belanger
  *	The EboxMain and FboxMain functions were nearly identical, so they were
  *	combined into one that is now in COMUTL.
+ *
+ *	V01.005		19-Oct-2026	Jonathan D. Belanger
+ *	Completion atomically moves the instruction from Executing to
+ *	WaitingRetirement.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Ebox/AXP_21264_Ebox.h"
@@ -70,6 +74,7 @@
  */
 void AXP_21264_Ebox_Compl(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
 {
+    AXP_INS_STATE state = Executing;
 
     /*
      * If no exception occurred, then we have the data we need and just need to
@@ -112,9 +117,10 @@ void AXP_21264_Ebox_Compl(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     }
 
     /*
-     * Indicate that the instruction is ready to be retired.
+     * Indicate that the instruction is ready to be retired, unless the Ibox
+     * aborted it while the Mbox was working on it.
      */
-    instr->state = WaitingRetirement;
+    AXP_ROB_CHANGE_STATE(instr, &state, WaitingRetirement);
 
     /*
      * We want the Ebox threads to handle their own completion.  The Mbox has
@@ -36,6 +36,10 @@
  *	V01.003		01-Jan-2018	Jonathan D. Belanger
  *	Changed the way instructions are completed when they need to utilize the
  *	Mbox.
+ *
+ *	V01.004		19-Oct-2026	Jonathan D. Belanger
+ *	LDA and LDAH no longer set the instruction state.  The dispatcher does
+ *	that after the exception value has been stored.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Ebox/AXP_21264_Ebox_LoadStore.h"
@@ -84,11 +88,6 @@ AXP_EXCEPTIONS AXP_LDA(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      */
     instr->destv.r.uq = instr->src1v.r.uq + instr->displacement;
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -124,11 +123,6 @@ AXP_EXCEPTIONS AXP_LDAH(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     instr->destv.r.uq = instr->src1v.r.uq
   + (instr->displacement * AXP_LDAH_MULT);
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
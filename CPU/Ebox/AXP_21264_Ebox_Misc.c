@@ -36,6 +36,10 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  These functions no longer set the instruction state.  The dispatcher moves
+ *  the instruction to WaitingRetirement once the exception value is stored.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Ebox/AXP_21264_Ebox_Misc.h"
@@ -102,11 +106,6 @@ AXP_AMASK(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
         instr->destv.r.uq = Rbv & ~*aMask;
     }
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -150,11 +149,6 @@ AXP_CALL_PAL(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      */
     instr->branchPC = AXP_21264_GetPALFuncVPC(cpu, instr->function);
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -190,11 +184,6 @@ AXP_IMPLVER(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      */
     instr->destv.r.uq = cpu->implVer;
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -226,11 +215,6 @@ AXP_ECB(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
 {
     AXP_DcacheEvict(cpu, instr->src1v.r.uq, instr->pc);
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -264,7 +248,6 @@ AXP_EXCB(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     /*
      * There is nothing we have to do except get retired.
      */
-    instr->state = WaitingRetirement;
 
     /*
      * Return back to the caller with any exception that may have occurred.
@@ -307,11 +290,6 @@ AXP_FETCH(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      *          now, this is implemented as a NO-OP.
      */
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -353,11 +331,6 @@ AXP_FETCH_M(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      *          now, this is implemented as a NO-OP.
      */
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -398,11 +371,6 @@ AXP_MB(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      *          mispredicted branch.
      */
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -459,11 +427,6 @@ AXP_RPCC(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      */
     AXP_EBOX_READ_CC(instr->destv.r.uq, cpu);
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -498,10 +461,7 @@ AXP_TRAPB(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
 
     /*
      * There is nothing we have to do except get retired.
-     *
-     * Indicate that the instruction is ready to be retired.
      */
-    instr->state = WaitingRetirement;
 
     /*
      * Return back to the caller with any exception that may have occurred.
@@ -543,11 +503,6 @@ AXP_WH64(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      *          cause this instruction to behave like a NO-OP.
      */
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
@@ -610,11 +565,6 @@ AXP_WH64EN(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
          *          this one indicates that eviction policy for the indicated
          *          64 byte location is different than the other.
          */
-
-        /*
-         * Indicate that the instruction is ready to be retired.
-         */
-        instr->state = WaitingRetirement;
     }
 
     /*
@@ -654,11 +604,6 @@ AXP_WMB(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      *          that the WMB can be retired.
      */
 
-    /*
-     * Indicate that the instruction is ready to be retired.
-     */
-    instr->state = WaitingRetirement;
-
     /*
      * Return back to the caller with any exception that may have occurred.
      */
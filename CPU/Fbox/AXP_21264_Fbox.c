@@ -39,6 +39,10 @@
  *	V01.004		27-Feb-2018	Jonathan D. Belanger
  *	The EboxMain and FboxMain functions were nearly identical, so they were
  *	combined into one that is now in COMUTL.
+ *
+ *	V01.005		19-Oct-2026	Jonathan D. Belanger
+ *	Completion atomically moves the instruction from Executing to
+ *	WaitingRetirement.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Fbox/AXP_21264_Fbox.h"
@@ -74,6 +78,7 @@ void AXP_21264_Fbox_Compl(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     AXP_F_MEMORY *tmpF = (AXP_F_MEMORY *) &tmp;
     AXP_G_MEMORY *tmpG = (AXP_G_MEMORY *) &tmp;
     AXP_S_MEMORY *tmpS = (AXP_S_MEMORY *) &tmp;
+    AXP_INS_STATE state = Executing;
 
     if (instr->excRegMask == NoException)
     {
@@ -162,9 +167,10 @@ void AXP_21264_Fbox_Compl(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     }
 
     /*
-     * Indicate that the instruction is ready to be retired.
+     * Indicate that the instruction is ready to be retired, unless the Ibox
+     * aborted it while the Mbox was working on it.
      */
-    instr->state = WaitingRetirement;
+    AXP_ROB_CHANGE_STATE(instr, &state, WaitingRetirement);
 
     /*
      * We want the Fbox threads to handle their own completion.  The Mbox has
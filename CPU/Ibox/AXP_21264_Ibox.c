@@ -123,6 +123,54 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.016 19-Oct-2026 Jonathan D. Belanger
+ *  Retiring instructions now moves the cycle counter and the timers' virtual
+ *  clock on, and going to sleep marks the CPU idle for the timers.
+ *
+ *  V01.017 19-Oct-2026 Jonathan D. Belanger
+ *  Retirement now detects the CPU going around a loop that makes no progress,
+ *  such as a branch to itself, and the Ibox parks the CPU until an interrupt
+ *  or other event arrives, instead of fetching the loop over and over.
+ *
+ *  V01.018 19-Oct-2026 Jonathan D. Belanger
+ *  The IRQ_H bits are taken and cleared atomically, as they are now set
+ *  without a lock.
+ *
+ *  V01.019 19-Oct-2026 Jonathan D. Belanger
+ *  Added the Icache prefetcher.  Each time the fetch moves to a different
+ *  Icache line, the lines after it are requested from the Cbox, and the
+ *  prefetches are counted as useful, late or wasted.
+ *
+ *  V01.020 19-Oct-2026 Jonathan D. Belanger
+ *  Retiring a branch counts how well it was predicted and, when requested,
+ *  writes it to the branch trace file.
+ *
+ *  V01.021 19-Oct-2026 Jonathan D. Belanger
+ *  The ROB mutex is gone.  The Ibox is the only thread that moves the ROB
+ *  start and end indexes, and the state of each entry is published and
+ *  examined with atomic stores and loads, so neither decoding nor retiring
+ *  blocks the Ebox and Fbox.
+ *
+ *  V01.022 19-Oct-2026 Jonathan D. Belanger
+ *  Retirement is done in batches.  Every consecutive instruction waiting for
+ *  retirement, up to the first one that aborts the rest, is retired in one
+ *  pass, the freed physical registers are put back onto the free lists
+ *  together, and the Ebox and Fbox are each signaled at most once.
+ *
+ *  V01.023 19-Oct-2026 Jonathan D. Belanger
+ *  An Icache prefetch is skipped, and counted, when the MAF has no entry free
+ *  for it, so prefetches never wait for one ahead of demand misses.
+ *
+ *  V01.024 19-Oct-2026 Jonathan D. Belanger
+ *  Idle detection now also recognizes the loops the PALcode and operating
+ *  systems wait in.  CALL_PAL WTINT parks the CPU until an interrupt.  A loop
+ *  that only reads memory or IPRs, getting the same values each time around,
+ *  parks the CPU for a while at a time, or until a probe arrives.
+ *
+ *  V01.025 19-Oct-2026 Jonathan D. Belanger
+ *  IRQ<1> is a level.  When the CPU takes it, the System is told to redo the
+ *  IRQ_H bits, so that it is posted again while a device still asserts it.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CommonUtilities/AXP_Dumps.h"
@@ -131,7 +179,16 @@
 #include "CPU/Ibox/AXP_21264_Ibox_InstructionDecoding.h"
 #include "CPU/Ibox/AXP_21264_Ibox_PCHandling.h"
 #include "CPU/Mbox/AXP_21264_Mbox.h"
+#include "CPU/Cbox/SystemInterface/AXP_21264_to_System.h"
 #include "CommonUtilities/AXP_Trace.h"
+#include "CommonUtilities/AXP_TimerWheel.h"
+#include <errno.h>
+
+/*
+ * How long a CPU is parked in an idle loop that polls memory, before it goes
+ * around the loop again to see if what it is polling has changed.
+ */
+#define AXP_IBOX_IDLE_POLL_NS	1000000
 
 /*
  * A local structure used to calculate the PC for a CALL_PAL function.
@@ -213,6 +270,17 @@ static char *_ins_state_[] =
 static AXP_QUEUE_ENTRY *AXP_GetNextIQEntry(AXP_21264_CPU *);
 static AXP_QUEUE_ENTRY *AXP_GetNextFQEntry(AXP_21264_CPU *);
 
+/*
+ * Functions that detect an idle loop and park the CPU in it.
+ */
+static void AXP_21264_Ibox_IdleCheck(AXP_21264_CPU *, AXP_INSTRUCTION *);
+static void AXP_21264_Ibox_Park(AXP_21264_CPU *);
+
+/*
+ * Function that runs the Icache prefetcher ahead of the fetch.
+ */
+static void AXP_21264_Ibox_Prefetch(AXP_21264_CPU *, AXP_PC, bool);
+
 /*
  * AXP_GetNextIQEntry
  *  This function is called to get the next available entry for the IQ queue.
@@ -481,8 +549,19 @@ void AXP_21264_Ibox_Event(AXP_21264_CPU *cpu,
                 break;
 
             case AXP_INTERRUPT:
-                cpu->iSum.ei = cpu->irqH;
-                cpu->irqH = 0;
+                cpu->iSum.ei = __atomic_exchange_n(&cpu->irqH,
+                                                   0,
+                                                   __ATOMIC_SEQ_CST);
+
+                /*
+                 * IRQ<1> is the device interrupt line, which stays asserted
+                 * until the device deasserts it.  Have the System redo our
+                 * IRQ_H bits, so that it is posted again if it still is.
+                 */
+                if ((cpu->iSum.ei & 0x02) != 0)
+                {
+                    AXP_21264_InterruptTaken(cpu);
+                }
                 break;
 
             case AXP_MCHK:
@@ -510,9 +589,15 @@ void AXP_21264_Ibox_Event(AXP_21264_CPU *cpu,
         pthread_mutex_unlock(&cpu->iBoxIPRMutex);
 
         /*
-         * Let the main loop know that there is an exception pending.
+         * Let the main loop know that there is an exception pending.  If the
+         * CPU is parked in an idle loop, it is busy again from now.
          */
         cpu->excPend = true;
+        if (cpu->parked == true)
+        {
+            cpu->parked = false;
+            AXP_TimerIdle(false);
+        }
 
         /*
          * We, the Ibox, did not call this function, then we need signal the
@@ -973,8 +1058,13 @@ void AXP_21264_Ibox_Retire_HW_MTPR(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
                 AXP_IBOX_WRITE_I_STAT(instr->src1v.r.uq, cpu);
                 break;
 
+            /*
+             * The CPU is idle for the timers until the Cbox wakes it up
+             * on an interrupt, when it is marked busy again.
+             */
             case AXP_IPR_SLEEP:
                 cpu->cpuState = Sleep;
+                AXP_TimerIdle(true);
                 break;
 
             case AXP_IPR_PCXT0:
@@ -1361,13 +1451,405 @@ void AXP_21264_Ibox_Retire_HW_MTPR(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     return;
 }
 
+/*
+ * AXP_21264_Ibox_IdleCheck
+ *  This function is called, for each instruction retired, to detect the CPU
+ *  going around a loop that makes no progress.  A loop is the instructions
+ *  from the target of a backward branch to the branch back to it.  When a loop
+ *  is gone around without retiring anything that changes a register, memory
+ *  or the CPU's state, then each time around will be the same, until an
+ *  interrupt takes the CPU out of it.
+ *
+ *  This covers the idle loops of the operating systems, which poll memory
+ *  (for work to do, or a lock to be released) and do not write anything
+ *  until it changes.  As something other than an interrupt can change
+ *  memory, such a loop is marked as polling.  It also covers CALL_PAL WTINT,
+ *  which the OpenVMS and Tru64 UNIX PALcode provide to wait for an
+ *  interrupt.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  rob:
+ *      A pointer to the instruction being retired.
+ *
+ * Output Parameters:
+ *  cpu:
+ *      The idle field is set when the CPU is in an idle loop.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21264_Ibox_IdleCheck(AXP_21264_CPU *cpu, AXP_INSTRUCTION *rob)
+{
+    u64 target = AXP_GET_PC(rob->branchPC);
+    bool destFloat;
+    bool changed = false;
+
+    /*
+     * An instruction that writes a register only makes progress if the value
+     * written is not the one the register already had.  The register the
+     * destination was mapped to before this instruction has the previous
+     * value, as everything before this instruction has been retired.
+     */
+    if ((rob->decodedReg.bits.dest != 0) && (rob->aDest != AXP_UNMAPPED_REG))
+    {
+        destFloat = (rob->decodedReg.bits.dest & AXP_REG_FP) == AXP_REG_FP;
+        if (destFloat == true)
+        {
+            changed = cpu->pf[rob->prevDestMap].value != rob->destv.fp.uq;
+        }
+        else
+        {
+            changed = cpu->pr[rob->prevDestMap].value != rob->destv.r.uq;
+        }
+    }
+
+    if (rob->excRegMask != NoException)
+    {
+        cpu->idleProgress = true;
+    }
+
+    /*
+     * CALL_PAL WTINT is a request to wait for an interrupt.  Any other CALL_PAL
+     * function makes progress.
+     */
+    else if (rob->opcode == PAL00)
+    {
+        if (rob->function == OSF_WTINT)
+        {
+            cpu->idleLoop = AXP_GET_PC(rob->pc);
+            cpu->idle = true;
+        }
+        else
+        {
+            cpu->idleProgress = true;
+        }
+    }
+    else if (rob->type == Branch)
+    {
+
+        /*
+         * A taken branch backward, or to itself, closes a loop.  If it is the
+         * same loop as last time, and nothing made progress going around it,
+         * the CPU is idle.  If the loop polled memory, then the CPU is only
+         * parked for a while.
+         */
+        if ((target != 0) && (target <= AXP_GET_PC(rob->pc)))
+        {
+            if ((target == cpu->idleLoop) && (cpu->idleProgress == false))
+            {
+                cpu->idle = true;
+                if (cpu->idlePoll == true)
+                {
+                    cpu->idleTimed = true;
+                }
+            }
+            cpu->idleLoop = target;
+            cpu->idleProgress = false;
+            cpu->idlePoll = false;
+        }
+    }
+
+    /*
+     * The barriers only order what else is done.
+     */
+    else if ((rob->opcode == MISC) &&
+             ((rob->function == AXP_FUNC_TRAPB) ||
+              (rob->function == AXP_FUNC_EXCB) ||
+              (rob->function == AXP_FUNC_MB) ||
+              (rob->function == AXP_FUNC_WMB)))
+    {
+        /* Nothing to do */
+    }
+
+    /*
+     * A load, or a read of an IPR, that returns what the register already had
+     * is polling for a change.  LDA and LDAH are operates that only look like
+     * loads.
+     */
+    else if ((rob->type == Load) &&
+             (rob->opcode != LDA) &&
+             (rob->opcode != LDAH))
+    {
+        if (changed == true)
+        {
+            cpu->idleProgress = true;
+        }
+        else
+        {
+            cpu->idlePoll = true;
+        }
+    }
+
+    /*
+     * Operate instructions only make progress when they change a register.
+     * Stores, and everything else, can make progress.
+     */
+    else if (((rob->type != Arith) &&
+              (rob->type != Logic) &&
+              (rob->type != Oper) &&
+              (rob->type != Load)) ||
+             (changed == true))
+    {
+        cpu->idleProgress = true;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21264_Ibox_Park
+ *  This function is called, with the Ibox mutex locked, when retirement has
+ *  detected the CPU is in an idle loop.  Unless an event is already pending,
+ *  the CPU is marked idle, and the Ibox waits until AXP_21264_Ibox_Event
+ *  queues an event, such as an interrupt passed on by the Cbox from
+ *  AXP_21264_Set_IRQ or AXP_21264_InterruptToCPU.  With the Ibox not fetching,
+ *  the other boxes run out of work and wait as well.  If the idle loop polls
+ *  memory, the Ibox also stops waiting after AXP_IBOX_IDLE_POLL_NS, or when
+ *  AXP_21264_Ibox_Wake is called for a probe, and goes around the loop again.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21264_Ibox_Park(AXP_21264_CPU *cpu)
+{
+    struct timespec abstime;
+    bool timed = cpu->idleTimed;
+    int pthreadRet = 0;
+
+    cpu->idle = false;
+    cpu->idleProgress = true;
+    if (cpu->excPend == false)
+    {
+        if (AXP_IBOX_OPT1)
+        {
+            AXP_TRACE_BEGIN();
+            AXP_TraceWrite("Ibox parking CPU in idle loop at pc: 0x%016llx",
+                           cpu->idleLoop);
+            AXP_TRACE_END();
+        }
+        cpu->parked = true;
+        AXP_TimerIdle(true);
+        if (timed == true)
+        {
+            clock_gettime(CLOCK_REALTIME, &abstime);
+            abstime.tv_nsec += AXP_IBOX_IDLE_POLL_NS;
+            if (abstime.tv_nsec >= 1000000000)
+            {
+                abstime.tv_sec++;
+                abstime.tv_nsec -= 1000000000;
+            }
+        }
+        while ((cpu->parked == true) &&
+               (cpu->cpuState == Run) &&
+               (pthreadRet != ETIMEDOUT))
+        {
+            if (timed == true)
+            {
+                pthreadRet = pthread_cond_timedwait(&cpu->iBoxCondition,
+                                                    &cpu->iBoxMutex,
+                                                    &abstime);
+            }
+            else
+            {
+                pthread_cond_wait(&cpu->iBoxCondition, &cpu->iBoxMutex);
+            }
+        }
+        if (cpu->parked == true)
+        {
+            cpu->parked = false;
+            AXP_TimerIdle(false);
+        }
+    }
+    cpu->idleTimed = false;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21264_Ibox_Wake
+ *  This function is called by the Cbox when it has processed a probe.  The
+ *  probe may be for memory that another CPU, or a device, has changed, so if
+ *  the CPU is parked in an idle loop that polls memory, the Ibox is woken up
+ *  to go around the loop again.  A CPU parked waiting for an interrupt is
+ *  left parked.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_21264_Ibox_Wake(AXP_21264_CPU *cpu)
+{
+    pthread_mutex_lock(&cpu->iBoxMutex);
+    if ((cpu->parked == true) && (cpu->idleTimed == true))
+    {
+        cpu->parked = false;
+        AXP_TimerIdle(false);
+        pthread_cond_signal(&cpu->iBoxCondition);
+    }
+    pthread_mutex_unlock(&cpu->iBoxMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21264_Ibox_Prefetch
+ *  This function is called when the Ibox starts fetching from a different
+ *  Icache line.  If the line was one we prefetched, it is counted as useful
+ *  when it was already in the Icache, or late when it was not.  Then the next
+ *  iPrefetchDepth lines that are not already in the Icache, or already on
+ *  their way, are requested from the Cbox.
+ *
+ *  A prefetch never faults, goes to the PALcode, or changes the TB miss
+ *  state.  So, we stop at the first line that does not already have an ITB
+ *  entry we can execute from (unless we are in PALmode, which is physically
+ *  addressed).  We also stop when the MAF does not have an entry free for the
+ *  prefetch, rather than have it wait for one.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure for the emulated Alpha AXP 21264
+ *      processor.
+ *  pc:
+ *      A value containing the PC being fetched.
+ *  hit:
+ *      A boolean indicating whether the fetch found the line in the Icache.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21264_Ibox_Prefetch(AXP_21264_CPU *cpu, AXP_PC pc, bool hit)
+{
+    AXP_21264_TLB *itb;
+    AXP_PC linePC = pc;
+    u64 line, pa;
+    u32 ii, jj;
+    bool pending;
+
+    /*
+     * Score the line being fetched, if it is one we prefetched.
+     */
+    linePC.pc &= ~((u64) (AXP_ICACHE_LINE_INS - 1));
+    line = AXP_GET_PC(linePC);
+    for (ii = 0; ii < AXP_ICACHE_PREFETCH_LEN; ii++)
+    {
+        if ((cpu->iPrefetch[ii].valid == true) &&
+            (cpu->iPrefetch[ii].line == line))
+        {
+            if (hit == true)
+            {
+                cpu->iCacheStats.useful++;
+            }
+            else
+            {
+                cpu->iCacheStats.late++;
+            }
+            cpu->iPrefetch[ii].valid = false;
+        }
+    }
+
+    /*
+     * Now run ahead of the fetch, requesting the lines that follow it.
+     */
+    for (ii = 0; ii < cpu->iPrefetchDepth; ii++)
+    {
+        linePC.pc += AXP_ICACHE_LINE_INS;
+        line = AXP_GET_PC(linePC);
+        if (AXP_IcacheValid(cpu, linePC) == true)
+        {
+            continue;
+        }
+        pending = false;
+        for (jj = 0; ((jj < AXP_ICACHE_PREFETCH_LEN) && (pending == false));
+             jj++)
+        {
+            pending = (cpu->iPrefetch[jj].valid == true) &&
+                      (cpu->iPrefetch[jj].line == line);
+        }
+        if (pending == true)
+        {
+            continue;
+        }
+        if (linePC.pal == AXP_PAL_MODE)
+        {
+            pa = line & ~((u64) AXP_PAL_MODE);
+        }
+        else
+        {
+            itb = AXP_findTLBEntry(cpu, line, false);
+            if ((itb == NULL) ||
+                (AXP_21264_checkMemoryAccess(cpu, itb, Execute) !=
+                 NoException))
+            {
+                break;
+            }
+            pa = itb->physAddr | (line & itb->keepMask);
+        }
+        if (AXP_21264_Prefetch_MAF(cpu, pa) == false)
+        {
+            cpu->iCacheStats.skipped++;
+            break;
+        }
+
+        /*
+         * Remember the request.  If the entry we need is still holding an
+         * earlier prefetch, then that line was never fetched from.
+         */
+        jj = cpu->iPrefetchNext;
+        if (cpu->iPrefetch[jj].valid == true)
+        {
+            cpu->iCacheStats.wasted++;
+        }
+        cpu->iPrefetch[jj].line = line;
+        cpu->iPrefetch[jj].valid = true;
+        cpu->iPrefetchNext = (jj + 1) % AXP_ICACHE_PREFETCH_LEN;
+        cpu->iCacheStats.issued++;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
 /*
  * AXP_21264_Ibox_Retire
  *  This function is called whenever an instruction is transitioned to
  *  WaitingRetirement state.  This function will search through the ReOrder
  *  Buffer (ROB) from the oldest to the newest and retire all the instructions
  *  it can, in order.  If there was an exception, this should cause the
- *  remaining instructions to be flushed and not retired.
+ *  remaining instructions to be flushed and not retired.  The physical
+ *  registers freed by the retired instructions are collected and returned to
+ *  the free lists once, and each box waiting on a register is signaled once.
  *
  * Input Parameters:
  *  cpu:
@@ -1384,8 +1866,9 @@ void AXP_21264_Ibox_Retire_HW_MTPR(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
 bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
 {
     AXP_INSTRUCTION *rob;
+    AXP_RETIRE_BATCH batch;
     u32 ii, end;
-    u32 signalWho = AXP_SIGNAL_NONE;
+    u32 retired = 0;
     bool split;
     bool done = false;
     bool updateDest = false;
@@ -1401,11 +1884,9 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
         AXP_TRACE_END();
     }
 
-    /*
-     * First lock the ROB mutex so that it is not updated by anyone but this
-     * function.
-     */
-    pthread_mutex_lock(&cpu->robMutex);
+    batch.prCount = 0;
+    batch.pfCount = 0;
+    batch.signalWho = AXP_SIGNAL_NONE;
 
     /*
      * The split flag is used to determine when the end index has wrapped to
@@ -1453,9 +1934,10 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
          * If the next entry is ready for retirement, then complete the work
          * necessary for this instruction.  If it is not, then because
          * instructions need to be completed in order, then we are done trying
-         * to retire instructions.
+         * to retire instructions.  The acquire load of the state makes the
+         * results the Ebox or Fbox stored before publishing it visible here.
          */
-        if (rob->state == WaitingRetirement)
+        if (AXP_ROB_GET_STATE(rob) == WaitingRetirement)
         {
 
             /*
@@ -1492,13 +1974,17 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
                 /*
                  * Call the function to abort all instructions immediately
                  * after the current one.  This may change the value of
-                 * cpu->robEnd.
+                 * cpu->robEnd.  The aborting code puts registers back onto the
+                 * free lists itself, so the batch has to be on them first.
+                 * Nothing after this instruction can be retired in this pass.
                  */
+                AXP_ReleaseRegisters(cpu, &batch);
                 if ((AXP_AbortInstructions(cpu, rob) == true) &&
                     (stallRetired == false))
                 {
                     stallRetired = true;
                 }
+                done = true;
             }
             else
             {
@@ -1539,6 +2025,15 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
                                          taken,
                                          rob->localPredict,
                                          rob->globalPredict);
+                    AXP_Branch_Count(&cpu->bpStats,
+                                     taken,
+                                     rob->branchPredict,
+                                     rob->localPredict,
+                                     rob->globalPredict);
+                    if (cpu->bpTraceFp != NULL)
+                    {
+                        AXP_Branch_Trace(cpu, rob->pc, taken, rob->branchPC);
+                    }
 
                     /*
                      * Step 2:
@@ -1598,13 +2093,17 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
                         /*
                          * Call the function to abort all instructions
                          * immediately after the current one.  This may change
-                         * the value of cpu->robEnd.
+                         * the value of cpu->robEnd.  As above, the batch goes
+                         * onto the free lists first and this is the last
+                         * instruction retired in this pass.
                          */
+                        AXP_ReleaseRegisters(cpu, &batch);
                         if ((AXP_AbortInstructions(cpu, rob) == true) &&
                             (stallRetired == false))
                         {
                             stallRetired = true;
                         }
+                        done = true;
 
                         /*
                          * Step 4:
@@ -1641,7 +2140,7 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
                  */
                 if (updateDest == true)
                 {
-                    signalWho = AXP_UpdateRegisters(cpu, rob);
+                    AXP_UpdateRegisters(cpu, rob, &batch);
                 }
                 updateDest = false;
 
@@ -1703,7 +2202,9 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
              * Mark the instruction retired and move the top of the stack to
              * the next instruction location.
              */
-            rob->state = Retired;
+            AXP_ROB_SET_STATE(rob, Retired);
+            retired++;
+            AXP_21264_Ibox_IdleCheck(cpu, rob);
 
             cpu->robStart = (cpu->robStart + 1) % AXP_INFLIGHT_MAX;
             if (AXP_IBOX_INST)
@@ -1750,10 +2251,23 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
     }
 
     /*
-     * Finally, unlock the ROB mutex so that it can be updated by another
-     * thread.
+     * Put all the physical registers freed by the instructions just retired
+     * back onto the free lists.
      */
-    pthread_mutex_unlock(&cpu->robMutex);
+    AXP_ReleaseRegisters(cpu, &batch);
+
+    /*
+     * The cycle counter, when it is enabled, and the clock for the timers,
+     * when in virtual time, count the instructions retired.
+     */
+    if (retired > 0)
+    {
+        if (cpu->ccCtl.cc_ena == 1)
+        {
+            cpu->cc.counter += retired;
+        }
+        AXP_TimerRetire(retired);
+    }
 
     /*
      * If a stall was retired, then we need to let the Ibox know, so that it
@@ -1771,7 +2285,7 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
      * is one or more Queued Floating Point instructions that can now be
      * executed.
      */
-    if (signalWho == AXP_SIGNAL_FBOX)
+    if ((batch.signalWho & AXP_SIGNAL_FBOX) != 0)
     {
         pthread_cond_broadcast(&cpu->fBoxCondition);
     }
@@ -1782,7 +2296,7 @@ bool AXP_21264_Ibox_Retire(AXP_21264_CPU *cpu)
      * of them was for the Ebox, signal it to wake up and check to see if there
      * is one or more Queued Integer instructions that can now be executed.
      */
-    if (signalWho == AXP_SIGNAL_EBOX)
+    if ((batch.signalWho & AXP_SIGNAL_EBOX) != 0)
     {
         pthread_cond_broadcast(&cpu->eBoxCondition);
     }
@@ -1824,6 +2338,8 @@ void *AXP_21264_IboxMain(void *voidPtr)
     bool _asm;
     bool noop;
     bool aborting, branchPredicted = false;
+    u64 fetchLine = (u64) -1;   /* no Icache line fetched from, yet */
+    AXP_PC linePC;
 
     /*
      * Make sure to initialize the line and set prediction information.
@@ -1831,6 +2347,7 @@ void *AXP_21264_IboxMain(void *voidPtr)
     nextCacheLine.branch2bTaken = false;
     nextCacheLine.linePrediction = 0;
     nextCacheLine.setPrediction = 0;
+    nextCacheLine.fetchValid = false;
 
     /*
      * OK, we are just starting out and there is probably nothing available to
@@ -1897,6 +2414,19 @@ void *AXP_21264_IboxMain(void *voidPtr)
     while (cpu->cpuState == Run)
     {
 
+        /*
+         * If retirement found the CPU in an idle loop, there is no point in
+         * fetching it again.  Park the CPU until something happens.
+         */
+        if (cpu->idle == true)
+        {
+            AXP_21264_Ibox_Park(cpu);
+            if (cpu->cpuState != Run)
+            {
+                break;
+            }
+        }
+
         /*
          * Exceptions take precedence over normal CPU processing.  IF an
          * exception occurred, then make this the next PC and clear the
@@ -1925,8 +2455,20 @@ void *AXP_21264_IboxMain(void *voidPtr)
          * get the Cbox to fill the iCache.  If the former, store the faulting
          * PC and generate an exception.
          */
+        linePC = nextPC;
+        linePC.pc &= ~((u64) (AXP_ICACHE_LINE_INS - 1));
         if (AXP_IcacheFetch(cpu, nextPC, &nextCacheLine) == true)
         {
+
+            /*
+             * If we have moved onto a different Icache line, then run the
+             * prefetcher ahead of it.
+             */
+            if (AXP_GET_PC(linePC) != fetchLine)
+            {
+                fetchLine = AXP_GET_PC(linePC);
+                AXP_21264_Ibox_Prefetch(cpu, nextPC, true);
+            }
             aborting = false;
             for (ii = 0;
                  ((ii < AXP_NUM_FETCH_INS) && (aborting == false));
@@ -1934,10 +2476,9 @@ void *AXP_21264_IboxMain(void *voidPtr)
             {
 
                 /*
-                 * Lock the ROB mutex so that it is not updated by anyone but
-                 * this function.
+                 * Only the Ibox moves the ROB end index, so no lock is needed
+                 * to allocate the next entry.
                  */
-                pthread_mutex_lock(&cpu->robMutex);
                 decodedInstr = &cpu->rob[cpu->robEnd];
                 if (AXP_IBOX_BUFF)
                 {
@@ -1951,11 +2492,6 @@ void *AXP_21264_IboxMain(void *voidPtr)
 
                 cpu->robEnd = (cpu->robEnd + 1) % AXP_INFLIGHT_MAX;
 
-                /*
-                 * We are done with the ROB mutex.
-                 */
-                pthread_mutex_unlock(&cpu->robMutex);
-
                 /*
                  * Go and decode the instruction, as well as rename the
                  * architectural registers to their physical equivalent.
@@ -2156,7 +2692,7 @@ void *AXP_21264_IboxMain(void *voidPtr)
                             }
                         }
                     }
-                    decodedInstr->state = Queued;
+                    AXP_ROB_SET_STATE(decodedInstr, Queued);
                     if (whichQueue == AXP_IQ)
                     {
 
@@ -2234,7 +2770,7 @@ void *AXP_21264_IboxMain(void *voidPtr)
                 }
                 else
                 {
-                    decodedInstr->state = WaitingRetirement;
+                    AXP_ROB_SET_STATE(decodedInstr, WaitingRetirement);
                 }
 
                 /*
@@ -2359,6 +2895,16 @@ void *AXP_21264_IboxMain(void *voidPtr)
                                       0,
                                       AXP_ICACHE_BUF_LEN,
                                       false);
+
+                    /*
+                     * While the Cbox is getting this line, have it get the
+                     * ones after it as well.
+                     */
+                    if (AXP_GET_PC(linePC) != fetchLine)
+                    {
+                        fetchLine = AXP_GET_PC(linePC);
+                        AXP_21264_Ibox_Prefetch(cpu, nextPC, false);
+                    }
                 }
             }
         }
@@ -2381,8 +2927,30 @@ void *AXP_21264_IboxMain(void *voidPtr)
         AXP_TRACE_BEGIN();
         AXP_TraceWrite("Ibox is not/no longer in the Run State (%d)",
                        cpu->cpuState);
+        AXP_TraceWrite("Icache line prediction hits %llu, misses %llu",
+                       cpu->iCacheStats.linePredHits,
+                       cpu->iCacheStats.linePredMisses);
+        AXP_TraceWrite("Icache prefetches issued %llu, useful %llu, late "
+                       "%llu, wasted %llu, skipped %llu",
+                       cpu->iCacheStats.issued,
+                       cpu->iCacheStats.useful,
+                       cpu->iCacheStats.late,
+                       cpu->iCacheStats.wasted,
+                       cpu->iCacheStats.skipped);
+        AXP_TraceWrite("Branches retired %llu, taken %llu, predicted "
+                       "correctly %llu",
+                       cpu->bpStats.branches,
+                       cpu->bpStats.taken,
+                       cpu->bpStats.correct);
+        AXP_TraceWrite("Branch local predictor correct %llu, global "
+                       "predictor correct %llu, chooser correct %llu of %llu",
+                       cpu->bpStats.localCorrect,
+                       cpu->bpStats.globalCorrect,
+                       cpu->bpStats.chooserCorrect,
+                       cpu->bpStats.disagree);
         AXP_TRACE_END();
     }
+    AXP_Branch_TraceClose(cpu);
 
     /*
      * If we set the wasRunning flag, then we locked the iBox mutex.  Make
@@ -31,6 +31,20 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Initialize the Icache line and set predictors, and the Icache prefetch
+ *  depth, tracking and statistics.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Initialize the branch prediction statistics and open the branch trace
+ *  file, when one has been requested.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Invalidate the register map history.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  Clear the count of skipped Icache prefetches.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Ibox/AXP_21264_Ibox.h"
@@ -197,6 +211,14 @@ bool AXP_21264_Ibox_Init(AXP_21264_CPU *cpu)
         cpu->globalPredictor.gbl_pred[ii] = 0;
     }
     cpu->globalPathHistory = 0;
+    cpu->bpStats.branches = 0;
+    cpu->bpStats.taken = 0;
+    cpu->bpStats.correct = 0;
+    cpu->bpStats.localCorrect = 0;
+    cpu->bpStats.globalCorrect = 0;
+    cpu->bpStats.disagree = 0;
+    cpu->bpStats.chooserCorrect = 0;
+    AXP_Branch_TraceOpen(cpu);
     for (ii = 0; ii < AXP_INFLIGHT_MAX; ii++)
     {
         AXP_PUT_PC(cpu->predictionStack[ii], 0);
@@ -353,6 +375,13 @@ bool AXP_21264_Ibox_Init(AXP_21264_CPU *cpu)
             cpu->iCache[ii][jj].tag = 0;
             cpu->iCache[ii][jj].set_0_1 = 0;
             cpu->iCache[ii][jj].res_1 = 0;
+            for (kk = 0; kk < AXP_ICACHE_FETCH_BLKS; kk++)
+            {
+                cpu->iCache[ii][jj].linePred[kk].index = 0;
+                cpu->iCache[ii][jj].linePred[kk].set = 0;
+                cpu->iCache[ii][jj].linePred[kk].vb = 0;
+                cpu->iCache[ii][jj].linePred[kk].res = 0;
+            }
             for (kk = 0; kk < AXP_ICACHE_LINE_INS; kk++)
             {
                 cpu->iCache[ii][jj].instructions[kk].instr = 0;
@@ -360,6 +389,24 @@ bool AXP_21264_Ibox_Init(AXP_21264_CPU *cpu)
         }
     }
 
+    /*
+     * Initialize the Icache prefetcher and its statistics.
+     */
+    cpu->iPrefetchDepth = AXP_ConfigGet_IcachePrefetch();
+    cpu->iPrefetchNext = 0;
+    for (ii = 0; ii < AXP_ICACHE_PREFETCH_LEN; ii++)
+    {
+        cpu->iPrefetch[ii].line = 0;
+        cpu->iPrefetch[ii].valid = false;
+    }
+    cpu->iCacheStats.linePredHits = 0;
+    cpu->iCacheStats.linePredMisses = 0;
+    cpu->iCacheStats.issued = 0;
+    cpu->iCacheStats.useful = 0;
+    cpu->iCacheStats.late = 0;
+    cpu->iCacheStats.wasted = 0;
+    cpu->iCacheStats.skipped = 0;
+
     /*
      * Initialize the Instruction Translation Look-aside Buffer.
      */
@@ -395,6 +442,7 @@ bool AXP_21264_Ibox_Init(AXP_21264_CPU *cpu)
     for (ii = 0; ii < AXP_INFLIGHT_MAX; ii++)
     {
         cpu->rob[ii].state = Retired;
+        cpu->mapCkpt[ii].valid = false;
     }
 
     if (AXP_IBOX_OPT1)
@@ -36,6 +36,21 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Aborting an instruction changes its state with a compare and exchange, as
+ *  the Ebox or Fbox may be completing it at the same time.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Retiring an instruction adds the physical registers it frees to a batch,
+ *  which AXP_ReleaseRegisters puts back onto the free lists all at once.  The
+ *  floating-point free list now wraps at its own size.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  The register maps are saved in the map history when a branch is decoded.
+ *  Aborting back to a branch puts the maps back from there and rebuilds the
+ *  physical register reference counts, states and free lists from them,
+ *  instead of undoing the renaming of each aborted instruction.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Ibox/AXP_21264_Ibox.h"
@@ -58,6 +73,16 @@ static u16 AXP_RegisterDecodingOpcode17(AXP_INS_FMT);
 static u16 AXP_RegisterDecodingOpcode18(AXP_INS_FMT);
 static u16 AXP_RegisterDecodingOpcode1c(AXP_INS_FMT);
 static void AXP_RenameRegisters(AXP_21264_CPU *, AXP_INSTRUCTION *);
+static void AXP_RebuildRegisters(
+    AXP_INSTRUCTION *,
+    bool,
+    AXP_REGISTERS *,
+    u32,
+    u16 *,
+    u32,
+    u16 *,
+    u16 *,
+    u16 *);
 
 /*
  * The following module specific structure and variable are used to be able to
@@ -118,6 +143,7 @@ void AXP_Decode_Rename(AXP_21264_CPU *cpu,
     bool src2Float = false;
     bool destFloat = false;
     u32 function;
+    AXP_REG_MAP_CKPT *mapCkpt;
 
     /*
      * Decode the next instruction.
@@ -396,6 +422,20 @@ void AXP_Decode_Rename(AXP_21264_CPU *cpu,
      */
     AXP_RenameRegisters(cpu, decodedInstr);
 
+    /*
+     * If this is a branch, save the register maps, as they are now, in the
+     * map history entry for its ROB entry.  If the branch was mispredicted,
+     * this is what the maps will be put back to.  The entry is invalidated for
+     * anything else, as the ROB entry is being reused.
+     */
+    mapCkpt = &cpu->mapCkpt[decodedInstr - cpu->rob];
+    mapCkpt->valid = decodedInstr->type == Branch;
+    if (mapCkpt->valid == true)
+    {
+        memcpy(mapCkpt->prMap, cpu->prMap, sizeof(cpu->prMap));
+        memcpy(mapCkpt->pfMap, cpu->pfMap, sizeof(cpu->pfMap));
+    }
+
     /*
      * Return back to the caller.
      */
@@ -786,6 +826,7 @@ static void AXP_RenameRegisters(AXP_21264_CPU *cpu,
     AXP_REGISTERS *src1Phys, *src2Phys, *destPhys;
     u16 *src1Map, *src2Map, *destMap;
     u16 *destFreeList, *flStart, *flEnd;
+    u16 flSize;
     bool src1Float = ((decodedInstr->decodedReg.bits.src1 & AXP_REG_FP) == AXP_REG_FP);
     bool src2Float = ((decodedInstr->decodedReg.bits.src2 & AXP_REG_FP) == AXP_REG_FP);
     bool destFloat = ((decodedInstr->decodedReg.bits.dest & AXP_REG_FP) == AXP_REG_FP);
@@ -831,6 +872,7 @@ static void AXP_RenameRegisters(AXP_21264_CPU *cpu,
         destFreeList = cpu->prFreeList;
         flStart = &cpu->prFlStart;
         flEnd = &cpu->prFlEnd;
+        flSize = AXP_I_FREELIST_SIZE;
     }
     else
     {
@@ -839,6 +881,7 @@ static void AXP_RenameRegisters(AXP_21264_CPU *cpu,
         destFreeList = cpu->pfFreeList;
         flStart = &cpu->pfFlStart;
         flEnd = &cpu->pfFlEnd;
+        flSize = AXP_F_FREELIST_SIZE;
     }
 
     /*
@@ -895,7 +938,7 @@ static void AXP_RenameRegisters(AXP_21264_CPU *cpu,
             }
             destPhys[destMap[decodedInstr->aDest]].state = Free;
             destFreeList[*flEnd] = destMap[decodedInstr->aDest];
-            *flEnd = (*flEnd + 1) % AXP_I_FREELIST_SIZE;
+            *flEnd = (*flEnd + 1) % flSize;
         }
 
         if (AXP_IBOX_OPT2)
@@ -917,11 +960,18 @@ static void AXP_RenameRegisters(AXP_21264_CPU *cpu,
          * to the next free register.
          */
         decodedInstr->dest = destFreeList[*flStart];
-        *flStart = (*flStart + 1) % AXP_F_FREELIST_SIZE;
+        *flStart = (*flStart + 1) % flSize;
         destMap[decodedInstr->aDest] = decodedInstr->dest;
         destPhys[decodedInstr->dest].state = PendingUpdate;
         destPhys[decodedInstr->dest].refCount = 1;
-        destPhys[decodedInstr->dest].value = 0;
+
+        /*
+         * NOTE:    The value is intentionally left alone.  It is not looked at
+         *          until the instruction is retired and stores its result.  If
+         *          the register was freed by renaming an instruction that is
+         *          later aborted, it still holds the value it had when the
+         *          register map history is put back.
+         */
     }
 
     /*
@@ -972,8 +1022,10 @@ static void AXP_RenameRegisters(AXP_21264_CPU *cpu,
  *  then dereferences the destination register.  If after dereferencing a
  *  register, the reference count goes to zero and the current register mapping
  *  does not have the architectural register mapped to the same physical
- *  register, then the physical register is put back onto the free list.  As
- *  usual, R31 and F31 are ignored, except for the reference count.
+ *  register, then the physical register is marked free and added to the
+ *  retirement batch.  The batch is put back onto the free lists by
+ *  AXP_ReleaseRegisters.  As usual, R31 and F31 are ignored, except for the
+ *  reference count.
  *
  * Input Parameters:
  *  cpu:
@@ -982,22 +1034,27 @@ static void AXP_RenameRegisters(AXP_21264_CPU *cpu,
  *  instr:
  *      A pointer to the structure containing a decoded representation of the
  *      Alpha AXP instruction.
+ *  batch:
+ *      A pointer to the retirement batch collecting the freed registers and
+ *      the boxes to be signaled.
  *
  * Output Parameters:
- *  None.
+ *  batch:
+ *      The freed physical registers are appended and the AXP_SIGNAL_EBOX or
+ *      AXP_SIGNAL_FBOX bit is set for the destination register.
  *
  * Return Value:
- *  0:    Don't signal the Ebox or Fbox.
- *  1:    Only Signal the Ebox.
- *  2:    Only Signal the Fbox.
+ *  None.
  */
-u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
+void AXP_UpdateRegisters(
+    AXP_21264_CPU *cpu,
+    AXP_INSTRUCTION *instr,
+    AXP_RETIRE_BATCH *batch)
 {
     AXP_REGISTERS *src1Phys, *src2Phys, *destPhys;
     u16 *src1Map, *src2Map, *destMap;
-    u16 *src1FreeList, *src2FreeList, *destFreeList;
-    u16 *src1FlEnd, *src2FlEnd, *destFlEnd;
-    u32 retVal = AXP_SIGNAL_NONE;
+    u16 *src1Free, *src2Free, *destFree;
+    u32 *src1Count, *src2Count, *destCount;
     bool src1Float = ((instr->decodedReg.bits.src1 & AXP_REG_FP) == AXP_REG_FP);
     bool src2Float = ((instr->decodedReg.bits.src2 & AXP_REG_FP) == AXP_REG_FP);
     bool destFloat = ((instr->decodedReg.bits.dest & AXP_REG_FP) == AXP_REG_FP);
@@ -1016,50 +1073,50 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     {
         src1Phys = cpu->pr;
         src1Map = cpu->prMap;
-        src1FreeList = cpu->prFreeList;
-        src1FlEnd = &cpu->prFlEnd;
+        src1Free = batch->prFree;
+        src1Count = &batch->prCount;
     }
     else
     {
         src1Phys = cpu->pf;
         src1Map = cpu->pfMap;
-        src1FreeList = cpu->pfFreeList;
-        src1FlEnd = &cpu->pfFlEnd;
+        src1Free = batch->pfFree;
+        src1Count = &batch->pfCount;
     }
     if (src2Float == false)
     {
         src2Phys = cpu->pr;
         src2Map = cpu->prMap;
-        src2FreeList = cpu->prFreeList;
-        src2FlEnd = &cpu->prFlEnd;
+        src2Free = batch->prFree;
+        src2Count = &batch->prCount;
     }
     else
     {
         src2Phys = cpu->pf;
         src2Map = cpu->pfMap;
-        src2FreeList = cpu->pfFreeList;
-        src2FlEnd = &cpu->pfFlEnd;
+        src2Free = batch->pfFree;
+        src2Count = &batch->pfCount;
     }
     if (destFloat == false)
     {
         destPhys = cpu->pr;
         destMap = cpu->prMap;
-        destFreeList = cpu->prFreeList;
-        destFlEnd = &cpu->prFlEnd;
+        destFree = batch->prFree;
+        destCount = &batch->prCount;
     }
     else
     {
         destPhys = cpu->pf;
         destMap = cpu->pfMap;
-        destFreeList = cpu->pfFreeList;
-        destFlEnd = &cpu->pfFlEnd;
+        destFree = batch->pfFree;
+        destCount = &batch->pfCount;
     }
 
     /*
      * Dereference the source registers.
      */
     src1Phys[instr->src1].refCount--;
-    src2Phys[instr->src1].refCount--;
+    src2Phys[instr->src2].refCount--;
 
     /*
      * Move the value from executing the instruction into the physical
@@ -1097,7 +1154,9 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
      *  2) The current register mapping is not the same since originally mapped
      *  3) The reference counter is down to zero.
      *
-     * Only return a register back onto the free list once.
+     * Only return a register back onto the free list once.  Marking it Free
+     * now is what keeps a later instruction in the same batch from freeing it
+     * a second time.
      */
     if ((instr->aSrc1 != AXP_UNMAPPED_REG) &&
         (src1Map[instr->aSrc1] != instr->src1) &&
@@ -1106,17 +1165,13 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
         if (AXP_IBOX_OPT2)
         {
             AXP_TRACE_BEGIN();
-            AXP_TraceWrite("AXP_UpdateRegisters freeing P%c%02d back onto the "
-                           "p%cFreeList[%u] : (src1)",
+            AXP_TraceWrite("AXP_UpdateRegisters freeing P%c%02d : (src1)",
                            (src1Float ? 'F' : 'R'),
-                           instr->src1,
-                           (src1Float ? 'f' : 'r'),
-                           *src1FlEnd);
+                           instr->src1);
             AXP_TRACE_END();
         }
         src1Phys[instr->src1].state = Free;
-        src1FreeList[*src1FlEnd] = instr->src1;
-        *src1FlEnd = (*src1FlEnd + 1) % AXP_I_FREELIST_SIZE;
+        src1Free[(*src1Count)++] = instr->src1;
     }
     if ((instr->aSrc2 != AXP_UNMAPPED_REG) &&
         (src2Map[instr->aSrc2] != instr->src2) &&
@@ -1126,17 +1181,13 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
         if (AXP_IBOX_OPT2)
         {
             AXP_TRACE_BEGIN();
-            AXP_TraceWrite("AXP_UpdateRegisters freeing P%c%02d back onto the "
-                           "p%cFreeList[%u] : (src2)",
+            AXP_TraceWrite("AXP_UpdateRegisters freeing P%c%02d : (src2)",
                            (src2Float ? 'F' : 'R'),
-                           instr->src2,
-                           (src2Float ? 'f' : 'r'),
-                           *src2FlEnd);
+                           instr->src2);
             AXP_TRACE_END();
         }
         src2Phys[instr->src2].state = Free;
-        src2FreeList[*src2FlEnd] = instr->src2;
-        *src2FlEnd = (*src2FlEnd + 1) % AXP_I_FREELIST_SIZE;
+        src2Free[(*src2Count)++] = instr->src2;
     }
     if ((instr->aDest != AXP_UNMAPPED_REG) &&
         (destMap[instr->aDest] != instr->dest) &&
@@ -1147,17 +1198,13 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
         if (AXP_IBOX_OPT2)
         {
             AXP_TRACE_BEGIN();
-            AXP_TraceWrite("AXP_UpdateRegisters freeing P%c%02d back onto the "
-                           "p%cFreeList[%u] : (dest)",
+            AXP_TraceWrite("AXP_UpdateRegisters freeing P%c%02d : (dest)",
                            (destFloat ? 'F' : 'R'),
-                           instr->dest,
-                           (destFloat ? 'f' : 'r'),
-                           *destFlEnd);
+                           instr->dest);
             AXP_TRACE_END();
         }
         destPhys[instr->dest].state = Free;
-        destFreeList[*destFlEnd] = instr->dest;
-        *destFlEnd = (*destFlEnd + 1) % AXP_I_FREELIST_SIZE;
+        destFree[(*destCount)++] = instr->dest;
     }
 
     /*
@@ -1170,14 +1217,98 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     {
         if (destFloat == true)
         {
-            retVal = AXP_SIGNAL_FBOX;
+            batch->signalWho |= AXP_SIGNAL_FBOX;
         }
         else
         {
-            retVal = AXP_SIGNAL_EBOX;
+            batch->signalWho |= AXP_SIGNAL_EBOX;
         }
     }
 
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_ReleaseRegisters
+ *  This function is called at the end of a run of retirements, and before
+ *  aborting instructions, to put the physical registers collected in the
+ *  retirement batch back onto the integer and floating-point free lists.  Each
+ *  list is appended to with at most two copies (one if the end index does not
+ *  wrap) and a single update of its end index.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the structure containing all the fields needed to emulate
+ *      an Alpha AXP 21264 CPU.
+ *  batch:
+ *      A pointer to the retirement batch containing the freed registers.
+ *
+ * Output Parameters:
+ *  batch:
+ *      The register counts are set back to zero.  The signalWho field is left
+ *      for the caller.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_ReleaseRegisters(AXP_21264_CPU *cpu, AXP_RETIRE_BATCH *batch)
+{
+    u32 first;
+
+    if (batch->prCount > 0)
+    {
+        if (AXP_IBOX_OPT2)
+        {
+            AXP_TRACE_BEGIN();
+            AXP_TraceWrite("AXP_ReleaseRegisters returning %u registers onto "
+                           "the prFreeList[%u]",
+                           batch->prCount,
+                           cpu->prFlEnd);
+            AXP_TRACE_END();
+        }
+        first = AXP_I_FREELIST_SIZE - cpu->prFlEnd;
+        if (first > batch->prCount)
+        {
+            first = batch->prCount;
+        }
+        memcpy(&cpu->prFreeList[cpu->prFlEnd],
+               batch->prFree,
+               first * sizeof(u16));
+        memcpy(cpu->prFreeList,
+               &batch->prFree[first],
+               (batch->prCount - first) * sizeof(u16));
+        cpu->prFlEnd = (cpu->prFlEnd + batch->prCount) % AXP_I_FREELIST_SIZE;
+        batch->prCount = 0;
+    }
+    if (batch->pfCount > 0)
+    {
+        if (AXP_IBOX_OPT2)
+        {
+            AXP_TRACE_BEGIN();
+            AXP_TraceWrite("AXP_ReleaseRegisters returning %u registers onto "
+                           "the pfFreeList[%u]",
+                           batch->pfCount,
+                           cpu->pfFlEnd);
+            AXP_TRACE_END();
+        }
+        first = AXP_F_FREELIST_SIZE - cpu->pfFlEnd;
+        if (first > batch->pfCount)
+        {
+            first = batch->pfCount;
+        }
+        memcpy(&cpu->pfFreeList[cpu->pfFlEnd],
+               batch->pfFree,
+               first * sizeof(u16));
+        memcpy(cpu->pfFreeList,
+               &batch->pfFree[first],
+               (batch->pfCount - first) * sizeof(u16));
+        cpu->pfFlEnd = (cpu->pfFlEnd + batch->pfCount) % AXP_F_FREELIST_SIZE;
+        batch->pfCount = 0;
+    }
+
 #ifdef AXP_VERIFY_REGISTERS
 
     /*
@@ -1189,7 +1320,119 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
     /*
      * Return back to the caller.
      */
-    return (retVal);
+    return;
+}
+
+/*
+ * AXP_RebuildRegisters
+ *  This function is called after the register maps have been put back from
+ *  the register map history, to make one set of physical registers (integer
+ *  or floating-point) consistent with them again.  At this point the
+ *  instruction being aborted back to is the only one still in flight (the
+ *  older ones have all been retired), so the reference counts are just the
+ *  ones for this instruction's registers.  Each mapped register is valid,
+ *  other than this instruction's own pending destination, and every register
+ *  that is neither mapped nor referenced goes onto the free list.
+ *
+ * Input Parameters:
+ *  inst:
+ *      A pointer to the structure containing a decoded representation of the
+ *      Alpha AXP instruction being aborted back to.
+ *  fp:
+ *      A value of true when rebuilding the floating-point registers, false for
+ *      the integer registers.
+ *  phys:
+ *      A pointer to the physical registers.
+ *  physMax:
+ *      The number of physical registers.
+ *  map:
+ *      A pointer to the register map just put back.
+ *  mapMax:
+ *      The number of architectural registers in the map.
+ *
+ * Output Parameters:
+ *  phys:
+ *      The reference count and state of each physical register is updated.
+ *  freeList:
+ *      A pointer to the free list to be rebuilt.
+ *  flStart:
+ *      A pointer to the index of the first free register.
+ *  flEnd:
+ *      A pointer to the index after the last free register.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_RebuildRegisters(
+    AXP_INSTRUCTION *inst,
+    bool fp,
+    AXP_REGISTERS *phys,
+    u32 physMax,
+    u16 *map,
+    u32 mapMax,
+    u16 *freeList,
+    u16 *flStart,
+    u16 *flEnd)
+{
+    bool mapped[AXP_INT_PHYS_REG];
+    u32 pendingDest = AXP_INT_PHYS_REG;
+    u32 ii;
+
+    for (ii = 0; ii < physMax; ii++)
+    {
+        mapped[ii] = false;
+        phys[ii].refCount = 0;
+    }
+    for (ii = 0; ii < mapMax; ii++)
+    {
+        mapped[map[ii]] = true;
+    }
+
+    /*
+     * Put back the references the instruction took when it was renamed.
+     */
+    if (((inst->decodedReg.bits.src1 & AXP_REG_FP) == AXP_REG_FP) == fp)
+    {
+        phys[inst->src1].refCount++;
+    }
+    if (((inst->decodedReg.bits.src2 & AXP_REG_FP) == AXP_REG_FP) == fp)
+    {
+        phys[inst->src2].refCount++;
+    }
+    if (((inst->decodedReg.bits.dest & AXP_REG_FP) == AXP_REG_FP) == fp)
+    {
+        phys[inst->dest].refCount++;
+        if (inst->aDest != AXP_UNMAPPED_REG)
+        {
+            pendingDest = inst->dest;
+        }
+    }
+
+    /*
+     * Now go through the physical registers, in order, setting the state of
+     * the mapped ones and putting the unused ones onto the free list.
+     */
+    *flStart = *flEnd = 0;
+    for (ii = 0; ii < physMax; ii++)
+    {
+        if (mapped[ii] == true)
+        {
+            if (ii != pendingDest)
+            {
+                phys[ii].state = Valid;
+            }
+        }
+        else if (phys[ii].refCount == 0)
+        {
+            phys[ii].state = Free;
+            freeList[(*flEnd)++] = ii;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
 }
 
 /*
@@ -1199,11 +1442,14 @@ u32 AXP_UpdateRegisters(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
  *  The instruction passed on the call is the one to which we want to rollback.
  *  While rolling back, the architectural to physical mapping will also be
  *  rolled back and the value at the time a destination register was assigned
- *  will be reestablished.  If an instruction is still in the either the IQ or
- *  FQ, then entry will be indicated so that the Ibox and Fbox can detect when
- *  an instruction was aborted prior to being executed.  When we detect an
- *  instruction is on one of these queues, the mutex for that queue will be
- *  broadcast.
+ *  will be reestablished.  When the instruction has an entry in the register
+ *  map history (it is a branch), the maps are put back from there instead, and
+ *  the physical registers rebuilt from them, so the register work does not
+ *  depend upon the number of instructions aborted.  If an instruction is
+ *  still in the either the IQ or FQ, then entry will be indicated so that the
+ *  Ibox and Fbox can detect when an instruction was aborted prior to being
+ *  executed.  When we detect an instruction is on one of these queues, the
+ *  mutex for that queue will be broadcast.
  *
  * Input Parameters:
  *  cpu:
@@ -1229,6 +1475,8 @@ bool AXP_AbortInstructions(AXP_21264_CPU *cpu, AXP_INSTRUCTION *inst)
     u16 *destFlStart;
     u16 *destFlEnd;
     u32 endIdx = cpu->robEnd;
+    AXP_INS_STATE state, newState = Retired;
+    AXP_REG_MAP_CKPT *mapCkpt = &cpu->mapCkpt[inst - cpu->rob];
     bool rollbackRegisterMap;
     bool retVal = false;
 
@@ -1243,9 +1491,6 @@ bool AXP_AbortInstructions(AXP_21264_CPU *cpu, AXP_INSTRUCTION *inst)
     }
 
     /*
-     * The robMutex is already locked when we get here.  So, don't try and lock
-     * it again.
-     *
      * The rob indexes wrap around from the end to the beginning.  The end
      * always points to the next available entry.  So we need to look at the
      * entry previous to the one pointed to by the end index, but this,
@@ -1261,49 +1506,52 @@ bool AXP_AbortInstructions(AXP_21264_CPU *cpu, AXP_INSTRUCTION *inst)
     while ((endIdx != cpu->robStart) &&
            (AXP_GET_PC(rob->pc) != AXP_GET_PC(inst->pc)))
     {
-        rollbackRegisterMap = false;
-
-        switch (rob->state)
+        /*
+         * The Ebox or Fbox may move the entry from Queued to Executing or
+         * from Executing to WaitingRetirement while we are looking at it.  If
+         * the exchange below fails, it returns the state it found and we
+         * decide again.
+         */
+        state = AXP_ROB_GET_STATE(rob);
+        do
         {
+            switch (state)
+            {
 
-            /*
-             * If the entry is queued or executing, the Ebox or Fbox have it.
-             * Setting the state to Aborted, indicates to them that the\
-             * execution of this instruction needs to be aborted.  We need to
-             * rollback the register mapping.
-             */
-            case Queued:
-            case Executing:
-            rob->state = Aborted;
-            rollbackRegisterMap = true;
-            break;
+                /*
+                 * If the entry is queued or executing, the Ebox or Fbox have
+                 * it.  Setting the state to Aborted, indicates to them that
+                 * the execution of this instruction needs to be aborted.  We
+                 * need to rollback the register mapping.
+                 */
+                case Queued:
+                case Executing:
+                    newState = Aborted;
+                    rollbackRegisterMap = true;
+                    break;
 
-            /*
-             * If it is waiting for retirement is retired.  We need to rollback
-             * the register mapping.
-             */
-            case WaitingRetirement:
-            rob->state = Retired;
-            rollbackRegisterMap = true;
-            break;
+                /*
+                 * If it is waiting for retirement is retired.  We need to
+                 * rollback the register mapping.
+                 */
+                case WaitingRetirement:
+                    newState = Retired;
+                    rollbackRegisterMap = true;
+                    break;
 
-            /*
-             * For Retired or Aborted, there is noting else to do.  We don't
-             * even have to rollback the register mapping.
-             */
-            case Retired:
-            case Aborted:
-            rollbackRegisterMap = false;
-            break;
-        }
+                /*
+                 * For Retired or Aborted, there is noting else to do.  We
+                 * don't even have to rollback the register mapping.
+                 */
+                case Retired:
+                case Aborted:
+                default:
+                    rollbackRegisterMap = false;
+                    break;
+            }
+        } while ((rollbackRegisterMap == true) &&
+                 (AXP_ROB_CHANGE_STATE(rob, &state, newState) == false));
 
-        /*
-         * This is kind of what we really came here for.  If we need to
-         * rollback the mapping, then we need to make the physical registers
-         * look like they did prior to this instruction getting decoded, with
-         * the same value.  Additionally, we need to find the previous mapping
-         * and adjust the free list and mapping.
-         */
         if (rollbackRegisterMap == true)
         {
             if (AXP_IBOX_OPT2)
@@ -1324,6 +1572,19 @@ bool AXP_AbortInstructions(AXP_21264_CPU *cpu, AXP_INSTRUCTION *inst)
             {
                 retVal = rob->stall;
             }
+        }
+
+        /*
+         * This is kind of what we really came here for.  If we need to
+         * rollback the mapping, then we need to make the physical registers
+         * look like they did prior to this instruction getting decoded, with
+         * the same value.  Additionally, we need to find the previous mapping
+         * and adjust the free list and mapping.  When the maps are going to be
+         * put back from the register map history, this is all done once,
+         * below, instead.
+         */
+        if ((rollbackRegisterMap == true) && (mapCkpt->valid == false))
+        {
 
             /*
              * The code for floating point and integer register mapping is
@@ -1433,6 +1694,43 @@ bool AXP_AbortInstructions(AXP_21264_CPU *cpu, AXP_INSTRUCTION *inst)
         rob = &cpu->rob[endIdx];
     }
 
+    /*
+     * If the instruction we aborted back to has an entry in the register map
+     * history, put the maps back to what they were right after it was renamed
+     * and then make the physical registers and free lists agree with them.
+     */
+    if (mapCkpt->valid == true)
+    {
+        if (AXP_IBOX_OPT2)
+        {
+            AXP_TRACE_BEGIN();
+            AXP_TraceWrite("AXP_AbortInstructions restoring the register maps "
+                           "for pc 0x%016llx",
+                           AXP_GET_PC(inst->pc));
+            AXP_TRACE_END();
+        }
+        memcpy(cpu->prMap, mapCkpt->prMap, sizeof(cpu->prMap));
+        memcpy(cpu->pfMap, mapCkpt->pfMap, sizeof(cpu->pfMap));
+        AXP_RebuildRegisters(inst,
+                             false,
+                             cpu->pr,
+                             AXP_INT_PHYS_REG,
+                             cpu->prMap,
+                             AXP_MAX_INT_REGISTERS,
+                             cpu->prFreeList,
+                             &cpu->prFlStart,
+                             &cpu->prFlEnd);
+        AXP_RebuildRegisters(inst,
+                             true,
+                             cpu->pf,
+                             AXP_FP_PHYS_REG,
+                             cpu->pfMap,
+                             AXP_MAX_FP_REGISTERS,
+                             cpu->pfFreeList,
+                             &cpu->pfFlStart,
+                             &cpu->pfFlEnd);
+    }
+
 #ifdef AXP_VERIFY_REGISTERS
 
     /*
@@ -1512,13 +1810,13 @@ void AXP_RegisterRename_IntegrityCheck(AXP_21264_CPU *cpu)
         physInUse[cpu->pfMap[ii]]++;
     }
     wrap = cpu->pfFlStart > cpu->pfFlEnd;
-    end = wrap ? AXP_I_FREELIST_SIZE : cpu->pfFlEnd;
+    end = wrap ? AXP_F_FREELIST_SIZE : cpu->pfFlEnd;
     ii = cpu->pfFlStart;
     while (ii < end)
     {
         physInUse[cpu->pfFreeList[ii]]++;
         ii++;
-        if ((ii == AXP_I_FREELIST_SIZE) && (wrap == true))
+        if ((ii == AXP_F_FREELIST_SIZE) && (wrap == true))
         {
             end = cpu->pfFlEnd;
             ii = 0;
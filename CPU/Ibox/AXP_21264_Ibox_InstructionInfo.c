@@ -31,6 +31,11 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Instructions completed by the Ebox are moved to WaitingRetirement here,
+ *  with an atomic state change, instead of in the instruction functions.
+ *  This way the state is published after the exception value is stored.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Ibox/AXP_21264_Ibox_InstructionInfo.h"
@@ -473,13 +478,13 @@ void AXP_Dispatcher(AXP_21264_CPU *cpu, AXP_INSTRUCTION *instr)
         u32 tmp1;
         AXP_FP_FUNC tmp2;
     } fpFunc;
-    bool locked = false;
+    AXP_INS_STATE state;
 
     goto *(&&OP_CALL_PAL + label[instr->opcode]);
 
 OP_CALL_PAL: /* OPCODE: 0x00 */
     instr->excRegMask = AXP_CALL_PAL(cpu, instr);
-    goto COMPLETION_OP;
+    goto COMPL_RETIRE;
 
 OP_LDA: /* OPCODE: 0x08 */
     instr->excRegMask = AXP_LDA(cpu, instr);
@@ -1256,37 +1261,37 @@ OP_TRAPB: /* OPCODE: 0x18 */
     {
         case AXP_FUNC_TRAPB:
             instr->excRegMask = AXP_TRAPB(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_EXCB:
             instr->excRegMask = AXP_EXCB(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_MB:
             instr->excRegMask = AXP_MB(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_WMB:
             instr->excRegMask = AXP_WMB(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_FETCH:
             instr->excRegMask = AXP_FETCH(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_FETCH_M:
             instr->excRegMask = AXP_FETCH_M(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_RPCC:
             instr->excRegMask = AXP_RPCC(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_RC:
@@ -1296,7 +1301,7 @@ OP_TRAPB: /* OPCODE: 0x18 */
 
         case AXP_FUNC_ECB:
             instr->excRegMask = AXP_ECB(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_RS:
@@ -1306,12 +1311,12 @@ OP_TRAPB: /* OPCODE: 0x18 */
 
         case AXP_FUNC_WH64:
             instr->excRegMask = AXP_WH64(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         case AXP_FUNC_WH64EN:
             instr->excRegMask = AXP_WH64EN(cpu, instr);
-            goto COMPLETION_OP;
+            goto COMPL_RETIRE;
             break;
 
         default:
@@ -1583,15 +1588,10 @@ OP_BGT: /* OPCODE: 0x3f */
 RESERVED_OP:
 
     /*
-     * We lock the ROB mutex while looking at it and potentially setting it.
-     * We don't want some other thread changing the value of state while we are
-     * looking at it and potentially setting it ourselves.  So, if it is not
-     * in Executing state, then something else already occurred and we should
-     * not report this event.
+     * If the instruction is not in Executing state, then something else (the
+     * Ibox aborting it) already occurred and we should not report this event.
      */
-    pthread_mutex_lock(&cpu->robMutex);
-    locked = true;
-    if (instr->state == Executing)
+    if (AXP_ROB_GET_STATE(instr) == Executing)
     {
         instr->excRegMask = IllegalOperand;
         AXP_21264_Ibox_Event(cpu,
@@ -1610,28 +1610,14 @@ RESERVED_OP:
 
 COMPL_RETIRE:
 
-    /*
-     * If we didn't lock the ROB mutex above, then do so now.
-     */
-    if (locked == false)
-    {
-        pthread_mutex_lock(&cpu->robMutex);
-    }
-
     /*
      * If this instruction is in Executing state, then we can change it to
-     * Waiting Retirement.
-     */
-    if (instr->state == Executing)
-    {
-        instr->state = WaitingRetirement;
-    }
-
-    /*
-     * OK, the ROB mutex can be unlocked.
+     * Waiting Retirement.  This publishes the results and exception written
+     * above to the Ibox.  If the Ibox aborted the instruction in the meantime,
+     * the exchange fails and the results are dropped.
      */
-    pthread_mutex_unlock(&cpu->robMutex);
-    locked = false;
+    state = Executing;
+    AXP_ROB_CHANGE_STATE(instr, &state, WaitingRetirement);
 
     /*
      * It is the intent to fall through.
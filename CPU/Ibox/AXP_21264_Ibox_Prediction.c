@@ -31,11 +31,19 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added the counting of how well each of the predictors does, and the
+ *  branch trace file, which can be replayed through this code offline.
  */
 #include "CommonUtilities/AXP_Configure.h"
+#include "CommonUtilities/AXP_Blocks.h"
 #include "CPU/Ibox/AXP_21264_Ibox_Prediction.h"
+#include "CPU/Ibox/AXP_21264_Ibox.h"
 #include "CommonUtilities/AXP_Trace.h"
 
+#define AXP_BRANCH_TRACE_NAME_LEN   256
+
 /*
  * AXP_Branch_Prediction
  *
@@ -305,3 +313,251 @@ void AXP_Branch_Direction(AXP_21264_CPU *cpu,
     }
     return;
 }
+
+/*
+ * AXP_Branch_Count
+ *  This function is called when a branch is retired to count how well the
+ *  prediction made for it, and each of the predictors behind it, did.
+ *
+ * Input Parameters:
+ *  stats:
+ *      A pointer to the branch prediction statistics to be updated.
+ *  taken:
+ *      A value indicating if the branch was taken or not.
+ *  predicted:
+ *      A value of what the branch prediction logic predicted.
+ *  localTaken:
+ *      A value of what was predicted by the local predictor.
+ *  globalTaken:
+ *      A value of what was predicted by the global predictor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_Branch_Count(AXP_BRANCH_STATS *stats,
+                      bool taken,
+                      bool predicted,
+                      bool localTaken,
+                      bool globalTaken)
+{
+    stats->branches++;
+    if (taken == true)
+    {
+        stats->taken++;
+    }
+    if (predicted == taken)
+    {
+        stats->correct++;
+    }
+    if (localTaken == taken)
+    {
+        stats->localCorrect++;
+    }
+    if (globalTaken == taken)
+    {
+        stats->globalCorrect++;
+    }
+
+    /*
+     * The chooser only has a say when the local and global predictors
+     * disagree.
+     */
+    if (localTaken != globalTaken)
+    {
+        stats->disagree++;
+        if (predicted == taken)
+        {
+            stats->chooserCorrect++;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Branch_TraceOpen
+ *  This function is called when the Ibox is initialized.  If the
+ *  AXP_BRANCHFILE environment variable is set, then the branch trace file for
+ *  this CPU is created and its header written.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the structure containing the information needed to emulate
+ *      a single CPU.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_Branch_TraceOpen(AXP_21264_CPU *cpu)
+{
+    AXP_BRANCH_TRACE_HDR hdr;
+    char fileName[AXP_BRANCH_TRACE_NAME_LEN];
+    char *envStr;
+
+    cpu->bpTraceFp = NULL;
+    cpu->bpTraceBuf = NULL;
+    cpu->bpTraceCount = 0;
+    envStr = getenv(AXP_BRANCH_TRACE_ENV);
+    if (envStr != NULL)
+    {
+        snprintf(fileName,
+                 sizeof(fileName),
+                 "%s.%llu",
+                 envStr,
+                 (unsigned long long) cpu->whami);
+        cpu->bpTraceBuf = AXP_Allocate_Block(
+            -(i32) (AXP_BRANCH_TRACE_BUF_LEN * sizeof(AXP_BRANCH_TRACE_REC)),
+            NULL);
+        if (cpu->bpTraceBuf != NULL)
+        {
+            cpu->bpTraceFp = fopen(fileName, "wb");
+        }
+        if (cpu->bpTraceFp != NULL)
+        {
+            hdr.magic = AXP_BRANCH_TRACE_MAGIC;
+            hdr.version = AXP_BRANCH_TRACE_VERSION;
+            hdr.recordSize = sizeof(AXP_BRANCH_TRACE_REC);
+            hdr.cpuID = cpu->whami;
+            if (fwrite(&hdr, sizeof(hdr), 1, cpu->bpTraceFp) != 1)
+            {
+                fclose(cpu->bpTraceFp);
+                cpu->bpTraceFp = NULL;
+            }
+        }
+        if (cpu->bpTraceFp == NULL)
+        {
+            if (AXP_IBOX_OPT1)
+            {
+                AXP_TRACE_BEGIN();
+                AXP_TraceWrite("Unable to create branch trace file %s",
+                               fileName);
+                AXP_TRACE_END();
+            }
+            if (cpu->bpTraceBuf != NULL)
+            {
+                AXP_Deallocate_Block(cpu->bpTraceBuf);
+                cpu->bpTraceBuf = NULL;
+            }
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Branch_Trace
+ *  This function is called when a branch is retired, and the branch trace
+ *  file is open, to record the branch.  Records are buffered and written out
+ *  when the buffer fills.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the structure containing the information needed to emulate
+ *      a single CPU.
+ *  vpc:
+ *      A value of the Virtual Program Counter of the branch.
+ *  taken:
+ *      A value indicating if the branch was taken or not.
+ *  target:
+ *      A value of the Virtual Program Counter branched to, when taken.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_Branch_Trace(AXP_21264_CPU *cpu,
+                      AXP_PC vpc,
+                      bool taken,
+                      AXP_PC target)
+{
+    AXP_BRANCH_TRACE_REC *rec = &cpu->bpTraceBuf[cpu->bpTraceCount];
+
+    rec->pc = AXP_GET_PC(vpc);
+    if (taken == true)
+    {
+        rec->pc |= AXP_BRANCH_TRACE_TAKEN;
+        rec->target = AXP_GET_PC(target);
+    }
+    else
+    {
+        rec->target = 0;
+    }
+    if (++cpu->bpTraceCount == AXP_BRANCH_TRACE_BUF_LEN)
+    {
+        if (fwrite(cpu->bpTraceBuf,
+                   sizeof(AXP_BRANCH_TRACE_REC),
+                   cpu->bpTraceCount,
+                   cpu->bpTraceFp) != cpu->bpTraceCount)
+        {
+            if (AXP_IBOX_OPT1)
+            {
+                AXP_TRACE_BEGIN();
+                AXP_TraceWrite("Error writing the branch trace file, branch "
+                               "tracing stopped");
+                AXP_TRACE_END();
+            }
+            cpu->bpTraceCount = 0;
+            AXP_Branch_TraceClose(cpu);
+        }
+        cpu->bpTraceCount = 0;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Branch_TraceClose
+ *  This function is called when the Ibox stops, to write out any branches
+ *  still buffered and close the branch trace file.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the structure containing the information needed to emulate
+ *      a single CPU.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_Branch_TraceClose(AXP_21264_CPU *cpu)
+{
+    if (cpu->bpTraceFp != NULL)
+    {
+        if (cpu->bpTraceCount > 0)
+        {
+            fwrite(cpu->bpTraceBuf,
+                   sizeof(AXP_BRANCH_TRACE_REC),
+                   cpu->bpTraceCount,
+                   cpu->bpTraceFp);
+        }
+        fclose(cpu->bpTraceFp);
+        cpu->bpTraceFp = NULL;
+        AXP_Deallocate_Block(cpu->bpTraceBuf);
+        cpu->bpTraceBuf = NULL;
+        cpu->bpTraceCount = 0;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
@@ -37,6 +37,20 @@
  *  header block will contain a place for the block to be queued up, so that we
  *  can detect when a block is deallocated more than once, or not deallocated
  *  at all.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Virtual disk handles may now have the disk image mapped into memory.
+ *  Remove the mapping when the handle is deallocated.  Also, a RAW handle
+ *  now starts with an invalid file descriptor and is recognized by
+ *  AXP_ReturnType_Block.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  The SSD is now a mapping of its backing store file, with a mutex and
+ *  condition variable used to track dirty pages and control the flush thread.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  A VHD handle now frees its BAT and resolved block cache, and a
+ *  differencing VHD closes the parent it opened.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CommonUtilities/AXP_Blocks.h"
@@ -46,6 +60,7 @@
 #include "Devices/Console/AXP_Telnet.h"
 #include "Devices/VirtualDisks/AXP_VHDX.h"
 #include "Devices/Ethernet/AXP_Ethernet.h"
+#include <sys/mman.h>
 
 static const char *_blockNames[] =
 {
@@ -257,6 +272,8 @@ void *AXP_Allocate_Block(i32 blockType, ...)
                     ssd->head.tail = &ssd->tail;
                     ssd->tail.magicNumber = AXP_TL_MAGIC;
                     AXP_INSQUE(_blkQ.blink, &ssd->head.head);
+                    pthread_mutex_init(&ssd->ssd.dirtyMutex, NULL);
+                    pthread_cond_init(&ssd->ssd.flushCond, NULL);
 
                     /*
                      * Set the return value to the correct item.
@@ -396,6 +413,7 @@ void *AXP_Allocate_Block(i32 blockType, ...)
                     /*
                      * Set the return value to the correct item.
                      */
+                    raw->raw.fd = -1;
                     retBlock = (void *) &raw->raw;
                 }
             }
@@ -526,15 +544,33 @@ void AXP_Deallocate_Block(void *block)
                 {
                     AXP_SSD_Handle *ssd = (AXP_SSD_Handle *) block;
 
+                    if (ssd->flushStarted == true)
+                    {
+                        pthread_mutex_lock(&ssd->dirtyMutex);
+                        ssd->flushStop = true;
+                        pthread_cond_signal(&ssd->flushCond);
+                        pthread_mutex_unlock(&ssd->dirtyMutex);
+                        pthread_join(ssd->flushThread, NULL);
+                    }
+                    if (ssd->mapAddr != NULL)
+                    {
+                        munmap(ssd->mapAddr, ssd->mapLength);
+                    }
                     if (ssd->fp != NULL)
                     {
                         fflush(ssd->fp);
                         fclose(ssd->fp);
                     }
-                    if (ssd->memory != NULL)
+                    if (ssd->dirtyMap != NULL)
                     {
-                        AXP_Deallocate_Block(ssd->memory);
+                        AXP_Deallocate_Block(ssd->dirtyMap);
                     }
+                    if (ssd->filePath != NULL)
+                    {
+                        AXP_Deallocate_Block(ssd->filePath);
+                    }
+                    pthread_mutex_destroy(&ssd->dirtyMutex);
+                    pthread_cond_destroy(&ssd->flushCond);
                     free(head);
                 }
                 break;
@@ -543,6 +579,10 @@ void AXP_Deallocate_Block(void *block)
                 {
                     AXP_VHDX_Handle *vhdx = (AXP_VHDX_Handle *) block;
 
+                    if (vhdx->mapAddr != NULL)
+                    {
+                        munmap(vhdx->mapAddr, vhdx->mapLength);
+                    }
                     if (vhdx->fp != NULL)
                     {
                         fflush(vhdx->fp);
@@ -552,6 +592,18 @@ void AXP_Deallocate_Block(void *block)
                     {
                         AXP_Deallocate_Block(vhdx->filePath);
                     }
+                    if (vhdx->bat != NULL)
+                    {
+                        AXP_Deallocate_Block(vhdx->bat);
+                    }
+                    if (vhdx->resolved != NULL)
+                    {
+                        AXP_Deallocate_Block(vhdx->resolved);
+                    }
+                    if ((vhdx->parent != NULL) && (vhdx->parentOwned == true))
+                    {
+                        AXP_Deallocate_Block(vhdx->parent);
+                    }
                     free(head);
                 }
                 break;
@@ -560,6 +612,10 @@ void AXP_Deallocate_Block(void *block)
                 {
                     AXP_RAW_Handle *raw = (AXP_RAW_Handle *) block;
 
+                    if (raw->mapAddr != NULL)
+                    {
+                        munmap(raw->mapAddr, raw->mapLength);
+                    }
                     if (raw->fd >= 0)
                     {
                         if (raw->readOnly == false)
@@ -629,6 +685,8 @@ AXP_BLOCK_TYPE AXP_ReturnType_Block(void *block)
               (head->size == _ssd_blk_size)) ||
              ((head->type == AXP_VHDX_BLK) &&
               (head->size == _vhdx_blk_size)) ||
+             ((head->type == AXP_RAW_BLK) &&
+              (head->size == _raw_blk_size)) ||
              ((head->type == AXP_VOID_BLK) &&
               (head->size >= _head_tail_size))) &&
             (head->magicNumber == AXP_HD_MAGIC) &&
@@ -27,6 +27,20 @@
  *  V01.001 02-Mar-2018 Jonathan D. Belanger
  *  Added functions to return values from the configuration structure.  Also
  *  made the configuration structure static.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added the DiskCache node and a function to return it.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Added the VirtualTime value to the CPUs node and a function to return it.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Added the IcachePrefetch value to the CPUs node and a function to return
+ *  it.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  Added functions to return the number of networks and the information for
+ *  each of them.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -61,6 +75,8 @@
  *            Count            number
  *            Generation            string
  *            Pass            number
+ *            VirtualTime            number
+ *            IcachePrefetch            number
  *        DARRAY
  *            Count            number
  *            Size            decimal(MB, GB)
@@ -70,6 +86,10 @@
  *            Name            string
  *            Size            decimal(MB, GB)
  *            File            file-specification
+ *        DiskCache
+ *            Size            decimal(MB, GB)
+ *            DirtyLimit            decimal(MB, GB)
+ *            ReadAhead            number
  *        Console
  *            Port            number
  *        Network
@@ -105,8 +125,13 @@ static AXP_21264_CONFIG _axp_21264_config_ =
         .system.cpus.config = NULL,
         .system.cpus.count = 0,
         .system.cpus.minorType = 0,
+        .system.cpus.virtualTime = 0,
+        .system.cpus.iCachePrefetch = 2,
         .system.darrays.size = 0,
-        .system.darrays.count = 0};
+        .system.darrays.count = 0,
+        .system.diskCache.size = 0,
+        .system.diskCache.dirtyMax = 0,
+        .system.diskCache.readAhead = 0};
 
 /*
  * This mutex is used to make sure multiple threads are not accessing the same
@@ -158,6 +183,11 @@ struct AXP_DARRAYS
     char *token;
     AXP_21264_CONFIG_DARRAYS node;
 };
+struct AXP_DiskCache
+{
+    char *token;
+    AXP_21264_CONFIG_DISKCACHE node;
+};
 struct AXP_Disks
 {
     char *token;
@@ -223,6 +253,7 @@ static struct AXP_System _system_level_nodes[] =
     {"CPUs", CPUS},
     {"DARRAYs", DARRAYS},
     {"Disks", Disks},
+    {"DiskCache", DiskCache},
     {"Console", Console},
     {"Networks", Networks},
     {"Printers", Printers},
@@ -249,6 +280,8 @@ static struct AXP_CPUS _cpu_level_nodes[] =
     {"Count", CPUCount},
     {"Generation", Generation},
     {"Pass", MfgPass},
+    {"VirtualTime", VirtualTime},
+    {"IcachePrefetch", IcachePrefetch},
     {NULL, NoCPUs}
 };
 static struct AXP_DARRAYS _darray_level_nodes[] =
@@ -257,6 +290,13 @@ static struct AXP_DARRAYS _darray_level_nodes[] =
     {"Size", DARRAYSize},
     {NULL, NoDARRAYs}
 };
+static struct AXP_DiskCache _diskcache_level_nodes[] =
+{
+    {"Size", DiskCacheSize},
+    {"DirtyLimit", DiskCacheDirty},
+    {"ReadAhead", DiskCacheReadAhead},
+    {NULL, NoDiskCache}
+};
 static struct AXP_Disks _disks_level_nodes[] =
 {
     {"Disk", DECDisk},
@@ -2088,6 +2128,142 @@ static void parse_disks_names(xmlDocPtr doc,
     return;
 }
 
+/*
+ * parse_diskcache_names
+ *  This function parses the elements within the DiskCache Node in the XML
+ *  formatted configuration file.  It extracts the value for each of the
+ *  components and stores them in the configuration.  The format for the
+ *  subnodes in the DiskCache node are as follows:
+ *    <DiskCache>
+ *        <Size>256.0MB</Size>
+ *        <DirtyLimit>64.0MB</DirtyLimit>
+ *        <ReadAhead>32</ReadAhead>
+ *    </DiskCache>
+ *
+ * Input Parameters:
+ *  doc:
+ *      A pointer to the XML document node being parsed.
+ *  a_node:
+ *      A pointer to the current node (element) being parsed.
+ *  parent:
+ *      A value indicating the parent node being parsed.
+ *
+ * Output Parameters:
+ *  value:
+ *      A pointer to a location to receive the value when the node parsed is a
+ *      text node.  This parameter may be NULL, when we want to ignore the
+ *      results.
+ *
+ * Return Values:
+ *  None.
+ */
+static void parse_diskcache_names(xmlDocPtr doc,
+                                  xmlNode *a_node,
+                                  AXP_21264_CONFIG_DISKCACHE parent,
+                                  char *value)
+{
+    xmlNode *cur_node = NULL;
+    char *ptr;
+    char nodeValue[80];
+    int ii;
+    bool found;
+
+    /*
+     * If we are called with an address to value of NULL, then we are
+     * called for the first time by the parent parser.  When this happened,
+     * make sure that the local string is zero length.
+     */
+    if (value == NULL)
+    {
+        nodeValue[0] = '\0';
+    }
+
+    /*
+     * We recursively look through the node from the current one and look for
+     * either an Element Node or a Text Node.  If an Element node, there is
+     * something more to parse (handled below).  If it is a text node, then we
+     * are returning a value associated with an Element node.
+     */
+    for (cur_node = a_node; cur_node; cur_node = cur_node->next)
+    {
+
+        /*
+         * We have an element node.  See that is one that we care about and
+         * we'll parse it further.  Extra nodes will be ignored and duplicates
+         * will overwrite the previous value.
+         */
+        if (cur_node->type == XML_ELEMENT_NODE)
+        {
+            found = false;
+            for (ii = 0;
+                 ((_diskcache_level_nodes[ii].token != NULL) &&
+                  (found == false));
+                 ii++)
+            {
+                if (strcmp((char *) cur_node->name,
+                           _diskcache_level_nodes[ii].token) == 0)
+                {
+                    parent = _diskcache_level_nodes[ii].node;
+                    found = true;
+                }
+            }
+        }
+
+        /*
+         * We have a text node.  This is a value that is to be associated with
+         * an Element node.
+         */
+        else if (XML_TEXT_NODE == cur_node->type)
+        {
+            xmlChar *key;
+
+            key = xmlNodeListGetString(doc, cur_node, 1);
+            AXP_stripXmlString(key);
+            if (xmlStrlen(key) > 0)
+            {
+                strcpy(value, (char *) key);
+            }
+            xmlFree(key);
+        }
+
+        /*
+         * Parse out the relevant configuration information from the read in
+         * configuration file.
+         */
+        if (parent != NoDiskCache)
+        {
+            parse_diskcache_names(doc, cur_node->children, parent, nodeValue);
+            switch (parent)
+            {
+                case DiskCacheSize:
+                    _axp_21264_config_.system.diskCache.size =
+                        AXP_cvtSizeStr(nodeValue);
+                    break;
+
+                case DiskCacheDirty:
+                    _axp_21264_config_.system.diskCache.dirtyMax =
+                        AXP_cvtSizeStr(nodeValue);
+                    break;
+
+                case DiskCacheReadAhead:
+                    _axp_21264_config_.system.diskCache.readAhead =
+                        strtoul(nodeValue, &ptr, 10);
+                    break;
+
+                case NoDiskCache:
+                default:
+                    break;
+            }
+            parent = NoDiskCache;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
 /*
  * parse_darrays_names
  *  This function parses the elements within the DARRAYs Node in the XML
@@ -2228,6 +2404,8 @@ static void parse_darrays_names(xmlDocPtr doc,
  *        <Count>1</Count>
  *        <Generation>EV68CB</Generation>
  *        <Pass>5</Pass>
+ *        <VirtualTime>0</VirtualTime>
+ *        <IcachePrefetch>2</IcachePrefetch>
  *    </CPUs>
  *
  * Input Parameters:
@@ -2351,6 +2529,22 @@ static void parse_cpus_names(xmlDocPtr doc,
                                                                        10);
                     break;
 
+                case VirtualTime:
+                    _axp_21264_config_.system.cpus.virtualTime =
+                        strtoul(nodeValue, &ptr, 10);
+                    break;
+
+                case IcachePrefetch:
+                    _axp_21264_config_.system.cpus.iCachePrefetch =
+                        strtoul(nodeValue, &ptr, 10);
+                    if (_axp_21264_config_.system.cpus.iCachePrefetch >
+                        AXP_ICACHE_PREFETCH_MAX)
+                    {
+                        _axp_21264_config_.system.cpus.iCachePrefetch =
+                            AXP_ICACHE_PREFETCH_MAX;
+                    }
+                    break;
+
                 case NoCPUs:
                 default:
                     break;
@@ -2665,6 +2859,7 @@ static void parse_model_names(xmlDocPtr doc,
  *        <CPUs>...</CPUs>
  *        <DARRAYs>...</DARRAYs>
  *        <Disks>...</Disks>
+ *        <DiskCache>...</DiskCache>
  *        <Console>...</Console>
  *        <Networks>...</Networks>
  *        <Printers>...</Printers>
@@ -2754,6 +2949,14 @@ static void parse_system_names(xmlDocPtr doc,
                 parent = NoSystem;
                 break;
 
+            case DiskCache:
+                parse_diskcache_names(doc,
+                                      cur_node->children,
+                                      NoDiskCache,
+                                      NULL);
+                parent = NoSystem;
+                break;
+
             case Console:
                 parse_console_names(doc, cur_node->children, NoConsole, NULL);
                 parent = NoSystem;
@@ -3401,6 +3604,72 @@ u32 AXP_ConfigGet_CPUCount(void)
     return (retVal);
 }
 
+/*
+ * AXP_ConfigGet_VirtualTime
+ *  This function is called to return the nanoseconds of guest time each
+ *  instruction retired takes, when the emulation runs in virtual time.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  0:      The emulation runs on the host's clock.
+ *  ~0:     The nanoseconds of guest time for each instruction retired.
+ */
+u32 AXP_ConfigGet_VirtualTime(void)
+{
+    u32 retVal = 0;
+
+    /*
+     * Lock the interface mutex, get the virtual time value, then unlock the
+     * mutex.
+     */
+    pthread_mutex_lock(&_axp_config_mutex_);
+    retVal = _axp_21264_config_.system.cpus.virtualTime;
+    pthread_mutex_unlock(&_axp_config_mutex_);
+
+    /*
+     * Return back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_ConfigGet_IcachePrefetch
+ *  This function is called to return the number of Icache lines the Ibox
+ *  requests ahead of the line it is currently fetching from.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  0:      The Icache is only filled on demand.
+ *  ~0:     The number of sequential lines to prefetch.
+ */
+u32 AXP_ConfigGet_IcachePrefetch(void)
+{
+    u32 retVal = 0;
+
+    /*
+     * Lock the interface mutex, get the prefetch depth, then unlock the
+     * mutex.
+     */
+    pthread_mutex_lock(&_axp_config_mutex_);
+    retVal = _axp_21264_config_.system.cpus.iCachePrefetch;
+    pthread_mutex_unlock(&_axp_config_mutex_);
+
+    /*
+     * Return back to the caller.
+     */
+    return (retVal);
+}
+
 /*
  * AXP_ConfigGet_InitFile
  *  This function is called to return the value of the Initialization filename.
@@ -3685,6 +3954,126 @@ void AXP_ConfigGet_DarrayInfo(u32 *memArrayCnt, u64 *memArraySize)
     return;
 }
 
+/*
+ * AXP_ConfigGet_DiskCacheInfo
+ *  This function is called to return the size, dirty limit and read-ahead
+ *  for the host block cache used by the virtual disks.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  size:
+ *    A pointer to a 64-bit unsigned integer to receive the size, in bytes,
+ *    of the block cache.  A value of zero indicates no caching.
+ *  dirtyMax:
+ *    A pointer to a 64-bit unsigned integer to receive the maximum number of
+ *    bytes in the block cache that can be waiting to be written.
+ *  readAhead:
+ *    A pointer to a 32-bit unsigned integer to receive the number of blocks
+ *    to be read ahead for sequential reads.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_ConfigGet_DiskCacheInfo(u64 *size, u64 *dirtyMax, u32 *readAhead)
+{
+
+    /*
+     * Lock the interface mutex, copy the values into the return variables,
+     * then unlock the mutex.
+     */
+    pthread_mutex_lock(&_axp_config_mutex_);
+    *size = _axp_21264_config_.system.diskCache.size;
+    *dirtyMax = _axp_21264_config_.system.diskCache.dirtyMax;
+    *readAhead = _axp_21264_config_.system.diskCache.readAhead;
+    pthread_mutex_unlock(&_axp_config_mutex_);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_ConfigGet_NetworkCount
+ *  This function is called to return the number of networks defined in the
+ *  configuration file.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The number of networks defined in the configuration file.
+ */
+u32 AXP_ConfigGet_NetworkCount(void)
+{
+    u32 retVal = 0;
+
+    /*
+     * Lock the interface mutex, get the number of networks, then unlock the
+     * mutex.
+     */
+    pthread_mutex_lock(&_axp_config_mutex_);
+    retVal = _axp_21264_config_.system.networkCount;
+    pthread_mutex_unlock(&_axp_config_mutex_);
+
+    /*
+     * Return back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_ConfigGet_NetworkInfo
+ *  This function is called to return the name and unit number of one of the
+ *  networks defined in the configuration file.
+ *
+ * Input Parameters:
+ *  idx:
+ *    A value indicating the network to be returned, from 0 up to, but not
+ *    including, the value returned by AXP_ConfigGet_NetworkCount.
+ *
+ * Output Parameters:
+ *  name:
+ *    A pointer to a string to receive the name of the network.
+ *  unit:
+ *    A pointer to a 32-bit unsigned integer to receive the unit number of the
+ *    network.
+ *
+ * Return Values:
+ *  false:  Nothing was returned, because there is no such network or it has
+ *      no name.
+ *  true:   The network information was returned.
+ */
+bool AXP_ConfigGet_NetworkInfo(u32 idx, char *name, u32 *unit)
+{
+    bool retVal = false;
+
+    /*
+     * Lock the interface mutex, copy the values into the return variables,
+     * then unlock the mutex.
+     */
+    pthread_mutex_lock(&_axp_config_mutex_);
+    if ((name != NULL) &&
+        (idx < _axp_21264_config_.system.networkCount) &&
+        (_axp_21264_config_.system.networks[idx].name != NULL))
+    {
+        strcpy(name, _axp_21264_config_.system.networks[idx].name);
+        *unit = _axp_21264_config_.system.networks[idx].unit;
+        retVal = true;
+    }
+    pthread_mutex_unlock(&_axp_config_mutex_);
+
+    /*
+     * Return the outcome back to the caller.
+     */
+    return (retVal);
+}
+
 /*
  * AXP_TraceConfig
  *  This function is called to write out the configuration information to the
@@ -3786,6 +4175,10 @@ void AXP_TraceConfig(void)
                            _axp_21264_config_.system.cpus.config->majorType);
             AXP_TraceWrite("\t\t\tMinor Type:\t\t%d",
                            _axp_21264_config_.system.cpus.minorType);
+            AXP_TraceWrite("\t\t\tVirtual Time:\t\t%u",
+                           _axp_21264_config_.system.cpus.virtualTime);
+            AXP_TraceWrite("\t\t\tIcache Prefetch:\t%u",
+                           _axp_21264_config_.system.cpus.iCachePrefetch);
             cacheSize = _axp_21264_config_.system.cpus.config->iCacheSize;
             while (cacheSize > ONE_K)
             {
@@ -3845,6 +4238,27 @@ void AXP_TraceConfig(void)
                 idx++;
             }
             AXP_TraceWrite("\t\t\tSize:\t\t\t%llu%s", cacheSize, bytes[idx]);
+            AXP_TraceWrite("\t\tDisk Cache:");
+            cacheSize = _axp_21264_config_.system.diskCache.size;
+            idx = 0;
+            while (cacheSize > ONE_K)
+            {
+                cacheSize /= ONE_K;
+                idx++;
+            }
+            AXP_TraceWrite("\t\t\tSize:\t\t\t%llu%s", cacheSize, bytes[idx]);
+            cacheSize = _axp_21264_config_.system.diskCache.dirtyMax;
+            idx = 0;
+            while (cacheSize > ONE_K)
+            {
+                cacheSize /= ONE_K;
+                idx++;
+            }
+            AXP_TraceWrite("\t\t\tDirty Limit:\t\t%llu%s",
+                           cacheSize,
+                           bytes[idx]);
+            AXP_TraceWrite("\t\t\tRead-Ahead:\t\t%u",
+                           _axp_21264_config_.system.diskCache.readAhead);
             AXP_TraceWrite("\t\tNetworks:");
             AXP_TraceWrite("\t\t\tNumber:\t\t\t%u",
                            _axp_21264_config_.system.networkCount);
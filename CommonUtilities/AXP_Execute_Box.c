@@ -37,6 +37,10 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  The ROB mutex is gone.  An instruction is claimed for execution by
+ *  atomically changing its state from Queued to Executing.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CPU/Fbox/AXP_21264_Fbox.h"
@@ -455,17 +459,17 @@ void AXP_Execution_Box(AXP_21264_CPU *cpu,
                  * already started processing this entry, or the instruction is
                  * being aborted, then we should process/abort it now.
                  *
-                 * NOTE:    Because of the way we have to lock/unlock/lock the
-                 *          eBoxMutex/fBoxMutex and the robMutex, it is
-                 *          possible for an instruction that can be executed in
-                 *          more than one pipeline to have already been picked
-                 *          up for processing/aborting.
+                 * NOTE:    Because the Ibox can abort an instruction at any
+                 *          time, without holding the eBoxMutex/fBoxMutex, it
+                 *          is possible for an instruction that can be executed
+                 *          in more than one pipeline to have already been
+                 *          picked up for processing/aborting.
                  */
                 if (((((entry->pipeline == pipeCond[pipeline][0]) ||
                        (entry->pipeline == pipeCond[pipeline][1]) ||
                        (entry->pipeline == pipeCond[pipeline][2])) &&
                       (AXP_RegistersReady(cpu, entry) == true)) ||
-                     (entry->ins->state == Aborted)) &&
+                     (AXP_ROB_GET_STATE(entry->ins) == Aborted)) &&
                     (entry->processing == false))
                 {
                     entry->processing = true;
@@ -515,16 +519,12 @@ void AXP_Execution_Box(AXP_21264_CPU *cpu,
             }
 
             /*
-             * First we need to lock the ROB mutex.  We don't want some
-             * other thread changing the contents while we are looking at
-             * it.  We are looking to see if the instruction was aborted.
+             * Claim the instruction by moving it from Queued to Executing.  If
+             * the Ibox got to it first and aborted it, the exchange fails and
+             * leaves the state it found in state.
              */
-            pthread_mutex_lock(&cpu->robMutex);
-            if ((state = entry->ins->state) == Queued)
-            {
-                entry->ins->state = Executing;
-            }
-            pthread_mutex_unlock(&cpu->robMutex);
+            state = Queued;
+            AXP_ROB_CHANGE_STATE(entry->ins, &state, Executing);
             if (state == Aborted)
             {
                 AXP_RemoveCountedQueue((AXP_CQUE_ENTRY *) entry, true);
@@ -672,10 +672,9 @@ void AXP_Execution_Box(AXP_21264_CPU *cpu,
                                    pipelineStr[pipeline]);
                     AXP_TRACE_END();
                 }
-                pthread_mutex_lock(&cpu->robMutex);
                 entry->ins->excRegMask = FloatingDisabledFault;
-                entry->ins->state = WaitingRetirement;
-                pthread_mutex_unlock(&cpu->robMutex);
+                state = Executing;
+                AXP_ROB_CHANGE_STATE(entry->ins, &state, WaitingRetirement);
             }
 
             /*
@@ -25,6 +25,11 @@
  *
  *  V01.001 01-Jun-2019 Jonathan D. Belanger
  *  Reformatted to remove tabs and be consistent with other source files.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  The trace message is now only formatted when tracing is turned on, since
+ *  this function is called for every byte received over TELNET.  Also, an
+ *  action equal to the maximum is no longer used to index the state machine.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -62,8 +67,6 @@ u8 AXP_Execute_SM(AXP_StateMachine *sm,
                   AXP_SM_Args *args)
 {
     AXP_SM_Entry *entry;
-    char trcBuf[512];
-    int trcIdx = 0;
     u8 retVal = curState;
     bool act;
 
@@ -75,23 +78,13 @@ u8 AXP_Execute_SM(AXP_StateMachine *sm,
     }
 
     /*
-     * We first need to determine the address of the entry in the state machine
-     * to be processed.
-     */
-    entry = AXP_SM_ENTRY(sm, action, curState);
-
-    /*
-     * If there is an action Routine, go ahead and call it.
+     * If the action is within the state machine, determine the address of the
+     * entry to be processed, and if there is an action Routine, go ahead and
+     * call it.
      */
-    if (action <= sm->maxActions)
+    if (action < sm->maxActions)
     {
-        trcIdx += sprintf(&trcBuf[trcIdx],
-                          "\tState Machine: %s Current State = %d, Action = "
-                          "0x%02x (%d) --> ",
-                          sm->smName,
-                          curState,
-                          action,
-                          action);
+        entry = AXP_SM_ENTRY(sm, action, curState);
         if (entry->actionRtn != NULL)
         {
             (*entry->actionRtn)(args);
@@ -102,14 +95,18 @@ u8 AXP_Execute_SM(AXP_StateMachine *sm,
             act = false;
         }
         retVal = entry->nextState;
-        trcIdx += sprintf(&trcBuf[trcIdx],
-                          "Next State = %d (Action Routine %s called)",
-                          retVal,
-                          (act ? "" : "not"));
         if (AXP_UTL_OPT2)
         {
             AXP_TRACE_BEGIN();
-            AXP_TraceWrite(trcBuf);
+            AXP_TraceWrite("\tState Machine: %s Current State = %d, Action = "
+                           "0x%02x (%d) --> Next State = %d (Action Routine "
+                           "%s called)",
+                           sm->smName,
+                           curState,
+                           action,
+                           action,
+                           retVal,
+                           (act ? "" : "not"));
             AXP_TRACE_END();
         }
     }
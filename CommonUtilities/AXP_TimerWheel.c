@@ -0,0 +1,1017 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains the event timer service used by the emulated devices.
+ *  All the timers are kept in a single hierarchical timer wheel, which is
+ *  serviced by one thread.  The thread sleeps on a timerfd, armed for the next
+ *  tick that has something to do, and is woken early by re-arming the timerfd
+ *  when a timer is started that expires sooner.
+ *
+ *  Starting and stopping a timer is constant time.  A timer is put in the
+ *  slot, of the lowest level that reaches far enough, for the tick it expires
+ *  on.  As the wheel turns, the timers in a slot of a higher level are moved
+ *  down a level when the lower level comes around to them.
+ *
+ *  The timers that expire on the same tick are called in order of their
+ *  expiry time, and then of when they were started, so the order is the same
+ *  from run to run.  The callbacks are called without the wheel locked.
+ *
+ *  In virtual time, the clock is not the host's.  It is moved on by the CPUs
+ *  as they retire instructions, and the thread is woken by a one-shot timerfd
+ *  when the clock reaches the armed tick.  When all the CPUs are idle, nothing
+ *  is going to happen until the next timer expires, so the clock is moved
+ *  straight to it, rather than waiting for it in real time.
+ *
+ * Revision History:
+ *
+ *  V01.000	19-Oct-2026	Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added virtual time.
+ *
+ *  V01.002	19-Oct-2026	Jonathan D. Belanger
+ *  The virtual clock is not skipped ahead until a grace period after the last
+ *  callbacks, so a CPU parked in its idle loop has time to take the interrupt
+ *  they started.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_TimerWheel.h"
+#include <sys/timerfd.h>
+
+/*
+ * The timer wheel.  The tick is the next one to be processed, and the armed
+ * tick is the one the timerfd is armed for (0 when it is not armed).  In
+ * virtual time, the clock is in nanoseconds, and the base is where it was,
+ * and the host time in seconds, when virtual time was turned on.  The armed
+ * tick, clock, and idle count are updated atomically by the CPUs.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_t thread;
+    int fd;
+    u64 tick;
+    u64 armedTick;
+    u64 seq;
+    bool virtual;
+    u32 cpus;
+    u32 idle;
+    u32 instrTime;
+    u64 clock;
+    u64 clockBase;
+    time_t timeBase;
+    AXP_TIMER *slot[AXP_TIMER_LEVELS][AXP_TIMER_SLOTS];
+} AXP_TIMER_WHEEL;
+
+/*
+ * In virtual time, after callbacks have been called with all the CPUs idle,
+ * the clock is not skipped until this long, in real time, has passed.  The
+ * callbacks may have started an interrupt on its way to a CPU, and it needs
+ * time to be woken up before the clock moves on.
+ */
+#define AXP_TIMER_GRACE		1000000ll
+
+static AXP_TIMER_WHEEL _timerWheel =
+{
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .fd = -1
+};
+static pthread_once_t _timerOnce = PTHREAD_ONCE_INIT;
+
+/*
+ * Local Prototypes
+ */
+static u64 AXP_Timer_Real(void);
+static void AXP_Timer_Start(void);
+static void AXP_Timer_Insert(AXP_TIMER *);
+static void AXP_Timer_Remove(AXP_TIMER *);
+static void AXP_Timer_Due(AXP_TIMER **, AXP_TIMER *);
+static AXP_TIMER *AXP_Timer_Advance(u64);
+static void AXP_Timer_Arm(u64);
+static void AXP_Timer_Kick(u64);
+static u64 AXP_Timer_Next(void);
+static void *AXP_Timer_Main(void *);
+
+/*
+ * AXP_Timer_Real
+ *  This function is called to get the current time of the host's monotonic
+ *  clock, in nanoseconds.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The current time in nanoseconds.
+ */
+static u64 AXP_Timer_Real(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(((u64) now.tv_sec * AXP_TIMER_NSEC) + now.tv_nsec);
+}
+
+/*
+ * AXP_TimerNow
+ *  This function is called to get the current time of the timer wheel's
+ *  clock, in nanoseconds.  This is the host's monotonic clock, or the virtual
+ *  clock when virtual time is on.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The current time in nanoseconds.
+ */
+u64 AXP_TimerNow(void)
+{
+    u64 retVal;
+
+    if (__atomic_load_n(&_timerWheel.virtual, __ATOMIC_ACQUIRE) == true)
+    {
+        retVal = __atomic_load_n(&_timerWheel.clock, __ATOMIC_ACQUIRE);
+    }
+    else
+    {
+        retVal = AXP_Timer_Real();
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_TimerTime
+ *  This function is called, instead of time(), by the devices that keep the
+ *  time of day, so that it moves on with the virtual clock when virtual time
+ *  is on.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The current time of day, in seconds since the Epoch.
+ */
+time_t AXP_TimerTime(void)
+{
+    time_t retVal;
+
+    if (__atomic_load_n(&_timerWheel.virtual, __ATOMIC_ACQUIRE) == true)
+    {
+        retVal = _timerWheel.timeBase +
+                 (time_t) ((AXP_TimerNow() - _timerWheel.clockBase) /
+                           AXP_TIMER_NSEC);
+    }
+    else
+    {
+        retVal = time(NULL);
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Timer_Start
+ *  This function is called once, the first time a timer is initialized, to
+ *  create the timerfd and start the thread servicing the timer wheel.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Timer_Start(void)
+{
+    _timerWheel.tick = AXP_TimerNow() >> AXP_TIMER_TICK_SHIFT;
+    _timerWheel.fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (_timerWheel.fd >= 0)
+    {
+        if (pthread_create(&_timerWheel.thread,
+                           NULL,
+                           AXP_Timer_Main,
+                           NULL) == 0)
+        {
+            pthread_detach(_timerWheel.thread);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Timer_Insert
+ *  This function is called, with the wheel locked, to put a timer into the
+ *  slot for the first tick at or after its expiry time, so it is never fired
+ *  early.  A timer that has already expired goes in the slot for the next tick
+ *  to be processed.
+ *
+ * Input Parameters:
+ *  timer:
+ *      A pointer to the timer to be inserted.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Timer_Insert(AXP_TIMER *timer)
+{
+    AXP_TIMER **head;
+    u64 tick = AXP_TIMER_TICK(timer->expires);
+    u64 delta;
+    int level;
+
+    if (tick < _timerWheel.tick)
+    {
+        tick = _timerWheel.tick;
+    }
+    delta = tick - _timerWheel.tick;
+    for (level = 0; level < (AXP_TIMER_LEVELS - 1); level++)
+    {
+        if ((delta >> (AXP_TIMER_SLOT_BITS * (level + 1))) == 0)
+        {
+            break;
+        }
+    }
+    if ((delta >> (AXP_TIMER_SLOT_BITS * AXP_TIMER_LEVELS)) != 0)
+    {
+        tick = _timerWheel.tick +
+               ((1ll << (AXP_TIMER_SLOT_BITS * AXP_TIMER_LEVELS)) - 1);
+    }
+    head = &_timerWheel.slot[level]
+                            [(tick >> (AXP_TIMER_SLOT_BITS * level)) &
+                             AXP_TIMER_SLOT_MASK];
+    timer->head = head;
+    timer->blink = NULL;
+    timer->flink = *head;
+    if (*head != NULL)
+    {
+        (*head)->blink = timer;
+    }
+    *head = timer;
+    timer->armed = true;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Timer_Remove
+ *  This function is called, with the wheel locked, to take a timer out of the
+ *  slot it is in.
+ *
+ * Input Parameters:
+ *  timer:
+ *      A pointer to the timer to be removed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Timer_Remove(AXP_TIMER *timer)
+{
+    if (timer->blink != NULL)
+    {
+        timer->blink->flink = timer->flink;
+    }
+    else
+    {
+        *timer->head = timer->flink;
+    }
+    if (timer->flink != NULL)
+    {
+        timer->flink->blink = timer->blink;
+    }
+    timer->flink = timer->blink = NULL;
+    timer->head = NULL;
+    timer->armed = false;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Timer_Due
+ *  This function is called, with the wheel locked, to add an expired timer to
+ *  the list of timers to be called, in order of expiry time and then of when
+ *  they were started.
+ *
+ * Input Parameters:
+ *  list:
+ *      A pointer to the head of the list of expired timers.
+ *  timer:
+ *      A pointer to the expired timer.
+ *
+ * Output Parameters:
+ *  list:
+ *      The list with the timer added.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Timer_Due(AXP_TIMER **list, AXP_TIMER *timer)
+{
+    while ((*list != NULL) &&
+           (((*list)->expires < timer->expires) ||
+            (((*list)->expires == timer->expires) &&
+             ((*list)->seq < timer->seq))))
+    {
+        list = &(*list)->due;
+    }
+    timer->due = *list;
+    *list = timer;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Timer_Advance
+ *  This function is called, with the wheel locked, to turn the wheel up to
+ *  and including a tick.  On each tick, the higher level slots that have come
+ *  around are moved down, and the timers in the first level slot have
+ *  expired.  A periodic timer is restarted from when it should have expired,
+ *  and when it is more than one period late, the periods missed are counted
+ *  in one expiry, rather than each being called.
+ *
+ * Input Parameters:
+ *  now:
+ *      A value indicating the current time, in nanoseconds.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  A pointer to the list of timers whose callbacks are to be called, linked
+ *  through their due fields.
+ */
+static AXP_TIMER *AXP_Timer_Advance(u64 now)
+{
+    AXP_TIMER *expired = NULL;
+    AXP_TIMER *retVal = NULL;
+    AXP_TIMER *tail = NULL;
+    AXP_TIMER *timer, *next;
+    u64 nowTick = now >> AXP_TIMER_TICK_SHIFT;
+    u64 tick;
+    int level;
+
+    while (_timerWheel.tick <= nowTick)
+    {
+
+        /*
+         * When the wheel is well behind the clock, as it is when the virtual
+         * clock has been skipped ahead, go straight to the next tick with
+         * something to do, rather than turning through all the empty ones.
+         */
+        if ((nowTick - _timerWheel.tick) >= AXP_TIMER_SLOTS)
+        {
+            tick = AXP_Timer_Next();
+            if ((tick == 0) || (tick > nowTick))
+            {
+                _timerWheel.tick = nowTick + 1;
+                break;
+            }
+            _timerWheel.tick = tick;
+        }
+        tick = _timerWheel.tick;
+        for (level = AXP_TIMER_LEVELS - 1; level > 0; level--)
+        {
+            if ((tick & ((1ll << (AXP_TIMER_SLOT_BITS * level)) - 1)) == 0)
+            {
+                AXP_TIMER **head;
+
+                head = &_timerWheel.slot[level]
+                                        [(tick >>
+                                          (AXP_TIMER_SLOT_BITS * level)) &
+                                         AXP_TIMER_SLOT_MASK];
+                timer = *head;
+                *head = NULL;
+                while (timer != NULL)
+                {
+                    next = timer->flink;
+                    AXP_Timer_Insert(timer);
+                    timer = next;
+                }
+            }
+        }
+        timer = _timerWheel.slot[0][tick & AXP_TIMER_SLOT_MASK];
+        _timerWheel.slot[0][tick & AXP_TIMER_SLOT_MASK] = NULL;
+        while (timer != NULL)
+        {
+            next = timer->flink;
+            timer->flink = timer->blink = NULL;
+            timer->head = NULL;
+            timer->armed = false;
+            AXP_Timer_Due(&expired, timer);
+            timer = next;
+        }
+        _timerWheel.tick++;
+    }
+
+    /*
+     * Now restart the periodic timers, and decide which callbacks get called.
+     * The list of callbacks to call is kept in the same order.
+     */
+    while (expired != NULL)
+    {
+        timer = expired;
+        expired = timer->due;
+        timer->count = 1;
+        if (timer->period != 0)
+        {
+            if (now >= (timer->expires + timer->period))
+            {
+                timer->count += (now - timer->expires) / timer->period;
+            }
+            timer->expires += timer->count * timer->period;
+            AXP_Timer_Insert(timer);
+        }
+        if ((timer->coalesce == true) && (timer->pending == true))
+        {
+            timer->missed += timer->count;
+        }
+        else
+        {
+            timer->count += timer->missed;
+            timer->missed = 0;
+            timer->pending = timer->coalesce;
+            timer->due = NULL;
+            if (tail == NULL)
+            {
+                retVal = timer;
+            }
+            else
+            {
+                tail->due = timer;
+            }
+            tail = timer;
+        }
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Timer_Next
+ *  This function is called, with the wheel locked, to find the next tick on
+ *  which there is something to do.  That is the first non-empty slot of the
+ *  first level, or the tick on which the first non-empty slot of a higher
+ *  level comes around, whichever is sooner.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  0:      There are no timers running.
+ *  ~0:     The next tick on which there is something to do.
+ */
+static u64 AXP_Timer_Next(void)
+{
+    u64 retVal = 0;
+    u64 tick = _timerWheel.tick;
+    u64 block, next;
+    int level, ii;
+
+    for (ii = 0; ii < AXP_TIMER_SLOTS; ii++)
+    {
+        if (_timerWheel.slot[0][(tick + ii) & AXP_TIMER_SLOT_MASK] != NULL)
+        {
+            retVal = tick + ii;
+            break;
+        }
+    }
+    for (level = 1; level < AXP_TIMER_LEVELS; level++)
+    {
+        block = tick >> (AXP_TIMER_SLOT_BITS * level);
+        for (ii = 1; ii <= AXP_TIMER_SLOTS; ii++)
+        {
+            if (_timerWheel.slot[level][(block + ii) & AXP_TIMER_SLOT_MASK] !=
+                NULL)
+            {
+                next = (block + ii) << (AXP_TIMER_SLOT_BITS * level);
+                if ((retVal == 0) || (next < retVal))
+                {
+                    retVal = next;
+                }
+                break;
+            }
+        }
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Timer_Arm
+ *  This function is called, with the wheel locked, to arm the timerfd for a
+ *  tick, or disarm it.
+ *
+ * Input Parameters:
+ *  tick:
+ *      A value indicating the tick to wake up on, or 0 for none.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Timer_Arm(u64 tick)
+{
+    struct itimerspec ts;
+    u64 when = tick << AXP_TIMER_TICK_SHIFT;
+
+    /*
+     * In virtual time, the CPUs kick the thread when the clock gets to the
+     * armed tick, so the timerfd is only armed here if it is already there,
+     * or if the CPUs are all idle and the clock needs to be skipped ahead.
+     */
+    if (_timerWheel.virtual == true)
+    {
+        __atomic_store_n(&_timerWheel.armedTick, tick, __ATOMIC_SEQ_CST);
+        if ((tick != 0) &&
+            ((tick <=
+              (__atomic_load_n(&_timerWheel.clock, __ATOMIC_SEQ_CST) >>
+               AXP_TIMER_TICK_SHIFT)) ||
+             (__atomic_load_n(&_timerWheel.idle, __ATOMIC_SEQ_CST) >=
+              _timerWheel.cpus)))
+        {
+            AXP_Timer_Kick(1);
+        }
+    }
+    else
+    {
+        memset(&ts, 0, sizeof(ts));
+        if (tick != 0)
+        {
+            ts.it_value.tv_sec = when / AXP_TIMER_NSEC;
+            ts.it_value.tv_nsec = when % AXP_TIMER_NSEC;
+            if ((ts.it_value.tv_sec == 0) && (ts.it_value.tv_nsec == 0))
+            {
+                ts.it_value.tv_nsec = 1;
+            }
+        }
+        _timerWheel.armedTick = tick;
+        timerfd_settime(_timerWheel.fd, TFD_TIMER_ABSTIME, &ts, NULL);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Timer_Kick
+ *  This function is called to wake the timer thread up, in real time, by
+ *  arming the timerfd to expire after a delay.
+ *
+ * Input Parameters:
+ *  delay:
+ *      A value indicating how long, in nanoseconds, before the thread is
+ *      woken up.  This is at least 1.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Timer_Kick(u64 delay)
+{
+    struct itimerspec ts;
+
+    if (_timerWheel.fd >= 0)
+    {
+        memset(&ts, 0, sizeof(ts));
+        ts.it_value.tv_sec = delay / AXP_TIMER_NSEC;
+        ts.it_value.tv_nsec = delay % AXP_TIMER_NSEC;
+        timerfd_settime(_timerWheel.fd, 0, &ts, NULL);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Timer_Main
+ *  This is the main function for the thread servicing the timer wheel.  It
+ *  turns the wheel up to the current time, calls the callbacks of the timers
+ *  that expired, and then sleeps until the next tick with something to do.
+ *  In virtual time, when all the CPUs are idle, the clock is moved to the
+ *  next tick with something to do, and the wheel turned again, instead.  It
+ *  is not moved until a grace period after the last callbacks were called.
+ *
+ * Input Parameters:
+ *  voidPtr:
+ *      Not used.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL.
+ */
+static void *AXP_Timer_Main(void *voidPtr)
+{
+    AXP_TIMER *timer, *next;
+    u64 expirations, nextTick, now;
+    u64 grace = 0;
+    bool skip;
+
+    while (true)
+    {
+        pthread_mutex_lock(&_timerWheel.mutex);
+        timer = AXP_Timer_Advance(AXP_TimerNow());
+        pthread_mutex_unlock(&_timerWheel.mutex);
+        if ((timer != NULL) && (_timerWheel.virtual == true))
+        {
+            grace = AXP_Timer_Real() + AXP_TIMER_GRACE;
+        }
+        while (timer != NULL)
+        {
+            next = timer->due;
+            (*timer->callback)(timer->arg, timer->count);
+            timer = next;
+        }
+        pthread_mutex_lock(&_timerWheel.mutex);
+        nextTick = AXP_Timer_Next();
+        skip = (_timerWheel.virtual == true) &&
+               (nextTick != 0) &&
+               (__atomic_load_n(&_timerWheel.idle, __ATOMIC_SEQ_CST) >=
+                _timerWheel.cpus);
+        if ((skip == true) && ((now = AXP_Timer_Real()) < grace))
+        {
+            AXP_Timer_Kick(grace - now);
+            skip = false;
+        }
+        else if (skip == true)
+        {
+            now = __atomic_load_n(&_timerWheel.clock, __ATOMIC_SEQ_CST);
+            while ((now < (nextTick << AXP_TIMER_TICK_SHIFT)) &&
+                   (__atomic_compare_exchange_n(&_timerWheel.clock,
+                                                &now,
+                                                nextTick <<
+                                                    AXP_TIMER_TICK_SHIFT,
+                                                false,
+                                                __ATOMIC_SEQ_CST,
+                                                __ATOMIC_SEQ_CST) == false))
+            {
+                continue;
+            }
+        }
+        else
+        {
+            AXP_Timer_Arm(nextTick);
+        }
+        pthread_mutex_unlock(&_timerWheel.mutex);
+        if ((skip == false) &&
+            (read(_timerWheel.fd, &expirations, sizeof(expirations)) < 0))
+        {
+            expirations = 0;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(NULL);
+}
+
+/*
+ * AXP_TimerInit
+ *  This function is called to initialize a timer before it is first started.
+ *  The first call also starts the timer service.
+ *
+ * Input Parameters:
+ *  timer:
+ *      A pointer to the timer to be initialized.
+ *  callback:
+ *      A pointer to the function to be called when the timer expires.
+ *  arg:
+ *      A pointer to be passed to the callback.
+ *  coalesce:
+ *      A boolean indicating whether the callback is held back until the last
+ *      call has been acknowledged.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_TimerInit(AXP_TIMER *timer,
+                   AXP_TIMER_CALLBACK callback,
+                   void *arg,
+                   bool coalesce)
+{
+    pthread_once(&_timerOnce, AXP_Timer_Start);
+    memset(timer, 0, sizeof(AXP_TIMER));
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->coalesce = coalesce;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_TimerStart
+ *  This function is called to start, or restart, a timer.  If it now expires
+ *  before anything else, the timer thread is woken up sooner.
+ *
+ * Input Parameters:
+ *  timer:
+ *      A pointer to the timer to be started.
+ *  delay:
+ *      A value indicating how long from now, in nanoseconds, the timer first
+ *      expires.
+ *  period:
+ *      A value indicating the period, in nanoseconds, for the timer to expire
+ *      after that, or 0 for it to expire only once.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_TimerStart(AXP_TIMER *timer, u64 delay, u64 period)
+{
+    u64 tick, armedTick;
+
+    pthread_mutex_lock(&_timerWheel.mutex);
+    if (timer->armed == true)
+    {
+        AXP_Timer_Remove(timer);
+    }
+    timer->expires = AXP_TimerNow() + delay;
+    timer->period = period;
+    timer->seq = ++_timerWheel.seq;
+    AXP_Timer_Insert(timer);
+    tick = AXP_TIMER_TICK(timer->expires);
+    if (tick < _timerWheel.tick)
+    {
+        tick = _timerWheel.tick;
+    }
+    armedTick = __atomic_load_n(&_timerWheel.armedTick, __ATOMIC_SEQ_CST);
+    if ((armedTick == 0) || (tick < armedTick))
+    {
+        AXP_Timer_Arm(tick);
+    }
+    pthread_mutex_unlock(&_timerWheel.mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_TimerStop
+ *  This function is called to stop a timer.  Expiries not yet passed to the
+ *  callback are forgotten.  A callback already being called is not stopped.
+ *
+ * Input Parameters:
+ *  timer:
+ *      A pointer to the timer to be stopped.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_TimerStop(AXP_TIMER *timer)
+{
+    pthread_mutex_lock(&_timerWheel.mutex);
+    if (timer->armed == true)
+    {
+        AXP_Timer_Remove(timer);
+    }
+    timer->pending = false;
+    timer->missed = 0;
+    pthread_mutex_unlock(&_timerWheel.mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_TimerAck
+ *  This function is called when the guest has acknowledged a coalescing
+ *  timer's last expiry, so that its callback can be called again.
+ *
+ * Input Parameters:
+ *  timer:
+ *      A pointer to the timer being acknowledged.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_TimerAck(AXP_TIMER *timer)
+{
+    pthread_mutex_lock(&_timerWheel.mutex);
+    timer->pending = false;
+    pthread_mutex_unlock(&_timerWheel.mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_TimerVirtual
+ *  This function is called, when the system is created, to turn on virtual
+ *  time.  The virtual clock starts where the host's monotonic clock is, and
+ *  the time of day where the host's is, so timers already started are not
+ *  disturbed.  Virtual time cannot be turned off again.
+ *
+ * Input Parameters:
+ *  cpus:
+ *      A value indicating the number of CPUs in the system.  The clock is
+ *      skipped ahead when this many are idle.
+ *  instrTime:
+ *      A value indicating the nanoseconds the clock moves on for each
+ *      instruction retired.  A value of 0 leaves virtual time off.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_TimerVirtual(u32 cpus, u32 instrTime)
+{
+    pthread_mutex_lock(&_timerWheel.mutex);
+    if ((_timerWheel.virtual == false) && (instrTime != 0))
+    {
+        _timerWheel.cpus = cpus;
+        _timerWheel.instrTime = instrTime;
+        _timerWheel.clock = AXP_TimerNow();
+        _timerWheel.clockBase = _timerWheel.clock;
+        _timerWheel.timeBase = time(NULL);
+        __atomic_store_n(&_timerWheel.virtual, true, __ATOMIC_SEQ_CST);
+    }
+    pthread_mutex_unlock(&_timerWheel.mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_TimerRetire
+ *  This function is called by a CPU when it retires instructions.  In virtual
+ *  time, the clock is moved on, and if it has got to the tick the timer thread
+ *  is waiting for, the thread is woken up.  Only the CPU that takes the armed
+ *  tick wakes the thread.
+ *
+ * Input Parameters:
+ *  count:
+ *      A value indicating the number of instructions retired.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_TimerRetire(u32 count)
+{
+    u64 now, armedTick;
+
+    if (__atomic_load_n(&_timerWheel.virtual, __ATOMIC_RELAXED) == true)
+    {
+        now = __atomic_add_fetch(&_timerWheel.clock,
+                                 (u64) count * _timerWheel.instrTime,
+                                 __ATOMIC_SEQ_CST);
+        armedTick = __atomic_load_n(&_timerWheel.armedTick, __ATOMIC_SEQ_CST);
+        if ((armedTick != 0) &&
+            ((now >> AXP_TIMER_TICK_SHIFT) >= armedTick) &&
+            (__atomic_compare_exchange_n(&_timerWheel.armedTick,
+                                         &armedTick,
+                                         0,
+                                         false,
+                                         __ATOMIC_SEQ_CST,
+                                         __ATOMIC_SEQ_CST) == true))
+        {
+            AXP_Timer_Kick(1);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_TimerIdle
+ *  This function is called when a CPU goes idle or halts, and again when it
+ *  is busy again.  In virtual time, when the last CPU goes idle, the timer
+ *  thread is woken up to skip the clock ahead.  Code that wakes a CPU from a
+ *  timer callback needs to mark it busy before the callback returns, so the
+ *  clock is not skipped past an event the CPU has yet to see.
+ *
+ * Input Parameters:
+ *  idle:
+ *      A boolean indicating whether the CPU is now idle.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_TimerIdle(bool idle)
+{
+    if (idle == true)
+    {
+        if ((__atomic_add_fetch(&_timerWheel.idle, 1, __ATOMIC_SEQ_CST) >=
+             _timerWheel.cpus) &&
+            (__atomic_load_n(&_timerWheel.virtual, __ATOMIC_SEQ_CST) == true))
+        {
+            AXP_Timer_Kick(1);
+        }
+    }
+    else
+    {
+        __atomic_sub_fetch(&_timerWheel.idle, 1, __ATOMIC_SEQ_CST);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
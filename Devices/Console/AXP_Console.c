@@ -0,0 +1,570 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains the code for the console serial ports.  Each port is
+ *  a 16550 UART, as seen by the emulated system through PIO reads and writes,
+ *  with a byte ring in each direction.  COM1 is connected to the TELNET
+ *  server, which fills the port's receive ring with the input from the
+ *  read-write session and empties the port's transmit ring to all the
+ *  sessions.
+ *
+ *  The rings are single producer, single consumer, so neither the CPU side nor
+ *  the TELNET side takes a lock to move a character, and neither one ever
+ *  waits on the other.  A full receive ring sets the overrun error, and
+ *  characters written to a full transmit ring are dropped.
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_Configure.h"
+#include "Devices/Console/AXP_Console.h"
+#include "Devices/Console/AXP_Telnet.h"
+
+/*
+ * The console ports.
+ */
+static AXP_CONSOLE_PORT _consolePorts[AXP_CONSOLE_PORTS];
+static const u16 _consoleBase[AXP_CONSOLE_PORTS] =
+{
+    AXP_CONSOLE_COM1,
+    AXP_CONSOLE_COM2
+};
+
+/*
+ * Local Prototypes
+ */
+static u8 AXP_Console_Pending(AXP_CONSOLE_PORT *);
+static void AXP_Console_Interrupt(AXP_CONSOLE_PORT *);
+
+/*
+ * AXP_Console_Put
+ *  This function is called by the producer for a ring to copy as many bytes
+ *  into the ring as will fit.  The bytes are copied before the tail is moved,
+ *  so the consumer never sees a byte that has not been written.
+ *
+ * Input Parameters:
+ *  ring:
+ *      A pointer to the ring to be written.
+ *  buf:
+ *      A pointer to the bytes to be written into the ring.
+ *  bufLen:
+ *      A value indicating the number of bytes in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The number of bytes actually written into the ring.
+ */
+u32 AXP_Console_Put(AXP_CONSOLE_RING *ring, u8 *buf, u32 bufLen)
+{
+    u32 head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    u32 tail = ring->tail;
+    u32 room = AXP_CONSOLE_RING_LEN - (tail - head);
+    u32 idx = tail & AXP_CONSOLE_RING_MASK;
+    u32 len;
+
+    if (bufLen > room)
+    {
+        bufLen = room;
+    }
+    len = AXP_CONSOLE_RING_LEN - idx;
+    if (len > bufLen)
+    {
+        len = bufLen;
+    }
+    memcpy(&ring->buf[idx], buf, len);
+    memcpy(ring->buf, &buf[len], bufLen - len);
+    __atomic_store_n(&ring->tail, tail + bufLen, __ATOMIC_RELEASE);
+
+    /*
+     * Return back to the caller.
+     */
+    return(bufLen);
+}
+
+/*
+ * AXP_Console_Get
+ *  This function is called by the consumer for a ring to copy as many bytes
+ *  out of the ring as there are, up to the size of the supplied buffer.  The
+ *  bytes are copied before the head is moved, so the producer never writes
+ *  over a byte that has not been read.
+ *
+ * Input Parameters:
+ *  ring:
+ *      A pointer to the ring to be read.
+ *  bufLen:
+ *      A value indicating the size of the buf parameter.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the buffer to receive the bytes read from the ring.
+ *
+ * Return Values:
+ *  The number of bytes actually read from the ring.
+ */
+u32 AXP_Console_Get(AXP_CONSOLE_RING *ring, u8 *buf, u32 bufLen)
+{
+    u32 tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    u32 head = ring->head;
+    u32 count = tail - head;
+    u32 idx = head & AXP_CONSOLE_RING_MASK;
+    u32 len;
+
+    if (bufLen > count)
+    {
+        bufLen = count;
+    }
+    len = AXP_CONSOLE_RING_LEN - idx;
+    if (len > bufLen)
+    {
+        len = bufLen;
+    }
+    memcpy(buf, &ring->buf[idx], len);
+    memcpy(&buf[len], ring->buf, bufLen - len);
+    __atomic_store_n(&ring->head, head + bufLen, __ATOMIC_RELEASE);
+
+    /*
+     * Return back to the caller.
+     */
+    return(bufLen);
+}
+
+/*
+ * AXP_Console_Init
+ *  This function is called to reset the console ports, supply the function to
+ *  be called when a port's interrupt line may have changed, and connect COM1
+ *  to the TELNET server.
+ *
+ * Input Parameters:
+ *  interrupt:
+ *      A pointer to the function to be called with the interrupt argument and
+ *      the port's interrupt line.  It is called from both the CPU side and the
+ *      TELNET side, and only needs to act when the line changes.
+ *  intArg:
+ *      A pointer to be passed to the interrupt function.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Console_Init(void (*interrupt)(void *, bool), void *intArg)
+{
+    int ii;
+
+    for (ii = 0; ii < AXP_CONSOLE_PORTS; ii++)
+    {
+        memset(&_consolePorts[ii], 0, sizeof(AXP_CONSOLE_PORT));
+        _consolePorts[ii].base = _consoleBase[ii];
+        _consolePorts[ii].interrupt = interrupt;
+        _consolePorts[ii].intArg = intArg;
+    }
+    AXP_Telnet_SetInput(AXP_Console_Input);
+    AXP_Telnet_SetOutput(AXP_Console_Output);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Console_Port
+ *  This function is called to determine if a PCI I/O address is one of the
+ *  console port registers.
+ *
+ * Input Parameters:
+ *  ioAddr:
+ *      A value containing the PCI I/O address being read or written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL:   The address is not a console port register.
+ *  !NULL:  A pointer to the console port whose register it is.
+ */
+AXP_CONSOLE_PORT *AXP_Console_Port(u32 ioAddr)
+{
+    AXP_CONSOLE_PORT *retVal = NULL;
+    int ii;
+
+    for (ii = 0; ((ii < AXP_CONSOLE_PORTS) && (retVal == NULL)); ii++)
+    {
+        if ((ioAddr >= _consoleBase[ii]) &&
+            (ioAddr < (_consoleBase[ii] + AXP_CONSOLE_REGS)))
+        {
+            retVal = &_consolePorts[ii];
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Console_Pending
+ *  This function is called to determine the highest priority interrupt that
+ *  is pending for a console port.
+ *
+ * Input Parameters:
+ *  port:
+ *      A pointer to the console port.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_UART_IIR_RDA:   Received data is available.
+ *  AXP_UART_IIR_THRE:  The transmit holding register is empty.
+ *  AXP_UART_IIR_NONE:  There is no interrupt pending.
+ */
+static u8 AXP_Console_Pending(AXP_CONSOLE_PORT *port)
+{
+    u8 ier = __atomic_load_n(&port->ier, __ATOMIC_ACQUIRE);
+    u8 retVal = AXP_UART_IIR_NONE;
+
+    if (((ier & AXP_UART_IER_RDA) != 0) &&
+        (__atomic_load_n(&port->rx.tail, __ATOMIC_ACQUIRE) !=
+         __atomic_load_n(&port->rx.head, __ATOMIC_ACQUIRE)))
+    {
+        retVal = AXP_UART_IIR_RDA;
+    }
+    else if (((ier & AXP_UART_IER_THRE) != 0) &&
+             (__atomic_load_n(&port->thrInt, __ATOMIC_ACQUIRE) == true))
+    {
+        retVal = AXP_UART_IIR_THRE;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Console_Interrupt
+ *  This function is called, from either side, after something has changed
+ *  that may change a console port's interrupt line.  The line is checked again
+ *  after it has been passed on, in case the other side changed it in the
+ *  meantime, so that the last value passed on is always the current one.
+ *
+ * Input Parameters:
+ *  port:
+ *      A pointer to the console port.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Console_Interrupt(AXP_CONSOLE_PORT *port)
+{
+    bool level;
+
+    if (port->interrupt != NULL)
+    {
+        do
+        {
+            level = AXP_Console_Pending(port) != AXP_UART_IIR_NONE;
+            (*port->interrupt)(port->intArg, level);
+        } while (level != (AXP_Console_Pending(port) != AXP_UART_IIR_NONE));
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Console_ReadPort
+ *  This function is called from the CPU side to read one of a console port's
+ *  registers.  Reading the receive buffer takes the next byte from the receive
+ *  ring.
+ *
+ * Input Parameters:
+ *  port:
+ *      A pointer to the console port.
+ *  reg:
+ *      A value indicating the register to be read.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The value of the register.
+ */
+u8 AXP_Console_ReadPort(AXP_CONSOLE_PORT *port, u32 reg)
+{
+    bool dlab = (port->lcr & AXP_UART_LCR_DLAB) != 0;
+    u8 retVal = 0;
+
+    switch (reg)
+    {
+        case AXP_UART_RBR:
+            if (dlab == true)
+            {
+                retVal = port->dll;
+            }
+            else
+            {
+                AXP_Console_Get(&port->rx, &retVal, 1);
+                AXP_Console_Interrupt(port);
+            }
+            break;
+
+        case AXP_UART_IER:
+            retVal = (dlab == true) ? port->dlm : port->ier;
+            break;
+
+        case AXP_UART_IIR:
+            retVal = AXP_Console_Pending(port);
+            if (retVal == AXP_UART_IIR_THRE)
+            {
+                __atomic_store_n(&port->thrInt, false, __ATOMIC_RELEASE);
+                AXP_Console_Interrupt(port);
+            }
+            if ((port->fcr & AXP_UART_FCR_ENABLE) != 0)
+            {
+                retVal |= AXP_UART_IIR_FIFO;
+            }
+            break;
+
+        case AXP_UART_LCR:
+            retVal = port->lcr;
+            break;
+
+        case AXP_UART_MCR:
+            retVal = port->mcr;
+            break;
+
+        /*
+         * We can always take another byte to transmit, even if it ends up
+         * being dropped, so the CPU never waits on the TELNET side.
+         */
+        case AXP_UART_LSR:
+            retVal = AXP_UART_LSR_THRE | AXP_UART_LSR_TEMT;
+            if (__atomic_load_n(&port->rx.tail, __ATOMIC_ACQUIRE) !=
+                port->rx.head)
+            {
+                retVal |= AXP_UART_LSR_DR;
+            }
+            if (__atomic_exchange_n(&port->overrun,
+                                    false,
+                                    __ATOMIC_ACQ_REL) == true)
+            {
+                retVal |= AXP_UART_LSR_OE;
+            }
+            break;
+
+        case AXP_UART_MSR:
+            retVal = AXP_UART_MSR_READY;
+            break;
+
+        case AXP_UART_SCR:
+            retVal = port->scr;
+            break;
+
+        default:
+            break;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Console_WritePort
+ *  This function is called from the CPU side to write one of a console port's
+ *  registers.  Writing the transmit holding register puts the byte into the
+ *  transmit ring, and if the TELNET side has not already been told there is
+ *  output, tells it.  In loopback mode, the byte goes into the receive ring
+ *  instead.
+ *
+ * Input Parameters:
+ *  port:
+ *      A pointer to the console port.
+ *  reg:
+ *      A value indicating the register to be written.
+ *  value:
+ *      A value to be written to the register.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Console_WritePort(AXP_CONSOLE_PORT *port, u32 reg, u8 value)
+{
+    bool dlab = (port->lcr & AXP_UART_LCR_DLAB) != 0;
+    u8 discard[AXP_CONSOLE_REGS * 16];
+
+    switch (reg)
+    {
+        case AXP_UART_THR:
+            if (dlab == true)
+            {
+                port->dll = value;
+            }
+            else
+            {
+                if ((port->mcr & AXP_UART_MCR_LOOP) != 0)
+                {
+                    if (AXP_Console_Put(&port->rx, &value, 1) == 0)
+                    {
+                        __atomic_store_n(&port->overrun,
+                                         true,
+                                         __ATOMIC_RELEASE);
+                    }
+                }
+                else if ((AXP_Console_Put(&port->tx, &value, 1) == 1) &&
+                         (port == &_consolePorts[0]) &&
+                         (__atomic_exchange_n(&port->txKick,
+                                              true,
+                                              __ATOMIC_ACQ_REL) == false))
+                {
+                    AXP_Telnet_Kick();
+                }
+                __atomic_store_n(&port->thrInt, true, __ATOMIC_RELEASE);
+                AXP_Console_Interrupt(port);
+            }
+            break;
+
+        case AXP_UART_IER:
+            if (dlab == true)
+            {
+                port->dlm = value;
+            }
+            else
+            {
+                __atomic_store_n(&port->ier, value & 0x0f, __ATOMIC_RELEASE);
+                __atomic_store_n(&port->thrInt,
+                                 (value & AXP_UART_IER_THRE) != 0,
+                                 __ATOMIC_RELEASE);
+                AXP_Console_Interrupt(port);
+            }
+            break;
+
+        case AXP_UART_FCR:
+            port->fcr = value;
+            if ((value & AXP_UART_FCR_RCLR) != 0)
+            {
+                while (AXP_Console_Get(&port->rx,
+                                       discard,
+                                       sizeof(discard)) > 0);
+                AXP_Console_Interrupt(port);
+            }
+            break;
+
+        case AXP_UART_LCR:
+            port->lcr = value;
+            break;
+
+        case AXP_UART_MCR:
+            port->mcr = value;
+            break;
+
+        case AXP_UART_SCR:
+            port->scr = value;
+            break;
+
+        default:
+            break;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Console_Input
+ *  This function is called by the TELNET server with the input from the
+ *  read-write session, to be put into COM1's receive ring.  Whatever does not
+ *  fit is dropped, and reported to the CPU side as an overrun error.
+ *
+ * Input Parameters:
+ *  buf:
+ *      A pointer to the input received.
+ *  bufLen:
+ *      A value indicating the number of bytes in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Console_Input(u8 *buf, u32 bufLen)
+{
+    AXP_CONSOLE_PORT *port = &_consolePorts[0];
+
+    if (AXP_Console_Put(&port->rx, buf, bufLen) < bufLen)
+    {
+        __atomic_store_n(&port->overrun, true, __ATOMIC_RELEASE);
+    }
+    AXP_Console_Interrupt(port);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Console_Output
+ *  This function is called by the TELNET server, after it has been told there
+ *  is output, to get the output from COM1's transmit ring.  The output flag is
+ *  cleared before the ring is read, so that anything written after the ring
+ *  was read will tell the TELNET server again.
+ *
+ * Input Parameters:
+ *  bufLen:
+ *      A value indicating the size of the buf parameter.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the buffer to receive the output.
+ *
+ * Return Values:
+ *  The number of bytes returned in the buf parameter.
+ */
+u32 AXP_Console_Output(u8 *buf, u32 bufLen)
+{
+    AXP_CONSOLE_PORT *port = &_consolePorts[0];
+
+    __atomic_store_n(&port->txKick, false, __ATOMIC_SEQ_CST);
+
+    /*
+     * Return back to the caller.
+     */
+    return(AXP_Console_Get(&port->tx, buf, bufLen));
+}
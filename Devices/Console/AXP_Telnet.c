@@ -17,10 +17,10 @@
  * Description:
  *
  *  This module contains the TELNET server code.  It sets up a port on which to
- *  listen and accepts just one connection.  Once a connection is accepted,
- *  other attempts to connect will be rejected.  If the active connection is
- *  dropped, it will get cleaned up and the listener will now accept new
- *  connection requests.
+ *  listen and accepts up to AXP_TELNET_MAX_SESSIONS connections.  The first
+ *  connection is the one allowed to send input to the console, the rest are
+ *  read-only mirrors of the console output.  If the read-write connection is
+ *  dropped, the oldest remaining connection becomes the read-write one.
  *
  * Revision History:
  *
@@ -34,6 +34,29 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Replaced the single session, blocking server loop with one that waits on
+ *  non-blocking sockets with epoll, so that more than one session can be
+ *  connected at a time.  Output to each session is buffered, and we stop
+ *  reading from a client that is not taking its output.  The server can also
+ *  be restricted to loopback connections and shut down, for testing.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  The receive state machine action for each byte value is now looked up in
+ *  a table, and runs of plain data bytes received while in the data state are
+ *  handed on in one go, rather than running the state machine for each byte.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Output is no longer sent on every call.  It is coalesced in the session's
+ *  output buffer and sent when a batch's worth is queued, at the end of a
+ *  line or prompt, after a short delay, or after the received data has been
+ *  processed, so option negotiation and echoes go out in a single write.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  Added a function to be called to get console output, and one to tell the
+ *  server there is some, so a console port can hand its output to the server
+ *  without taking the server's mutex.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -299,6 +322,18 @@ AXP_StateMachine TN_Receive_SM =
     .stateMachine = &TN_Receive[0][0]
 };
 
+/*
+ * These tables are indexed by a received byte.  The first contains the action
+ * into the receive state machine for the byte.  The second indicates whether,
+ * while in the data state, the byte just gets echoed and leaves us in the
+ * data state.  Runs of these bytes are handled without the state machine.
+ * They are built from the receive state machine the first time data is
+ * processed.
+ */
+static u8 TN_RcvAction[256];
+static bool TN_RcvPlain[256];
+static pthread_once_t TN_RcvOnce = PTHREAD_ONCE_INIT;
+
 static char *TN_dir[] =
 {
     "<---",
@@ -309,12 +344,21 @@ static char *TN_dir[] =
 
 /*
  * This state value is used to maintain the state of being able to listen and
- * accept connections.  Once a connection has been accepted, then a session
- * block will be created to hold the TELNET connection information.  At this
- * point we probably could accept more connections, but we will not allow it,
- * at least at this time.
+ * accept connections.  Each connection that has been accepted has a session
+ * block to hold the TELNET connection information, and its own state.  The
+ * sessions, and the output queued for them, are protected by the mutex.
  */
 AXP_Telnet_Session_State srvState;
+static pthread_mutex_t _telnetMutex = PTHREAD_MUTEX_INITIALIZER;
+static AXP_TELNET_SESSION *_telnetSessions[AXP_TELNET_MAX_SESSIONS];
+static void (*_telnetInput)(u8 *, u32) = NULL;
+static u32 (*_telnetOutput)(u8 *, u32) = NULL;
+static int _telnetEpoll = -1;
+static int _telnetListen = -1;
+static int _telnetWake = -1;
+static u16 _telnetPort = AXP_TELNET_DEFAULT_PORT;
+static pthread_t _telnetThread;
+static bool _telnetLoopback = false;
 
 /*
  * Local Prototypes.
@@ -322,11 +366,23 @@ AXP_Telnet_Session_State srvState;
 static void Process_Suboption(AXP_SM_Args *);
 static u32 AXP_Telnet_Trace(int, u8 *, u32);
 static bool AXP_Telnet_Listener(int *);
-static AXP_TELNET_SESSION *AXP_Telnet_Accept(int);
+static void AXP_Telnet_Interest(AXP_TELNET_SESSION *);
+static bool AXP_Telnet_Flush(AXP_TELNET_SESSION *);
+static bool AXP_Telnet_Coalesce(AXP_TELNET_SESSION *, u8 *, u32);
+static u64 AXP_Telnet_Now(void);
+static int AXP_Telnet_Timers(void);
+static void AXP_Telnet_Accept(int);
 static bool AXP_Telnet_Receive(AXP_TELNET_SESSION *, u8 *, u32 *);
+static void AXP_Telnet_Queue(AXP_TELNET_SESSION *, u8 *, u32);
+static void AXP_Telnet_Broadcast(u8 *, u32);
+static void AXP_Telnet_Drain(void);
+static void AXP_Telnet_Echo(AXP_TELNET_SESSION *, u8 *, u32);
+static void AXP_Telnet_RcvInit(void);
 static bool AXP_Telnet_Reject(AXP_TELNET_SESSION **);
 static bool AXP_Telnet_Ignore(int);
 static bool AXP_Telnet_Processor(AXP_TELNET_SESSION *, u8 *, u32);
+static void AXP_Telnet_Negotiate(AXP_TELNET_SESSION *);
+static void AXP_Telnet_Session(AXP_TELNET_SESSION *, u32);
 
 /*
  * Send_DO
@@ -368,11 +424,11 @@ void Send_DO(AXP_SM_Args *args)
 
     /*
      * OK, something happened and the session is no longer active.  Set the
-     * server state, so that we can start cleaning up the connection.
+     * session state, so that we can start cleaning up the connection.
      */
     if (retVal == false)
     {
-        srvState = Inactive;
+        ses->state = Inactive;
     }
 
     /*
@@ -421,11 +477,11 @@ void Send_DONT(AXP_SM_Args *args)
 
     /*
      * OK, something happened and the session is no longer active.  Set the
-     * server state, so that we can start cleaning up the connection.
+     * session state, so that we can start cleaning up the connection.
      */
     if (retVal == false)
     {
-        srvState = Inactive;
+        ses->state = Inactive;
     }
 
     /*
@@ -474,11 +530,11 @@ void Send_WILL(AXP_SM_Args *args)
 
     /*
      * OK, something happened and the session is no longer active.  Set the
-     * server state, so that we can start cleaning up the connection.
+     * session state, so that we can start cleaning up the connection.
      */
     if (retVal == false)
     {
-        srvState = Inactive;
+        ses->state = Inactive;
     }
 
     /*
@@ -527,11 +583,11 @@ void Send_WONT(AXP_SM_Args *args)
 
     /*
      * OK, something happened and the session is no longer active.  Set the
-     * server state, so that we can start cleaning up the connection.
+     * session state, so that we can start cleaning up the connection.
      */
     if (retVal == false)
     {
-        srvState = Inactive;
+        ses->state = Inactive;
     }
 
     /*
@@ -560,7 +616,6 @@ void Send_WONT(AXP_SM_Args *args)
 void Echo_Data(AXP_SM_Args *args)
 {
     AXP_TELNET_SESSION *ses = (AXP_TELNET_SESSION *) args->argp[0];
-    bool retVal = true;
     u8 c = *((u8 *) args->argp[1]);
 
     if (AXP_UTL_OPT1)
@@ -569,22 +624,46 @@ void Echo_Data(AXP_SM_Args *args)
         AXP_TraceWrite("\tEcho_Data Called (%c - %02x).", c, c);
         AXP_TRACE_END();
     }
+    AXP_Telnet_Echo(ses, &c, 1);
 
     /*
-     * Get the character that needs to be sent back to the client, but only if
-     * echoing is turned on.
+     * Return back to the caller.
      */
-    if (ses->myOptions[TELOPT_ECHO].state == AXP_OPT_YES)
-    {
-        retVal = AXP_Telnet_Send(ses, &c, 1);
+    return;
+}
 
-        /*
-         * OK, something happened and the session is no longer active.  Set the
-         * server state, so that we can start cleaning up the connection.
-         */
-        if (retVal == false)
+/*
+ * AXP_Telnet_Echo
+ *  This function is called with one or more data characters received from a
+ *  client.  Data from the read-only sessions is ignored.  Data from the
+ *  read-write session is handed to the console, and if echoing is turned on,
+ *  sent back to all the sessions, so the mirrors see what is being typed.
+ *
+ * Input Parameters:
+ *  ses:
+ *      A pointer to the session variable used to maintain the TELNET session.
+ *  buf:
+ *      A pointer to the data characters.
+ *  bufLen:
+ *      A value indicating the number of characters in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Telnet_Echo(AXP_TELNET_SESSION *ses, u8 *buf, u32 bufLen)
+{
+    if (ses->readOnly == false)
+    {
+        if (_telnetInput != NULL)
+        {
+            (*_telnetInput)(buf, bufLen);
+        }
+        if (ses->myOptions[TELOPT_ECHO].state == AXP_OPT_YES)
         {
-            srvState = Inactive;
+            AXP_Telnet_Broadcast(buf, bufLen);
         }
     }
 
@@ -1149,9 +1228,10 @@ static u32 AXP_Telnet_Trace(int dir, u8 *buf, u32 bufLen)
 
 /*
  * AXP_Telnet_Listener
- *  This function is called to create the port listener.  It gets the port on
- *  which it is supposed to be listening from the configuration.  It will
- *  default to 108 (snagas - Digital SNA Gateway Access Protocol).
+ *  This function is called to create the port listener.  The listener is
+ *  non-blocking, so that it can be waited on along with the sessions.  If the
+ *  server is only to be used from this host (for testing), the listener is
+ *  bound to the loopback address.
  *
  * Input Parameters:
  *  None.
@@ -1166,19 +1246,24 @@ static u32 AXP_Telnet_Trace(int dir, u8 *buf, u32 bufLen)
  */
 static bool AXP_Telnet_Listener(int *sock)
 {
-    struct sockaddr_in    myName;
+    struct sockaddr_in myName;
+    socklen_t myNameSize = sizeof(myName);
+    int reuse = 1;
     bool retVal = true;
 
     /*
      * First things first, we need a socket onto which we will listen for
      * connections.
      */
-    *sock = socket(AF_INET, SOCK_STREAM, 0);
+    *sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (*sock >= 0)
     {
+        memset(&myName, 0, sizeof(myName));
         myName.sin_family = AF_INET;
-        myName.sin_addr.s_addr = INADDR_ANY;
-        myName.sin_port = htons(AXP_TELNET_DEFAULT_PORT);
+        myName.sin_addr.s_addr =
+            htonl(_telnetLoopback ? INADDR_LOOPBACK : INADDR_ANY);
+        myName.sin_port = htons(_telnetPort);
+        setsockopt(*sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
     }
     else
     {
@@ -1186,20 +1271,27 @@ static bool AXP_Telnet_Listener(int *sock)
     }
 
     /*
-     * Now bind the name to the socket
+     * Now bind the name to the socket, and if we were asked for any port,
+     * get the one we were given.
      */
     if (retVal == true)
     {
         retVal = bind(*sock, (struct sockaddr *) &myName, sizeof(myName)) >= 0;
     }
+    if (retVal == true)
+    {
+        retVal = getsockname(*sock,
+                             (struct sockaddr *) &myName,
+                             &myNameSize) >= 0;
+        _telnetPort = ntohs(myName.sin_port);
+    }
 
     /*
-     * Now set up a listener on the socket (only allow one connection request
-     * into the listener queue).
+     * Now set up a listener on the socket.
      */
     if (retVal == true)
     {
-        retVal = listen(*sock, 1) >= 0;
+        retVal = listen(*sock, AXP_TELNET_MAX_SESSIONS) >= 0;
     }
 
     /*
@@ -1209,114 +1301,124 @@ static bool AXP_Telnet_Listener(int *sock)
 }
 
 /*
- * AXP_Telnet_Accept
- *  This function is called to wait for the next connection to be requested and
- *  accept it.
+ * AXP_Telnet_Interest
+ *  This function is called to update the events we are waiting for on a
+ *  session's socket.  We wait to receive data, unless too much output is
+ *  queued for the session, and wait to send data when the socket would not
+ *  take all the output we tried to send.
  *
  * Input Parameters:
- *  sock:
- *      The value of the socket on which to accept connections.
+ *  ses:
+ *      A pointer to the session variable used to maintain the TELNET session.
  *
  * Output Parameters:
- *  ses:
- *      A location to receive the session information on which data is sent and
- *      received to and from the client.
+ *  None.
  *
  * Return Values:
- *  NULL:       An error occurred and the connection was not accepted.
- *  <address>:  The address of a TELNET session block used to maintain the
- *              TELNET connection with the client (we are the server).
+ *  None.
  */
-static AXP_TELNET_SESSION *AXP_Telnet_Accept(int sock)
+static void AXP_Telnet_Interest(AXP_TELNET_SESSION *ses)
 {
-    AXP_SM_Args args;
-    AXP_TELNET_SESSION *ses;
-    struct sockaddr theirName;
-    int theirNameSize = sizeof(theirName);
-
-    /*
-     * Go allocate a block into which TELNET session information can be
-     * maintained throughout the life of the connection with the client.
-     */
-    ses = (AXP_TELNET_SESSION *) AXP_Allocate_Block(AXP_TELNET_SES_BLK);
+    struct epoll_event event;
+    u32 events = ses->events;
 
-    /*
-     * Try to accept a connection.  If it fails, return the block, otherwise
-     * go ahead initialize and return it back to the caller.
-     */
-    printf("Ready to accept a TELNET connection...\n");
-    ses->mySocket = accept(sock, &theirName, &theirNameSize);
-    if (ses->mySocket < 0)
+    if (ses->outLen >= AXP_TELNET_OUT_HIGH)
     {
-        AXP_Deallocate_Block(ses);
-        ses = NULL;
-        printf("Accepting a TELNET connection has failed...\n");
+        events &= ~EPOLLIN;
+    }
+    else if (ses->outLen <= AXP_TELNET_OUT_LOW)
+    {
+        events |= EPOLLIN;
+    }
+    if (ses->outBlocked == true)
+    {
+        events |= EPOLLOUT;
     }
     else
     {
-        AXP_OPT_SET_PREF(ses->myOptions, TELOPT_ECHO);
-        AXP_OPT_SET_PREF(ses->myOptions, TELOPT_SGA);
-        AXP_OPT_SET_SUPP(ses->myOptions, TELOPT_TTYPE);
-        AXP_OPT_SET_SUPP(ses->myOptions, TELOPT_NEW_ENVIRON);
-        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_ECHO);
-        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_SGA);
-        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_NAWS);
-        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_LFLOW);
-        ses->rcvState = AXP_RCV_DATA;
-        args.argc = 1;
-        args.argp[0] = (void *) ses;
-        SubOpt_Clear(&args);
-        printf("A TELNET connection has been accepted...\n");
+        events &= ~EPOLLOUT;
+    }
+    if ((events != ses->events) && (_telnetEpoll >= 0))
+    {
+        event.events = events;
+        event.data.ptr = (void *) ses;
+        epoll_ctl(_telnetEpoll, EPOLL_CTL_MOD, ses->mySocket, &event);
+        ses->events = events;
     }
 
     /*
      * Return back to the caller.
      */
-    return(ses);
+    return;
 }
 
 /*
- * AXP_Telnet_Receive
- *  This function is called to wait for the next message to be sent from the
- *  TELNET client and return it back to the caller.
+ * AXP_Telnet_Flush
+ *  This function is called to send as much of the output queued for a session
+ *  as the socket will take without blocking.  The output buffer is a ring, so
+ *  the queued output is sent as up to two pieces in the one call.
  *
  * Input Parameters:
  *  ses:
  *      A pointer to the session variable used to maintain the TELNET session.
- *  bufLen:
- *      A pointer to a location indicating the number of bytes in the buf
- *      parameter.
  *
  * Output Parameters:
- *  buf:
- *      A location to receive the data received from the TELNET client.
- *  bufLen:
- *      A pointer to a location to receive the number of bytes being returned
- *      in the buf parameter.
+ *  None.
  *
  * Return Values:
- *  true:   The buf and bufLen parameters contain valid information.
- *  false:  Failure.
+ *  true:   The output was sent or is still queued.
+ *  false:  The connection has been terminated.
  */
-static bool AXP_Telnet_Receive(AXP_TELNET_SESSION *ses, u8 *buf, u32 *bufLen)
+static bool AXP_Telnet_Flush(AXP_TELNET_SESSION *ses)
 {
-    bool    retVal = true;
-
-    /*
-     * Receive up to a buffers worth of data.  Since we are using a
-     * steam protocol, we only may receive part of a complete buffer.
-     * A buffer's last character should be a null character.
-     */
-    *bufLen = recv(ses->mySocket, buf, *bufLen, 0);
+    struct msghdr msg;
+    struct iovec iov[2];
+    ssize_t sent = 0;
+    u32 len;
+    bool retVal = true;
 
-    /*
-     * If the receive length is less than or equal to zero, we assume
-     * the connection has been terminated for one reason or other (them
-     * or us).
-     */
-    if ((i32) *bufLen <= 0)
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    ses->flushAt = 0;
+    ses->outBlocked = false;
+    while ((ses->outLen > 0) && (sent >= 0))
     {
-        retVal = false;
+        len = AXP_TELNET_OUT_LEN - ses->outHead;
+        if (len >= ses->outLen)
+        {
+            len = ses->outLen;
+            msg.msg_iovlen = 1;
+        }
+        else
+        {
+            iov[1].iov_base = ses->outBuf;
+            iov[1].iov_len = ses->outLen - len;
+            msg.msg_iovlen = 2;
+        }
+        iov[0].iov_base = &ses->outBuf[ses->outHead];
+        iov[0].iov_len = len;
+        sent = sendmsg(ses->mySocket, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            ses->outHead = (ses->outHead + sent) % AXP_TELNET_OUT_LEN;
+            ses->outLen -= sent;
+        }
+        else if ((sent < 0) && (errno == EINTR))
+        {
+            sent = 0;
+        }
+        else if ((sent < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            retVal = false;
+        }
+        else if (sent < 0)
+        {
+            ses->outBlocked = true;
+        }
+    }
+    if (retVal == true)
+    {
+        AXP_Telnet_Interest(ses);
     }
 
     /*
@@ -1326,14 +1428,19 @@ static bool AXP_Telnet_Receive(AXP_TELNET_SESSION *ses, u8 *buf, u32 *bufLen)
 }
 
 /*
- * AXP_Telnet_Send
- *  This function is called to send data to the TELNET client.
+ * AXP_Telnet_Coalesce
+ *  This function is called after output has been queued for a session, to
+ *  decide whether to send it now, or wait for more.  It is sent now if there
+ *  is a batch's worth queued, or the output just queued completes a line or
+ *  a prompt.  Otherwise, it is sent when the flush delay expires, and if we
+ *  are not the server thread, the server is woken up to start the delay.  If
+ *  the socket is not taking output, we wait for it to become writable.
  *
  * Input Parameters:
  *  ses:
  *      A pointer to the session variable used to maintain the TELNET session.
  *  buf:
- *      A location containing the data to be sent to the TELNET client.
+ *      A pointer to the output just queued.
  *  bufLen:
  *      A value indicating the number of bytes in the buf parameter.
  *
@@ -1341,55 +1448,45 @@ static bool AXP_Telnet_Receive(AXP_TELNET_SESSION *ses, u8 *buf, u32 *bufLen)
  *  None.
  *
  * Return Values:
- *  true:   The data in the buf parameter was sent.
- *  false:  Failure.
+ *  true:   The output was sent or is still queued.
+ *  false:  The connection has been terminated.
  */
-bool AXP_Telnet_Send(AXP_TELNET_SESSION *ses, u8 *buf, int bufLen)
+static bool AXP_Telnet_Coalesce(AXP_TELNET_SESSION *ses, u8 *buf, u32 bufLen)
 {
-    bool    retVal = true;
-
-    if (AXP_UTL_CALL)
-    {
-        AXP_TRACE_BEGIN();
-        AXP_TraceWrite("AXP_Telnet_Send called.");
-        AXP_TRACE_END();
-    }
+    u64 wakeCount = 1;
+    u32 last;
+    bool retVal = true;
+    bool prompt = false;
 
-    /*
-     * Receive up to a buffers worth of data.  Since we are using a
-     * steam protocol, we only may receive part of a complete buffer.
-     * A buffer's last character should be a null character.
-     */
-    if (TELCMD_OK(buf[0]))
+    if ((ses->outLen >= 2) && (ses->outBlocked == false))
     {
-        u32 trcLen = 0;
-
-        while (trcLen < bufLen)
-        {
-            trcLen += AXP_Telnet_Trace(SENT, &buf[trcLen], (bufLen - trcLen));
-        }
+        last = (ses->outHead + ses->outLen - 1) % AXP_TELNET_OUT_LEN;
+        prompt = (ses->outBuf[last] == ' ') &&
+                 AXP_TELNET_PROMPT(
+                     ses->outBuf[(last + AXP_TELNET_OUT_LEN - 1) %
+                                 AXP_TELNET_OUT_LEN]);
     }
-    else
+    if (ses->outBlocked == true)
     {
-        buf[bufLen] = '\0';
+        ses->flushAt = 0;
     }
-    bufLen = send(ses->mySocket, buf, bufLen, 0);
-
-    /*
-     * If the sent length is less than or equal to zero, we assume the
-     * connection has been terminated for one reason or other (them or us).
-     */
-    if (bufLen <= 0)
+    else if ((ses->outLen >= AXP_TELNET_FLUSH_LEN) ||
+             (memchr(buf, LF, bufLen) != NULL) ||
+             (prompt == true))
     {
-        retVal = false;
+        retVal = AXP_Telnet_Flush(ses);
     }
-
-    if (AXP_UTL_CALL)
+    else if ((ses->flushAt == 0) && (ses->outLen > 0))
     {
-        AXP_TRACE_BEGIN();
-        AXP_TraceWrite("AXP_Telnet_Send returning, %s.",
-                       (retVal ? "Success" : "Failure"));
-        AXP_TRACE_END();
+        ses->flushAt = AXP_Telnet_Now() + AXP_TELNET_FLUSH_NSEC;
+        if ((_telnetWake >= 0) &&
+            (pthread_equal(pthread_self(), _telnetThread) == 0))
+        {
+            if (write(_telnetWake, &wakeCount, sizeof(wakeCount)) < 0)
+            {
+                wakeCount = 0;
+            }
+        }
     }
 
     /*
@@ -1399,67 +1496,75 @@ bool AXP_Telnet_Send(AXP_TELNET_SESSION *ses, u8 *buf, int bufLen)
 }
 
 /*
- * AXP_Telnet_Reject
- *  This function is called to close the connection with a TELNET client.  This
- *  does not close the socket used to receive connection requests.
+ * AXP_Telnet_Now
+ *  This function is called to get the current time, in nanoseconds, from the
+ *  monotonic clock.
  *
  * Input Parameters:
- *  ses:
- *      A pointer to the address of the TELNET session block..
+ *  None.
  *
  * Output Parameters:
  *  None.
  *
  * Return Values:
- *  true:   The TELNET socket has been closed.
- *  false:  Failure.
+ *  The current monotonic time in nanoseconds.
  */
-static bool AXP_Telnet_Reject(AXP_TELNET_SESSION **ses)
+static u64 AXP_Telnet_Now(void)
 {
-    bool retVal = true;
-
-    /*
-     * Close the socket.
-     */
-    close((*ses)->mySocket);
-
-    /*
-     * Return the block of memory back to the system.
-     */
-    AXP_Deallocate_Block(ses);
-    *ses = NULL;
-    printf("TELNET session has been closed...\n");
+    struct timespec now;
 
-    /*
-     * Return back to the caller.
-     */
-    return(retVal);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return(((u64) now.tv_sec * 1000000000ll) + (u64) now.tv_nsec);
 }
 
 /*
- * AXP_Telnet_Ignore
- *  This function is called to close the socket used to receive connection
- *  requests.
+ * AXP_Telnet_Timers
+ *  This function is called by the server before it waits, to send the output
+ *  of any session whose flush delay has expired, and to determine how long it
+ *  can wait before the next one expires.  A session that cannot be sent to is
+ *  marked inactive, and is cleaned up when its socket reports the error.
  *
  * Input Parameters:
- *  sock:
- *      The value of the socket to be closed.
+ *  None.
  *
  * Output Parameters:
  *  None.
  *
  * Return Values:
- *  true:   The Listener socket has been closed.
- *  false:  Failure.
+ *  -1:     There is no output waiting to be sent.
+ *  >=0:    The number of milliseconds until the next output is to be sent.
  */
-static bool AXP_Telnet_Ignore(int sock)
+static int AXP_Telnet_Timers(void)
 {
-    bool retVal = true;
+    AXP_TELNET_SESSION *ses;
+    u64 now = AXP_Telnet_Now();
+    u64 next = 0;
+    int retVal = -1;
+    int ii;
 
-    /*
-     * Close the socket.
-     */
-    close(sock);
+    for (ii = 0; ii < AXP_TELNET_MAX_SESSIONS; ii++)
+    {
+        ses = _telnetSessions[ii];
+        if ((ses == NULL) || (ses->flushAt == 0))
+        {
+            continue;
+        }
+        if (ses->flushAt <= now)
+        {
+            if (AXP_Telnet_Flush(ses) == false)
+            {
+                ses->state = Inactive;
+            }
+        }
+        else if ((next == 0) || (ses->flushAt < next))
+        {
+            next = ses->flushAt;
+        }
+    }
+    if (next != 0)
+    {
+        retVal = (int) ((next - now + 999999ll) / 1000000ll);
+    }
 
     /*
      * Return back to the caller.
@@ -1468,73 +1573,709 @@ static bool AXP_Telnet_Ignore(int sock)
 }
 
 /*
- * AXP_Telent_Processor
- *  This function is called with a socket, buffer, and buffer length.  The
- *  buffer contains one or more bytes of data that may contain one or more
- *  TELNET commands.  This function process through this data, and when
- *  necessary sends a response in kind.
+ * AXP_Telnet_Accept
+ *  This function is called when there are connection requests to accept.
+ *  Each accepted connection gets a session block and is added to the set of
+ *  sockets we are waiting on.  The first session is the one allowed to send
+ *  input to the console, any others are read-only mirrors.  If all the
+ *  sessions are in use, the connection is closed as soon as it is accepted.
  *
  * Input Parameters:
  *  sock:
- *      The value of the socket on which to send data, if necessary.
- *  buf:
- *      A location containing the data to be processed.
- *  bufLen:
- *      A value indicating the number of bytes in the buf parameter.
+ *      The value of the socket on which to accept connections.
  *
  * Output Parameters:
  *  None.
  *
  * Return Values:
- *  true:   The data has been processed.
- *  false:  Failure.
+ *  None.
  */
-static bool AXP_Telnet_Processor(AXP_TELNET_SESSION *ses, u8 *buf, u32 bufLen)
+static void AXP_Telnet_Accept(int sock)
 {
     AXP_SM_Args args;
-    bool retVal = true;
-    u32 trcLen = 0;
+    AXP_TELNET_SESSION *ses;
+    struct epoll_event event;
+    bool readOnly = false;
+    int newSock;
+    int slot;
     int ii;
 
-    /*
-     * At this point we want to perform some action.
-     */
-    ii = 0;
-    args.argc = 2;
-    args.argp[0] = (void *) ses;
-    while ((ii < bufLen) && (retVal == true))
+    while ((newSock = accept(sock, NULL, NULL)) >= 0)
     {
-        if (AXP_UTL_BUFF)
+        fcntl(newSock, F_SETFL, fcntl(newSock, F_GETFL, 0) | O_NONBLOCK);
+        fcntl(newSock, F_SETFD, FD_CLOEXEC);
+        slot = -1;
+        for (ii = 0; ii < AXP_TELNET_MAX_SESSIONS; ii++)
         {
-            AXP_TRACE_BEGIN();
-            if (ii == trcLen)
-            trcLen += AXP_Telnet_Trace(RCVD, &buf[trcLen], (bufLen - trcLen));
-            AXP_TRACE_END();
+            if (_telnetSessions[ii] == NULL)
+            {
+                if (slot < 0)
+                {
+                    slot = ii;
+                }
+            }
+            else if (_telnetSessions[ii]->readOnly == false)
+            {
+                readOnly = true;
+            }
+        }
+
+        /*
+         * Go allocate a block into which TELNET session information can be
+         * maintained throughout the life of the connection with the client.
+         */
+        ses = NULL;
+        if (slot >= 0)
+        {
+            ses = (AXP_TELNET_SESSION *) AXP_Allocate_Block(AXP_TELNET_SES_BLK);
         }
-        args.argp[1] = (void *) &buf[ii];
-        ses->rcvState = AXP_Execute_SM(&TN_Receive_SM,
-                                       AXP_RCV_ACTION(buf[ii]),
-                                       ses->rcvState,
-                                       &args);
-        if ((srvState != Negotiating) && (srvState != Active))
+        if (ses == NULL)
         {
-            retVal = false;
+            close(newSock);
+            printf("A TELNET connection has been rejected...\n");
+            continue;
+        }
+        ses->mySocket = newSock;
+        ses->state = Accept;
+        ses->readOnly = readOnly;
+        ses->slot = slot;
+        ses->events = EPOLLIN;
+        AXP_OPT_SET_PREF(ses->myOptions, TELOPT_ECHO);
+        AXP_OPT_SET_PREF(ses->myOptions, TELOPT_SGA);
+        AXP_OPT_SET_SUPP(ses->myOptions, TELOPT_TTYPE);
+        AXP_OPT_SET_SUPP(ses->myOptions, TELOPT_NEW_ENVIRON);
+        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_ECHO);
+        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_SGA);
+        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_NAWS);
+        AXP_OPT_SET_PREF(ses->theirOptions, TELOPT_LFLOW);
+        ses->rcvState = AXP_RCV_DATA;
+        args.argc = 1;
+        args.argp[0] = (void *) ses;
+        SubOpt_Clear(&args);
+        event.events = ses->events;
+        event.data.ptr = (void *) ses;
+        if (epoll_ctl(_telnetEpoll, EPOLL_CTL_ADD, newSock, &event) == 0)
+        {
+            _telnetSessions[slot] = ses;
+            printf("A %s TELNET connection has been accepted...\n",
+                   (readOnly ? "read-only" : "read-write"));
+            readOnly = true;
+        }
+        else
+        {
+            close(newSock);
+            AXP_Deallocate_Block(ses);
+            printf("Accepting a TELNET connection has failed...\n");
         }
-        ii++;
     }
 
     /*
      * Return back to the caller.
      */
-    return(retVal);
+    return;
 }
 
 /*
- * AXP_Telnet_Main
- *  This function is called to establish the listener socket, accept connection
- *  requests, one at a time, for a TELNET connection, receive data from the
- *  TELNET client, process it as necessary, occasionally send a response back,
- *  all until either the TELNET client goes away or we are shutting down.
+ * AXP_Telnet_Receive
+ *  This function is called to get the next message sent from the TELNET
+ *  client, without blocking.
+ *
+ * Input Parameters:
+ *  ses:
+ *      A pointer to the session variable used to maintain the TELNET session.
+ *  bufLen:
+ *      A pointer to a location indicating the number of bytes in the buf
+ *      parameter.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A location to receive the data received from the TELNET client.
+ *  bufLen:
+ *      A pointer to a location to receive the number of bytes being returned
+ *      in the buf parameter.  Zero is returned if there is nothing to receive
+ *      at this time.
+ *
+ * Return Values:
+ *  true:   The buf and bufLen parameters contain valid information.
+ *  false:  The connection has been terminated.
+ */
+static bool AXP_Telnet_Receive(AXP_TELNET_SESSION *ses, u8 *buf, u32 *bufLen)
+{
+    ssize_t rcvLen;
+    bool retVal = true;
+
+    /*
+     * Receive up to a buffers worth of data.  Since we are using a
+     * steam protocol, we only may receive part of a complete buffer.
+     */
+    do
+    {
+        rcvLen = recv(ses->mySocket, buf, *bufLen, MSG_DONTWAIT);
+    } while ((rcvLen < 0) && (errno == EINTR));
+
+    /*
+     * If the receive length is zero, or there was an error other than there
+     * being nothing to receive, we assume the connection has been terminated
+     * for one reason or other (them or us).
+     */
+    if (rcvLen > 0)
+    {
+        *bufLen = rcvLen;
+    }
+    else
+    {
+        *bufLen = 0;
+        if ((rcvLen == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)))
+        {
+            retVal = false;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Telnet_Queue
+ *  This function is called to queue data to be sent to a TELNET client.  Any
+ *  data that does not fit in the session's output buffer is dropped.
+ *
+ * Input Parameters:
+ *  ses:
+ *      A pointer to the session variable used to maintain the TELNET session.
+ *  buf:
+ *      A location containing the data to be sent to the TELNET client.
+ *  bufLen:
+ *      A value indicating the number of bytes in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Telnet_Queue(AXP_TELNET_SESSION *ses, u8 *buf, u32 bufLen)
+{
+    u32 tail;
+    u32 len;
+
+    if (bufLen > (AXP_TELNET_OUT_LEN - ses->outLen))
+    {
+        ses->outDropped += bufLen - (AXP_TELNET_OUT_LEN - ses->outLen);
+        bufLen = AXP_TELNET_OUT_LEN - ses->outLen;
+    }
+    while (bufLen > 0)
+    {
+        tail = (ses->outHead + ses->outLen) % AXP_TELNET_OUT_LEN;
+        len = AXP_TELNET_OUT_LEN - tail;
+        if (len > bufLen)
+        {
+            len = bufLen;
+        }
+        memcpy(&ses->outBuf[tail], buf, len);
+        ses->outLen += len;
+        buf += len;
+        bufLen -= len;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Send
+ *  This function is called to send data to the TELNET client.  The data is
+ *  queued for the session, and sent along with any other output queued for
+ *  it, as decided by AXP_Telnet_Coalesce.
+ *
+ * Input Parameters:
+ *  ses:
+ *      A pointer to the session variable used to maintain the TELNET session.
+ *  buf:
+ *      A location containing the data to be sent to the TELNET client.
+ *  bufLen:
+ *      A value indicating the number of bytes in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The data in the buf parameter was sent or queued.
+ *  false:  Failure.
+ */
+bool AXP_Telnet_Send(AXP_TELNET_SESSION *ses, u8 *buf, int bufLen)
+{
+    bool    retVal = true;
+
+    if (AXP_UTL_CALL)
+    {
+        AXP_TRACE_BEGIN();
+        AXP_TraceWrite("AXP_Telnet_Send called.");
+        AXP_TRACE_END();
+    }
+
+    /*
+     * If we are sending a TELNET command, and buffer tracing is turned on,
+     * trace it.
+     */
+    if (AXP_UTL_BUFF && TELCMD_OK(buf[0]))
+    {
+        u32 trcLen = 0;
+
+        AXP_TRACE_BEGIN();
+        while (trcLen < bufLen)
+        {
+            trcLen += AXP_Telnet_Trace(SENT, &buf[trcLen], (bufLen - trcLen));
+        }
+        AXP_TRACE_END();
+    }
+    AXP_Telnet_Queue(ses, buf, bufLen);
+    retVal = AXP_Telnet_Coalesce(ses, buf, bufLen);
+
+    if (AXP_UTL_CALL)
+    {
+        AXP_TRACE_BEGIN();
+        AXP_TraceWrite("AXP_Telnet_Send returning, %s.",
+                       (retVal ? "Success" : "Failure"));
+        AXP_TRACE_END();
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Telnet_Broadcast
+ *  This function is called to send console data to every session that has
+ *  completed negotiating.  Any IAC characters in the data are doubled, so
+ *  that the client does not interpret them as the start of a command.  The
+ *  caller must hold the server mutex.
+ *
+ * Input Parameters:
+ *  buf:
+ *      A location containing the data to be sent to the TELNET clients.
+ *  bufLen:
+ *      A value indicating the number of bytes in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Telnet_Broadcast(u8 *buf, u32 bufLen)
+{
+    AXP_TELNET_SESSION *ses;
+    u8 iac = IAC;
+    u32 start, ii;
+    int jj;
+
+    for (jj = 0; jj < AXP_TELNET_MAX_SESSIONS; jj++)
+    {
+        ses = _telnetSessions[jj];
+        if ((ses == NULL) || (ses->state != Active))
+        {
+            continue;
+        }
+        for (start = 0, ii = 0; ii < bufLen; ii++)
+        {
+            if (buf[ii] == IAC)
+            {
+                AXP_Telnet_Queue(ses, &buf[start], ii - start + 1);
+                AXP_Telnet_Queue(ses, &iac, 1);
+                start = ii + 1;
+            }
+        }
+        AXP_Telnet_Queue(ses, &buf[start], bufLen - start);
+        if (AXP_Telnet_Coalesce(ses, buf, bufLen) == false)
+        {
+            ses->state = Inactive;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Output
+ *  This function is called to send console output to all the TELNET clients.
+ *  It can be called from any thread.
+ *
+ * Input Parameters:
+ *  buf:
+ *      A location containing the data to be sent to the TELNET clients.
+ *  bufLen:
+ *      A value indicating the number of bytes in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Telnet_Output(u8 *buf, u32 bufLen)
+{
+    pthread_mutex_lock(&_telnetMutex);
+    AXP_Telnet_Broadcast(buf, bufLen);
+    pthread_mutex_unlock(&_telnetMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Push
+ *  This function is called, from any thread, to send all the output queued
+ *  for the TELNET clients now, rather than waiting for more.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Telnet_Push(void)
+{
+    AXP_TELNET_SESSION *ses;
+    int ii;
+
+    pthread_mutex_lock(&_telnetMutex);
+    for (ii = 0; ii < AXP_TELNET_MAX_SESSIONS; ii++)
+    {
+        ses = _telnetSessions[ii];
+        if ((ses != NULL) &&
+            (ses->outLen > 0) &&
+            (ses->outBlocked == false) &&
+            (AXP_Telnet_Flush(ses) == false))
+        {
+            ses->state = Inactive;
+        }
+    }
+    pthread_mutex_unlock(&_telnetMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_SetInput
+ *  This function is called to set the function that is called with the
+ *  characters received from the read-write TELNET session.
+ *
+ * Input Parameters:
+ *  inputRtn:
+ *      A pointer to the function to be called with the characters, or NULL.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Telnet_SetInput(void (*inputRtn)(u8 *, u32))
+{
+    pthread_mutex_lock(&_telnetMutex);
+    _telnetInput = inputRtn;
+    pthread_mutex_unlock(&_telnetMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_SetOutput
+ *  This function is called to set the function that is called to get the
+ *  console output to be sent to all the TELNET sessions.  It is called by the
+ *  server, after AXP_Telnet_Kick has been called, until it returns zero.
+ *
+ * Input Parameters:
+ *  outputRtn:
+ *      A pointer to the function to be called with a buffer and its size,
+ *      which returns the number of bytes of output put into the buffer, or
+ *      NULL.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Telnet_SetOutput(u32 (*outputRtn)(u8 *, u32))
+{
+    pthread_mutex_lock(&_telnetMutex);
+    _telnetOutput = outputRtn;
+    pthread_mutex_unlock(&_telnetMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Kick
+ *  This function is called, from any thread, to tell the TELNET server that
+ *  there is console output to be gotten from the output function.  It does
+ *  not take the server's mutex, it just wakes the server up.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_Telnet_Kick(void)
+{
+    u64 wakeCount = 1;
+    int wake = _telnetWake;
+
+    if (wake >= 0)
+    {
+        if (write(wake, &wakeCount, sizeof(wakeCount)) < 0)
+        {
+            wakeCount = 0;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Drain
+ *  This function is called by the server, with the mutex locked, to get the
+ *  console output from the output function and send it to all the sessions.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_Telnet_Drain(void)
+{
+    u8 buf[AXP_TELNET_MSG_LEN];
+    u32 len;
+
+    if (_telnetOutput != NULL)
+    {
+        while ((len = (*_telnetOutput)(buf, sizeof(buf))) > 0)
+        {
+            AXP_Telnet_Broadcast(buf, len);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Reject
+ *  This function is called to close the connection with a TELNET client.  This
+ *  does not close the socket used to receive connection requests.  If the
+ *  session was the read-write session, the oldest remaining session becomes
+ *  the read-write session.
+ *
+ * Input Parameters:
+ *  ses:
+ *      A pointer to the address of the TELNET session block..
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The TELNET socket has been closed.
+ *  false:  Failure.
+ */
+static bool AXP_Telnet_Reject(AXP_TELNET_SESSION **ses)
+{
+    bool retVal = true;
+    int ii;
+
+    /*
+     * Stop waiting on the socket and close it.
+     */
+    epoll_ctl(_telnetEpoll, EPOLL_CTL_DEL, (*ses)->mySocket, NULL);
+    close((*ses)->mySocket);
+    _telnetSessions[(*ses)->slot] = NULL;
+    if ((*ses)->readOnly == false)
+    {
+        for (ii = 0; ii < AXP_TELNET_MAX_SESSIONS; ii++)
+        {
+            if (_telnetSessions[ii] != NULL)
+            {
+                _telnetSessions[ii]->readOnly = false;
+                break;
+            }
+        }
+    }
+
+    /*
+     * Return the block of memory back to the system.
+     */
+    AXP_Deallocate_Block(*ses);
+    *ses = NULL;
+    printf("TELNET session has been closed...\n");
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Telnet_Ignore
+ *  This function is called to close the socket used to receive connection
+ *  requests.
+ *
+ * Input Parameters:
+ *  sock:
+ *      The value of the socket to be closed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The Listener socket has been closed.
+ *  false:  Failure.
+ */
+static bool AXP_Telnet_Ignore(int sock)
+{
+    bool retVal = true;
+
+    /*
+     * Close the socket.
+     */
+    if (sock >= 0)
+    {
+        close(sock);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Telent_Processor
+ *  This function is called with a socket, buffer, and buffer length.  The
+ *  buffer contains one or more bytes of data that may contain one or more
+ *  TELNET commands.  This function process through this data, and when
+ *  necessary sends a response in kind.
+ *
+ * Input Parameters:
+ *  sock:
+ *      The value of the socket on which to send data, if necessary.
+ *  buf:
+ *      A location containing the data to be processed.
+ *  bufLen:
+ *      A value indicating the number of bytes in the buf parameter.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The data has been processed.
+ *  false:  Failure.
+ */
+static bool AXP_Telnet_Processor(AXP_TELNET_SESSION *ses, u8 *buf, u32 bufLen)
+{
+    AXP_SM_Args args;
+    bool retVal = true;
+    u32 trcLen = 0;
+    u32 start;
+    u32 ii;
+
+    pthread_once(&TN_RcvOnce, AXP_Telnet_RcvInit);
+
+    /*
+     * At this point we want to perform some action.
+     */
+    ii = 0;
+    args.argc = 2;
+    args.argp[0] = (void *) ses;
+    while ((ii < bufLen) && (retVal == true))
+    {
+        if (AXP_UTL_BUFF)
+        {
+            AXP_TRACE_BEGIN();
+            while ((trcLen <= ii) && (trcLen < bufLen))
+            {
+                start = AXP_Telnet_Trace(RCVD,
+                                         &buf[trcLen],
+                                         (bufLen - trcLen));
+                trcLen += (start > 0) ? start : 1;
+            }
+            AXP_TRACE_END();
+        }
+
+        /*
+         * If we are in the data state, then hand on all the plain data up to
+         * the next byte that needs the state machine.
+         */
+        if ((ses->rcvState == AXP_RCV_DATA) && TN_RcvPlain[buf[ii]])
+        {
+            start = ii;
+            while ((ii < bufLen) && TN_RcvPlain[buf[ii]])
+            {
+                ii++;
+            }
+            AXP_Telnet_Echo(ses, &buf[start], ii - start);
+        }
+        else
+        {
+            args.argp[1] = (void *) &buf[ii];
+            ses->rcvState = AXP_Execute_SM(&TN_Receive_SM,
+                                           TN_RcvAction[buf[ii]],
+                                           ses->rcvState,
+                                           &args);
+            ii++;
+        }
+        if (ses->state == Inactive)
+        {
+            retVal = false;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Telnet_RcvInit
+ *  This function is called once, before any data is processed, to build the
+ *  receive action and plain data tables from the receive state machine.
  *
  * Input Parameters:
  *  None.
@@ -1545,127 +2286,342 @@ static bool AXP_Telnet_Processor(AXP_TELNET_SESSION *ses, u8 *buf, u32 bufLen)
  * Return Value:
  *  None.
  */
-void AXP_Telnet_Main(void)
+static void AXP_Telnet_RcvInit(void)
+{
+    AXP_StateMachine *sm = &TN_Receive_SM;
+    AXP_SM_Entry *entry;
+    int ii;
+
+    for (ii = 0; ii < 256; ii++)
+    {
+        TN_RcvAction[ii] = AXP_RCV_ACTION(ii);
+        entry = AXP_SM_ENTRY(sm, TN_RcvAction[ii], AXP_RCV_DATA);
+        TN_RcvPlain[ii] = (entry->nextState == AXP_RCV_DATA) &&
+                          (entry->actionRtn == Echo_Data);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Negotiate
+ *  This function is called to offer the options we prefer to the client.
+ *
+ * Input Parameters:
+ *  ses:
+ *      A pointer to the session variable used to maintain the TELNET session.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Telnet_Negotiate(AXP_TELNET_SESSION *ses)
 {
     AXP_SM_Args args;
+    int ii;
+
+    for (ii = 0; ii < NTELOPTS; ii++)
+    {
+        args.argc = 2;
+        args.argp[0] = (void *) ses;
+        args.argp[1] = (void *) &ii;
+        if (ses->myOptions[ii].preferred == true)
+        {
+            ses->myOptions[ii].state =
+                AXP_Execute_SM(&TN_Option_SM,
+                               AXP_OPT_ACTION(YES_SRV, ses->myOptions[ii]),
+                               ses->myOptions[ii].state,
+                               &args);
+        }
+        if (ses->theirOptions[ii].preferred == true)
+        {
+            ses->theirOptions[ii].state =
+                AXP_Execute_SM(&TN_Option_SM,
+                               AXP_OPT_ACTION(YES_CLI, ses->theirOptions[ii]),
+                               ses->theirOptions[ii].state,
+                               &args);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Session
+ *  This function is called when there are events on a session's socket.
+ *  Queued output is sent, and received data processed.  If the client does
+ *  not send us any options to be negotiated, then it probably is not a TELNET
+ *  client, so we do not offer ours until the client has sent something.
+ *
+ * Input Parameters:
+ *  ses:
+ *      A pointer to the session variable used to maintain the TELNET session.
+ *  events:
+ *      A value indicating the events that occurred on the socket.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Telnet_Session(AXP_TELNET_SESSION *ses, u32 events)
+{
     u8 buffer[AXP_TELNET_MSG_LEN];
-    u32 bufferLen;
+    u32 bufferLen = AXP_TELNET_MSG_LEN;
+    bool retVal = true;
+    int ii;
+
+    if ((events & EPOLLOUT) != 0)
+    {
+        retVal = AXP_Telnet_Flush(ses);
+    }
+
+    /*
+     * Receive what the client has sent, but only so much at a time, so that
+     * one client cannot keep the others from being serviced.
+     */
+    for (ii = 0;
+         ((ii < AXP_TELNET_RCV_BURST) &&
+          ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) &&
+          (bufferLen > 0) &&
+          (retVal == true));
+         ii++)
+    {
+        bufferLen = AXP_TELNET_MSG_LEN;
+        retVal = AXP_Telnet_Receive(ses, buffer, &bufferLen);
+        if ((retVal == true) && (bufferLen > 0))
+        {
+            if (ses->state == Accept)
+            {
+                ses->state = Negotiating;
+            }
+            retVal = AXP_Telnet_Processor(ses, buffer, bufferLen);
+            if ((retVal == true) && (ses->state == Negotiating))
+            {
+                AXP_Telnet_Negotiate(ses);
+
+                /*
+                 * One of the things that could have happened is that while
+                 * possibly sending to the client, the connection was reset or
+                 * terminated.  If this is the case, then the session state has
+                 * already been changed.  Otherwise, the next state is Active.
+                 */
+                if (ses->state == Negotiating)
+                {
+                    ses->state = Active;
+                }
+            }
+        }
+    }
+
+    /*
+     * Send the responses to what was received, all in one go.
+     */
+    if ((retVal == true) && (ses->outLen > 0) && (ses->outBlocked == false))
+    {
+        retVal = AXP_Telnet_Flush(ses);
+    }
+    if ((retVal == false) || (ses->state == Inactive))
+    {
+        AXP_Telnet_Reject(&ses);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Main
+ *  This function is called to run the TELNET server on the default port, and
+ *  accepting connections from any host.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_Telnet_Main(void)
+{
+    AXP_Telnet_Server(AXP_TELNET_DEFAULT_PORT, false);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Server
+ *  This function is called to establish the listener socket, accept connection
+ *  requests for TELNET connections, receive data from the TELNET clients,
+ *  process it as necessary, and send the queued responses and console output
+ *  back, all until we are shutting down.  All the sockets are non-blocking
+ *  and waited on together, so no one client can hold up the others.
+ *
+ * Input Parameters:
+ *  port:
+ *      A value indicating the port on which to listen.  If zero, any free port
+ *      is used, and can be found out by calling AXP_Telnet_Port.
+ *  loopbackOnly:
+ *      A value indicating that only connections from this host are accepted.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_Telnet_Server(u16 port, bool loopbackOnly)
+{
+    struct epoll_event event;
+    struct epoll_event events[AXP_TELNET_MAX_SESSIONS + 2];
+    AXP_TELNET_SESSION *ses;
+    u64 wakeCount;
     int connSock = -1;
+    int timeout;
+    int count;
     int ii;
-    AXP_TELNET_SESSION *ses = NULL;
     bool retVal = true;
 
     if (AXP_UTL_CALL)
     {
         AXP_TRACE_BEGIN();
-        AXP_TraceWrite("TELNET Server is starting on port %d...",
-                       AXP_TELNET_DEFAULT_PORT);
+        AXP_TraceWrite("TELNET Server is starting on port %d...", port);
         AXP_TRACE_END();
     }
 
+    pthread_mutex_lock(&_telnetMutex);
+    srvState = Listen;
+    _telnetPort = port;
+    _telnetLoopback = loopbackOnly;
+    _telnetThread = pthread_self();
     while(srvState != Finished)
     {
         switch(srvState)
         {
+
+            /*
+             * Create the listener, the epoll instance and the event used to
+             * wake us up to shut down, and start waiting on the listener and
+             * the wake up event.
+             */
             case Listen:
                 retVal = AXP_Telnet_Listener(&connSock);
-                srvState = retVal ? Accept : Closing;
-                break;
-
-            case Accept:
-                ses = AXP_Telnet_Accept(connSock);
-                if (ses != NULL)
+                if (retVal == true)
                 {
-
-                    /*
-                     * If the client does not send us any options to be
-                     * negotiated, then it probably is not a TELNET client.
-                     */
-                    bufferLen = AXP_TELNET_MSG_LEN;
-                    retVal = AXP_Telnet_Receive(ses, buffer, &bufferLen);
-                    srvState = retVal ? Negotiating : Listen;
-                    if (retVal == true)
-                    {
-                        retVal = AXP_Telnet_Processor(ses, buffer, bufferLen);
-                        if (retVal == false)
-                        {
-                            srvState = Listen;
-                        }
-                    }
+                    _telnetEpoll = epoll_create1(EPOLL_CLOEXEC);
+                    _telnetWake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                    retVal = (_telnetEpoll >= 0) && (_telnetWake >= 0);
                 }
-                else
+                if (retVal == true)
                 {
-                    srvState = Listen;
+                    event.events = EPOLLIN;
+                    event.data.ptr = (void *) &_telnetListen;
+                    retVal = epoll_ctl(_telnetEpoll,
+                                       EPOLL_CTL_ADD,
+                                       connSock,
+                                       &event) == 0;
                 }
-                break;
-
-            case Negotiating:
-                for (ii = 0; ii < NTELOPTS; ii++)
+                if (retVal == true)
                 {
-                    args.argc = 2;
-                    args.argp[0] = (void *) ses;
-                    args.argp[1] = (void *) &ii;
-                    if (ses->myOptions[ii].preferred == true)
-                    {
-                        ses->myOptions[ii].state =
-                            AXP_Execute_SM(&TN_Option_SM,
-                                           AXP_OPT_ACTION(YES_SRV, ses->myOptions[ii]),
-                                           ses->myOptions[ii].state,
-                                           &args);
-                    }
-                    if (ses->theirOptions[ii].preferred == true)
-                    {
-                        ses->theirOptions[ii].state =
-                            AXP_Execute_SM(&TN_Option_SM,
-                                           AXP_OPT_ACTION(YES_CLI, ses->theirOptions[ii]),
-                                           ses->theirOptions[ii].state,
-                                           &args);
-                    }
+                    event.events = EPOLLIN;
+                    event.data.ptr = (void *) &_telnetWake;
+                    retVal = epoll_ctl(_telnetEpoll,
+                                       EPOLL_CTL_ADD,
+                                       _telnetWake,
+                                       &event) == 0;
                 }
-
-                /*
-                 * One of the things that could have happened is that while
-                 * possibly sending to the client, the connection was reset or
-                 * terminated.  If this is the case, then the server state has
-                 * already been changed.  Otherwise, the next state is Active.
-                 */
-                if (srvState == Negotiating)
+                _telnetListen = connSock;
+                if (srvState == Listen)
+                {
+                    srvState = retVal ? Accept : Closing;
+                }
+                if (srvState == Accept)
                 {
-                    srvState = Active;
+                    printf("Ready to accept TELNET connections on port "
+                           "%u...\n",
+                           _telnetPort);
+                    AXP_Telnet_Drain();
                 }
                 break;
 
-            case Active:
-                while (srvState == Active)
+            /*
+             * Send any output whose flush delay has expired, wait for
+             * something to happen or the next delay to expire, and then deal
+             * with it.  The mutex is not held while waiting, so that console
+             * output can be queued from other threads.
+             */
+            case Accept:
+                timeout = AXP_Telnet_Timers();
+                pthread_mutex_unlock(&_telnetMutex);
+                count = epoll_wait(_telnetEpoll,
+                                   events,
+                                   AXP_TELNET_MAX_SESSIONS + 2,
+                                   timeout);
+                pthread_mutex_lock(&_telnetMutex);
+                for (ii = 0; ii < count; ii++)
                 {
-                    bufferLen = AXP_TELNET_MSG_LEN;
-                    retVal = AXP_Telnet_Receive(ses, buffer, &bufferLen);
-                    if (retVal == true)
+                    if (events[ii].data.ptr == (void *) &_telnetListen)
+                    {
+                        AXP_Telnet_Accept(connSock);
+                    }
+                    else if (events[ii].data.ptr == (void *) &_telnetWake)
                     {
-                        retVal = AXP_Telnet_Processor(ses, buffer, bufferLen);
+                        while (read(_telnetWake,
+                                    &wakeCount,
+                                    sizeof(wakeCount)) > 0);
+                        AXP_Telnet_Drain();
                     }
-                    if (retVal == false)
+                    else
                     {
-                        srvState = Inactive;
+                        AXP_Telnet_Session(
+                            (AXP_TELNET_SESSION *) events[ii].data.ptr,
+                            events[ii].events);
                     }
                 }
                 break;
 
-            case Inactive:
-                retVal = AXP_Telnet_Reject(&ses);
-                ses = NULL;
-                srvState = Listen;
-                break;
-
+            /*
+             * Close all the sessions and everything else we were waiting on.
+             */
             case Closing:
+                for (ii = 0; ii < AXP_TELNET_MAX_SESSIONS; ii++)
+                {
+                    ses = _telnetSessions[ii];
+                    if (ses != NULL)
+                    {
+                        AXP_Telnet_Flush(ses);
+                        AXP_Telnet_Reject(&ses);
+                    }
+                }
                 retVal = AXP_Telnet_Ignore(connSock);
+                AXP_Telnet_Ignore(_telnetWake);
+                AXP_Telnet_Ignore(_telnetEpoll);
+                _telnetListen = _telnetWake = _telnetEpoll = -1;
                 srvState = Finished;
                 break;
 
-            case Finished:
+            default:
+                srvState = Closing;
                 break;
         }
     }
+    pthread_mutex_unlock(&_telnetMutex);
 
     if (AXP_UTL_CALL)
     {
@@ -1679,3 +2635,72 @@ void AXP_Telnet_Main(void)
      */
     return;
 }
+
+/*
+ * AXP_Telnet_Shutdown
+ *  This function is called, from any thread, to have the TELNET server close
+ *  all the sessions and return.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_Telnet_Shutdown(void)
+{
+    u64 wakeCount = 1;
+
+    pthread_mutex_lock(&_telnetMutex);
+    if ((srvState == Listen) || (srvState == Accept))
+    {
+        srvState = Closing;
+        if (_telnetWake >= 0)
+        {
+            if (write(_telnetWake, &wakeCount, sizeof(wakeCount)) < 0)
+            {
+                wakeCount = 0;
+            }
+        }
+    }
+    pthread_mutex_unlock(&_telnetMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Telnet_Port
+ *  This function is called to get the port the TELNET server is listening on.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  0:      The server is not accepting connections.
+ *  >0:     The port on which connections are being accepted.
+ */
+u16 AXP_Telnet_Port(void)
+{
+    u16 retVal = 0;
+
+    pthread_mutex_lock(&_telnetMutex);
+    if (srvState == Accept)
+    {
+        retVal = _telnetPort;
+    }
+    pthread_mutex_unlock(&_telnetMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
@@ -102,16 +102,22 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.006 19-Oct-2026 Jonathan D. Belanger
+ *  The periodic, alarm, and update timers are now event timers on the shared
+ *  timer wheel, rather than POSIX timers each delivering through a thread of
+ *  their own.  The timers coalesce, so a tick the guest has not acknowledged,
+ *  by reading Control Register C, is not delivered again.
+ *
+ *  V01.007 19-Oct-2026 Jonathan D. Belanger
+ *  The time of day comes from the timer wheel, so that it follows the virtual
+ *  clock when the emulation is running in virtual time.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
 #include "CommonUtilities/AXP_Trace.h"
+#include "CommonUtilities/AXP_TimerWheel.h"
 #include "Devices/TOYClock/AXP_DS12887A_TOYClock.h"
-#if defined(linux)
-    #include <signal.h>
-#else
-    #include <cygwin/signal.h>
-#endif
 /*
  * The RAM array contains 128 bytes to store date, time, and general
  * information.  The array is declared as signed bytes here, but the structure
@@ -169,9 +175,9 @@ static pthread_mutex_t rtcMutex = PTHREAD_MUTEX_INITIALIZER;
  *
  * The periodic interrupt will be trigger every certain number of milliseconds.
  */
-static timer_t periodicTimer;
-static timer_t alarmTimer;
-static timer_t updateTimer;
+static AXP_TIMER periodicTimer;
+static AXP_TIMER alarmTimer;
+static AXP_TIMER updateTimer;
 static bool timersArmed = false;
 
 /*
@@ -188,7 +194,7 @@ static u64 irqMask = 0;
  */
 static int AXP_DS12887A_DST(u8, u8, u8, u8, u8, u8);
 static void AXP_DS12887A_Normalize(struct tm *, bool);
-void AXP_DS12887A_Notify(sigval_t);
+static void AXP_DS12887A_Notify(void *, u32);
 static void AXP_DS12887A_StartTimers(bool);
 static void AXP_DS12887A_StopTimers(void);
 static void AXP_DS12887A_Initialize(void);
@@ -518,11 +524,15 @@ static void AXP_DS12887A_CheckIRQF(void)
 
 /*
  * AXP_DS12887A_Notify
- *  This function is called when one of the timers triggers.
+ *  This function is called on the timer thread when one of the timers
+ *  triggers.
  *
  * Input Parameters:
- *  sv:
+ *  arg:
  *      A value indicating the timer that was just triggered.
+ *  count:
+ *      A value indicating the number of times the timer triggered since the
+ *      guest last read Control Register C.  Not used.
  *
  * Output Parameters:
  *  None.
@@ -530,7 +540,7 @@ static void AXP_DS12887A_CheckIRQF(void)
  * Return Results:
  *  None.
  */
-void AXP_DS12887A_Notify(sigval_t sv)
+static void AXP_DS12887A_Notify(void *arg, u32 count)
 {
     AXP_DS12887A_LOCK;
 
@@ -544,7 +554,7 @@ void AXP_DS12887A_Notify(sigval_t sv)
         /*
         * Set the appropriate interrupt flag.
         */
-        switch (sv.sival_int)
+        switch ((int) (intptr_t) arg)
         {
             case AXP_DS12887A_TIMER_PERIOD:
                 ctrlC->pf = 1; /* always assume the period expired */
@@ -607,8 +617,8 @@ void AXP_DS12887A_Notify(sigval_t sv)
  */
 static void AXP_DS12887A_StartTimers(bool all)
 {
-    struct itimerspec ts;
-    int flag = 0;
+    u64 alarmDelay = 0;
+    u64 alarmPeriod = 0;
     u64 periods[] =
     {
         0,
@@ -649,11 +659,9 @@ static void AXP_DS12887A_StartTimers(bool all)
                            periods[ctrlA->rs]);
             AXP_TRACE_END();
         }
-        ts.it_interval.tv_nsec = periods[ctrlA->rs];
-        ts.it_interval.tv_sec = 0;
-        ts.it_value.tv_nsec = periods[ctrlA->rs];
-        ts.it_value.tv_sec = 0;
-        timer_settime(periodicTimer, 0, &ts, NULL);
+        AXP_TimerStart(&periodicTimer,
+                       periods[ctrlA->rs],
+                       periods[ctrlA->rs]);
         timersArmed = true;
     }
 
@@ -687,16 +695,12 @@ static void AXP_DS12887A_StartTimers(bool all)
      * So based on the above description, if all three alarm registers are
      * don't care values, then we trigger the timer every second.
      */
-    ts.it_interval.tv_nsec = 0;
-    ts.it_interval.tv_sec = 0;
-    ts.it_value.tv_nsec = 0;
-    ts.it_value.tv_sec = 0;
     if ((ram[AXP_ADDR_SecondsAlarm] > 59) &&
         (ram[AXP_ADDR_MinutesAlarm] > 59) &&
         (ram[AXP_ADDR_HoursAlarm] > 23))
     {
-        ts.it_interval.tv_sec = 1;  /* every 1 second */
-        ts.it_value.tv_sec = 1;     /* in 1 second */
+        alarmPeriod = AXP_TIMER_NSEC;       /* every 1 second */
+        alarmDelay = AXP_TIMER_NSEC;        /* in 1 second */
         if (AXP_SYS_OPT2)
         {
             AXP_TRACE_BEGIN();
@@ -712,8 +716,8 @@ static void AXP_DS12887A_StartTimers(bool all)
      */
     else if (ram[AXP_ADDR_MinutesAlarm] > 59)
     {
-        ts.it_interval.tv_sec = 60; /* every 1 minute */
-        ts.it_value.tv_sec = 60; /* in 1 minute */
+        alarmPeriod = 60 * AXP_TIMER_NSEC;  /* every 1 minute */
+        alarmDelay = 60 * AXP_TIMER_NSEC;   /* in 1 minute */
         if (AXP_SYS_OPT2)
         {
             AXP_TRACE_BEGIN();
@@ -729,8 +733,8 @@ static void AXP_DS12887A_StartTimers(bool all)
      */
     else if (ram[AXP_ADDR_HoursAlarm] > 23)
     {
-        ts.it_interval.tv_sec = 3600; /* every 1 hour */
-        ts.it_value.tv_sec = 3600; /* in 1 hour */
+        alarmPeriod = 3600 * AXP_TIMER_NSEC; /* every 1 hour */
+        alarmDelay = 3600 * AXP_TIMER_NSEC;  /* in 1 hour */
         if (AXP_SYS_OPT2)
         {
             AXP_TRACE_BEGIN();
@@ -747,9 +751,9 @@ static void AXP_DS12887A_StartTimers(bool all)
     else if (ram[AXP_ADDR_SecondsAlarm] <= 59)
     {
         struct tm gmt, nextA;
-        time_t now;
+        time_t now, next;
 
-        now = time(NULL);
+        now = AXP_TimerTime();
         gmtime_r(&now, &gmt);
         nextA.tm_sec = gmt.tm_sec - ram[AXP_ADDR_SecondsAlarm];
         nextA.tm_min = gmt.tm_min - ram[AXP_ADDR_MinutesAlarm];
@@ -783,23 +787,27 @@ static void AXP_DS12887A_StartTimers(bool all)
         }
 
         /*
-        * Normalize the time, then get the absolute time for the next trigger.
+        * Normalize the time, then get how long it is until the next trigger.
+        * Both times are converted the same way, so the difference is right.
         */
         AXP_DS12887A_Normalize(&nextA, false);
-        ts.it_value.tv_sec = mktime(&nextA);
-        flag = TIMER_ABSTIME;
+        next = mktime(&nextA);
+        now = mktime(&gmt);
+        alarmDelay = (next > now) ?
+                     (u64) (next - now) * AXP_TIMER_NSEC :
+                     AXP_TIMER_NSEC;
         if (AXP_SYS_OPT2)
         {
             AXP_TRACE_BEGIN();
             AXP_TraceWrite("AXP_DS12887A_StartTimers Alarm Timer Started "
-                           "at %d seconds",
-                           ts.it_value.tv_sec);
+                           "in %ld seconds",
+                           (long) (next - now));
             AXP_TRACE_END();
         }
     }
-    if (ts.it_value.tv_sec != 0)
+    if (alarmDelay != 0)
     {
-        timer_settime(alarmTimer, flag, &ts, NULL);
+        AXP_TimerStart(&alarmTimer, alarmDelay, alarmPeriod);
         timersArmed = true;
     }
 
@@ -815,11 +823,7 @@ static void AXP_DS12887A_StartTimers(bool all)
                            "1 seconds.");
             AXP_TRACE_END();
         }
-        ts.it_interval.tv_nsec = 0;
-        ts.it_interval.tv_sec = 1;
-        ts.it_value.tv_nsec = 0;
-        ts.it_value.tv_sec = 1;
-        timer_settime(updateTimer, 0, &ts, NULL);
+        AXP_TimerStart(&updateTimer, AXP_TIMER_NSEC, AXP_TIMER_NSEC);
         timersArmed = true;
     }
 
@@ -858,8 +862,6 @@ static void AXP_DS12887A_StartTimers(bool all)
  */
 static void AXP_DS12887A_StopTimers(void)
 {
-    struct itimerspec ts;
-
     if (timersArmed == true)
     {
         if (AXP_SYS_OPT2)
@@ -869,20 +871,12 @@ static void AXP_DS12887A_StopTimers(void)
             AXP_TRACE_END();
         }
 
-        /*
-        * Set the timer specification to all zeros, which will disarm the timer.
-        */
-        ts.it_interval.tv_nsec = 0;
-        ts.it_interval.tv_sec = 0;
-        ts.it_value.tv_nsec = 0;
-        ts.it_value.tv_sec = 0;
-
         /*
         * Disarm all the timers.
         */
-        timer_settime(periodicTimer, 0, &ts, NULL);
-        timer_settime(alarmTimer, 0, &ts, NULL);
-        timer_settime(updateTimer, 0, &ts, NULL);
+        AXP_TimerStop(&periodicTimer);
+        AXP_TimerStop(&alarmTimer);
+        AXP_TimerStop(&updateTimer);
         timersArmed = false;
 
         if (AXP_SYS_OPT2)
@@ -920,7 +914,6 @@ static void AXP_DS12887A_StopTimers(void)
  */
 static void AXP_DS12887A_Initialize(void)
 {
-    sigevent_t se;
     int ii;
 
     /*
@@ -952,24 +945,22 @@ static void AXP_DS12887A_Initialize(void)
     ctrlD->vrt = 1; /* RAM and Time Valid */
 
     /*
-     * Let's get all the timers created.
-     *
-     * Set the sigevent structure to cause the signal to be delivered by
-     * creating a new thread.  The sigev_value will be used to indicate which
-     * timer was triggered.
+     * Let's get all the timers created.  The argument passed to the callback
+     * indicates which timer was triggered.  A tick is not delivered again
+     * until the guest has read Control Register C.
      */
-    se.sigev_notify = SIGEV_THREAD;
-    se.sigev_notify_function = &AXP_DS12887A_Notify;
-    se.sigev_notify_attributes = NULL;
-
-    se.sigev_value.sival_int = AXP_DS12887A_TIMER_PERIOD;
-    timer_create(CLOCK_REALTIME, &se, &periodicTimer);
-
-    se.sigev_value.sival_int = AXP_DS12887A_TIMER_ALARM;
-    timer_create(CLOCK_REALTIME, &se, &alarmTimer);
-
-    se.sigev_value.sival_int = AXP_DS12887A_TIMER_UPDATE;
-    timer_create(CLOCK_REALTIME, &se, &updateTimer);
+    AXP_TimerInit(&periodicTimer,
+                  AXP_DS12887A_Notify,
+                  (void *) AXP_DS12887A_TIMER_PERIOD,
+                  true);
+    AXP_TimerInit(&alarmTimer,
+                  AXP_DS12887A_Notify,
+                  (void *) AXP_DS12887A_TIMER_ALARM,
+                  true);
+    AXP_TimerInit(&updateTimer,
+                  AXP_DS12887A_Notify,
+                  (void *) AXP_DS12887A_TIMER_UPDATE,
+                  true);
 
     /*
      * Indicate that we should not be called again.
@@ -1400,7 +1391,7 @@ void AXP_DS12887A_Write(u8 addr, u8 value)
                 if (updVal.set == 1)
                 {
                     AXP_DS12887A_StopTimers();
-                    now = time(NULL);
+                    now = AXP_TimerTime();
                     gmtime_r(&now, &currentTime);
                 }
             }
@@ -1556,7 +1547,7 @@ void AXP_DS12887A_Read(u8 addr, u8 *value)
      *
      * Step 1:
      */
-    now = time(NULL);
+    now = AXP_TimerTime();
     gmtime_r(&now, &currentTime);
 
     /*
@@ -1786,6 +1777,9 @@ void AXP_DS12887A_Read(u8 addr, u8 *value)
         case AXP_ADDR_ControlC:
             *value = ctrlC->value & AXP_MASK_ControlC;
             ctrlC->value = 0; /* This register is cleared upon reading */
+            AXP_TimerAck(&periodicTimer);
+            AXP_TimerAck(&alarmTimer);
+            AXP_TimerAck(&updateTimer);
             break;
 
         case AXP_ADDR_ControlD:
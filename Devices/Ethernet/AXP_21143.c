@@ -0,0 +1,1804 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains the code for the DEC 21143 Ethernet controller.  The
+ *  CPU reads and writes the PCI configuration space and the CSRs, and a
+ *  thread for each 21143 processes the transmit and receive descriptor rings,
+ *  DMAing the descriptors and the buffers they point to through the PCI bus
+ *  the 21143 is on.  Frames are exchanged with the Ethernet handle through its
+ *  frame queues.
+ *
+ *  The thread is woken up by a poll demand, a change to the operation mode,
+ *  or by the Ethernet handle when it has received frames.  Each time it is
+ *  woken up, it processes up to a batch of descriptors in each direction, and
+ *  then looks at the interrupts once for the whole batch.  With interrupt
+ *  mitigation set up in CSR11, the receive and transmit interrupts are held
+ *  back until a number of frames have completed or a timer runs out, so the
+ *  guest takes one interrupt for many frames.
+ *
+ *  The serial ROM, MII management interface, and SIA are not modeled.  The
+ *  link is always reported as being up.
+ *
+ * Revision History:
+ *
+ *  V01.000	19-Oct-2026	Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  DMA through the function given to us for the PCI bus, without the mutex
+ *  held, rather than directly to and from guest physical memory.  Fill in a
+ *  PCI device, so the 21143 can be registered with a Pchip.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_Configure.h"
+#include "CommonUtilities/AXP_Blocks.h"
+#include "Devices/Ethernet/AXP_21143.h"
+
+/*
+ * Local Prototypes
+ */
+static u64 AXP_21143_Now(void);
+static bool AXP_21143_Dma(AXP_21143 *, u64, void *, u32, bool);
+static bool AXP_21143_DmaRead(AXP_21143 *, u64, void *, u32);
+static bool AXP_21143_DmaWrite(AXP_21143 *, u64, void *, u32);
+static bool AXP_21143_ReadDesc(AXP_21143 *, u64, u32 *);
+static bool AXP_21143_WriteStatus(AXP_21143 *, u64, u32);
+static u64 AXP_21143_Next(AXP_21143 *, u64, u32 *, u32);
+static void AXP_21143_Fatal(AXP_21143 *);
+static void AXP_21143_Reset(AXP_21143 *);
+static void AXP_21143_Flush(AXP_21143 *);
+static u32 AXP_21143_Crc(u8 *, u32);
+static void AXP_21143_Setup(AXP_21143 *, u8 *, bool);
+static bool AXP_21143_Accept(AXP_21143 *, AXP_ETH_FRAME *);
+static void AXP_21143_Transmit(AXP_21143 *);
+static bool AXP_21143_Scatter(AXP_21143 *);
+static void AXP_21143_Receive(AXP_21143 *);
+static u32 AXP_21143_Mitigate(u32, u32, u32, u32 *, u64 *, u64, u64);
+static void AXP_21143_Timers(AXP_21143 *);
+static void AXP_21143_Update(AXP_21143 *);
+static void AXP_21143_Signal(AXP_21143 *);
+static void AXP_21143_Notify(void *);
+static void *AXP_21143_Main(void *);
+static u64 AXP_21143_PCIRead(void *, u32, u64, u32);
+static void AXP_21143_PCIWrite(void *, u32, u64, u64, u32);
+
+/*
+ * AXP_21143_Now
+ *  This function is called to get the current time, in nanoseconds, from the
+ *  monotonic clock used for the timers.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The current time in nanoseconds.
+ */
+static u64 AXP_21143_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(((u64) now.tv_sec * AXP_21143_NSEC) + now.tv_nsec);
+}
+
+/*
+ * AXP_21143_Dma
+ *  This function is called, with the mutex held, to DMA to or from guest
+ *  memory through the PCI bus.  The mutex is released during the DMA, which
+ *  waits for the bus, so that the bus can get to the CSRs in the meantime.
+ *  If the rings were reset, moved, or stopped before or during the DMA, it is
+ *  given up on.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 doing the DMA.
+ *  addr:
+ *      A value indicating the PCI address to be read or written.
+ *  buf:
+ *      A pointer to the data to be written, or the buffer to receive the data
+ *      read.
+ *  len:
+ *      A value indicating the number of bytes to be read or written.
+ *  write:
+ *      A boolean indicating whether guest memory is to be written.
+ *
+ * Output Parameters:
+ *  buf:
+ *      The data read.
+ *
+ * Return Values:
+ *  true:   The data was read or written.
+ *  false:  The address could not be accessed, or the DMA was given up on.
+ */
+static bool AXP_21143_Dma(AXP_21143 *nic,
+                          u64 addr,
+                          void *buf,
+                          u32 len,
+                          bool write)
+{
+    bool retVal = nic->gen == nic->dmaGen;
+
+    if (retVal == true)
+    {
+        pthread_mutex_unlock(&nic->mutex);
+        retVal = (*nic->dma)(nic->dmaArg, addr, (u8 *) buf, len, write);
+        pthread_mutex_lock(&nic->mutex);
+        retVal = retVal && (nic->gen == nic->dmaGen);
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_DmaRead
+ *  This function is called to read from guest memory.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 doing the read.
+ *  addr:
+ *      A value indicating the physical address to be read.
+ *  buf:
+ *      A pointer to the buffer to receive the data read.
+ *  len:
+ *      A value indicating the number of bytes to be read.
+ *
+ * Output Parameters:
+ *  buf:
+ *      The data read.
+ *
+ * Return Values:
+ *  true:   The data was read.
+ *  false:  The address could not be read, or the read was given up on.
+ */
+static bool AXP_21143_DmaRead(AXP_21143 *nic, u64 addr, void *buf, u32 len)
+{
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(AXP_21143_Dma(nic, addr, buf, len, false));
+}
+
+/*
+ * AXP_21143_DmaWrite
+ *  This function is called to write to guest memory.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 doing the write.
+ *  addr:
+ *      A value indicating the physical address to be written.
+ *  buf:
+ *      A pointer to the data to be written.
+ *  len:
+ *      A value indicating the number of bytes to be written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The data was written.
+ *  false:  The address could not be written, or the write was given up on.
+ */
+static bool AXP_21143_DmaWrite(AXP_21143 *nic, u64 addr, void *buf, u32 len)
+{
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(AXP_21143_Dma(nic, addr, buf, len, true));
+}
+
+/*
+ * AXP_21143_ReadDesc
+ *  This function is called to read a descriptor from guest memory.  The
+ *  first longword, which has the OWN bit, is read before the rest of the
+ *  descriptor, so that we see everything the guest wrote before giving the
+ *  descriptor to us.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 reading the descriptor.
+ *  addr:
+ *      A value indicating the physical address of the descriptor.
+ *
+ * Output Parameters:
+ *  desc:
+ *      A pointer to the 4 longwords to receive the descriptor.
+ *
+ * Return Values:
+ *  true:   The descriptor was read.
+ *  false:  The descriptor is not aligned or could not be read.
+ */
+static bool AXP_21143_ReadDesc(AXP_21143 *nic, u64 addr, u32 *desc)
+{
+    bool retVal = ((addr & 0x3) == 0) &&
+                  AXP_21143_DmaRead(nic, addr, &desc[0], sizeof(u32)) &&
+                  AXP_21143_DmaRead(nic,
+                                    addr + sizeof(u32),
+                                    &desc[1],
+                                    sizeof(u32) * 3);
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_WriteStatus
+ *  This function is called to write the first longword of a descriptor back
+ *  to guest memory, giving the descriptor back to the guest.  Everything
+ *  written to the buffers beforehand is seen by the guest before it sees the
+ *  OWN bit clear.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 writing the descriptor.
+ *  addr:
+ *      A value indicating the physical address of the descriptor, already
+ *      checked by AXP_21143_ReadDesc.
+ *  status:
+ *      A value for the first longword of the descriptor.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The status was written.
+ *  false:  The status could not be written, or the write was given up on.
+ */
+static bool AXP_21143_WriteStatus(AXP_21143 *nic, u64 addr, u32 status)
+{
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(AXP_21143_DmaWrite(nic, addr, &status, sizeof(u32)));
+}
+
+/*
+ * AXP_21143_Next
+ *  This function is called to determine the address of the descriptor
+ *  following the one just processed.  The end of ring bit takes precedence
+ *  over the chained bit.  Otherwise, descriptors follow one another,
+ *  separated by the skip length in CSR0.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 processing the descriptor.
+ *  addr:
+ *      A value indicating the physical address of the descriptor.
+ *  desc:
+ *      A pointer to the descriptor.
+ *  base:
+ *      A value indicating the list base address for the ring.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The physical address of the next descriptor.
+ */
+static u64 AXP_21143_Next(AXP_21143 *nic, u64 addr, u32 *desc, u32 base)
+{
+    u64 retVal;
+
+    if ((desc[1] & AXP_21143_ER) != 0)
+    {
+        retVal = base & ~0x3;
+    }
+    else if ((desc[1] & AXP_21143_CH) != 0)
+    {
+        retVal = desc[3] & ~0x3;
+    }
+    else
+    {
+        retVal = addr + AXP_21143_DESC_LEN +
+                 (((nic->csr[AXP_21143_CSR0] & AXP_21143_CSR0_DSL) >>
+                   AXP_21143_CSR0_DSL_SHIFT) * sizeof(u32));
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_Fatal
+ *  This function is called when a DMA fails.  It stops both processes and
+ *  reports a fatal bus error, unless the DMA was given up on because the rings
+ *  were reset, moved, or stopped, in which case there is nothing to report.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 that got the error.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Fatal(AXP_21143 *nic)
+{
+    if (nic->gen == nic->dmaGen)
+    {
+        nic->csr[AXP_21143_CSR5] |= AXP_21143_FBE;
+        nic->rxState = AXP_21143_STOPPED;
+        nic->txState = AXP_21143_STOPPED;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Reset
+ *  This function is called to put the CSRs and the receive and transmit
+ *  processes back into their power-up state.  The frames being received and
+ *  gathered for transmission are flushed by the 21143's thread, which may be
+ *  DMAing to or from them.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to be reset.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Reset(AXP_21143 *nic)
+{
+    memset(nic->csr, 0, sizeof(nic->csr));
+    nic->csr[AXP_21143_CSR0] = 0xfe000000;
+    nic->csr[AXP_21143_CSR3] = 0xfffffffc;
+    nic->csr[AXP_21143_CSR4] = 0xfffffffc;
+    nic->csr[AXP_21143_CSR5] = 0xf0000000;
+    nic->csr[AXP_21143_CSR6] = 0x32000040;
+    nic->csr[AXP_21143_CSR7] = 0xf3fe0000;
+    nic->csr[AXP_21143_CSR9] = 0xfff483ff;
+    nic->csr[AXP_21143_CSR11] = nic->mitigation;
+    nic->rxState = AXP_21143_STOPPED;
+    nic->txState = AXP_21143_STOPPED;
+    nic->rxDesc = nic->csr[AXP_21143_CSR3];
+    nic->txDesc = nic->csr[AXP_21143_CSR4];
+    nic->rxCount = nic->txCount = 0;
+    nic->rxTimer = nic->txTimer = nic->gpTimer = 0;
+    nic->missed = 0;
+    nic->flush = true;
+    nic->gen++;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Flush
+ *  This function is called by the 21143's thread, after a reset, to give the
+ *  frame being received back to the Ethernet handle, and throw away the one
+ *  being gathered for transmission, keeping its frame buffer.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 that was reset.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Flush(AXP_21143 *nic)
+{
+    if (nic->flush == true)
+    {
+        if (nic->rxFrame != NULL)
+        {
+            AXP_EthernetRxPut(nic->eth, nic->rxFrame);
+            nic->rxFrame = NULL;
+        }
+        if (nic->txFrame != NULL)
+        {
+            nic->txFrame->len = 0;
+        }
+        nic->flush = false;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Crc
+ *  This function is called to calculate the little-endian Ethernet CRC of a
+ *  multicast address.  The low 9 bits index the hash filter.
+ *
+ * Input Parameters:
+ *  data:
+ *      A pointer to the bytes to calculate the CRC over.
+ *  len:
+ *      A value indicating the number of bytes in data.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The CRC.
+ */
+static u32 AXP_21143_Crc(u8 *data, u32 len)
+{
+    u32 retVal = 0xffffffff;
+    u32 ii, jj;
+
+    for (ii = 0; ii < len; ii++)
+    {
+        retVal ^= data[ii];
+        for (jj = 0; jj < 8; jj++)
+        {
+            retVal = (retVal >> 1) ^ (((retVal & 1) != 0) ? 0xedb88320 : 0);
+        }
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_Setup
+ *  This function is called to load the address filter from a setup frame.
+ *  Every other pair of bytes in the frame is ignored, since only the low order
+ *  16 bits of each longword are used.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to load the address filter for.
+ *  setup:
+ *      A pointer to the setup frame, AXP_21143_SETUP_LEN bytes long.
+ *  hash:
+ *      A value indicating whether this is a hash table and one address,
+ *      instead of 16 addresses.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Setup(AXP_21143 *nic, u8 *setup, bool hash)
+{
+    u32 ii, jj;
+
+    nic->hashFilter = hash;
+    memset(nic->perfect, 0, sizeof(nic->perfect));
+    memset(nic->hash, 0, sizeof(nic->hash));
+    if (hash == true)
+    {
+        for (ii = 0; ii < (AXP_21143_HASH_BITS / 16); ii++)
+        {
+            nic->hash[ii * 2] = setup[ii * 4];
+            nic->hash[(ii * 2) + 1] = setup[(ii * 4) + 1];
+        }
+        for (jj = 0; jj < (AXP_MAC_ADDR_LEN / 2); jj++)
+        {
+            nic->perfect[0][jj * 2] =
+                setup[(AXP_21143_HASH_ADDR + jj) * 4];
+            nic->perfect[0][(jj * 2) + 1] =
+                setup[((AXP_21143_HASH_ADDR + jj) * 4) + 1];
+        }
+    }
+    else
+    {
+        for (ii = 0; ii < AXP_21143_PERFECT; ii++)
+        {
+            for (jj = 0; jj < (AXP_MAC_ADDR_LEN / 2); jj++)
+            {
+                nic->perfect[ii][jj * 2] = setup[((ii * 3) + jj) * 4];
+                nic->perfect[ii][(jj * 2) + 1] =
+                    setup[(((ii * 3) + jj) * 4) + 1];
+            }
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Accept
+ *  This function is called to determine whether a received frame passes the
+ *  address filter.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 that received the frame.
+ *  frame:
+ *      A pointer to the frame received.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The frame is to be received.
+ *  false:  The frame is to be discarded.
+ */
+static bool AXP_21143_Accept(AXP_21143 *nic, AXP_ETH_FRAME *frame)
+{
+    u8 *dest = frame->data;
+    u32 crc;
+    bool retVal = false;
+    int ii;
+
+    if (frame->len < (AXP_MAC_ADDR_LEN * 2))
+    {
+        retVal = false;
+    }
+    else if ((nic->csr[AXP_21143_CSR6] & AXP_21143_PR) != 0)
+    {
+        retVal = true;
+    }
+    else if (((dest[0] & 0x01) != 0) &&
+             ((nic->csr[AXP_21143_CSR6] & AXP_21143_PM) != 0))
+    {
+        retVal = true;
+    }
+    else if ((nic->hashFilter == true) && ((dest[0] & 0x01) != 0))
+    {
+        crc = AXP_21143_Crc(dest, AXP_MAC_ADDR_LEN) &
+              (AXP_21143_HASH_BITS - 1);
+        retVal = (nic->hash[crc / 8] & (1 << (crc % 8))) != 0;
+    }
+    else
+    {
+        for (ii = 0;
+             ((ii < AXP_21143_PERFECT) && (retVal == false));
+             ii++)
+        {
+            retVal = memcmp(dest, nic->perfect[ii], AXP_MAC_ADDR_LEN) == 0;
+            if (nic->hashFilter == true)
+            {
+                break;
+            }
+        }
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_Transmit
+ *  This function is called by the 21143's thread to process a batch of
+ *  transmit descriptors.  The buffers of each descriptor are gathered into a
+ *  frame buffer, which is queued to the Ethernet handle when the last segment
+ *  of the frame has been gathered.  Processing stops when a descriptor is
+ *  found that the 21143 does not own, or when the Ethernet handle has no
+ *  frame buffers free, in which case we try again shortly.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to transmit for.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Transmit(AXP_21143 *nic)
+{
+    u8 setup[AXP_21143_SETUP_LEN];
+    u32 desc[4];
+    u32 len[2];
+    u32 copy;
+    int ii, jj;
+
+    AXP_21143_Flush(nic);
+    nic->dmaGen = nic->gen;
+    nic->txWait = false;
+    for (ii = 0;
+         ((ii < AXP_21143_BATCH) && (nic->txState == AXP_21143_RUNNING));
+         ii++)
+    {
+        nic->txPoll = false;
+        if (AXP_21143_ReadDesc(nic, nic->txDesc, desc) == false)
+        {
+            AXP_21143_Fatal(nic);
+            break;
+        }
+
+        /*
+         * If there was a poll demand while we were reading the descriptor,
+         * the guest may have given it to us since, so we look again.
+         */
+        if ((desc[0] & AXP_21143_OWN) == 0)
+        {
+            if (nic->txPoll == false)
+            {
+                nic->txState = AXP_21143_TX_SUSPENDED;
+                nic->csr[AXP_21143_CSR5] |= AXP_21143_TU;
+            }
+            break;
+        }
+        len[0] = desc[1] & AXP_21143_BS_MASK;
+        len[1] = ((desc[1] & AXP_21143_CH) != 0) ?
+                 0 :
+                 (desc[1] >> AXP_21143_BS2_SHIFT) & AXP_21143_BS_MASK;
+        if ((desc[1] & AXP_21143_TDES1_SET) != 0)
+        {
+            memset(setup, 0, sizeof(setup));
+            copy = (len[0] < AXP_21143_SETUP_LEN) ?
+                   len[0] :
+                   AXP_21143_SETUP_LEN;
+            if (AXP_21143_DmaRead(nic, desc[2], setup, copy) == false)
+            {
+                AXP_21143_Fatal(nic);
+                break;
+            }
+            AXP_21143_Setup(nic,
+                            setup,
+                            (desc[1] & AXP_21143_TDES1_HP) != 0);
+        }
+        else
+        {
+
+            /*
+             * A frame is gathered into the frame buffer we got for it, and
+             * anything already gathered is thrown away when the first segment
+             * of another frame comes along.
+             */
+            if (nic->txFrame == NULL)
+            {
+                nic->txFrame = AXP_EthernetTxGet(nic->eth);
+                if (nic->txFrame == NULL)
+                {
+                    nic->txWait = true;
+                    break;
+                }
+                nic->txFrame->len = 0;
+            }
+            else if ((desc[1] & AXP_21143_TDES1_FS) != 0)
+            {
+                nic->txFrame->len = 0;
+            }
+            for (jj = 0; jj < 2; jj++)
+            {
+                copy = AXP_ETH_FRAME_LEN - nic->txFrame->len;
+                copy = (len[jj] < copy) ? len[jj] : copy;
+                if ((copy > 0) &&
+                    (AXP_21143_DmaRead(nic,
+                                       desc[2 + jj],
+                                       &nic->txFrame->data[nic->txFrame->len],
+                                       copy) == false))
+                {
+                    break;
+                }
+                nic->txFrame->len += copy;
+            }
+            if (jj < 2)
+            {
+                AXP_21143_Fatal(nic);
+                break;
+            }
+            if ((desc[1] & AXP_21143_TDES1_LS) != 0)
+            {
+                if ((nic->txFrame->len < AXP_21143_MIN_FRAME) &&
+                    ((desc[1] & AXP_21143_TDES1_DPD) == 0))
+                {
+                    memset(&nic->txFrame->data[nic->txFrame->len],
+                           0,
+                           AXP_21143_MIN_FRAME - nic->txFrame->len);
+                    nic->txFrame->len = AXP_21143_MIN_FRAME;
+                }
+                AXP_EthernetTxPut(nic->eth, nic->txFrame);
+                nic->txFrame = NULL;
+                nic->txFrames++;
+            }
+        }
+        if ((desc[1] & AXP_21143_TDES1_IC) != 0)
+        {
+            nic->txCount++;
+        }
+        if (AXP_21143_WriteStatus(nic, nic->txDesc, 0) == false)
+        {
+            AXP_21143_Fatal(nic);
+            break;
+        }
+        nic->txDesc = AXP_21143_Next(nic,
+                                     nic->txDesc,
+                                     desc,
+                                     nic->csr[AXP_21143_CSR4]);
+    }
+    if (ii == AXP_21143_BATCH)
+    {
+        nic->work = true;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Scatter
+ *  This function is called to copy the frame being received into the
+ *  buffers of as many receive descriptors as it takes.  The status of a
+ *  descriptor is not written until we know whether the frame continues into
+ *  the next one, so the last descriptor of the frame is always marked as such.
+ *  The frame length reported includes the CRC, for which there is space left
+ *  (zeroed) at the end of the data.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 receiving the frame.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The frame has been received, or discarded if it ran out of
+ *          descriptors part way through.
+ *  false:  There are no descriptors to receive into, memory could not be
+ *          accessed, or the rings were reset, moved, or stopped, and the
+ *          frame is kept for later.
+ */
+static bool AXP_21143_Scatter(AXP_21143 *nic)
+{
+    AXP_ETH_FRAME *frame = nic->rxFrame;
+    u64 addr = nic->rxDesc;
+    u64 prevAddr = 0;
+    u32 prevStatus = 0;
+    u32 total = frame->len + AXP_21143_CRC_LEN;
+    u32 offset = 0;
+    u32 desc[4];
+    u32 len[2];
+    u32 copy, status;
+    bool retVal = true;
+    bool prev = false;
+    int ii, jj;
+
+    memset(&frame->data[frame->len], 0, AXP_21143_CRC_LEN);
+    status = AXP_21143_RDES0_FS;
+    for (ii = 0; ii < AXP_21143_BATCH; ii++)
+    {
+        nic->rxPoll = false;
+        if (AXP_21143_ReadDesc(nic, addr, desc) == false)
+        {
+            AXP_21143_Fatal(nic);
+            retVal = prev;
+            break;
+        }
+        if ((desc[0] & AXP_21143_OWN) == 0)
+        {
+            if (nic->rxPoll == false)
+            {
+                nic->rxState = AXP_21143_SUSPENDED;
+                nic->csr[AXP_21143_CSR5] |= AXP_21143_RU;
+            }
+            retVal = prev;
+            break;
+        }
+
+        /*
+         * We own this descriptor, so the frame continues into it, and the
+         * previous one can be given back.
+         */
+        if ((prev == true) &&
+            (AXP_21143_WriteStatus(nic, prevAddr, prevStatus) == false))
+        {
+            AXP_21143_Fatal(nic);
+            retVal = prev = false;
+            break;
+        }
+        len[0] = desc[1] & AXP_21143_BS_MASK;
+        len[1] = ((desc[1] & AXP_21143_CH) != 0) ?
+                 0 :
+                 (desc[1] >> AXP_21143_BS2_SHIFT) & AXP_21143_BS_MASK;
+        for (jj = 0; jj < 2; jj++)
+        {
+            copy = total - offset;
+            copy = (len[jj] < copy) ? len[jj] : copy;
+            if ((copy > 0) &&
+                (AXP_21143_DmaWrite(nic,
+                                    desc[2 + jj],
+                                    &frame->data[offset],
+                                    copy) == false))
+            {
+                break;
+            }
+            offset += copy;
+        }
+        addr = AXP_21143_Next(nic, addr, desc, nic->csr[AXP_21143_CSR3]);
+        if (jj < 2)
+        {
+            AXP_21143_Fatal(nic);
+            break;
+        }
+        if (offset == total)
+        {
+            status |= AXP_21143_RDES0_LS | (total << AXP_21143_RDES0_FL_SHIFT);
+            if ((frame->data[0] & 0x01) != 0)
+            {
+                status |= AXP_21143_RDES0_MF;
+            }
+            if (((frame->data[12] << 8) | frame->data[13]) >= 0x0600)
+            {
+                status |= AXP_21143_RDES0_FT;
+            }
+            if (AXP_21143_WriteStatus(nic, nic->rxDesc, status) == false)
+            {
+                AXP_21143_Fatal(nic);
+                retVal = false;
+            }
+            else
+            {
+                nic->rxDesc = addr;
+            }
+            prev = false;
+            break;
+        }
+        prevAddr = nic->rxDesc;
+        prevStatus = status;
+        prev = true;
+        nic->rxDesc = addr;
+        status = 0;
+    }
+
+    /*
+     * If we ran out of descriptors part way through the frame, the rest of it
+     * is lost.  The last descriptor it was received into says so.  If the
+     * rings were reset, moved, or stopped, they are no longer ours to write.
+     */
+    if (nic->gen != nic->dmaGen)
+    {
+        retVal = false;
+    }
+    else if (prev == true)
+    {
+        AXP_21143_WriteStatus(nic,
+                              prevAddr,
+                              prevStatus |
+                              AXP_21143_RDES0_LS |
+                              AXP_21143_ES |
+                              AXP_21143_RDES0_DE |
+                              (offset << AXP_21143_RDES0_FL_SHIFT));
+        nic->missed++;
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_Receive
+ *  This function is called by the 21143's thread to receive a batch of the
+ *  frames queued by the Ethernet handle.  Frames that do not pass the address
+ *  filter are given straight back.  If there is no receive descriptor for a
+ *  frame, the frame is held until the guest gives us one and issues a receive
+ *  poll demand.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to receive for.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Receive(AXP_21143 *nic)
+{
+    int ii;
+
+    AXP_21143_Flush(nic);
+    nic->dmaGen = nic->gen;
+    for (ii = 0;
+         ((ii < AXP_21143_BATCH) && (nic->rxState == AXP_21143_RUNNING));
+         ii++)
+    {
+        if (nic->rxFrame == NULL)
+        {
+            nic->rxFrame = AXP_EthernetRxGet(nic->eth);
+            if (nic->rxFrame == NULL)
+            {
+                break;
+            }
+            if (nic->rxFrame->len > (AXP_ETH_FRAME_LEN - AXP_21143_CRC_LEN))
+            {
+                nic->rxFrame->len = AXP_ETH_FRAME_LEN - AXP_21143_CRC_LEN;
+            }
+            if (AXP_21143_Accept(nic, nic->rxFrame) == false)
+            {
+                AXP_EthernetRxPut(nic->eth, nic->rxFrame);
+                nic->rxFrame = NULL;
+                continue;
+            }
+        }
+        if (AXP_21143_Scatter(nic) == false)
+        {
+            break;
+        }
+        AXP_EthernetRxPut(nic->eth, nic->rxFrame);
+        nic->rxFrame = NULL;
+        nic->rxCount++;
+        nic->rxFrames++;
+    }
+    if (ii == AXP_21143_BATCH)
+    {
+        nic->work = true;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Mitigate
+ *  This function is called to determine whether the receive or transmit
+ *  interrupt, held back by interrupt mitigation, should now be reported.  It
+ *  is reported when the number of frames completed reaches the count, or the
+ *  timer, started with the first of them, runs out.  With neither a count nor
+ *  a timer, every frame is reported.
+ *
+ * Input Parameters:
+ *  bit:
+ *      A value indicating the status bit to be reported.
+ *  frames:
+ *      A value indicating the number of frames to wait for, or 0.
+ *  timer:
+ *      A value indicating the timer, in units of 16 cycles, or 0.
+ *  count:
+ *      A pointer to the number of frames completed and not yet reported.
+ *  expires:
+ *      A pointer to when the timer runs out, or 0 when it is not running.
+ *  now:
+ *      A value indicating the current time.
+ *  cycle:
+ *      A value indicating the length of a cycle, in nanoseconds.
+ *
+ * Output Parameters:
+ *  count:
+ *      Cleared when the interrupt is reported.
+ *  expires:
+ *      Started, or cleared when the interrupt is reported.
+ *
+ * Return Values:
+ *  0:      There is nothing to report yet.
+ *  bit:    The interrupt is to be reported.
+ */
+static u32 AXP_21143_Mitigate(u32 bit,
+                              u32 frames,
+                              u32 timer,
+                              u32 *count,
+                              u64 *expires,
+                              u64 now,
+                              u64 cycle)
+{
+    u32 retVal = 0;
+
+    if (*count > 0)
+    {
+        if (((frames == 0) && (timer == 0)) ||
+            ((frames != 0) && (*count >= frames)) ||
+            ((*expires != 0) && (now >= *expires)))
+        {
+            retVal = bit;
+        }
+        else if ((timer != 0) && (*expires == 0))
+        {
+            *expires = now + (timer * 16 * cycle);
+        }
+    }
+    if (retVal != 0)
+    {
+        *count = 0;
+        *expires = 0;
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_Timers
+ *  This function is called by the 21143's thread after each batch, to report
+ *  the receive and transmit interrupts held back by interrupt mitigation, and
+ *  the general-purpose timer.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to check the timers for.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Timers(AXP_21143 *nic)
+{
+    u32 csr11 = nic->csr[AXP_21143_CSR11];
+    u64 now = AXP_21143_Now();
+    u64 cycle = ((csr11 & AXP_21143_CS) != 0) ?
+                AXP_21143_CYCLE_CS_NS :
+                AXP_21143_CYCLE_NS;
+
+    nic->csr[AXP_21143_CSR5] |=
+        AXP_21143_Mitigate(AXP_21143_RI,
+                           (csr11 >> AXP_21143_NRP_SHIFT) & 0x7,
+                           (csr11 >> AXP_21143_RT_SHIFT) & 0xf,
+                           &nic->rxCount,
+                           &nic->rxTimer,
+                           now,
+                           cycle);
+    nic->csr[AXP_21143_CSR5] |=
+        AXP_21143_Mitigate(AXP_21143_TI,
+                           (csr11 >> AXP_21143_NTP_SHIFT) & 0x7,
+                           (csr11 >> AXP_21143_TT_SHIFT) & 0xf,
+                           &nic->txCount,
+                           &nic->txTimer,
+                           now,
+                           cycle);
+    if ((nic->gpTimer != 0) && (now >= nic->gpTimer))
+    {
+        nic->csr[AXP_21143_CSR5] |= AXP_21143_GTE;
+        nic->gpTimer = ((csr11 & AXP_21143_CON) != 0) ?
+                       now + ((csr11 & AXP_21143_TIMER) * cycle) :
+                       0;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Update
+ *  This function is called, with the mutex held, after anything that changes
+ *  CSR5 or CSR7, to update the interrupt summary bits and the interrupt line.
+ *  The line is signalled to the system, once the mutex has been released, by
+ *  AXP_21143_Signal.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to update.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Update(AXP_21143 *nic)
+{
+    u32 enabled = nic->csr[AXP_21143_CSR5] & nic->csr[AXP_21143_CSR7];
+    u32 csr5 = nic->csr[AXP_21143_CSR5] & ~(AXP_21143_NIS | AXP_21143_AIS);
+
+    if ((enabled & AXP_21143_NORMAL) != 0)
+    {
+        csr5 |= AXP_21143_NIS;
+    }
+    if ((enabled & AXP_21143_ABNORMAL) != 0)
+    {
+        csr5 |= AXP_21143_AIS;
+    }
+    nic->csr[AXP_21143_CSR5] = csr5;
+    __atomic_store_n(&nic->irq,
+                     (csr5 &
+                      nic->csr[AXP_21143_CSR7] &
+                      (AXP_21143_NIS | AXP_21143_AIS)) != 0,
+                     __ATOMIC_SEQ_CST);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Signal
+ *  This function is called, without the mutex held, to signal a change in the
+ *  interrupt line to the system.  The line is checked again after signalling
+ *  it, in case it changed while we were doing so.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 whose interrupt line is to be signalled.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Signal(AXP_21143 *nic)
+{
+    bool level;
+
+    do
+    {
+        level = __atomic_load_n(&nic->irq, __ATOMIC_SEQ_CST);
+        if (__atomic_exchange_n(&nic->signalled,
+                                level,
+                                __ATOMIC_SEQ_CST) != level)
+        {
+            if (level == true)
+            {
+                __atomic_add_fetch(&nic->interrupts, 1, __ATOMIC_RELAXED);
+            }
+            if (nic->interrupt != NULL)
+            {
+                (*nic->interrupt)(nic->intArg, level);
+            }
+        }
+    } while (level != __atomic_load_n(&nic->irq, __ATOMIC_SEQ_CST));
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Notify
+ *  This function is called by the thread servicing the Ethernet handle when it
+ *  has received frames, to wake up the 21143's thread.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the 21143 the frames were received for.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_Notify(void *arg)
+{
+    AXP_21143 *nic = (AXP_21143 *) arg;
+
+    pthread_mutex_lock(&nic->mutex);
+    nic->work = true;
+    pthread_cond_signal(&nic->cond);
+    pthread_mutex_unlock(&nic->mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Main
+ *  This is the main function for the 21143's thread.  It waits until there is
+ *  work to do or a timer runs out, and then processes a batch of transmit and
+ *  receive descriptors and updates the interrupt line, until it is stopped.
+ *
+ * Input Parameters:
+ *  voidPtr:
+ *      A pointer to the 21143 to be serviced.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL.
+ */
+static void *AXP_21143_Main(void *voidPtr)
+{
+    AXP_21143 *nic = (AXP_21143 *) voidPtr;
+    struct timespec abstime;
+    u64 deadline, timer;
+    int ii;
+
+    pthread_mutex_lock(&nic->mutex);
+    while (nic->running == true)
+    {
+        if (nic->work == false)
+        {
+
+            /*
+             * Wait for the earliest of the timers, or shortly if we are
+             * waiting for the Ethernet handle to transmit frames, otherwise
+             * until we are woken up.
+             */
+            deadline = (nic->txWait == true) ?
+                       AXP_21143_Now() + AXP_21143_TX_RETRY :
+                       0;
+            for (ii = 0; ii < 3; ii++)
+            {
+                timer = (ii == 0) ? nic->rxTimer :
+                        ((ii == 1) ? nic->txTimer : nic->gpTimer);
+                if ((timer != 0) && ((deadline == 0) || (timer < deadline)))
+                {
+                    deadline = timer;
+                }
+            }
+            if (deadline == 0)
+            {
+                pthread_cond_wait(&nic->cond, &nic->mutex);
+            }
+            else
+            {
+                abstime.tv_sec = deadline / AXP_21143_NSEC;
+                abstime.tv_nsec = deadline % AXP_21143_NSEC;
+                pthread_cond_timedwait(&nic->cond, &nic->mutex, &abstime);
+            }
+        }
+        nic->work = false;
+        AXP_21143_Transmit(nic);
+        AXP_21143_Receive(nic);
+        AXP_21143_Timers(nic);
+        AXP_21143_Update(nic);
+        pthread_mutex_unlock(&nic->mutex);
+        AXP_21143_Signal(nic);
+        pthread_mutex_lock(&nic->mutex);
+    }
+    pthread_mutex_unlock(&nic->mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return(NULL);
+}
+
+/*
+ * AXP_21143_PCIRead
+ *  This function is called by the PCI bus to read one of the 21143's CSRs.
+ *  Both the I/O and memory space BARs map the CSRs.
+ *
+ * Input Parameters:
+ *  ctx:
+ *      A pointer to the 21143 to be read.
+ *  bar:
+ *      A value indicating the BAR the read is through.
+ *  offset:
+ *      A value indicating the byte offset from the base address.
+ *  len:
+ *      A value indicating the length of the read, in bytes.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The value of the CSR.
+ */
+static u64 AXP_21143_PCIRead(void *ctx, u32 bar, u64 offset, u32 len)
+{
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(AXP_21143_ReadCSR((AXP_21143 *) ctx, (u32) offset));
+}
+
+/*
+ * AXP_21143_PCIWrite
+ *  This function is called by the PCI bus to write one of the 21143's CSRs.
+ *  Both the I/O and memory space BARs map the CSRs.
+ *
+ * Input Parameters:
+ *  ctx:
+ *      A pointer to the 21143 to be written.
+ *  bar:
+ *      A value indicating the BAR the write is through.
+ *  offset:
+ *      A value indicating the byte offset from the base address.
+ *  data:
+ *      A value to be written.
+ *  len:
+ *      A value indicating the length of the write, in bytes.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21143_PCIWrite(void *ctx,
+                               u32 bar,
+                               u64 offset,
+                               u64 data,
+                               u32 len)
+{
+    AXP_21143_WriteCSR((AXP_21143 *) ctx, (u32) offset, (u32) data);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_Init
+ *  This function is called to create a 21143, open the Ethernet device it is
+ *  attached to, and start the thread that processes its descriptor rings.
+ *  The PCI device in the 21143 is filled in, ready to be registered with the
+ *  Pchip for the bus it is on.  The bus has to be running for as long as the
+ *  21143 is, because the thread waits for it to do each DMA.
+ *
+ * Input Parameters:
+ *  name:
+ *      A pointer to the name of the Ethernet device to attach to.
+ *  cardNo:
+ *      A value indicating the card number, used for the MAC address.
+ *  dma:
+ *      A pointer to the function to be called to DMA to or from guest memory,
+ *      without the 21143's mutex held.
+ *  dmaArg:
+ *      A pointer to be passed to the DMA function.
+ *  interrupt:
+ *      A pointer to the function to be called when the interrupt line changes.
+ *  intArg:
+ *      A pointer to be passed to the interrupt function.
+ *  mitigation:
+ *      A value for the interrupt mitigation fields of CSR11, after a reset.
+ *      The guest can change them.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL:   The 21143 could not be created.
+ *  ~NULL:  A pointer to the 21143.
+ */
+AXP_21143 *AXP_21143_Init(char *name,
+                          u8 cardNo,
+                          bool (*dma)(void *, u64, u8 *, u32, bool),
+                          void *dmaArg,
+                          void (*interrupt)(void *, bool),
+                          void *intArg,
+                          u32 mitigation)
+{
+    AXP_21143 *retVal;
+    pthread_condattr_t condAttr;
+
+    retVal = AXP_Allocate_Block(-(i32) sizeof(AXP_21143), NULL);
+    if (retVal != NULL)
+    {
+        retVal->eth = AXP_EthernetOpen(name, cardNo);
+        if (retVal->eth == NULL)
+        {
+            AXP_Deallocate_Block(retVal);
+            retVal = NULL;
+        }
+    }
+    if (retVal != NULL)
+    {
+        retVal->dma = dma;
+        retVal->dmaArg = dmaArg;
+        retVal->interrupt = interrupt;
+        retVal->intArg = intArg;
+        retVal->mitigation = mitigation & ~AXP_21143_TIMER;
+        retVal->cfg[AXP_21143_CFID / 4] =
+            (AXP_21143_DEVICE << 16) | AXP_21143_VENDOR;
+        retVal->cfg[AXP_21143_CFCS / 4] = 0x02800000;
+        retVal->cfg[AXP_21143_CFRV / 4] =
+            (AXP_21143_CLASS << 8) | AXP_21143_REVISION;
+        retVal->cfg[AXP_21143_CBIO / 4] = 0x00000001;
+        retVal->cfg[AXP_21143_CFIT / 4] = 0x281401ff;
+        retVal->pci.cfg.vendorID = AXP_21143_VENDOR;
+        retVal->pci.cfg.deviceID = AXP_21143_DEVICE;
+        retVal->pci.cfg.revision = AXP_21143_REVISION;
+        retVal->pci.cfg.classCode = AXP_21143_CLASS;
+        retVal->pci.cfg.baseAddrReg[0] = 0x00000001;
+        retVal->pci.cfg.baseAddrReg[1] = AXP_PCI_BAR32;
+        retVal->pci.cfg.interruptPin = 0x01;
+        retVal->pci.cfg.minGnt = 0x14;
+        retVal->pci.cfg.maxLat = 0x28;
+        retVal->pci.barSize[0] = AXP_21143_IO_SIZE;
+        retVal->pci.barSize[1] = AXP_21143_MEM_SIZE;
+        retVal->pci.read = AXP_21143_PCIRead;
+        retVal->pci.write = AXP_21143_PCIWrite;
+        retVal->pci.ctx = retVal;
+        AXP_21143_Reset(retVal);
+        pthread_mutex_init(&retVal->mutex, NULL);
+        pthread_condattr_init(&condAttr);
+        pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+        pthread_cond_init(&retVal->cond, &condAttr);
+        pthread_condattr_destroy(&condAttr);
+        retVal->running = true;
+        if (pthread_create(&retVal->thread,
+                           NULL,
+                           AXP_21143_Main,
+                           retVal) != 0)
+        {
+            AXP_EthernetClose(retVal->eth);
+            pthread_cond_destroy(&retVal->cond);
+            pthread_mutex_destroy(&retVal->mutex);
+            AXP_Deallocate_Block(retVal);
+            retVal = NULL;
+        }
+        else
+        {
+            AXP_EthernetNotify(retVal->eth, AXP_21143_Notify, retVal);
+        }
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_Close
+ *  This function is called to stop a 21143's thread, close the Ethernet
+ *  device it is attached to, and free it.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 created in the AXP_21143_Init call.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_21143_Close(AXP_21143 *nic)
+{
+    AXP_EthernetNotify(nic->eth, NULL, NULL);
+    pthread_mutex_lock(&nic->mutex);
+    nic->running = false;
+    pthread_cond_signal(&nic->cond);
+    pthread_mutex_unlock(&nic->mutex);
+    pthread_join(nic->thread, NULL);
+    AXP_EthernetClose(nic->eth);
+    pthread_cond_destroy(&nic->cond);
+    pthread_mutex_destroy(&nic->mutex);
+    AXP_Deallocate_Block(nic);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_ReadConfig
+ *  This function is called to read a longword of the 21143's PCI
+ *  configuration space.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to be read.
+ *  offset:
+ *      A value indicating the byte offset of the longword to be read.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The value of the longword, or 0 for registers that are not implemented.
+ */
+u32 AXP_21143_ReadConfig(AXP_21143 *nic, u32 offset)
+{
+    u32 retVal = 0;
+
+    if ((offset / 4) < AXP_21143_CFG_REGS)
+    {
+        pthread_mutex_lock(&nic->mutex);
+        retVal = nic->cfg[offset / 4];
+        pthread_mutex_unlock(&nic->mutex);
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_WriteConfig
+ *  This function is called to write a longword of the 21143's PCI
+ *  configuration space.  Only the writable bits are changed.  Writing all 1s
+ *  to a base address register and reading it back gives its size.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to be written.
+ *  offset:
+ *      A value indicating the byte offset of the longword to be written.
+ *  value:
+ *      A value to be written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_21143_WriteConfig(AXP_21143 *nic, u32 offset, u32 value)
+{
+    u32 *cfg = nic->cfg;
+
+    pthread_mutex_lock(&nic->mutex);
+    switch (offset & ~0x3)
+    {
+        case AXP_21143_CFCS:
+            cfg[AXP_21143_CFCS / 4] =
+                ((cfg[AXP_21143_CFCS / 4] & 0xffff0000) &
+                 ~(value & 0xf9000000)) |
+                (value & 0x00000147);
+            break;
+
+        case AXP_21143_CFLT:
+            cfg[AXP_21143_CFLT / 4] = value & 0x0000ffff;
+            break;
+
+        case AXP_21143_CBIO:
+            cfg[AXP_21143_CBIO / 4] =
+                (value & ~(AXP_21143_IO_SIZE - 1)) | 0x00000001;
+            break;
+
+        case AXP_21143_CBMA:
+            cfg[AXP_21143_CBMA / 4] = value & ~(AXP_21143_MEM_SIZE - 1);
+            break;
+
+        case AXP_21143_CFIT:
+            cfg[AXP_21143_CFIT / 4] =
+                (cfg[AXP_21143_CFIT / 4] & 0xffffff00) | (value & 0xff);
+            break;
+
+        case AXP_21143_CFDD:
+            cfg[AXP_21143_CFDD / 4] = value & 0xc000ff00;
+            break;
+
+        default:
+            break;
+    }
+    pthread_mutex_unlock(&nic->mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21143_ReadCSR
+ *  This function is called to read one of the 21143's CSRs, through either
+ *  the I/O or memory space base address.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to be read.
+ *  offset:
+ *      A value indicating the byte offset from the base address.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The value of the CSR.
+ */
+u32 AXP_21143_ReadCSR(AXP_21143 *nic, u32 offset)
+{
+    u32 csr = offset >> AXP_21143_CSR_SHIFT;
+    u32 retVal = 0;
+
+    if (csr < AXP_21143_CSRS)
+    {
+        pthread_mutex_lock(&nic->mutex);
+        switch (csr)
+        {
+            case AXP_21143_CSR5:
+                retVal = nic->csr[AXP_21143_CSR5] |
+                         (nic->rxState << AXP_21143_RS_SHIFT) |
+                         (nic->txState << AXP_21143_TS_SHIFT);
+                break;
+
+            case AXP_21143_CSR8:
+                retVal = (nic->missed < 0xffff) ? nic->missed : 0x1ffff;
+                nic->missed = 0;
+                break;
+
+            default:
+                retVal = nic->csr[csr];
+                break;
+        }
+        pthread_mutex_unlock(&nic->mutex);
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21143_WriteCSR
+ *  This function is called to write one of the 21143's CSRs, through either
+ *  the I/O or memory space base address.  Poll demands and changes to the
+ *  operation mode wake up the 21143's thread.
+ *
+ * Input Parameters:
+ *  nic:
+ *      A pointer to the 21143 to be written.
+ *  offset:
+ *      A value indicating the byte offset from the base address.
+ *  value:
+ *      A value to be written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_21143_WriteCSR(AXP_21143 *nic, u32 offset, u32 value)
+{
+    u32 csr = offset >> AXP_21143_CSR_SHIFT;
+    u32 changed;
+
+    if (csr < AXP_21143_CSRS)
+    {
+        pthread_mutex_lock(&nic->mutex);
+        switch (csr)
+        {
+            case AXP_21143_CSR0:
+                if ((value & AXP_21143_CSR0_SWR) != 0)
+                {
+                    AXP_21143_Reset(nic);
+                }
+                else
+                {
+                    nic->csr[AXP_21143_CSR0] = value;
+                }
+                break;
+
+            case AXP_21143_CSR1:
+                if (nic->txState != AXP_21143_STOPPED)
+                {
+                    nic->txState = AXP_21143_RUNNING;
+                    nic->txPoll = true;
+                    nic->work = true;
+                }
+                break;
+
+            case AXP_21143_CSR2:
+                if (nic->rxState != AXP_21143_STOPPED)
+                {
+                    nic->rxState = AXP_21143_RUNNING;
+                    nic->rxPoll = true;
+                    nic->work = true;
+                }
+                break;
+
+            case AXP_21143_CSR3:
+                nic->csr[AXP_21143_CSR3] = value;
+                nic->rxDesc = value & ~0x3;
+                nic->gen++;
+                break;
+
+            case AXP_21143_CSR4:
+                nic->csr[AXP_21143_CSR4] = value;
+                nic->txDesc = value & ~0x3;
+                nic->gen++;
+                break;
+
+            case AXP_21143_CSR5:
+                nic->csr[AXP_21143_CSR5] &= ~(value & AXP_21143_W1C);
+                break;
+
+            /*
+             * Starting a process has it look for a descriptor straight away.
+             * Stopping it reports that it has stopped, and has the thread
+             * give up on the descriptor it is processing.
+             */
+            case AXP_21143_CSR6:
+                changed = nic->csr[AXP_21143_CSR6] ^ value;
+                nic->csr[AXP_21143_CSR6] = value;
+                if ((changed & AXP_21143_SR) != 0)
+                {
+                    if ((value & AXP_21143_SR) != 0)
+                    {
+                        nic->rxState = AXP_21143_RUNNING;
+                    }
+                    else
+                    {
+                        nic->rxState = AXP_21143_STOPPED;
+                        nic->csr[AXP_21143_CSR5] |= AXP_21143_RPS;
+                        nic->gen++;
+                    }
+                }
+                if ((changed & AXP_21143_ST) != 0)
+                {
+                    if ((value & AXP_21143_ST) != 0)
+                    {
+                        nic->txState = AXP_21143_RUNNING;
+                    }
+                    else
+                    {
+                        nic->txState = AXP_21143_STOPPED;
+                        nic->csr[AXP_21143_CSR5] |= AXP_21143_TPS;
+                        nic->gen++;
+                    }
+                }
+                nic->work = true;
+                break;
+
+            case AXP_21143_CSR11:
+                nic->csr[AXP_21143_CSR11] = value;
+                nic->gpTimer = 0;
+                if ((value & AXP_21143_TIMER) != 0)
+                {
+                    nic->gpTimer = AXP_21143_Now() +
+                        ((value & AXP_21143_TIMER) *
+                         (((value & AXP_21143_CS) != 0) ?
+                          AXP_21143_CYCLE_CS_NS :
+                          AXP_21143_CYCLE_NS));
+                    nic->work = true;
+                }
+                break;
+
+            default:
+                nic->csr[csr] = value;
+                break;
+        }
+        if (nic->work == true)
+        {
+            pthread_cond_signal(&nic->cond);
+        }
+        AXP_21143_Update(nic);
+        pthread_mutex_unlock(&nic->mutex);
+        AXP_21143_Signal(nic);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
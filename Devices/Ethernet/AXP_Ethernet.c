@@ -24,22 +24,364 @@
  *
  *  V01.000	28-Jul-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added a packet path.  Each handle has a pool of frame buffers, which move
+ *  between the NIC model and the backend through lock-free queues, and a
+ *  thread that services the backend.  Besides pcap, the backend can be an
+ *  AF_PACKET socket with a memory-mapped TPACKET_V3 receive ring, a TAP
+ *  device, or one end of an in-process loopback pair for offline testing.
+ *
+ *  V01.002	19-Oct-2026	Jonathan D. Belanger
+ *  Added AXP_EthernetNotify, so that a NIC model can wait for frames to be
+ *  received, rather than polling for them.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
 #include "CommonUtilities/AXP_Trace.h"
 #include "Devices/Ethernet/AXP_Ethernet.h"
 #include "CommonUtilities/AXP_Blocks.h"
+#include <poll.h>
+#include <sys/eventfd.h>
 
 #if defined(linux)
      #define PCAP_OPENFLAG_PROMISCUOUS 1
      #define PCAP_OPENFLAG_NOCAPTURE_LOCAL 8
+     #include <sys/socket.h>
+     #include <sys/ioctl.h>
+     #include <sys/mman.h>
+     #include <net/if.h>
+     #include <linux/if_packet.h>
+     #include <linux/if_ether.h>
+     #include <linux/if_tun.h>
 #endif
 
+/*
+ * The ends of the loopback pairs that are waiting for the other end to be
+ * opened.
+ */
+static pthread_mutex_t _ethPairMutex = PTHREAD_MUTEX_INITIALIZER;
+static AXP_Ethernet_Handle *_ethPairs[AXP_ETH_PAIRS];
+
+/*
+ * Local Prototypes
+ */
+static bool AXP_Ethernet_QueuePut(AXP_ETH_QUEUE *, AXP_ETH_FRAME *);
+static AXP_ETH_FRAME *AXP_Ethernet_QueueGet(AXP_ETH_QUEUE *);
+static bool AXP_Ethernet_OpenPacket(AXP_Ethernet_Handle *, char *);
+static bool AXP_Ethernet_OpenTap(AXP_Ethernet_Handle *, char *);
+static bool AXP_Ethernet_OpenPair(AXP_Ethernet_Handle *, char *);
+static bool AXP_Ethernet_Deliver(AXP_Ethernet_Handle *, const u8 *, u32);
+static void AXP_Ethernet_Receive(AXP_Ethernet_Handle *);
+static void AXP_Ethernet_Transmit(AXP_Ethernet_Handle *);
+static void AXP_Ethernet_Stop(AXP_Ethernet_Handle *);
+static void AXP_Ethernet_Notify(AXP_Ethernet_Handle *);
+static void *AXP_Ethernet_Main(void *);
+
+/*
+ * AXP_Ethernet_QueuePut
+ *  This function is called by the producer for a queue to add a frame to the
+ *  end of it.  The frame pointer is stored before the tail is moved, so the
+ *  consumer never sees an entry that has not been written.
+ *
+ * Input Parameters:
+ *  queue:
+ *      A pointer to the queue to be added to.
+ *  frame:
+ *      A pointer to the frame to be added.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  true:   The frame was added to the queue.
+ *  false:  The queue is full.
+ */
+static bool AXP_Ethernet_QueuePut(AXP_ETH_QUEUE *queue, AXP_ETH_FRAME *frame)
+{
+    u32 head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    u32 tail = queue->tail;
+    bool retVal = (tail - head) < AXP_ETH_QUEUE_LEN;
+
+    if (retVal == true)
+    {
+        queue->frame[tail & AXP_ETH_QUEUE_MASK] = frame;
+        __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Ethernet_QueueGet
+ *  This function is called by the consumer for a queue to remove the frame at
+ *  the front of it.
+ *
+ * Input Parameters:
+ *  queue:
+ *      A pointer to the queue to be removed from.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  NULL:   The queue is empty.
+ *  ~NULL:  A pointer to the frame removed from the queue.
+ */
+static AXP_ETH_FRAME *AXP_Ethernet_QueueGet(AXP_ETH_QUEUE *queue)
+{
+    u32 tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    u32 head = queue->head;
+    AXP_ETH_FRAME *retVal = NULL;
+
+    if (head != tail)
+    {
+        retVal = queue->frame[head & AXP_ETH_QUEUE_MASK];
+        __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Ethernet_OpenPacket
+ *  This function is called to open an AF_PACKET socket on a network interface,
+ *  in promiscuous mode, with a memory-mapped TPACKET_V3 receive ring.  The
+ *  kernel fills whole blocks of the ring with frames, so we are only woken up
+ *  once per block, or when the block timeout expires.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the Ethernet Handle being opened.
+ *  name:
+ *	A pointer to the string containing the name of the interface.
+ *
+ * Output Parameters:
+ *  eth:
+ *	The fd, ring, and ringSize fields are set.
+ *
+ * Return Value:
+ *  true:	The socket and ring are ready to use.
+ *  false:	The socket or ring could not be set up.
+ */
+static bool AXP_Ethernet_OpenPacket(AXP_Ethernet_Handle *eth, char *name)
+{
+    bool retVal = false;
+#if defined(linux)
+    struct tpacket_req3 req;
+    struct sockaddr_ll addr;
+    struct packet_mreq mreq;
+    int version = TPACKET_V3;
+    int ifIndex = if_nametoindex(name);
+
+    eth->fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    retVal = (eth->fd >= 0) && (ifIndex > 0);
+    if (retVal == true)
+    {
+        retVal = setsockopt(eth->fd,
+                            SOL_PACKET,
+                            PACKET_VERSION,
+                            &version,
+                            sizeof(version)) == 0;
+    }
+    if (retVal == true)
+    {
+        memset(&req, 0, sizeof(req));
+        req.tp_block_size = AXP_ETH_BLOCK_SIZE;
+        req.tp_block_nr = AXP_ETH_BLOCKS;
+        req.tp_frame_size = AXP_ETH_FRAME_LEN;
+        req.tp_frame_nr = (AXP_ETH_BLOCK_SIZE / AXP_ETH_FRAME_LEN) *
+                          AXP_ETH_BLOCKS;
+        req.tp_retire_blk_tov = AXP_ETH_BLOCK_TMO;
+        retVal = setsockopt(eth->fd,
+                            SOL_PACKET,
+                            PACKET_RX_RING,
+                            &req,
+                            sizeof(req)) == 0;
+    }
+    if (retVal == true)
+    {
+        eth->ringSize = AXP_ETH_BLOCK_SIZE * AXP_ETH_BLOCKS;
+        eth->ring = mmap(NULL,
+                         eth->ringSize,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED,
+                         eth->fd,
+                         0);
+        if (eth->ring == MAP_FAILED)
+        {
+            eth->ring = NULL;
+            retVal = false;
+        }
+    }
+    if (retVal == true)
+    {
+        memset(&addr, 0, sizeof(addr));
+        addr.sll_family = AF_PACKET;
+        addr.sll_protocol = htons(ETH_P_ALL);
+        addr.sll_ifindex = ifIndex;
+        retVal = bind(eth->fd, (struct sockaddr *) &addr, sizeof(addr)) == 0;
+    }
+    if (retVal == true)
+    {
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.mr_ifindex = ifIndex;
+        mreq.mr_type = PACKET_MR_PROMISC;
+        retVal = setsockopt(eth->fd,
+                            SOL_PACKET,
+                            PACKET_ADD_MEMBERSHIP,
+                            &mreq,
+                            sizeof(mreq)) == 0;
+    }
+    if (retVal == false)
+    {
+        snprintf(eth->errorBuf,
+                 sizeof(eth->errorBuf),
+                 "Unable to open packet socket on %s: %s",
+                 name,
+                 strerror(errno));
+    }
+#endif
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Ethernet_OpenTap
+ *  This function is called to attach to a TAP device, creating it if it does
+ *  not already exist.  The device is non-blocking, so that we can read all the
+ *  frames that are ready each time we are woken up.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the Ethernet Handle being opened.
+ *  name:
+ *	A pointer to the string containing the name of the TAP device.
+ *
+ * Output Parameters:
+ *  eth:
+ *	The fd field is set.
+ *
+ * Return Value:
+ *  true:	The TAP device is ready to use.
+ *  false:	The TAP device could not be attached to.
+ */
+static bool AXP_Ethernet_OpenTap(AXP_Ethernet_Handle *eth, char *name)
+{
+    bool retVal = false;
+#if defined(linux)
+    struct ifreq ifr;
+
+    eth->fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    retVal = eth->fd >= 0;
+    if (retVal == true)
+    {
+        memset(&ifr, 0, sizeof(ifr));
+        ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+        strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+        retVal = ioctl(eth->fd, TUNSETIFF, &ifr) == 0;
+    }
+    if (retVal == false)
+    {
+        snprintf(eth->errorBuf,
+                 sizeof(eth->errorBuf),
+                 "Unable to attach to TAP device %s: %s",
+                 name,
+                 strerror(errno));
+    }
+#endif
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Ethernet_OpenPair
+ *  This function is called to open one end of a loopback pair.  The first end
+ *  opened waits for the other one.  When the second end is opened, the two
+ *  are linked, and what is transmitted on one end is received on the other.
+ *  The second end services both.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the Ethernet Handle being opened.
+ *  name:
+ *	A pointer to the string containing the number of the pair.
+ *
+ * Output Parameters:
+ *  eth:
+ *	The pairIdx and peer fields are set, and the wake field of the second
+ *	end is a duplicate of the first's.
+ *
+ * Return Value:
+ *  true:	The end of the pair has been opened.
+ *  false:	The pair number is not valid.
+ */
+static bool AXP_Ethernet_OpenPair(AXP_Ethernet_Handle *eth, char *name)
+{
+    char *end;
+    u32 pairIdx = strtoul(name, &end, 10);
+    bool retVal = (*name != '\0') &&
+                  (*end == '\0') &&
+                  (pairIdx < AXP_ETH_PAIRS);
+
+    if (retVal == true)
+    {
+        eth->pairIdx = pairIdx;
+        pthread_mutex_lock(&_ethPairMutex);
+        if (_ethPairs[pairIdx] == NULL)
+        {
+            eth->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            retVal = eth->wake >= 0;
+            if (retVal == true)
+            {
+                _ethPairs[pairIdx] = eth;
+            }
+        }
+        else
+        {
+            eth->wake = dup(_ethPairs[pairIdx]->wake);
+            retVal = eth->wake >= 0;
+            if (retVal == true)
+            {
+                eth->peer = _ethPairs[pairIdx];
+                eth->peer->peer = eth;
+                _ethPairs[pairIdx] = NULL;
+            }
+        }
+        pthread_mutex_unlock(&_ethPairMutex);
+    }
+    else
+    {
+        snprintf(eth->errorBuf,
+                 sizeof(eth->errorBuf),
+                 "Invalid loopback pair %s",
+                 name);
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
 /*
  * AXP_EthernetOpen
  *  This function is called to open an ethernet device for sending and
- *  receiving packets over the device.
+ *  receiving packets over the device.  The name can be prefixed to select the
+ *  backend used (see AXP_Ethernet.h).  Once the device is open, a thread is
+ *  started to move frames between it and the handle's queues.
  *
  * Input Parameters:
  *  name:
@@ -59,38 +401,113 @@
 AXP_Ethernet_Handle *AXP_EthernetOpen(char *name, u8 cardNo)
 {
     AXP_Ethernet_Handle *retVal;
+    bool opened = false;
+    int ii;
 
     retVal = AXP_Allocate_Block(AXP_ETHERNET_BLK);
     if (retVal != NULL)
     {
+        retVal->fd = -1;
+        retVal->wake = -1;
+        retVal->macAddr[0] = 0x08;
+        retVal->macAddr[1] = 0x00;
+        retVal->macAddr[2] = 0x2b;
+        retVal->macAddr[3] = 0xde;
+        retVal->macAddr[4] = 0xcc;
+        retVal->macAddr[5] = cardNo;
+
+        /*
+         * Allocate the frame buffers, and queue half of them to receive into
+         * and the other half to transmit from.
+         */
+        retVal->frames = AXP_Allocate_Block(
+                            -(i32) (sizeof(AXP_ETH_FRAME) * AXP_ETH_FRAMES * 2),
+                            NULL);
+        if (retVal->frames != NULL)
+        {
+            for (ii = 0; ii < AXP_ETH_FRAMES; ii++)
+            {
+                AXP_Ethernet_QueuePut(&retVal->rxFree, &retVal->frames[ii]);
+                AXP_Ethernet_QueuePut(&retVal->txFree,
+                                      &retVal->frames[AXP_ETH_FRAMES + ii]);
+            }
+
+            /*
+             * Open the backend.
+             */
+            if (strncmp(name,
+                        AXP_ETH_PACKET_PREFIX,
+                        strlen(AXP_ETH_PACKET_PREFIX)) == 0)
+            {
+                retVal->backend = AXP_ETH_PACKET;
+                opened = AXP_Ethernet_OpenPacket(
+                                retVal,
+                                &name[strlen(AXP_ETH_PACKET_PREFIX)]);
+            }
+            else if (strncmp(name,
+                             AXP_ETH_TAP_PREFIX,
+                             strlen(AXP_ETH_TAP_PREFIX)) == 0)
+            {
+                retVal->backend = AXP_ETH_TAP;
+                opened = AXP_Ethernet_OpenTap(
+                                retVal,
+                                &name[strlen(AXP_ETH_TAP_PREFIX)]);
+            }
+            else if (strncmp(name,
+                             AXP_ETH_PAIR_PREFIX,
+                             strlen(AXP_ETH_PAIR_PREFIX)) == 0)
+            {
+                retVal->backend = AXP_ETH_PAIR;
+                opened = AXP_Ethernet_OpenPair(
+                                retVal,
+                                &name[strlen(AXP_ETH_PAIR_PREFIX)]);
+            }
+            else
+            {
+                retVal->backend = AXP_ETH_PCAP;
 #if defined(linux)
-  retVal->handle = pcap_open_live(
+                retVal->handle = pcap_open_live(
 #else
-  retVal->handle = pcap_open(
+                retVal->handle = pcap_open(
 #endif
-        name,
-        SIXTYFOUR_K,
-        (PCAP_OPENFLAG_PROMISCUOUS |
-            PCAP_OPENFLAG_NOCAPTURE_LOCAL),
-        AXP_ETH_READ_TIMEOUT,
+                        name,
+                        SIXTYFOUR_K,
+                        (PCAP_OPENFLAG_PROMISCUOUS |
+                            PCAP_OPENFLAG_NOCAPTURE_LOCAL),
+                        AXP_ETH_READ_TIMEOUT,
 #if !defined(linux)
-        NULL,
+                        NULL,
 #endif
-        retVal->errorBuf);
-  if (retVal->handle == NULL)
-  {
-      AXP_Deallocate_Block(retVal);
-      retVal = NULL;
-  }
-  else
-  {
-      retVal->macAddr[0] = 0x08;
-      retVal->macAddr[1] = 0x00;
-      retVal->macAddr[2] = 0x2b;
-      retVal->macAddr[3] = 0xde;
-      retVal->macAddr[4] = 0xcc;
-      retVal->macAddr[5] = cardNo;
-  }
+                        retVal->errorBuf);
+                opened = retVal->handle != NULL;
+            }
+        }
+
+        /*
+         * Create the event used to wake the thread up when there are frames to
+         * transmit, and start the thread.  One end of a pair, opened before
+         * the other, is started when the other end is opened.
+         */
+        if ((opened == true) && (retVal->wake < 0))
+        {
+            retVal->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            opened = retVal->wake >= 0;
+        }
+        if ((opened == true) &&
+            ((retVal->backend != AXP_ETH_PAIR) || (retVal->peer != NULL)))
+        {
+            retVal->running = true;
+            retVal->ownThread = pthread_create(&retVal->thread,
+                                               NULL,
+                                               AXP_Ethernet_Main,
+                                               retVal) == 0;
+            opened = retVal->ownThread;
+        }
+        if (opened == false)
+        {
+            AXP_EthernetClose(retVal);
+            retVal = NULL;
+        }
     }
 
     /*
@@ -99,10 +516,47 @@ AXP_Ethernet_Handle *AXP_EthernetOpen(char *name, u8 cardNo)
     return(retVal);
 }
 
+/*
+ * AXP_Ethernet_Stop
+ *  This function is called to stop the thread servicing a handle, and wait
+ *  for it to exit.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the handle whose thread is to be stopped.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Ethernet_Stop(AXP_Ethernet_Handle *eth)
+{
+    u64 wakeCount = 1;
+
+    if (eth->ownThread == true)
+    {
+        __atomic_store_n(&eth->running, false, __ATOMIC_RELEASE);
+        if (write(eth->wake, &wakeCount, sizeof(wakeCount)) < 0)
+        {
+            wakeCount = 0;
+        }
+        pthread_join(eth->thread, NULL);
+        eth->ownThread = false;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
 /*
  * AXP_EthernetClose
  *  This function is called to close an ethernet device that is no longer
- *  needed.
+ *  needed.  Closing either end of a loopback pair stops the thread servicing
+ *  both ends.
  *
  * Input Parameters:
  *  handle:
@@ -116,11 +570,53 @@ AXP_Ethernet_Handle *AXP_EthernetOpen(char *name, u8 cardNo)
  */
 void AXP_EthernetClose(AXP_Ethernet_Handle *handle)
 {
+    if (handle->backend == AXP_ETH_PAIR)
+    {
+        pthread_mutex_lock(&_ethPairMutex);
+        if (handle->peer != NULL)
+        {
+            AXP_Ethernet_Stop(handle->peer);
+            AXP_Ethernet_Stop(handle);
+            handle->peer->peer = NULL;
+            handle->peer = NULL;
+        }
+        else if (_ethPairs[handle->pairIdx] == handle)
+        {
+            _ethPairs[handle->pairIdx] = NULL;
+        }
+        pthread_mutex_unlock(&_ethPairMutex);
+    }
+    else
+    {
+        AXP_Ethernet_Stop(handle);
+    }
     if (handle->handle != NULL)
     {
   pcap_close(handle->handle);
   handle->handle = NULL;
     }
+#if defined(linux)
+    if (handle->ring != NULL)
+    {
+        munmap(handle->ring, handle->ringSize);
+        handle->ring = NULL;
+    }
+#endif
+    if (handle->fd >= 0)
+    {
+        close(handle->fd);
+        handle->fd = -1;
+    }
+    if (handle->wake >= 0)
+    {
+        close(handle->wake);
+        handle->wake = -1;
+    }
+    if (handle->frames != NULL)
+    {
+        AXP_Deallocate_Block(handle->frames);
+        handle->frames = NULL;
+    }
     AXP_Deallocate_Block(handle);
 
     /*
@@ -128,3 +624,501 @@ void AXP_EthernetClose(AXP_Ethernet_Handle *handle)
      */
     return;
 }
+
+/*
+ * AXP_EthernetRxGet
+ *  This function is called by the NIC model to get the next frame received.
+ *  The frame is the NIC model's until it is given back with AXP_EthernetRxPut.
+ *
+ * Input Parameters:
+ *  handle:
+ *	A pointer to the handle created in the AXP_EthernetOpen call.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  NULL:	No frames have been received.
+ *  ~NULL:	A pointer to the frame received.
+ */
+AXP_ETH_FRAME *AXP_EthernetRxGet(AXP_Ethernet_Handle *handle)
+{
+    return(AXP_Ethernet_QueueGet(&handle->rxReady));
+}
+
+/*
+ * AXP_EthernetRxPut
+ *  This function is called by the NIC model to give back a frame returned by
+ *  AXP_EthernetRxGet, once it is done with it, to be received into again.
+ *
+ * Input Parameters:
+ *  handle:
+ *	A pointer to the handle created in the AXP_EthernetOpen call.
+ *  frame:
+ *	A pointer to the frame being given back.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_EthernetRxPut(AXP_Ethernet_Handle *handle, AXP_ETH_FRAME *frame)
+{
+    AXP_Ethernet_QueuePut(&handle->rxFree, frame);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_EthernetTxGet
+ *  This function is called by the NIC model to get a frame buffer into which
+ *  to put a frame to be transmitted.
+ *
+ * Input Parameters:
+ *  handle:
+ *	A pointer to the handle created in the AXP_EthernetOpen call.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  NULL:	All the frame buffers are waiting to be transmitted.
+ *  ~NULL:	A pointer to the frame buffer.
+ */
+AXP_ETH_FRAME *AXP_EthernetTxGet(AXP_Ethernet_Handle *handle)
+{
+    return(AXP_Ethernet_QueueGet(&handle->txFree));
+}
+
+/*
+ * AXP_EthernetTxPut
+ *  This function is called by the NIC model to queue a frame, from a buffer
+ *  returned by AXP_EthernetTxGet, to be transmitted.  The thread servicing the
+ *  handle is only woken up if it has not already been told there are frames to
+ *  transmit.
+ *
+ * Input Parameters:
+ *  handle:
+ *	A pointer to the handle created in the AXP_EthernetOpen call.
+ *  frame:
+ *	A pointer to the frame to be transmitted, with its len field set.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_EthernetTxPut(AXP_Ethernet_Handle *handle, AXP_ETH_FRAME *frame)
+{
+    u64 wakeCount = 1;
+
+    AXP_Ethernet_QueuePut(&handle->txReady, frame);
+    if (__atomic_exchange_n(&handle->txKick, true, __ATOMIC_ACQ_REL) == false)
+    {
+        if (write(handle->wake, &wakeCount, sizeof(wakeCount)) < 0)
+        {
+            wakeCount = 0;
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_EthernetNotify
+ *  This function is called by the NIC model to have a function called each
+ *  time the thread servicing the handle has queued one or more frames to the
+ *  NIC model.  The function is called from that thread, once per batch of
+ *  frames, so it should do no more than wake up the NIC model.
+ *
+ * Input Parameters:
+ *  handle:
+ *	A pointer to the handle created in the AXP_EthernetOpen call.
+ *  notify:
+ *	A pointer to the function to be called, or NULL for none.
+ *  arg:
+ *	A pointer to be passed to the notify function.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_EthernetNotify(AXP_Ethernet_Handle *handle,
+                        void (*notify)(void *),
+                        void *arg)
+{
+    __atomic_store_n(&handle->rxNotify, NULL, __ATOMIC_SEQ_CST);
+    handle->rxArg = arg;
+    __atomic_store_n(&handle->rxNotify, notify, __ATOMIC_SEQ_CST);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Ethernet_Notify
+ *  This function is called by the thread servicing a handle, after receiving
+ *  and transmitting, to call the NIC model's notify function, if frames have
+ *  been queued to it since the last time it was called.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the handle that may have received frames.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Ethernet_Notify(AXP_Ethernet_Handle *eth)
+{
+    void (*notify)(void *);
+
+    notify = __atomic_load_n(&eth->rxNotify, __ATOMIC_SEQ_CST);
+    if ((notify != NULL) && (eth->rxNotified != eth->rxFrames))
+    {
+        eth->rxNotified = eth->rxFrames;
+        (*notify)(eth->rxArg);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Ethernet_Deliver
+ *  This function is called by the thread servicing a handle to copy a frame
+ *  received from the backend into a free frame buffer and queue it to the NIC
+ *  model.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the handle that received the frame.
+ *  data:
+ *	A pointer to the frame received.
+ *  len:
+ *	A value indicating the length of the frame received.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  true:   The frame has been queued to the NIC model.
+ *  false:  The NIC model has not given back any frame buffers.
+ */
+static bool AXP_Ethernet_Deliver(AXP_Ethernet_Handle *eth,
+                                 const u8 *data,
+                                 u32 len)
+{
+    AXP_ETH_FRAME *frame = AXP_Ethernet_QueueGet(&eth->rxFree);
+    bool retVal = frame != NULL;
+
+    if (retVal == true)
+    {
+        frame->len = (len < AXP_ETH_FRAME_LEN) ? len : AXP_ETH_FRAME_LEN;
+        memcpy(frame->data, data, frame->len);
+        AXP_Ethernet_QueuePut(&eth->rxReady, frame);
+        eth->rxFrames++;
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_Ethernet_Receive
+ *  This function is called by the thread servicing a handle to receive the
+ *  frames that are ready from the backend.  For a packet socket, this is every
+ *  block the kernel has handed over to us in the ring.  For a TAP device,
+ *  frames are read straight into the free frame buffers, a batch at a time.
+ *  For pcap, it waits for up to the read timeout for a frame.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the handle to receive frames for.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Ethernet_Receive(AXP_Ethernet_Handle *eth)
+{
+    struct pcap_pkthdr *hdr;
+    const u8 *data;
+    ssize_t len;
+    int ii;
+
+    switch (eth->backend)
+    {
+        case AXP_ETH_PCAP:
+            for (ii = 0;
+                 ((ii < AXP_ETH_BATCH) &&
+                  (pcap_next_ex(eth->handle, &hdr, &data) == 1));
+                 ii++)
+            {
+                if (AXP_Ethernet_Deliver(eth, data, hdr->caplen) == false)
+                {
+                    eth->rxDropped++;
+                }
+            }
+            break;
+
+#if defined(linux)
+        case AXP_ETH_PACKET:
+            {
+                struct tpacket_block_desc *desc;
+                struct tpacket3_hdr *pkt;
+                u32 jj;
+
+                desc = (struct tpacket_block_desc *)
+                        &eth->ring[eth->block * AXP_ETH_BLOCK_SIZE];
+                while ((__atomic_load_n(&desc->hdr.bh1.block_status,
+                                        __ATOMIC_ACQUIRE) &
+                        TP_STATUS_USER) != 0)
+                {
+                    pkt = (struct tpacket3_hdr *)
+                        ((u8 *) desc + desc->hdr.bh1.offset_to_first_pkt);
+                    for (jj = 0; jj < desc->hdr.bh1.num_pkts; jj++)
+                    {
+                        if (AXP_Ethernet_Deliver(eth,
+                                                 (u8 *) pkt + pkt->tp_mac,
+                                                 pkt->tp_snaplen) == false)
+                        {
+                            eth->rxDropped++;
+                        }
+                        pkt = (struct tpacket3_hdr *)
+                            ((u8 *) pkt + pkt->tp_next_offset);
+                    }
+                    __atomic_store_n(&desc->hdr.bh1.block_status,
+                                     TP_STATUS_KERNEL,
+                                     __ATOMIC_RELEASE);
+                    eth->block = (eth->block + 1) % AXP_ETH_BLOCKS;
+                    desc = (struct tpacket_block_desc *)
+                            &eth->ring[eth->block * AXP_ETH_BLOCK_SIZE];
+                }
+            }
+            break;
+#endif
+
+        /*
+         * Each read of a TAP device returns one frame.  A frame buffer we did
+         * not get to read into is kept for next time, since only the NIC model
+         * puts buffers back on the free queue.
+         */
+        case AXP_ETH_TAP:
+            len = 0;
+            for (ii = 0; ((ii < AXP_ETH_BATCH) && (len >= 0)); ii++)
+            {
+                if (eth->spare == NULL)
+                {
+                    eth->spare = AXP_Ethernet_QueueGet(&eth->rxFree);
+                }
+                if (eth->spare != NULL)
+                {
+                    len = read(eth->fd, eth->spare->data, AXP_ETH_FRAME_LEN);
+                    if (len > 0)
+                    {
+                        eth->spare->len = len;
+                        AXP_Ethernet_QueuePut(&eth->rxReady, eth->spare);
+                        eth->spare = NULL;
+                        eth->rxFrames++;
+                    }
+                }
+                else
+                {
+                    u8 discard[AXP_ETH_FRAME_LEN];
+
+                    len = read(eth->fd, discard, sizeof(discard));
+                    if (len > 0)
+                    {
+                        eth->rxDropped++;
+                    }
+                }
+                if (len == 0)
+                {
+                    len = -1;
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Ethernet_Transmit
+ *  This function is called by the thread servicing a handle to transmit all
+ *  the frames queued by the NIC model, and give the frame buffers back to it.
+ *  For a loopback pair, the frame is received by the other end.  If the other
+ *  end has no free frame buffers, the frame is held, as is everything queued
+ *  after it, until it does.
+ *
+ * Input Parameters:
+ *  eth:
+ *	A pointer to the handle to transmit frames for.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Ethernet_Transmit(AXP_Ethernet_Handle *eth)
+{
+    AXP_ETH_FRAME *frame;
+    bool sent = false;
+
+    __atomic_store_n(&eth->txKick, false, __ATOMIC_SEQ_CST);
+    while ((frame = (eth->held != NULL) ?
+                    eth->held :
+                    AXP_Ethernet_QueueGet(&eth->txReady)) != NULL)
+    {
+        eth->held = NULL;
+        switch (eth->backend)
+        {
+            case AXP_ETH_PCAP:
+                sent = pcap_sendpacket(eth->handle,
+                                       frame->data,
+                                       frame->len) == 0;
+                break;
+
+            case AXP_ETH_PACKET:
+                sent = send(eth->fd, frame->data, frame->len, 0) == frame->len;
+                break;
+
+            case AXP_ETH_TAP:
+                sent = write(eth->fd, frame->data, frame->len) == frame->len;
+                break;
+
+            case AXP_ETH_PAIR:
+                sent = eth->peer != NULL;
+                if ((sent == true) &&
+                    (AXP_Ethernet_Deliver(eth->peer,
+                                          frame->data,
+                                          frame->len) == false))
+                {
+                    eth->held = frame;
+                }
+                break;
+        }
+        if (eth->held != NULL)
+        {
+            break;
+        }
+        if (sent == true)
+        {
+            eth->txFrames++;
+        }
+        else
+        {
+            eth->txDropped++;
+        }
+        AXP_Ethernet_QueuePut(&eth->txFree, frame);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Ethernet_Main
+ *  This is the main function for the thread servicing a handle, and for a
+ *  loopback pair, the other end as well.  It waits for frames to be received
+ *  or queued for transmission, and moves them between the backend and the
+ *  handle's queues, until it is stopped.
+ *
+ * Input Parameters:
+ *  voidPtr:
+ *	A pointer to the handle to be serviced.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  NULL.
+ */
+static void *AXP_Ethernet_Main(void *voidPtr)
+{
+    AXP_Ethernet_Handle *eth = (AXP_Ethernet_Handle *) voidPtr;
+    AXP_Ethernet_Handle *peer = eth->peer;
+    struct pollfd fds[2];
+    u64 wakeCount;
+    int timeout;
+    int nfds = 1;
+
+    fds[0].fd = eth->wake;
+    fds[0].events = POLLIN;
+    if (eth->fd >= 0)
+    {
+        fds[1].fd = eth->fd;
+        fds[1].events = POLLIN;
+        nfds++;
+    }
+    while (__atomic_load_n(&eth->running, __ATOMIC_ACQUIRE) == true)
+    {
+
+        /*
+         * pcap has no descriptor for us to wait on, so it waits for frames to
+         * be received, for up to the read timeout, instead.  If a loopback
+         * frame is being held, we check again shortly for frame buffers.
+         */
+        timeout = ((eth->held != NULL) ||
+                   ((peer != NULL) && (peer->held != NULL))) ?
+                  AXP_ETH_HELD_TIMEOUT :
+                  -1;
+        if (eth->backend == AXP_ETH_PCAP)
+        {
+            AXP_Ethernet_Receive(eth);
+        }
+        else if (poll(fds, nfds, timeout) > 0)
+        {
+            if ((fds[0].revents & POLLIN) != 0)
+            {
+                while (read(eth->wake, &wakeCount, sizeof(wakeCount)) > 0);
+            }
+            if ((nfds > 1) && (fds[1].revents != 0))
+            {
+                AXP_Ethernet_Receive(eth);
+            }
+        }
+        AXP_Ethernet_Transmit(eth);
+        if (peer != NULL)
+        {
+            AXP_Ethernet_Transmit(peer);
+            AXP_Ethernet_Notify(peer);
+        }
+        AXP_Ethernet_Notify(eth);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(NULL);
+}
@@ -33,9 +33,17 @@
  *  either have a null value or the address of the block being allocated (so
  *  that it can be replaced) provided on the call, or the call will get a
  *  segmentation fault.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added the read and write sector functions.  When opened with
+ *  OPEN_MAPPED_IO, the device or file is mapped into memory and reads become
+ *  a memory copy.  ISO files are regular files, so their geometry is now
+ *  determined from the file size rather than from block device ioctls.
  */
 #include "Devices/VirtualDisks/AXP_RAW.h"
+#include "Devices/VirtualDisks/AXP_VHD_Utility.h"
 #include "CommonUtilities/AXP_Blocks.h"
+#include <sys/stat.h>
 
 /*
  * _GetDiskInfo
@@ -57,10 +65,26 @@
  */
 static bool _GetDiskInfo(AXP_RAW_Handle *raw)
 {
+    struct stat statBuf;
     bool retVal = true, done = false;
     int ioctlCnt = 0;
     int ro;
 
+    /*
+     * If this is a regular file (an ISO image, for example), then the block
+     * device ioctls will not work.  Get the size from the file itself and use
+     * the default sector size for the device type.
+     */
+    if ((fstat(raw->fd, &statBuf) == 0) && S_ISREG(statBuf.st_mode))
+    {
+        raw->readOnly = raw->deviceID == STORAGE_TYPE_DEV_ISO;
+        raw->diskSize = statBuf.st_size;
+        raw->sectorSize = (raw->deviceID == STORAGE_TYPE_DEV_ISO) ?
+            AXP_ISO_SEC_DEF : AXP_VHD_SEC_DEF;
+        raw->blkSize = raw->sectorSize;
+        done = true;
+    }
+
     /*
      * Let's get information about the device.
      */
@@ -83,7 +107,7 @@ static bool _GetDiskInfo(AXP_RAW_Handle *raw)
 
             case 3:
                 retVal = ioctl(raw->fd, BLKSSZGET, &raw->sectorSize) == 0;
-                /* no break */
+                /* no break */
 
             default:
                 done = true;
@@ -158,7 +182,7 @@ u32 _AXP_RAW_Open(char *path,
          * Allocate a buffer long enough for for the filename (plus null
          * character).
          */
-        raw->filePath = AXP_Allocate_Block(-(strlen(path) + 1), path);
+        raw->filePath = AXP_Allocate_Block(-(strlen(path) + 1), NULL);
         if (raw->filePath != NULL)
         {
             int mode = (deviceID == STORAGE_TYPE_DEV_ISO) ? O_RDONLY : O_RDWR;
@@ -182,6 +206,24 @@ u32 _AXP_RAW_Open(char *path,
                 {
                     retVal = AXP_VHD_READ_FAULT;
                 }
+
+                /*
+                 * If we were asked to use mapped I/O, then map the entire
+                 * device/file.  The mapping is only ever read through, writes
+                 * still go through the file descriptor, so the mapping is
+                 * read-only.  If the mapping cannot be established, we just
+                 * fall back to file I/O.
+                 */
+                else if (flags == OPEN_MAPPED_IO)
+                {
+                    if (AXP_VHD_MapImage(raw->fd,
+                                         raw->diskSize,
+                                         false,
+                                         &raw->mapAddr) == AXP_VHD_SUCCESS)
+                    {
+                        raw->mapLength = raw->diskSize;
+                    }
+                }
             }
             else
             {
@@ -201,12 +243,153 @@ u32 _AXP_RAW_Open(char *path,
     /*
      * OK, if we don't have a success at this point, and we allocated a VHD
      * handle, then deallocate the handle, since the VHD was not successfully
-     * opened.
+     * opened.  Otherwise, return the handle back to the caller.
      */
     if ((retVal != AXP_VHD_SUCCESS) && (raw != NULL))
     {
         AXP_Deallocate_Block(raw);
     }
+    else if (retVal == AXP_VHD_SUCCESS)
+    {
+        *handle = (AXP_VHD_HANDLE) raw;
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_RAW_ReadSectors
+ *  Reads one or more sectors from a RAW device or ISO file.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A pointer to the handle object that represents the device or file from
+ *      which to read.
+ *  lba:
+ *      A value representing the Logical Block Address from where the read is
+ *      to be started.
+ *  sectorsRead:
+ *      A pointer to a value representing the number of sectors to be read.
+ *
+ * Output Parameters:
+ *  sectorsRead:
+ *      A pointer to an unsigned 32-bit value to receive the actual number of
+ *      sectors read.
+ *  outBuf:
+ *      A pointer to an unsigned 8-bit array in which to receive the read in
+ *      data.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_READ_FAULT:     An error occurred reading from the device or file.
+ */
+u32 _AXP_RAW_ReadSectors(AXP_VHD_HANDLE handle,
+                         u64 lba,
+                         u32 *sectorsRead,
+                         u8 *outBuf)
+{
+    AXP_RAW_Handle *raw = (AXP_RAW_Handle *) handle;
+    u64 offset = lba * (u64) raw->sectorSize;
+    size_t bytes = (size_t) *sectorsRead * raw->sectorSize;
+    ssize_t bytesRead;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    /*
+     * If the device/file is mapped, then the read is just a copy from the
+     * mapping.  There is no system call needed, as the data comes out of the
+     * host page cache.
+     */
+    if (raw->mapAddr != NULL)
+    {
+        memcpy(outBuf, &raw->mapAddr[offset], bytes);
+    }
+
+    /*
+     * Otherwise, read the sectors from the device/file.
+     */
+    else
+    {
+        bytesRead = pread(raw->fd, outBuf, bytes, offset);
+        if (bytesRead >= 0)
+        {
+            *sectorsRead = bytesRead / raw->sectorSize;
+        }
+        else
+        {
+            *sectorsRead = 0;
+            retVal = AXP_VHD_READ_FAULT;
+        }
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_RAW_WriteSectors
+ *  Writes one or more sectors to a RAW device.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A pointer to the handle object that represents the device to which to
+ *      write.
+ *  lba:
+ *      A value representing the Logical Block Address from where the write is
+ *      to be started.
+ *  sectorsWritten:
+ *      A pointer to a value representing the number of sectors to be written.
+ *  inBuf:
+ *      A pointer to an unsigned 8-bit array to be written to the device.
+ *
+ * Output Parameters:
+ *  sectorsWritten:
+ *      A pointer to an unsigned 32-bit value to receive the actual number of
+ *      sectors written.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_FILE_READ_ONLY: The device or file is read-only.
+ *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the device.
+ */
+u32 _AXP_RAW_WriteSectors(AXP_VHD_HANDLE handle,
+                          u64 lba,
+                          u32 *sectorsWritten,
+                          u8 *inBuf)
+{
+    AXP_RAW_Handle *raw = (AXP_RAW_Handle *) handle;
+    u64 offset = lba * (u64) raw->sectorSize;
+    size_t bytes = (size_t) *sectorsWritten * raw->sectorSize;
+    ssize_t bytesWritten;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    /*
+     * We always write through the file descriptor.  If the device is also
+     * mapped, the mapping is shared, so the data written will be seen the
+     * next time it is read through the mapping.
+     */
+    if (raw->readOnly == false)
+    {
+        bytesWritten = pwrite(raw->fd, inBuf, bytes, offset);
+        if (bytesWritten >= 0)
+        {
+            *sectorsWritten = bytesWritten / raw->sectorSize;
+        }
+        else
+        {
+            *sectorsWritten = 0;
+            retVal = AXP_VHD_WRITE_FAULT;
+        }
+    }
+    else
+    {
+        *sectorsWritten = 0;
+        retVal = AXP_VHD_FILE_READ_ONLY;
+    }
 
     /*
      * Return the outcome of this call back to the caller.
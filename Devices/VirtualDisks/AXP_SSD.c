@@ -29,9 +29,32 @@
  *  either have a null value or the address of the block being allocated (so
  *  that it can be replaced) provided on the call, or the call will get a
  *  segmentation fault.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Rather than allocating memory for the entire SSD and reading the backing
+ *  store file into it on open (and writing all of it back out to save it),
+ *  the backing store file is now mapped into memory.  Opening a large SSD is
+ *  now immediate.  Each write marks the pages it touched as dirty, and a
+ *  flush thread periodically writes back just the dirty pages.  A final
+ *  flush is performed when the SSD is closed.  Also added the functions to
+ *  read and write sectors.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  An SSD whose backing store file is too small for the size in its header is
+ *  not opened, rather than mapping past the end of the file.
  */
 #include "CommonUtilities/AXP_Blocks.h"
 #include "Devices/VirtualDisks/AXP_SSD.h"
+#include "Devices/VirtualDisks/AXP_VHD_Utility.h"
+#include <sys/mman.h>
+
+/*
+ * Local Prototypes
+ */
+static u32 _AXP_SSD_Map(AXP_SSD_Handle *);
+static void *_AXP_SSD_FlushMain(void *);
+static void _AXP_SSD_MarkDirty(AXP_SSD_Handle *, u64, u64);
+static u32 _AXP_SSD_FlushRun(AXP_SSD_Handle *, u64, u64);
 
 /*
  * _AXP_SSD_Create
@@ -85,28 +108,19 @@ u32 _AXP_SSD_Create(char *path,
     ssd = (AXP_SSD_Handle *) AXP_Allocate_Block(AXP_SSD_BLK);
     if (ssd != NULL)
     {
-        ssd->memory = (u8 *) AXP_Allocate_Block(-diskSize, ssd->memory);
-        if (ssd->memory != NULL)
-        {
 
-            /*
-             * Allocate a buffer long enough for for the filename (plus null
-             * character).
-             */
-            ssd->filePath = AXP_Allocate_Block(-(strlen(path) + 1),
-                                               ssd->filePath);
-            if (ssd->filePath != NULL)
-            {
-                strcpy(ssd->filePath, path);
-                ssd->deviceID = deviceID;
-                ssd->diskSize = diskSize;
-                ssd->blkSize = blkSize;
-                ssd->sectorSize = sectorSize;
-            }
-            else
-            {
-                retVal = AXP_VHD_OUTOFMEMORY;
-            }
+        /*
+         * Allocate a buffer long enough for for the filename (plus null
+         * character).
+         */
+        ssd->filePath = AXP_Allocate_Block(-(strlen(path) + 1), NULL);
+        if (ssd->filePath != NULL)
+        {
+            strcpy(ssd->filePath, path);
+            ssd->deviceID = deviceID;
+            ssd->diskSize = diskSize;
+            ssd->blkSize = blkSize;
+            ssd->sectorSize = sectorSize;
         }
         else
         {
@@ -133,6 +147,12 @@ u32 _AXP_SSD_Create(char *path,
         ssd->fp = fopen(path, "rb");
         if (ssd->fp == NULL)
         {
+
+            /*
+             * The data portion of the file is not written.  Extending the
+             * file by writing at its end leaves the data as a hole in the
+             * file, which reads back as zeros.
+             */
             ssd->fp = fopen(path, "wb");
             if (ssd->fp != NULL)
             {
@@ -185,22 +205,29 @@ u32 _AXP_SSD_Create(char *path,
         }
         else
         {
+            fclose(ssd->fp);
+            ssd->fp = NULL;
             retVal = AXP_VHD_FILE_EXISTS;
         }
     }
 
     /*
      * OK, if we get this far and the return status is still successful, then
-     * we need to reopen the file for binary read/write.
+     * we need to reopen the file for binary read/write and map it into
+     * memory.
      */
     if (retVal == AXP_VHD_SUCCESS)
     {
-        ssd->fp = freopen(path, "wb+", ssd->fp);
+        ssd->fp = freopen(path, "rb+", ssd->fp);
         if (ssd->fp == NULL)
         {
             retVal = AXP_VHD_INV_HANDLE;
         }
         else
+        {
+            retVal = _AXP_SSD_Map(ssd);
+        }
+        if (retVal == AXP_VHD_SUCCESS)
         {
             *handle = (AXP_VHD_HANDLE) ssd;
         }
@@ -246,7 +273,8 @@ u32 _AXP_SSD_Create(char *path,
  *  AXP_VHD_FILE_NOT_FOUND: File Not Found.
  *  AXP_VHD_READ_FAULT:     Failed to read information from the file.
  *  AXP_VHD_OUTOFMEMORY:    Insufficient memory to perform operation.
- *  AXP_VHD_FILE_CORRUPT:   The file appears to be corrupt.
+ *  AXP_VHD_FILE_CORRUPT:   The file appears to be corrupt, or is too small
+ *                          for the size of disk in its header.
  */
 u32 _AXP_SSD_Open(char *path,
                   AXP_VHD_OPEN_FLAG flags,
@@ -256,6 +284,7 @@ u32 _AXP_SSD_Open(char *path,
     AXP_SSD_Handle *ssd;
     AXP_SSD_Geometry header;
     size_t outLen;
+    i64 fileSize;
     u32 retVal = AXP_VHD_SUCCESS;
 
     /*
@@ -270,17 +299,37 @@ u32 _AXP_SSD_Open(char *path,
          * Allocate a buffer long enough for for the filename (plus null
          * character).
          */
-        ssd->filePath = AXP_Allocate_Block(-(strlen(path) + 1), ssd->filePath);
+        ssd->filePath = AXP_Allocate_Block(-(strlen(path) + 1), NULL);
         if (ssd->filePath != NULL)
         {
-            ssd->fp = fopen(path, "rb");
+            strcpy(ssd->filePath, path);
+            ssd->deviceID = deviceID;
+
+            /*
+             * The file is opened for read/write, because the mapping of it
+             * needs to be writable.
+             */
+            ssd->fp = fopen(path, "rb+");
             if (ssd->fp != NULL)
             {
                 outLen = sizeof(header);
                 if (AXP_ReadFromOffset(ssd->fp, &header, &outLen, 0) == true)
                 {
+                    fileSize = AXP_GetFileSize(ssd->fp);
+
+                    /*
+                     * The whole of the file, from the header to the end of
+                     * the disk data, gets mapped into memory.  So, the file
+                     * has to be at least that large, or accessing the end of
+                     * the disk would be past the end of the file.
+                     */
                     if ((header.ID1 == AXP_SSD_SIG1) &&
-                        (header.ID2 == AXP_SSD_SIG2))
+                        (header.ID2 == AXP_SSD_SIG2) &&
+                        (header.byteZeroOffset >= sizeof(header)) &&
+                        (fileSize >= 0) &&
+                        ((u64) fileSize >= header.byteZeroOffset) &&
+                        (((u64) fileSize - header.byteZeroOffset) >=
+                         header.diskSize))
                     {
                         ssd->diskSize = header.diskSize;
                         ssd->blkSize = header.blkSize;
@@ -305,63 +354,487 @@ u32 _AXP_SSD_Open(char *path,
                 retVal = AXP_VHD_FILE_NOT_FOUND;
             }
         }
+        else
+        {
+            retVal = AXP_VHD_OUTOFMEMORY;
+        }
+    }
+    else
+    {
+        retVal = AXP_VHD_OUTOFMEMORY;
+    }
+
+    /*
+     * If we get here with a success status, then we have read in the header
+     * from the backing store file.  Now map the file into memory.  There is
+     * no need to read in the saved SSD data, it will be paged in as it is
+     * accessed.
+     */
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = _AXP_SSD_Map(ssd);
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            *handle = (AXP_VHD_HANDLE) ssd;
+        }
+    }
+
+    /*
+     * OK, if we don't have a success at this point, and we allocated a SSD
+     * handle, then deallocate the handle, since the SSD or its backing store
+     * file were not successfully opened.
+     */
+    if ((retVal != AXP_VHD_SUCCESS) && (ssd != NULL))
+    {
+        AXP_Deallocate_Block(ssd);
+    }
+
+    /*
+     * Return the result of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_SSD_ReadSectors
+ *  Reads one or more sectors from a solid state disk (SSD).
+ *
+ * Input Parameters:
+ *  handle:
+ *      A pointer to the handle object that represents the SSD from which to
+ *      read.
+ *  lba:
+ *      A value representing the Logical Block Address from where the read is
+ *      to be started.
+ *  sectorsRead:
+ *      A pointer to a value representing the number of sectors to be read.
+ *
+ * Output Parameters:
+ *  sectorsRead:
+ *      A pointer to an unsigned 32-bit value to receive the actual number of
+ *      sectors read.
+ *  outBuf:
+ *      A pointer to an unsigned 8-bit array in which to receive the read in
+ *      data.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ */
+u32 _AXP_SSD_ReadSectors(AXP_VHD_HANDLE handle,
+                         u64 lba,
+                         u32 *sectorsRead,
+                         u8 *outBuf)
+{
+    AXP_SSD_Handle *ssd = (AXP_SSD_Handle *) handle;
+
+    /*
+     * The parameters have already been validated, so just copy the data out
+     * of the SSD.
+     */
+    memcpy(outBuf,
+           &ssd->memory[lba * (u64) ssd->sectorSize],
+           (size_t) *sectorsRead * ssd->sectorSize);
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(AXP_VHD_SUCCESS);
+}
+
+/*
+ * _AXP_SSD_WriteSectors
+ *  Writes one or more sectors to a solid state disk (SSD).
+ *
+ * Input Parameters:
+ *  handle:
+ *      A pointer to the handle object that represents the SSD to which to
+ *      write.
+ *  lba:
+ *      A value representing the Logical Block Address from where the write is
+ *      to be started.
+ *  sectorsWritten:
+ *      A pointer to a value representing the number of sectors to be written.
+ *  inBuf:
+ *      A pointer to an unsigned 8-bit array to be written to the SSD.
+ *
+ * Output Parameters:
+ *  sectorsWritten:
+ *      A pointer to an unsigned 32-bit value to receive the actual number of
+ *      sectors written.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ */
+u32 _AXP_SSD_WriteSectors(AXP_VHD_HANDLE handle,
+                          u64 lba,
+                          u32 *sectorsWritten,
+                          u8 *inBuf)
+{
+    AXP_SSD_Handle *ssd = (AXP_SSD_Handle *) handle;
+    u64 offset = lba * (u64) ssd->sectorSize;
+    size_t bytes = (size_t) *sectorsWritten * ssd->sectorSize;
+
+    /*
+     * The parameters have already been validated, so just copy the data into
+     * the SSD.  Then mark the pages that were written to as dirty, so that
+     * they get written back to the backing store file.  The pages are marked
+     * after the copy, so that a flush that is in progress does not miss any
+     * of the data.
+     */
+    if (bytes > 0)
+    {
+        memcpy(&ssd->memory[offset], inBuf, bytes);
+        offset += ssd->byteZeroOffset;
+        _AXP_SSD_MarkDirty(ssd,
+                           offset / ssd->pageSize,
+                           (offset + bytes - 1) / ssd->pageSize);
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(AXP_VHD_SUCCESS);
+}
+
+/*
+ * _AXP_SSD_Flush
+ *  This function is called to write all the pages that have been modified,
+ *  since the last time this function was called, back to the backing store
+ *  file.  Contiguous dirty pages are written back with a single call.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A pointer to the handle object that represents the SSD to be flushed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the backing store.
+ */
+u32 _AXP_SSD_Flush(AXP_VHD_HANDLE handle)
+{
+    AXP_SSD_Handle *ssd = (AXP_SSD_Handle *) handle;
+    u64 words = (ssd->dirtyPages + 63) / 64;
+    u64 dirty;
+    u64 runStart = 0;
+    u64 runLen = 0;
+    u64 ii;
+    int jj;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    for (ii = 0; ii < words; ii++)
+    {
 
         /*
-         * If we get here with a success status, then we have read in the
-         * backing store file, now allocate the memory needed for the SSD and
-         * read in the saved SSD data from the file.
+         * Get and clear the next 64 dirty bits.  We do not hold the mutex
+         * while writing the pages back, so that writes to the SSD are not
+         * held up by the flush.
          */
-        if (retVal == AXP_VHD_SUCCESS)
+        pthread_mutex_lock(&ssd->dirtyMutex);
+        dirty = ssd->dirtyMap[ii];
+        ssd->dirtyMap[ii] = 0;
+        pthread_mutex_unlock(&ssd->dirtyMutex);
+
+        /*
+         * If none of these pages are dirty, then write out any run of dirty
+         * pages we were collecting, and move on to the next set.
+         */
+        if (dirty == 0)
         {
-            ssd->memory = (u8 *) AXP_Allocate_Block(-ssd->diskSize,
-                                                    ssd->memory);
-            if (ssd->memory != NULL)
+            if (runLen > 0)
             {
-                outLen = ssd->diskSize;
-                if (AXP_ReadFromOffset(ssd->fp,
-                                       ssd->memory,
-                                       &outLen,
-                                       ssd->byteZeroOffset) == false)
+                if (_AXP_SSD_FlushRun(ssd, runStart, runLen) != AXP_VHD_SUCCESS)
                 {
-                    retVal = AXP_VHD_READ_FAULT;
+                    retVal = AXP_VHD_WRITE_FAULT;
                 }
+                runLen = 0;
             }
-            else
+            continue;
+        }
+
+        /*
+         * Go through each of the bits, collecting runs of contiguous dirty
+         * pages.
+         */
+        for (jj = 0; jj < 64; jj++)
+        {
+            if ((dirty & (1ll << jj)) != 0)
             {
-                retVal = AXP_VHD_OUTOFMEMORY;
+                if (runLen == 0)
+                {
+                    runStart = (ii * 64) + jj;
+                }
+                runLen++;
+            }
+            else if (runLen > 0)
+            {
+                if (_AXP_SSD_FlushRun(ssd, runStart, runLen) != AXP_VHD_SUCCESS)
+                {
+                    retVal = AXP_VHD_WRITE_FAULT;
+                }
+                runLen = 0;
             }
         }
     }
 
     /*
-     * OK, if we get this far and the return status is still successful, then
-     * we need to reopen the file for binary read/write.
+     * Write out the last run of dirty pages, if there is one.
      */
+    if (runLen > 0)
+    {
+        if (_AXP_SSD_FlushRun(ssd, runStart, runLen) != AXP_VHD_SUCCESS)
+        {
+            retVal = AXP_VHD_WRITE_FAULT;
+        }
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_SSD_Close
+ *  This function is called to stop the flush thread and write all the
+ *  remaining modified pages back to the backing store file, prior to the SSD
+ *  handle being deallocated.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A pointer to the handle object that represents the SSD being closed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void _AXP_SSD_Close(AXP_VHD_HANDLE handle)
+{
+    AXP_SSD_Handle *ssd = (AXP_SSD_Handle *) handle;
+
+    /*
+     * Tell the flush thread to exit and then wait for it to do so.
+     */
+    if (ssd->flushStarted == true)
+    {
+        pthread_mutex_lock(&ssd->dirtyMutex);
+        ssd->flushStop = true;
+        pthread_cond_signal(&ssd->flushCond);
+        pthread_mutex_unlock(&ssd->dirtyMutex);
+        pthread_join(ssd->flushThread, NULL);
+        ssd->flushStarted = false;
+    }
+
+    /*
+     * Write back whatever has been modified since the last flush.
+     */
+    if (ssd->dirtyMap != NULL)
+    {
+        _AXP_SSD_Flush(handle);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * _AXP_SSD_Map
+ *  This function is called to map the backing store file into memory,
+ *  allocate the bitmap used to track the dirty pages, and start the thread
+ *  that periodically flushes the dirty pages back to the file.
+ *
+ * Input Parameters:
+ *  ssd:
+ *      A pointer to the SSD handle, with the backing store file opened for
+ *      read/write and the disk geometry filled in.
+ *
+ * Output Parameters:
+ *  ssd:
+ *      A pointer to the SSD handle, with the mapping information filled in.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_NOT_SUPPORTED:  The backing store file could not be mapped.
+ *  AXP_VHD_OUTOFMEMORY:    Insufficient memory to perform operation.
+ */
+static u32 _AXP_SSD_Map(AXP_SSD_Handle *ssd)
+{
+    u64 words;
+    u32 retVal;
+
+    ssd->mapLength = ssd->byteZeroOffset + ssd->diskSize;
+    retVal = AXP_VHD_MapImage(fileno(ssd->fp),
+                              ssd->mapLength,
+                              true,
+                              &ssd->mapAddr);
     if (retVal == AXP_VHD_SUCCESS)
     {
-        ssd->fp = freopen(path, "wb+", ssd->fp);
-        if (ssd->fp == NULL)
+        ssd->memory = &ssd->mapAddr[ssd->byteZeroOffset];
+        ssd->pageSize = sysconf(_SC_PAGESIZE);
+        ssd->dirtyPages = (ssd->mapLength + ssd->pageSize - 1) / ssd->pageSize;
+        words = (ssd->dirtyPages + 63) / 64;
+        ssd->dirtyMap = AXP_Allocate_Block(-(words * sizeof(u64)), NULL);
+        if (ssd->dirtyMap == NULL)
         {
-            retVal = AXP_VHD_INV_HANDLE;
+            retVal = AXP_VHD_OUTOFMEMORY;
         }
-        else
+    }
+
+    /*
+     * If everything has been set up, start the flush thread.  If the thread
+     * cannot be started, the dirty pages will still be flushed on close.
+     */
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        ssd->flushStop = false;
+        ssd->flushStarted = pthread_create(&ssd->flushThread,
+                                           NULL,
+                                           _AXP_SSD_FlushMain,
+                                           ssd) == 0;
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_SSD_FlushMain
+ *  This is the main function for the thread that periodically writes the
+ *  dirty pages of an SSD back to the backing store file.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the SSD handle to be flushed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL.
+ */
+static void *_AXP_SSD_FlushMain(void *arg)
+{
+    AXP_SSD_Handle *ssd = (AXP_SSD_Handle *) arg;
+    struct timespec wakeTime;
+    bool stop = false;
+
+    while (stop == false)
+    {
+
+        /*
+         * Wait for the flush interval to expire, or to be told to stop.
+         */
+        clock_gettime(CLOCK_REALTIME, &wakeTime);
+        wakeTime.tv_sec += AXP_SSD_FLUSH_SECS;
+        pthread_mutex_lock(&ssd->dirtyMutex);
+        while ((ssd->flushStop == false) &&
+               (pthread_cond_timedwait(&ssd->flushCond,
+                                       &ssd->dirtyMutex,
+                                       &wakeTime) == 0));
+        stop = ssd->flushStop;
+        pthread_mutex_unlock(&ssd->dirtyMutex);
+
+        /*
+         * If we were not told to stop, then write back the dirty pages.  The
+         * final flush is performed by the close.
+         */
+        if (stop == false)
         {
-            *handle = (AXP_VHD_HANDLE) ssd;
+            _AXP_SSD_Flush((AXP_VHD_HANDLE) ssd);
         }
     }
 
     /*
-     * OK, if we don't have a success at this point, and we allocated a SSD
-     * handle, then deallocate the handle, since the SSD or its backing store
-     * file were not successfully opened.
+     * Return back to the caller.
      */
-    if ((retVal != AXP_VHD_SUCCESS) && (ssd != NULL))
+    return(NULL);
+}
+
+/*
+ * _AXP_SSD_MarkDirty
+ *  This function is called to mark a range of pages as having been modified.
+ *
+ * Input Parameters:
+ *  ssd:
+ *      A pointer to the SSD handle.
+ *  firstPage:
+ *      A value indicating the first page, from the start of the backing
+ *      store file, that was modified.
+ *  lastPage:
+ *      A value indicating the last page that was modified.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void _AXP_SSD_MarkDirty(AXP_SSD_Handle *ssd,
+                               u64 firstPage,
+                               u64 lastPage)
+{
+    u64 page;
+
+    pthread_mutex_lock(&ssd->dirtyMutex);
+    for (page = firstPage; page <= lastPage; page++)
     {
-        AXP_Deallocate_Block(ssd);
+        ssd->dirtyMap[page / 64] |= (1ll << (page % 64));
     }
+    pthread_mutex_unlock(&ssd->dirtyMutex);
 
     /*
-     * Return the result of this call back to the caller.
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * _AXP_SSD_FlushRun
+ *  This function is called to write a run of contiguous dirty pages back to
+ *  the backing store file.  If the write fails, the pages are marked as dirty
+ *  again, so that they will be tried again on the next flush.
+ *
+ * Input Parameters:
+ *  ssd:
+ *      A pointer to the SSD handle.
+ *  firstPage:
+ *      A value indicating the first page to be written.
+ *  pages:
+ *      A value indicating the number of pages to be written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the backing store.
+ */
+static u32 _AXP_SSD_FlushRun(AXP_SSD_Handle *ssd, u64 firstPage, u64 pages)
+{
+    u64 offset = firstPage * ssd->pageSize;
+    u64 length = pages * ssd->pageSize;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    if ((offset + length) > ssd->mapLength)
+    {
+        length = ssd->mapLength - offset;
+    }
+    if (msync(&ssd->mapAddr[offset], length, MS_SYNC) != 0)
+    {
+        _AXP_SSD_MarkDirty(ssd, firstPage, firstPage + pages - 1);
+        retVal = AXP_VHD_WRITE_FAULT;
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
      */
     return(retVal);
 }
@@ -29,10 +29,34 @@
  *  either have a null value or the address of the block being allocated (so
  *  that it can be replaced) provided on the call, or the call will get a
  *  segmentation fault.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  A fixed VHD opened with OPEN_MAPPED_IO now has its data area mapped into
+ *  memory, and reads from it are a memory copy.  The file is now reopened
+ *  for read/write with "rb+", as "wb+" truncated the file we had just
+ *  created or validated.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Finished reading and writing dynamic VHDs, and added differencing VHDs.
+ *  A differencing VHD reads the blocks it does not have from its parent
+ *  chain, and copies a block from the parent the first time it is written.
+ *  The disk in the chain that holds each block is cached, so that it is only
+ *  searched for once.  Also added the ability to create a differencing VHD
+ *  as a snapshot overlay on top of a VHD that is already open.  Created VHDs
+ *  now have the disk type set in the footer, without which they could not
+ *  be opened, and the BAT padding no longer overruns the BAT buffer.
  */
 #include "CommonUtilities/AXP_Blocks.h"
 #include "Devices/VirtualDisks/AXP_VHD.h"
 #include "Devices/VirtualDisks/AXP_VHDX.h"
+#include <unistd.h>
+
+/*
+ * This is stored in the resolved block cache of a differencing VHD for a
+ * block that is not in any of the disks in the parent chain (so it reads as
+ * zeros).  A NULL entry indicates a block that has not been resolved yet.
+ */
+static AXP_VHDX_Handle _AXP_VHD_NoBlock;
 
 /*
  * AXP_VHD_Checksum
@@ -192,7 +216,7 @@ void AXP_VHD_CHSCalc(u64 diskSize, u32 sectorSize, AXP_VHD_DiskGeo *chs)
 }
 
 /*
- * _AXP_VHD_Create
+ * _AXP_VHD_CreateImage
  *  Creates a virtual hard disk (VHD) image file.
  *
  * Input Parameters:
@@ -202,12 +226,11 @@ void AXP_VHD_CHSCalc(u64 diskSize, u32 sectorSize, AXP_VHD_DiskGeo *chs)
  *  flags:
  *      Creation flags, which must be a valid combination of the
  *      AXP_VHD_CREATE_FLAG enumeration.
- *  parentPath:
- *      A pointer to a valid string that represents the path to the parent
- *      virtual disk image file.  This means that we are creating a
- *      differential VHD.
- *  parentDevID:
- *      An unsigned 32-bit value indicating the disk type of the parent.
+ *  parent:
+ *      A pointer to the handle of the open parent VHD.  This means that we are
+ *      creating a differencing VHD, which takes its size, and if the parent is
+ *      not fixed, its block size, from the parent.  This parameter is NULL
+ *      for fixed and dynamic VHDs.
  *  diskSize:
  *      An unsigned 64-bit value for the size of the disk to be created, in
  *      bytes.
@@ -230,15 +253,14 @@ void AXP_VHD_CHSCalc(u64 diskSize, u32 sectorSize, AXP_VHD_DiskGeo *chs)
  *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the VHD file.
  *  AXP_VHD_OUTOFMEMORY:    Insufficient memory to perform operation.
  */
-u32 _AXP_VHD_Create(char *path,
-                    AXP_VHD_CREATE_FLAG flags,
-                    char *parentPath,
-                    u32 parentDevID,
-                    u64 diskSize,
-                    u32 blkSize,
-                    u32 sectorSize,
-                    u32 deviceID,
-                    AXP_VHD_HANDLE *handle)
+static u32 _AXP_VHD_CreateImage(char *path,
+                                AXP_VHD_CREATE_FLAG flags,
+                                AXP_VHDX_Handle *parent,
+                                u64 diskSize,
+                                u32 blkSize,
+                                u32 sectorSize,
+                                u32 deviceID,
+                                AXP_VHD_HANDLE *handle)
 {
     AXP_VHDX_Handle *vhd;
     AXP_VHD_Footer foot;
@@ -248,6 +270,20 @@ u32 _AXP_VHD_Create(char *path,
     u32 retVal = AXP_VHD_SUCCESS;
     bool writeRet = true;
 
+    /*
+     * A differencing disk is the same size as its parent, and uses the same
+     * block size, so that a block in the differencing disk is a block in the
+     * parent.
+     */
+    if (parent != NULL)
+    {
+        diskSize = parent->diskSize;
+        if (parent->fixed == false)
+        {
+            blkSize = parent->blkSize;
+        }
+    }
+
     /*
      * Let's allocate the block we need to maintain access to the virtual disk
      * image.
@@ -266,7 +302,8 @@ u32 _AXP_VHD_Create(char *path,
             vhd->diskSize = diskSize;
             vhd->blkSize = blkSize;
             vhd->sectorSize = sectorSize;
-            vhd->fixed = (flags == CREATE_FULL_PHYSICAL_ALLOCATION);
+            vhd->fixed = (flags == CREATE_FULL_PHYSICAL_ALLOCATION) &&
+                         (parent == NULL);
         }
         else
         {
@@ -406,6 +443,18 @@ u32 _AXP_VHD_Create(char *path,
         foot.creatorHostOS = AXP_CREATOR_HOST;
         foot.originalSize = foot.currentSize = diskSize;
         AXP_VHD_CHSCalc(diskSize, sectorSize, &foot.chs);
+        if (vhd->fixed == true)
+        {
+            foot.diskType = DiskFixed;
+        }
+        else if (parent != NULL)
+        {
+            foot.diskType = DiskDifferencing;
+        }
+        else
+        {
+            foot.diskType = DiskDynamic;
+        }
         foot.checksum = AXP_VHD_Checksum((u8 *) &foot, sizeof(AXP_VHD_Footer));
 
         /*
@@ -458,9 +507,8 @@ u32 _AXP_VHD_Create(char *path,
          */
         if (vhd->fixed == false)
         {
-            u32 unused, ii;
+            u32 batBytes, ii;
             u64 curOffset = 0;
-            AXP_VHD_BAT_ENT blockOff = AXP_VHD_BAT_UNUSED;
 
             /*
              * Because this is a dynamic file, the footer is replicated at the
@@ -479,33 +527,53 @@ u32 _AXP_VHD_Create(char *path,
             dyn.dataOff = AXP_VHD_DATA_OFFSET;
             vhd->batOffset = dyn.tableOff = sizeof(AXP_VHD_Footer) +
                     sizeof(AXP_VHD_Dynamic);
-            vhd->batCount = dyn.maxTableEnt = diskSize / blkSize;
+            vhd->batCount = dyn.maxTableEnt =
+                (diskSize + blkSize - 1) / blkSize;
             vhd->batLength = vhd->batCount * sizeof(AXP_VHD_BAT_ENT);
             dyn.headerVer = AXP_VHD_HEADER_VER;
             dyn.blockSize = blkSize;
-            dyn.checksum = AXP_VHD_Checksum((u8 *) &dyn,
-                                            sizeof(AXP_VHD_Dynamic));
 
             /*
              * Now we need to figure out the Block Allocation Table (BAT).  The
              * BAT always ends on a sector boundary, so we may have some
-             * additional unused BAT entries.
-             *
-             * The number of unused entries is the distance, in u32 values, to
-             * the end of the sector.  This is calculated as follows:
-             *
-             *  sectorSize - ((tableOffset + tableSize) % sectorSize)
-             *  tableSize = maxTableEntries * 4 [size of 32-bit offset value]
-             *
+             * additional unused BAT entries.  These are written out, but are
+             * not part of the BAT length.  Everything after the BAT (the
+             * parent locator and the data blocks) is then on a sector
+             * boundary, as the BAT entries are sector offsets.
+             */
+            batBytes = ((dyn.tableOff + vhd->batLength + sectorSize - 1) /
+                        sectorSize) * sectorSize - dyn.tableOff;
+
+            /*
+             * If this is a differencing disk, then the path to the parent is
+             * stored in a parent locator, immediately after the BAT.  We use
+             * the Mac OS X locator code, which is for a UTF-8 file
+             * specification.  The parent name is also stored, which for us is
+             * just the path widened to 16-bits.
              */
-            unused = sectorSize -
-                    ((dyn.tableOff + (dyn.maxTableEnt * sizeof(u32))) %
-                       sectorSize);
+            if (parent != NULL)
+            {
+                u32 pathLen = strlen(parent->filePath);
 
-            vhd->bat = AXP_Allocate_Block(-vhd->batLength, vhd->bat);
+                dyn.parentLoc[0].code = AXP_VHD_PCODE_MACX;
+                dyn.parentLoc[0].dataLen = pathLen;
+                dyn.parentLoc[0].dataSpace =
+                    (pathLen + sectorSize - 1) / sectorSize;
+                dyn.parentLoc[0].dataOff = dyn.tableOff + batBytes;
+                for (ii = 0;
+                     ((ii < pathLen) && (ii < AXP_VHD_PARENT_NAME_LEN));
+                     ii++)
+                {
+                    dyn.parentName[ii] = (u8) parent->filePath[ii];
+                }
+            }
+            dyn.checksum = AXP_VHD_Checksum((u8 *) &dyn,
+                                            sizeof(AXP_VHD_Dynamic));
+
+            vhd->bat = AXP_Allocate_Block(-(i32) batBytes, NULL);
             if (vhd->bat != NULL)
             {
-                AXP_VHD_BAT_ENT *batPtr = (AXP_VHD_BAT_ENT *) vhd->bat;
+                memset(vhd->bat, 0xff, batBytes); /* AXP_VHD_BAT_UNUSED */
 
                 /*
                  * So we are ready to write out the dynamic portions of the VHD
@@ -514,13 +582,13 @@ u32 _AXP_VHD_Create(char *path,
                  *   1) Copy of hard disk footer    512
                  *   2) Dynamic Disk Header        1024
                  *   3) BAT (Block Allocation table)    As needed.
-                 *   4) Hard Disk Footer        512
+                 *   4) Parent Locator (differencing only) As needed.
+                 *   5) Hard Disk Footer        512
                  */
                 writeRet = AXP_WriteAtOffset(vhd->fp,
                                              &foot,
                                              sizeof(AXP_VHD_Footer),
                                              curOffset);
-                dyn.tableOff = 0; /* there is nothing after the footer record */
                 curOffset += sizeof(AXP_VHD_Footer);
                 if (writeRet == true)
                 {
@@ -530,18 +598,40 @@ u32 _AXP_VHD_Create(char *path,
                                                  curOffset);
                 }
                 curOffset += sizeof(AXP_VHD_Dynamic);
-                for (ii = 0;
-                     ((ii < (dyn.maxTableEnt + unused)) && (writeRet == true));
-                     ii++)
+                if (writeRet == true)
                 {
-                    batPtr[ii] = blockOff;
                     writeRet = AXP_WriteAtOffset(vhd->fp,
-                                                 &blockOff,
-                                                 sizeof(blockOff),
+                                                 vhd->bat,
+                                                 batBytes,
                                                  curOffset);
-                    curOffset += sizeof(blockOff);
                 }
-                eofOff = curOffset;
+                curOffset += batBytes;
+                if ((writeRet == true) && (parent != NULL))
+                {
+                    char *locator;
+
+                    locator = AXP_Allocate_Block(
+                        -(i32) (dyn.parentLoc[0].dataSpace * sectorSize),
+                        NULL);
+                    if (locator != NULL)
+                    {
+                        memcpy(locator,
+                               parent->filePath,
+                               dyn.parentLoc[0].dataLen);
+                        writeRet = AXP_WriteAtOffset(
+                            vhd->fp,
+                            locator,
+                            dyn.parentLoc[0].dataSpace * sectorSize,
+                            curOffset);
+                        curOffset += dyn.parentLoc[0].dataSpace * sectorSize;
+                        AXP_Deallocate_Block(locator);
+                    }
+                    else
+                    {
+                        retVal = AXP_VHD_OUTOFMEMORY;
+                    }
+                }
+                eofOff = vhd->footerOffset = curOffset;
             }
             else
             {
@@ -563,9 +653,26 @@ u32 _AXP_VHD_Create(char *path,
                                          sizeof(AXP_VHD_Footer),
                                          eofOff);
         }
+
+        /*
+         * A differencing disk needs somewhere to cache which disk in the
+         * parent chain holds each block.
+         */
+        if ((writeRet == true) &&
+            (retVal == AXP_VHD_SUCCESS) &&
+            (parent != NULL))
+        {
+            vhd->resolved = AXP_Allocate_Block(
+                -(i32) (vhd->batCount * sizeof(void *)),
+                NULL);
+            if (vhd->resolved == NULL)
+            {
+                retVal = AXP_VHD_OUTOFMEMORY;
+            }
+        }
         if ((writeRet == true) && (retVal == AXP_VHD_SUCCESS))
         {
-            vhd->fp = freopen(path, "wb+", vhd->fp);
+            vhd->fp = freopen(path, "rb+", vhd->fp);
             if (vhd->fp == NULL)
             {
                 remove(path); /* Delete the file */
@@ -574,6 +681,17 @@ u32 _AXP_VHD_Create(char *path,
             }
             else
             {
+
+                /*
+                 * The parent of a differencing disk can no longer be written,
+                 * as this would change what is seen through the differencing
+                 * disk.
+                 */
+                if (parent != NULL)
+                {
+                    vhd->parent = parent;
+                    parent->readOnly = true;
+                }
                 *handle = (AXP_VHD_HANDLE) vhd;
             }
         }
@@ -599,6 +717,253 @@ u32 _AXP_VHD_Create(char *path,
     return (retVal);
 }
 
+/*
+ * _AXP_VHD_Create
+ *  Creates a virtual hard disk (VHD) image file.
+ *
+ * Input Parameters:
+ *  path:
+ *      A pointer to a valid string that represents the path to the new virtual
+ *      disk image file.
+ *  flags:
+ *      Creation flags, which must be a valid combination of the
+ *      AXP_VHD_CREATE_FLAG enumeration.
+ *  parentPath:
+ *      A pointer to a valid string that represents the path to the parent
+ *      virtual disk image file.  This means that we are creating a
+ *      differential VHD.
+ *  parentDevID:
+ *      An unsigned 32-bit value indicating the disk type of the parent.
+ *  diskSize:
+ *      An unsigned 64-bit value for the size of the disk to be created, in
+ *      bytes.
+ *  blkSize:
+ *      An unsigned 32-bit value for the size of each block.
+ *  sectorSize:
+ *      An unsigned 32-bit value for the size of each sector.
+ *  deviceID:
+ *      An unsigned 32-bit value indicating the desired disk type.
+ *
+ * Output Parameters:
+ *  handle:
+ *      A pointer to the handle object that represents the newly created
+ *      virtual disk.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_FILE_EXISTS:    File already exists.
+ *  AXP_VHD_INV_HANDLE:     Failed to create the VHDX file.
+ *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the VHD file.
+ *  AXP_VHD_OUTOFMEMORY:    Insufficient memory to perform operation.
+ *  AXP_VHD_NOT_SUPPORTED:  The parent is not a VHD.
+ *  Other:                  The status returned opening the parent.
+ */
+u32 _AXP_VHD_Create(char *path,
+                    AXP_VHD_CREATE_FLAG flags,
+                    char *parentPath,
+                    u32 parentDevID,
+                    u64 diskSize,
+                    u32 blkSize,
+                    u32 sectorSize,
+                    u32 deviceID,
+                    AXP_VHD_HANDLE *handle)
+{
+    AXP_VHD_HANDLE parent = NULL;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    /*
+     * If we are creating a differencing disk, then we need to open the parent
+     * first.  We only support VHD parents.
+     */
+    if (parentPath != NULL)
+    {
+        if (parentDevID == STORAGE_TYPE_DEV_VHD)
+        {
+            retVal = _AXP_VHD_Open(parentPath,
+                                   OPEN_NONE,
+                                   STORAGE_TYPE_DEV_VHD,
+                                   &parent);
+        }
+        else
+        {
+            retVal = AXP_VHD_NOT_SUPPORTED;
+        }
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = _AXP_VHD_CreateImage(path,
+                                      flags,
+                                      (AXP_VHDX_Handle *) parent,
+                                      diskSize,
+                                      blkSize,
+                                      sectorSize,
+                                      deviceID,
+                                      handle);
+    }
+
+    /*
+     * We opened the parent, so the differencing disk closes it when it is
+     * closed.  If we failed to create the differencing disk, close it now.
+     */
+    if (parent != NULL)
+    {
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            ((AXP_VHDX_Handle *) *handle)->parentOwned = true;
+        }
+        else
+        {
+            AXP_Deallocate_Block(parent);
+        }
+    }
+
+    /*
+     * Return the result of this call back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * _AXP_VHD_CreateOverlay
+ *  Creates a differencing virtual hard disk (VHD) image file on top of a VHD
+ *  that is already open.  The open VHD becomes the parent of the new VHD and
+ *  can no longer be written, but continues to belong to the caller, who must
+ *  not close it until all the overlays on top of it have been closed.  Any
+ *  number of overlays can be created on top of the same parent.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open VHD.
+ *  path:
+ *      A pointer to a valid string that represents the path to the new virtual
+ *      disk image file.
+ *
+ * Output Parameters:
+ *  overlay:
+ *      A pointer to the handle object that represents the newly created
+ *      differencing virtual disk.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_FILE_EXISTS:    File already exists.
+ *  AXP_VHD_INV_HANDLE:     Failed to create the VHD file.
+ *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the VHD file.
+ *  AXP_VHD_OUTOFMEMORY:    Insufficient memory to perform operation.
+ */
+u32 _AXP_VHD_CreateOverlay(AXP_VHD_HANDLE handle,
+                           char *path,
+                           AXP_VHD_HANDLE *overlay)
+{
+    AXP_VHDX_Handle *parent = (AXP_VHDX_Handle *) handle;
+
+    /*
+     * The parent is read directly from its file descriptor by the overlay,
+     * so make sure anything written to it is out of the stream buffers.
+     */
+    fflush(parent->fp);
+    return (_AXP_VHD_CreateImage(path,
+                                 CREATE_NONE,
+                                 parent,
+                                 parent->diskSize,
+                                 AXP_VHD_BLK_DEF,
+                                 parent->sectorSize,
+                                 STORAGE_TYPE_DEV_VHD,
+                                 overlay));
+}
+
+/*
+ * _AXP_VHD_OpenParent
+ *  This function is called when opening a differencing VHD to open its
+ *  parent, using the path in the parent locator.  The parent must be a VHD of
+ *  the same size and, unless it is fixed, the same block size.
+ *
+ * Input Parameters:
+ *  vhd:
+ *      A pointer to the handle of the differencing VHD being opened.
+ *  loc:
+ *      A pointer to the parent locator entry from the Dynamic Disk Header.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_FILE_CORRUPT:   The parent locator is not one we wrote, or the
+ *                          parent does not match the differencing disk.
+ *  AXP_VHD_READ_FAULT:     Failed to read the parent locator.
+ *  AXP_VHD_OUTOFMEMORY:    Insufficient memory to perform operation.
+ *  Other:                  The status returned opening the parent.
+ */
+static u32 _AXP_VHD_OpenParent(AXP_VHDX_Handle *vhd, AXP_VHD_ParentLoc *loc)
+{
+    AXP_VHDX_Handle *parent = NULL;
+    char *parentPath;
+    size_t outLen;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    if ((loc->code != AXP_VHD_PCODE_MACX) ||
+        (loc->dataLen == 0) ||
+        (loc->dataLen > (loc->dataSpace * vhd->sectorSize)))
+    {
+        return (AXP_VHD_FILE_CORRUPT);
+    }
+    parentPath = AXP_Allocate_Block(-(i32) (loc->dataLen + 1), NULL);
+    if (parentPath == NULL)
+    {
+        return (AXP_VHD_OUTOFMEMORY);
+    }
+    outLen = loc->dataLen;
+    if ((AXP_ReadFromOffset(vhd->fp, parentPath, &outLen, loc->dataOff) ==
+         false) ||
+        (outLen != loc->dataLen))
+    {
+        retVal = AXP_VHD_READ_FAULT;
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = _AXP_VHD_Open(parentPath,
+                               OPEN_NONE,
+                               STORAGE_TYPE_DEV_VHD,
+                               (AXP_VHD_HANDLE *) &parent);
+    }
+    AXP_Deallocate_Block(parentPath);
+
+    /*
+     * A block in the differencing disk has to be the same block in the parent.
+     */
+    if ((retVal == AXP_VHD_SUCCESS) &&
+        ((parent->diskSize != vhd->diskSize) ||
+         ((parent->fixed == false) && (parent->blkSize != vhd->blkSize))))
+    {
+        retVal = AXP_VHD_FILE_CORRUPT;
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        vhd->resolved = AXP_Allocate_Block(
+            -(i32) (vhd->batCount * sizeof(void *)),
+            NULL);
+        if (vhd->resolved == NULL)
+        {
+            retVal = AXP_VHD_OUTOFMEMORY;
+        }
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        parent->readOnly = true;
+        vhd->parent = parent;
+        vhd->parentOwned = true;
+    }
+    else if (parent != NULL)
+    {
+        AXP_Deallocate_Block(parent);
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return (retVal);
+}
+
 /*
  * _AXP_VHD_Open
  *  This function is called to open a VHD virtual disk.
@@ -632,6 +997,8 @@ u32 _AXP_VHD_Open(char *path,
 {
     AXP_VHDX_Handle *vhd;
     AXP_VHD_Footer *footer;
+    AXP_VHD_ParentLoc loc;
+    bool differencing = false;
     u8 footerBuf[sizeof(AXP_VHD_Footer) + 1];
     i64 fileSize;
     size_t outLen;
@@ -763,11 +1130,18 @@ u32 _AXP_VHD_Open(char *path,
                                 vhd->cylinders = footer->chs.cylinders;
                                 vhd->heads = footer->chs.heads;
                                 vhd->sectors = footer->chs.sectors;
-                                vhd->sectorSize = vhd->diskSize /
-                                        ((u64) vhd->cylinders *
-                                         (u64) vhd->heads *
-                                         (u64) vhd->sectors);
+
+                                /*
+                                 * VHDs only have 512 byte sectors.  The CHS
+                                 * geometry is rounded, so it cannot be used
+                                 * to calculate the sector size.
+                                 */
+                                vhd->sectorSize = AXP_VHD_SEC_DEF;
                                 vhd->fixed = footer->diskType == DiskFixed;
+                                vhd->footerOffset = fileSize -
+                                        sizeof(AXP_VHD_Footer);
+                                differencing =
+                                        footer->diskType == DiskDifferencing;
                             }
                             else
                             {
@@ -822,6 +1196,10 @@ u32 _AXP_VHD_Open(char *path,
                                         vhd->batLength = dyn.maxTableEnt *
                                                 sizeof(u32);
                                         vhd->blkSize = dyn.blockSize;
+                                        if (differencing == true)
+                                        {
+                                            loc = dyn.parentLoc[0];
+                                        }
                                     }
                                     else
                                     {
@@ -856,6 +1234,20 @@ u32 _AXP_VHD_Open(char *path,
                                 {
                                     retVal = AXP_VHD_OUTOFMEMORY;
                                 }
+
+                                /*
+                                 * If this is a differencing disk, then open
+                                 * its parent (which will open its parent, and
+                                 * so on), unless we were asked not to.
+                                 * Without its parent, the blocks not in this
+                                 * disk read as zeros.
+                                 */
+                                if ((retVal == AXP_VHD_SUCCESS) &&
+                                    (differencing == true) &&
+                                    (flags != OPEN_NO_PARENTS))
+                                {
+                                    retVal = _AXP_VHD_OpenParent(vhd, &loc);
+                                }
                             }
                             else
                             {
@@ -894,7 +1286,7 @@ u32 _AXP_VHD_Open(char *path,
      */
     if (retVal == AXP_VHD_SUCCESS)
     {
-        vhd->fp = freopen(path, "wb+", vhd->fp);
+        vhd->fp = freopen(path, "rb+", vhd->fp);
         if (vhd->fp == NULL)
         {
             retVal = AXP_VHD_INV_HANDLE;
@@ -905,6 +1297,26 @@ u32 _AXP_VHD_Open(char *path,
         }
     }
 
+    /*
+     * If we were asked to use mapped I/O and this is a fixed VHD, then the
+     * data area is a straight linear mapping of LBA to file offset, starting
+     * at the beginning of the file.  Map just the data area (the footer is
+     * not part of the disk).  If the mapping cannot be established, we just
+     * fall back to file I/O.
+     */
+    if ((retVal == AXP_VHD_SUCCESS) &&
+        (flags == OPEN_MAPPED_IO) &&
+        (vhd->fixed == true))
+    {
+        if (AXP_VHD_MapImage(fileno(vhd->fp),
+                             vhd->diskSize,
+                             false,
+                             &vhd->mapAddr) == AXP_VHD_SUCCESS)
+        {
+            vhd->mapLength = vhd->diskSize;
+        }
+    }
+
     /*
      * OK, if we don't have a success at this point, and we allocated a VHD
      * handle, then deallocate the handle, since the VHD was not successfully
@@ -921,6 +1333,253 @@ u32 _AXP_VHD_Open(char *path,
     return (retVal);
 }
 
+/*
+ * _AXP_VHD_BlockOffset
+ *  This function is called to determine where, in the file for a disk in a
+ *  parent chain, the data for a block starts.  For a fixed VHD, this is just
+ *  the block's offset on the disk.  For a dynamic or differencing VHD, the
+ *  block must be in the file, and the data follows the sector bitmap.
+ *
+ * Input Parameters:
+ *  layer:
+ *      A pointer to the handle of the disk in the parent chain holding the
+ *      block.
+ *  blkSize:
+ *      A value indicating the block size of the disk being accessed (a fixed
+ *      VHD does not have a block size of its own).
+ *  blkNum:
+ *      A value indicating the block number on the disk.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The offset within the file for the first byte of the block.
+ */
+static u64 _AXP_VHD_BlockOffset(AXP_VHDX_Handle *layer, u32 blkSize, u64 blkNum)
+{
+    AXP_VHD_BAT_ENT *bat = (AXP_VHD_BAT_ENT *) layer->bat;
+
+    if (layer->fixed == true)
+    {
+        return (blkNum * blkSize);
+    }
+    return (((u64) bat[blkNum] +
+             AXP_VHD_BITMAP_SECTS(layer->blkSize, layer->sectorSize)) *
+            layer->sectorSize);
+}
+
+/*
+ * _AXP_VHD_ReadLayer
+ *  This function is called to read data from a disk in a parent chain.  The
+ *  file descriptor is read directly, rather than through the stream, because
+ *  a parent may be shared by several differencing disks, which may be
+ *  reading it at the same time.  Anything past the end of the file reads as
+ *  zeros.
+ *
+ * Input Parameters:
+ *  layer:
+ *      A pointer to the handle of the disk to be read.
+ *  offset:
+ *      A value indicating the offset within the file to start reading.
+ *  bytes:
+ *      A value indicating the number of bytes to be read.
+ *
+ * Output Parameters:
+ *  outBuf:
+ *      A pointer to the buffer to receive the data read.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_READ_FAULT:     An error occurred reading from the VHD file.
+ */
+static u32 _AXP_VHD_ReadLayer(AXP_VHDX_Handle *layer,
+                              u64 offset,
+                              u8 *outBuf,
+                              size_t bytes)
+{
+    ssize_t readLen;
+    size_t done = 0;
+
+    while (done < bytes)
+    {
+        readLen = pread(fileno(layer->fp),
+                        &outBuf[done],
+                        bytes - done,
+                        offset + done);
+        if (readLen < 0)
+        {
+            return (AXP_VHD_READ_FAULT);
+        }
+        else if (readLen == 0)
+        {
+            memset(&outBuf[done], 0, bytes - done);
+            break;
+        }
+        done += readLen;
+    }
+    return (AXP_VHD_SUCCESS);
+}
+
+/*
+ * _AXP_VHD_ResolveBlock
+ *  This function is called to determine which disk in a parent chain holds a
+ *  block.  This is the first disk, starting with the one being accessed,
+ *  that is fixed or has the block in its BAT.  For a differencing disk, the
+ *  result is cached, so that the chain is only searched the first time a
+ *  block is accessed.  Since the parents cannot be written, the only thing
+ *  that changes the result is this disk adding the block, which updates the
+ *  cache.
+ *
+ * Input Parameters:
+ *  vhd:
+ *      A pointer to the handle of the disk being accessed.
+ *  blkNum:
+ *      A value indicating the block number on the disk.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL:       None of the disks have the block, so it reads as zeros.
+ *  Not NULL:   A pointer to the handle of the disk holding the block.
+ */
+static AXP_VHDX_Handle *_AXP_VHD_ResolveBlock(AXP_VHDX_Handle *vhd,
+                                              u64 blkNum)
+{
+    AXP_VHDX_Handle *layer = NULL;
+
+    if (vhd->resolved != NULL)
+    {
+        layer = (AXP_VHDX_Handle *) vhd->resolved[blkNum];
+    }
+    if (layer == NULL)
+    {
+        layer = vhd;
+        while ((layer != NULL) &&
+               (layer->fixed == false) &&
+               (((AXP_VHD_BAT_ENT *) layer->bat)[blkNum] ==
+                AXP_VHD_BAT_UNUSED))
+        {
+            layer = (AXP_VHDX_Handle *) layer->parent;
+        }
+        if (vhd->resolved != NULL)
+        {
+            vhd->resolved[blkNum] = (layer != NULL) ? layer : &_AXP_VHD_NoBlock;
+        }
+    }
+    else if (layer == &_AXP_VHD_NoBlock)
+    {
+        layer = NULL;
+    }
+    return (layer);
+}
+
+/*
+ * _AXP_VHD_AllocateBlock
+ *  This function is called to add a block to the end of a dynamic or
+ *  differencing VHD file.  For a differencing disk, the contents of the block
+ *  are copied from the parent chain, otherwise the block is zeroed.  All the
+ *  bits in the sector bitmap are set, as all the sectors are now in this
+ *  file.  The footer is moved after the new block, and then the BAT entry is
+ *  updated.
+ *
+ * Input Parameters:
+ *  vhd:
+ *      A pointer to the handle of the disk being written.
+ *  blkNum:
+ *      A value indicating the block number on the disk.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_READ_FAULT:     An error occurred reading from the parent.
+ *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the VHD file.
+ *  AXP_VHD_OUTOFMEMORY:    Insufficient memory to perform operation.
+ */
+static u32 _AXP_VHD_AllocateBlock(AXP_VHDX_Handle *vhd, u64 blkNum)
+{
+    AXP_VHD_BAT_ENT *bat = (AXP_VHD_BAT_ENT *) vhd->bat;
+    AXP_VHDX_Handle *layer;
+    AXP_VHD_Footer foot;
+    AXP_VHD_BAT_ENT batEnt;
+    u8 *blkBuf;
+    size_t outLen = sizeof(AXP_VHD_Footer);
+    u32 bitmapLen = AXP_VHD_BITMAP_SECTS(vhd->blkSize, vhd->sectorSize) *
+                    vhd->sectorSize;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    /*
+     * Get the footer, before we write over it.
+     */
+    if (AXP_ReadFromOffset(vhd->fp, &foot, &outLen, vhd->footerOffset) ==
+        false)
+    {
+        return (AXP_VHD_READ_FAULT);
+    }
+    blkBuf = AXP_Allocate_Block(-(i32) (bitmapLen + vhd->blkSize), NULL);
+    if (blkBuf == NULL)
+    {
+        return (AXP_VHD_OUTOFMEMORY);
+    }
+    memset(blkBuf, 0xff, bitmapLen);
+    if (vhd->parent != NULL)
+    {
+        layer = _AXP_VHD_ResolveBlock(vhd, blkNum);
+        if (layer != NULL)
+        {
+            retVal = _AXP_VHD_ReadLayer(layer,
+                                        _AXP_VHD_BlockOffset(layer,
+                                                             vhd->blkSize,
+                                                             blkNum),
+                                        &blkBuf[bitmapLen],
+                                        vhd->blkSize);
+        }
+    }
+
+    /*
+     * Write the block where the footer was, the footer after it, and then
+     * point the BAT entry at the block.  The BAT entry is the sector offset
+     * of the block.
+     */
+    batEnt = vhd->footerOffset / vhd->sectorSize;
+    if ((retVal == AXP_VHD_SUCCESS) &&
+        ((AXP_WriteAtOffset(vhd->fp,
+                            blkBuf,
+                            bitmapLen + vhd->blkSize,
+                            vhd->footerOffset) == false) ||
+         (AXP_WriteAtOffset(vhd->fp,
+                            &foot,
+                            sizeof(AXP_VHD_Footer),
+                            vhd->footerOffset + bitmapLen + vhd->blkSize) ==
+          false) ||
+         (AXP_WriteAtOffset(vhd->fp,
+                            &batEnt,
+                            sizeof(AXP_VHD_BAT_ENT),
+                            vhd->batOffset +
+                            (blkNum * sizeof(AXP_VHD_BAT_ENT))) == false)))
+    {
+        retVal = AXP_VHD_WRITE_FAULT;
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        vhd->footerOffset += bitmapLen + vhd->blkSize;
+        bat[blkNum] = batEnt;
+        if (vhd->resolved != NULL)
+        {
+            vhd->resolved[blkNum] = vhd;
+        }
+    }
+    AXP_Deallocate_Block(blkBuf);
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return (retVal);
+}
+
 /*
  * _AXP_VHD_ReadSectors
  *  Reads one or more sectors from a virtual hard disk (VHD) image file.
@@ -959,9 +1618,16 @@ u32 _AXP_VHD_ReadSectors(AXP_VHD_HANDLE handle,
 
     /*
      * If this is a fixed sized VHD, then all the blocks for the disk have been
-     * preallocated.  Go ahead and read from the file.
+     * preallocated.  If the image is mapped, then the read is just a copy
+     * from the mapping (which is served out of the host page cache).
+     * Otherwise, go ahead and read from the file.
      */
-    if (vhd->fixed == true)
+    if ((vhd->fixed == true) && (vhd->mapAddr != NULL))
+    {
+        offset = lba * (u64) vhd->sectorSize;
+        memcpy(outBuf, &vhd->mapAddr[offset], *sectorsRead * vhd->sectorSize);
+    }
+    else if (vhd->fixed == true)
     {
         offset = lba * (u64) vhd->sectorSize;
         *sectorsRead *= vhd->sectorSize;
@@ -976,49 +1642,52 @@ u32 _AXP_VHD_ReadSectors(AXP_VHD_HANDLE handle,
     }
 
     /*
-     * OK, we have a dynamic VHD.  We need to determine a few things.  First,
-     * is the block we are looking to read in the file.  And second, if it is,
-     * then find out where it is located and read it in.  NOTE: There is
-     * nothing to say that sectors are continuous, so we are going to have read
-     * them in one at a time.
+     * OK, we have a dynamic or differencing VHD.  For each block in the
+     * request, find out which disk in the parent chain holds the block.  If
+     * none of them do, then the block has never been written and reads as
+     * zeros.  NOTE: There is nothing to say that blocks are contiguous in the
+     * file, so we read one block's worth at a time.
      */
     else
     {
-        AXP_VHD_BAT_ENT *bat = (AXP_VHD_BAT_ENT *) vhd->bat;
+        AXP_VHDX_Handle *layer;
         u8 *bufPtr = outBuf;
         u32 sectorsPerBlk = vhd->blkSize / vhd->sectorSize;
-        u64 blkNum = lba / (u64) sectorsPerBlk;
-        u32 bitMapBytes = (7 + sectorsPerBlk) / 8;
-        u32 bitMapSects = (bitMapBytes + vhd->sectorSize - 1) / vhd->sectorSize;
-        u32 sectorsInRead = sectorsPerBlk - lba % sectorsPerBlk;
         u32 sectorsRem = *sectorsRead;
-        u64 bytesInRead = sectorsInRead * vhd->sectorSize;
+        u32 sectorsInRead;
+        u64 blkNum;
 
         *sectorsRead = 0;
         while ((sectorsRem > 0) && (retVal == AXP_VHD_SUCCESS))
         {
-            if (bat[blkNum] == AXP_VHD_BAT_UNUSED)
+            blkNum = lba / sectorsPerBlk;
+            sectorsInRead = sectorsPerBlk - (lba % sectorsPerBlk);
+            if (sectorsInRead > sectorsRem)
+            {
+                sectorsInRead = sectorsRem;
+            }
+            layer = _AXP_VHD_ResolveBlock(vhd, blkNum);
+            if (layer == NULL)
             {
-                memset(bufPtr, 0, bytesInRead);
+                memset(bufPtr, 0, sectorsInRead * vhd->sectorSize);
             }
             else
             {
-                offset = ((u64) bat[blkNum] + lba % (u64) sectorsPerBlk
-                        + (u64) bitMapSects)
-                        * (u64) vhd->sectorSize;
-                if (AXP_ReadFromOffset(vhd->fp,
-                                       bufPtr,
-                                       (size_t *) &bytesInRead,
-                                       offset) == true)
-                {
-                    /* TODO: finish */
-                    sectorsRem -= sectorsInRead;
-                    bufPtr = &bufPtr[bytesInRead];
-                }
-                else
-                {
-                    retVal = AXP_VHD_READ_FAULT;
-                }
+                retVal = _AXP_VHD_ReadLayer(layer,
+                                            _AXP_VHD_BlockOffset(layer,
+                                                                 vhd->blkSize,
+                                                                 blkNum) +
+                                            ((lba % sectorsPerBlk) *
+                                             vhd->sectorSize),
+                                            bufPtr,
+                                            sectorsInRead * vhd->sectorSize);
+            }
+            if (retVal == AXP_VHD_SUCCESS)
+            {
+                *sectorsRead += sectorsInRead;
+                sectorsRem -= sectorsInRead;
+                lba += sectorsInRead;
+                bufPtr = &bufPtr[sectorsInRead * vhd->sectorSize];
             }
         }
     }
@@ -1064,17 +1733,25 @@ u32 _AXP_VHD_WriteSectors(AXP_VHD_HANDLE handle,
     u64 offset;
     u32 retVal = AXP_VHD_SUCCESS;
 
+    /*
+     * The parent of a differencing disk cannot be written.
+     */
+    if (vhd->readOnly == true)
+    {
+        retVal = AXP_VHD_FILE_READ_ONLY;
+    }
+
     /*
      * If this is a fixed sized VHD, then all the blocks for the disk have been
-     * preallocated.  Go ahead and read from the file.
+     * preallocated.  Go ahead and write to the file.
      */
-    if (vhd->fixed == true)
+    else if (vhd->fixed == true)
     {
         offset = lba * (u64) vhd->sectorSize;
         *sectorsWritten *= vhd->sectorSize;
         if (AXP_WriteAtOffset(vhd->fp,
                               inBuf,
-                              (size_t) sectorsWritten,
+                              (size_t) *sectorsWritten,
                               offset) == true)
         {
             *sectorsWritten /= vhd->sectorSize;
@@ -1086,14 +1763,54 @@ u32 _AXP_VHD_WriteSectors(AXP_VHD_HANDLE handle,
     }
 
     /*
-     * OK, we have a dynamic VHD.  We need to determine a few things.  First,
-     * is the block we are looking to write in the file.  And second, if it is,
-     * then find out where it is located and write it.  NOTE: There is
-     * nothing to say that sectors are contiguous, so we are going to have to
-     * write them one at a time.
+     * OK, we have a dynamic or differencing VHD.  For each block in the
+     * request, if the block is not in the file yet, add it to the end of the
+     * file.  Then write the sectors into the block.  NOTE: There is nothing
+     * to say that blocks are contiguous in the file, so we write one block's
+     * worth at a time.
      */
     else
     {
+        AXP_VHD_BAT_ENT *bat = (AXP_VHD_BAT_ENT *) vhd->bat;
+        u8 *bufPtr = inBuf;
+        u32 sectorsPerBlk = vhd->blkSize / vhd->sectorSize;
+        u32 sectorsRem = *sectorsWritten;
+        u32 sectorsInWrite;
+        u64 blkNum;
+
+        *sectorsWritten = 0;
+        while ((sectorsRem > 0) && (retVal == AXP_VHD_SUCCESS))
+        {
+            blkNum = lba / sectorsPerBlk;
+            sectorsInWrite = sectorsPerBlk - (lba % sectorsPerBlk);
+            if (sectorsInWrite > sectorsRem)
+            {
+                sectorsInWrite = sectorsRem;
+            }
+            if (bat[blkNum] == AXP_VHD_BAT_UNUSED)
+            {
+                retVal = _AXP_VHD_AllocateBlock(vhd, blkNum);
+            }
+            if ((retVal == AXP_VHD_SUCCESS) &&
+                (AXP_WriteAtOffset(vhd->fp,
+                                   bufPtr,
+                                   sectorsInWrite * vhd->sectorSize,
+                                   _AXP_VHD_BlockOffset(vhd,
+                                                        vhd->blkSize,
+                                                        blkNum) +
+                                   ((lba % sectorsPerBlk) *
+                                    vhd->sectorSize)) == false))
+            {
+                retVal = AXP_VHD_WRITE_FAULT;
+            }
+            if (retVal == AXP_VHD_SUCCESS)
+            {
+                *sectorsWritten += sectorsInWrite;
+                sectorsRem -= sectorsInWrite;
+                lba += sectorsInWrite;
+                bufPtr = &bufPtr[sectorsInWrite * vhd->sectorSize];
+            }
+        }
     }
 
     /*
@@ -0,0 +1,1455 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This source file contains the host block cache used by the virtual disks.
+ *  The cache is shared by all the virtual disks in the system.  It is split
+ *  into shards, each with its own lock, hash table, Least Recently Used (LRU)
+ *  list, and share of the cache budget and dirty limit.  Writes are held in
+ *  the cache (write-back) until either the shard's dirty limit is exceeded,
+ *  the block is evicted, or the disk is flushed or closed.  When a disk is
+ *  being read sequentially, misses read ahead of the request.
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  A miss only allocates a buffer when it reads more than one block, and it
+ *  is only as large as the read.  A block read on a miss is not put in the
+ *  cache if the disk was written while it was being read.  Sequential
+ *  streams are detected with more than one request in flight.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Dirty blocks are written back with their shard unlocked, so hits in the
+ *  shard are not held up by the I/O.  A partially written block is read into
+ *  an entry already in the cache, so it is never read again.  Whether a block
+ *  read on a miss is still current is decided for its shard, not the disk.
+ */
+#include "CommonUtilities/AXP_Blocks.h"
+#include "CommonUtilities/AXP_Configure.h"
+#include "Devices/VirtualDisks/AXP_VHD_Cache.h"
+#include "Devices/VirtualDisks/AXP_VHDX.h"
+#include "Devices/VirtualDisks/AXP_RAW.h"
+
+/*
+ * This is the maximum number of blocks read from a disk on a single miss.
+ */
+#define AXP_VHD_CACHE_MAX_FILL  64
+
+/*
+ * The cache mutex protects the set up of the cache and the attaching and
+ * detaching of disks.  It is not used when reading or writing.  The attached
+ * disk handles are kept in their own array, so that they can be searched
+ * without locking.
+ */
+static pthread_mutex_t _cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static bool _cacheSetup = false;
+static u32 _cacheReadAhead = 0;
+static u32 _cacheAttached = 0;
+static AXP_VHD_CACHE_SHARD _cacheShards[AXP_VHD_CACHE_SHARDS];
+static AXP_VHD_HANDLE _cacheHandles[AXP_VHD_CACHE_MAX_DISKS];
+static AXP_VHD_CACHE_DISK *_cacheDisks[AXP_VHD_CACHE_MAX_DISKS];
+
+/*
+ * _AXP_VHD_CacheHash
+ *  This function is called to hash a disk and block number.  The shard is
+ *  selected from one set of bits of the hash, and the bucket within the shard
+ *  from another.
+ *
+ * Input Parameters:
+ *  disk:
+ *      A pointer to the cached disk.
+ *  blockNum:
+ *      A value indicating the cache block number on the disk.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The hash value.
+ */
+static inline u64 _AXP_VHD_CacheHash(AXP_VHD_CACHE_DISK *disk, u64 blockNum)
+{
+    return((blockNum + ((u64) disk >> 4)) * 0x9e3779b97f4a7c15ll);
+}
+#define AXP_VHD_CACHE_SHARD(hash)                                           \
+    (&_cacheShards[((hash) >> 32) & (AXP_VHD_CACHE_SHARDS - 1)])
+#define AXP_VHD_CACHE_BUCKET(shard, hash)                                   \
+    (((hash) >> 36) & (shard)->hashMask)
+
+/*
+ * _AXP_VHD_CacheLookup
+ *  This function is called, with the shard locked, to look up a block in the
+ *  shard's hash table.
+ *
+ * Input Parameters:
+ *  shard:
+ *      A pointer to the shard containing the block.
+ *  disk:
+ *      A pointer to the cached disk.
+ *  blockNum:
+ *      A value indicating the cache block number on the disk.
+ *  hash:
+ *      A value containing the hash of the disk and block number.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL:       The block is not in the cache.
+ *  Not NULL:   A pointer to the cache entry for the block.
+ */
+static AXP_VHD_CACHE_ENTRY *_AXP_VHD_CacheLookup(AXP_VHD_CACHE_SHARD *shard,
+                                                 AXP_VHD_CACHE_DISK *disk,
+                                                 u64 blockNum,
+                                                 u64 hash)
+{
+    AXP_VHD_CACHE_ENTRY *entry;
+
+    entry = shard->hash[AXP_VHD_CACHE_BUCKET(shard, hash)];
+    while ((entry != NULL) &&
+           ((entry->disk != disk) || (entry->blockNum != blockNum)))
+    {
+        entry = entry->hashNext;
+    }
+    return(entry);
+}
+
+/*
+ * _AXP_VHD_CacheUnhash
+ *  This function is called, with the shard locked, to remove an entry from
+ *  the shard's hash table.
+ *
+ * Input Parameters:
+ *  shard:
+ *      A pointer to the shard containing the entry.
+ *  entry:
+ *      A pointer to the entry to be removed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void _AXP_VHD_CacheUnhash(AXP_VHD_CACHE_SHARD *shard,
+                                 AXP_VHD_CACHE_ENTRY *entry)
+{
+    AXP_VHD_CACHE_ENTRY **prev;
+    u64 hash = _AXP_VHD_CacheHash(entry->disk, entry->blockNum);
+
+    prev = &shard->hash[AXP_VHD_CACHE_BUCKET(shard, hash)];
+    while ((*prev != NULL) && (*prev != entry))
+    {
+        prev = &(*prev)->hashNext;
+    }
+    if (*prev != NULL)
+    {
+        *prev = entry->hashNext;
+    }
+    entry->hashNext = NULL;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * _AXP_VHD_CacheIO
+ *  This function is called to read or write one or more contiguous cache
+ *  blocks from or to the format specific disk.  A request that extends past
+ *  the end of the disk is truncated, and on a read, the remainder of the
+ *  buffer is zeroed.
+ *
+ * Input Parameters:
+ *  disk:
+ *      A pointer to the cached disk.
+ *  blockNum:
+ *      A value indicating the first cache block number.
+ *  blocks:
+ *      A value indicating the number of cache blocks.
+ *  buf:
+ *      A pointer to the buffer to be written (write).
+ *  write:
+ *      A boolean indicating whether this is a write (true) or read (false).
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the buffer to receive the data read (read).
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  Other:                  The status returned by the format specific
+ *                          function.
+ */
+static u32 _AXP_VHD_CacheIO(AXP_VHD_CACHE_DISK *disk,
+                            u64 blockNum,
+                            u32 blocks,
+                            u8 *buf,
+                            bool write)
+{
+    u64 offset = blockNum * AXP_VHD_CACHE_BLK_SIZE;
+    u64 bytes = (u64) blocks * AXP_VHD_CACHE_BLK_SIZE;
+    u32 sectors;
+    u32 retVal;
+
+    if ((offset + bytes) > disk->diskSize)
+    {
+        bytes = disk->diskSize - offset;
+    }
+    sectors = bytes / disk->sectorSize;
+    pthread_mutex_lock(&disk->ioMutex);
+    if (write == true)
+    {
+        retVal = _AXP_VHD_WriteBackend(disk->handle,
+                                       disk->deviceID,
+                                       offset / disk->sectorSize,
+                                       &sectors,
+                                       buf);
+    }
+    else
+    {
+        retVal = _AXP_VHD_ReadBackend(disk->handle,
+                                      disk->deviceID,
+                                      offset / disk->sectorSize,
+                                      &sectors,
+                                      buf);
+    }
+    pthread_mutex_unlock(&disk->ioMutex);
+    if ((write == false) &&
+        (bytes < ((u64) blocks * AXP_VHD_CACHE_BLK_SIZE)))
+    {
+        memset(&buf[bytes],
+               0,
+               ((u64) blocks * AXP_VHD_CACHE_BLK_SIZE) - bytes);
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_VHD_CacheWriteBack
+ *  This function is called, with the shard locked, to write dirty entries
+ *  back to their disks, least recently used first.  The entries are marked as
+ *  being written, and no longer dirty, and then the shard is unlocked while
+ *  they are written, so that hits in the shard are not held up.  If a write
+ *  fails, the error is remembered for the disk and returned on the next flush
+ *  or close.  The shard's write generation is incremented, as what is on the
+ *  disks has changed.
+ *
+ * Input Parameters:
+ *  shard:
+ *      A pointer to the shard containing the entries.
+ *  disk:
+ *      A pointer to the cached disk whose entries are to be written, or NULL
+ *      for the entries of any disk.
+ *  count:
+ *      A value indicating the maximum number of entries to be written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The number of entries written.
+ */
+static u32 _AXP_VHD_CacheWriteBack(AXP_VHD_CACHE_SHARD *shard,
+                                   AXP_VHD_CACHE_DISK *disk,
+                                   u32 count)
+{
+    AXP_VHD_CACHE_ENTRY *list = NULL;
+    AXP_VHD_CACHE_ENTRY **tail = &list;
+    AXP_VHD_CACHE_ENTRY *entry;
+    AXP_QUEUE_HDR *next;
+    u32 written = 0;
+    u32 errors = 0;
+
+    for (next = shard->lruQ.flink;
+         ((next != (AXP_QUEUE_HDR *) &shard->lruQ) && (written < count));
+         next = next->flink)
+    {
+        entry = (AXP_VHD_CACHE_ENTRY *) next;
+        if ((entry->dirty == true) && ((disk == NULL) || (entry->disk == disk)))
+        {
+            entry->dirty = false;
+            entry->writing = true;
+            shard->dirty--;
+            *tail = entry;
+            tail = &entry->wbNext;
+            written++;
+        }
+    }
+    *tail = NULL;
+
+    /*
+     * Write the entries with the shard unlocked.  They cannot be written into
+     * or evicted until we are done.
+     */
+    if (written > 0)
+    {
+        pthread_mutex_unlock(&shard->mutex);
+        for (entry = list; entry != NULL; entry = entry->wbNext)
+        {
+            if (_AXP_VHD_CacheIO(entry->disk,
+                                 entry->blockNum,
+                                 1,
+                                 entry->data,
+                                 true) != AXP_VHD_SUCCESS)
+            {
+                entry->disk->lastError = AXP_VHD_WRITE_FAULT;
+                errors++;
+            }
+        }
+        pthread_mutex_lock(&shard->mutex);
+        for (entry = list; entry != NULL; entry = entry->wbNext)
+        {
+            entry->writing = false;
+        }
+        __atomic_add_fetch(&shard->writeGen, 1, __ATOMIC_RELEASE);
+        shard->writeBacks += written;
+        shard->writeErrors += errors;
+        pthread_cond_broadcast(&shard->cond);
+    }
+
+    /*
+     * Return the number of entries written back to the caller.
+     */
+    return(written);
+}
+
+/*
+ * _AXP_VHD_CacheGetEntry
+ *  This function is called, with the shard locked, to get an entry to be
+ *  used for a block.  If the shard has not used up its share of the cache
+ *  budget, a new entry is allocated.  Otherwise, the least recently used
+ *  entry that is neither dirty nor in use is evicted.  If there is no such
+ *  entry, and the caller can wait, the least recently used dirty entry is
+ *  written back, or, if none are dirty, we wait for an entry to no longer be
+ *  in use.  Either is done with the shard unlocked, so the caller then needs
+ *  to look up the block again.
+ *
+ * Input Parameters:
+ *  shard:
+ *      A pointer to the shard the block is to be inserted into.
+ *
+ * Output Parameters:
+ *  retry:
+ *      A pointer to a boolean set to true when the shard was unlocked, and
+ *      the caller needs to look up the block again.  If this is NULL, the
+ *      shard is never unlocked.
+ *
+ * Return Values:
+ *  NULL:       An entry could not be allocated, or retry was set.
+ *  Not NULL:   A pointer to an entry that is not in the hash table or on the
+ *              LRU list.
+ */
+static AXP_VHD_CACHE_ENTRY *_AXP_VHD_CacheGetEntry(AXP_VHD_CACHE_SHARD *shard,
+                                                   bool *retry)
+{
+    AXP_VHD_CACHE_ENTRY *entry = NULL;
+    AXP_VHD_CACHE_ENTRY *victim;
+    AXP_QUEUE_HDR *next = shard->lruQ.flink;
+
+    if (shard->entries < shard->maxEntries)
+    {
+        entry = AXP_Allocate_Block(-(i32) (sizeof(AXP_VHD_CACHE_ENTRY) +
+                                           AXP_VHD_CACHE_BLK_SIZE),
+                                   NULL);
+        if (entry != NULL)
+        {
+            AXP_INIT_QUEP((&entry->lru));
+            entry->data = (u8 *) &entry[1];
+            shard->entries++;
+        }
+    }
+    while ((entry == NULL) && (next != (AXP_QUEUE_HDR *) &shard->lruQ))
+    {
+        victim = (AXP_VHD_CACHE_ENTRY *) next;
+        next = next->flink;
+        if ((victim->dirty == false) &&
+            (victim->filling == false) &&
+            (victim->writing == false))
+        {
+            _AXP_VHD_CacheUnhash(shard, victim);
+            AXP_LRURemove(&victim->lru);
+            shard->evictions++;
+            entry = victim;
+        }
+    }
+    if ((entry == NULL) && (retry != NULL) && (shard->entries > 0))
+    {
+        if (shard->dirty > 0)
+        {
+            _AXP_VHD_CacheWriteBack(shard, NULL, 1);
+        }
+        else
+        {
+            pthread_cond_wait(&shard->cond, &shard->mutex);
+        }
+        *retry = true;
+    }
+    if (entry != NULL)
+    {
+        entry->dirty = false;
+        entry->prefetched = false;
+        entry->filling = false;
+        entry->writing = false;
+    }
+
+    /*
+     * Return the entry back to the caller.
+     */
+    return(entry);
+}
+
+/*
+ * _AXP_VHD_CacheInsert
+ *  This function is called, with the shard locked, to get an entry for a
+ *  block, initialize it, and insert it into the shard's hash table and LRU
+ *  list.
+ *
+ * Input Parameters:
+ *  shard:
+ *      A pointer to the shard the block is to be inserted into.
+ *  disk:
+ *      A pointer to the cached disk.
+ *  blockNum:
+ *      A value indicating the cache block number on the disk.
+ *  hash:
+ *      A value containing the hash of the disk and block number.
+ *  data:
+ *      A pointer to the contents of the block, or NULL if the caller fills it
+ *      in.
+ *
+ * Output Parameters:
+ *  retry:
+ *      A pointer to a boolean set to true when the shard was unlocked to make
+ *      room, and the caller needs to look up the block again.  If this is
+ *      NULL, the shard is never unlocked.
+ *
+ * Return Values:
+ *  NULL:       An entry could not be allocated, or retry was set.
+ *  Not NULL:   A pointer to the newly inserted entry.
+ */
+static AXP_VHD_CACHE_ENTRY *_AXP_VHD_CacheInsert(AXP_VHD_CACHE_SHARD *shard,
+                                                 AXP_VHD_CACHE_DISK *disk,
+                                                 u64 blockNum,
+                                                 u64 hash,
+                                                 u8 *data,
+                                                 bool *retry)
+{
+    AXP_VHD_CACHE_ENTRY *entry = _AXP_VHD_CacheGetEntry(shard, retry);
+    u32 bucket;
+
+    if (entry != NULL)
+    {
+        entry->disk = disk;
+        entry->blockNum = blockNum;
+        if (data != NULL)
+        {
+            memcpy(entry->data, data, AXP_VHD_CACHE_BLK_SIZE);
+        }
+        bucket = AXP_VHD_CACHE_BUCKET(shard, hash);
+        entry->hashNext = shard->hash[bucket];
+        shard->hash[bucket] = entry;
+        AXP_LRUAdd(&shard->lruQ, &entry->lru);
+    }
+
+    /*
+     * Return the entry back to the caller.
+     */
+    return(entry);
+}
+
+/*
+ * _AXP_VHD_CacheTrimDirty
+ *  This function is called, with the shard locked, when the number of dirty
+ *  entries in the shard has exceeded its limit.  The oldest dirty entries are
+ *  written back, with the shard unlocked, until the shard is down to half of
+ *  its limit.
+ *
+ * Input Parameters:
+ *  shard:
+ *      A pointer to the shard to be trimmed.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void _AXP_VHD_CacheTrimDirty(AXP_VHD_CACHE_SHARD *shard)
+{
+    if (shard->dirty > (shard->maxDirty / 2))
+    {
+        _AXP_VHD_CacheWriteBack(shard,
+                                NULL,
+                                shard->dirty - (shard->maxDirty / 2));
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * _AXP_VHD_CacheCopy
+ *  This function is called to copy the part of a block that overlaps a
+ *  request between the block and the caller's buffer.
+ *
+ * Input Parameters:
+ *  blockNum:
+ *      A value indicating the cache block number on the disk.
+ *  blockData:
+ *      A pointer to the contents of the block.
+ *  offset:
+ *      A value indicating the byte offset, on the disk, of the request.
+ *  bytes:
+ *      A value indicating the length, in bytes, of the request.
+ *  buf:
+ *      A pointer to the caller's buffer.
+ *  toBlock:
+ *      A boolean indicating whether the copy is from the caller's buffer into
+ *      the block (true) or from the block into the caller's buffer (false).
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void _AXP_VHD_CacheCopy(u64 blockNum,
+                               u8 *blockData,
+                               u64 offset,
+                               u64 bytes,
+                               u8 *buf,
+                               bool toBlock)
+{
+    u64 blockStart = blockNum * AXP_VHD_CACHE_BLK_SIZE;
+    u64 start = (offset > blockStart) ? offset : blockStart;
+    u64 end = blockStart + AXP_VHD_CACHE_BLK_SIZE;
+
+    if (end > (offset + bytes))
+    {
+        end = offset + bytes;
+    }
+    if (toBlock == true)
+    {
+        memcpy(&blockData[start - blockStart],
+               &buf[start - offset],
+               end - start);
+    }
+    else
+    {
+        memcpy(&buf[start - offset],
+               &blockData[start - blockStart],
+               end - start);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * _AXP_VHD_CacheFindDisk
+ *  This function is called to find the cached disk for a handle.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  NULL:       The handle is not attached to the cache.
+ *  Not NULL:   A pointer to the cached disk.
+ */
+static AXP_VHD_CACHE_DISK *_AXP_VHD_CacheFindDisk(AXP_VHD_HANDLE handle)
+{
+    int ii;
+
+    for (ii = 0; ii < AXP_VHD_CACHE_MAX_DISKS; ii++)
+    {
+        if (_cacheHandles[ii] == handle)
+        {
+            return(_cacheDisks[ii]);
+        }
+    }
+    return(NULL);
+}
+
+/*
+ * _AXP_VHD_CacheSetup
+ *  This function is called, with the cache mutex locked and no disks
+ *  attached, to divide the cache budget between the shards.  A budget too
+ *  small to give each shard at least one block disables the cache.
+ *
+ * Input Parameters:
+ *  size:
+ *      A value indicating the cache budget, in bytes.
+ *  dirtyMax:
+ *      A value indicating the maximum number of bytes that can be dirty.  A
+ *      value of zero selects a default.
+ *  readAhead:
+ *      A value indicating the number of blocks to be read ahead when a disk is
+ *      being read sequentially.  A value of zero disables read-ahead.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void _AXP_VHD_CacheSetup(u64 size, u64 dirtyMax, u32 readAhead)
+{
+    AXP_VHD_CACHE_SHARD *shard;
+    u64 perShard = size / AXP_VHD_CACHE_BLK_SIZE / AXP_VHD_CACHE_SHARDS;
+    u64 dirtyPerShard;
+    u32 buckets = 1;
+    int ii;
+
+    if (dirtyMax == 0)
+    {
+        dirtyPerShard = perShard / AXP_VHD_CACHE_DEF_DIRTY_DIV;
+    }
+    else
+    {
+        dirtyPerShard = dirtyMax /
+                        AXP_VHD_CACHE_BLK_SIZE /
+                        AXP_VHD_CACHE_SHARDS;
+    }
+    if (dirtyPerShard == 0)
+    {
+        dirtyPerShard = 1;
+    }
+    while (buckets < perShard)
+    {
+        buckets <<= 1;
+    }
+    _cacheReadAhead = readAhead;
+    for (ii = 0; ii < AXP_VHD_CACHE_SHARDS; ii++)
+    {
+        shard = &_cacheShards[ii];
+        memset(shard, 0, sizeof(AXP_VHD_CACHE_SHARD));
+        pthread_mutex_init(&shard->mutex, NULL);
+        pthread_cond_init(&shard->cond, NULL);
+        AXP_INIT_QUE(shard->lruQ);
+        if (perShard > 0)
+        {
+            shard->hash = AXP_Allocate_Block(
+                -(i32) (buckets * sizeof(AXP_VHD_CACHE_ENTRY *)),
+                NULL);
+        }
+        if (shard->hash != NULL)
+        {
+            shard->hashMask = buckets - 1;
+            shard->maxEntries = perShard;
+            shard->maxDirty = dirtyPerShard;
+        }
+    }
+    _cacheSetup = true;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * _AXP_VHD_CacheTeardown
+ *  This function is called, with the cache mutex locked and no disks
+ *  attached, to free all the entries and hash tables in the cache.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void _AXP_VHD_CacheTeardown(void)
+{
+    AXP_VHD_CACHE_SHARD *shard;
+    AXP_QUEUE_HDR *entry;
+    int ii;
+
+    for (ii = 0; ii < AXP_VHD_CACHE_SHARDS; ii++)
+    {
+        shard = &_cacheShards[ii];
+        while ((entry = AXP_LRUReturn(&shard->lruQ)) != NULL)
+        {
+            AXP_LRURemove(entry);
+            AXP_Deallocate_Block(entry);
+        }
+        if (shard->hash != NULL)
+        {
+            AXP_Deallocate_Block(shard->hash);
+        }
+        pthread_mutex_destroy(&shard->mutex);
+        pthread_cond_destroy(&shard->cond);
+    }
+    _cacheSetup = false;
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_VHD_CacheInit
+ *  This function is called to size the block cache.  If it is not called,
+ *  the cache is sized from the system configuration when the first disk is
+ *  attached.  The cache can only be resized when no disks are attached.
+ *
+ * Input Parameters:
+ *  size:
+ *      A value indicating the cache budget, in bytes.  A value of zero
+ *      disables the cache.
+ *  dirtyMax:
+ *      A value indicating the maximum number of bytes that can be dirty.  A
+ *      value of zero selects a default.
+ *  readAhead:
+ *      A value indicating the number of blocks to be read ahead when a disk is
+ *      being read sequentially.  A value of zero disables read-ahead.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  true:   The cache was sized.
+ *  false:  There are disks attached to the cache.
+ */
+bool AXP_VHD_CacheInit(u64 size, u64 dirtyMax, u32 readAhead)
+{
+    bool retVal = false;
+
+    pthread_mutex_lock(&_cacheMutex);
+    if (_cacheAttached == 0)
+    {
+        if (_cacheSetup == true)
+        {
+            _AXP_VHD_CacheTeardown();
+        }
+        _AXP_VHD_CacheSetup(size, dirtyMax, readAhead);
+        retVal = true;
+    }
+    pthread_mutex_unlock(&_cacheMutex);
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_VHD_CacheAttach
+ *  This function is called when a disk has been opened to attach it to the
+ *  block cache.  Disks that are mapped into memory are not cached, since the
+ *  host page cache is already being accessed directly.  If the cache is
+ *  disabled or full, the disk is just not cached.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_VHD_CacheAttach(AXP_VHD_HANDLE handle)
+{
+    AXP_VHD_CACHE_DISK *disk = NULL;
+    u64 size, dirtyMax;
+    u32 readAhead;
+    int ii;
+
+    pthread_mutex_lock(&_cacheMutex);
+    if (_cacheSetup == false)
+    {
+        AXP_ConfigGet_DiskCacheInfo(&size, &dirtyMax, &readAhead);
+        _AXP_VHD_CacheSetup(size, dirtyMax, readAhead);
+    }
+    for (ii = 0;
+         ((ii < AXP_VHD_CACHE_MAX_DISKS) &&
+          (_cacheShards[0].maxEntries > 0) &&
+          (disk == NULL));
+         ii++)
+    {
+        if (_cacheHandles[ii] == NULL)
+        {
+            disk = AXP_Allocate_Block(-(i32) sizeof(AXP_VHD_CACHE_DISK), NULL);
+            if (disk == NULL)
+            {
+                break;
+            }
+            switch (AXP_ReturnType_Block(handle))
+            {
+                case AXP_VHDX_BLK:
+                    {
+                        AXP_VHDX_Handle *vhdx = (AXP_VHDX_Handle *) handle;
+
+                        disk->deviceID = vhdx->deviceID;
+                        disk->sectorSize = vhdx->sectorSize;
+                        disk->diskSize = vhdx->diskSize;
+                        disk->writable = vhdx->readOnly == false;
+                        if (vhdx->mapAddr != NULL)
+                        {
+                            disk->sectorSize = 0;
+                        }
+                    }
+                    break;
+
+                case AXP_RAW_BLK:
+                    {
+                        AXP_RAW_Handle *raw = (AXP_RAW_Handle *) handle;
+
+                        disk->deviceID = raw->deviceID;
+                        disk->sectorSize = raw->sectorSize;
+                        disk->diskSize = raw->diskSize;
+                        disk->writable =
+                            (raw->readOnly == false) &&
+                            (raw->deviceID != STORAGE_TYPE_DEV_ISO);
+                        if (raw->mapAddr != NULL)
+                        {
+                            disk->sectorSize = 0;
+                        }
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+
+            /*
+             * If this is a disk that we cache, then initialize the rest of it
+             * and make it visible to the read and write functions.
+             */
+            if ((disk->sectorSize > 0) &&
+                (disk->sectorSize <= AXP_VHD_CACHE_BLK_SIZE) &&
+                ((AXP_VHD_CACHE_BLK_SIZE % disk->sectorSize) == 0))
+            {
+                disk->handle = handle;
+                disk->nextBlock = ~0ll;
+                pthread_mutex_init(&disk->ioMutex, NULL);
+                pthread_mutex_init(&disk->streamMutex, NULL);
+                _cacheDisks[ii] = disk;
+                _cacheHandles[ii] = handle;
+                _cacheAttached++;
+            }
+            else
+            {
+                AXP_Deallocate_Block(disk);
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&_cacheMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_VHD_CacheFlush
+ *  This function is called to write all the dirty blocks for a disk back to
+ *  the disk, and wait for any being written back by someone else.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_WRITE_FAULT:    A dirty block for the disk could not be written,
+ *                          either now or when it was evicted.
+ */
+u32 AXP_VHD_CacheFlush(AXP_VHD_HANDLE handle)
+{
+    AXP_VHD_CACHE_DISK *disk = _AXP_VHD_CacheFindDisk(handle);
+    AXP_VHD_CACHE_SHARD *shard;
+    AXP_VHD_CACHE_ENTRY *entry;
+    AXP_QUEUE_HDR *next;
+    u32 retVal = AXP_VHD_SUCCESS;
+    bool writing;
+    int ii;
+
+    if (disk != NULL)
+    {
+        for (ii = 0; ii < AXP_VHD_CACHE_SHARDS; ii++)
+        {
+            shard = &_cacheShards[ii];
+            pthread_mutex_lock(&shard->mutex);
+            _AXP_VHD_CacheWriteBack(shard, disk, shard->dirty);
+            do
+            {
+                writing = false;
+                next = shard->lruQ.flink;
+                while ((writing == false) &&
+                       (next != (AXP_QUEUE_HDR *) &shard->lruQ))
+                {
+                    entry = (AXP_VHD_CACHE_ENTRY *) next;
+                    next = next->flink;
+                    writing = (entry->disk == disk) && (entry->writing == true);
+                }
+                if (writing == true)
+                {
+                    pthread_cond_wait(&shard->cond, &shard->mutex);
+                }
+            } while (writing == true);
+            pthread_mutex_unlock(&shard->mutex);
+        }
+        retVal = disk->lastError;
+        disk->lastError = AXP_VHD_SUCCESS;
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_VHD_CacheDetach
+ *  This function is called when a disk is being closed to flush its dirty
+ *  blocks, remove all its blocks from the cache, and detach it from the
+ *  cache.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_WRITE_FAULT:    A dirty block for the disk could not be written.
+ */
+u32 AXP_VHD_CacheDetach(AXP_VHD_HANDLE handle)
+{
+    AXP_VHD_CACHE_DISK *disk = _AXP_VHD_CacheFindDisk(handle);
+    AXP_VHD_CACHE_SHARD *shard;
+    AXP_VHD_CACHE_ENTRY *entry;
+    AXP_QUEUE_HDR *next;
+    u32 retVal = AXP_VHD_SUCCESS;
+    int ii;
+
+    if (disk != NULL)
+    {
+        retVal = AXP_VHD_CacheFlush(handle);
+        for (ii = 0; ii < AXP_VHD_CACHE_SHARDS; ii++)
+        {
+            shard = &_cacheShards[ii];
+            pthread_mutex_lock(&shard->mutex);
+            next = shard->lruQ.flink;
+            while (next != (AXP_QUEUE_HDR *) &shard->lruQ)
+            {
+                entry = (AXP_VHD_CACHE_ENTRY *) next;
+                next = next->flink;
+                if (entry->disk == disk)
+                {
+                    _AXP_VHD_CacheUnhash(shard, entry);
+                    AXP_LRURemove(&entry->lru);
+                    AXP_Deallocate_Block(entry);
+                    shard->entries--;
+                }
+            }
+            pthread_mutex_unlock(&shard->mutex);
+        }
+        pthread_mutex_lock(&_cacheMutex);
+        for (ii = 0; ii < AXP_VHD_CACHE_MAX_DISKS; ii++)
+        {
+            if (_cacheHandles[ii] == handle)
+            {
+                _cacheHandles[ii] = NULL;
+                _cacheDisks[ii] = NULL;
+                _cacheAttached--;
+            }
+        }
+        pthread_mutex_unlock(&_cacheMutex);
+        pthread_mutex_destroy(&disk->ioMutex);
+        pthread_mutex_destroy(&disk->streamMutex);
+        AXP_Deallocate_Block(disk);
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_VHD_CacheRead
+ *  This function is called to read one or more sectors through the block
+ *  cache.  Blocks not in the cache are read from the disk, along with any of
+ *  the following blocks in the request.  If the disk is being read
+ *  sequentially, then blocks past the end of the request are also read and
+ *  put in the cache.  The shards are not locked while the disk is read, so if
+ *  any block in a shard was written back in the meantime, the blocks read for
+ *  that shard are only returned to the caller, and not put in the cache, as
+ *  they may be older than what is now on the disk.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *  lba:
+ *      A value representing the Logical Block Address from where the read is
+ *      to be started.
+ *  sectorsRead:
+ *      A pointer to a value representing the number of sectors to be read.
+ *
+ * Output Parameters:
+ *  sectorsRead:
+ *      A pointer to a location to receive the number of sectors read.
+ *  outBuf:
+ *      A pointer to the buffer to receive the data read.
+ *  retVal:
+ *      A pointer to a location to receive the status of the read.
+ *
+ * Return Values:
+ *  true:   The disk is cached, and the read was performed.
+ *  false:  The disk is not cached, the caller needs to perform the read.
+ */
+bool AXP_VHD_CacheRead(AXP_VHD_HANDLE handle,
+                       u64 lba,
+                       u32 *sectorsRead,
+                       u8 *outBuf,
+                       u32 *retVal)
+{
+    AXP_VHD_CACHE_DISK *disk = _AXP_VHD_CacheFindDisk(handle);
+    AXP_VHD_CACHE_SHARD *shard;
+    AXP_VHD_CACHE_ENTRY *entry;
+    u8 blockBuf[AXP_VHD_CACHE_BLK_SIZE];
+    u8 *fillBuf = NULL;
+    u8 *readBuf;
+    u64 gen[AXP_VHD_CACHE_SHARDS];
+    u64 offset, bytes, block, first, last, lastDiskBlock, hash, ii;
+    u32 readAhead = 0;
+    u32 fillBlocks;
+    u32 fillSize = 0;
+
+    if (disk == NULL)
+    {
+        return(false);
+    }
+    *retVal = AXP_VHD_SUCCESS;
+    offset = lba * disk->sectorSize;
+    bytes = (u64) *sectorsRead * disk->sectorSize;
+    if (bytes == 0)
+    {
+        return(true);
+    }
+    first = offset / AXP_VHD_CACHE_BLK_SIZE;
+    last = (offset + bytes - 1) / AXP_VHD_CACHE_BLK_SIZE;
+    lastDiskBlock = (disk->diskSize - 1) / AXP_VHD_CACHE_BLK_SIZE;
+
+    /*
+     * Determine if this read continues the stream of reads on the disk, by
+     * starting within a window of where the stream has got to.  If it does
+     * often enough, then we consider the disk to be read sequentially and
+     * read ahead on a miss.  The stream only moves forward, as the reads in
+     * flight at the same time can complete in any order.
+     */
+    pthread_mutex_lock(&disk->streamMutex);
+    if (((first + AXP_VHD_CACHE_SEQ_WINDOW) >= disk->nextBlock) &&
+        (first <= (disk->nextBlock + AXP_VHD_CACHE_SEQ_WINDOW)))
+    {
+        if (disk->seqCount < AXP_VHD_CACHE_SEQ_TRIGGER)
+        {
+            disk->seqCount++;
+        }
+        if ((last + 1) > disk->nextBlock)
+        {
+            disk->nextBlock = last + 1;
+        }
+    }
+    else
+    {
+        disk->seqCount = 0;
+        disk->nextBlock = last + 1;
+    }
+    if (disk->seqCount >= AXP_VHD_CACHE_SEQ_TRIGGER)
+    {
+        readAhead = _cacheReadAhead;
+    }
+    pthread_mutex_unlock(&disk->streamMutex);
+
+    block = first;
+    while ((block <= last) && (*retVal == AXP_VHD_SUCCESS))
+    {
+        hash = _AXP_VHD_CacheHash(disk, block);
+        shard = AXP_VHD_CACHE_SHARD(hash);
+        pthread_mutex_lock(&shard->mutex);
+        entry = _AXP_VHD_CacheLookup(shard, disk, block, hash);
+        while ((entry != NULL) && (entry->filling == true))
+        {
+            pthread_cond_wait(&shard->cond, &shard->mutex);
+            entry = _AXP_VHD_CacheLookup(shard, disk, block, hash);
+        }
+        if (entry != NULL)
+        {
+            _AXP_VHD_CacheCopy(block,
+                               entry->data,
+                               offset,
+                               bytes,
+                               outBuf,
+                               false);
+            AXP_LRUAdd(&shard->lruQ, &entry->lru);
+            shard->hits++;
+            if (entry->prefetched == true)
+            {
+                shard->readAheadHits++;
+                entry->prefetched = false;
+            }
+            pthread_mutex_unlock(&shard->mutex);
+            block++;
+            continue;
+        }
+        pthread_mutex_unlock(&shard->mutex);
+
+        /*
+         * We missed.  Read this block, the rest of the request, and the
+         * read-ahead blocks, up to the end of the disk, all at once.
+         */
+        fillBlocks = (last - block + 1) + readAhead;
+        if (fillBlocks > AXP_VHD_CACHE_MAX_FILL)
+        {
+            fillBlocks = AXP_VHD_CACHE_MAX_FILL;
+        }
+        if ((block + fillBlocks - 1) > lastDiskBlock)
+        {
+            fillBlocks = lastDiskBlock - block + 1;
+        }
+        /*
+         * A single block is read onto the stack.  Otherwise, the buffer only
+         * needs to be as large as the largest read so far.
+         */
+        if (fillBlocks == 1)
+        {
+            readBuf = blockBuf;
+        }
+        else
+        {
+            if (fillBlocks > fillSize)
+            {
+                if (fillBuf != NULL)
+                {
+                    AXP_Deallocate_Block(fillBuf);
+                }
+                fillSize = fillBlocks;
+                fillBuf = AXP_Allocate_Block(-(i32) (fillSize *
+                                                     AXP_VHD_CACHE_BLK_SIZE),
+                                             NULL);
+                if (fillBuf == NULL)
+                {
+                    *retVal = AXP_VHD_OUTOFMEMORY;
+                    break;
+                }
+            }
+            readBuf = fillBuf;
+        }
+        for (ii = 0; ii < AXP_VHD_CACHE_SHARDS; ii++)
+        {
+            gen[ii] = __atomic_load_n(&_cacheShards[ii].writeGen,
+                                      __ATOMIC_ACQUIRE);
+        }
+        *retVal = _AXP_VHD_CacheIO(disk, block, fillBlocks, readBuf, false);
+        if (*retVal != AXP_VHD_SUCCESS)
+        {
+            break;
+        }
+
+        /*
+         * Put each block read into the cache, unless it got there while we
+         * were reading (it may be dirty, so it is newer than what we read),
+         * or blocks in its shard were written back while we were reading.
+         * The latter is checked under the shard lock, which is held when the
+         * write generation is incremented.  Blocks in the request are copied
+         * to the caller's buffer from whichever is the current copy, which is
+         * what we read if the entry is still being filled.
+         */
+        for (ii = 0; ii < fillBlocks; ii++, block++)
+        {
+            u8 *data = &readBuf[ii * AXP_VHD_CACHE_BLK_SIZE];
+
+            hash = _AXP_VHD_CacheHash(disk, block);
+            shard = AXP_VHD_CACHE_SHARD(hash);
+            pthread_mutex_lock(&shard->mutex);
+            entry = _AXP_VHD_CacheLookup(shard, disk, block, hash);
+            if (entry == NULL)
+            {
+                if (__atomic_load_n(&shard->writeGen, __ATOMIC_ACQUIRE) ==
+                    gen[shard - _cacheShards])
+                {
+                    entry = _AXP_VHD_CacheInsert(shard,
+                                                 disk,
+                                                 block,
+                                                 hash,
+                                                 data,
+                                                 NULL);
+                }
+                if (block > last)
+                {
+                    shard->readAheads++;
+                    if (entry != NULL)
+                    {
+                        entry->prefetched = true;
+                    }
+                }
+                else
+                {
+                    shard->misses++;
+                }
+            }
+            else if (entry->filling == false)
+            {
+                data = entry->data;
+            }
+            if (block <= last)
+            {
+                _AXP_VHD_CacheCopy(block, data, offset, bytes, outBuf, false);
+            }
+            pthread_mutex_unlock(&shard->mutex);
+        }
+    }
+    if (fillBuf != NULL)
+    {
+        AXP_Deallocate_Block(fillBuf);
+    }
+
+    /*
+     * Return back to the caller, indicating that the read was handled here.
+     */
+    return(true);
+}
+
+/*
+ * AXP_VHD_CacheWrite
+ *  This function is called to write one or more sectors through the block
+ *  cache.  The data is copied into the cache and the blocks are marked
+ *  dirty.  Partially written blocks that are not in the cache are read in
+ *  first, into an entry put in the cache before the shard is unlocked, so no
+ *  one else uses the block until it has been read.  Blocks being filled or
+ *  written back are waited for.  If the shard's dirty limit is exceeded, the
+ *  oldest dirty blocks in the shard are written back.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *  lba:
+ *      A value representing the Logical Block Address from where the write is
+ *      to be started.
+ *  sectorsWritten:
+ *      A pointer to a value representing the number of sectors to be written.
+ *  inBuf:
+ *      A pointer to the buffer containing the data to be written.
+ *
+ * Output Parameters:
+ *  sectorsWritten:
+ *      A pointer to a location to receive the number of sectors written.
+ *  retVal:
+ *      A pointer to a location to receive the status of the write.
+ *
+ * Return Values:
+ *  true:   The disk is cached, and the write was performed.
+ *  false:  The disk is not cached (or is read-only), the caller needs to
+ *          perform the write.
+ */
+bool AXP_VHD_CacheWrite(AXP_VHD_HANDLE handle,
+                        u64 lba,
+                        u32 *sectorsWritten,
+                        u8 *inBuf,
+                        u32 *retVal)
+{
+    AXP_VHD_CACHE_DISK *disk = _AXP_VHD_CacheFindDisk(handle);
+    AXP_VHD_CACHE_SHARD *shard;
+    AXP_VHD_CACHE_ENTRY *entry;
+    u64 offset, bytes, block, last, hash;
+    bool full, retry;
+
+    if ((disk == NULL) || (disk->writable == false))
+    {
+        return(false);
+    }
+    *retVal = AXP_VHD_SUCCESS;
+    offset = lba * disk->sectorSize;
+    bytes = (u64) *sectorsWritten * disk->sectorSize;
+    if (bytes == 0)
+    {
+        return(true);
+    }
+    last = (offset + bytes - 1) / AXP_VHD_CACHE_BLK_SIZE;
+
+    for (block = offset / AXP_VHD_CACHE_BLK_SIZE;
+         ((block <= last) && (*retVal == AXP_VHD_SUCCESS));
+         block++)
+    {
+        full = ((block * AXP_VHD_CACHE_BLK_SIZE) >= offset) &&
+               (((block + 1) * AXP_VHD_CACHE_BLK_SIZE) <= (offset + bytes));
+        hash = _AXP_VHD_CacheHash(disk, block);
+        shard = AXP_VHD_CACHE_SHARD(hash);
+        pthread_mutex_lock(&shard->mutex);
+        do
+        {
+            retry = false;
+            entry = _AXP_VHD_CacheLookup(shard, disk, block, hash);
+            if (entry == NULL)
+            {
+                entry = _AXP_VHD_CacheInsert(shard,
+                                             disk,
+                                             block,
+                                             hash,
+                                             NULL,
+                                             &retry);
+                if ((entry == NULL) && (retry == false))
+                {
+                    *retVal = AXP_VHD_OUTOFMEMORY;
+                }
+
+                /*
+                 * If we are only writing part of the block, read in the rest
+                 * of it, with the shard unlocked.  The entry is marked as
+                 * being filled, so no one else uses it, or reads the block in
+                 * as well, until we are done.
+                 */
+                else if ((entry != NULL) && (full == false))
+                {
+                    entry->filling = true;
+                    pthread_mutex_unlock(&shard->mutex);
+                    *retVal = _AXP_VHD_CacheIO(disk,
+                                               block,
+                                               1,
+                                               entry->data,
+                                               false);
+                    pthread_mutex_lock(&shard->mutex);
+                    entry->filling = false;
+                    pthread_cond_broadcast(&shard->cond);
+                    if (*retVal != AXP_VHD_SUCCESS)
+                    {
+                        _AXP_VHD_CacheUnhash(shard, entry);
+                        AXP_LRURemove(&entry->lru);
+                        AXP_Deallocate_Block(entry);
+                        shard->entries--;
+                        entry = NULL;
+                    }
+                }
+            }
+
+            /*
+             * The block is being filled or written back, with the shard
+             * unlocked.  Wait for it to be done, and look it up again.
+             */
+            else if ((entry->filling == true) || (entry->writing == true))
+            {
+                pthread_cond_wait(&shard->cond, &shard->mutex);
+                entry = NULL;
+                retry = true;
+            }
+        } while ((entry == NULL) && (retry == true));
+
+        /*
+         * Copy the data into the block and mark it dirty.
+         */
+        if (entry != NULL)
+        {
+            _AXP_VHD_CacheCopy(block, entry->data, offset, bytes, inBuf, true);
+            if (entry->dirty == false)
+            {
+                entry->dirty = true;
+                shard->dirty++;
+            }
+            entry->prefetched = false;
+            AXP_LRUAdd(&shard->lruQ, &entry->lru);
+            if (shard->dirty > shard->maxDirty)
+            {
+                _AXP_VHD_CacheTrimDirty(shard);
+            }
+        }
+        pthread_mutex_unlock(&shard->mutex);
+    }
+
+    /*
+     * Return back to the caller, indicating that the write was handled here.
+     */
+    return(true);
+}
+
+/*
+ * AXP_VHD_CacheGetStats
+ *  This function is called to return the block cache statistics, summed
+ *  across all the shards.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  stats:
+ *      A pointer to a location to receive the statistics.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_VHD_CacheGetStats(AXP_VHD_CACHE_STATS *stats)
+{
+    AXP_VHD_CACHE_SHARD *shard;
+    int ii;
+
+    memset(stats, 0, sizeof(AXP_VHD_CACHE_STATS));
+    if (_cacheSetup == true)
+    {
+        for (ii = 0; ii < AXP_VHD_CACHE_SHARDS; ii++)
+        {
+            shard = &_cacheShards[ii];
+            pthread_mutex_lock(&shard->mutex);
+            stats->hits += shard->hits;
+            stats->misses += shard->misses;
+            stats->readAheads += shard->readAheads;
+            stats->readAheadHits += shard->readAheadHits;
+            stats->writeBacks += shard->writeBacks;
+            stats->evictions += shard->evictions;
+            stats->writeErrors += shard->writeErrors;
+            stats->entries += shard->entries;
+            stats->dirty += shard->dirty;
+            stats->maxEntries += shard->maxEntries;
+            pthread_mutex_unlock(&shard->mutex);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
@@ -31,6 +31,20 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added functions to map, unmap, and advise on the memory mapping of a disk
+ *  image.  The read and write validation functions now accept RAW/ISO
+ *  handles, and OPEN_MAPPED_IO is now a valid open flag.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  The read and write validation functions now accept SSD handles, and the
+ *  create validation has its own limits for an SSD.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  A VHD can now be created with a parent (a differencing disk).  Also, the
+ *  minimum and maximum block sizes are now valid block sizes, and OPEN_NONE
+ *  is accepted when opening a disk.
  */
 #include "Devices/VirtualDisks/AXP_VirtualDisk.h"
 #include "CommonUtilities/AXP_Utility.h"
@@ -41,6 +55,7 @@
 #include "Devices/VirtualDisks/AXP_VHD.h"
 #include "Devices/VirtualDisks/AXP_VHDX.h"
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 
 /*
@@ -450,6 +465,199 @@ u64 AXP_VHD_PerformFileSize(FILE *fp)
     return(retVal);
 }
 
+/*
+ * AXP_VHD_MapImage
+ *  This function is called to map a disk image, or a portion of one, into our
+ *  address space.  This is only used for disk formats where the layout is a
+ *  straight linear mapping of LBA to file offset (fixed VHD, RAW, and ISO).
+ *  The mapping is shared, so that writes performed through the file
+ *  descriptor are seen through the mapping (the host page cache is unified).
+ *
+ * Input Parameters:
+ *  fd:
+ *      The file descriptor for the open disk image file or device.
+ *  length:
+ *      A value indicating the number of bytes, starting at offset zero, to be
+ *      mapped.
+ *  writable:
+ *      A boolean indicating whether the mapping should allow writes.
+ *
+ * Output Parameters:
+ *  mapAddr:
+ *      A pointer to a location to receive the address where the image was
+ *      mapped.  This is set to NULL if the mapping failed.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_INV_PARAM:      The length is zero.
+ *  AXP_VHD_NOT_SUPPORTED:  The image could not be mapped.
+ */
+u32 AXP_VHD_MapImage(int fd, u64 length, bool writable, u8 **mapAddr)
+{
+    void *addr;
+    int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    *mapAddr = NULL;
+    if ((fd >= 0) && (length > 0))
+    {
+        addr = mmap(NULL, length, prot, MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            *mapAddr = (u8 *) addr;
+        }
+        else
+        {
+            retVal = AXP_VHD_NOT_SUPPORTED;
+        }
+    }
+    else
+    {
+        retVal = AXP_VHD_INV_PARAM;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_VHD_UnmapImage
+ *  This function is called to remove a mapping previously established by a
+ *  call to AXP_VHD_MapImage.  If the mapping was writable, the modified pages
+ *  are written to the backing file before the mapping is removed.
+ *
+ * Input Parameters:
+ *  mapAddr:
+ *      The address where the image was mapped.
+ *  length:
+ *      The number of bytes that were mapped.
+ *  writable:
+ *      A boolean indicating whether the mapping allowed writes.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+void AXP_VHD_UnmapImage(u8 *mapAddr, u64 length, bool writable)
+{
+    if (mapAddr != NULL)
+    {
+        if (writable == true)
+        {
+            msync(mapAddr, length, MS_SYNC);
+        }
+        munmap(mapAddr, length);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_VHD_AdviseImage
+ *  This function is called to pass an access pattern hint for a range of a
+ *  mapped image on to the host.  The range is expanded to page boundaries.
+ *
+ * Input Parameters:
+ *  mapAddr:
+ *      The address where the image was mapped.
+ *  mapLength:
+ *      The number of bytes that were mapped.
+ *  offset:
+ *      The byte offset, from the start of the mapping, of the range.
+ *  length:
+ *      The number of bytes in the range.  If zero, the entire mapping is
+ *      used.
+ *  hint:
+ *      A value indicating the expected access pattern for the range.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_INV_PARAM:      The range or hint is not valid.
+ *  AXP_VHD_NOT_SUPPORTED:  The image is not mapped.
+ */
+u32 AXP_VHD_AdviseImage(u8 *mapAddr,
+                        u64 mapLength,
+                        u64 offset,
+                        u64 length,
+                        AXP_VHD_ACCESS_HINT hint)
+{
+    u64 pageMask = (u64) sysconf(_SC_PAGESIZE) - 1;
+    u64 start, end;
+    int advice;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    if (length == 0)
+    {
+        offset = 0;
+        length = mapLength;
+    }
+    switch (hint)
+    {
+        case ACCESS_HINT_NORMAL:
+            advice = MADV_NORMAL;
+            break;
+
+        case ACCESS_HINT_SEQUENTIAL:
+            advice = MADV_SEQUENTIAL;
+            break;
+
+        case ACCESS_HINT_RANDOM:
+            advice = MADV_RANDOM;
+            break;
+
+        case ACCESS_HINT_WILLNEED:
+            advice = MADV_WILLNEED;
+            break;
+
+        case ACCESS_HINT_DONTNEED:
+            advice = MADV_DONTNEED;
+            break;
+
+        default:
+            advice = -1;
+            retVal = AXP_VHD_INV_PARAM;
+            break;
+    }
+    if (mapAddr == NULL)
+    {
+        retVal = AXP_VHD_NOT_SUPPORTED;
+    }
+    else if ((offset + length) > mapLength)
+    {
+        retVal = AXP_VHD_INV_PARAM;
+    }
+
+    /*
+     * The hint is only advisory, so we do not care whether the host actually
+     * took it.
+     */
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        start = offset & ~pageMask;
+        end = (offset + length + pageMask) & ~pageMask;
+        if (end > ((mapLength + pageMask) & ~pageMask))
+        {
+            end = (mapLength + pageMask) & ~pageMask;
+        }
+        madvise(&mapAddr[start], end - start, advice);
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return(retVal);
+}
+
 /*
  * AXP_VHD_ValidateCreate
  *  This function is called to validate the parameters for the AXP_VHD_Create.
@@ -537,8 +745,18 @@ u32 AXP_VHD_ValidateCreate(AXP_VHD_STORAGE_TYPE *storageType,
             *deviceID = storageType->deviceID;
             switch(storageType->deviceID)
             {
-                case STORAGE_TYPE_DEV_ISO:
                 case STORAGE_TYPE_DEV_SSD:
+                    minDisk = ONE_M;
+                    maxDisk = ONE_T;
+                    minBlk = AXP_SSD_BLK_MIN;
+                    defBlk = AXP_SSD_BLK_DEF;
+                    maxBlk = AXP_SSD_BLK_MAX;
+                    minSector = AXP_SSD_SEC_MIN;
+                    defSector = AXP_SSD_SEC_DEF;
+                    maxSector = AXP_SSD_SEC_MAX;
+                    break;
+
+                case STORAGE_TYPE_DEV_ISO:
                     minDisk = 0;
                     maxDisk = 0;
                     minBlk = 0;
@@ -671,8 +889,8 @@ u32 AXP_VHD_ValidateCreate(AXP_VHD_STORAGE_TYPE *storageType,
                  (accessMask != ACCESS_NONE)) ||
                 (flags > CREATE_FULL_PHYSICAL_ALLOCATION) ||
                 ((accessMask & ~ACCESS_ALL) != 0) ||
-                 (((*blkSize <= minBlk) ||
-                   (*blkSize >= maxBlk)) ||
+                 (((*blkSize < minBlk) ||
+                   (*blkSize > maxBlk)) ||
                   (IS_POWER_OF_2(*blkSize) == false)) ||
                  ((*sectorSize != minSector) &&
                   (*sectorSize != maxSector)) ||
@@ -682,7 +900,8 @@ u32 AXP_VHD_ValidateCreate(AXP_VHD_STORAGE_TYPE *storageType,
             {
                 retVal = AXP_VHD_INV_PARAM;
             }
-            else if (*parentPath != NULL)
+            else if ((*parentPath != NULL) &&
+                     (*deviceID != STORAGE_TYPE_DEV_VHD))
             {
                 retVal = AXP_VHD_NOT_SUPPORTED;
             }
@@ -756,13 +975,17 @@ u32 AXP_VHD_ValidateOpen(AXP_VHD_STORAGE_TYPE *storageType,
          *
          *  1) Only Version 1 is supported at this time.
          *  2) The access mask must only include the same bits set by ALL.
-         *  3) The flags is not equal to OPEN_NO_PARENTS or OPEN_BLANK_FILE.
+         *  3) The flags is not equal to OPEN_NONE (open the parents of a
+         *     differencing disk), OPEN_NO_PARENTS, OPEN_BLANK_FILE, or
+         *     OPEN_MAPPED_IO.
          */
         if (((param != NULL) &&
              (param->ver != OPEN_VER_1)) ||
             ((accessMask & ~ACCESS_ALL) != 0) ||
-             ((flags != OPEN_NO_PARENTS) &&
-              (flags != OPEN_BLANK_FILE)))
+             ((flags != OPEN_NONE) &&
+              (flags != OPEN_NO_PARENTS) &&
+              (flags != OPEN_BLANK_FILE) &&
+              (flags != OPEN_MAPPED_IO)))
         {
             retVal = AXP_VHD_INV_PARAM;
         }
@@ -791,6 +1014,80 @@ u32 AXP_VHD_ValidateOpen(AXP_VHD_STORAGE_TYPE *storageType,
     return(retVal);
 }
 
+/*
+ * _AXP_VHD_HandleGeometry
+ *  This function is called to extract the device type, sector size, and disk
+ *  size from one of the handle types that can be returned from the open and
+ *  create calls.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A handle to an open virtual or physical disk.
+ *
+ * Output Parameters:
+ *  deviceID:
+ *      A pointer to a 32-bit unsigned integer to receive the type of device.
+ *  sectorSize:
+ *      A pointer to a 32-bit unsigned integer to receive the size of each
+ *      sector, in bytes.
+ *  diskSize:
+ *      A pointer to a 64-bit unsigned integer to receive the size of the disk,
+ *      in bytes.
+ *
+ * Return Values:
+ *  true:   The handle is one we know about.
+ *  false:  The handle is not valid.
+ */
+static bool _AXP_VHD_HandleGeometry(AXP_VHD_HANDLE handle,
+                                    u32 *deviceID,
+                                    u32 *sectorSize,
+                                    u64 *diskSize)
+{
+    bool retVal = true;
+
+    switch (AXP_ReturnType_Block(handle))
+    {
+        case AXP_VHDX_BLK:
+            {
+                AXP_VHDX_Handle *vhd = (AXP_VHDX_Handle *) handle;
+
+                *deviceID = vhd->deviceID;
+                *sectorSize = vhd->sectorSize;
+                *diskSize = vhd->diskSize;
+            }
+            break;
+
+        case AXP_RAW_BLK:
+            {
+                AXP_RAW_Handle *raw = (AXP_RAW_Handle *) handle;
+
+                *deviceID = raw->deviceID;
+                *sectorSize = raw->sectorSize;
+                *diskSize = raw->diskSize;
+            }
+            break;
+
+        case AXP_SSD_BLK:
+            {
+                AXP_SSD_Handle *ssd = (AXP_SSD_Handle *) handle;
+
+                *deviceID = ssd->deviceID;
+                *sectorSize = ssd->sectorSize;
+                *diskSize = ssd->diskSize;
+            }
+            break;
+
+        default:
+            retVal = false;
+            break;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return(retVal);
+}
+
 /*
  * AXP_VHD_ValidateRead
  *  This function is called to verify the parameters on a read function call.
@@ -814,23 +1111,19 @@ u32 AXP_VHD_ValidateRead(AXP_VHD_HANDLE handle,
                          u32 sectorsRead,
                          u32 *deviceID)
 {
-    AXP_VHDX_Handle *vhdHandle;
     u32 retVal = AXP_VHD_SUCCESS;
     u64 blkOffset;
+    u64 diskSize;
+    u32 sectorSize;
 
-    if (AXP_ReturnType_Block(handle) == AXP_VHDX_BLK)
+    if (_AXP_VHD_HandleGeometry(handle, deviceID, &sectorSize, &diskSize))
     {
-        vhdHandle = (AXP_VHDX_Handle *) handle;
-        blkOffset = (u64) vhdHandle->sectorSize * lba;
-        blkOffset += ((u64) sectorsRead * (u64) vhdHandle->sectorSize);
-        if (blkOffset > vhdHandle->diskSize)
+        blkOffset = (u64) sectorSize * lba;
+        blkOffset += ((u64) sectorsRead * (u64) sectorSize);
+        if (blkOffset > diskSize)
         {
             retVal = AXP_VHD_INV_PARAM;
         }
-        else
-        {
-            *deviceID = vhdHandle->deviceID;
-        }
     }
     else
     {
@@ -866,23 +1159,19 @@ u32 AXP_VHD_ValidateWrite(AXP_VHD_HANDLE handle,
                           u32 sectorsWritten,
                           u32 *deviceID)
 {
-    AXP_VHDX_Handle *vhdHandle;
     u32 retVal = AXP_VHD_SUCCESS;
     u64 blkOffset;
+    u64 diskSize;
+    u32 sectorSize;
 
-    if (AXP_ReturnType_Block(handle) == AXP_VHDX_BLK)
+    if (_AXP_VHD_HandleGeometry(handle, deviceID, &sectorSize, &diskSize))
     {
-        vhdHandle = (AXP_VHDX_Handle *) handle;
-        blkOffset = (u64) vhdHandle->sectorSize * lba;
-        blkOffset += ((u64) sectorsWritten * (u64) vhdHandle->sectorSize);
-        if (blkOffset > vhdHandle->diskSize)
+        blkOffset = (u64) sectorSize * lba;
+        blkOffset += ((u64) sectorsWritten * (u64) sectorSize);
+        if (blkOffset > diskSize)
         {
             retVal = AXP_VHD_INV_PARAM;
         }
-        else
-        {
-            *deviceID = vhdHandle->deviceID;
-        }
     }
     else
     {
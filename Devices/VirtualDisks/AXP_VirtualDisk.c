@@ -23,7 +23,29 @@
  *
  *  V01.000 08-Jul-2018 Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Enabled RAW/ISO reads and RAW writes, corrected VHD writes, which were
+ *  calling the read function, and added the functions to return a mapped
+ *  address for a set of sectors and to give the host access pattern hints.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Enabled SSD reads and writes.  Closing an SSD flushes its modified pages
+ *  back to the backing store file.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Reads and writes now go through the host block cache.  The format
+ *  specific dispatch was moved into backend functions that the cache calls
+ *  on a miss or write-back.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Added the function to create a snapshot overlay on top of an open VHD.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  A newly created disk is also attached to the host block cache.
  */
+#include "Devices/VirtualDisks/AXP_VHD_Utility.h"
+#include "Devices/VirtualDisks/AXP_VHD_Cache.h"
 #include "Devices/VirtualDisks/AXP_VirtualDisk.h"
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Blocks.h"
@@ -179,6 +201,14 @@ u32 AXP_VHD_Create(AXP_VHD_STORAGE_TYPE *storageType,
                 retVal = AXP_VHD_CALL_NOT_IMPL;
                 break;
         }
+
+        /*
+         * If the disk was created, see if the block cache will take it.
+         */
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            AXP_VHD_CacheAttach(*handle);
+        }
     }
 
     /*
@@ -304,6 +334,14 @@ u32 AXP_VHD_Open(AXP_VHD_STORAGE_TYPE *storageType,
                 retVal = AXP_VHD_CALL_NOT_IMPL;
                 break;
         }
+
+        /*
+         * If the disk was opened, see if the block cache will take it.
+         */
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            AXP_VHD_CacheAttach(*handle);
+        }
     }
 
     /*
@@ -356,52 +394,20 @@ u32 AXP_VHD_ReadSectors(AXP_VHD_HANDLE handle,
     {
 
         /*
-         * Based on storage type, call the appropriate read sectors function.
+         * If the disk is in the block cache, the cache does the read,
+         * otherwise go directly to the format specific function.
          */
-        switch (deviceID)
+        if (AXP_VHD_CacheRead(handle,
+                              lba,
+                              sectorsRead,
+                              outBuf,
+                              &retVal) == false)
         {
-
-            /*
-             * Read from a VHD formatted virtual disk.
-             */
-            case STORAGE_TYPE_DEV_VHD:
-                retVal = _AXP_VHD_ReadSectors(handle,
-                                              lba,
-                                              (size_t *) sectorsRead,
-                                              outBuf);
-                break;
-
-#if 0
-            /*
-             * Read from a VHDX formatted virtual disk.  TODO
-             */
-            case STORAGE_TYPE_DEV_VHDX:
-                retVal = _AXP_VHDX_ReadSectors(handle,
-                                               lba,
-                                               sectorsRead,
-                                               outBuf);
-                break;
-
-            /*
-             * Read from a RAW or ISO formatted physical/virtual disk. TODO
-             */
-            case STORAGE_TYPE_DEV_RAW:
-            case STORAGE_TYPE_DEV_ISO:
-                retVal = _AXP_RAW_ReadSectors(handle, lba, sectorsRead, outBuf);
-                break;
-
-            /*
-             * Read from a Solid State Disk (SSD). TODO
-             */
-            case STORAGE_TYPE_DEV_SSD:
-                retVal = _AXP_SSD_ReadSectors(handle, lba, sectorsRead, outBuf);
-                break;
-#endif
-
-            case STORAGE_TYPE_DEV_UNKNOWN:
-            default:
-                retVal = AXP_VHD_CALL_NOT_IMPL;
-                break;
+            retVal = _AXP_VHD_ReadBackend(handle,
+                                          deviceID,
+                                          lba,
+                                          sectorsRead,
+                                          outBuf);
         }
     }
 
@@ -455,62 +461,223 @@ u32 AXP_VHD_WriteSectors(AXP_VHD_HANDLE handle,
     {
 
         /*
-         * Based on storage type, call the appropriate read sectors function.
+         * If the disk is in the block cache, the cache does the write,
+         * otherwise go directly to the format specific function.
          */
-        switch (deviceID)
+        if (AXP_VHD_CacheWrite(handle,
+                               lba,
+                               sectorsWritten,
+                               inBuf,
+                               &retVal) == false)
         {
+            retVal = _AXP_VHD_WriteBackend(handle,
+                                           deviceID,
+                                           lba,
+                                           sectorsWritten,
+                                           inBuf);
+        }
+    }
 
-            /*
-             * Write to a VHD formatted virtual disk.
-             */
-            case STORAGE_TYPE_DEV_VHD:
-                retVal = _AXP_VHD_ReadSectors(handle,
-                                              lba,
-                                              (size_t *) sectorsWritten,
-                                              inBuf);
-                break;
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * _AXP_VHD_ReadBackend
+ *  This function is called to read one or more sectors from the format
+ *  specific disk.  It is called directly when the disk is not in the block
+ *  cache, and by the block cache when a block is not in the cache.  The
+ *  parameters have already been validated.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *  deviceID:
+ *      A value indicating the format of the disk.
+ *  lba:
+ *      A value representing the Logical Block Address from where the read is
+ *      to be started.
+ *  sectorsRead:
+ *      A pointer to a value representing the number of sectors to be read from
+ *      the VHD.
+ *
+ * Output Parameters:
+ *  outBuf:
+ *      A pointer to an array of unsigned bytes to receive the data read in
+ *      from the sectors.
+ *  sectorsRead:
+ *      A pointer to an unsigned 32-bit location to receive the number of
+ *      actual sectors read.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_CALL_NOT_IMPL:  Reads are not implemented for the format.
+ *  TODO: Cross reference with format specific function returns.
+ */
+u32 _AXP_VHD_ReadBackend(AXP_VHD_HANDLE handle,
+                         u32 deviceID,
+                         u64 lba,
+                         u32 *sectorsRead,
+                         u8 *outBuf)
+{
+    size_t sectors;
+    u32 retVal;
+
+    /*
+     * Based on storage type, call the appropriate read sectors function.
+     */
+    switch (deviceID)
+    {
+
+        /*
+         * Read from a VHD formatted virtual disk.
+         */
+        case STORAGE_TYPE_DEV_VHD:
+            sectors = *sectorsRead;
+            retVal = _AXP_VHD_ReadSectors(handle,
+                                          lba,
+                                          &sectors,
+                                          outBuf);
+            *sectorsRead = (u32) sectors;
+            break;
+
+        /*
+         * Read from a RAW or ISO formatted physical/virtual disk.
+         */
+        case STORAGE_TYPE_DEV_RAW:
+        case STORAGE_TYPE_DEV_ISO:
+            retVal = _AXP_RAW_ReadSectors(handle, lba, sectorsRead, outBuf);
+            break;
+
+        /*
+         * Read from a Solid State Disk (SSD).
+         */
+        case STORAGE_TYPE_DEV_SSD:
+            retVal = _AXP_SSD_ReadSectors(handle, lba, sectorsRead, outBuf);
+            break;
 
 #if 0
-            /*
-             * Write to a VHDX formatted virtual disk. TODO
-             */
-            case STORAGE_TYPE_DEV_VHDX:
-                retVal = _AXP_VHDX_ReadSectors(handle,
-                                               lba,
-                                               sectorsWritten,
-                                               inBuf);
-                break;
+        /*
+         * Read from a VHDX formatted virtual disk.  TODO
+         */
+        case STORAGE_TYPE_DEV_VHDX:
+            retVal = _AXP_VHDX_ReadSectors(handle,
+                                           lba,
+                                           sectorsRead,
+                                           outBuf);
+            break;
+#endif
 
-            /*
-             * Write to a RAW formatted physical disk. TODO
-             */
-            case STORAGE_TYPE_DEV_RAW:
-                retVal = _AXP_RAW_ReadSectors(handle,
-                                              lba,
-                                              sectorsWritten,
-                                              inBuf);
-                break;
+        case STORAGE_TYPE_DEV_UNKNOWN:
+        default:
+            retVal = AXP_VHD_CALL_NOT_IMPL;
+            break;
+    }
 
-            /*
-             * Write to a Solid State Disk (SSD). TODO
-             */
-            case STORAGE_TYPE_DEV_SSD:
-                retVal = _AXP_SSD_ReadSectors(handle,
-                                              lba,
-                                              sectorsWritten,
-                                              inBuf);
-                break;
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * _AXP_VHD_WriteBackend
+ *  This function is called to write one or more sectors to the format
+ *  specific disk.  It is called directly when the disk is not in the block
+ *  cache, and by the block cache when a dirty block is written back.  The
+ *  parameters have already been validated.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *  deviceID:
+ *      A value indicating the format of the disk.
+ *  lba:
+ *      A value representing the Logical Block Address from where the write is
+ *      to be started.
+ *  sectorsWritten:
+ *      A pointer to a value representing the number of sectors to be written
+ *      to the VHD.
+ *  inBuf:
+ *      A pointer to an array of unsigned bytes from which to write the data to
+ *      the sectors.
+ *
+ * Output Parameters:
+ *  sectorsWritten:
+ *      A pointer to an unsigned 32-bit location to receive the number of
+ *      actual sectors written.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_CALL_NOT_IMPL:  Writes are not implemented for the format.
+ *  TODO: Cross reference with format specific function returns.
+ */
+u32 _AXP_VHD_WriteBackend(AXP_VHD_HANDLE handle,
+                          u32 deviceID,
+                          u64 lba,
+                          u32 *sectorsWritten,
+                          u8 *inBuf)
+{
+    u32 retVal;
+
+    /*
+     * Based on storage type, call the appropriate write sectors function.
+     */
+    switch (deviceID)
+    {
+
+        /*
+         * Write to a VHD formatted virtual disk.
+         */
+        case STORAGE_TYPE_DEV_VHD:
+            retVal = _AXP_VHD_WriteSectors(handle,
+                                           lba,
+                                           sectorsWritten,
+                                           inBuf);
+            break;
+
+        /*
+         * Write to a RAW formatted physical disk.
+         */
+        case STORAGE_TYPE_DEV_RAW:
+            retVal = _AXP_RAW_WriteSectors(handle,
+                                           lba,
+                                           sectorsWritten,
+                                           inBuf);
+            break;
+
+        /*
+         * Write to a Solid State Disk (SSD).
+         */
+        case STORAGE_TYPE_DEV_SSD:
+            retVal = _AXP_SSD_WriteSectors(handle,
+                                           lba,
+                                           sectorsWritten,
+                                           inBuf);
+            break;
+
+#if 0
+        /*
+         * Write to a VHDX formatted virtual disk. TODO
+         */
+        case STORAGE_TYPE_DEV_VHDX:
+            retVal = _AXP_VHDX_ReadSectors(handle,
+                                           lba,
+                                           sectorsWritten,
+                                           inBuf);
+            break;
 #endif
 
-            /*
-             * We don't write to these kinds of VHDs.
-             */
-            case STORAGE_TYPE_DEV_UNKNOWN:
-            case STORAGE_TYPE_DEV_ISO:
-            default:
-                retVal = AXP_VHD_CALL_NOT_IMPL;
-                break;
-        }
+        /*
+         * We don't write to these kinds of VHDs.
+         */
+        case STORAGE_TYPE_DEV_UNKNOWN:
+        case STORAGE_TYPE_DEV_ISO:
+        default:
+            retVal = AXP_VHD_CALL_NOT_IMPL;
+            break;
     }
 
     /*
@@ -536,21 +703,287 @@ u32 AXP_VHD_WriteSectors(AXP_VHD_HANDLE handle,
  */
 u32 AXP_VHD_CloseHandle(AXP_VHD_HANDLE handle)
 {
-    AXP_VHDX_Handle *vhdx = (AXP_VHDX_Handle *) handle;
     u32 retVal = AXP_VHD_SUCCESS;
 
     /*
-     * Verify that we have a proper handle.
+     * Verify that we have a proper handle.  Any blocks in the block cache
+     * that have not been written yet are written before the disk is closed.
+     * Deallocating the block closes the file and removes any mapping of the
+     * disk image.
+     */
+    switch (AXP_ReturnType_Block(handle))
+    {
+        case AXP_VHDX_BLK:
+        case AXP_RAW_BLK:
+            retVal = AXP_VHD_CacheDetach(handle);
+            AXP_Deallocate_Block(handle);
+            break;
+
+        case AXP_SSD_BLK:
+            _AXP_SSD_Close(handle);
+            AXP_Deallocate_Block(handle);
+            break;
+
+        default:
+            retVal = AXP_VHD_INV_HANDLE;
+            break;
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * _AXP_VHD_MappedImage
+ *  This function is called to return the mapping information for a virtual
+ *  disk handle, if the disk image was mapped into memory when it was opened.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *
+ * Output Parameters:
+ *  mapAddr:
+ *      A pointer to a location to receive the address of the mapped image.
+ *  mapLength:
+ *      A pointer to a location to receive the length of the mapped image.
+ *  sectorSize:
+ *      A pointer to a location to receive the sector size of the disk.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_INV_HANDLE:     The handle is not for a disk type that can be
+ *                          mapped.
+ *  AXP_VHD_NOT_SUPPORTED:  The disk image is not mapped.
+ */
+static u32 _AXP_VHD_MappedImage(AXP_VHD_HANDLE handle,
+                                u8 **mapAddr,
+                                u64 *mapLength,
+                                u32 *sectorSize)
+{
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    switch (AXP_ReturnType_Block(handle))
+    {
+        case AXP_VHDX_BLK:
+            *mapAddr = ((AXP_VHDX_Handle *) handle)->mapAddr;
+            *mapLength = ((AXP_VHDX_Handle *) handle)->mapLength;
+            *sectorSize = ((AXP_VHDX_Handle *) handle)->sectorSize;
+            break;
+
+        case AXP_RAW_BLK:
+            *mapAddr = ((AXP_RAW_Handle *) handle)->mapAddr;
+            *mapLength = ((AXP_RAW_Handle *) handle)->mapLength;
+            *sectorSize = ((AXP_RAW_Handle *) handle)->sectorSize;
+            break;
+
+        default:
+            *mapAddr = NULL;
+            retVal = AXP_VHD_INV_HANDLE;
+            break;
+    }
+    if ((retVal == AXP_VHD_SUCCESS) && (*mapAddr == NULL))
+    {
+        retVal = AXP_VHD_NOT_SUPPORTED;
+    }
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_VHD_SetAccessHint
+ *  This function is called to let the host know how a range of sectors on a
+ *  virtual disk, opened with OPEN_MAPPED_IO, is about to be accessed.  This
+ *  allows the host to read ahead sequential streams, or not bother to for
+ *  random access, and to release pages that will no longer be needed.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *  lba:
+ *      A value representing the Logical Block Address of the start of the
+ *      range of sectors.
+ *  sectors:
+ *      A value representing the number of sectors in the range.  A value of
+ *      zero indicates the entire disk.
+ *  hint:
+ *      A value indicating the expected access pattern.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_INV_HANDLE:     The handle is not for a disk type that can be
+ *                          mapped.
+ *  AXP_VHD_INV_PARAM:      The range of sectors is not on the disk.
+ *  AXP_VHD_NOT_SUPPORTED:  The disk image is not mapped.
+ */
+u32 AXP_VHD_SetAccessHint(AXP_VHD_HANDLE handle,
+                          u64 lba,
+                          u32 sectors,
+                          AXP_VHD_ACCESS_HINT hint)
+{
+    u8 *mapAddr;
+    u64 mapLength;
+    u64 offset;
+    u32 sectorSize;
+    u32 retVal;
+
+    retVal = _AXP_VHD_MappedImage(handle, &mapAddr, &mapLength, &sectorSize);
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        offset = lba * (u64) sectorSize;
+        if ((offset + ((u64) sectors * (u64) sectorSize)) <= mapLength)
+        {
+            retVal = AXP_VHD_AdviseImage(mapAddr,
+                                         mapLength,
+                                         offset,
+                                         (u64) sectors * (u64) sectorSize,
+                                         hint);
+        }
+        else
+        {
+            retVal = AXP_VHD_INV_PARAM;
+        }
+    }
+
+    /*
+     * Return the results of this call back to the caller.
      */
-    if (AXP_ReturnType_Block(handle) == AXP_VHDX_BLK)
+    return (retVal);
+}
+
+/*
+ * AXP_VHD_GetMappedSectors
+ *  This function is called to return the address, within the mapped disk
+ *  image, of a range of sectors on a virtual disk opened with OPEN_MAPPED_IO.
+ *  This allows a caller, such as a DMA engine, to copy the data directly
+ *  without first reading it into an intermediate buffer.  The returned
+ *  address must only be read from and is valid until the handle is closed.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open object.
+ *  lba:
+ *      A value representing the Logical Block Address of the first sector.
+ *  sectors:
+ *      A value representing the number of sectors that are going to be read.
+ *
+ * Output Parameters:
+ *  sectorAddr:
+ *      A pointer to a location to receive the address of the first sector.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_INV_HANDLE:     The handle is not for a disk type that can be
+ *                          mapped.
+ *  AXP_VHD_INV_PARAM:      The range of sectors is not on the disk.
+ *  AXP_VHD_NOT_SUPPORTED:  The disk image is not mapped.
+ */
+u32 AXP_VHD_GetMappedSectors(AXP_VHD_HANDLE handle,
+                             u64 lba,
+                             u32 sectors,
+                             u8 **sectorAddr)
+{
+    u8 *mapAddr;
+    u64 mapLength;
+    u64 offset;
+    u32 sectorSize;
+    u32 retVal;
+
+    *sectorAddr = NULL;
+    retVal = _AXP_VHD_MappedImage(handle, &mapAddr, &mapLength, &sectorSize);
+    if (retVal == AXP_VHD_SUCCESS)
     {
-        AXP_Deallocate_Block(vhdx);
+        offset = lba * (u64) sectorSize;
+        if ((offset + ((u64) sectors * (u64) sectorSize)) <= mapLength)
+        {
+            *sectorAddr = &mapAddr[offset];
+        }
+        else
+        {
+            retVal = AXP_VHD_INV_PARAM;
+        }
     }
-    else
+
+    /*
+     * Return the results of this call back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_VHD_CreateOverlay
+ *  This function is called to create a snapshot overlay on top of an open
+ *  VHD.  The overlay is a differencing VHD whose parent is the open VHD.
+ *  Reads of blocks that have not been written through the overlay come from
+ *  the parent, and the first write to a block copies it into the overlay.
+ *  The open VHD becomes read-only, but stays open and continues to belong to
+ *  the caller.  Any number of overlays can be created on top of the same VHD,
+ *  so that many guests can be started from a single image, without copying
+ *  it.  The overlays need to be closed before the VHD they are on top of.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A valid handle to an open VHD.
+ *  path:
+ *      A pointer to a valid string that represents the path to the overlay
+ *      virtual disk image file to be created.
+ *
+ * Output Parameters:
+ *  overlay:
+ *      A pointer to a location to receive the handle for the overlay.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal Successful Completion.
+ *  AXP_VHD_INV_HANDLE:     The handle is not for an open VHD.
+ *  AXP_VHD_INV_PARAM:      The path or overlay parameter is NULL.
+ *  AXP_VHD_WRITE_FAULT:    An error occurred writing to the overlay file, or
+ *                          writing the VHD's cached blocks back to it.
+ *  TODO: Cross reference with format specific function returns.
+ */
+u32 AXP_VHD_CreateOverlay(AXP_VHD_HANDLE handle,
+                          char *path,
+                          AXP_VHD_HANDLE *overlay)
+{
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    if ((path == NULL) || (overlay == NULL))
+    {
+        retVal = AXP_VHD_INV_PARAM;
+    }
+    else if ((AXP_ReturnType_Block(handle) != AXP_VHDX_BLK) ||
+             (((AXP_VHDX_Handle *) handle)->deviceID != STORAGE_TYPE_DEV_VHD))
     {
         retVal = AXP_VHD_INV_HANDLE;
     }
 
+    /*
+     * Everything written to the VHD needs to be in the file before it becomes
+     * a parent.  It is detached from the block cache, and attached again
+     * after it has become read-only, so that its writes no longer go into the
+     * cache.
+     */
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = AXP_VHD_CacheDetach(handle);
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = _AXP_VHD_CreateOverlay(handle, path, overlay);
+        AXP_VHD_CacheAttach(handle);
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        AXP_VHD_CacheAttach(*overlay);
+    }
+
     /*
      * Return the results of this call back to the caller.
      */
@@ -86,6 +86,49 @@
  *  the system/AXP_21274_21264_Common.h file.  When the System structure is
  *  allocated, it will call the CPU allocation function for each of the CPUs
  *  configured on the system.
+ *
+ *  V01.013 19-Oct-2026 Jonathan D. Belanger
+ *  Added the fields used to detect the CPU is in an idle loop and park it.
+ *
+ *  V01.014 19-Oct-2026 Jonathan D. Belanger
+ *  The IRQ_H bits are now updated atomically, and the Cbox has a flag to say
+ *  when it is waiting, so the System only signals it when it needs to.
+ *
+ *  V01.015 19-Oct-2026 Jonathan D. Belanger
+ *  Added the MAF hash buckets, the queue of requests waiting for an MAF entry,
+ *  and the MAF statistics.
+ *
+ *  V01.016 19-Oct-2026 Jonathan D. Belanger
+ *  Added the Icache prefetch tracking and statistics, and the last fetch
+ *  location used to train the line and set predictors.
+ *
+ *  V01.017 19-Oct-2026 Jonathan D. Belanger
+ *  Added the branch prediction statistics and the branch trace file.
+ *
+ *  V01.018 19-Oct-2026 Jonathan D. Belanger
+ *  Removed the ROB mutex.  The state of each ROB entry is now transitioned
+ *  atomically and the start and end indexes are only updated by the Ibox.
+ *
+ *  V01.019 19-Oct-2026 Jonathan D. Belanger
+ *  Added the register map history, a copy of the integer and floating-point
+ *  register maps taken for each branch in the ROB.
+ *
+ *  V01.020 19-Oct-2026 Jonathan D. Belanger
+ *  The CPU now has the address of its skid buffers in the System and the next
+ *  one it will use.
+ *
+ *  V01.021 19-Oct-2026 Jonathan D. Belanger
+ *  Added the fields used to detect an idle loop that polls memory, which the
+ *  CPU is only parked in for a while at a time.
+ *
+ *  V01.022 19-Oct-2026 Jonathan D. Belanger
+ *  The CPU now has the address of the System's flag that has it redo the
+ *  IRQ_H bits, so that IRQ<1> is posted again after the CPU has taken it, if
+ *  a device is still asserting it.
+ *
+ *  V01.023 19-Oct-2026 Jonathan D. Belanger
+ *  Added the flag that tells the System the CPU is waiting for one of its skid
+ *  buffers to be released.
  */
 #ifndef _AXP_21264_CPU_DEFS_
 #define _AXP_21264_CPU_DEFS_
@@ -140,6 +183,8 @@
 #define AXP_21264_IOWB_LEN      4
 #define AXP_21264_VDB_LEN       8
 #define AXP_21264_MAF_LEN       8
+#define AXP_21264_MAF_HASH_LEN  16
+#define AXP_21264_MAF_WAIT_LEN  ((2 * AXP_MBOX_QUEUE_LEN) + AXP_21264_MAF_LEN)
 #define AXP_21264_EBOX_L0       0
 #define AXP_21264_EBOX_L1       1
 #define AXP_21264_EBOX_U0       2
@@ -241,6 +286,10 @@ typedef struct
     bool branch2bTaken;
     u32 linePrediction;
     u32 setPrediction;
+    u32 fetchIndex;     /* Icache line, set and fetch block last fetched */
+    u32 fetchSet;
+    u32 fetchBlock;
+    bool fetchValid;
     u64 retPredStack;
     AXP_INS_FMT instructions[AXP_NUM_FETCH_INS];
     AXP_INS_TYPE instrType[AXP_NUM_FETCH_INS];
@@ -256,6 +305,20 @@ typedef struct
     bool processing;
 } AXP_QUEUE_ENTRY;
 
+/*
+ * This structure is one entry in the register map history.  There is one for
+ * each ROB entry, and when a branch is decoded, the integer and floating-point
+ * register maps, as they are after renaming the branch, are saved in it.  When
+ * the branch turns out to have been mispredicted, the maps are put back from
+ * here, rather than undoing the renaming of each aborted instruction.
+ */
+typedef struct
+{
+    u16 prMap[AXP_MAX_INT_REGISTERS];
+    u16 pfMap[AXP_MAX_FP_REGISTERS];
+    bool valid;
+} AXP_REG_MAP_CKPT;
+
 /*
  * The following states are used during CPU execution.  The state transitions
  * are as follows:
@@ -326,6 +389,10 @@ typedef struct
     pthread_mutex_t *mutex;
     pthread_cond_t *cond;
     AXP_QUEUE_HDR *rq;
+    AXP_21264_RQ_ENTRY *skidBuffers;    /* AXP_21264_CCHIP_RQ_LEN of these */
+    bool *irqUpdate;                    /* System needs to redo IRQ_H */
+    u32 skidEnd;                        /* Next skid buffer to be filled */
+    bool skidWait;                      /* Waiting for a skid buffer */
 } AXP_21264_SYSTEM;
 
 /*
@@ -377,6 +444,10 @@ typedef struct
     GPT globalPredictor;
     CPT choicePredictor;
     u16 globalPathHistory;
+    AXP_BRANCH_STATS bpStats;
+    FILE *bpTraceFp;                    /* Branch trace file, or NULL */
+    AXP_BRANCH_TRACE_REC *bpTraceBuf;
+    u32 bpTraceCount;
     u8 instrCounter;                    /* Unique ID for each instruction */
     AXP_PC predictionStack[AXP_INFLIGHT_MAX];
     u8 predStackIdx;
@@ -389,13 +460,19 @@ typedef struct
     u32 vpcEnd;
 
     /*
-     * Reorder Buffer
+     * Reorder Buffer.  The Ibox is the only one that moves the start and end
+     * indexes.  The state of each entry is shared with the Ebox and Fbox and
+     * is only accessed using the AXP_ROB_*_STATE macros.
      */
-    pthread_mutex_t robMutex;
     AXP_INSTRUCTION rob[AXP_INFLIGHT_MAX];
     u32 robStart;
     u32 robEnd;
 
+    /*
+     * Register map history, indexed the same as the ROB.
+     */
+    AXP_REG_MAP_CKPT mapCkpt[AXP_INFLIGHT_MAX];
+
     /*
      * Instruction Queues (Integer and Floating-Point), as well as the IQ
      * scoreboard bits.
@@ -446,8 +523,34 @@ typedef struct
     pthread_mutex_t iCacheMutex;
     AXP_ICACHE_BLK iCache[AXP_CACHE_ENTRIES][AXP_2_WAY_CACHE];
     bool iCacheFlushPending;
+
+    /*
+     * Icache prefetching.  The Ibox requests up to iPrefetchDepth lines
+     * ahead of the one it is fetching from, and remembers them here so that
+     * it can tell whether they were of any use.
+     */
+    AXP_ICACHE_PREFETCH iPrefetch[AXP_ICACHE_PREFETCH_LEN];
+    u32 iPrefetchDepth;
+    u32 iPrefetchNext;
+    AXP_ICACHE_STATS iCacheStats;
     bool stallWaitingRetirement;
 
+    /*
+     * Idle loop detection.  The idle loop is the target of the last backward
+     * branch retired, and progress is set when anything has been retired
+     * since that changed a register, memory or the CPU's state.  Going around
+     * the same loop twice without progress means the CPU is idle, and the
+     * Ibox is parked until an event arrives.  Poll is set when the loop read
+     * memory or an IPR, which something other than an event can change, so
+     * the CPU is only parked for a while (timed) before going around again.
+     */
+    u64 idleLoop;
+    bool idleProgress;
+    bool idlePoll;
+    bool idleTimed;
+    bool idle;
+    bool parked;
+
     /*
      * This is the Instruction Address Translation (Look-aside) Table (ITB).
      * It is 128 entries in size, and is allocated in a round-robin scheme.
@@ -809,7 +912,12 @@ typedef struct
     AXP_21264_CBOX_PQ pq[AXP_21264_PQ_LEN];
     bool noProbeResponses;
     AXP_21264_CBOX_MAF maf[AXP_21264_MAF_LEN];
+    i8 mafHash[AXP_21264_MAF_HASH_LEN]; /* first MAF entry per block hash */
+    AXP_21264_CBOX_MAF_WAIT mafWait[AXP_21264_MAF_WAIT_LEN];
+    u8 mafWaitTop, mafWaitCount;
+    AXP_21264_CBOX_MAF_STATS mafStats;
     u8 irqH;                    /* Interrupt bits (IRQH[0:5] set by system */
+    bool cBoxSleeping;          /* Cbox is waiting on its condition        */
     u8 vdbTop, vdbBottom;
     u8 iowbTop, iowbBottom;
     u8 pqTop, pqBottom;
@@ -42,6 +42,10 @@
  *	Changed the LEN_STALL flag used for the HW_LD/ST and HW_RET instructions
  *	into two separate flags.  One to indicate a quadword len, and the other to
  *	indicate a stall in the Ibox.
+ *
+ *	V01.006		19-Oct-2026	Jonathan D. Belanger
+ *	Added the macros used to read and transition the state of a ROB entry
+ *	without holding a mutex.
  */
 #ifndef _AXP_21264_INS_DEFS_
 #define _AXP_21264_INS_DEFS_
@@ -1028,6 +1032,32 @@ typedef enum
     Aborted
 } AXP_INS_STATE;
 
+/*
+ * The state of a Reorder Buffer (ROB) entry is the only field shared between
+ * the Ibox, which queues, retires and aborts instructions, and the Ebox and
+ * Fbox, which execute them.  Rather than serializing everyone on a single
+ * mutex, the state is read with acquire and written with release semantics.
+ * The writer fills in the rest of the entry (results, exceptions) first and
+ * then publishes the new state, so a reader that sees the new state also sees
+ * everything written before it.
+ *
+ * Transitions that can race with another thread (Queued to Executing,
+ * Executing to WaitingRetirement and anything to Aborted) are done with a
+ * compare and exchange.  The expected state is passed by address and, when
+ * the exchange fails, is updated to the state actually found.
+ */
+#define AXP_ROB_GET_STATE(rob)                                              \
+    __atomic_load_n(&(rob)->state, __ATOMIC_ACQUIRE)
+#define AXP_ROB_SET_STATE(rob, newState)                                    \
+    __atomic_store_n(&(rob)->state, (newState), __ATOMIC_RELEASE)
+#define AXP_ROB_CHANGE_STATE(rob, expected, newState)                       \
+    __atomic_compare_exchange_n(&(rob)->state,                              \
+                                (expected),                                 \
+                                (newState),                                 \
+                                false,                                      \
+                                __ATOMIC_ACQ_REL,                           \
+                                __ATOMIC_ACQUIRE)
+
 /*
  * This structure is what will be put into the Reorder Buffer.  A queue entry
  * in the Integer or Floating-point Queues (IQ or FQ) will point to the queue
@@ -23,6 +23,13 @@
  *
  *  V01.000 29-Jul-2017 Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Added the line and set predictors to the Icache block, and the definitions
+ *  to track and count Icache prefetches.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Count the Icache prefetches not made because the MAF was full.
  */
 #ifndef _AXP_21264_CACHE_DEFS_DEFS_
 #define _AXP_21264_CACHE_DEFS_DEFS_
@@ -323,6 +330,21 @@ typedef struct
 
 #define AXP_ICACHE_LINE_INS        16
 #define AXP_ICACHE_BUF_LEN        64
+#define AXP_ICACHE_FETCH_BLKS     4    /* Line instructions / fetch size */
+
+/*
+ * Each fetch block (4 instructions) in an Icache block has a line and set
+ * prediction.  It indicates the Icache line and set the next fetch came from
+ * the last time this fetch block was executed, and so is trained both by
+ * falling through to the next line and by taken branches.
+ */
+typedef struct
+{
+    u16 index :9;   /* Predicted Icache line */
+    u16 set :1;     /* Predicted Icache set */
+    u16 vb :1;      /* Prediction has been trained */
+    u16 res :5;     /* align to the 16-bit boundary */
+} AXP_ICACHE_LINE_PRED;
 
 /*
  * This structure is the definition of one instruction cache block.  A block
@@ -356,9 +378,35 @@ typedef struct
     u64 tag :33;    /* Tag */
     u64 set_0_1 :1; /* When set 0 was last used */
     u64 res_1 :15;  /* align to the 64-bit boundary */
+    AXP_ICACHE_LINE_PRED linePred[AXP_ICACHE_FETCH_BLKS];
     AXP_INS_FMT instructions[AXP_ICACHE_LINE_INS];
 } AXP_ICACHE_BLK;
 
+/*
+ * The Ibox requests the next few Icache lines ahead of the one it is fetching
+ * from.  Each request is remembered until the line is fetched from (useful if
+ * the line had arrived, late if it had not) or the entry is needed for a later
+ * request (wasted).
+ */
+#define AXP_ICACHE_PREFETCH_LEN    16
+
+typedef struct
+{
+    u64 line;       /* VPC of the first instruction in the line */
+    bool valid;
+} AXP_ICACHE_PREFETCH;
+
+typedef struct
+{
+    u64 linePredHits;   /* Fetches the line/set predictor got right */
+    u64 linePredMisses; /* Fetches it got wrong */
+    u64 issued;         /* Prefetches sent to the Cbox */
+    u64 useful;         /* Prefetched lines in the Icache when fetched */
+    u64 late;           /* Prefetched lines fetched before they arrived */
+    u64 wasted;         /* Prefetched lines never fetched */
+    u64 skipped;        /* Prefetches not made, the MAF was full */
+} AXP_ICACHE_STATS;
+
 /*
  * 2.1.5.2 Data Cache
  *
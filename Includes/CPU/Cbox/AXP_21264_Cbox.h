@@ -45,6 +45,18 @@
  *
  *	V01.005		31-Dec-2017	Jonathan D. Belanger
  *	Added Cbox function prototypes.
+ *
+ *	V01.006		19-Oct-2026	Jonathan D. Belanger
+ *	Added AXP_21264_Drain_IOWB.
+ *
+ *	V01.007		19-Oct-2026	Jonathan D. Belanger
+ *	Added AXP_21264_Drain_MAF.
+ *
+ *	V01.008		19-Oct-2026	Jonathan D. Belanger
+ *	AXP_21264_Process_VDB now returns whether the entry was processed.
+ *
+ *	V01.009		19-Oct-2026	Jonathan D. Belanger
+ *	Added AXP_21264_Prefetch_MAF.
  */
 #ifndef _AXP_21264_CBOX_DEFS_DEFS_
 #define _AXP_21264_CBOX_DEFS_DEFS_
@@ -76,6 +88,7 @@ void AXP_21264_Bcache_ClearDirty(AXP_21264_CPU *, u64);
  */
 int AXP_21264_IOWB_Empty(AXP_21264_CPU *);
 void AXP_21264_Process_IOWB(AXP_21264_CPU *, int);
+bool AXP_21264_Drain_IOWB(AXP_21264_CPU *);
 bool AXP_21264_Merge_IOWB(AXP_21264_CBOX_IOWB *, u64, i8, u8 *, int, int);
 void AXP_21264_Add_IOWB(AXP_21264_CPU *, u64, i8, u8 *, int);
 void AXP_21264_Free_IOWB(AXP_21264_CPU *, u8);
@@ -85,6 +98,7 @@ void AXP_21264_Free_IOWB(AXP_21264_CPU *, u8);
  */
 int AXP_21264_MAF_Empty(AXP_21264_CPU *);
 void AXP_21264_Process_MAF(AXP_21264_CPU *, int);
+bool AXP_21264_Drain_MAF(AXP_21264_CPU *);
 void AXP_21264_Complete_MAF(AXP_21264_CPU *, int, AXP_SYSDC, u8 *);
 bool AXP_21265_Check_MAFAddrSent(AXP_21264_CPU *, u64, u8 *);
 bool AXP_21264_Add_MAF_Mem(
@@ -102,6 +116,7 @@ bool AXP_21264_Add_MAF_IO(
     int,
     bool);
 void AXP_21264_Add_MAF(AXP_21264_CPU *, AXP_CBOX_MAF_TYPE, u64, i8, int, bool);
+bool AXP_21264_Prefetch_MAF(AXP_21264_CPU *, u64);
 void AXP_21264_Free_MAF(AXP_21264_CPU *, u8);
 
 /*
@@ -128,7 +143,7 @@ void AXP_21264_Free_PQ(AXP_21264_CPU *, u8);
  * AXP_21264_Cbox_VDB.c
  */
 int AXP_21264_VDB_Empty(AXP_21264_CPU *);
-void AXP_21264_Process_VDB(AXP_21264_CPU *, int);
+bool AXP_21264_Process_VDB(AXP_21264_CPU *, int);
 u8 AXP_21264_Add_VDB(AXP_21264_CPU *, AXP_21264_VDB_TYPE, u64, u8 *, bool, bool);
 bool AXP_21264_IsSetP_VDB(AXP_21264_CPU *, u64);
 void AXP_21264_ClearP_VDB(AXP_21264_CPU *, u8);
@@ -57,6 +57,14 @@
  *  between the 2 emulations.  These definitions have to be maintained so that
  *  they are identical, except in name.  This way the CPU does not have to
  *  include all the System header files and the System the CPU header files.
+ *
+ *  V01.008 19-Oct-2026 Jonathan D. Belanger
+ *  Added the MAF hash chain, the requests waiting for a free MAF entry, and
+ *  the MAF statistics.
+ *
+ *  V01.009 19-Oct-2026 Jonathan D. Belanger
+ *  The MAF complete flag is now the sent flag, which is what it indicated.
+ *  Waiting I-stream requests are replaced, rather than requests dropped.
  */
 #ifndef _AXP_21264_CBOX_DEFS_
 #define _AXP_21264_CBOX_DEFS_
@@ -405,11 +413,41 @@ typedef struct
     int dataLen;
     int bufLen;
     bool valid;
-    bool complete; /* cleared by Mbox, set by Cbox */
+    bool sent;     /* set by the Cbox once sent to the System */
     bool shared;
     bool ioReq;
+    i8 hashNext;   /* next entry in the same hash bucket, or -1 */
 } AXP_21264_CBOX_MAF;
 
+/*
+ * A request to add an MAF entry that arrived while all the MAF entries were
+ * in use.  It waits here, in order, until one is freed.
+ */
+typedef struct
+{
+    AXP_CBOX_MAF_TYPE type;
+    u64 pa;
+    i8 lqSqEntry;
+    int dataLen;
+    bool shared;
+} AXP_21264_CBOX_MAF_WAIT;
+
+/*
+ * Counters kept on the use of the MAF.  The occupancy is the number of MAF
+ * entries in use when a new one is allocated, summed over all allocations,
+ * so that dividing it by the allocations gives the average occupancy.
+ */
+typedef struct
+{
+    u64 allocated;      /* MAF entries allocated                */
+    u64 merged;         /* requests merged into an existing one */
+    u64 fullStalls;     /* requests that had to wait for one    */
+    u64 occupancy;      /* sum of entries in use at allocation  */
+    u64 replaced;       /* waiting I-stream requests replaced   */
+    u32 inUse;          /* entries currently in use             */
+    u32 maxInUse;       /* most entries ever in use at once     */
+} AXP_21264_CBOX_MAF_STATS;
+
 /*
  * HRM 2.12
  * Each IOWB entry has the following:
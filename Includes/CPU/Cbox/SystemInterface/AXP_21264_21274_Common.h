@@ -34,6 +34,10 @@
  *
  *	V01.000		31-Mar-2018	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	The request queue entry now has the same layout as the System's skid
+ *	buffer, including the queue header, so the CPU can fill one in place.
  */
 #ifndef _AXP_21264_21274_COMMON_H_
 #define _AXP_21264_21274_COMMON_H_
@@ -149,6 +153,7 @@ typedef struct
  */
 typedef struct
 {
+    AXP_QUEUE_HDR header;
     u64 sysData[AXP_21264_DATA_SIZE];
     u64 mask;
     u64 pa;
@@ -163,7 +168,7 @@ typedef struct
     bool miss2;
     bool rqValid;
     bool cacheHit;
-    bool valid;
+    bool inUse;
 } AXP_21264_RQ_ENTRY;
 
 #define AXP_21264_CCHIP_RQ_LEN	6	/* Per CPU */
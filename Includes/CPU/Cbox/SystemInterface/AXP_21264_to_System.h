@@ -23,11 +23,24 @@
  *
  *	V01.000		01-Jun-2018	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	Added AXP_21264_SendToSystemBatch.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	The send functions now return whether, or how many, messages were sent.
+ *
+ *	V01.003		19-Oct-2026	Jonathan D. Belanger
+ *	Added AXP_21264_InterruptTaken.
  */
 #ifndef _AXP_21264_TO_SYSTEM_H_
 #define _AXP_21264_TO_SYSTEM_H_
 
-void AXP_21264_SendToSystem(AXP_21264_CPU *, AXP_21264_SYSBUS_System *);
+bool AXP_21264_SendToSystem(AXP_21264_CPU *, AXP_21264_SYSBUS_System *);
+u32 AXP_21264_SendToSystemBatch(AXP_21264_CPU *,
+                                AXP_21264_SYSBUS_System *,
+                                u32);
+void AXP_21264_InterruptTaken(AXP_21264_CPU *);
 
 
 #endif /* _AXP_21264_TO_SYSTEM_H_ */
@@ -26,6 +26,14 @@
  *
  *	V01.001		01-Jun-2017	Jonathan D. Belanger
  *	Added a function prototype to add an Icache line/block.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	Added the function prototypes to count branch predictions and to write
+ *	the branch trace file.
+ *
+ *	V01.003		19-Oct-2026	Jonathan D. Belanger
+ *	Added the function prototype to wake a CPU parked in an idle loop that
+ *	polls memory.
  */
 #ifndef _AXP_21264_IBOX_DEFS_
 #define _AXP_21264_IBOX_DEFS_
@@ -58,10 +66,15 @@ void AXP_Branch_Direction(
     bool taken,
     bool localTaken,
     bool globalTaken);
+void AXP_Branch_Count(AXP_BRANCH_STATS *, bool, bool, bool, bool);
+void AXP_Branch_TraceOpen(AXP_21264_CPU *);
+void AXP_Branch_Trace(AXP_21264_CPU *, AXP_PC, bool, AXP_PC);
+void AXP_Branch_TraceClose(AXP_21264_CPU *);
 void AXP_ReturnIQEntry(AXP_21264_CPU *, AXP_QUEUE_ENTRY *);
 void AXP_ReturnFQEntry(AXP_21264_CPU *, AXP_QUEUE_ENTRY *);
 void AXP_21264_Ibox_Event(AXP_21264_CPU *, u32, AXP_PC, u64, u8, u8, bool, bool);
 void AXP_21264_Ibox_UpdateIcache(AXP_21264_CPU *, u64, u8 *, bool);
+void AXP_21264_Ibox_Wake(AXP_21264_CPU *);
 bool AXP_21264_Ibox_Retire(AXP_21264_CPU *);
 void *AXP_21264_IboxMain(void *);
 
@@ -30,6 +30,10 @@
  *	Ebox, and Fbox did.  So, it is better located at the queue entry that goes
  *	on the IQ or FQ.  This also simplifies the mutex locking and avoids both
  *	potential deadlocks and multiple threads trying to execute an instruction.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	Added the retirement batch, so that physical registers freed while retiring
+ *	are returned to the free lists together and each box is signaled once.
  */
 #ifndef _AXP_IBOX_INS_DECODE_DEFS_
 #define _AXP_IBOX_INS_DECODE_DEFS_	1
@@ -38,13 +42,31 @@
 #define AXP_SIGNAL_EBOX	1
 #define AXP_SIGNAL_FBOX	2
 
+/*
+ * The physical registers freed while retiring a run of instructions are
+ * collected here and put back onto their free lists in one go by
+ * AXP_ReleaseRegisters.  A register can only be freed once while it is off
+ * the free list, so a batch never holds more registers than its free list.
+ * The signalWho field accumulates the AXP_SIGNAL_* bits for the boxes that
+ * need to be woken up once the batch is done.
+ */
+typedef struct
+{
+    u16 prFree[AXP_I_FREELIST_SIZE];
+    u16 pfFree[AXP_F_FREELIST_SIZE];
+    u32 prCount;
+    u32 pfCount;
+    u32 signalWho;
+} AXP_RETIRE_BATCH;
+
 void AXP_Decode_Rename(
     AXP_21264_CPU *,
     AXP_INS_LINE *,
     int,
     AXP_INSTRUCTION *,
     AXP_PIPELINE *);
-u32 AXP_UpdateRegisters(AXP_21264_CPU *, AXP_INSTRUCTION *);
+void AXP_UpdateRegisters(AXP_21264_CPU *, AXP_INSTRUCTION *, AXP_RETIRE_BATCH *);
+void AXP_ReleaseRegisters(AXP_21264_CPU *, AXP_RETIRE_BATCH *);
 bool AXP_AbortInstructions(AXP_21264_CPU *, AXP_INSTRUCTION *);
 void AXP_RegisterRename_IntegrityCheck(AXP_21264_CPU *);
 #endif	/* _AXP_IBOX_INS_DECODE_DEFS_ */
@@ -33,6 +33,9 @@
  *	Included the AXP_Base_CPU header file, which contains definitions common to
  *	all Alpha AXP CPUs.
  *
+ *	V01.003		19-Oct-2026	Jonathan D. Belanger
+ *	Added the branch prediction statistics and the branch trace file format.
+ *
  */
 #ifndef _AXP_21264_PRED_DEFS_
 #define _AXP_21264_PRED_DEFS_
@@ -172,4 +175,49 @@ typedef struct
 #define AXP_GLOBAL_PATH_TAKEN(gph)		(gph) = (((gph) * 2) + 1) & AXP_MASK_12_BITS
 #define AXP_GLOBAL_PATH_NOT_TAKEN(gph)	(gph) = ((gph) * 2) & AXP_MASK_12_BITS
 
+/*
+ * Branch prediction statistics.  These are kept for each branch retired, and
+ * show how often each of the predictors, and the chooser between them when
+ * they disagree, got the direction right.
+ */
+typedef struct
+{
+	u64 branches;		/* Branches retired */
+	u64 taken;			/* Branches taken */
+	u64 correct;		/* Branches predicted correctly */
+	u64 localCorrect;	/* Local predictor correct */
+	u64 globalCorrect;	/* Global predictor correct */
+	u64 disagree;		/* Local and global predictors disagreed */
+	u64 chooserCorrect;	/* ... and the chooser picked the correct one */
+} AXP_BRANCH_STATS;
+
+/*
+ * Branch trace file.  When the AXP_BRANCHFILE environment variable is set,
+ * each CPU writes every branch it retires to the file <AXP_BRANCHFILE>.<cpu>.
+ * The file is a header followed by one record per branch.  The record's PC
+ * has the PALmode bit in bit 0 and the taken bit in bit 1 (PCs are longword
+ * aligned, so bit 1 is otherwise always 0).  The target is 0 when the branch
+ * was not taken.  Records are written in the host's byte order.
+ */
+#define AXP_BRANCH_TRACE_ENV		"AXP_BRANCHFILE"
+#define AXP_BRANCH_TRACE_MAGIC		0x42505841	/* 'AXPB' */
+#define AXP_BRANCH_TRACE_VERSION	1
+#define AXP_BRANCH_TRACE_PAL		0x1
+#define AXP_BRANCH_TRACE_TAKEN		0x2
+#define AXP_BRANCH_TRACE_BUF_LEN	4096	/* records buffered before writing */
+
+typedef struct
+{
+	u32 magic;
+	u16 version;
+	u16 recordSize;
+	u64 cpuID;
+} AXP_BRANCH_TRACE_HDR;
+
+typedef struct
+{
+	u64 pc;
+	u64 target;
+} AXP_BRANCH_TRACE_REC;
+
 #endif /* _AXP_21264_PRED_DEFS_ */
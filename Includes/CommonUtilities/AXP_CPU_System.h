@@ -23,6 +23,10 @@
  *
  *	V01.000		14-MAY-2018	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	Added the NOP probe requests that set the next state to Dirty/Shared and
+ *	Invalid.
  */
 
 #ifndef AXP_CPU_SYSTEM_H_
@@ -34,6 +38,8 @@ typedef enum
     NOP_Clean,
     NOP_CleanShared,
     NOP_Transition3,
+    NOP_DirtyShared,
+    NOP_Invalid,
     NOP_Transition1 = 0x06,
     ReadHit_NOP = 0x08,
     ReadHit_Clean,
@@ -36,6 +36,19 @@
  *	V01.003		03-Feb-2018	Jonathan D. Belanger
  *	Continued to work on reading in the configuration file and loading it into
  *	a usable format.
+ *
+ *	V01.004		19-Oct-2026	Jonathan D. Belanger
+ *	Added the DiskCache node, used to size the host block cache used by the
+ *	virtual disks.
+ *
+ *	V01.005		19-Oct-2026	Jonathan D. Belanger
+ *	Added the VirtualTime value to the CPUs node.
+ *
+ *	V01.006		19-Oct-2026	Jonathan D. Belanger
+ *	Added the IcachePrefetch value to the CPUs node.
+ *
+ *	V01.007		19-Oct-2026	Jonathan D. Belanger
+ *	Added functions to return the configured networks.
  */
 #ifndef _AXP_CONFIGURE_DEFS_
 #define _AXP_CONFIGURE_DEFS_
@@ -69,6 +82,8 @@
  *				Generation			number
  *				Pass				number
  *				Name				string
+ *				VirtualTime			number
+ *				IcachePrefetch		number
  *			DARRAY
  *				Size				decimal
  *				Count				decimal
@@ -78,6 +93,10 @@
  *					Name			string
  *					Size			decimal(MB, GB)
  *					File			file-specification
+ *			DiskCache
+ *				Size				decimal(MB, GB)
+ *				DirtyLimit			decimal(MB, GB)
+ *				ReadAhead			number
  *			Console
  *				Port				number
  *			Networks
@@ -124,6 +143,7 @@ typedef enum
     CPUS,
     DARRAYS,
     Disks,
+    DiskCache,
     Console,
     Networks,
     Printers,
@@ -152,9 +172,16 @@ typedef enum
     NoCPUs,
     CPUCount,
     Generation,
-    MfgPass
+    MfgPass,
+    VirtualTime,
+    IcachePrefetch
 } AXP_21264_CONFIG_CPUS;
 
+/*
+ * The most Icache lines the Ibox can be configured to prefetch ahead.
+ */
+#define AXP_ICACHE_PREFETCH_MAX 8
+
 typedef enum
 {
     NoDARRAYs,
@@ -168,6 +195,14 @@ typedef enum
     DECDisk
 } AXP_21264_CONFIG_DISKS;
 
+typedef enum
+{
+    NoDiskCache,
+    DiskCacheSize,
+    DiskCacheDirty,
+    DiskCacheReadAhead
+} AXP_21264_CONFIG_DISKCACHE;
+
 typedef enum
 {
     NoDisk,
@@ -364,6 +399,8 @@ typedef struct
     AXP_CPU_CONFIG *config;
     u32 minorType;
     u32 count;
+    u32 virtualTime;
+    u32 iCachePrefetch;
 } AXP_21264_CPU_INFO;
 
 /*
@@ -415,6 +452,26 @@ typedef struct
     AXP_21264_DISK_TYPES type;
 } AXP_21264_DISK_INFO;
 
+/*
+ * The virtual disks share a host block cache.  The size is the total amount
+ * of host memory the cache can use, the dirty limit is the amount of that
+ * which can be waiting to be written to the disk files, and the read-ahead is
+ * the number of 4KB blocks read ahead when a disk is being read sequentially.
+ * The cache is used regardless of how the disk files were opened.
+ *
+ *		System
+ *			DiskCache
+ *				Size			decimal(MB, GB)
+ *				DirtyLimit		decimal(MB, GB)
+ *				ReadAhead		number
+ */
+typedef struct
+{
+    u64 size;
+    u64 dirtyMax;
+    u32 readAhead;
+} AXP_21264_DISKCACHE_INFO;
+
 /*
  * The ES40 has the potential for 2 consoles.  Not exactly sure why.  For now,
  * we are going to only have a single console.  This console will be
@@ -489,6 +546,7 @@ typedef struct
   AXP_21264_SROM_INFO srom;
   AXP_21264_CPU_INFO cpus;
   AXP_21264_DARRAY_INFO darrays;
+  AXP_21264_DISKCACHE_INFO diskCache;
   AXP_21264_CONSOLE_INFO console;
   u32 diskCount;
   u32 networkCount;
@@ -507,12 +565,17 @@ extern AXP_CPU_CONFIG AXP_CPU_Configurations[];
 int AXP_LoadConfig_File(char *);
 bool AXP_ConfigGet_CPUType(u32 *, u32 *);
 u32 AXP_ConfigGet_CPUCount(void);
+u32 AXP_ConfigGet_VirtualTime(void);
+u32 AXP_ConfigGet_IcachePrefetch(void);
 bool AXP_ConfigGet_InitFile(char *);
 bool AXP_ConfigGet_PALFile(char *);
 bool AXP_ConfigGet_ROMFile(char *);
 bool AXP_ConfigGet_NVRAMFile(char *);
 bool AXP_ConfigGet_CboxCSRFile(char *);
 void AXP_ConfigGet_DarrayInfo(u32 *, u64 *);
+void AXP_ConfigGet_DiskCacheInfo(u64 *, u64 *, u32 *);
+u32 AXP_ConfigGet_NetworkCount(void);
+bool AXP_ConfigGet_NetworkInfo(u32, char *, u32 *);
 void AXP_TraceConfig(void);
 
 #endif /* _AXP_CONFIGURE_DEFS_ */
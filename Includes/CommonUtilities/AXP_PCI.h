@@ -46,6 +46,10 @@
  *
  *	V01.000		19-May-2018	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	Added the PCI device structure, used to register a device model with the
+ *	Pchip for the bus it is on.
  */
 #ifndef _AXP_PCI_H_
 #define _AXP_PCI_H_
@@ -390,4 +394,37 @@ typedef struct
 #define AXP_PCI_VPD_RES_RW	0x91
 #define AXP_PCI_VPD_RES_END	0x78
 
+/*
+ * PCI Device
+ *
+ * A device model fills one of these in and registers it with the Pchip for
+ * the bus it is on.  The configuration space is maintained for the device,
+ * including the sizing and programming of the BARs.  Once a BAR has been
+ * programmed and its space enabled in the command register, accesses to it
+ * are passed to the device's read and write functions, with the BAR number,
+ * the offset into the BAR, and the length of the access (1, 2, 4, or 8).
+ */
+#define AXP_PCI_MAX_BARS	6
+#define AXP_PCI_MAX_SLOTS	6
+#define AXP_PCI_CFG_CMD		0x04
+#define AXP_PCI_CFG_BAR0	0x10
+#define AXP_PCI_CFG_BAR5	0x24
+#define AXP_PCI_CFG_INTLINE	0x3c
+#define AXP_PCI_NO_DEVICE	0xffffffffffffffffll
+
+typedef u64 (*AXP_PCI_READ)(void *, u32, u64, u32);
+typedef void (*AXP_PCI_WRITE)(void *, u32, u64, u64, u32);
+
+typedef struct
+{
+    AXP_PCI_CFG cfg;		/* Configuration space header */
+    u32 barSize[AXP_PCI_MAX_BARS];	/* Power of 2, 0 = not implemented */
+    AXP_PCI_READ read;
+    AXP_PCI_WRITE write;
+    void *ctx;			/* Passed to read and write */
+    void *bus;			/* The Pchip the device is registered with */
+    u32 slot;
+    u32 irq;			/* DRIR bit for the interrupt pin */
+} AXP_PCI_DEVICE;
+
 #endif /* _AXP_PCI_H_ */
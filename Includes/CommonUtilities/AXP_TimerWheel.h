@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This header contains the definitions for the event timer service, a
+ *  hierarchical timer wheel shared by all the emulated devices and serviced by
+ *  a single thread.
+ *
+ * Revision History:
+ *
+ *  V01.000	19-Oct-2026	Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added virtual time, where the clock is advanced by the instructions the
+ *  CPUs retire, and skipped ahead to the next timer when they are all idle.
+ */
+#ifndef _AXP_TIMER_WHEEL_H_
+#define _AXP_TIMER_WHEEL_H_
+#include "CommonUtilities/AXP_Utility.h"
+
+/*
+ * The wheel has 4 levels of 256 slots.  A tick is 2^15 nanoseconds (about
+ * 32.8us), so the first level covers about 8.4ms, the second 2.1 seconds,
+ * the third 9.2 minutes, and the fourth 39 hours.  Timers further out than
+ * that are put in the last slot and looked at again when it comes around.
+ * Expiry times are kept to the nanosecond, so periodic timers do not drift,
+ * even though they are only fired on a tick.
+ */
+#define AXP_TIMER_TICK_SHIFT	15
+#define AXP_TIMER_LEVELS	4
+#define AXP_TIMER_SLOT_BITS	8
+#define AXP_TIMER_SLOTS		(1 << AXP_TIMER_SLOT_BITS)
+#define AXP_TIMER_SLOT_MASK	(AXP_TIMER_SLOTS - 1)
+#define AXP_TIMER_NSEC		1000000000ll
+#define AXP_TIMER_TICK(ns)						      \
+    (((ns) + (1ll << AXP_TIMER_TICK_SHIFT) - 1) >> AXP_TIMER_TICK_SHIFT)
+
+/*
+ * The callback is called on the timer thread, with the number of times the
+ * timer expired since the callback was last called (more than 1 when ticks
+ * have been coalesced).  It may start and stop timers, but should not block.
+ */
+typedef void (*AXP_TIMER_CALLBACK)(void *, u32);
+
+/*
+ * An event timer.  A coalescing timer does not call its callback again until
+ * the last call has been acknowledged with AXP_TimerAck.  Expiries in the
+ * meantime are counted and passed to the next call.
+ */
+typedef struct _AXP_TIMER
+{
+    struct _AXP_TIMER *flink;
+    struct _AXP_TIMER *blink;
+    struct _AXP_TIMER **head;
+    struct _AXP_TIMER *due;
+    AXP_TIMER_CALLBACK callback;
+    void	*arg;
+    u64		expires;
+    u64		period;
+    u64		seq;
+    u32		count;
+    u32		missed;
+    bool	armed;
+    bool	coalesce;
+    bool	pending;
+} AXP_TIMER;
+
+/*
+ * Function prototypes.
+ */
+void AXP_TimerInit(AXP_TIMER *, AXP_TIMER_CALLBACK, void *, bool);
+void AXP_TimerStart(AXP_TIMER *, u64, u64);
+void AXP_TimerStop(AXP_TIMER *);
+void AXP_TimerAck(AXP_TIMER *);
+u64 AXP_TimerNow(void);
+time_t AXP_TimerTime(void);
+void AXP_TimerVirtual(u32, u32);
+void AXP_TimerRetire(u32);
+void AXP_TimerIdle(bool);
+
+#endif /* _AXP_TIMER_WHEEL_H_ */
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This header contains the definitions for the console serial ports, which
+ *  connect the emulated system's UARTs to the TELNET server.
+ *
+ * Revision History:
+ *
+ *  V01.000	19-Oct-2026	Jonathan D. Belanger
+ *  Initially written.
+ */
+#ifndef AXP_CONSOLE_H_
+#define AXP_CONSOLE_H_
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_Configure.h"
+
+/*
+ * The console ports are 16550 UARTs at the standard COM1 and COM2 addresses in
+ * PCI I/O space.  Each one has 8 registers.
+ */
+#define AXP_CONSOLE_PORTS	2
+#define AXP_CONSOLE_COM1	0x3f8
+#define AXP_CONSOLE_COM2	0x2f8
+#define AXP_CONSOLE_REGS	8
+
+/*
+ * UART register offsets (with the DLAB bit in LCR clear, except for DLL and
+ * DLM).
+ */
+#define AXP_UART_RBR		0	/* Receive Buffer (read) */
+#define AXP_UART_THR		0	/* Transmit Holding (write) */
+#define AXP_UART_DLL		0	/* Divisor Latch LSB (DLAB set) */
+#define AXP_UART_IER		1	/* Interrupt Enable */
+#define AXP_UART_DLM		1	/* Divisor Latch MSB (DLAB set) */
+#define AXP_UART_IIR		2	/* Interrupt Identification (read) */
+#define AXP_UART_FCR		2	/* FIFO Control (write) */
+#define AXP_UART_LCR		3	/* Line Control */
+#define AXP_UART_MCR		4	/* Modem Control */
+#define AXP_UART_LSR		5	/* Line Status */
+#define AXP_UART_MSR		6	/* Modem Status */
+#define AXP_UART_SCR		7	/* Scratch */
+
+/*
+ * UART register bits.
+ */
+#define AXP_UART_IER_RDA	0x01	/* Received data available */
+#define AXP_UART_IER_THRE	0x02	/* Transmit holding register empty */
+#define AXP_UART_IIR_NONE	0x01	/* No interrupt pending */
+#define AXP_UART_IIR_THRE	0x02
+#define AXP_UART_IIR_RDA	0x04
+#define AXP_UART_IIR_FIFO	0xc0	/* FIFOs enabled */
+#define AXP_UART_FCR_ENABLE	0x01
+#define AXP_UART_FCR_RCLR	0x02
+#define AXP_UART_LCR_DLAB	0x80
+#define AXP_UART_MCR_LOOP	0x10
+#define AXP_UART_LSR_DR		0x01	/* Data ready */
+#define AXP_UART_LSR_OE		0x02	/* Overrun error */
+#define AXP_UART_LSR_THRE	0x20
+#define AXP_UART_LSR_TEMT	0x40
+#define AXP_UART_MSR_READY	0xb0	/* DCD, DSR, and CTS */
+
+/*
+ * Each direction of a console port is a single producer, single consumer ring.
+ * The producer only ever writes the tail and the consumer only ever writes the
+ * head, so neither side needs a lock.  The length must be a power of 2.
+ */
+#define AXP_CONSOLE_RING_LEN	4096
+#define AXP_CONSOLE_RING_MASK	(AXP_CONSOLE_RING_LEN - 1)
+
+typedef struct
+{
+    u32 head;				/* Written by the consumer */
+    u8 res_1[60];			/* Keep head and tail in separate lines */
+    u32 tail;				/* Written by the producer */
+    u8 res_2[60];
+    u8 buf[AXP_CONSOLE_RING_LEN];
+} AXP_CONSOLE_RING;
+
+/*
+ * The console port.  The rx ring is filled by the TELNET server and emptied by
+ * the emulated system, and the tx ring the other way around.  The registers
+ * are only ever accessed by the emulated system.  The interrupt function is
+ * called with the port's interrupt line when it may have changed.
+ */
+typedef struct
+{
+    AXP_CONSOLE_RING rx;
+    AXP_CONSOLE_RING tx;
+    void (*interrupt)(void *, bool);
+    void *intArg;
+    bool txKick;
+    bool overrun;
+    bool thrInt;
+    u16 base;
+    u8 ier;
+    u8 fcr;
+    u8 lcr;
+    u8 mcr;
+    u8 scr;
+    u8 dll;
+    u8 dlm;
+} AXP_CONSOLE_PORT;
+
+/*
+ * Function prototypes.
+ */
+u32 AXP_Console_Put(AXP_CONSOLE_RING *, u8 *, u32);
+u32 AXP_Console_Get(AXP_CONSOLE_RING *, u8 *, u32);
+void AXP_Console_Init(void (*)(void *, bool), void *);
+AXP_CONSOLE_PORT *AXP_Console_Port(u32);
+u8 AXP_Console_ReadPort(AXP_CONSOLE_PORT *, u32);
+void AXP_Console_WritePort(AXP_CONSOLE_PORT *, u32, u8);
+void AXP_Console_Input(u8 *, u32);
+u32 AXP_Console_Output(u8 *, u32);
+
+#endif /* AXP_CONSOLE_H_ */
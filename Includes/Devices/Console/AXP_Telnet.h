@@ -22,6 +22,16 @@
  *
  *  V01.000	16-Jun-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added the definitions for a server that supports more than one session at
+ *  a time, with the output for each session buffered.
+ *
+ *  V01.002	19-Oct-2026	Jonathan D. Belanger
+ *  Added the definitions used to decide when queued output is sent.
+ *
+ *  V01.003	19-Oct-2026	Jonathan D. Belanger
+ *  Added the prototypes used by the console ports to hand over their output.
  */
 #ifndef AXP_TELNET_H_
 #define AXP_TELNET_H_
@@ -39,6 +49,8 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 /*
  * Definitions used in the source file.
@@ -46,6 +58,31 @@
 #define AXP_TELNET_MSG_LEN	1024
 #define AXP_TELNET_DEFAULT_PORT	108
 
+/*
+ * Definitions for the sessions.  One session at a time is allowed to send
+ * input to the console, the others are read-only mirrors of the output.  The
+ * output for each session is queued, and when more than the high-water mark is
+ * queued, we stop reading from that client until the queue drains below the
+ * low-water mark.
+ */
+#define AXP_TELNET_MAX_SESSIONS	8
+#define AXP_TELNET_OUT_LEN	(64 * 1024)
+#define AXP_TELNET_OUT_HIGH	((AXP_TELNET_OUT_LEN * 3) / 4)
+#define AXP_TELNET_OUT_LOW	(AXP_TELNET_OUT_LEN / 4)
+#define AXP_TELNET_RCV_BURST	16
+
+/*
+ * Output is queued and sent in batches.  It is sent as soon as a batch's worth
+ * is queued, a line or what looks like a prompt is completed, or the first
+ * byte queued has waited the flush delay, whichever comes first.  A prompt is
+ * one of the characters below followed by a space.
+ */
+#define AXP_TELNET_FLUSH_LEN	4096
+#define AXP_TELNET_FLUSH_NSEC	2000000ll
+#define AXP_TELNET_PROMPT(c)	\
+    (((c) == '>') || ((c) == '$') || ((c) == '#') || ((c) == ':') || \
+     ((c) == '?'))
+
 /*
  * Define the states for the TELNET session.
  */
@@ -170,6 +207,32 @@ typedef struct
     int				mySocket;
     u8				rcvState;
 
+    /*
+     * These fields are used by the server to keep track of the session.
+     * Before any data has been received, the session is in the Accept state.
+     */
+    AXP_Telnet_Session_State	state;
+    bool			readOnly;
+    u32				slot;
+    u32				events;
+
+    /*
+     * Output is queued in this ring buffer and sent as the socket can take
+     * it.  Output that does not fit is dropped and counted.
+     */
+    u8				outBuf[AXP_TELNET_OUT_LEN];
+    u32				outHead;
+    u32				outLen;
+    u64				outDropped;
+
+    /*
+     * When output has been queued, but not yet sent, this is the time, from
+     * the monotonic clock, by which it is to be sent.  When the socket would
+     * not take all the output, we wait for it to become writable.
+     */
+    u64				flushAt;
+    bool			outBlocked;
+
     /*
      * These are the state objects.  They are used with the appropriate
      * State Machine
@@ -199,7 +262,15 @@ typedef struct
  * Function prototypes.
  */
 bool AXP_Telnet_Send(AXP_TELNET_SESSION *, u8 *, int);
+void AXP_Telnet_Output(u8 *, u32);
+void AXP_Telnet_Push(void);
+void AXP_Telnet_SetInput(void (*)(u8 *, u32));
+void AXP_Telnet_SetOutput(u32 (*)(u8 *, u32));
+void AXP_Telnet_Kick(void);
 void AXP_Telnet_Main(void);
+void AXP_Telnet_Server(u16, bool);
+void AXP_Telnet_Shutdown(void);
+u16 AXP_Telnet_Port(void);
 void get_State_Machines(AXP_StateMachine ***, AXP_StateMachine ***);
 
 #endif /* AXP_TELNET_H_ */
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This header contains the definitions for the DEC 21143 PCI/CardBus 10/100
+ *  Mb/s Ethernet LAN Controller (Tulip).  The register and descriptor layouts
+ *  are taken from the 21143 Hardware Reference Manual.
+ *
+ * Revision History:
+ *
+ *  V01.000	19-Oct-2026	Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  The 21143 is now a PCI device, DMAing through the bus it is on, rather
+ *  than directly to and from guest physical memory.
+ */
+#ifndef _AXP_21143_H_
+#define _AXP_21143_H_
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_PCI.h"
+#include "Devices/Ethernet/AXP_Ethernet.h"
+
+/*
+ * PCI configuration space.  The 21143 has a 128 byte I/O space BAR (CBIO) and
+ * a 1KB memory space BAR (CBMA), both of which map the CSRs.
+ */
+#define AXP_21143_VENDOR	0x1011
+#define AXP_21143_DEVICE	0x0019
+#define AXP_21143_REVISION	0x41
+#define AXP_21143_CLASS		0x020000	/* Ethernet controller */
+#define AXP_21143_CFG_REGS	17
+#define AXP_21143_IO_SIZE	128
+#define AXP_21143_MEM_SIZE	1024
+
+#define AXP_21143_CFID		0x00	/* Identification */
+#define AXP_21143_CFCS		0x04	/* Command and Status */
+#define AXP_21143_CFRV		0x08	/* Revision */
+#define AXP_21143_CFLT		0x0c	/* Latency Timer */
+#define AXP_21143_CBIO		0x10	/* Base I/O Address */
+#define AXP_21143_CBMA		0x14	/* Base Memory Address */
+#define AXP_21143_CSID		0x2c	/* Subsystem ID */
+#define AXP_21143_CBER		0x30	/* Expansion ROM Base Address */
+#define AXP_21143_CFIT		0x3c	/* Interrupt */
+#define AXP_21143_CFDD		0x40	/* Device and Driver Area */
+
+/*
+ * The CSRs are 32 bits wide, aligned on quadword boundaries in both the I/O
+ * and memory spaces.
+ */
+#define AXP_21143_CSRS		16
+#define AXP_21143_CSR_SHIFT	3
+
+#define AXP_21143_CSR0		0	/* Bus Mode */
+#define AXP_21143_CSR1		1	/* Transmit Poll Demand */
+#define AXP_21143_CSR2		2	/* Receive Poll Demand */
+#define AXP_21143_CSR3		3	/* Receive List Base Address */
+#define AXP_21143_CSR4		4	/* Transmit List Base Address */
+#define AXP_21143_CSR5		5	/* Status */
+#define AXP_21143_CSR6		6	/* Operation Mode */
+#define AXP_21143_CSR7		7	/* Interrupt Enable */
+#define AXP_21143_CSR8		8	/* Missed Frames and Overflow Counter */
+#define AXP_21143_CSR9		9	/* Boot ROM, Serial ROM, and MII */
+#define AXP_21143_CSR10		10	/* Boot ROM Programming Address */
+#define AXP_21143_CSR11		11	/* General-Purpose Timer and */
+					/* Interrupt Mitigation Control */
+#define AXP_21143_CSR12		12	/* SIA Status */
+#define AXP_21143_CSR13		13	/* SIA Connectivity */
+#define AXP_21143_CSR14		14	/* SIA Transmit and Receive */
+#define AXP_21143_CSR15		15	/* SIA and General-Purpose Port */
+
+/*
+ * CSR0 - Bus Mode
+ */
+#define AXP_21143_CSR0_SWR	0x00000001	/* Software Reset */
+#define AXP_21143_CSR0_DSL	0x0000007c	/* Descriptor Skip Length */
+#define AXP_21143_CSR0_DSL_SHIFT 2
+
+/*
+ * CSR5 - Status, and CSR7 - Interrupt Enable.  Bits 16 through 0 are cleared
+ * by writing a 1 to them.
+ */
+#define AXP_21143_TI		0x00000001	/* Transmit Interrupt */
+#define AXP_21143_TPS		0x00000002	/* Transmit Process Stopped */
+#define AXP_21143_TU		0x00000004	/* Transmit Buffer Unavailable */
+#define AXP_21143_UNF		0x00000020	/* Transmit Underflow */
+#define AXP_21143_RI		0x00000040	/* Receive Interrupt */
+#define AXP_21143_RU		0x00000080	/* Receive Buffer Unavailable */
+#define AXP_21143_RPS		0x00000100	/* Receive Process Stopped */
+#define AXP_21143_GTE		0x00000800	/* General-Purpose Timer Expired */
+#define AXP_21143_FBE		0x00002000	/* Fatal Bus Error */
+#define AXP_21143_AIS		0x00008000	/* Abnormal Interrupt Summary */
+#define AXP_21143_NIS		0x00010000	/* Normal Interrupt Summary */
+#define AXP_21143_W1C		0x0001ffff
+#define AXP_21143_NORMAL	(AXP_21143_TI | AXP_21143_TU | AXP_21143_RI)
+#define AXP_21143_ABNORMAL	(AXP_21143_TPS | AXP_21143_UNF |	      \
+				 AXP_21143_RU | AXP_21143_RPS |		      \
+				 AXP_21143_GTE | AXP_21143_FBE)
+#define AXP_21143_RS_SHIFT	17		/* Receive Process State */
+#define AXP_21143_TS_SHIFT	20		/* Transmit Process State */
+#define AXP_21143_STATE_MASK	0x7
+
+/*
+ * The receive and transmit process states, as reported in CSR5.
+ */
+#define AXP_21143_STOPPED	0
+#define AXP_21143_RUNNING	3	/* Waiting for a frame */
+#define AXP_21143_SUSPENDED	4	/* Receive, no descriptor */
+#define AXP_21143_TX_SUSPENDED	6	/* Transmit, no descriptor */
+
+/*
+ * CSR6 - Operation Mode
+ */
+#define AXP_21143_SR		0x00000002	/* Start/Stop Receive */
+#define AXP_21143_PR		0x00000040	/* Promiscuous Mode */
+#define AXP_21143_PM		0x00000080	/* Pass All Multicast */
+#define AXP_21143_ST		0x00002000	/* Start/Stop Transmission */
+
+/*
+ * CSR11 - General-Purpose Timer and Interrupt Mitigation Control.  The
+ * receive and transmit interrupts are held back until either the number of
+ * frames or the timer, which starts with the first frame, runs out.  The
+ * timers count in units of 16 cycles, and the general-purpose timer in single
+ * cycles.  A cycle is 81.92us, or 5.12us with the cycle size bit set.  Zero
+ * in both fields turns mitigation off for that direction.
+ */
+#define AXP_21143_CS		0x80000000	/* Cycle Size */
+#define AXP_21143_TT_SHIFT	27		/* Transmit Timer */
+#define AXP_21143_NTP_SHIFT	24		/* Number of Transmit Packets */
+#define AXP_21143_RT_SHIFT	20		/* Receive Timer */
+#define AXP_21143_NRP_SHIFT	17		/* Number of Receive Packets */
+#define AXP_21143_CON		0x00010000	/* Continuous Mode */
+#define AXP_21143_TIMER		0x0000ffff	/* Timer Value */
+#define AXP_21143_CYCLE_NS	81920
+#define AXP_21143_CYCLE_CS_NS	5120
+#define AXP_21143_NSEC		1000000000
+#define AXP_21143_TX_RETRY	1000000		/* Wait for frame buffers */
+
+/*
+ * Descriptors are 4 longwords.  The 2nd is the control longword and the 3rd
+ * and 4th are the buffer addresses, the 4th being the address of the next
+ * descriptor when the descriptors are chained.
+ */
+#define AXP_21143_DESC_LEN	16
+#define AXP_21143_OWN		0x80000000	/* Owned by the 21143 */
+#define AXP_21143_ES		0x00008000	/* Error Summary */
+#define AXP_21143_ER		0x02000000	/* End of Ring */
+#define AXP_21143_CH		0x01000000	/* Second Address Chained */
+#define AXP_21143_BS2_SHIFT	11
+#define AXP_21143_BS_MASK	0x7ff
+
+/*
+ * RDES0 status, and transmit-only bits in TDES1.
+ */
+#define AXP_21143_RDES0_FL_SHIFT 16		/* Frame Length */
+#define AXP_21143_RDES0_DE	0x00004000	/* Descriptor Error */
+#define AXP_21143_RDES0_MF	0x00000400	/* Multicast Frame */
+#define AXP_21143_RDES0_FS	0x00000200	/* First Descriptor */
+#define AXP_21143_RDES0_LS	0x00000100	/* Last Descriptor */
+#define AXP_21143_RDES0_FT	0x00000020	/* Frame Type */
+#define AXP_21143_TDES1_IC	0x80000000	/* Interrupt on Completion */
+#define AXP_21143_TDES1_LS	0x40000000	/* Last Segment */
+#define AXP_21143_TDES1_FS	0x20000000	/* First Segment */
+#define AXP_21143_TDES1_SET	0x08000000	/* Setup Packet */
+#define AXP_21143_TDES1_DPD	0x00800000	/* Disabled Padding */
+#define AXP_21143_TDES1_HP	0x00400000	/* Hash/Perfect Filtering */
+
+/*
+ * The setup frame loads the address filter, either with 16 addresses, or with
+ * a 512 bit multicast hash table and 1 address.  Each 16 bits of the setup
+ * frame is in the low order 16 bits of a longword.
+ */
+#define AXP_21143_SETUP_LEN	192
+#define AXP_21143_PERFECT	16
+#define AXP_21143_HASH_BITS	512
+#define AXP_21143_HASH_ADDR	39		/* Longword of the hash address */
+
+#define AXP_21143_MIN_FRAME	60
+#define AXP_21143_CRC_LEN	4
+
+/*
+ * The most descriptors processed in one direction before the other direction
+ * gets a turn, and interrupts are looked at.
+ */
+#define AXP_21143_BATCH		64
+
+/*
+ * The 21143 device.  The CSRs are read and written by the CPU, and the
+ * descriptor rings are processed by a thread of its own, which DMAs through
+ * the PCI bus it is on.  Everything is protected by the mutex, except the
+ * interrupt line, which is only changed by whoever holds the mutex but is
+ * signalled to the system outside of it.  The mutex is not held during a
+ * DMA, so that the bus can get to the CSRs while it is doing the DMA.  If the
+ * rings are reset, moved, or stopped in the meantime, gen is changed and the
+ * thread gives up on the descriptor it was processing.
+ */
+typedef struct
+{
+    pthread_t	thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool	running;
+    bool	work;
+    bool	irq;
+    bool	signalled;
+    AXP_Ethernet_Handle *eth;
+    AXP_PCI_DEVICE pci;
+    bool	(*dma)(void *, u64, u8 *, u32, bool);
+    void	*dmaArg;
+    void	(*interrupt)(void *, bool);
+    void	*intArg;
+
+    /*
+     * Registers.
+     */
+    u32		cfg[AXP_21143_CFG_REGS];
+    u32		csr[AXP_21143_CSRS];
+    u32		mitigation;
+
+    /*
+     * Receive and transmit processes.
+     */
+    u32		rxState;
+    u32		txState;
+    u64		rxDesc;
+    u64		txDesc;
+    AXP_ETH_FRAME *rxFrame;
+    AXP_ETH_FRAME *txFrame;
+    bool	txWait;
+    bool	rxPoll;		/* Poll demands while a descriptor */
+    bool	txPoll;		/* was being read */
+    bool	flush;		/* Reset, frames to be given back */
+    u32		gen;
+    u32		dmaGen;		/* gen when the batch was started */
+
+    /*
+     * Interrupt mitigation.  Frames completed, whose interrupt is being held
+     * back, and when the timers run out (0 when not running).
+     */
+    u32		rxCount;
+    u32		txCount;
+    u64		rxTimer;
+    u64		txTimer;
+    u64		gpTimer;
+
+    /*
+     * Address filter, loaded by a setup frame.
+     */
+    u8		perfect[AXP_21143_PERFECT][AXP_MAC_ADDR_LEN];
+    u8		hash[AXP_21143_HASH_BITS / 8];
+    bool	hashFilter;
+
+    /*
+     * Counters.
+     */
+    u32		missed;
+    u64		rxFrames;
+    u64		txFrames;
+    u64		interrupts;
+} AXP_21143;
+
+/*
+ * Function prototypes.
+ */
+AXP_21143 *AXP_21143_Init(char *,
+                          u8,
+                          bool (*)(void *, u64, u8 *, u32, bool),
+                          void *,
+                          void (*)(void *, bool),
+                          void *,
+                          u32);
+void AXP_21143_Close(AXP_21143 *);
+u32 AXP_21143_ReadConfig(AXP_21143 *, u32);
+void AXP_21143_WriteConfig(AXP_21143 *, u32, u32);
+u32 AXP_21143_ReadCSR(AXP_21143 *, u32);
+void AXP_21143_WriteCSR(AXP_21143 *, u32, u32);
+
+#endif /* _AXP_21143_H_ */
@@ -24,24 +24,129 @@
  *
  *  V01.000	28-Jul-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added the packet socket, TAP, and loopback pair backends, and the receive
+ *  and transmit queues through which a NIC model exchanges frames with them.
+ *
+ *  V01.002	19-Oct-2026	Jonathan D. Belanger
+ *  Added a callback to tell the NIC model that frames have been received.
  */
 #ifndef _AXP_ETHERNET_H_
 #define _AXP_ETHERNET_H_
 #define HAVE_REMOTE	1
 #include <pcap.h>
 
-#define AXP_ETH_READ_TIMEOUT	1000
+#define AXP_ETH_READ_TIMEOUT	10
 #define AXP_MAC_ADDR_LEN	6
 
 /*
- * Ethernet handle.  Ethernet packets will be sent and received through this
- * handle.
+ * The backend used for a device is selected by a prefix on its name.  A name
+ * without a prefix is opened with pcap.
+ *
+ *	packet:<interface>	An AF_PACKET socket with a TPACKET_V3 receive ring
+ *	tap:<interface>		A TAP device
+ *	pair:<n>		One end of an in-process loopback pair, for testing
  */
+typedef enum
+{
+    AXP_ETH_PCAP,
+    AXP_ETH_PACKET,
+    AXP_ETH_TAP,
+    AXP_ETH_PAIR
+} AXP_ETH_BACKEND;
+
+#define AXP_ETH_PACKET_PREFIX	"packet:"
+#define AXP_ETH_TAP_PREFIX	"tap:"
+#define AXP_ETH_PAIR_PREFIX	"pair:"
+#define AXP_ETH_PAIRS		8
+#define AXP_ETH_HELD_TIMEOUT	1
+
+/*
+ * Frames are received into, and transmitted from, a pool of frame buffers
+ * belonging to the handle.  Half are for receiving and half for transmitting.
+ */
+#define AXP_ETH_FRAME_LEN	2048
+#define AXP_ETH_FRAMES		256
+#define AXP_ETH_BATCH		32
+
 typedef struct
+{
+    u32		len;
+    u32		res;
+    u8		data[AXP_ETH_FRAME_LEN];
+} AXP_ETH_FRAME;
+
+/*
+ * The frame buffers move between the NIC model and the backend through single
+ * producer, single consumer queues of frame pointers, so frames are neither
+ * copied nor locked on the way.  The producer only writes the tail and the
+ * consumer only writes the head.  The length must be a power of 2 greater
+ * than the number of frames that can be queued.
+ *
+ *	Queue		Producer	Consumer
+ *	-------		--------	--------
+ *	rxReady		backend		NIC model	Received frames
+ *	rxFree		NIC model	backend		Buffers to receive into
+ *	txReady		NIC model	backend		Frames to be transmitted
+ *	txFree		backend		NIC model	Buffers to transmit from
+ */
+#define AXP_ETH_QUEUE_LEN	(AXP_ETH_FRAMES * 2)
+#define AXP_ETH_QUEUE_MASK	(AXP_ETH_QUEUE_LEN - 1)
+
+typedef struct
+{
+    u32		head;
+    u8		res_1[60];
+    u32		tail;
+    u8		res_2[60];
+    AXP_ETH_FRAME *frame[AXP_ETH_QUEUE_LEN];
+} AXP_ETH_QUEUE;
+
+/*
+ * The TPACKET_V3 receive ring geometry.
+ */
+#define AXP_ETH_BLOCK_SIZE	(128 * 1024)
+#define AXP_ETH_BLOCKS		16
+#define AXP_ETH_BLOCK_TMO	10
+
+/*
+ * Ethernet handle.  Ethernet packets will be sent and received through this
+ * handle.  The backend is serviced by a thread of its own, which is woken up
+ * when there are frames to be transmitted.  The two ends of a loopback pair
+ * are serviced by the same thread.
+ */
+typedef struct _AXP_Ethernet_Handle
 {
     pcap_t	*handle;
     char	errorBuf[PCAP_ERRBUF_SIZE];
     u8		macAddr[AXP_MAC_ADDR_LEN];
+    AXP_ETH_BACKEND backend;
+    int		fd;
+    int		wake;
+    u8		*ring;
+    size_t	ringSize;
+    u32		block;
+    pthread_t	thread;
+    bool	ownThread;
+    bool	running;
+    bool	txKick;
+    u32		pairIdx;
+    struct _AXP_Ethernet_Handle *peer;
+    AXP_ETH_FRAME *frames;
+    AXP_ETH_FRAME *spare;
+    AXP_ETH_FRAME *held;
+    AXP_ETH_QUEUE rxReady;
+    AXP_ETH_QUEUE rxFree;
+    AXP_ETH_QUEUE txReady;
+    AXP_ETH_QUEUE txFree;
+    void	(*rxNotify)(void *);
+    void	*rxArg;
+    u64		rxNotified;
+    u64		rxFrames;
+    u64		rxDropped;
+    u64		txFrames;
+    u64		txDropped;
 } AXP_Ethernet_Handle;
 
 /*
@@ -49,6 +154,11 @@ typedef struct
  */
 AXP_Ethernet_Handle *AXP_EthernetOpen(char *, u8);
 void AXP_EthernetClose(AXP_Ethernet_Handle *);
+AXP_ETH_FRAME *AXP_EthernetRxGet(AXP_Ethernet_Handle *);
+void AXP_EthernetRxPut(AXP_Ethernet_Handle *, AXP_ETH_FRAME *);
+AXP_ETH_FRAME *AXP_EthernetTxGet(AXP_Ethernet_Handle *);
+void AXP_EthernetTxPut(AXP_Ethernet_Handle *, AXP_ETH_FRAME *);
+void AXP_EthernetNotify(AXP_Ethernet_Handle *, void (*)(void *), void *);
 
 
 #endif /* _AXP_ETHERNET_H_ */
@@ -27,6 +27,10 @@
  *
  *  V01.000	15-Jul-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added the read and write sector prototypes and the fields to maintain a
+ *  memory mapping of the device or file.
  */
 #ifndef AXP_RAW_H_
 #define AXP_RAW_H_
@@ -82,8 +86,17 @@ typedef struct
     u32			cylinders;
     u32			heads;
     u32			sectors;
+
+    /*
+     * When opened with OPEN_MAPPED_IO, this is where the device or file has
+     * been mapped into our address space.
+     */
+    u8			*mapAddr;
+    u64			mapLength;
 } AXP_RAW_Handle;
 
 u32 _AXP_RAW_Open(char *, AXP_VHD_OPEN_FLAG, u32, AXP_VHD_HANDLE *);
+u32 _AXP_RAW_ReadSectors(AXP_VHD_HANDLE, u64, u32 *, u8 *);
+u32 _AXP_RAW_WriteSectors(AXP_VHD_HANDLE, u64, u32 *, u8 *);
 
 #endif /* AXP_RAW_H_ */
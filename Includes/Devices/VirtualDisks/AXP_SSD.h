@@ -23,6 +23,11 @@
  *
  *  V01.000	05-Aug-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  The SSD is no longer read into allocated memory.  The backing store file
+ *  is mapped into memory, pages written to are tracked, and only those pages
+ *  are flushed back to the file, either periodically or on close.
  */
 #ifndef AXP_SSD_H_
 #define AXP_SSD_H_
@@ -34,6 +39,12 @@
 #define AXP_SSD_SIG1	0x424a707861434544ll
 #define AXP_SSD_SIG2	0x4445436178704a42ll
 
+/*
+ * This is the number of seconds between each flush of the modified pages back
+ * to the backing store file.
+ */
+#define AXP_SSD_FLUSH_SECS	5
+
 typedef struct
 {
     u64		ID1;
@@ -63,12 +74,35 @@ typedef struct
      */
     FILE	*fp;
 
+    /*
+     * This is the backing store file mapped into memory.  The mapping starts
+     * with the header, so that the mapping is page aligned in the file.
+     */
+    u8		*mapAddr;
+    u64		mapLength;
+
     /*
      * This is the actual solid state drive.  This is exactly the size of the
-     * disk (there is no header or trailer information.
+     * disk (there is no header or trailer information.  It points into the
+     * mapping, just past the header.
      */
     u8		*memory;
 
+    /*
+     * This is a bitmap, one bit per page of the mapping, indicating the pages
+     * that have been written to since they were last flushed to the backing
+     * store file.  The flush thread periodically writes back just these
+     * pages.
+     */
+    pthread_mutex_t	dirtyMutex;
+    u64		*dirtyMap;
+    u64		dirtyPages;
+    u32		pageSize;
+    pthread_t	flushThread;
+    pthread_cond_t	flushCond;
+    bool	flushStarted;
+    bool	flushStop;
+
     /*
      * These are things read from (or written to) the backing store file that
      * are used while accessing the contents.
@@ -87,5 +121,9 @@ typedef struct
  */
 u32 _AXP_SSD_Create(char *,AXP_VHD_CREATE_FLAG, u64, u32, u32, u32, AXP_VHD_HANDLE *);
 u32 _AXP_SSD_Open(char *, AXP_VHD_OPEN_FLAG, u32, AXP_VHD_HANDLE *);
+u32 _AXP_SSD_ReadSectors(AXP_VHD_HANDLE, u64, u32 *, u8 *);
+u32 _AXP_SSD_WriteSectors(AXP_VHD_HANDLE, u64, u32 *, u8 *);
+u32 _AXP_SSD_Flush(AXP_VHD_HANDLE);
+void _AXP_SSD_Close(AXP_VHD_HANDLE);
 
 #endif /* AXP_SSD_H_ */
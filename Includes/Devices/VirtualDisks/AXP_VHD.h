@@ -23,6 +23,11 @@
  *
  *  V01.000	08-Jul-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Corrected the Parent Locator Entry and Dynamic Disk Header layouts to be
+ *  the sizes in the specification, and added the definitions needed for
+ *  differencing disks and snapshot overlays.
  */
 #ifndef _AXP_VHD_H_
 #define _AXP_VHD_H_
@@ -107,13 +112,14 @@ typedef struct
  */
 #define AXP_VHD_DYNAMIC_RES_LEN	256
 #define AXP_VHD_PARENT_LOC_CNT	8
+#define AXP_VHD_PARENT_NAME_LEN	256
 typedef struct
 {
     u32 code;
     u32 dataSpace;  /* in sectors */
     u32 dataLen;    /* in bytes */
     u32 res_1;
-    u32 dataOff;
+    u64 dataOff;
 } AXP_VHD_ParentLoc;
 
 #define AXP_VHD_PCODE_NONE	0x00000000l
@@ -136,7 +142,7 @@ typedef struct
     AXP_VHDX_GUID parentGuid;
     u32 parentTimestamp;
     u32 res_1;
-    uint16_t parentName;
+    uint16_t parentName[AXP_VHD_PARENT_NAME_LEN];
     AXP_VHD_ParentLoc parentLoc[AXP_VHD_PARENT_LOC_CNT];
     u8 res_2[AXP_VHD_DYNAMIC_RES_LEN];
 } AXP_VHD_Dynamic;
@@ -164,6 +170,17 @@ typedef struct
 typedef u32 AXP_VHD_BAT_ENT;
 #define AXP_VHD_BAT_UNUSED	0xffffffffl
 
+/*
+ * Each data block in a dynamic or differencing disk is preceded by a sector
+ * bitmap, with one bit per sector in the block, padded to a sector boundary.
+ * In a differencing disk, a set bit indicates that the sector is in this
+ * file, and a clear bit that it is to be read from the parent.  We always
+ * copy a whole block from the parent the first time the block is written, so
+ * the blocks we allocate always have every bit set.
+ */
+#define AXP_VHD_BITMAP_SECTS(blkSize, sectorSize)                           \
+    (((((blkSize) / (sectorSize)) + 7) / 8 + (sectorSize) - 1) / (sectorSize))
+
 /*
  * Function Prototypes
  */
@@ -178,6 +195,7 @@ u32 _AXP_VHD_Create(char *,
                     AXP_VHD_HANDLE *);
 u32 _AXP_VHD_Open(char *, AXP_VHD_OPEN_FLAG, u32, AXP_VHD_HANDLE *);
 u32 _AXP_VHD_ReadSectors(AXP_VHD_HANDLE, u64, size_t *, u8 *);
-u32 _AXP_VHD_WritreSectors(AXP_VHD_HANDLE, u64, u32 *, u8 *);
+u32 _AXP_VHD_WriteSectors(AXP_VHD_HANDLE, u64, u32 *, u8 *);
+u32 _AXP_VHD_CreateOverlay(AXP_VHD_HANDLE, char *, AXP_VHD_HANDLE *);
 
 #endif /* _AXP_VHD_H_ */
@@ -23,6 +23,12 @@
  *
  *  V01.000 03-Jul-2018 Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Added the fields to maintain a memory mapping of a fixed VHD image.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added the fields to maintain the parent chain of a differencing VHD.
  */
 #ifndef _AXP_VHDX_H_
 #define _AXP_VHDX_H_
@@ -298,6 +304,34 @@ typedef struct
     u32 cylinders;
     u32 heads;
     u32 sectors;
+
+    /*
+     * When opened with OPEN_MAPPED_IO, and the layout of the file is a linear
+     * mapping of LBA to file offset (fixed VHD), this is where the image has
+     * been mapped into our address space.
+     */
+    u8 *mapAddr;
+    u64 mapLength;
+
+    /*
+     * For a dynamic or differencing VHD, this is the offset of the footer at
+     * the end of the file.  New data blocks are written here, and the footer
+     * moved after them.
+     */
+    u64 footerOffset;
+
+    /*
+     * For a differencing VHD, this is the handle for the parent disk.  If we
+     * opened the parent, because it was in the parent locator, then we close
+     * it when this disk is closed.  If the parent was supplied to us, when a
+     * snapshot overlay was created on top of it, then it belongs to the
+     * caller.  The resolved array has an entry for each block on the disk,
+     * and caches which disk in the parent chain holds that block (see
+     * _AXP_VHD_ResolveBlock).
+     */
+    void *parent;
+    bool parentOwned;
+    void **resolved;
 } AXP_VHDX_Handle;
 
 /*
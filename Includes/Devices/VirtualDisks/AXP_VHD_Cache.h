@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This header file contains the definitions needed by the host block cache.
+ *  The block cache sits between the AXP_VHD_ReadSectors/AXP_VHD_WriteSectors
+ *  functions and the format specific read and write functions.  It is shared
+ *  by all the virtual disks in the system, and its size is set in the system
+ *  configuration.
+ *
+ * Revision History:
+ *
+ *  V01.000	19-Oct-2026	Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added the window within which a read still continues a sequential stream,
+ *  and a count of the writes to a disk, so that a miss can tell whether what
+ *  it read is still current.
+ *
+ *  V01.002	19-Oct-2026	Jonathan D. Belanger
+ *  The count of writes is now kept for each shard, and only counts the blocks
+ *  written back to their disks.  Entries can be in use with their shard
+ *  unlocked, while they are being filled or written back.
+ */
+#ifndef _AXP_VHD_CACHE_H_
+#define _AXP_VHD_CACHE_H_
+#include "Devices/VirtualDisks/AXP_VirtualDisk.h"
+#include "CommonUtilities/AXP_Utility.h"
+
+/*
+ * The cache is made up of fixed sized blocks.  All the supported sector sizes
+ * divide evenly into a cache block.  The cache is split up into a number of
+ * shards, each with its own lock, hash table, and LRU list, so that accesses
+ * to different blocks do not contend on a single lock.  The maximum number of
+ * disks is the number of virtual disks that can be attached to the cache at
+ * one time.
+ */
+#define AXP_VHD_CACHE_BLK_SIZE		FOUR_K
+#define AXP_VHD_CACHE_SHARDS		16
+#define AXP_VHD_CACHE_MAX_DISKS		16
+
+/*
+ * This is the number of consecutive sequential reads on a disk after which
+ * the disk is considered to be streaming, and read-ahead is performed.
+ */
+#define AXP_VHD_CACHE_SEQ_TRIGGER	2
+
+/*
+ * With more than one request in flight, the reads of a sequential stream do
+ * not always arrive in order.  A read that starts within this many blocks of
+ * where the stream has got to is still considered part of it.
+ */
+#define AXP_VHD_CACHE_SEQ_WINDOW	16
+
+/*
+ * When the configuration has a cache size, but does not specify a dirty
+ * limit, this fraction of the cache can be dirty.
+ */
+#define AXP_VHD_CACHE_DEF_DIRTY_DIV	4
+
+/*
+ * A cache entry.  The LRU queue header must be first, as the LRU functions
+ * work with queue headers.  The data for the block immediately follows the
+ * entry.  An entry being filled from, or written back to, its disk is used
+ * with the shard unlocked.  Until it is done, an entry being filled cannot be
+ * used at all, and one being written back cannot be written into.  Neither
+ * can be evicted.
+ */
+struct AXP_VHD_CacheDisk;
+typedef struct AXP_VHD_CacheEntry
+{
+    AXP_QUEUE_HDR		lru;
+    struct AXP_VHD_CacheEntry *hashNext;
+    struct AXP_VHD_CacheEntry *wbNext;
+    struct AXP_VHD_CacheDisk *disk;
+    u64				blockNum;
+    bool			dirty;
+    bool			prefetched;
+    bool			filling;
+    bool			writing;
+    u8				*data;
+} AXP_VHD_CACHE_ENTRY;
+
+/*
+ * A cache shard.  Each shard has a share of the cache budget and dirty limit.
+ * The condition variable is broadcast when entries are no longer being filled
+ * or written back.  The write generation is incremented, with the shard
+ * locked, whenever blocks in the shard have been written back to their disks.
+ */
+typedef struct
+{
+    pthread_mutex_t	mutex;
+    pthread_cond_t	cond;
+    AXP_QUEUE_HDR	lruQ;
+    AXP_VHD_CACHE_ENTRY **hash;
+    u32				hashMask;
+    u32				entries;
+    u32				maxEntries;
+    u32				dirty;
+    u32				maxDirty;
+    u64				writeGen;
+
+    /*
+     * Statistics
+     */
+    u64				hits;
+    u64				misses;
+    u64				readAheads;
+    u64				readAheadHits;
+    u64				writeBacks;
+    u64				evictions;
+    u64				writeErrors;
+} AXP_VHD_CACHE_SHARD;
+
+/*
+ * A disk attached to the cache.  The I/O mutex serializes the calls to the
+ * format specific functions for the disk, as these are not thread safe.  The
+ * stream mutex protects the sequential read detection.
+ */
+typedef struct AXP_VHD_CacheDisk
+{
+    AXP_VHD_HANDLE	handle;
+    pthread_mutex_t	ioMutex;
+    pthread_mutex_t	streamMutex;
+    u64				diskSize;
+    u64				nextBlock;
+    u32				seqCount;
+    u32				deviceID;
+    u32				sectorSize;
+    u32				lastError;
+    bool			writable;
+} AXP_VHD_CACHE_DISK;
+
+/*
+ * The statistics returned to the caller.
+ */
+typedef struct
+{
+    u64				hits;
+    u64				misses;
+    u64				readAheads;
+    u64				readAheadHits;
+    u64				writeBacks;
+    u64				evictions;
+    u64				writeErrors;
+    u64				entries;
+    u64				dirty;
+    u64				maxEntries;
+} AXP_VHD_CACHE_STATS;
+
+/*
+ * Function Prototypes
+ */
+bool AXP_VHD_CacheInit(u64, u64, u32);
+void AXP_VHD_CacheAttach(AXP_VHD_HANDLE);
+u32 AXP_VHD_CacheDetach(AXP_VHD_HANDLE);
+u32 AXP_VHD_CacheFlush(AXP_VHD_HANDLE);
+bool AXP_VHD_CacheRead(AXP_VHD_HANDLE, u64, u32 *, u8 *, u32 *);
+bool AXP_VHD_CacheWrite(AXP_VHD_HANDLE, u64, u32 *, u8 *, u32 *);
+void AXP_VHD_CacheGetStats(AXP_VHD_CACHE_STATS *);
+
+/*
+ * These are in AXP_VirtualDisk.c, and are called by the cache to read and
+ * write the format specific disk.
+ */
+u32 _AXP_VHD_ReadBackend(AXP_VHD_HANDLE, u32, u64, u32 *, u8 *);
+u32 _AXP_VHD_WriteBackend(AXP_VHD_HANDLE, u32, u64, u32 *, u8 *);
+
+#endif /* _AXP_VHD_CACHE_H_ */
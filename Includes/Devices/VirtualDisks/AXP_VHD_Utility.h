@@ -23,6 +23,9 @@
  *
  *  V01.000	07-Jul-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added the prototypes for the image mapping functions.
  */
 #ifndef _AXP_VHD_UTILITY_H_
 #define _AXP_VHD_UTILITY_H_
@@ -62,6 +65,9 @@ void AXP_VHD_SetGUIDDisk(AXP_VHDX_GUID *);
 void AXP_VHD_KnownGUIDMemory(AXP_VHD_KnownGUIDs, AXP_VHDX_GUID *);
 void AXP_VHD_KnownGUIDDisk(AXP_VHD_KnownGUIDs, AXP_VHDX_GUID *);
 u64 AXP_VHD_PerformFileSize(FILE *);
+u32 AXP_VHD_MapImage(int, u64, bool, u8 **);
+void AXP_VHD_UnmapImage(u8 *, u64, bool);
+u32 AXP_VHD_AdviseImage(u8 *, u64, u64, u64, AXP_VHD_ACCESS_HINT);
 u32 AXP_VHD_ValidateCreate(
     AXP_VHD_STORAGE_TYPE *,
     char *,
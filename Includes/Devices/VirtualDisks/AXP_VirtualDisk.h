@@ -25,6 +25,18 @@
  *
  *  V01.000	02-Jul-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001	19-Oct-2026	Jonathan D. Belanger
+ *  Added the OPEN_MAPPED_IO open flag and the access hint and mapped sector
+ *  functions, so that fixed VHD, RAW, and ISO images can be accessed through
+ *  a memory mapping of the image file.
+ *
+ *  V01.002	19-Oct-2026	Jonathan D. Belanger
+ *  Added the SSD length definitions.  The SSD was using the ISO ones, which
+ *  did not allow an SSD to be created.
+ *
+ *  V01.003	19-Oct-2026	Jonathan D. Belanger
+ *  Added the function to create a snapshot overlay on top of an open VHD.
  */
 #ifndef AXP_VIRTUALDISK_H_
 #define AXP_VIRTUALDISK_H_
@@ -45,6 +57,9 @@
 #define AXP_ISO_BLK_DEF		0
 #define AXP_ISO_BLK_MIN		0
 #define AXP_ISO_BLK_MAX		0
+#define AXP_SSD_BLK_MIN		(512 * ONE_K)
+#define AXP_SSD_BLK_DEF		(32 * ONE_M)
+#define AXP_SSD_BLK_MAX		(256 * ONE_M)
 #define AXP_VHD_DEF_SEC		0
 #define AXP_VHD_SEC_DEF		512
 #define AXP_VHD_SEC_MIN		512
@@ -55,6 +70,9 @@
 #define AXP_ISO_SEC_DEF		TWO_K
 #define AXP_ISO_SEC_MIN		TWO_K
 #define AXP_ISO_SEC_MAX		TWO_K
+#define AXP_SSD_SEC_DEF		512
+#define AXP_SSD_SEC_MIN		512
+#define AXP_SSD_SEC_MAX		FOUR_K
 
 /*
  * Device type (DeviceID)
@@ -238,7 +256,8 @@ typedef enum
     OPEN_PARENT_CACHED_IO,
     OPEN_VHDSET_FILE_ONLY,
     OPEN_IGNORE_REL_PARENT_LOC,
-    OPEN_NO_WRITE_HARDENING
+    OPEN_NO_WRITE_HARDENING,
+    OPEN_MAPPED_IO
 } AXP_VHD_OPEN_FLAG;
 typedef enum
 {
@@ -301,6 +320,21 @@ typedef enum
     ACCESS_WRITABLE = 0x00000100
 } AXP_VHD_ACCESS_MASK;
 
+
+/*
+ * These are the access patterns that can be supplied for a virtual disk that
+ * was opened with OPEN_MAPPED_IO.  They are passed to the host as madvise
+ * hints for the mapped image.
+ */
+typedef enum
+{
+    ACCESS_HINT_NORMAL,
+    ACCESS_HINT_SEQUENTIAL,
+    ACCESS_HINT_RANDOM,
+    ACCESS_HINT_WILLNEED,
+    ACCESS_HINT_DONTNEED
+} AXP_VHD_ACCESS_HINT;
+
 typedef enum
 {
     RESIZE_NONE,
@@ -995,4 +1029,30 @@ u32 AXP_VHD_WriteSectors(AXP_VHD_HANDLE handle,
       u32 *sectorsWritten,
       u8 *outBuf);
 
+/*
+ * Supply an access pattern hint for a virtual disk opened with
+ * OPEN_MAPPED_IO.
+ */
+u32 AXP_VHD_SetAccessHint(AXP_VHD_HANDLE handle,
+        u64 lba,
+        u32 sectors,
+        AXP_VHD_ACCESS_HINT hint);
+
+/*
+ * Return the address, within the mapped image, of one or more sectors for a
+ * virtual disk opened with OPEN_MAPPED_IO.
+ */
+u32 AXP_VHD_GetMappedSectors(AXP_VHD_HANDLE handle,
+        u64 lba,
+        u32 sectors,
+        u8 **sectorAddr);
+
+/*
+ * Create a differencing disk on top of an open VHD, so that the VHD becomes
+ * its read-only parent, and return a handle to the new disk.
+ */
+u32 AXP_VHD_CreateOverlay(AXP_VHD_HANDLE handle,
+        char *path,
+        AXP_VHD_HANDLE *overlay);
+
 #endif /* AXP_VIRTUALDISK_H_ */
@@ -24,6 +24,9 @@
  *
  *	V01.000		02-Jun-2018	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	The Pchip is given the memory arrays it transfers DMA to and from.
  */
 #ifndef _AXP_21274_INITRTNS_H_
 #define _AXP_21274_INITRTNS_H_
@@ -36,7 +39,7 @@ void AXP_21274_CchipInit(AXP_21274_SYSTEM *);
 /*
  * Pchip Initialization Function Prototype
  */
-void AXP_21274_PchipInit(AXP_21274_PCHIP *, u32 id);
+void AXP_21274_PchipInit(AXP_21274_PCHIP *, u32 id, u64 **, u32, u64);
 
 /*
  * Dchip Initialization Function Prototype
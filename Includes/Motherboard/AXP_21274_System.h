@@ -22,6 +22,21 @@
  *
  *	V01.000		31-Dec-2017	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	Added the prototypes for the functions used to send to the CPUs.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	Interrupts are posted to a CPU atomically, and the CPU is only signaled
+ *	when its Cbox is sleeping.  The Cchip only works out the interrupts for
+ *	the CPUs again when the registers that route them change.
+ *
+ *	V01.003		19-Oct-2026	Jonathan D. Belanger
+ *	Added the 21143s for the configured networks.
+ *
+ *	V01.004		19-Oct-2026	Jonathan D. Belanger
+ *	Added the address of the flag a CPU sets when it is waiting for one of its
+ *	skid buffers to be released.
  */
 #ifndef _AXP_SYSTEM_DEFS_
 #define _AXP_SYSTEM_DEFS_	1
@@ -33,6 +48,7 @@
 #include "Motherboard/Cchip/AXP_21274_Cchip.h"
 #include "Motherboard/Pchip/AXP_21274_Pchip.h"
 #include "Motherboard/Dchip/AXP_21274_Dchip.h"
+#include "Devices/Ethernet/AXP_21143.h"
 
 /*
  * The following structure contains the information needed to be able to
@@ -46,10 +62,13 @@ typedef struct
     u8 *pqTop;
     u8 *pqBottom;
     u8 *irq_H;
+    bool *sleeping;
+    bool *skidWait;
 } AXP_21274_CPU;
 
 #define AXP_21274_MAX_CPUS		4
 #define AXP_21274_MAX_ARRAYS	4
+#define AXP_21274_MAX_NICS		AXP_PCI_MAX_SLOTS
 
 /*
  * HRM 2.1 System Building Block Variables
@@ -123,6 +142,7 @@ typedef struct
     u32 skidLastUsed;
     u32 cpuCount;
     AXP_21274_CPU cpu[AXP_21274_MAX_CPUS];
+    bool irqUpdate;			/* IRQ routing needs to be redone */
 
     /*
      * Cchip Registers
@@ -190,6 +210,21 @@ typedef struct
      *************************************************************************/
     AXP_21274_PCHIP p0;
     AXP_21274_PCHIP p1;
+
+    /*
+     * Network Interfaces
+     *
+     * A 21143 for each configured network, in the slots of the Pchip 0 PCI
+     * bus.
+     */
+    u32 nicCount;
+    AXP_21143 *nic[AXP_21274_MAX_NICS];
 } AXP_21274_SYSTEM;
 
+/*
+ * System to CPU Function Prototypes
+ */
+void AXP_21264_SendToCPU(AXP_21274_SYSBUS_CPU *, AXP_21274_CPU *);
+void AXP_21264_InterruptToCPU(u8, AXP_21274_CPU *);
+
 #endif	/* _AXP_SYSTEM_DEFS_ */
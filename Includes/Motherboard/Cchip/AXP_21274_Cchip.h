@@ -23,6 +23,13 @@
  *
  *	V01.000		18-Mar-2018	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	Added the definitions for the console ports in PCI I/O space.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	Added the CPU and ID, from the CPU's request, to the CAPbus message, so
+ *	that the data read by the Pchip can be returned to the CPU.
  */
 #ifndef _AXP_21274_CCHIP_H_
 #define _AXP_21274_CCHIP_H_
@@ -240,11 +247,21 @@ typedef struct
     u16 csr;				/* Pchip2Cchip */
     u8 mask;				/* Cchipe2Pchip */
     u8 res;				/* reserved */
+    u8 cpuID;				/* CPU the read is returned to */
+    u8 id;				/* ID from the CPU's request */
 } AXP_CAPbusMsg;
 
 #include "Motherboard/Pchip/AXP_21274_Pchip.h"
 #include "Motherboard/Dchip/AXP_21274_Dchip.h"
 
+/*
+ * The PCI I/O address is in the low 25 bits of a linear I/O address.  The
+ * console ports are ISA devices, whose interrupts come in through the PCI-ISA
+ * bridge on DRIR<55>.
+ */
+#define AXP_21274_IO_MASK	0x0000000001ffffffll
+#define AXP_21274_DRIR_ISA	55
+
 /*
  * Cchip Function Prototypes
  */
@@ -34,6 +34,26 @@
  *
  *	V01.000		31-Mar-2018	Jonathan D. Belanger
  *	Initially written.
+ *
+ *	V01.001		19-Oct-2026	Jonathan D. Belanger
+ *	The System is also given the address of the flag the Cbox sets when it is
+ *	waiting for something to do.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	Added the miss1 flag to the skid buffer, so it has the same layout as the
+ *	CPU's request queue entry, and the CPU is given the address of its skid
+ *	buffers.
+ *
+ *	V01.003		19-Oct-2026	Jonathan D. Belanger
+ *	Added the probe to the probe queue entry, which was missing, so that it
+ *	has the same layout as the CPU's.
+ *
+ *	V01.004		19-Oct-2026	Jonathan D. Belanger
+ *	The System's flag to redo the IRQ_H bits is also given to the CPU.
+ *
+ *	V01.005		19-Oct-2026	Jonathan D. Belanger
+ *	The CPU's flag that it is waiting for a skid buffer is given to the
+ *	System.
  */
 #ifndef _AXP_21274_21264_COMMON_H_
 #define _AXP_21274_21264_COMMON_H_
@@ -100,6 +120,7 @@ typedef struct
     u64 sysData[AXP_21274_DATA_SIZE];
     AXP_SYSDC sysDc;
     AXP_ProbeStatus probeStatus;
+    int probe;
     bool rvb;
     bool rpb;
     bool a;
@@ -160,6 +181,7 @@ typedef struct
     int sysDataLen;
     u32 cpuID;
     u16 waitVector;
+    bool miss1;
     bool miss2;
     bool rqValid;
     bool cacheHit;
@@ -185,9 +207,13 @@ void AXP_21264_Save_SystemInterfaces(
     u8 **,
     u8 **,
     u8 **,
+    bool **,
+    bool **,
     pthread_mutex_t *,
     pthread_cond_t *,
-    AXP_QUEUE_HDR *);
+    AXP_QUEUE_HDR *,
+    void *,
+    bool *);
 void AXP_21264_Unlock_CPU(void *);
 
 #endif /* _AXP_21274_21264_COMMON_H_ */
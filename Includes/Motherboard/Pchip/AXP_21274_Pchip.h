@@ -26,6 +26,33 @@
  *
  *	V01.001		12-May-2018	Jonathan D. Belanger
  *	Moved the Pchip CSRs and queues over here to be similar to the real thing.
+ *
+ *	V01.002		19-Oct-2026	Jonathan D. Belanger
+ *	Added the scatter-gather TLB, the memory arrays that DMA is transferred
+ *	to and from, and the DMA function called by the PCI devices.
+ *
+ *	V01.003		19-Oct-2026	Jonathan D. Belanger
+ *	Replaced the request queues with separate, bounded, PIO and DMA queues.
+ *
+ *	V01.004		19-Oct-2026	Jonathan D. Belanger
+ *	Added the PCI devices registered on the bus, and the indexes used to find
+ *	the device whose BAR a PIO address falls in.
+ *
+ *	V01.005		19-Oct-2026	Jonathan D. Belanger
+ *	Added the function called to return the data for a read back to the
+ *	Cchip.  The indexes that have been replaced are now freed by the Pchip
+ *	thread, between batches of requests, rather than kept forever.
+ *
+ *	V01.006		19-Oct-2026	Jonathan D. Belanger
+ *	Requests are numbered as they are queued, so that the two queues can be
+ *	processed in the order the requests arrived.  DMA from a PCI device is
+ *	now queued, as a bulk transfer, rather than done on the device's thread.
+ *	Added a flag to have the Pchip thread exit.
+ *
+ *	V01.007		19-Oct-2026	Jonathan D. Belanger
+ *	Added the other Pchip, to pass a DMA that does not hit in any window on
+ *	to as a peer-to-peer transfer, and the function called after a DMA has
+ *	written to memory, so that the CPUs can invalidate their copies of it.
  */
 #ifndef _AXP_21274_PCHIP_H_
 #define _AXP_21274_PCHIP_H_
@@ -33,6 +60,7 @@
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
 #include "CommonUtilities/AXP_Trace.h"
+#include "CommonUtilities/AXP_PCI.h"
 #include "Motherboard/AXP_21274_Registers.h"
 #include "Motherboard/Cchip/AXP_21274_Cchip.h"
 #include "Motherboard/Dchip/AXP_21274_Dchip.h"
@@ -42,16 +70,94 @@
  * implement a single Pchip.  There is always at least one of these and as many
  * as two of them.
  */
-#define AXP_21274_CAPBUS_MQ_SIZE	4+4	/* up to 4 messages in each direction */
+
+/*
+ * The requests to the Pchip are kept on a circular queue.  There is one for
+ * requests from the CPUs (PIO, CSR, and configuration) and one for requests
+ * from the PCI devices (DMA).  Each request is numbered as it is queued, so
+ * that the Pchip can process the two queues in the order the requests
+ * arrived.  A DMA from a PCI device is a bulk transfer to or from the
+ * device's buffer, rather than a CAPbus message, and the device waits for it
+ * to be done.  A DMA that does not hit in any of the Pchip's windows is
+ * queued again, to the other Pchip, as a peer-to-peer transfer.
+ */
+#define AXP_21274_PCHIP_QUE_LEN	16
+typedef struct
+{
+    AXP_CAPbusMsg msg;
+    u64 seq;				/* Order the request was queued in */
+    u64 pciAddr;			/* Bulk DMA only (buf != NULL) */
+    u8 *buf;
+    u32 len;
+    bool write;
+    bool ptp;				/* Peer-to-peer, to the PCI bus */
+    bool *miss;				/* Set when no window was hit */
+    bool *done;				/* Set when the DMA has been done */
+    bool *retVal;			/* Set to whether the DMA succeeded */
+} AXP_21274_PCHIP_RQ;
+
+typedef struct
+{
+    u32 head;
+    u32 count;
+    AXP_21274_PCHIP_RQ rq[AXP_21274_PCHIP_QUE_LEN];
+} AXP_21274_PCHIP_QUE;
+
+/*
+ * HRM 10.1.4.4 Scatter-Gather TLB
+ *
+ * The scatter-gather TLB has eight entries.  Each entry is tagged with PCI
+ * address <31:15> and whether the address was a DAC one, and holds the four
+ * PTEs, from one 32-byte aligned group in the page table, that map the four
+ * 8KB pages following the tag.
+ */
+#define AXP_21274_TLB_LEN	8
+#define AXP_21274_TLB_PTES	4
+#define AXP_21274_SG_PAGE	8192
+typedef struct
+{
+    bool valid;
+    bool dac;
+    u32 tag;				/* PCI address <31:15> */
+    u64 pte[AXP_21274_TLB_PTES];
+} AXP_21274_SG_TLB;
+
+/*
+ * The programmed and enabled BARs on a PCI bus are kept in an index, sorted by
+ * base address, so that the device for a PIO address can be found with a
+ * binary search.  There is one for PCI memory space and one for PCI I/O
+ * space.  An index is never changed once it has been published.  When a BAR
+ * or command register is written, a new one is built and swapped in, so that
+ * a lookup never needs a lock.  Lookups are only done by the Pchip thread,
+ * so the ones that have been replaced are kept until it has finished the
+ * batch of requests it is working on, and then freed.
+ */
 typedef struct
+{
+    u64 base;
+    u64 limit;
+    AXP_PCI_DEVICE *dev;
+    u32 bar;
+} AXP_PCI_RANGE;
+
+typedef struct AXP_PCI_INDEX_S
+{
+    struct AXP_PCI_INDEX_S *prev;	/* The index this one replaced */
+    u32 count;
+    AXP_PCI_RANGE range[AXP_PCI_MAX_SLOTS * AXP_PCI_MAX_BARS];
+} AXP_PCI_INDEX;
+
+typedef struct AXP_21274_PCHIP_S
 {
 
     /*
-     * There is one thread/mutex/condition variable per Pchip.
+     * There is one thread/mutex/condition variable per Pchip.  The second
+     * condition variable is used to wait for room on a full queue.
      */
     pthread_t threadID;
     pthread_mutex_t mutex;
     pthread_cond_t cond;
+    pthread_cond_t space;
 
     /*
      * Pchip ID
@@ -59,14 +165,14 @@ typedef struct
     u32 pChipID;
 
     /*
-     * Interface queues.
+     * Interface queues, the number given to the next request queued on
+     * either of them, and the flag that has the Pchip thread exit once they
+     * are empty.
      */
-    AXP_QUEUE_HDR tpr; /* To Pchip Requests CSC<PRQMAX> */
-    AXP_QUEUE_HDR fpr; /* From Pchip Requests PCTL<CRQMAX> */
-    u32 tprCnt; /* Up to CSC<PRQMAX> */
-    u32 fprCnt; /* Up to PCTL<CRQMAX> */
-    AXP_CAPbusMsg rq[AXP_21274_CAPBUS_MQ_SIZE];
-    u32 rqIdx;
+    AXP_21274_PCHIP_QUE pio;
+    AXP_21274_PCHIP_QUE dma;
+    u64 seq;
+    bool shutdown;
 
     /*
      * The following are the Pchip CSRs.  The addresses for these Pchip CSRs
@@ -94,6 +200,52 @@ typedef struct
     AXP_21274_PMONCTL pMonCtl; /* Address: 80n.8000.0500 */
     AXP_21274_PMONCNT pMonCnt; /* Address: 80n.8000.0540 */
     AXP_21274_SPRST sprSt; /* Address: 80n.8000.0800 */
+
+    /*
+     * The scatter-gather TLB.  The mutex also covers the error bits in
+     * PERROR, which a PCI device thread sets when its DMA does not hit in a
+     * window on either Pchip.
+     */
+    pthread_mutex_t tlbMutex;
+    AXP_21274_SG_TLB tlb[AXP_21274_TLB_LEN];
+    u32 tlbNext;
+
+    /*
+     * The memory arrays, from the Dchip, that DMA is transferred to and from.
+     */
+    u64 **array;
+    u32 arrayCount;
+    u64 arraySize;
+
+    /*
+     * The PCI devices registered on this Pchip's bus, the indexes of their
+     * memory and I/O BARs, and the function called, with its argument, to
+     * assert or deassert a device's interrupt.  The mutex is only used when
+     * registering devices and writing configuration space.
+     */
+    pthread_mutex_t pciMutex;
+    AXP_PCI_DEVICE *pciDev[AXP_PCI_MAX_SLOTS];
+    AXP_PCI_INDEX *memIndex;
+    AXP_PCI_INDEX *ioIndex;
+    void (*irq)(void *, u32, bool);
+    void *irqArg;
+
+    /*
+     * The function called, with its argument, when a read request from the
+     * Cchip has completed, to return the data read to the CPU.
+     */
+    void (*complete)(void *, AXP_CAPbusMsg *);
+    void *completeArg;
+
+    /*
+     * The function called, with its argument, after a DMA has written to a
+     * range of memory, so that the CPUs do not keep using stale copies of it
+     * in their caches, and the other Pchip, which PCI addresses that do not
+     * hit in one of our windows are passed on to.
+     */
+    void (*invalidate)(void *, u64, u32);
+    void *invalidateArg;
+    struct AXP_21274_PCHIP_S *peer;
 } AXP_21274_PCHIP;
 
 #define AXP_21274_WHICH_PCHIP(addr) (((addr) & 0x0000000200000000) >> 33)
@@ -102,5 +254,17 @@ typedef struct
  * Pchip Function Prototypes
  */
 void *AXP_21274_PchipMain(void *);
+bool AXP_21274_PchipDMA(AXP_21274_PCHIP *, u64, u8 *, u32, bool);
+void AXP_21274_PchipQueue(AXP_21274_PCHIP *, AXP_CAPbusMsg *);
+void AXP_21274_PchipStop(AXP_21274_PCHIP *);
+
+/*
+ * PCI Bus Function Prototypes
+ */
+bool AXP_21274_PCIRegister(AXP_21274_PCHIP *, AXP_PCI_DEVICE *, u32);
+void AXP_21274_PCIInterrupt(AXP_PCI_DEVICE *, bool);
+void AXP_21274_PCIAccess(AXP_21274_PCHIP *, AXP_CAPbusMsg *);
+void AXP_21274_PCIRetire(AXP_21274_PCHIP *);
+bool AXP_21274_PCIPeer(AXP_21274_PCHIP *, u64, u8 *, u32, bool);
 
 #endif /* _AXP_21274_PCHIP_H_ */
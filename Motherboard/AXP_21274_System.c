@@ -22,20 +22,130 @@
  *
  *  V01.000 21-JAN-2018	Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001 19-Oct-2026	Jonathan D. Belanger
+ *  Turn on virtual time for the timers when it is configured.
+ *
+ *  V01.002 19-Oct-2026	Jonathan D. Belanger
+ *  Get the address of each CPU's Cbox sleeping flag.
+ *
+ *  V01.003 19-Oct-2026	Jonathan D. Belanger
+ *  Initialize the Pchip TLB mutexes, give the Pchips the memory arrays, and
+ *  pass each Pchip thread its own Pchip, rather than the system.
+ *
+ *  V01.004 19-Oct-2026	Jonathan D. Belanger
+ *  Initialize the condition variables used to wait for room on the Pchip
+ *  queues.
+ *
+ *  V01.005 19-Oct-2026	Jonathan D. Belanger
+ *  Initialize the Pchip PCI bus mutexes.
+ *
+ *  V01.006 19-Oct-2026	Jonathan D. Belanger
+ *  Give each CPU the address of its own set of skid buffers.
+ *
+ *  V01.007 19-Oct-2026	Jonathan D. Belanger
+ *  Create a 21143 for each configured network, and register it on the Pchip 0
+ *  PCI bus.
+ *
+ *  V01.008 19-Oct-2026	Jonathan D. Belanger
+ *  Let each Pchip know about the other one, for peer-to-peer DMA.
+ *
+ *  V01.009 19-Oct-2026	Jonathan D. Belanger
+ *  Give each CPU the address of the flag that has the Cchip redo the IRQ_H
+ *  bits.
+ *
+ *  V01.010 19-Oct-2026	Jonathan D. Belanger
+ *  Get the address of each CPU's flag that it is waiting for a skid buffer.
  */
 #include "CommonUtilities/AXP_Configure.h"
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Blocks.h"
+#include "CommonUtilities/AXP_TimerWheel.h"
 #include "Motherboard/AXP_21274_System.h"
 #include "Motherboard/Cchip/AXP_21274_Cchip.h"
 #include "Motherboard/Dchip/AXP_21274_Dchip.h"
 #include "Motherboard/Pchip/AXP_21274_Pchip.h"
 #include "Motherboard/AXP_21274_InitRoutines.h"
 
+/*
+ * AXP_21274_NicDMA
+ *  This function is called by a 21143 to DMA to or from memory through the
+ *  Pchip it is on.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the Pchip the 21143 is on.
+ *  addr:
+ *      A value indicating the PCI address to be read or written.
+ *  buf:
+ *      A pointer to the data to be written, or the buffer to receive the data
+ *      read.
+ *  len:
+ *      A value indicating the number of bytes to be read or written.
+ *  write:
+ *      A boolean indicating whether memory is to be written.
+ *
+ * Output Parameters:
+ *  buf:
+ *      The data read.
+ *
+ * Return Values:
+ *  true:   The DMA was done.
+ *  false:  The PCI address did not map to memory.
+ */
+static bool AXP_21274_NicDMA(void *arg, u64 addr, u8 *buf, u32 len, bool write)
+{
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (AXP_21274_PchipDMA((AXP_21274_PCHIP *) arg,
+                               addr,
+                               buf,
+                               len,
+                               write));
+}
+
+/*
+ * AXP_21274_NicInterrupt
+ *  This function is called by a 21143 when its interrupt line changes.  The
+ *  21143 is not in the system until it has been created, but it cannot
+ *  interrupt until the guest has set it up.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the entry in the system for the 21143.
+ *  level:
+ *      A boolean indicating the level of the interrupt line.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void AXP_21274_NicInterrupt(void *arg, bool level)
+{
+    AXP_21143 *nic = __atomic_load_n((AXP_21143 **) arg, __ATOMIC_ACQUIRE);
+
+    if (nic != NULL)
+    {
+        AXP_21274_PCIInterrupt(&nic->pci, level);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
 AXP_21274_SYSTEM *AXP_21274_AllocateSystem(void)
 {
     AXP_21274_SYSTEM *sys;
     void *cpu[AXP_21274_MAX_CPUS];
+    AXP_21143 *nic;
+    char name[256];
+    u32 unit;
     int pthreadRet;
     int ii;
     bool qRet = true;
@@ -57,6 +167,22 @@ AXP_21274_SYSTEM *AXP_21274_AllocateSystem(void)
             pthreadRet = pthread_mutex_init(&sys->p1.mutex, NULL);
         }
         if (pthreadRet == 0)
+        {
+            pthreadRet = pthread_mutex_init(&sys->p0.tlbMutex, NULL);
+        }
+        if (pthreadRet == 0)
+        {
+            pthreadRet = pthread_mutex_init(&sys->p1.tlbMutex, NULL);
+        }
+        if (pthreadRet == 0)
+        {
+            pthreadRet = pthread_mutex_init(&sys->p0.pciMutex, NULL);
+        }
+        if (pthreadRet == 0)
+        {
+            pthreadRet = pthread_mutex_init(&sys->p1.pciMutex, NULL);
+        }
+        if (pthreadRet == 0)
         {
             pthreadRet = pthread_cond_init(&sys->cChipCond, NULL);
         }
@@ -68,6 +194,14 @@ AXP_21274_SYSTEM *AXP_21274_AllocateSystem(void)
         {
             pthreadRet = pthread_cond_init(&sys->p1.cond, NULL);
         }
+        if (pthreadRet == 0)
+        {
+            pthreadRet = pthread_cond_init(&sys->p0.space, NULL);
+        }
+        if (pthreadRet == 0)
+        {
+            pthreadRet = pthread_cond_init(&sys->p1.space, NULL);
+        }
 
         /*
         * Let's go allocate all the CPUs configured to this emulation
@@ -75,6 +209,13 @@ AXP_21274_SYSTEM *AXP_21274_AllocateSystem(void)
         if (pthreadRet == 0)
         {
             sys->cpuCount = AXP_ConfigGet_CPUCount();
+
+            /*
+             * If the CPUs are to run in virtual time, the device timers are
+             * run off the instructions the CPUs retire, rather than the
+             * host's clock.
+             */
+            AXP_TimerVirtual(sys->cpuCount, AXP_ConfigGet_VirtualTime());
             for (ii = 0; ii < AXP_21274_MAX_CPUS; ii++)
             {
 
@@ -99,9 +240,15 @@ AXP_21274_SYSTEM *AXP_21274_AllocateSystem(void)
                                                         &sys->cpu[ii].pqTop,
                                                         &sys->cpu[ii].pqBottom,
                                                         &sys->cpu[ii].irq_H,
+                                                        &sys->cpu[ii].sleeping,
+                                                        &sys->cpu[ii].skidWait,
                                                         &sys->cChipMutex,
                                                         &sys->cChipCond,
-                                                        &sys->skidBufferQ);
+                                                        &sys->skidBufferQ,
+                                                        &sys->skidBuffers[
+                                                            ii *
+                                                            AXP_21274_CCHIP_RQ_LEN],
+                                                        &sys->irqUpdate);
                     }
                     else
                     {
@@ -153,8 +300,18 @@ AXP_21274_SYSTEM *AXP_21274_AllocateSystem(void)
              */
             AXP_21274_CchipInit(sys);
             AXP_21274_DchipInit(sys);
-            AXP_21274_PchipInit(&sys->p0, 0);
-            AXP_21274_PchipInit(&sys->p1, 1);
+            AXP_21274_PchipInit(&sys->p0,
+                                0,
+                                sys->array,
+                                sys->arrayCount,
+                                sys->arraySizes);
+            AXP_21274_PchipInit(&sys->p1,
+                                1,
+                                sys->array,
+                                sys->arrayCount,
+                                sys->arraySizes);
+            sys->p0.peer = &sys->p1;
+            sys->p1.peer = &sys->p0;
             pthreadRet = pthread_create(&sys->cChipThreadID,
                                         NULL,
                                         AXP_21274_CchipMain,
@@ -164,14 +321,53 @@ AXP_21274_SYSTEM *AXP_21274_AllocateSystem(void)
                 pthreadRet = pthread_create(&sys->p0.threadID,
                                             NULL,
                                             AXP_21274_PchipMain,
-                                            sys);
+                                            &sys->p0);
             }
             if (pthreadRet == 0)
             {
                 pthreadRet = pthread_create(&sys->p1.threadID,
                                             NULL,
                                             AXP_21274_PchipMain,
-                                            sys);
+                                            &sys->p1);
+            }
+
+            /*
+             * Now that the Pchips are running, create a 21143 for each of the
+             * configured networks, and put it in the next free slot of the
+             * Pchip 0 PCI bus.  A network that cannot be opened is left out.
+             */
+            sys->nicCount = 0;
+            for (ii = 0;
+                 ((pthreadRet == 0) &&
+                  (ii < AXP_ConfigGet_NetworkCount()) &&
+                  (sys->nicCount < AXP_21274_MAX_NICS));
+                 ii++)
+            {
+                if (AXP_ConfigGet_NetworkInfo(ii, name, &unit) == true)
+                {
+                    nic = AXP_21143_Init(name,
+                                         unit,
+                                         AXP_21274_NicDMA,
+                                         &sys->p0,
+                                         AXP_21274_NicInterrupt,
+                                         &sys->nic[sys->nicCount],
+                                         0);
+                    if (nic != NULL)
+                    {
+                        if (AXP_21274_PCIRegister(&sys->p0,
+                                                  &nic->pci,
+                                                  sys->nicCount) == true)
+                        {
+                            __atomic_store_n(&sys->nic[sys->nicCount++],
+                                             nic,
+                                             __ATOMIC_RELEASE);
+                        }
+                        else
+                        {
+                            AXP_21143_Close(nic);
+                        }
+                    }
+                }
             }
         }
     }
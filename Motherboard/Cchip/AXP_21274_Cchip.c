@@ -53,11 +53,55 @@
  *  request from the CPU, and initialize the response to the CPU.  The Cchip
  *  loop will send this response to the appropriate CPU upon return from the
  *  read and write.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Byte reads and writes to the console ports in Pchip0's PCI I/O space are
+ *  now handled here, against the console port's rings, rather than being
+ *  queued to the Pchip.  The console ports raise their interrupt through
+ *  DRIR, and the CPUs are only signaled when it is first asserted.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  The IRQ_H bits are no longer recomputed, under each CPU's mutex, after
+ *  every request.  They are only recomputed when MISC, DIMn, or DRIR have
+ *  changed, and are posted to the CPUs without a lock.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  Requests to the Pchips are built locally and then queued up to the Pchip,
+ *  which waits for room on its queue, rather than using the next one of its
+ *  entries with no check for it being full.
+ *
+ *  V01.006 19-Oct-2026 Jonathan D. Belanger
+ *  The console interrupt is now just one of the DRIR bits that can be set or
+ *  cleared, the others being the PCI device interrupts from the Pchips.
+ *
+ *  V01.007 19-Oct-2026 Jonathan D. Belanger
+ *  A skid buffer is released atomically once it has been processed, and the
+ *  CPU that filled it is signaled, in case it was waiting for one to become
+ *  available.  Also, all the skid buffers are now initialized.
+ *
+ *  V01.008 19-Oct-2026 Jonathan D. Belanger
+ *  The response filled in for a request is now sent to the CPU.  Reads queued
+ *  to a Pchip carry the CPU and ID along with them, and the Pchip calls back
+ *  here, with the data read, to have the response sent.
+ *
+ *  V01.009 19-Oct-2026 Jonathan D. Belanger
+ *  When a DMA has written to memory, the Pchip calls back here to have each
+ *  block written invalidated in the caches of the CPUs with probes enabled.
+ *
+ *  V01.010 19-Oct-2026 Jonathan D. Belanger
+ *  IRQ<1> is kept a level.  The main loop is also woken up, without a request
+ *  to process, to redo the IRQ_H bits when a device deasserts its interrupt
+ *  or a CPU has taken IRQ<1>.
+ *
+ *  V01.011 19-Oct-2026 Jonathan D. Belanger
+ *  A CPU is only signalled, when one of its skid buffers is released, if it
+ *  is waiting for one.
  */
 #include "Motherboard/AXP_21274_System.h"
 #include "Motherboard/Cchip/AXP_21274_Cchip.h"
 #include "Motherboard/Cchip/CPUInterface/AXP_21274_21264_Common.h"
 #include "Motherboard/AXP_21274_AddressMapping.h"
+#include "Devices/Console/AXP_Console.h"
 
 /*
  * Local Prototypes
@@ -87,6 +131,14 @@ static void AXP_21274_ReadTIG(AXP_21274_SYSTEM *,
 static void AXP_21274_WriteTIG(AXP_21274_SYSTEM *,
                                AXP_21274_RQ_ENTRY *,
                                AXP_21274_SYSBUS_CPU *);
+static bool AXP_21274_ConsolePIO(AXP_21274_RQ_ENTRY *,
+                                 AXP_21274_SYSBUS_CPU *);
+static void AXP_21274_DeviceInterrupt(void *, u32, bool);
+static void AXP_21274_PchipComplete(void *, AXP_CAPbusMsg *);
+static void AXP_21274_PchipInvalidate(void *, u64, u32);
+static void AXP_21274_ConsoleInterrupt(void *, bool);
+static void AXP_21274_UpdateIRQ(AXP_21274_SYSTEM *);
+static void AXP_21274_CheckIRQ(AXP_21274_SYSTEM *);
 
 /*
  * AXP_21274_ReadCCSR
@@ -497,6 +549,7 @@ static void AXP_21274_WriteCCSR(AXP_21274_SYSTEM *sys,
                     {
                         sys->misc.itintr |= csrValue.misc.itintr;
                     }
+                    __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
                     break;
 
                 case 0x03: /* MPD */
@@ -527,11 +580,13 @@ static void AXP_21274_WriteCCSR(AXP_21274_SYSTEM *sys,
                 case 0x08: /* DIM0 */
                     csrValue.value = value; /* TODO: Mask? */
                     sys->dim0 = csrValue.dimn;
+                    __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
                     break;
 
                 case 0x09: /* DIM1 */
                     csrValue.value = value; /* TODO: Mask? */
                     sys->dim1 = csrValue.dimn;
+                    __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
                     break;
 
                 case 0x0d: /* PRBEN */
@@ -598,11 +653,13 @@ static void AXP_21274_WriteCCSR(AXP_21274_SYSTEM *sys,
                 case 0x18: /* DIM2 */
                     csrValue.value = value; /* TODO: Mask? */
                     sys->dim2 = csrValue.dimn;
+                    __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
                     break;
 
                 case 0x19: /* DIM3 */
                     csrValue.value = value; /* TODO: Mask? */
                     sys->dim3 = csrValue.dimn;
+                    __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
                     break;
 
                 case 0x1c: /* IIC2 */
@@ -687,14 +744,9 @@ static void AXP_21274_ReadPchip(AXP_21274_SYSTEM *sys, AXP_21274_RQ_ENTRY *rq)
     AXP_21274_PCHIP *p = (AXP_21274_WHICH_PCHIP(rq->pa) == 0) ?
                             &sys->p0 :
                             &sys->p1;
-    AXP_CAPbusMsg *msg;
+    AXP_CAPbusMsg msg;
 
-    /*
-     * TODO: Need to look at flow-control.
-     */
-
-    pthread_mutex_lock(&p->mutex);
-    msg = &p->rq[p->rqIdx++];
+    memset(&msg, 0, sizeof(msg));
 
     /*
      * The command to send to the Pchip is determined by the address space
@@ -702,57 +754,57 @@ static void AXP_21274_ReadPchip(AXP_21274_SYSTEM *sys, AXP_21274_RQ_ENTRY *rq)
      */
     if (AXP_21264_CSR_ADDR(rq->pa))
     {
-        msg->cmd = CSR_Read;
+        msg.cmd = CSR_Read;
     }
     else if (AXP_21274_LINEAR_MEMORY(rq->pa))
     {
-        msg->cmd = PIO_MemoryRead;
+        msg.cmd = PIO_MemoryRead;
     }
     else if (AXP_21274_LINEAR_IO(rq->pa))
     {
-        msg->cmd = PIO_Read;
+        msg.cmd = PIO_Read;
     }
     else if (AXP_21274_LINEAR_CFG(rq->pa))
     {
-        msg->cmd = PCI_ConfigRead;
+        msg.cmd = PCI_ConfigRead;
     }
     else if (AXP_21274_LINEAR_IACK(rq->pa))
     {
-        msg->cmd = PIO_IACK;
+        msg.cmd = PIO_IACK;
     }
 
     /*
      * The type that each bit in the mask represents is determined by the
      * command sent from the CPU.
      */
-    msg->ldp = NoLDP;
-    msg->c = NoCSR;
+    msg.ldp = NoLDP;
+    msg.c = NoCSR;
     switch (rq->cmd)
     {
         case ReadBytes:
-            msg->maskType = CAPbus_Byte;
+            msg.maskType = CAPbus_Byte;
             break;
 
         case ReadLWs:
-            msg->maskType = CAPbus_Lowngword;
+            msg.maskType = CAPbus_Lowngword;
             break;
 
         case ReadQWs:
-            if (msg->cmd == CSR_Read)
+            if (msg.cmd == CSR_Read)
             {
                 AXP_21274_CSR_ADDR csrNum =
                 {
                     .addr = rq->pa
                 };
 
-                msg->ldp = LoadP_PTP;
-                msg->c = PchipCSR;
-                msg->csr = csrNum.csr;
-                msg->maskType = CAPbus_NoMask;
+                msg.ldp = LoadP_PTP;
+                msg.c = PchipCSR;
+                msg.csr = csrNum.csr;
+                msg.maskType = CAPbus_NoMask;
             }
             else
             {
-                msg->maskType = CAPbus_Quadword;
+                msg.maskType = CAPbus_Quadword;
             }
             break;
 
@@ -761,33 +813,30 @@ static void AXP_21274_ReadPchip(AXP_21274_SYSTEM *sys, AXP_21274_RQ_ENTRY *rq)
     }
 
     /*
-     * Set the mask from the CPU.
+     * Set the mask from the CPU, and where the data read is to be returned.
      */
-    msg->mask = rq->mask;
+    msg.mask = rq->mask;
+    msg.cpuID = rq->cpuID & 0x3;
+    msg.id = rq->entry;
 
     /*
      * Address<34:3>
      */
-    if (msg->cmd == CSR_Write)
+    if (msg.cmd == CSR_Write)
     {
-        msg->addr = 0;
+        msg.addr = 0;
     }
     else
     {
-        msg->addr = (rq->pa & 0x000000007FFFFFFF8) >> 3;
+        msg.addr = (rq->pa & 0x000000007FFFFFFF8) >> 3;
     }
 
     /*
-     * Queue this up to the Pchip and then notify the Pchip it has something to
-     * process.
-     */
-    AXP_INSQUE(p->tpr.blink, &msg->header);
-
-    /*
-     * Notify the Pchip tat there is something to process.
+     * Queue this up to the Pchip, which will notify the Pchip it has something
+     * to process.  The Pchip calls AXP_21274_PchipComplete when it has the
+     * data.
      */
-    pthread_cond_signal(&p->cond);
-    pthread_mutex_unlock(&p->mutex);
+    AXP_21274_PchipQueue(p, &msg);
 
     /*
      * Return back to the caller
@@ -836,6 +885,10 @@ static void AXP_21274_ReadPIO(AXP_21274_SYSTEM *sys, AXP_21274_RQ_ENTRY *rq,
         rsp->sysDc = ReadData;
         rsp->id = rq->entry;
     }
+    else if (AXP_21274_ConsolePIO(rq, rsp) == true)
+    {
+        /* Handled against the console port's rings */
+    }
     else if (AXP_21274_LINEAR_MEMORY(rq->pa) ||
              AXP_21274_LINEAR_IO(rq->pa) ||
              AXP_21274_LINEAR_CFG(rq->pa) ||
@@ -883,14 +936,9 @@ static void AXP_21274_WritePchip(AXP_21274_SYSTEM *sys, AXP_21274_RQ_ENTRY *rq)
     AXP_21274_PCHIP *p = (AXP_21274_WHICH_PCHIP(rq->pa) == 0) ?
                          &sys->p0 :
                          &sys->p1;
-    AXP_CAPbusMsg *msg;
-
-    pthread_mutex_lock(&p->mutex);
-    msg = &p->rq[p->rqIdx++];
+    AXP_CAPbusMsg msg;
 
-    /*
-     * TODO: Need to look at flow-control.
-     */
+    memset(&msg, 0, sizeof(msg));
 
     /*
      * The command to send to the Pchip is determined by the address space
@@ -898,61 +946,61 @@ static void AXP_21274_WritePchip(AXP_21274_SYSTEM *sys, AXP_21274_RQ_ENTRY *rq)
      */
     if (AXP_21264_CSR_ADDR(rq->pa))
     {
-        msg->cmd = CSR_Write;
+        msg.cmd = CSR_Write;
     }
     else if (AXP_21274_LINEAR_MEMORY(rq->pa))
     {
-        msg->cmd = PIO_MemoryWriteCPU;
+        msg.cmd = PIO_MemoryWriteCPU;
     }
     else if (AXP_21274_LINEAR_IO(rq->pa))
     {
-        msg->cmd = PIO_Write;
+        msg.cmd = PIO_Write;
     }
     else if (AXP_21274_LINEAR_CFG(rq->pa))
     {
-        msg->cmd = PCI_ConfigWrite;
+        msg.cmd = PCI_ConfigWrite;
     }
     else if (AXP_21274_LINEAR_IACK(rq->pa))
     {
-        msg->cmd = PIO_SpecialCycle;
+        msg.cmd = PIO_SpecialCycle;
     }
 
     /*
      * The type that each bit in the mask represents is determined by the
      * command sent from the CPU.
      */
-    msg->ldp = NoLDP;
-    msg->c = NoCSR;
+    msg.ldp = NoLDP;
+    msg.c = NoCSR;
     switch (rq->cmd)
     {
         case WrBytes:
-            msg->maskType = CAPbus_Byte;
-            memcpy(msg->data, rq->sysData, (sizeof(u8) * AXP_21274_DATA_SIZE));
+            msg.maskType = CAPbus_Byte;
+            memcpy(msg.data, rq->sysData, (sizeof(u8) * AXP_21274_DATA_SIZE));
             break;
 
         case WrLWs:
-            msg->maskType = CAPbus_Lowngword;
-            memcpy(msg->data, rq->sysData, (sizeof(u32) * AXP_21274_DATA_SIZE));
+            msg.maskType = CAPbus_Lowngword;
+            memcpy(msg.data, rq->sysData, (sizeof(u32) * AXP_21274_DATA_SIZE));
             break;
 
         case WrQWs:
-            if (msg->cmd == CSR_Write)
+            if (msg.cmd == CSR_Write)
             {
                 AXP_21274_CSR_ADDR csrNum =
                 {
                     .addr = rq->pa
                 };
 
-                msg->ldp = LoadP_SGTERead;
-                msg->c = PchipCSR;
-                msg->csr = csrNum.csr;
-                msg->maskType = CAPbus_NoMask;
-                msg->data[0] = rq->sysData[0];
+                msg.ldp = LoadP_SGTERead;
+                msg.c = PchipCSR;
+                msg.csr = csrNum.csr;
+                msg.maskType = CAPbus_NoMask;
+                msg.data[0] = rq->sysData[0];
             }
             else
             {
-                msg->maskType = CAPbus_Quadword;
-                memcpy(msg->data,
+                msg.maskType = CAPbus_Quadword;
+                memcpy(msg.data,
                        rq->sysData,
                        (sizeof(u64) * AXP_21274_DATA_SIZE));
             }
@@ -965,31 +1013,25 @@ static void AXP_21274_WritePchip(AXP_21274_SYSTEM *sys, AXP_21274_RQ_ENTRY *rq)
     /*
      * Set the mask from the CPU.
      */
-    msg->mask = rq->mask;
+    msg.mask = rq->mask;
 
     /*
      * Address<34:3>
      */
-    if (msg->cmd == CSR_Write)
+    if (msg.cmd == CSR_Write)
     {
-        msg->addr = 0;
+        msg.addr = 0;
     }
     else
     {
-        msg->addr = (rq->pa & 0x000000007FFFFFFF8) >> 3;
+        msg.addr = (rq->pa & 0x000000007FFFFFFF8) >> 3;
     }
 
     /*
-     * Queue this up to the Pchip and then notify the Pchip it has something to
-     * process.
+     * Queue this up to the Pchip, which will notify the Pchip it has something
+     * to process.
      */
-    AXP_INSQUE(p->tpr.blink, &msg->header);
-
-    /*
-     * Notify the Pchip tat there is something to process.
-     */
-    pthread_cond_signal(&p->cond);
-    pthread_mutex_unlock(&p->mutex);
+    AXP_21274_PchipQueue(p, &msg);
 
     /*
      * Return back to the caller
@@ -1039,6 +1081,10 @@ static void AXP_21274_WritePIO(AXP_21274_SYSTEM *sys,
         rsp->sysDc = WriteData;
         rsp->id = rq->entry;
     }
+    else if (AXP_21274_ConsolePIO(rq, rsp) == true)
+    {
+        /* Handled against the console port's rings */
+    }
     else if (AXP_21274_LINEAR_MEMORY(rq->pa) ||
              AXP_21274_LINEAR_IO(rq->pa) ||
              AXP_21274_LINEAR_CFG(rq->pa) ||
@@ -1245,6 +1291,413 @@ static void AXP_21274_WriteTIG(AXP_21274_SYSTEM *sys,
     return;
 }
 
+/*
+ * AXP_21274_ConsolePIO
+ *  This function is called on an I/O read or write command to determine if it
+ *  is a byte access to one of the console port registers in Pchip0's PCI I/O
+ *  space, and if so, to read or write the registers for each byte in the mask.
+ *  The console ports never block, so there is no need to queue these to the
+ *  Pchip.
+ *
+ * Input Parameters:
+ *  rq:
+ *      A pointer to the request to be processed.
+ *
+ * Output Parameters:
+ *  rsp:
+ *      A pointer to the structure to contain the response to send back to the
+ *      CPU that send the request.
+ *
+ * Return Value:
+ *  true:   The request was for the console ports and has been processed.
+ *  false:  The request was not for the console ports.
+ */
+static bool AXP_21274_ConsolePIO(AXP_21274_RQ_ENTRY *rq,
+                                 AXP_21274_SYSBUS_CPU *rsp)
+{
+    AXP_CONSOLE_PORT *port;
+    u8 *rqData = (u8 *) rq->sysData;
+    u8 *rspData = (u8 *) rsp->sysData;
+    u32 ioAddr = (u32) (rq->pa & AXP_21274_IO_MASK & ~0x7ll);
+    u32 reg;
+    int ii;
+    bool retVal = false;
+
+    if (AXP_21274_LINEAR_IO(rq->pa) &&
+        (AXP_21274_WHICH_PCHIP(rq->pa) == 0) &&
+        ((rq->cmd == ReadBytes) || (rq->cmd == WrBytes)))
+    {
+        if (rq->cmd == ReadBytes)
+        {
+            rsp->sysData[0] = 0;
+        }
+        for (ii = 0; ii < sizeof(u64); ii++)
+        {
+            port = AXP_Console_Port(ioAddr + ii);
+            if (((rq->mask & (1 << ii)) != 0) && (port != NULL))
+            {
+                reg = ioAddr + ii - port->base;
+                if (rq->cmd == ReadBytes)
+                {
+                    rspData[ii] = AXP_Console_ReadPort(port, reg);
+                }
+                else
+                {
+                    AXP_Console_WritePort(port, reg, rqData[ii]);
+                }
+                retVal = true;
+            }
+        }
+    }
+    if (retVal == true)
+    {
+        rsp->sysDc = (rq->cmd == ReadBytes) ? ReadData : WriteData;
+        rsp->id = rq->entry;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * AXP_21274_DeviceInterrupt
+ *  This function is called with the state of a device interrupt line, either
+ *  from a PCI device through its Pchip, or from the console ports.  The bit in
+ *  DRIR is updated without a lock, and only when it is first set are the CPUs,
+ *  whose mask allows it, interrupted.  When it is cleared, the Cchip main loop
+ *  is woken up to redo the IRQ_H bits.  A CPU that takes IRQ<1> also has the
+ *  main loop redo them, which posts IRQ<1> again while the line is asserted.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the system data structure from which the emulation
+ *      information is maintained.
+ *  irq:
+ *      A value indicating the DRIR bit for the interrupt line.
+ *  level:
+ *      A boolean indicating whether the interrupt line is asserted.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_DeviceInterrupt(void *arg, u32 irq, bool level)
+{
+    AXP_21274_SYSTEM *sys = (AXP_21274_SYSTEM *) arg;
+    const u64 irqBit = 1ll << irq;
+    u64 dim[AXP_21274_MAX_CPUS] = {sys->dim0, sys->dim1, sys->dim2, sys->dim3};
+    u32 ii;
+
+    if (level == false)
+    {
+        if ((__atomic_fetch_and(&sys->drir, ~irqBit, __ATOMIC_ACQ_REL) &
+             irqBit) != 0)
+        {
+            __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
+            pthread_mutex_lock(&sys->cChipMutex);
+            pthread_cond_signal(&sys->cChipCond);
+            pthread_mutex_unlock(&sys->cChipMutex);
+        }
+    }
+    else if ((__atomic_fetch_or(&sys->drir, irqBit, __ATOMIC_ACQ_REL) &
+              irqBit) == 0)
+    {
+        __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
+        for (ii = 0; ii < sys->cpuCount; ii++)
+        {
+            if ((dim[ii] & irqBit) != 0)
+            {
+                AXP_21264_InterruptToCPU(2, &sys->cpu[ii]);
+            }
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_ConsoleInterrupt
+ *  This function is called by the console ports, from either the Cchip or the
+ *  TELNET server, with the state of their interrupt line, which is the
+ *  PCI-ISA bridge bit in DRIR.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the system data structure from which the emulation
+ *      information is maintained.
+ *  level:
+ *      A boolean indicating whether the interrupt line is asserted.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_ConsoleInterrupt(void *arg, bool level)
+{
+    AXP_21274_DeviceInterrupt(arg, AXP_21274_DRIR_ISA, level);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PchipComplete
+ *  This function is called by a Pchip thread when it has completed a read
+ *  request that was queued to it by AXP_21274_ReadPchip.  The data read is
+ *  sent to the CPU that requested it.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the system data structure from which the emulation
+ *      information is maintained.
+ *  msg:
+ *      A pointer to the completed request, containing the data read.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PchipComplete(void *arg, AXP_CAPbusMsg *msg)
+{
+    AXP_21274_SYSTEM *sys = (AXP_21274_SYSTEM *) arg;
+    AXP_21274_SYSBUS_CPU rsp;
+
+    memset(&rsp, 0, sizeof(rsp));
+    memcpy(rsp.sysData, msg->data, sizeof(rsp.sysData));
+    rsp.sysDc = ReadData;
+    rsp.id = msg->id;
+    AXP_21264_SendToCPU(&rsp, &sys->cpu[msg->cpuID & 0x3]);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PchipInvalidate
+ *  This function is called by a Pchip thread after a DMA has written to
+ *  memory.  A probe, that invalidates the block and moves no data, is sent
+ *  for each 64-byte block written to each of the CPUs that have probes
+ *  enabled in PRBEN, so that they do not go on using stale copies of it.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the system data structure from which the emulation
+ *      information is maintained.
+ *  pa:
+ *      A value containing the physical address of the first byte written.
+ *  len:
+ *      A value indicating the number of bytes written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PchipInvalidate(void *arg, u64 pa, u32 len)
+{
+    AXP_21274_SYSTEM *sys = (AXP_21274_SYSTEM *) arg;
+    AXP_21274_PRBEN prbEn = sys->prbEn;
+    AXP_21274_SYSBUS_CPU rsp;
+    u64 end = pa + len;
+    u32 enabled;
+    u32 ii;
+
+    enabled = prbEn.prben0 |
+              (prbEn.prben1 << 1) |
+              (prbEn.prben2 << 2) |
+              (prbEn.prben3 << 3);
+    memset(&rsp, 0, sizeof(rsp));
+    rsp.cmd = NOP_Invalid;
+    rsp.sysDc = SysDC_Nop;
+    rsp.probe = true;
+    for (rsp.pa = pa & ~0x3fll; rsp.pa < end; rsp.pa += sizeof(rsp.sysData))
+    {
+        for (ii = 0; ii < sys->cpuCount; ii++)
+        {
+            if ((enabled & (1 << ii)) != 0)
+            {
+                AXP_21264_SendToCPU(&rsp, &sys->cpu[ii]);
+            }
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_UpdateIRQ
+ *  This function is called by the Cchip main loop, when one of MISC, DIMn, or
+ *  DRIR has changed, to determine the IRQ_H bits for each of the CPUs.  The
+ *  bits that are no longer asserted are cleared, and the ones that are, are
+ *  posted to the CPU.  The CPU is only woken up when a new bit gets set.
+ *
+ * Input Parameters:
+ *  sys:
+ *      A pointer to the system data structure from which the emulation
+ *      information is maintained.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_UpdateIRQ(AXP_21274_SYSTEM *sys)
+{
+    u64 dir;
+    u32 ii;
+    u8 irqH;
+    u8 cpuBit;
+
+    for(ii = 0; ii < sys->cpuCount; ii++)
+    {
+        irqH = 0;
+        cpuBit = 1 << ii;
+
+        /*
+         * If NXM is set or TIG interrupt bits 62 or 61 (Pchip0 and Pchip1,
+         * respectively) are set, then IRQ<0> is set.
+         */
+        if (sys->misc.nxm == 1)
+        {
+            irqH |= 1;
+        }
+
+        /*
+         * DRIR is ANDed with the CPU specific MASK bits DIRn and if the
+         * result is non-zero, then IRQ<1> is set.  If DEVSUP is set for
+         * this CPU, then setting of this bit is suppressed for this cycle.
+         */
+        if ((sys->misc.devSup & cpuBit) == 0)
+        {
+
+            /*
+             * Determine which mask to use for this CPU.
+             */
+            switch (ii)
+            {
+                case 0:
+                    AXP_CCHIP_READ_DIR0(dir, sys);
+                    break;
+
+                case 1:
+                    AXP_CCHIP_READ_DIR1(dir, sys);
+                    break;
+
+                case 2:
+                    AXP_CCHIP_READ_DIR2(dir, sys);
+                    break;
+
+                default:
+                    AXP_CCHIP_READ_DIR3(dir, sys);
+                    break;
+            }
+            if ((__atomic_load_n(&sys->drir, __ATOMIC_ACQUIRE) & dir) != 0)
+            {
+                irqH |= 2;
+            }
+        }
+
+        /*
+         * If ITINTR is set for this CPU, then IRQ<2> is set.
+         */
+        if ((sys->misc.itintr & cpuBit) == cpuBit)
+        {
+            irqH |= 4;
+        }
+
+        /*
+         * If IPINTR is set for this CPU, then IRQ<3> is set.
+         */
+        if ((sys->misc.ipintr & cpuBit) == cpuBit)
+        {
+            irqH |= 8;
+        }
+
+        /*
+         * Clear the bits that are no longer asserted, then post the ones that
+         * are.  The CPU will only be signaled if one of them is new.
+         */
+        __atomic_fetch_and(sys->cpu[ii].irq_H,
+                           (u8) ~(0x0f & ~irqH),
+                           __ATOMIC_SEQ_CST);
+        if (irqH != 0)
+        {
+            AXP_21264_InterruptToCPU(irqH, &sys->cpu[ii]);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_CheckIRQ
+ *  This function is called by the Cchip main loop, after it has processed a
+ *  request or when it has been woken up without one, to redo the IRQ_H bits
+ *  for each of the CPUs, but only when something that routes them has
+ *  changed.
+ *
+ * Input Parameters:
+ *  sys:
+ *      A pointer to the system data structure from which the emulation
+ *      information is maintained.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_CheckIRQ(AXP_21274_SYSTEM *sys)
+{
+    if (__atomic_exchange_n(&sys->irqUpdate, false, __ATOMIC_SEQ_CST))
+    {
+        AXP_21274_UpdateIRQ(sys);
+
+        /*
+         * Clear the bits that indicated an interrupt needed to be sent or
+         * suppressed to the CPUs.  If any of them were set, then the IRQ
+         * bits will need to be redone the next time through.
+         */
+        if ((sys->misc.devSup != 0) ||
+            (sys->misc.itintr != 0) ||
+            (sys->misc.ipreq != 0))
+        {
+            sys->misc.devSup = 0;
+            sys->misc.itintr = 0;
+            sys->misc.ipreq = 0;
+            __atomic_store_n(&sys->irqUpdate, true, __ATOMIC_SEQ_CST);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
 /*
  * AXP_21274_CchipInit
  *  This function is called to initialize the Cchip CSRs as documented in HRM
@@ -1448,6 +1901,19 @@ void AXP_21274_CchipInit(AXP_21274_SYSTEM *sys)
      * Initialization for DRIR (HRM Table 10-18)
      */
     sys->drir = AXP_DRIR_INTR_NONE;
+    AXP_Console_Init(AXP_21274_ConsoleInterrupt, sys);
+    sys->p0.irq = AXP_21274_DeviceInterrupt;
+    sys->p0.irqArg = sys;
+    sys->p1.irq = AXP_21274_DeviceInterrupt;
+    sys->p1.irqArg = sys;
+    sys->p0.complete = AXP_21274_PchipComplete;
+    sys->p0.completeArg = sys;
+    sys->p1.complete = AXP_21274_PchipComplete;
+    sys->p1.completeArg = sys;
+    sys->p0.invalidate = AXP_21274_PchipInvalidate;
+    sys->p0.invalidateArg = sys;
+    sys->p1.invalidate = AXP_21274_PchipInvalidate;
+    sys->p1.invalidateArg = sys;
 
     /*
      * Initialization for PRBEN (HRM Table 10-19)
@@ -1617,7 +2083,8 @@ void AXP_21274_CchipInit(AXP_21274_SYSTEM *sys)
         {
             for (jj = 0; jj < AXP_21274_DATA_SIZE; jj++)
             {
-                sys->skidBuffers[ii].sysData[jj] = 0;
+                sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].sysData[jj] =
+                    0;
             }
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].mask = 0;
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].pa = 0;
@@ -1630,11 +2097,13 @@ void AXP_21274_CchipInit(AXP_21274_SYSTEM *sys)
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].cpuID = 0;
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].sysDataLen = 0;
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].waitVector = 0;
+            sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].miss1 = false;
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].miss2 = false;
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].rqValid =
                 false;
             sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].cacheHit =
                 false;
+            sys->skidBuffers[(hh * AXP_21274_CCHIP_RQ_LEN) + ii].inUse = false;
         }
     }
 
@@ -1666,7 +2135,6 @@ void *AXP_21274_CchipMain(void *voidPtr)
     AXP_21274_SYSTEM *sys = (AXP_21274_SYSTEM *) voidPtr;
     AXP_21274_RQ_ENTRY *rq;
     AXP_21274_SYSBUS_CPU rsp;
-    int ii;
 
     /*
      * Log that we are starting.
@@ -1707,11 +2175,22 @@ void *AXP_21274_CchipMain(void *voidPtr)
          *     including those that represent interrupt status
          *
          * This first thing we need to do is wait for something to arrive to be
-         * processed.
+         * processed.  We are also woken up, with nothing to process, when the
+         * IRQ_H bits need to be redone.  This is done without the Cchip mutex
+         * locked, as it is when processing a request.
          */
         while AXP_QUE_EMPTY(sys->skidBufferQ)
         {
-            pthread_cond_wait(&sys->cChipCond, &sys->cChipMutex);
+            if (__atomic_load_n(&sys->irqUpdate, __ATOMIC_SEQ_CST) == true)
+            {
+                pthread_mutex_unlock(&sys->cChipMutex);
+                AXP_21274_CheckIRQ(sys);
+                pthread_mutex_lock(&sys->cChipMutex);
+            }
+            else
+            {
+                pthread_cond_wait(&sys->cChipCond, &sys->cChipMutex);
+            }
         }
 
         /*
@@ -1729,8 +2208,11 @@ void *AXP_21274_CchipMain(void *voidPtr)
 
         /*
          * Determine what has been requested and make the call needed to
-         * complete request.
+         * complete request.  A request that is completed here fills in the
+         * response, and one that is queued to a Pchip leaves it as a no-op,
+         * to be sent when the Pchip has completed it.
          */
+        memset(&rsp, 0, sizeof(rsp));
         switch (rq->cmd)
         {
 
@@ -1821,153 +2303,40 @@ void *AXP_21274_CchipMain(void *voidPtr)
             case InvalToDirty:
                 break;
         }
+        if (rsp.sysDc != SysDC_Nop)
+        {
+            AXP_21264_SendToCPU(&rsp, &sys->cpu[rq->cpuID & 0x3]);
+        }
 
         /*
          * Before we go back to see if there is anything to process, let's make
-         * sure the IRQ bits are set accordingly.  If they change, then the
-         * appropriate CPU should be signaled.
+         * sure the IRQ bits are set accordingly, but only when something that
+         * routes them has changed.
          */
-        for(ii = 0; ii < sys->cpuCount; ii++)
-        {
-            u8 curIrqH;
-            u8 cpuBit = 1 << ii;
-
-            /*
-             * Don't let the CPU try and read or modify the IRQ_H bits until we
-             * are done setting them.
-             */
-            pthread_mutex_lock(sys->cpu[ii].mutex);
-
-            /*
-             * Save the current value of the IRQ_H bits.
-             */
-            curIrqH = *sys->cpu[ii].irq_H;
-
-            /*
-             * If NXM is set or TIG interrupt bits 62 or 61 (Pchip0 and Pchip1,
-             * respectively) are set, then IRQ<0> is set.
-             */
-            if (sys->misc.nxm == 1)
-            {
-                *sys->cpu[ii].irq_H |= 1;
-            }
-            else
-            {
-                *sys->cpu[ii].irq_H &= 0xfe;
-            }
-
-            /*
-             * DRIR is ANDed with the CPU specific MASK bits DIRn and if the
-             * result is non-zero, then IRQ<1> is set.  If DEVSUP is set for
-             * this CPU, then setting of this bit is suppressed for this cycle.
-             */
-            if ((sys->misc.devSup & cpuBit) == 0)
-            {
-                bool setBit = false;
-                u64 dir;
-
-                /*
-                 * Determine which mask to use and determine if the IRQ<1> bit
-                 * for this CPU should be set.
-                 */
-                switch (ii)
-                {
-                    case 0:
-                        AXP_CCHIP_READ_DIR0(dir, sys);
-                        setBit = (sys->drir & dir) != 0;
-                        break;
-
-                    case 1:
-                        AXP_CCHIP_READ_DIR1(dir, sys);
-                        setBit = (sys->drir & dir) != 0;
-                        break;
-
-                    case 2:
-                        AXP_CCHIP_READ_DIR2(dir, sys);
-                        setBit = (sys->drir & dir) != 0;
-                        break;
-
-                    case 3:
-                        AXP_CCHIP_READ_DIR3(dir, sys);
-                        setBit = (sys->drir & dir) != 0;
-                        break;
-                }
-
-                /*
-                * If the bit should be set, then do so now.
-                */
-                if (setBit)
-                {
-                    *sys->cpu[ii].irq_H |= 2;
-                }
-                else
-                {
-                    *sys->cpu[ii].irq_H &= 0xfd;
-                }
-            }
-            else
-            {
-
-                /*
-                 * Clear the IRQ<1> bit for this CPU.
-                 */
-                *sys->cpu[ii].irq_H &= 0xfd;
-            }
-
-            /*
-             * If ITINTR is set for this CPU, then IRQ<2> is set.
-             */
-            if ((sys->misc.itintr & cpuBit) == cpuBit)
-            {
-                *sys->cpu[ii].irq_H |= 4;
-            }
-            else
-            {
-                *sys->cpu[ii].irq_H &= 0xfb;
-            }
-
-            /*
-             * If IPINTR is set for this CPU, then IRQ<3> is set.
-             */
-            if ((sys->misc.ipintr & cpuBit) == cpuBit)
-            {
-                *sys->cpu[ii].irq_H |= 8;
-            }
-            else
-            {
-                *sys->cpu[ii].irq_H &= 0xf7;
-            }
-
-            /*
-             * Finally, if the IRQ_H bit changed, then we need to signal the
-             * CPU to process them.
-             */
-            if (curIrqH != *sys->cpu[ii].irq_H)
-            {
-                pthread_cond_signal(sys->cpu[ii].cond);
-            }
-
-            /*
-             * OK, we are done with this CPU, unlock its mutex and move onto
-             * the next.
-             */
-            pthread_mutex_unlock(sys->cpu[ii].mutex);
-        }
+        AXP_21274_CheckIRQ(sys);
 
         /*
-         * Clear the bits that indicated an interrupt needed to be sent or
-         * suppressed to the CPUs.
+         * The skid buffer can now be reused by the CPU that filled it in.  If
+         * that CPU found all its skid buffers in use, its Cbox is holding its
+         * requests until one is released, and has said so.  The Cbox holds
+         * its interface mutex from when it found them in use until it waits,
+         * so locking it here makes sure the signal is not lost.
          */
-        sys->misc.devSup = 0;
-        sys->misc.itintr = 0;
-        sys->misc.ipreq = 0;
+        __atomic_store_n(&rq->inUse, false, __ATOMIC_SEQ_CST);
+        if (__atomic_exchange_n(sys->cpu[rq->cpuID & 0x3].skidWait,
+                                false,
+                                __ATOMIC_SEQ_CST) == true)
+        {
+            pthread_mutex_lock(sys->cpu[rq->cpuID & 0x3].mutex);
+            pthread_cond_signal(sys->cpu[rq->cpuID & 0x3].cond);
+            pthread_mutex_unlock(sys->cpu[rq->cpuID & 0x3].mutex);
+        }
 
         /*
          * At this point, we have to relock the Cchip mutex so that other
          * threads don't interrupt the Cchip while it is using memory that is
          * accessed and potentially updated by other threads.
          */
-        rq->inUse = false;
         pthread_mutex_lock(&sys->cChipMutex);
     }
 
@@ -23,6 +23,13 @@
  *
  *  V01.000 30-Mar2018  Jonathan D. Belanger
  *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Interrupts are posted with an atomic OR, and the CPU is only signaled when
+ *  new bits were set and its Cbox is waiting.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  The probe request in the message is now passed on to the CPU.
  */
 #include "Motherboard/Cchip/CPUInterface/AXP_21274_21264_Common.h"
 #include "CommonUtilities/AXP_Utility.h"
@@ -66,6 +73,7 @@ void AXP_21264_SendToCPU(AXP_21274_SYSBUS_CPU *msg, AXP_21274_CPU *cpu)
     pq->pa = msg->pa;
     pq->sysDc = msg->sysDc;
     pq->probeStatus = HitClean; /* Just initializing */
+    pq->probe = (msg->probe == true) ? msg->cmd : NOP_NOP;
     pq->rvb = msg->rvb;
     pq->rpb = msg->rpb;
     pq->a = msg->a;
@@ -117,8 +125,12 @@ void AXP_21264_SendToCPU(AXP_21274_SYSBUS_CPU *msg, AXP_21274_CPU *cpu)
 /*
  * AXP_21274_InterruptToCPU
  *  This function is called with a pointer to the irq_H bits and a pointer
- *  to the CPU structure, and updates the equivalent field in the CPU, locking
- *  the correct mutex and signaling the correct condition variable.
+ *  to the CPU structure, and updates the equivalent field in the CPU.  The
+ *  bits are set without a lock.  The CPU's mutex is only locked, to signal its
+ *  condition variable, when a bit that was not already pending has been set
+ *  and the Cbox is waiting for something to do.  The Cbox sets its sleeping
+ *  flag before it looks at the IRQ_H bits one last time, so either it sees
+ *  the new bits or we see the flag.
  *
  * Input Parameters:
  *   irq_H:
@@ -128,29 +140,25 @@ void AXP_21264_SendToCPU(AXP_21274_SYSBUS_CPU *msg, AXP_21274_CPU *cpu)
  */
 void AXP_21264_InterruptToCPU(u8 irq_H, AXP_21274_CPU *cpu)
 {
-
-    /*
-     * Lock the mutex so that no one else tries to manipulate the queue or the
-     * index into it.
-     */
-    pthread_mutex_lock(cpu->mutex);
+    u8 prev;
 
     /*
      * This function only sets flags, it does not clear them.  Therefore, OR
      * the bits we want to set with the bits that are already set.
      */
-    *cpu->irq_H |= irq_H;
+    prev = __atomic_fetch_or(cpu->irq_H, irq_H, __ATOMIC_SEQ_CST);
 
     /*
-     * OK, we are done here.  Signal the CPU that it has something to process.
-     */
-    pthread_cond_signal(cpu->cond);
-
-    /*
-     * Unlock the CPU's interface Mutex, so that the CPU can process the
-     * interrupts we just set.
+     * If there is something new, and the Cbox is waiting, signal it that it
+     * has something to process.
      */
-    pthread_mutex_unlock(cpu->mutex);
+    if (((prev & irq_H) != irq_H) &&
+        (__atomic_load_n(cpu->sleeping, __ATOMIC_SEQ_CST) == true))
+    {
+        pthread_mutex_lock(cpu->mutex);
+        pthread_cond_signal(cpu->cond);
+        pthread_mutex_unlock(cpu->mutex);
+    }
 
     /*
      * Return back to the caller.
@@ -0,0 +1,824 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This source file contains the PCI bus behind each Pchip.  PCI devices
+ *  register themselves, in a slot, on the bus.  The Pchip maintains each
+ *  device's configuration space, and keeps an index of the BARs that have
+ *  been programmed and enabled, so that the PIO requests from the CPUs can be
+ *  passed to the device that owns the address.
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  The indexes that have been replaced are freed by the Pchip thread, once it
+ *  has finished a batch of requests.  A byte request is now a cycle for each
+ *  run of contiguous bytes in the mask, rather than assuming there was only
+ *  one.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added peer-to-peer memory reads and writes, from a PCI device on the other
+ *  Pchip's bus.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_Blocks.h"
+#include "CommonUtilities/AXP_PCI.h"
+#include "Motherboard/AXP_21274_System.h"
+#include "Motherboard/Pchip/AXP_21274_Pchip.h"
+
+/*
+ * The address spaces a PIO request can be to.
+ */
+typedef enum
+{
+    PCIMemory,
+    PCIIO,
+    PCIConfig
+} AXP_PCI_SPACE;
+
+/*
+ * Local Prototypes
+ */
+static int AXP_21274_PCIRangeCmp(const void *, const void *);
+static void AXP_21274_PCIIndex(AXP_21274_PCHIP *);
+static AXP_PCI_RANGE *AXP_21274_PCILookup(AXP_PCI_INDEX *, u64);
+static void AXP_21274_PCIConfigWrite(AXP_21274_PCHIP *,
+                                     AXP_PCI_DEVICE *,
+                                     u32,
+                                     u8 *,
+                                     u32);
+static void AXP_21274_PCICycle(AXP_21274_PCHIP *,
+                               AXP_PCI_SPACE,
+                               u64,
+                               u8 *,
+                               u32,
+                               bool);
+
+/*
+ * AXP_21274_PCIRangeCmp
+ *  This function is called by qsort to order the ranges in an index by their
+ *  base address.
+ *
+ * Input Parameters:
+ *  a:
+ *      A pointer to the first range to be compared.
+ *  b:
+ *      A pointer to the second range to be compared.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  <0: The first range is below the second.
+ *  0:  The ranges start at the same address.
+ *  >0: The first range is above the second.
+ */
+static int AXP_21274_PCIRangeCmp(const void *a, const void *b)
+{
+    const AXP_PCI_RANGE *rangeA = (const AXP_PCI_RANGE *) a;
+    const AXP_PCI_RANGE *rangeB = (const AXP_PCI_RANGE *) b;
+    int retVal = 0;
+
+    if (rangeA->base < rangeB->base)
+    {
+        retVal = -1;
+    }
+    else if (rangeA->base > rangeB->base)
+    {
+        retVal = 1;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21274_PCIIndex
+ *  This function is called, with the PCI mutex locked, after a BAR or command
+ *  register has been written, to rebuild the memory and I/O indexes.  Each
+ *  BAR that has a non-zero base address, and whose space is enabled in the
+ *  command register, is put in the index for its space.  The new indexes are
+ *  then swapped in for the old ones, which are kept behind the new ones until
+ *  AXP_21274_PCIRetire frees them.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PCIIndex(AXP_21274_PCHIP *p)
+{
+    AXP_PCI_INDEX *memIndex;
+    AXP_PCI_INDEX *ioIndex;
+    AXP_PCI_INDEX *index;
+    AXP_PCI_DEVICE *dev;
+    AXP_PCI_DEV_CTRL devCtrl;
+    AXP_BAR bar;
+    u64 base;
+    int ii, jj;
+
+    memIndex = AXP_Allocate_Block(-(i32) sizeof(AXP_PCI_INDEX), NULL);
+    ioIndex = AXP_Allocate_Block(-(i32) sizeof(AXP_PCI_INDEX), NULL);
+    if ((memIndex != NULL) && (ioIndex != NULL))
+    {
+        for (ii = 0; ii < AXP_PCI_MAX_SLOTS; ii++)
+        {
+            dev = p->pciDev[ii];
+            if (dev != NULL)
+            {
+                devCtrl.devCtrl = dev->cfg.devCtrl;
+                for (jj = 0; jj < AXP_PCI_MAX_BARS; jj++)
+                {
+                    bar.baseAddrReg = dev->cfg.baseAddrReg[jj];
+                    if (bar.io.ioSpaceInd == 1)
+                    {
+                        base = bar.baseAddrReg & ~0x3ll;
+                        index = (devCtrl.ioSpace == 1) ? ioIndex : NULL;
+                    }
+                    else
+                    {
+                        base = bar.baseAddrReg & ~0xfll;
+                        index = (devCtrl.memSpace == 1) ? memIndex : NULL;
+                    }
+                    if ((index != NULL) &&
+                        (dev->barSize[jj] != 0) &&
+                        (base != 0))
+                    {
+                        index->range[index->count].base = base;
+                        index->range[index->count].limit =
+                            base + dev->barSize[jj] - 1;
+                        index->range[index->count].dev = dev;
+                        index->range[index->count].bar = jj;
+                        index->count++;
+                    }
+                }
+            }
+        }
+        qsort(memIndex->range,
+              memIndex->count,
+              sizeof(AXP_PCI_RANGE),
+              AXP_21274_PCIRangeCmp);
+        qsort(ioIndex->range,
+              ioIndex->count,
+              sizeof(AXP_PCI_RANGE),
+              AXP_21274_PCIRangeCmp);
+
+        /*
+         * Publish the new indexes.  A lookup that already has the old one can
+         * keep using it.
+         */
+        memIndex->prev = p->memIndex;
+        ioIndex->prev = p->ioIndex;
+        __atomic_store_n(&p->memIndex, memIndex, __ATOMIC_RELEASE);
+        __atomic_store_n(&p->ioIndex, ioIndex, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        if (memIndex != NULL)
+        {
+            AXP_Deallocate_Block(memIndex);
+        }
+        if (ioIndex != NULL)
+        {
+            AXP_Deallocate_Block(ioIndex);
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PCILookup
+ *  This function is called to find the range in an index that contains an
+ *  address.  The ranges are sorted by base address, so this is a binary
+ *  search for the last range starting at or below the address.
+ *
+ * Input Parameters:
+ *  index:
+ *      A pointer to the index to be searched.  This may be NULL.
+ *  addr:
+ *      A value containing the PCI address to be looked up.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  NULL:   No device has a BAR containing the address.
+ *  !NULL:  A pointer to the range containing the address.
+ */
+static AXP_PCI_RANGE *AXP_21274_PCILookup(AXP_PCI_INDEX *index, u64 addr)
+{
+    AXP_PCI_RANGE *retVal = NULL;
+    u32 low = 0;
+    u32 high;
+    u32 mid;
+
+    if (index != NULL)
+    {
+        high = index->count;
+        while (low < high)
+        {
+            mid = (low + high) / 2;
+            if (index->range[mid].base <= addr)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        if ((low > 0) && (addr <= index->range[low - 1].limit))
+        {
+            retVal = &index->range[low - 1];
+        }
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21274_PCIConfigWrite
+ *  This function is called to write to a device's configuration space.  Only
+ *  the command register, the BARs, and the interrupt line can be written.  A
+ *  BAR only keeps the bits above its size, so that writing all ones to it
+ *  returns the size when it is read back, and keeps its type bits.  When the
+ *  command register or a BAR is written, the indexes are rebuilt.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  dev:
+ *      A pointer to the device whose configuration space is being written.
+ *  reg:
+ *      A value indicating the offset into the configuration space.
+ *  buf:
+ *      A pointer to the data to be written.
+ *  len:
+ *      A value indicating the number of bytes to be written.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PCIConfigWrite(AXP_21274_PCHIP *p,
+                                     AXP_PCI_DEVICE *dev,
+                                     u32 reg,
+                                     u8 *buf,
+                                     u32 len)
+{
+    u8 *cfg = (u8 *) &dev->cfg;
+    u32 dword;
+    u32 oldValue;
+    u32 newValue;
+    u32 typeMask;
+    u32 chunk;
+    u32 bar;
+    bool reindex = false;
+
+    pthread_mutex_lock(&p->pciMutex);
+    while ((len > 0) && (reg < sizeof(AXP_PCI_CFG)))
+    {
+
+        /*
+         * Merge the bytes being written into the dword that contains them.
+         */
+        dword = reg & ~0x3;
+        chunk = 4 - (reg & 0x3);
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        memcpy(&oldValue, &cfg[dword], sizeof(u32));
+        newValue = oldValue;
+        memcpy(&((u8 *) &newValue)[reg & 0x3], buf, chunk);
+
+        /*
+         * Now only keep the bits that can be written.
+         */
+        switch (dword)
+        {
+            case AXP_PCI_CFG_CMD:
+                newValue = (oldValue & 0xffff0000) | (newValue & 0x0000ffff);
+                reindex = true;
+                break;
+
+            case AXP_PCI_CFG_INTLINE:
+                newValue = (oldValue & 0xffffff00) | (newValue & 0x000000ff);
+                break;
+
+            default:
+                if ((dword >= AXP_PCI_CFG_BAR0) && (dword <= AXP_PCI_CFG_BAR5))
+                {
+                    bar = (dword - AXP_PCI_CFG_BAR0) / sizeof(u32);
+                    typeMask = ((oldValue & 1) == 1) ? 0x3 : 0xf;
+                    if (dev->barSize[bar] != 0)
+                    {
+                        newValue = (newValue &
+                                    ~(dev->barSize[bar] - 1) &
+                                    ~typeMask) |
+                                   (oldValue & typeMask);
+                    }
+                    else
+                    {
+                        newValue = 0;
+                    }
+                    reindex = true;
+                }
+                else
+                {
+                    newValue = oldValue;
+                }
+                break;
+        }
+        memcpy(&cfg[dword], &newValue, sizeof(u32));
+        reg += chunk;
+        buf += chunk;
+        len -= chunk;
+    }
+    if (reindex == true)
+    {
+        AXP_21274_PCIIndex(p);
+    }
+    pthread_mutex_unlock(&p->pciMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PCICycle
+ *  This function is called to perform a single read or write on the PCI bus.
+ *  A configuration cycle is to the configuration space of the device in the
+ *  slot indicated by the IDSEL bits of the address.  Only bus 0, function 0
+ *  is supported.  A memory or I/O cycle is looked up in the index for that
+ *  space, and passed to the device that owns it.  A read that no device
+ *  responds to returns all ones, and a write is dropped.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  space:
+ *      A value indicating the address space being accessed.
+ *  addr:
+ *      A value containing the address within the space.
+ *  buf:
+ *      A pointer to the data to be written, when write is true.
+ *  len:
+ *      A value indicating the number of bytes to be transferred.
+ *  write:
+ *      A boolean indicating that this is a write cycle.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the location to receive the data read, when write is
+ *      false.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PCICycle(AXP_21274_PCHIP *p,
+                               AXP_PCI_SPACE space,
+                               u64 addr,
+                               u8 *buf,
+                               u32 len,
+                               bool write)
+{
+    AXP_PCI_DEVICE *dev = NULL;
+    AXP_PCI_RANGE *range = NULL;
+    u64 value = AXP_PCI_NO_DEVICE;
+    u32 slot;
+    u32 reg;
+
+    switch (space)
+    {
+        case PCIConfig:
+            slot = (addr >> 11) & 0x1f;
+            reg = addr & 0xff;
+            if (((addr & 0x00ff0700) == 0) && (slot < AXP_PCI_MAX_SLOTS))
+            {
+                dev = __atomic_load_n(&p->pciDev[slot], __ATOMIC_ACQUIRE);
+            }
+            if (dev != NULL)
+            {
+                if (write == true)
+                {
+                    AXP_21274_PCIConfigWrite(p, dev, reg, buf, len);
+                }
+                else
+                {
+                    value = 0;
+                    if ((reg + len) <= sizeof(AXP_PCI_CFG))
+                    {
+                        memcpy(&value, &((u8 *) &dev->cfg)[reg], len);
+                    }
+                }
+            }
+            break;
+
+        case PCIMemory:
+            range = AXP_21274_PCILookup(
+                __atomic_load_n(&p->memIndex, __ATOMIC_ACQUIRE),
+                addr);
+            break;
+
+        case PCIIO:
+            range = AXP_21274_PCILookup(
+                __atomic_load_n(&p->ioIndex, __ATOMIC_ACQUIRE),
+                addr);
+            break;
+    }
+
+    /*
+     * If a device owns the memory or I/O address, then pass the cycle to it.
+     */
+    if (range != NULL)
+    {
+        dev = range->dev;
+        if (write == true)
+        {
+            value = 0;
+            memcpy(&value, buf, len);
+            dev->write(dev->ctx, range->bar, addr - range->base, value, len);
+        }
+        else
+        {
+            value = dev->read(dev->ctx, range->bar, addr - range->base, len);
+        }
+    }
+    if (write == false)
+    {
+        memcpy(buf, &value, len);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PCIRegister
+ *  This function is called by a PCI device model to register itself in a
+ *  slot on the bus behind a Pchip.  The device's configuration space should
+ *  already have its IDs, the type bits of its BARs, and its interrupt pin
+ *  filled in, along with the size of each BAR.  The interrupt pin is assigned
+ *  a DRIR bit based on the Pchip and slot.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  dev:
+ *      A pointer to the device to be registered.
+ *  slot:
+ *      A value indicating the slot the device is in.
+ *
+ * Output Parameters:
+ *  dev:
+ *      A pointer to the device, with its bus, slot, and IRQ set.
+ *
+ * Return Value:
+ *  true:   The device was registered.
+ *  false:  The slot does not exist or is already in use.
+ */
+bool AXP_21274_PCIRegister(AXP_21274_PCHIP *p, AXP_PCI_DEVICE *dev, u32 slot)
+{
+    bool retVal = false;
+
+    pthread_mutex_lock(&p->pciMutex);
+    if ((slot < AXP_PCI_MAX_SLOTS) && (p->pciDev[slot] == NULL))
+    {
+        dev->bus = p;
+        dev->slot = slot;
+        dev->irq = (p->pChipID * AXP_PCI_MAX_SLOTS * 4) + (slot * 4);
+        if (dev->cfg.interruptPin != 0)
+        {
+            dev->irq += (dev->cfg.interruptPin - 1) & 0x3;
+        }
+        __atomic_store_n(&p->pciDev[slot], dev, __ATOMIC_RELEASE);
+        retVal = true;
+    }
+    pthread_mutex_unlock(&p->pciMutex);
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21274_PCIInterrupt
+ *  This function is called by a PCI device model to assert or deassert its
+ *  interrupt pin.
+ *
+ * Input Parameters:
+ *  dev:
+ *      A pointer to the device whose interrupt is changing.
+ *  level:
+ *      A boolean indicating whether the interrupt is asserted.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_21274_PCIInterrupt(AXP_PCI_DEVICE *dev, bool level)
+{
+    AXP_21274_PCHIP *p = (AXP_21274_PCHIP *) dev->bus;
+
+    if ((p != NULL) && (p->irq != NULL) && (dev->cfg.interruptPin != 0))
+    {
+        p->irq(p->irqArg, dev->irq, level);
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PCIRetire
+ *  This function is called by the Pchip thread, between batches of requests,
+ *  to free the indexes that have been replaced.  Lookups are only done while
+ *  the Pchip thread is processing a request, so at this point none of them
+ *  can still be using a replaced index.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_21274_PCIRetire(AXP_21274_PCHIP *p)
+{
+    AXP_PCI_INDEX *index[2];
+    AXP_PCI_INDEX *prev;
+    int ii;
+
+    pthread_mutex_lock(&p->pciMutex);
+    index[0] = p->memIndex;
+    index[1] = p->ioIndex;
+    for (ii = 0; ii < 2; ii++)
+    {
+        if (index[ii] != NULL)
+        {
+            while (index[ii]->prev != NULL)
+            {
+                prev = index[ii]->prev;
+                index[ii]->prev = prev->prev;
+                AXP_Deallocate_Block(prev);
+            }
+        }
+    }
+    pthread_mutex_unlock(&p->pciMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PCIAccess
+ *  This function is called by the Pchip to perform a PIO or configuration
+ *  request from the Cchip, or a peer-to-peer request from the other Pchip,
+ *  on the PCI bus.  The address in the request is
+ *  address <34:3>, and the mask indicates the bytes, longwords, or
+ *  quadwords, following it, to be transferred.  Bytes are transferred as one
+ *  cycle for each run of contiguous bytes in the mask, the others as one
+ *  cycle per mask bit.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  msg:
+ *      A pointer to the request.
+ *
+ * Output Parameters:
+ *  msg:
+ *      A pointer to the request, with the data read.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_21274_PCIAccess(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
+{
+    AXP_PCI_SPACE space;
+    u64 addr = (u64) msg->addr << 3;
+    u8 *data = (u8 *) msg->data;
+    u32 mask;
+    u32 size;
+    u32 ii;
+    bool write = false;
+
+    switch (msg->cmd)
+    {
+        case PIO_MemoryWriteCPU:
+        case PTPMemoryWrite:
+        case PTPWrByteMaskByp:
+            write = true;
+            /* Fall Through */
+
+        case PIO_MemoryRead:
+        case PTPMemoryRead:
+            space = PCIMemory;
+            addr &= 0x00000000ffffffffll;
+            break;
+
+        case PIO_Write:
+            write = true;
+            /* Fall Through */
+
+        case PIO_Read:
+            space = PCIIO;
+            addr &= 0x0000000001ffffffll;
+            break;
+
+        case PCI_ConfigWrite:
+            write = true;
+            /* Fall Through */
+
+        default:
+            space = PCIConfig;
+            addr &= 0x0000000000ffffffll;
+            break;
+    }
+
+    if (msg->maskType == CAPbus_Byte)
+    {
+        mask = msg->mask;
+        while (mask != 0)
+        {
+            ii = __builtin_ctz(mask);
+            size = __builtin_ctz(~(mask >> ii));
+            AXP_21274_PCICycle(p, space, addr + ii, &data[ii], size, write);
+            mask &= ~(((1 << size) - 1) << ii);
+        }
+    }
+    else
+    {
+        size = (msg->maskType == CAPbus_Lowngword) ? sizeof(u32) : sizeof(u64);
+        for (ii = 0; ii < AXP_21274_DATA_SIZE; ii++)
+        {
+            if ((msg->mask & (1 << ii)) != 0)
+            {
+                AXP_21274_PCICycle(p,
+                                   space,
+                                   addr + (ii * size),
+                                   &data[ii * size],
+                                   size,
+                                   write);
+            }
+        }
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PCIPeer
+ *  This function is called by the Pchip thread to do a peer-to-peer transfer
+ *  for a PCI device on the other Pchip's bus, whose DMA did not hit in any of
+ *  that Pchip's windows.  If a device on this bus has a memory BAR containing
+ *  the whole transfer, then it is broken up into a PTP request for each
+ *  quadword, which is performed just like a PIO request from the Cchip.
+ *  Whole longwords are transferred as longwords, and anything else as bytes.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  pciAddr:
+ *      A value containing the PCI memory address at which to start the
+ *      transfer.
+ *  buf:
+ *      A pointer to the buffer to be written to the device, when write is
+ *      true.
+ *  len:
+ *      A value indicating the number of bytes to be transferred.
+ *  write:
+ *      A boolean indicating that the data is to be written to the device.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the buffer to receive the data read from the device, when
+ *      write is false.
+ *
+ * Return Value:
+ *  true:   A device on this bus claimed the transfer.
+ *  false:  No device on this bus has a memory BAR containing the transfer.
+ */
+bool AXP_21274_PCIPeer(AXP_21274_PCHIP *p,
+                       u64 pciAddr,
+                       u8 *buf,
+                       u32 len,
+                       bool write)
+{
+    AXP_CAPbusMsg msg;
+    AXP_PCI_RANGE *range;
+    u8 *data = (u8 *) msg.data;
+    u64 qw;
+    u32 offset;
+    u32 chunk;
+    bool retVal = false;
+
+    range = AXP_21274_PCILookup(__atomic_load_n(&p->memIndex, __ATOMIC_ACQUIRE),
+                                pciAddr);
+    if ((range != NULL) &&
+        (len > 0) &&
+        ((pciAddr + len - 1) <= range->limit))
+    {
+        retVal = true;
+        while (len > 0)
+        {
+            qw = pciAddr & ~0x7ll;
+            offset = pciAddr - qw;
+            chunk = sizeof(u64) - offset;
+            if (chunk > len)
+            {
+                chunk = len;
+            }
+            memset(&msg, 0, sizeof(msg));
+            msg.addr = qw >> 3;
+            if (((offset % sizeof(u32)) == 0) && ((chunk % sizeof(u32)) == 0))
+            {
+                msg.cmd = (write == true) ? PTPMemoryWrite : PTPMemoryRead;
+                msg.maskType = CAPbus_Lowngword;
+                msg.mask = ((1 << (chunk / sizeof(u32))) - 1) <<
+                           (offset / sizeof(u32));
+            }
+            else
+            {
+                msg.cmd = (write == true) ? PTPWrByteMaskByp : PTPMemoryRead;
+                msg.maskType = CAPbus_Byte;
+                msg.mask = ((1 << chunk) - 1) << offset;
+            }
+            if (write == true)
+            {
+                memcpy(&data[offset], buf, chunk);
+            }
+            AXP_21274_PCIAccess(p, &msg);
+            if (write == false)
+            {
+                memcpy(buf, &data[offset], chunk);
+            }
+            pciAddr += chunk;
+            buf += chunk;
+            len -= chunk;
+        }
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
@@ -46,6 +46,38 @@
  *  these all appear to be when trying to get the 64-bit value equivalent of
  *  the 64-bit long PC structure.  We will use shifts (in a macro) instead of
  *  the casts.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Implemented PCI DMA through the WSBAn, WSMn, and TBAn window registers.
+ *  Scatter-gather PTEs are cached in a TLB, which is invalidated through
+ *  TLBIV and TLBIA, and the data is copied straight to and from the memory
+ *  arrays, a page at a time, rather than a CAPbus message per quadword.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  The requests from the CPUs and the ones from the PCI devices are now
+ *  queued on separate, bounded, queues.  Each time the Pchip wakes up, it
+ *  processes everything on both of them, and then goes back to waiting,
+ *  rather than exiting after the first request.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  PIO and configuration requests are passed on to the devices on the PCI
+ *  bus.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  The data for a read is returned to the Cchip, to be sent on to the CPU
+ *  that requested it.  Replaced PCI indexes are freed after each batch.
+ *
+ *  V01.006 19-Oct-2026 Jonathan D. Belanger
+ *  The PIO and DMA queues are processed in the order the requests were
+ *  queued, so that posted writes stay in order.  DMA from a PCI device is
+ *  queued, as a bulk transfer, and done by the Pchip thread in order with the
+ *  PIO requests.  The Pchip thread now exits when it is stopped.
+ *
+ *  V01.007 19-Oct-2026 Jonathan D. Belanger
+ *  A DMA that does not hit in any window is passed on to the other Pchip, as
+ *  a peer-to-peer transfer, and PTP requests are performed on the PCI bus.
+ *  Memory written by a DMA is invalidated in the CPUs' caches.  The error
+ *  bits in PERROR are now set and read with the TLB mutex locked.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
@@ -57,6 +89,20 @@
  */
 static u64 AXP_21274_ReadPCSR(AXP_21274_PCHIP *, AXP_CAPbusMsg *);
 static void AXP_21274_WritePCSR(AXP_21274_PCHIP *, AXP_CAPbusMsg *);
+static void AXP_21274_TLBInvalidate(AXP_21274_PCHIP *, bool, bool, u32);
+static bool AXP_21274_PchipMemory(AXP_21274_PCHIP *, u64, u8 *, u32, bool);
+static bool AXP_21274_PchipTranslate(AXP_21274_PCHIP *, u64, u64 *, bool *);
+static bool AXP_21274_PchipTransfer(AXP_21274_PCHIP *,
+                                    u64,
+                                    u8 *,
+                                    u32,
+                                    bool,
+                                    bool *);
+static void AXP_21274_PchipDMAMsg(AXP_21274_PCHIP *, AXP_CAPbusMsg *);
+static void AXP_21274_PchipPIOMsg(AXP_21274_PCHIP *, AXP_CAPbusMsg *);
+static void AXP_21274_PchipEnqueue(AXP_21274_PCHIP *,
+                                   AXP_21274_PCHIP_QUE *,
+                                   AXP_21274_PCHIP_RQ *);
 
 /*
  * AXP_21274_ReadPCSR
@@ -156,7 +202,9 @@ static u64 AXP_21274_ReadPCSR(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
             break;
 
         case 0x0f: /* PERROR */
+            pthread_mutex_lock(&p->tlbMutex);
             AXP_PCHIP_READ_PERROR(retVal, p);
+            pthread_mutex_unlock(&p->tlbMutex);
             retVal &= AXP_21274_PERROR_RMASK;
             break;
 
@@ -242,61 +290,73 @@ static void AXP_21274_WritePCSR(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
   case 0x00: /* WSBA0 */
       csrValue.value = msg->data[0] & AXP_21274_WSBAn_WMASK;
       p->wsba0 = csrValue.Wsban;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x01: /* WSBA1 */
       csrValue.value = msg->data[0] & AXP_21274_WSBAn_WMASK;
       p->wsba1 = csrValue.Wsban;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x02: /* WSBA2 */
       csrValue.value = msg->data[0] & AXP_21274_WSBAn_WMASK;
       p->wsba2 = csrValue.Wsban;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x03: /* WSBA3 */
       csrValue.value = msg->data[0] & AXP_21274_WSBA3_WMASK;
       p->wsba3 = csrValue.Wsba3;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x04: /* WSM0 */
       csrValue.value = msg->data[0] & AXP_21274_WSMn_WMASK;
       p->wsm0 = csrValue.Wsmn;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x05: /* WSM1 */
       csrValue.value = msg->data[0] & AXP_21274_WSMn_WMASK;
       p->wsm1 = csrValue.Wsmn;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x06: /* WSM2 */
       csrValue.value = msg->data[0] & AXP_21274_WSMn_WMASK;
       p->wsm2 = csrValue.Wsmn;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x07: /* WSM3 */
       csrValue.value = msg->data[0] & AXP_21274_WSMn_WMASK;
       p->wsm3 = csrValue.Wsmn;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x08: /* TBA0 */
       csrValue.value = msg->data[0] & AXP_21274_TBAn_WMASK;
       p->tba0 = csrValue.Tban;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x09: /* TBA1 */
       csrValue.value = msg->data[0] & AXP_21274_TBAn_WMASK;
       p->tba1 = csrValue.Tban;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x0a: /* TBA2 */
       csrValue.value = msg->data[0] & AXP_21274_TBAn_WMASK;
       p->tba2 = csrValue.Tban;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x0b: /* TBA3 */
       csrValue.value = msg->data[0] & AXP_21274_TBAn_WMASK;
       p->tba3 = csrValue.Tban;
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x0c: /* PCTL */
@@ -326,10 +386,14 @@ static void AXP_21274_WritePCSR(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
   case 0x12: /* TLBIV */
       csrValue.value = msg->data[0] & AXP_21274_TLBIV_WMASK;
       p->tlbiv = csrValue.Tlbiv;
+      AXP_21274_TLBInvalidate(p,
+                              false,
+                              p->tlbiv.dac == 1,
+                              p->tlbiv.addr);
       break;
 
   case 0x13: /* TLBIA */
-      /* TODO: Invalidate SG TLB sys->p0Tlbia; */
+      AXP_21274_TLBInvalidate(p, true, false, 0);
       break;
 
   case 0x14: /* PMONCTL */
@@ -352,6 +416,784 @@ static void AXP_21274_WritePCSR(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
     return;
 }
 
+/*
+ * AXP_21274_TLBInvalidate
+ *  This function is called to invalidate entries in the scatter-gather TLB.
+ *  Either all the entries are invalidated (TLBIA, or a change to one of the
+ *  window registers), or only the ones whose PCI address <31:16> and DAC
+ *  match the values written to TLBIV.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  all:
+ *      A boolean indicating that all the TLB entries are to be invalidated.
+ *  dac:
+ *      A boolean indicating that only DAC entries are to be invalidated.
+ *  addr:
+ *      A value containing PCI address <31:16> to be invalidated.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_TLBInvalidate(AXP_21274_PCHIP *p,
+                                    bool all,
+                                    bool dac,
+                                    u32 addr)
+{
+    int ii;
+
+    pthread_mutex_lock(&p->tlbMutex);
+    for (ii = 0; ii < AXP_21274_TLB_LEN; ii++)
+    {
+        if ((all == true) ||
+            ((p->tlb[ii].dac == dac) && ((p->tlb[ii].tag >> 1) == addr)))
+        {
+            p->tlb[ii].valid = false;
+        }
+    }
+    pthread_mutex_unlock(&p->tlbMutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PchipMemory
+ *  This function is called to copy data to or from the memory arrays.  The
+ *  arrays are all the same size, and together make up a contiguous physical
+ *  address space starting at zero.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  pa:
+ *      A value containing the physical address to be read or written.
+ *  buf:
+ *      A pointer to the buffer to be written to memory, when write is true.
+ *  len:
+ *      A value indicating the number of bytes to be transferred.
+ *  write:
+ *      A boolean indicating that the data is to be written to memory.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the buffer to receive the data read from memory, when
+ *      write is false.
+ *
+ * Return Value:
+ *  true:   The data was transferred.
+ *  false:  Some part of the address range does not exist.
+ */
+static bool AXP_21274_PchipMemory(AXP_21274_PCHIP *p,
+                                  u64 pa,
+                                  u8 *buf,
+                                  u32 len,
+                                  bool write)
+{
+    u8 *mem;
+    u64 offset;
+    u64 idx;
+    u32 chunk;
+    bool retVal = p->arraySize != 0;
+
+    while ((len > 0) && (retVal == true))
+    {
+        idx = pa / p->arraySize;
+        offset = pa % p->arraySize;
+        if ((idx < p->arrayCount) && (p->array[idx] != NULL))
+        {
+            mem = (u8 *) p->array[idx];
+            chunk = len;
+            if (chunk > (p->arraySize - offset))
+            {
+                chunk = p->arraySize - offset;
+            }
+            if (write == true)
+            {
+                memcpy(&mem[offset], buf, chunk);
+            }
+            else
+            {
+                memcpy(buf, &mem[offset], chunk);
+            }
+            pa += chunk;
+            buf += chunk;
+            len -= chunk;
+        }
+        else
+        {
+            retVal = false;
+        }
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21274_PchipTranslate
+ *  This function is called to translate a PCI address, that a device is
+ *  using for DMA, into a physical address (HRM 10.1.4).  The PCI address is
+ *  compared against each of the enabled windows.  If the window is direct
+ *  mapped, then the translated base address replaces the PCI address bits
+ *  above the window mask.  Otherwise, the page is looked up in the scatter-
+ *  gather TLB, and on a miss, the group of four PTEs containing it is read
+ *  from the page table at the translated base address.  A PCI address above
+ *  4GB is a DAC address, and can only hit in window 3.  An invalid PTE is
+ *  reported in PERROR, but a PCI address that does not hit in any window is
+ *  left to the caller, since it may be for a device on the other Pchip.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  pciAddr:
+ *      A value containing the PCI address to be translated.
+ *
+ * Output Parameters:
+ *  pa:
+ *      A pointer to the location to receive the physical address.
+ *  miss:
+ *      A pointer to a boolean set to whether the PCI address did not hit in
+ *      any of the windows.
+ *
+ * Return Value:
+ *  true:   The PCI address was translated.
+ *  false:  The PCI address does not hit in a window, or the PTE is not valid.
+ */
+static bool AXP_21274_PchipTranslate(AXP_21274_PCHIP *p,
+                                     u64 pciAddr,
+                                     u64 *pa,
+                                     bool *miss)
+{
+    u64 wsba[4];
+    u64 wsm[4];
+    u64 tba[4];
+    u64 size = 0;
+    u64 pteAddr = 0;
+    u64 pte;
+    u32 tag;
+    int window = -1;
+    int ii;
+    bool dac = false;
+    bool sg = false;
+    bool retVal = false;
+
+    AXP_PCHIP_READ_WSBA0(wsba[0], p);
+    AXP_PCHIP_READ_WSBA1(wsba[1], p);
+    AXP_PCHIP_READ_WSBA2(wsba[2], p);
+    AXP_PCHIP_READ_WSBA3(wsba[3], p);
+    AXP_PCHIP_READ_WSM0(wsm[0], p);
+    AXP_PCHIP_READ_WSM1(wsm[1], p);
+    AXP_PCHIP_READ_WSM2(wsm[2], p);
+    AXP_PCHIP_READ_WSM3(wsm[3], p);
+    AXP_PCHIP_READ_TBA0(tba[0], p);
+    AXP_PCHIP_READ_TBA1(tba[1], p);
+    AXP_PCHIP_READ_TBA2(tba[2], p);
+    AXP_PCHIP_READ_TBA3(tba[3], p);
+
+    /*
+     * A DAC address only hits in window 3, when it is enabled for DAC, and
+     * PCI address <39> is set and <63:40> and <38:32> are zero.  The page
+     * table origin is in TBA3<34:22>.
+     */
+    if ((pciAddr >> 32) != 0)
+    {
+        if ((p->wsba3.ena == AXP_ENA_ENABLE) &&
+            (p->wsba3.dac == AXP_DAC_ENABLE) &&
+            ((pciAddr >> 32) == 0x80))
+        {
+            window = 3;
+            dac = true;
+            sg = true;
+            pteAddr = (tba[3] & 0x00000007ffc00000ll) |
+                      (((pciAddr & 0x00000000ffffffffll) >> 13) << 3);
+        }
+    }
+
+    /*
+     * Otherwise, the PCI address hits in the first enabled window whose base
+     * address matches PCI address <31:20>, for the bits not masked off.
+     */
+    else
+    {
+        for (ii = 0; (ii < 4) && (window == -1); ii++)
+        {
+            size = (wsm[ii] & AXP_21274_WSMn_RMASK) | 0x00000000000fffffll;
+            if (((wsba[ii] & 1) == AXP_ENA_ENABLE) &&
+                ((ii != 3) || (p->wsba3.dac == AXP_DAC_DISABLE)) &&
+                ((pciAddr & ~size) ==
+                 (wsba[ii] & AXP_21274_WSBAn_RMASK & ~size)))
+            {
+                window = ii;
+                sg = ((wsba[ii] >> 1) & 1) == AXP_SG_ENABLE;
+                if (sg == true)
+                {
+                    pteAddr = (tba[ii] & AXP_21274_TBAn_RMASK & ~(size >> 10)) |
+                              (((pciAddr & size) >> 13) << 3);
+                }
+                else
+                {
+                    *pa = (tba[ii] & AXP_21274_TBAn_RMASK & ~size) |
+                          (pciAddr & size);
+                    retVal = true;
+                }
+            }
+        }
+    }
+
+    /*
+     * If this is a scatter-gather window, then look for the PTE in the TLB,
+     * and if it is not there, then read the group of 4 PTEs, that contains
+     * it, into the next TLB entry.
+     */
+    if (sg == true)
+    {
+        tag = (pciAddr >> 15) & 0x1ffff;
+        pthread_mutex_lock(&p->tlbMutex);
+        for (ii = 0; ii < AXP_21274_TLB_LEN; ii++)
+        {
+            if ((p->tlb[ii].valid == true) &&
+                (p->tlb[ii].dac == dac) &&
+                (p->tlb[ii].tag == tag))
+            {
+                break;
+            }
+        }
+        if (ii == AXP_21274_TLB_LEN)
+        {
+            ii = p->tlbNext;
+            if (AXP_21274_PchipMemory(p,
+                                      pteAddr & ~0x1fll,
+                                      (u8 *) p->tlb[ii].pte,
+                                      sizeof(p->tlb[ii].pte),
+                                      false) == true)
+            {
+                p->tlb[ii].valid = true;
+                p->tlb[ii].dac = dac;
+                p->tlb[ii].tag = tag;
+                p->tlbNext = (p->tlbNext + 1) % AXP_21274_TLB_LEN;
+            }
+            else
+            {
+                ii = -1;
+            }
+        }
+        if (ii >= 0)
+        {
+            pte = p->tlb[ii].pte[(pciAddr >> 13) & (AXP_21274_TLB_PTES - 1)];
+            if ((pte & 1) == 1)
+            {
+                *pa = (((pte >> 1) & 0x3fffff) << 13) | (pciAddr & 0x1fff);
+                retVal = true;
+            }
+        }
+        if (retVal == false)
+        {
+            p->perror.sge = 1;
+        }
+        pthread_mutex_unlock(&p->tlbMutex);
+    }
+    *miss = window == -1;
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21274_PchipTransfer
+ *  This function is called by the Pchip thread to do a DMA from a PCI device.
+ *  The transfer is broken up at each 8KB page, since each page can translate
+ *  to a different physical address, and each page is then copied directly to
+ *  or from the memory arrays.  Each page written is then invalidated in the
+ *  CPUs' caches.  If the first page does not hit in any window, and there is
+ *  another Pchip, then nothing is transferred, and the caller passes the DMA
+ *  on to it.  Otherwise, a page that does not hit is reported in PERROR as
+ *  being to a non-existent device.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  pciAddr:
+ *      A value containing the PCI address at which to start the transfer.
+ *  buf:
+ *      A pointer to the buffer to be written to memory, when write is true.
+ *  len:
+ *      A value indicating the number of bytes to be transferred.
+ *  write:
+ *      A boolean indicating that the data is to be written to memory.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the buffer to receive the data read from memory, when
+ *      write is false.
+ *  miss:
+ *      A pointer to a boolean set to whether the DMA is to be passed on to
+ *      the other Pchip.
+ *
+ * Return Value:
+ *  true:   All the data was transferred.
+ *  false:  Some part of the transfer did not translate or does not exist.
+ */
+static bool AXP_21274_PchipTransfer(AXP_21274_PCHIP *p,
+                                    u64 pciAddr,
+                                    u8 *buf,
+                                    u32 len,
+                                    bool write,
+                                    bool *miss)
+{
+    u64 pa;
+    u32 chunk;
+    bool noWindow;
+    bool first = true;
+    bool retVal = true;
+
+    *miss = false;
+    while ((len > 0) && (retVal == true))
+    {
+        chunk = AXP_21274_SG_PAGE - (pciAddr & (AXP_21274_SG_PAGE - 1));
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        retVal = AXP_21274_PchipTranslate(p, pciAddr, &pa, &noWindow);
+        if (retVal == true)
+        {
+            retVal = AXP_21274_PchipMemory(p, pa, buf, chunk, write);
+            if ((retVal == true) && (write == true) && (p->invalidate != NULL))
+            {
+                p->invalidate(p->invalidateArg, pa, chunk);
+            }
+        }
+        else if (noWindow == true)
+        {
+            if ((first == true) && (p->peer != NULL))
+            {
+                *miss = true;
+            }
+            else
+            {
+                pthread_mutex_lock(&p->tlbMutex);
+                p->perror.nds = 1;
+                pthread_mutex_unlock(&p->tlbMutex);
+            }
+        }
+        first = false;
+        pciAddr += chunk;
+        buf += chunk;
+        len -= chunk;
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21274_PchipDMA
+ *  This function is called by a PCI device to transfer data to or from
+ *  memory.  The transfer is queued to the Pchip, so that it is done in order
+ *  with the PIO requests queued before it, and we wait for it to be done.
+ *  If the PCI address does not hit in any of the Pchip's windows, then it is
+ *  queued again, to the other Pchip, as a peer-to-peer transfer to a device
+ *  on its bus.  This is done here, rather than by the Pchip thread, so that
+ *  neither Pchip thread ever waits for the other.  This must not be called on
+ *  a Pchip thread, which includes the device's PIO read and write functions.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  pciAddr:
+ *      A value containing the PCI address at which to start the transfer.
+ *  buf:
+ *      A pointer to the buffer to be written to memory, when write is true.
+ *  len:
+ *      A value indicating the number of bytes to be transferred.
+ *  write:
+ *      A boolean indicating that the data is to be written to memory.
+ *
+ * Output Parameters:
+ *  buf:
+ *      A pointer to the buffer to receive the data read from memory, when
+ *      write is false.
+ *
+ * Return Value:
+ *  true:   All the data was transferred.
+ *  false:  Some part of the transfer did not translate or does not exist.
+ */
+bool AXP_21274_PchipDMA(AXP_21274_PCHIP *p,
+                        u64 pciAddr,
+                        u8 *buf,
+                        u32 len,
+                        bool write)
+{
+    AXP_21274_PCHIP *peer = p->peer;
+    AXP_21274_PCHIP_RQ rq;
+    bool miss = false;
+    bool done = false;
+    bool retVal = false;
+
+    memset(&rq, 0, sizeof(rq));
+    rq.pciAddr = pciAddr;
+    rq.buf = buf;
+    rq.len = len;
+    rq.write = write;
+    rq.miss = &miss;
+    rq.done = &done;
+    rq.retVal = &retVal;
+
+    /*
+     * The Pchip broadcasts on the space condition variable after each batch,
+     * which is also when it marks the DMAs in the batch as done.
+     */
+    pthread_mutex_lock(&p->mutex);
+    AXP_21274_PchipEnqueue(p, &p->dma, &rq);
+    while (done == false)
+    {
+        pthread_cond_wait(&p->space, &p->mutex);
+    }
+    pthread_mutex_unlock(&p->mutex);
+
+    /*
+     * If the PCI address did not hit in any window, then pass it on to the
+     * other Pchip.  If no device on its bus claims it either, then the DMA was
+     * to a non-existent device.
+     */
+    if (miss == true)
+    {
+        rq.ptp = true;
+        rq.miss = NULL;
+        done = false;
+        pthread_mutex_lock(&peer->mutex);
+        AXP_21274_PchipEnqueue(peer, &peer->dma, &rq);
+        while (done == false)
+        {
+            pthread_cond_wait(&peer->space, &peer->mutex);
+        }
+        pthread_mutex_unlock(&peer->mutex);
+        if (retVal == false)
+        {
+            pthread_mutex_lock(&p->tlbMutex);
+            p->perror.nds = 1;
+            pthread_mutex_unlock(&p->tlbMutex);
+        }
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_21274_PchipDMAMsg
+ *  This function is called to process a DMA CAPbus message.  The address in
+ *  the message is physical address <34:3>, which has already been
+ *  translated, and the mask indicates which of the quadwords following it
+ *  are to be transferred.  For a read-modify-write, the mask indicates which
+ *  bytes of the one quadword are to be written.  Memory that is written is
+ *  invalidated in the CPUs' caches.  A PTP request, from the other Pchip, is
+ *  to a device on our PCI bus, and is performed just like a PIO request.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  msg:
+ *      A pointer to the DMA request.
+ *
+ * Output Parameters:
+ *  msg:
+ *      A pointer to the DMA request, with the data read from memory.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PchipDMAMsg(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
+{
+    u64 pa = (u64) msg->addr << 3;
+    u8 *qw;
+    u64 data;
+    int ii;
+
+    switch (msg->cmd)
+    {
+        case DMAReadNQW:
+        case SGTEReadNQW:
+        case DMAWriteNQW:
+            for (ii = 0; ii < AXP_21274_DATA_SIZE; ii++)
+            {
+                if ((msg->mask & (1 << ii)) != 0)
+                {
+                    AXP_21274_PchipMemory(p,
+                                          pa + (ii * sizeof(u64)),
+                                          (u8 *) &msg->data[ii],
+                                          sizeof(u64),
+                                          msg->cmd == DMAWriteNQW);
+                }
+            }
+            if ((msg->cmd == DMAWriteNQW) && (p->invalidate != NULL))
+            {
+                p->invalidate(p->invalidateArg,
+                              pa,
+                              AXP_21274_DATA_SIZE * sizeof(u64));
+            }
+            break;
+
+        case DMARdModyWrQW:
+            qw = (u8 *) &msg->data[0];
+            if (AXP_21274_PchipMemory(p,
+                                      pa,
+                                      (u8 *) &data,
+                                      sizeof(u64),
+                                      false) == true)
+            {
+                for (ii = 0; ii < sizeof(u64); ii++)
+                {
+                    if ((msg->mask & (1 << ii)) != 0)
+                    {
+                        ((u8 *) &data)[ii] = qw[ii];
+                    }
+                }
+                AXP_21274_PchipMemory(p, pa, (u8 *) &data, sizeof(u64), true);
+                if (p->invalidate != NULL)
+                {
+                    p->invalidate(p->invalidateArg, pa, sizeof(u64));
+                }
+            }
+            break;
+
+        case PTPMemoryRead:
+        case PTPMemoryWrite:
+        case PTPWrByteMaskByp:
+            AXP_21274_PCIAccess(p, msg);
+            break;
+
+        default:
+            break;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PchipPIOMsg
+ *  This function is called to process a PIO, CSR, or configuration CAPbus
+ *  message from the Cchip.  When a read has completed, the data is returned
+ *  to the Cchip, which sends it on to the CPU that requested it.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  msg:
+ *      A pointer to the request.
+ *
+ * Output Parameters:
+ *  msg:
+ *      A pointer to the request, with the data read.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PchipPIOMsg(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
+{
+
+    /*
+     * Determine what has been requested and make the call needed to
+     * complete request.
+     */
+    switch (msg->cmd)
+    {
+        case CSR_Read:
+            msg->data[0] = AXP_21274_ReadPCSR(p, msg);
+            break;
+
+        case CSR_Write:
+            AXP_21274_WritePCSR(p, msg);
+            break;
+
+        case PIO_Read:
+        case PIO_Write:
+        case PIO_MemoryRead:
+        case PIO_MemoryWriteCPU:
+        case PCI_ConfigRead:
+        case PCI_ConfigWrite:
+            AXP_21274_PCIAccess(p, msg);
+            break;
+
+        default:
+            break;
+    }
+
+    /*
+     * There is no interrupt controller on the PCI bus, so an interrupt
+     * acknowledge reads as zero.
+     */
+    switch (msg->cmd)
+    {
+        case CSR_Read:
+        case PIO_Read:
+        case PIO_MemoryRead:
+        case PCI_ConfigRead:
+        case PIO_IACK:
+            if (p->complete != NULL)
+            {
+                p->complete(p->completeArg, msg);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PchipEnqueue
+ *  This function is called, with the Pchip mutex locked, to number a request
+ *  and copy it onto the end of a queue.  If the queue is full, then we wait
+ *  for the Pchip to make room on it.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  que:
+ *      A pointer to the queue the request goes on.
+ *  rq:
+ *      A pointer to the request to be copied onto the queue.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_21274_PchipEnqueue(AXP_21274_PCHIP *p,
+                                   AXP_21274_PCHIP_QUE *que,
+                                   AXP_21274_PCHIP_RQ *rq)
+{
+    while (que->count == AXP_21274_PCHIP_QUE_LEN)
+    {
+        pthread_cond_wait(&p->space, &p->mutex);
+    }
+    rq->seq = p->seq++;
+    que->rq[(que->head + que->count) % AXP_21274_PCHIP_QUE_LEN] = *rq;
+    que->count++;
+    pthread_cond_signal(&p->cond);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PchipQueue
+ *  This function is called to queue up a CAPbus request to the Pchip.  DMA
+ *  and PTP requests go on the DMA queue and everything else, from the Cchip
+ *  on behalf of the CPUs, goes on the PIO queue.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *  msg:
+ *      A pointer to the request to be copied onto the queue.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_21274_PchipQueue(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
+{
+    AXP_21274_PCHIP_QUE *que;
+    AXP_21274_PCHIP_RQ rq;
+
+    switch (msg->cmd)
+    {
+        case DMAReadNQW:
+        case SGTEReadNQW:
+        case DMARdModyWrQW:
+        case DMAWriteNQW:
+        case PTPMemoryRead:
+        case PTPMemoryWrite:
+        case PTPWrByteMaskByp:
+            que = &p->dma;
+            break;
+
+        default:
+            que = &p->pio;
+            break;
+    }
+
+    memset(&rq, 0, sizeof(rq));
+    rq.msg = *msg;
+    pthread_mutex_lock(&p->mutex);
+    AXP_21274_PchipEnqueue(p, que, &rq);
+    pthread_mutex_unlock(&p->mutex);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_21274_PchipStop
+ *  This function is called to have the Pchip thread exit, once it has
+ *  processed everything already queued to it, and wait for it to do so.
+ *
+ * Input Parameters:
+ *  p:
+ *      A pointer to the Pchip data structure from which the emulation
+ *      information is maintained.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+void AXP_21274_PchipStop(AXP_21274_PCHIP *p)
+{
+    pthread_mutex_lock(&p->mutex);
+    p->shutdown = true;
+    pthread_cond_signal(&p->cond);
+    pthread_mutex_unlock(&p->mutex);
+    pthread_join(p->threadID, NULL);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
 /*
  * AXP_21274_PchipInit
  *  This function is called to initialize the Pchip CSRs as documented in HRM
@@ -363,6 +1205,12 @@ static void AXP_21274_WritePCSR(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
  *      information is maintained.
  *  id:
  *      A value indicating the numeric identifier associated with this Pchip.
+ *  array:
+ *      A pointer to the memory arrays DMA is transferred to and from.
+ *  arrayCount:
+ *      A value indicating the number of memory arrays.
+ *  arraySize:
+ *      A value indicating the size, in bytes, of each memory array.
  *
  * Output Parameters:
  *  None.
@@ -370,11 +1218,38 @@ static void AXP_21274_WritePCSR(AXP_21274_PCHIP *p, AXP_CAPbusMsg *msg)
  * Return Values:
  *  None.
  */
-void AXP_21274_PchipInit(AXP_21274_PCHIP *p, u32 id)
+void AXP_21274_PchipInit(AXP_21274_PCHIP *p,
+                         u32 id,
+                         u64 **array,
+                         u32 arrayCount,
+                         u64 arraySize)
 {
     int ii;
 
     p->pChipID = id; /* Save the ID for this Pchip */
+    p->array = array;
+    p->arrayCount = arrayCount;
+    p->arraySize = arraySize;
+
+    /*
+     * Start off with an empty scatter-gather TLB.
+     */
+    for (ii = 0; ii < AXP_21274_TLB_LEN; ii++)
+    {
+        p->tlb[ii].valid = false;
+    }
+    p->tlbNext = 0;
+
+    /*
+     * There are no devices on the PCI bus until they register themselves, so
+     * there is nothing in the address indexes.
+     */
+    for (ii = 0; ii < AXP_PCI_MAX_SLOTS; ii++)
+    {
+        p->pciDev[ii] = NULL;
+    }
+    p->memIndex = NULL;
+    p->ioIndex = NULL;
 
     /*
      * Initialize the message queues.  We do not have the data queues, since
@@ -382,12 +1257,12 @@ void AXP_21274_PchipInit(AXP_21274_PCHIP *p, u32 id)
      * memory.  The Cchip performs this function on behalf of the CPU and the
      * Pchip performs this function on behalf of itself.
      */
-    AXP_INIT_QUE(p->tpr);
-    AXP_INIT_QUE(p->fpr);
-    for (ii = 0; ii < AXP_21274_CAPBUS_MQ_SIZE; ii++)
-    {
-  AXP_INIT_QUE(p->rq[ii].header);
-    }
+    p->pio.head = 0;
+    p->pio.count = 0;
+    p->dma.head = 0;
+    p->dma.count = 0;
+    p->seq = 0;
+    p->shutdown = false;
 
     /*
      * Initialization for WSBA0, WSBA1,and WSBA2 (HRM Table 10-35).
@@ -578,7 +1453,8 @@ void AXP_21274_PchipInit(AXP_21274_PCHIP *p, u32 id)
  * AXP_21274_Pchip_Main
  *  This is the main function for the Pchip.  It looks at its queues to
  *   determine if there is anything that needs to be processed from the Cchip or
- *   PCI devices.
+ *   PCI devices.  The requests are processed in the order they were queued,
+ *   and the thread exits once it has been stopped and its queues are empty.
  *
  * Input Parameters:
  *   p:
@@ -594,17 +1470,20 @@ void AXP_21274_PchipInit(AXP_21274_PCHIP *p, u32 id)
 void *AXP_21274_PchipMain(void *voidPtr)
 {
     AXP_21274_PCHIP *p = (AXP_21274_PCHIP *) voidPtr;
-    AXP_CAPbusMsg *msg;
+    AXP_21274_PCHIP_RQ *dma;
+    AXP_21274_PCHIP_RQ *pio;
+    u32 dmaCnt;
+    u32 pioCnt;
+    u32 ii, jj;
 
     /*
      * Log that we are starting.
      */
     if (AXP_SYS_CALL)
     {
-  AXP_TRACE_BEGIN();
-  AXP_TraceWrite("Pchip p%d is starting", p->pChipID);
-  AXP_TRACE_END()
-  ;
+        AXP_TRACE_BEGIN();
+        AXP_TraceWrite("Pchip p%d is starting", p->pChipID);
+        AXP_TRACE_END();
     }
 
     /*
@@ -614,77 +1493,112 @@ void *AXP_21274_PchipMain(void *voidPtr)
     pthread_mutex_lock(&p->mutex);
 
     /*
-     * TODO: Need to determine what the end condition for this loop should be.
+     * Keep going until we have been stopped and there is nothing left to
+     * process.
      */
-    while (true)
+    while ((p->shutdown == false) ||
+           (p->pio.count != 0) ||
+           (p->dma.count != 0))
     {
 
-  /*
-   * The Pchip performs the following functions:
-   *
-   * This first thing we need to do is wait for something to arrive to be
-   * processed.
-   */
-  while AXP_QUE_EMPTY(p->tpr)
-      pthread_cond_wait(&p->cond, &p->mutex);
-
-  /*
-   * We have something to process.
-   */
-  msg = (AXP_CAPbusMsg *) p->tpr.flink;
-  AXP_REMQUE(&msg->header);
-
-  /*
-   * At this point, we can unlock the Pchip mutex so that other threads
-   * can send requests to the Pchip.  We'll lock it before we mark the
-   * request to be processed as no longer in use.
-   */
-  pthread_mutex_unlock(&p->mutex);
-
-  /*
-   * Determine what has been requested and make the call needed to
-   * complete request.
-   */
-  switch (msg->cmd)
-  {
-      case PIO_IACK:
-      case PIO_SpecialCycle:
-      case PIO_Read:
-      case PIO_Write:
-      case PIO_MemoryWritePTP:
-      case PIO_MemoryRead:
-      case PIO_MemoryWriteCPU:
-    break;
-
-      case CSR_Read:
-    AXP_21274_ReadPCSR(p, msg);
-    break;
-
-      case CSR_Write:
-    AXP_21274_WritePCSR(p, msg);
-    break;
-
-      case PCI_ConfigRead:
-      case PCI_ConfigWrite:
-      case LoadPADbusDataDown:
-      case LoadPADbusDataUp:
-      case CAPbus_NoOp:
-      case DMAReadNQW:
-      case SGTEReadNQW:
-      case PTPMemoryRead:
-      case PTPMemoryWrite:
-      case DMARdModyWrQW:
-      case DMAWriteNQW:
-      case PTPWrByteMaskByp:
-    break;
-  }
-
-  /*
-   * We are shutting down.  Since we started everything, we need to clean
-   * ourself up.  The main function will be joining to all the threads it
-   * created and then freeing up the memory and exiting the image.
-   */
-  pthread_exit(NULL);
-  return (NULL);
+        /*
+         * This first thing we need to do is wait for something to arrive to
+         * be processed, or to be stopped.
+         */
+        while ((p->pio.count == 0) &&
+               (p->dma.count == 0) &&
+               (p->shutdown == false))
+        {
+            pthread_cond_wait(&p->cond, &p->mutex);
+        }
+
+        /*
+         * Take everything that is queued up right now as this batch.  At this
+         * point, we can unlock the Pchip mutex so that other threads can
+         * queue more requests behind the batch while it is being processed.
+         */
+        dmaCnt = p->dma.count;
+        pioCnt = p->pio.count;
+        pthread_mutex_unlock(&p->mutex);
+
+        /*
+         * The two queues are merged, in the order the requests were queued.
+         * A PIO read must not pass a DMA write that was queued before it, so
+         * that the CPU sees the data the device wrote before it sees the
+         * device's status, and a DMA must not pass a PIO write queued before
+         * it, such as the one that told the device where to DMA to.  PIO only
+         * ever waits behind the DMAs that were queued before it.
+         */
+        ii = jj = 0;
+        while ((ii < dmaCnt) || (jj < pioCnt))
+        {
+            dma = &p->dma.rq[(p->dma.head + ii) % AXP_21274_PCHIP_QUE_LEN];
+            pio = &p->pio.rq[(p->pio.head + jj) % AXP_21274_PCHIP_QUE_LEN];
+            if ((jj == pioCnt) || ((ii < dmaCnt) && (dma->seq < pio->seq)))
+            {
+                if ((dma->buf != NULL) && (dma->ptp == true))
+                {
+                    *dma->retVal = AXP_21274_PCIPeer(p,
+                                                     dma->pciAddr,
+                                                     dma->buf,
+                                                     dma->len,
+                                                     dma->write);
+                }
+                else if (dma->buf != NULL)
+                {
+                    *dma->retVal = AXP_21274_PchipTransfer(p,
+                                                           dma->pciAddr,
+                                                           dma->buf,
+                                                           dma->len,
+                                                           dma->write,
+                                                           dma->miss);
+                }
+                else
+                {
+                    AXP_21274_PchipDMAMsg(p, &dma->msg);
+                }
+                ii++;
+            }
+            else
+            {
+                AXP_21274_PchipPIOMsg(p, &pio->msg);
+                jj++;
+            }
+        }
+
+        /*
+         * Nothing is using a PCI index between batches, so this is when the
+         * ones replaced by configuration writes can be freed.
+         */
+        AXP_21274_PCIRetire(p);
+
+        /*
+         * Relock the mutex, let the devices know their DMAs are done, remove
+         * the batch from the queues, and let anyone waiting for room on them,
+         * or for their DMA, know.
+         */
+        pthread_mutex_lock(&p->mutex);
+        for (ii = 0; ii < dmaCnt; ii++)
+        {
+            dma = &p->dma.rq[(p->dma.head + ii) % AXP_21274_PCHIP_QUE_LEN];
+            if (dma->done != NULL)
+            {
+                *dma->done = true;
+            }
+        }
+        p->dma.head = (p->dma.head + dmaCnt) % AXP_21274_PCHIP_QUE_LEN;
+        p->dma.count -= dmaCnt;
+        p->pio.head = (p->pio.head + pioCnt) % AXP_21274_PCHIP_QUE_LEN;
+        p->pio.count -= pioCnt;
+        pthread_cond_broadcast(&p->space);
     }
+    pthread_mutex_unlock(&p->mutex);
+
+    /*
+     * We are shutting down.  Since we started everything, we need to clean
+     * ourself up.  The main function will be joining to all the threads it
+     * created and then freeing up the memory and exiting the image.
+     */
+    pthread_exit(NULL);
+    return (NULL);
 }
@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains a tool to replay branch trace files, written by the
+ *  emulator when the AXP_BRANCHFILE environment variable is set, through the
+ *  Ibox branch prediction code.  Each branch is predicted, then the predictor
+ *  is told which way it actually went, just as it is when the branch retires
+ *  in the emulator.  For each trace file and each of the selected prediction
+ *  modes (the BP_MODE field of I_CTL), starting from cleared predictor tables,
+ *  the following are reported:
+ *
+ *      - the overall prediction accuracy and mispredictions
+ *      - how often the local and global predictors were each correct
+ *      - how often the chooser picked the correct one, when they disagreed
+ *      - the cycles the mispredictions would have cost
+ *      - the rate at which branches were replayed
+ *
+ *  Usage:
+ *
+ *      AXP_21264_Branch_Replay [-m modes] [-p penalty] trace-file ...
+ *
+ *  Where modes is a comma separated list of choice, local, fall or all (the
+ *  default), and penalty is the number of cycles a misprediction costs (the
+ *  default is 7).
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_Blocks.h"
+#include "CPU/AXP_21264_CPU.h"
+#include "CPU/Ibox/AXP_21264_Ibox.h"
+#include <getopt.h>
+#include <time.h>
+
+#define AXP_REPLAY_DEF_PENALTY  7
+
+typedef enum
+{
+    Replay_Choice,
+    Replay_Local,
+    Replay_Fall,
+    Replay_Modes
+} AXP_REPLAY_MODE;
+
+/*
+ * The name of each mode, and the BP_MODE value that selects it.
+ */
+static const char *_modeNames[Replay_Modes] =
+{
+    "choice",
+    "local",
+    "fall"
+};
+static const u8 _modeBpMode[Replay_Modes] =
+{
+    AXP_I_CTL_BP_MODE_CHOICE,
+    AXP_I_CTL_BP_MODE_LOCAL,
+    AXP_I_CTL_BP_MODE_FALL
+};
+
+/*
+ * AXP_Replay_Usage
+ *  This function is called to display how this tool is used.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Replay_Usage(void)
+{
+    printf("Usage: AXP_21264_Branch_Replay [-m modes] [-p penalty] "
+           "trace-file ...\n");
+    printf("    -m  comma separated list of choice, local, fall or all "
+           "(all)\n");
+    printf("    -p  cycles each misprediction costs (%d)\n",
+           AXP_REPLAY_DEF_PENALTY);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Replay_Modes
+ *  This function is called to parse the list of prediction modes to replay
+ *  the trace files with.
+ *
+ * Input Parameters:
+ *  list:
+ *      A pointer to the comma separated list of mode names.
+ *
+ * Output Parameters:
+ *  modes:
+ *      A pointer to an array of booleans, one for each mode, to be set to true
+ *      for the modes that were selected.
+ *
+ * Return Value:
+ *  true:   The list was parsed.
+ *  false:  The list contains a name that is not known.
+ */
+static bool AXP_Replay_Modes(char *list, bool *modes)
+{
+    char *name;
+    bool retVal = true;
+    int ii;
+
+    for (ii = 0; ii < Replay_Modes; ii++)
+    {
+        modes[ii] = false;
+    }
+    for (name = strtok(list, ",");
+         ((name != NULL) && (retVal == true));
+         name = strtok(NULL, ","))
+    {
+        if (strcmp(name, "all") == 0)
+        {
+            for (ii = 0; ii < Replay_Modes; ii++)
+            {
+                modes[ii] = true;
+            }
+        }
+        else
+        {
+            for (ii = 0; ii < Replay_Modes; ii++)
+            {
+                if (strcmp(name, _modeNames[ii]) == 0)
+                {
+                    modes[ii] = true;
+                    break;
+                }
+            }
+            retVal = ii < Replay_Modes;
+        }
+    }
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * AXP_Replay_Reset
+ *  This function is called to clear the branch prediction tables, just as the
+ *  Ibox does when it is initialized, before each replay.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure holding the branch prediction tables.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  None.
+ */
+static void AXP_Replay_Reset(AXP_21264_CPU *cpu)
+{
+    memset(&cpu->localHistoryTable, 0, sizeof(cpu->localHistoryTable));
+    memset(&cpu->localPredictor, 0, sizeof(cpu->localPredictor));
+    memset(&cpu->globalPredictor, 0, sizeof(cpu->globalPredictor));
+    memset(&cpu->choicePredictor, 0, sizeof(cpu->choicePredictor));
+    cpu->globalPathHistory = 0;
+    memset(&cpu->bpStats, 0, sizeof(cpu->bpStats));
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * AXP_Replay_File
+ *  This function is called to replay one trace file through the branch
+ *  predictor, in one prediction mode, and report the results.
+ *
+ * Input Parameters:
+ *  cpu:
+ *      A pointer to the CPU structure holding the branch prediction tables.
+ *  fileName:
+ *      A pointer to the name of the trace file.
+ *  mode:
+ *      A value indicating the prediction mode to replay the trace with.
+ *  penalty:
+ *      A value of the number of cycles each misprediction costs.
+ *  buf:
+ *      A pointer to a buffer for AXP_BRANCH_TRACE_BUF_LEN trace records.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  true:   The trace file was replayed.
+ *  false:  The trace file could not be opened, or is not a branch trace.
+ */
+static bool AXP_Replay_File(AXP_21264_CPU *cpu,
+                            char *fileName,
+                            AXP_REPLAY_MODE mode,
+                            u32 penalty,
+                            AXP_BRANCH_TRACE_REC *buf)
+{
+    AXP_BRANCH_TRACE_HDR hdr;
+    AXP_BRANCH_STATS *stats = &cpu->bpStats;
+    struct timespec start, end;
+    FILE *fp;
+    AXP_PC vpc;
+    double seconds;
+    u64 mispredicts;
+    size_t count, ii;
+    bool taken, predicted, localTaken, globalTaken, choice;
+    bool retVal = false;
+
+    fp = fopen(fileName, "rb");
+    if (fp == NULL)
+    {
+        printf("Unable to open trace file: %s\n", fileName);
+        return (retVal);
+    }
+    if ((fread(&hdr, sizeof(hdr), 1, fp) != 1) ||
+        (hdr.magic != AXP_BRANCH_TRACE_MAGIC) ||
+        (hdr.version != AXP_BRANCH_TRACE_VERSION) ||
+        (hdr.recordSize != sizeof(AXP_BRANCH_TRACE_REC)))
+    {
+        printf("%s is not a version %d branch trace file\n",
+               fileName,
+               AXP_BRANCH_TRACE_VERSION);
+        fclose(fp);
+        return (retVal);
+    }
+    retVal = true;
+
+    /*
+     * Start from cleared predictor tables, in the requested mode, and run each
+     * branch through the predictor the way the Ibox does: predict it when it
+     * is fetched, then update the predictor when it is retired.
+     */
+    AXP_Replay_Reset(cpu);
+    cpu->iCtl.bp_mode = _modeBpMode[mode];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while ((count = fread(buf,
+                          sizeof(AXP_BRANCH_TRACE_REC),
+                          AXP_BRANCH_TRACE_BUF_LEN,
+                          fp)) > 0)
+    {
+        for (ii = 0; ii < count; ii++)
+        {
+            taken = (buf[ii].pc & AXP_BRANCH_TRACE_TAKEN) != 0;
+            AXP_PUT_PC(vpc, buf[ii].pc);
+            predicted = AXP_Branch_Prediction(cpu,
+                                              vpc,
+                                              &localTaken,
+                                              &globalTaken,
+                                              &choice);
+            AXP_Branch_Direction(cpu, vpc, taken, localTaken, globalTaken);
+            AXP_Branch_Count(stats,
+                             taken,
+                             predicted,
+                             localTaken,
+                             globalTaken);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fclose(fp);
+    seconds = (double) (end.tv_sec - start.tv_sec) +
+              ((double) (end.tv_nsec - start.tv_nsec) / 1000000000.0);
+
+    /*
+     * Print out what we found.
+     */
+    mispredicts = stats->branches - stats->correct;
+    printf("%s (CPU %llu), %s prediction:\n",
+           fileName,
+           (unsigned long long) hdr.cpuID,
+           _modeNames[mode]);
+    printf("    Branches:               %llu (%5.2f%% taken)\n",
+           stats->branches,
+           (stats->branches != 0) ?
+               ((double) stats->taken * 100.0 / (double) stats->branches) :
+               0.0);
+    printf("    Predicted correctly:    %llu (%5.2f%%)\n",
+           stats->correct,
+           (stats->branches != 0) ?
+               ((double) stats->correct * 100.0 / (double) stats->branches) :
+               0.0);
+    printf("    Mispredictions:         %llu, costing %llu cycles\n",
+           mispredicts,
+           mispredicts * penalty);
+    if (mode != Replay_Fall)
+    {
+        printf("    Local correct:          %llu (%5.2f%%)\n",
+               stats->localCorrect,
+               (stats->branches != 0) ?
+                   ((double) stats->localCorrect * 100.0 /
+                    (double) stats->branches) :
+                   0.0);
+    }
+    if (mode == Replay_Choice)
+    {
+        printf("    Global correct:         %llu (%5.2f%%)\n",
+               stats->globalCorrect,
+               (stats->branches != 0) ?
+                   ((double) stats->globalCorrect * 100.0 /
+                    (double) stats->branches) :
+                   0.0);
+        printf("    Chooser correct:        %llu of %llu (%5.2f%%)\n",
+               stats->chooserCorrect,
+               stats->disagree,
+               (stats->disagree != 0) ?
+                   ((double) stats->chooserCorrect * 100.0 /
+                    (double) stats->disagree) :
+                   0.0);
+    }
+    printf("    Replayed at:            %.2f million branches/second\n\n",
+           (seconds > 0.0) ?
+               ((double) stats->branches / seconds / 1000000.0) :
+               0.0);
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
+
+/*
+ * main
+ *  This is the main function for the branch trace replay tool.
+ *
+ * Input Parameters:
+ *  argc:
+ *      A value of the number of arguments.
+ *  argv:
+ *      An array of pointers to the arguments.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Value:
+ *  0:  All the trace files were replayed.
+ *  1:  The arguments were not valid, or a trace file could not be replayed.
+ */
+int main(int argc, char **argv)
+{
+    AXP_21264_CPU *cpu;
+    AXP_BRANCH_TRACE_REC *buf;
+    bool modes[Replay_Modes];
+    u32 penalty = AXP_REPLAY_DEF_PENALTY;
+    int retVal = 0;
+    int opt, ii, jj;
+
+    for (ii = 0; ii < Replay_Modes; ii++)
+    {
+        modes[ii] = true;
+    }
+    while ((opt = getopt(argc, argv, "m:p:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm':
+                if (AXP_Replay_Modes(optarg, modes) == false)
+                {
+                    AXP_Replay_Usage();
+                    return (1);
+                }
+                break;
+
+            case 'p':
+                penalty = strtoul(optarg, NULL, 10);
+                break;
+
+            case 'h':
+            default:
+                AXP_Replay_Usage();
+                return (1);
+        }
+    }
+    if (optind >= argc)
+    {
+        AXP_Replay_Usage();
+        return (1);
+    }
+
+    printf("\nAXP 21264 Branch Trace Replay\n\n");
+    cpu = (AXP_21264_CPU *) AXP_Allocate_Block(AXP_21264_CPU_BLK);
+    buf = AXP_Allocate_Block(
+        -(i32) (AXP_BRANCH_TRACE_BUF_LEN * sizeof(AXP_BRANCH_TRACE_REC)),
+        NULL);
+    if ((cpu == NULL) || (buf == NULL))
+    {
+        printf("Unable to allocate memory\n");
+        return (1);
+    }
+    for (ii = optind; ii < argc; ii++)
+    {
+        for (jj = 0; jj < Replay_Modes; jj++)
+        {
+            if ((modes[jj] == true) &&
+                (AXP_Replay_File(cpu, argv[ii], jj, penalty, buf) == false))
+            {
+                retVal = 1;
+                break;
+            }
+        }
+    }
+    AXP_Deallocate_Block(buf);
+    AXP_Deallocate_Block(cpu);
+
+    /*
+     * Return the results back to the caller.
+     */
+    return (retVal);
+}
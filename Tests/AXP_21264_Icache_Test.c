@@ -29,6 +29,9 @@
  *
  *  V01.002 09-Jun-2019 Jonathan D. Belanger
  *  Reformatted the code to remove tabs and correct other formatting issues.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Report how well the line and set predictors did.
  */
 #include "CommonUtilities/AXP_Blocks.h"
 #include "CPU/AXP_21264_CPU.h"
@@ -288,6 +291,7 @@ int main()
     instrCnt = 0;
     nextLine.linePrediction = 0;
     nextLine.setPrediction = 0;
+    nextLine.fetchValid = false;
 
     while (!done)
     {
@@ -452,5 +456,13 @@ int main()
            ((float)(hitCnt+cacheMissCnt+ITBMissCnt)/(float)cycleCnt));
     printf("Instructions per cycle:          %5.2f\n\n",
            ((float)instrCnt/(float)cycleCnt));
+    printf("Line predictions correct:        %llu\n",
+           cpu->iCacheStats.linePredHits);
+    printf("Line predictions wrong:          %llu\n",
+           cpu->iCacheStats.linePredMisses);
+    printf("Line prediction percentage:      %5.2f\n\n",
+           ((float)cpu->iCacheStats.linePredHits/
+            (float)(cpu->iCacheStats.linePredHits+
+                    cpu->iCacheStats.linePredMisses)*100.0));
     return(0);
 }
@@ -0,0 +1,588 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains the code to test DMA through the Pchip windows, and
+ *  PIO to the devices on the PCI bus.
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Requests are queued through AXP_21274_PchipQueue, and added a test that
+ *  more DMA requests than fit on the queue all get done.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test of PCI device registration, BAR programming, and PIO
+ *  dispatch.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Added tests of a byte write with a non-contiguous mask, and of a read,
+ *  queued to the Pchip, being returned through the completion function.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test that a DMA queued behind a PIO write is not done before it,
+ *  and the Pchip thread is stopped at the end.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  Added tests that memory written by a DMA is invalidated, and of a DMA that
+ *  goes to a device on the other Pchip's bus.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "Motherboard/AXP_21274_System.h"
+#include "Motherboard/Pchip/AXP_21274_Pchip.h"
+#include "Motherboard/AXP_21274_InitRoutines.h"
+
+#define TEST_ARRAY_SIZE	(4 * ONE_M)
+#define TEST_ARRAYS		2
+#define TEST_DIRECT_PA	0x00100000ll
+#define TEST_TABLE_PA	0x00200000ll
+#define TEST_SG_PA		0x00400000ll
+
+static AXP_21274_PCHIP p;
+static AXP_21274_PCHIP q;
+static u64 *arrays[TEST_ARRAYS];
+static u8 buf[4 * AXP_21274_SG_PAGE];
+static u8 chk[4 * AXP_21274_SG_PAGE];
+static AXP_PCI_DEVICE dev;
+static u64 devRegs[2][64];
+static u32 devIrq;
+static bool devLevel;
+static AXP_CAPbusMsg done;
+static u64 devSeen;
+static AXP_PCI_DEVICE peerDev;
+static u64 peerRegs[2][64];
+static u64 invalPA;
+static u32 invalLen;
+
+/*
+ * Test_Memory
+ *  Return a pointer to a physical address in the test memory arrays.
+ */
+u8 *Test_Memory(u64 pa)
+{
+    return(&((u8 *) arrays[pa / TEST_ARRAY_SIZE])[pa % TEST_ARRAY_SIZE]);
+}
+
+/*
+ * Test_Fill
+ *  Fill a buffer with a pattern based on a seed.
+ */
+void Test_Fill(u8 *data, u32 len, u8 seed)
+{
+    u32 ii;
+
+    for (ii = 0; ii < len; ii++)
+    {
+        data[ii] = (u8) (ii * 7 + seed);
+    }
+    return;
+}
+
+/*
+ * Test_TLBIV
+ *  Have the Pchip thread invalidate the TLB entries for a PCI address, by
+ *  writing TLBIV, and wait for it to have been done.
+ */
+bool Test_TLBIV(u64 pciAddr)
+{
+    AXP_CAPbusMsg msg;
+    int ii;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.cmd = CSR_Write;
+    msg.csr = 0x12;
+    msg.data[0] = ((pciAddr >> 16) & 0xffff) << 4;
+    AXP_21274_PchipQueue(&p, &msg);
+    for (ii = 0; (ii < 100) && (p.tlbiv.addr == 0); ii++)
+    {
+        usleep(1000);
+    }
+    usleep(1000);
+    return(p.tlbiv.addr != 0);
+}
+
+/*
+ * test_direct
+ *  A transfer through a direct mapped window goes to the translated base
+ *  address, and one outside all the windows fails.
+ */
+bool test_direct(void)
+{
+    bool retVal;
+
+    p.wsba0.addr = 0x400;		/* PCI 1GB */
+    p.wsba0.sg = AXP_SG_DISABLE;
+    p.wsba0.ena = AXP_ENA_ENABLE;
+    p.wsm0.am = 0;			/* 1MB */
+    p.tba0.addr = TEST_DIRECT_PA >> 10;
+    Test_Fill(buf, sizeof(buf), 1);
+    retVal = AXP_21274_PchipDMA(&p, 0x40001000, buf, sizeof(buf), true);
+    retVal = retVal &&
+             (memcmp(Test_Memory(TEST_DIRECT_PA + 0x1000),
+                     buf,
+                     sizeof(buf)) == 0);
+    memset(chk, 0, sizeof(chk));
+    retVal = retVal &&
+             AXP_21274_PchipDMA(&p, 0x40001000, chk, sizeof(chk), false);
+    retVal = retVal && (memcmp(chk, buf, sizeof(buf)) == 0);
+    retVal = retVal &&
+             (AXP_21274_PchipDMA(&p, 0x50000000, chk, 8, false) == false) &&
+             (p.perror.nds == 1);
+    return(retVal);
+}
+
+/*
+ * test_sg
+ *  A transfer through a scatter-gather window goes to the pages mapped by
+ *  the PTEs, which are cached until invalidated, and one to an invalid PTE
+ *  fails.
+ */
+bool test_sg(void)
+{
+    u64 *pte = (u64 *) Test_Memory(TEST_TABLE_PA);
+    u64 page;
+    int ii;
+    bool retVal = true;
+
+    p.wsba1.addr = 0x800;		/* PCI 2GB */
+    p.wsba1.sg = AXP_SG_ENABLE;
+    p.wsba1.ena = AXP_ENA_ENABLE;
+    p.wsm1.am = 0;			/* 1MB */
+    p.tba1.addr = TEST_TABLE_PA >> 10;
+
+    /*
+     * Map the pages of the window backwards, with the first one at the start
+     * of the second memory array.
+     */
+    for (ii = 0; ii < 4; ii++)
+    {
+        page = (TEST_ARRAY_SIZE - (ii * 3 * AXP_21274_SG_PAGE)) >> 13;
+        pte[ii] = (page << 1) | 1;
+    }
+    pte[4] = 0;
+    Test_Fill(buf, sizeof(buf), 2);
+    retVal = AXP_21274_PchipDMA(&p, 0x80000000, buf, sizeof(buf), true);
+    for (ii = 0; ii < 4; ii++)
+    {
+        retVal = retVal &&
+                 (memcmp(Test_Memory((pte[ii] >> 1) << 13),
+                         &buf[ii * AXP_21274_SG_PAGE],
+                         AXP_21274_SG_PAGE) == 0);
+    }
+    printf("    Scattered write %s\n", retVal ? "passed" : "failed");
+
+    /*
+     * Change the first PTE.  Until TLBIV is written, the old one is still
+     * used.
+     */
+    pte[0] = ((TEST_SG_PA >> 13) << 1) | 1;
+    Test_Fill(buf, AXP_21274_SG_PAGE, 3);
+    retVal = retVal &&
+             AXP_21274_PchipDMA(&p, 0x80000000, buf, 64, true) &&
+             (memcmp(Test_Memory(TEST_ARRAY_SIZE), buf, 64) == 0);
+    retVal = retVal && Test_TLBIV(0x80000000);
+    retVal = retVal &&
+             AXP_21274_PchipDMA(&p, 0x80000000, buf, 64, true) &&
+             (memcmp(Test_Memory(TEST_SG_PA), buf, 64) == 0);
+    printf("    TLB invalidate %s\n", retVal ? "passed" : "failed");
+    retVal = retVal &&
+             (AXP_21274_PchipDMA(&p,
+                                 0x80000000 + (4 * AXP_21274_SG_PAGE),
+                                 buf,
+                                 8,
+                                 false) == false) &&
+             (p.perror.sge == 1);
+    return(retVal);
+}
+
+/*
+ * test_queue
+ *  More DMA write requests than fit on the DMA queue are all done, in order.
+ */
+bool test_queue(void)
+{
+    AXP_CAPbusMsg msg;
+    u64 *mem = (u64 *) Test_Memory(TEST_SG_PA);
+    u32 ii;
+    bool retVal = true;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.cmd = DMAWriteNQW;
+    msg.mask = 0x01;
+    for (ii = 0; ii < (4 * AXP_21274_PCHIP_QUE_LEN); ii++)
+    {
+        msg.addr = (TEST_SG_PA >> 3) + (ii % 8);
+        msg.data[0] = ii;
+        AXP_21274_PchipQueue(&p, &msg);
+    }
+    for (ii = 0;
+         (ii < 100) && ((p.dma.count != 0) || (p.pio.count != 0));
+         ii++)
+    {
+        usleep(1000);
+    }
+    for (ii = 0; ii < 8; ii++)
+    {
+        retVal = retVal &&
+                 (mem[ii] == ((3 * AXP_21274_PCHIP_QUE_LEN) + 8 + ii));
+    }
+    return(retVal);
+}
+
+/*
+ * Test_Invalidate
+ *  Record the memory the Pchip has had invalidated in the CPUs' caches.
+ */
+void Test_Invalidate(void *arg, u64 pa, u32 len)
+{
+    invalPA = pa;
+    invalLen += len;
+    return;
+}
+
+/*
+ * test_invalidate
+ *  Memory written by a DMA, but not memory read by one, is invalidated in the
+ *  CPUs' caches.
+ */
+bool test_invalidate(void)
+{
+    bool retVal;
+
+    p.invalidate = Test_Invalidate;
+    invalPA = 0;
+    invalLen = 0;
+    retVal = AXP_21274_PchipDMA(&p, 0x40000100, buf, 256, false) &&
+             (invalLen == 0);
+    retVal = retVal &&
+             AXP_21274_PchipDMA(&p, 0x40000100, buf, 256, true) &&
+             (invalPA == (TEST_DIRECT_PA + 0x100)) &&
+             (invalLen == 256);
+    p.invalidate = NULL;
+    return(retVal);
+}
+
+/*
+ * Test_DevRead
+ *  The test device returns the quadword at the offset into its register
+ *  array for the BAR.
+ */
+u64 Test_DevRead(void *ctx, u32 bar, u64 offset, u32 len)
+{
+    u64 value = 0;
+
+    memcpy(&value, &((u8 *) ((u64 (*)[64]) ctx)[bar])[offset], len);
+    return(value);
+}
+
+/*
+ * Test_DevWrite
+ *  The test device stores the data at the offset into its register array for
+ *  the BAR.
+ */
+void Test_DevWrite(void *ctx, u32 bar, u64 offset, u64 data, u32 len)
+{
+    memcpy(&((u8 *) ((u64 (*)[64]) ctx)[bar])[offset], &data, len);
+    if ((bar == 1) && (offset == 0x20))
+    {
+        devSeen = *(u64 *) Test_Memory(TEST_SG_PA);
+    }
+    return;
+}
+
+/*
+ * Test_Irq
+ *  Record the interrupt line posted by the Pchip.
+ */
+void Test_Irq(void *arg, u32 irq, bool level)
+{
+    devIrq = irq;
+    devLevel = level;
+    return;
+}
+
+/*
+ * Test_Complete
+ *  Record the read request returned by the Pchip.
+ */
+void Test_Complete(void *arg, AXP_CAPbusMsg *msg)
+{
+    done = *msg;
+    return;
+}
+
+/*
+ * Test_PIO
+ *  Perform a single PIO request on the PCI bus.
+ */
+u64 Test_PIO(AXP_CAPbus_Command cmd, u64 addr, u32 mask, u64 data)
+{
+    AXP_CAPbusMsg msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.cmd = cmd;
+    msg.addr = addr >> 3;
+    msg.maskType = CAPbus_Lowngword;
+    msg.mask = mask;
+    msg.data[0] = data;
+    AXP_21274_PCIAccess(&p, &msg);
+    return(msg.data[0]);
+}
+
+/*
+ * test_pci
+ *  A registered device can have its BARs sized and programmed through its
+ *  configuration space, after which memory and I/O reads and writes in them
+ *  go to the device, and ones outside of them read as all ones.
+ */
+bool test_pci(void)
+{
+    AXP_CAPbusMsg msg;
+    int ii;
+    bool retVal;
+
+    dev.cfg.vendorID = 0x1011;
+    dev.cfg.deviceID = 0x0019;
+    dev.cfg.baseAddrReg[0] = AXP_PCI_BAR32;
+    dev.cfg.baseAddrReg[1] = 1;
+    dev.cfg.interruptPin = 1;
+    dev.barSize[0] = 4096;
+    dev.barSize[1] = 256;
+    dev.read = Test_DevRead;
+    dev.write = Test_DevWrite;
+    dev.ctx = devRegs;
+    p.irq = Test_Irq;
+    retVal = AXP_21274_PCIRegister(&p, &dev, 2) &&
+             (AXP_21274_PCIRegister(&p, &dev, 2) == false);
+
+    /*
+     * Slot 2 is IDSEL bit 13 in the configuration address.
+     */
+    retVal = retVal &&
+             (Test_PIO(PCI_ConfigRead, 2 << 11, 0x01, 0) == 0x00191011) &&
+             (Test_PIO(PCI_ConfigRead, 3 << 11, 0x01, 0) == 0xffffffff);
+    Test_PIO(PCI_ConfigWrite, (2 << 11) | AXP_PCI_CFG_BAR0, 0x03, ~0ll);
+    retVal = retVal &&
+             (Test_PIO(PCI_ConfigRead, (2 << 11) | AXP_PCI_CFG_BAR0, 0x03, 0)
+              == 0xffffff01fffff000ll);
+    printf("    Configuration space %s\n", retVal ? "passed" : "failed");
+
+    /*
+     * Nothing is decoded until the command register, which is the second
+     * longword of the first quadword, enables it.
+     */
+    Test_PIO(PCI_ConfigWrite,
+             (2 << 11) | AXP_PCI_CFG_BAR0,
+             0x03,
+             0x0000100100200000ll);
+    retVal = retVal &&
+             (Test_PIO(PIO_MemoryRead, 0x00200008, 0x01, 0) == 0xffffffff);
+    Test_PIO(PCI_ConfigWrite, 2 << 11, 0x02, 0x03ll << 32);
+    Test_PIO(PIO_MemoryWriteCPU, 0x00200008, 0x01, 0x12345678);
+    Test_PIO(PIO_Write, 0x1010, 0x01, 0x9abcdef0);
+    retVal = retVal &&
+             (devRegs[0][1] == 0x12345678) &&
+             (devRegs[1][2] == 0x9abcdef0) &&
+             (Test_PIO(PIO_MemoryRead, 0x00200008, 0x01, 0) == 0x12345678) &&
+             (Test_PIO(PIO_Read, 0x1010, 0x01, 0) == 0x9abcdef0) &&
+             (Test_PIO(PIO_MemoryRead, 0x00201000, 0x01, 0) == 0xffffffff);
+    printf("    BAR dispatch %s\n", retVal ? "passed" : "failed");
+
+    /*
+     * Only the bytes in the mask are written, even when they are not next to
+     * each other.
+     */
+    devRegs[1][3] = 0;
+    memset(&msg, 0, sizeof(msg));
+    msg.cmd = PIO_Write;
+    msg.addr = 0x1018 >> 3;
+    msg.maskType = CAPbus_Byte;
+    msg.mask = 0x25;
+    msg.data[0] = 0x8877665544332211ll;
+    AXP_21274_PCIAccess(&p, &msg);
+    retVal = retVal && (devRegs[1][3] == 0x0000660000330011ll);
+    printf("    Byte mask %s\n", retVal ? "passed" : "failed");
+
+    /*
+     * A read queued to the Pchip is returned, with where it is to go.
+     */
+    p.complete = Test_Complete;
+    msg.cmd = PIO_Read;
+    msg.maskType = CAPbus_Quadword;
+    msg.mask = 0x01;
+    msg.data[0] = 0;
+    msg.cpuID = 1;
+    msg.id = 5;
+    AXP_21274_PchipQueue(&p, &msg);
+    for (ii = 0; (ii < 100) && (done.cmd != PIO_Read); ii++)
+    {
+        usleep(1000);
+    }
+    retVal = retVal &&
+             (done.cmd == PIO_Read) &&
+             (done.cpuID == 1) &&
+             (done.id == 5) &&
+             (done.data[0] == 0x0000660000330011ll);
+    printf("    Read completion %s\n", retVal ? "passed" : "failed");
+
+    /*
+     * A DMA queued behind a PIO write is done after it.
+     */
+    *(u64 *) Test_Memory(TEST_SG_PA) = 0;
+    devSeen = ~0ll;
+    memset(&msg, 0, sizeof(msg));
+    msg.cmd = PIO_Write;
+    msg.addr = 0x1020 >> 3;
+    msg.maskType = CAPbus_Lowngword;
+    msg.mask = 0x01;
+    AXP_21274_PchipQueue(&p, &msg);
+    msg.cmd = DMAWriteNQW;
+    msg.addr = TEST_SG_PA >> 3;
+    msg.data[0] = 0x5a;
+    AXP_21274_PchipQueue(&p, &msg);
+    for (ii = 0;
+         (ii < 100) && ((p.dma.count != 0) || (p.pio.count != 0));
+         ii++)
+    {
+        usleep(1000);
+    }
+    retVal = retVal &&
+             (devSeen == 0) &&
+             (*(u64 *) Test_Memory(TEST_SG_PA) == 0x5a);
+    printf("    PIO and DMA ordering %s\n", retVal ? "passed" : "failed");
+    AXP_21274_PCIInterrupt(&dev, true);
+    retVal = retVal && (devIrq == 8) && (devLevel == true);
+    return(retVal);
+}
+
+/*
+ * test_peer
+ *  A DMA that does not hit in any of the Pchip's windows goes to the device
+ *  on the other Pchip's bus that claims it, and fails when none does.
+ */
+bool test_peer(void)
+{
+    AXP_CAPbusMsg msg;
+    u8 *regs = (u8 *) peerRegs[0];
+    bool retVal;
+
+    peerDev.cfg.baseAddrReg[0] = AXP_PCI_BAR32;
+    peerDev.barSize[0] = 4096;
+    peerDev.read = Test_DevRead;
+    peerDev.write = Test_DevWrite;
+    peerDev.ctx = peerRegs;
+    retVal = AXP_21274_PCIRegister(&q, &peerDev, 1);
+    memset(&msg, 0, sizeof(msg));
+    msg.cmd = PCI_ConfigWrite;
+    msg.addr = ((1 << 11) | AXP_PCI_CFG_BAR0) >> 3;
+    msg.maskType = CAPbus_Lowngword;
+    msg.mask = 0x01;
+    msg.data[0] = 0x60000000;
+    AXP_21274_PCIAccess(&q, &msg);
+    msg.addr = (1 << 11) >> 3;
+    msg.mask = 0x02;
+    msg.data[0] = 0x02ll << 32;
+    AXP_21274_PCIAccess(&q, &msg);
+    p.peer = &q;
+    q.peer = &p;
+    p.perror.nds = 0;
+
+    /*
+     * Whole longwords and odd bytes both get to the device.
+     */
+    Test_Fill(buf, 16, 4);
+    retVal = retVal &&
+             AXP_21274_PchipDMA(&p, 0x60000104, buf, 12, true) &&
+             (memcmp(&regs[0x104], buf, 12) == 0);
+    memset(chk, 0, 16);
+    retVal = retVal &&
+             AXP_21274_PchipDMA(&p, 0x60000103, chk, 9, false) &&
+             (memcmp(chk, &regs[0x103], 9) == 0) &&
+             (p.perror.nds == 0);
+    printf("    Peer-to-peer transfer %s\n", retVal ? "passed" : "failed");
+    retVal = retVal &&
+             (AXP_21274_PchipDMA(&p, 0x70000000, chk, 8, false) == false) &&
+             (p.perror.nds == 1);
+    return(retVal);
+}
+
+int main(void)
+{
+    int ii;
+    bool retVal;
+
+    printf("\nDECaxp Pchip DMA Testing...\n");
+    for (ii = 0; ii < TEST_ARRAYS; ii++)
+    {
+        arrays[ii] = calloc(1, TEST_ARRAY_SIZE);
+    }
+    pthread_mutex_init(&p.mutex, NULL);
+    pthread_mutex_init(&p.tlbMutex, NULL);
+    pthread_mutex_init(&p.pciMutex, NULL);
+    pthread_cond_init(&p.cond, NULL);
+    pthread_cond_init(&p.space, NULL);
+    pthread_mutex_init(&q.mutex, NULL);
+    pthread_mutex_init(&q.tlbMutex, NULL);
+    pthread_mutex_init(&q.pciMutex, NULL);
+    pthread_cond_init(&q.cond, NULL);
+    pthread_cond_init(&q.space, NULL);
+    AXP_21274_PchipInit(&p, 0, arrays, TEST_ARRAYS, TEST_ARRAY_SIZE);
+    AXP_21274_PchipInit(&q, 1, arrays, TEST_ARRAYS, TEST_ARRAY_SIZE);
+    pthread_create(&p.threadID, NULL, AXP_21274_PchipMain, &p);
+    pthread_create(&q.threadID, NULL, AXP_21274_PchipMain, &q);
+    printf("\nTesting a direct mapped window...\n");
+    retVal = test_direct();
+    if (retVal == true)
+    {
+        printf("\nTesting a scatter-gather window...\n");
+        retVal = test_sg();
+    }
+    if (retVal == true)
+    {
+        printf("\nTesting the DMA queue...\n");
+        retVal = test_queue();
+    }
+    if (retVal == true)
+    {
+        printf("\nTesting cache invalidation...\n");
+        retVal = test_invalidate();
+    }
+    if (retVal == true)
+    {
+        printf("\nTesting the PCI bus...\n");
+        retVal = test_pci();
+    }
+    if (retVal == true)
+    {
+        printf("\nTesting peer-to-peer DMA...\n");
+        retVal = test_peer();
+    }
+    AXP_21274_PchipStop(&p);
+    AXP_21274_PchipStop(&q);
+    if (retVal == true)
+    {
+        printf("All Tests Successful!\n");
+    }
+    else
+    {
+        printf("At Least One Test Failed.\n");
+    }
+    return(0);
+}
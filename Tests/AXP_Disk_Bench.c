@@ -0,0 +1,1100 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains a benchmark for the virtual disk code.  For each
+ *  selected disk format, a temporary disk is created, filled, and then
+ *  sequential and random read and write workloads are run against it through
+ *  the AXP_VirtualDisk interface.  Each workload is run in each of the
+ *  selected I/O modes:
+ *
+ *      sync    - one request at a time, directly to the disk format code.
+ *      async   - the requested queue depth, one thread per outstanding
+ *                request, directly to the disk format code.
+ *      cached  - the requested queue depth, through the host block cache.
+ *      mmap    - the requested queue depth, reads copied out of a mapping of
+ *                the disk image (writes still go through the disk format
+ *                code).
+ *
+ *  For each run, the I/Os per second, throughput, and latency percentiles are
+ *  reported.  Combinations the disk format does not support are reported as
+ *  such, rather than failing the benchmark.
+ *
+ *  Usage:
+ *
+ *      AXP_Disk_Bench [-b backends] [-m modes] [-w workloads] [-s blockSize]
+ *                     [-q queueDepth] [-n operations] [-S diskMB]
+ *                     [-c cacheMB] [-r seed] [-d directory] [-k]
+ *
+ *  Where backends is a comma separated list of fvhd, dvhd, vhdx, raw, ssd or
+ *  all, modes is a list of sync, async, cached, mmap or all, and workloads is
+ *  a list of seqread, seqwrite, randread, randwrite or all.
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Report the block cache hits and misses for each run in cached mode.
+ */
+#include "Devices/VirtualDisks/AXP_VirtualDisk.h"
+#include "Devices/VirtualDisks/AXP_VHD_Cache.h"
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_Blocks.h"
+#include "CommonUtilities/AXP_Trace.h"
+#include <getopt.h>
+#include <time.h>
+
+#define AXP_BENCH_SEC_SIZE      512
+#define AXP_BENCH_MAX_QD        64
+#define AXP_BENCH_MAX_FILENAME  256
+#define AXP_BENCH_DEF_BLOCK     FOUR_K
+#define AXP_BENCH_DEF_QD        4
+#define AXP_BENCH_DEF_OPS       8192
+#define AXP_BENCH_DEF_DISK_MB   64
+#define AXP_BENCH_DEF_CACHE_MB  16
+#define AXP_BENCH_DEF_READ_AHEAD 32
+#define AXP_BENCH_FILL_SIZE     ONE_M
+
+typedef enum
+{
+    Bench_FixedVHD,
+    Bench_DynamicVHD,
+    Bench_VHDX,
+    Bench_RAW,
+    Bench_SSD,
+    Bench_Backends
+} AXP_BENCH_BACKEND;
+
+typedef enum
+{
+    Bench_Sync,
+    Bench_Async,
+    Bench_Cached,
+    Bench_Mmap,
+    Bench_Modes
+} AXP_BENCH_MODE;
+
+typedef enum
+{
+    Bench_SeqRead,
+    Bench_SeqWrite,
+    Bench_RandRead,
+    Bench_RandWrite,
+    Bench_Workloads
+} AXP_BENCH_WORKLOAD;
+
+static const char *_backendNames[Bench_Backends] =
+{
+    "fvhd",
+    "dvhd",
+    "vhdx",
+    "raw",
+    "ssd"
+};
+static const char *_backendExt[Bench_Backends] =
+{
+    "vhd",
+    "vhd",
+    "vhdx",
+    "raw",
+    "ssd"
+};
+static const char *_modeNames[Bench_Modes] =
+{
+    "sync",
+    "async",
+    "cached",
+    "mmap"
+};
+static const char *_workloadNames[Bench_Workloads] =
+{
+    "seqread",
+    "seqwrite",
+    "randread",
+    "randwrite"
+};
+
+/*
+ * This structure contains the information for one of the threads issuing
+ * I/Os for a run.  Worker N of M issues operations N, N+M, N+2M, ..., so the
+ * sequential workloads walk the disk in order with M requests outstanding.
+ */
+typedef struct
+{
+    AXP_VHD_HANDLE handle;
+    pthread_mutex_t *ioMutex;
+    AXP_BENCH_WORKLOAD workload;
+    bool mapped;
+    u64 diskBlocks;
+    u32 blkSectors;
+    u32 first;
+    u32 stride;
+    u32 ops;
+    u64 seed;
+    u8 *buf;
+    u64 *latency;
+    u32 done;
+    u32 retVal;
+} AXP_BENCH_WORKER;
+
+/*
+ * This structure contains the options the benchmark was run with.
+ */
+typedef struct
+{
+    bool backends[Bench_Backends];
+    bool modes[Bench_Modes];
+    bool workloads[Bench_Workloads];
+    u32 blkSize;
+    u32 queueDepth;
+    u32 ops;
+    u64 diskSize;
+    u64 cacheSize;
+    u64 seed;
+    char *directory;
+    bool keep;
+} AXP_BENCH_OPTIONS;
+
+/*
+ * _AXP_Bench_Now
+ *  This function is called to get the current time, in nanoseconds, from the
+ *  monotonic clock.
+ *
+ * Input Parameters:
+ *  None.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  The current monotonic time in nanoseconds.
+ */
+static u64 _AXP_Bench_Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return(((u64) now.tv_sec * 1000000000ull) + (u64) now.tv_nsec);
+}
+
+/*
+ * _AXP_Bench_Random
+ *  This function is called to return the next value from a worker's xorshift
+ *  pseudo-random sequence.  Each worker has its own sequence, so the random
+ *  workloads do not contend on a shared generator.
+ *
+ * Input Parameters:
+ *  seed:
+ *      A pointer to the worker's current state.
+ *
+ * Output Parameters:
+ *  seed:
+ *      A pointer to the updated state.
+ *
+ * Return Values:
+ *  The next pseudo-random value.
+ */
+static u64 _AXP_Bench_Random(u64 *seed)
+{
+    u64 x = *seed;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seed = x;
+    return(x);
+}
+
+/*
+ * _AXP_Bench_Compare
+ *  This function is called by qsort to put the latencies in ascending order.
+ *
+ * Input Parameters:
+ *  a:
+ *      A pointer to the first latency.
+ *  b:
+ *      A pointer to the second latency.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  <0: a is less than b.
+ *  0:  a and b are equal.
+ *  >0: a is greater than b.
+ */
+static int _AXP_Bench_Compare(const void *a, const void *b)
+{
+    u64 la = *(const u64 *) a;
+    u64 lb = *(const u64 *) b;
+
+    return((la > lb) - (la < lb));
+}
+
+/*
+ * _AXP_Bench_Worker
+ *  This function is the thread that issues the I/Os for one outstanding
+ *  request slot of a run.  The latency of each I/O is recorded.  The worker
+ *  stops at the first error.
+ *
+ * Input Parameters:
+ *  arg:
+ *      A pointer to the AXP_BENCH_WORKER structure for this worker.
+ *
+ * Output Parameters:
+ *  arg:
+ *      The done, latency and retVal fields are updated.
+ *
+ * Return Values:
+ *  NULL.
+ */
+static void *_AXP_Bench_Worker(void *arg)
+{
+    AXP_BENCH_WORKER *worker = (AXP_BENCH_WORKER *) arg;
+    size_t bytes = (size_t) worker->blkSectors * AXP_BENCH_SEC_SIZE;
+    u8 *mapAddr;
+    u64 block;
+    u64 start;
+    u32 sectors;
+    u32 op;
+
+    worker->retVal = AXP_VHD_SUCCESS;
+    for (op = worker->first;
+         ((worker->done < worker->ops) &&
+          (worker->retVal == AXP_VHD_SUCCESS));
+         op += worker->stride)
+    {
+        if ((worker->workload == Bench_SeqRead) ||
+            (worker->workload == Bench_SeqWrite))
+        {
+            block = op % worker->diskBlocks;
+        }
+        else
+        {
+            block = _AXP_Bench_Random(&worker->seed) % worker->diskBlocks;
+        }
+        sectors = worker->blkSectors;
+        start = _AXP_Bench_Now();
+        if (worker->ioMutex != NULL)
+        {
+            pthread_mutex_lock(worker->ioMutex);
+        }
+        if ((worker->workload == Bench_SeqWrite) ||
+            (worker->workload == Bench_RandWrite))
+        {
+            worker->retVal = AXP_VHD_WriteSectors(worker->handle,
+                                                  block * sectors,
+                                                  &sectors,
+                                                  worker->buf);
+        }
+        else if (worker->mapped == true)
+        {
+            worker->retVal = AXP_VHD_GetMappedSectors(worker->handle,
+                                                      block * sectors,
+                                                      sectors,
+                                                      &mapAddr);
+            if (worker->retVal == AXP_VHD_SUCCESS)
+            {
+                memcpy(worker->buf, mapAddr, bytes);
+            }
+        }
+        else
+        {
+            worker->retVal = AXP_VHD_ReadSectors(worker->handle,
+                                                 block * sectors,
+                                                 &sectors,
+                                                 worker->buf);
+        }
+        if (worker->ioMutex != NULL)
+        {
+            pthread_mutex_unlock(worker->ioMutex);
+        }
+        worker->latency[worker->done++] = _AXP_Bench_Now() - start;
+    }
+
+    /*
+     * Return back to the caller.
+     */
+    return(NULL);
+}
+
+/*
+ * _AXP_Bench_CreateDisk
+ *  This function is called to create the temporary disk for a backend.  RAW
+ *  disks cannot be created through the virtual disk interface, so a file of
+ *  the requested size is created for them.
+ *
+ * Input Parameters:
+ *  backend:
+ *      A value indicating the format of the disk to create.
+ *  path:
+ *      A pointer to the name of the file to create.
+ *  diskSize:
+ *      A value indicating the size, in bytes, of the disk.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal successful completion.
+ *  AXP_VHD_WRITE_FAULT:    The RAW disk file could not be created.
+ *  Any of the return values from AXP_VHD_Create.
+ */
+static u32 _AXP_Bench_CreateDisk(AXP_BENCH_BACKEND backend,
+                                 char *path,
+                                 u64 diskSize)
+{
+    AXP_VHD_STORAGE_TYPE storageType;
+    AXP_VHD_CREATE_PARAM createParam;
+    AXP_VHD_CREATE_FLAG flags = CREATE_NONE;
+    AXP_VHD_HANDLE handle;
+    FILE *fp;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    memset(&storageType, 0, sizeof(storageType));
+    memset(&createParam, 0, sizeof(createParam));
+    createParam.ver = CREATE_VER_1;
+    createParam.ver_1.maxSize = diskSize;
+    createParam.ver_1.sectorSize = AXP_BENCH_SEC_SIZE;
+    switch (backend)
+    {
+        case Bench_FixedVHD:
+            flags = CREATE_FULL_PHYSICAL_ALLOCATION;
+            storageType.deviceID = STORAGE_TYPE_DEV_VHD;
+            createParam.ver_1.blkSize = AXP_VHD_DEF_BLK;
+            break;
+
+        case Bench_DynamicVHD:
+            storageType.deviceID = STORAGE_TYPE_DEV_VHD;
+            createParam.ver_1.blkSize = AXP_VHD_DEF_BLK;
+            break;
+
+        case Bench_VHDX:
+            storageType.deviceID = STORAGE_TYPE_DEV_VHDX;
+            createParam.ver_1.blkSize = AXP_VHD_DEF_BLK;
+            break;
+
+        case Bench_SSD:
+            storageType.deviceID = STORAGE_TYPE_DEV_SSD;
+            break;
+
+        case Bench_RAW:
+        default:
+            storageType.deviceID = STORAGE_TYPE_DEV_RAW;
+            fp = fopen(path, "wb");
+            if ((fp != NULL) &&
+                (fseek(fp, diskSize - 1, SEEK_SET) == 0) &&
+                (fputc(0, fp) != EOF))
+            {
+                fclose(fp);
+            }
+            else
+            {
+                if (fp != NULL)
+                {
+                    fclose(fp);
+                }
+                retVal = AXP_VHD_WRITE_FAULT;
+            }
+            break;
+    }
+    if (storageType.deviceID != STORAGE_TYPE_DEV_RAW)
+    {
+        retVal = AXP_VHD_Create(&storageType,
+                                path,
+                                ACCESS_NONE,
+                                NULL,
+                                flags,
+                                0,
+                                &createParam,
+                                NULL,
+                                &handle);
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            AXP_VHD_CloseHandle(handle);
+        }
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_Bench_OpenDisk
+ *  This function is called to open the temporary disk for a backend in a
+ *  particular I/O mode.  The block cache is resized before the open, so that
+ *  only the cached mode has a cache to attach to.
+ *
+ * Input Parameters:
+ *  backend:
+ *      A value indicating the format of the disk.
+ *  mode:
+ *      A value indicating the I/O mode the disk is being opened for.
+ *  path:
+ *      A pointer to the name of the disk file.
+ *  cacheSize:
+ *      A value indicating the size, in bytes, of the cache for cached mode.
+ *
+ * Output Parameters:
+ *  handle:
+ *      A pointer to the location to receive the handle of the opened disk.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal successful completion.
+ *  Any of the return values from AXP_VHD_Open.
+ */
+static u32 _AXP_Bench_OpenDisk(AXP_BENCH_BACKEND backend,
+                               AXP_BENCH_MODE mode,
+                               char *path,
+                               u64 cacheSize,
+                               AXP_VHD_HANDLE *handle)
+{
+    AXP_VHD_STORAGE_TYPE storageType;
+    static const u32 deviceIDs[Bench_Backends] =
+    {
+        STORAGE_TYPE_DEV_VHD,
+        STORAGE_TYPE_DEV_VHD,
+        STORAGE_TYPE_DEV_VHDX,
+        STORAGE_TYPE_DEV_RAW,
+        STORAGE_TYPE_DEV_SSD
+    };
+
+    if (mode == Bench_Cached)
+    {
+        AXP_VHD_CacheInit(cacheSize, 0, AXP_BENCH_DEF_READ_AHEAD);
+    }
+    else
+    {
+        AXP_VHD_CacheInit(0, 0, 0);
+    }
+    memset(&storageType, 0, sizeof(storageType));
+    storageType.deviceID = deviceIDs[backend];
+
+    /*
+     * Return the outcome of the open back to the caller.
+     */
+    return(AXP_VHD_Open(&storageType,
+                        path,
+                        ACCESS_ALL,
+                        (mode == Bench_Mmap) ? OPEN_MAPPED_IO : OPEN_NO_PARENTS,
+                        NULL,
+                        handle));
+}
+
+/*
+ * _AXP_Bench_Fill
+ *  This function is called to write the whole of a newly created disk, so
+ *  that the read workloads read data that is actually on the disk, rather
+ *  than unallocated blocks of a dynamic disk.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A value for the handle of the opened disk.
+ *  diskSize:
+ *      A value indicating the size, in bytes, of the disk.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal successful completion.
+ *  AXP_VHD_OUTOFMEMORY:    Insufficient memory for the fill buffer.
+ *  Any of the return values from AXP_VHD_WriteSectors.
+ */
+static u32 _AXP_Bench_Fill(AXP_VHD_HANDLE handle, u64 diskSize)
+{
+    u8 *buf;
+    u64 lba;
+    u32 sectors;
+    u32 ii;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    buf = AXP_Allocate_Block(-(i32) AXP_BENCH_FILL_SIZE, NULL);
+    if (buf != NULL)
+    {
+        for (ii = 0; ii < AXP_BENCH_FILL_SIZE; ii++)
+        {
+            buf[ii] = (u8) (ii * 7);
+        }
+        for (lba = 0;
+             ((lba < (diskSize / AXP_BENCH_SEC_SIZE)) &&
+              (retVal == AXP_VHD_SUCCESS));
+             lba += AXP_BENCH_FILL_SIZE / AXP_BENCH_SEC_SIZE)
+        {
+            sectors = AXP_BENCH_FILL_SIZE / AXP_BENCH_SEC_SIZE;
+            retVal = AXP_VHD_WriteSectors(handle, lba, &sectors, buf);
+        }
+        AXP_Deallocate_Block(buf);
+    }
+    else
+    {
+        retVal = AXP_VHD_OUTOFMEMORY;
+    }
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_Bench_Run
+ *  This function is called to run one workload against an opened disk, and
+ *  print the results.  The elapsed time of a write workload includes writing
+ *  back whatever the cache is still holding, so that write-back caching is
+ *  not credited with writes it has not done yet.  In cached mode, the cache
+ *  hits and misses during the run are also reported.
+ *
+ * Input Parameters:
+ *  handle:
+ *      A value for the handle of the opened disk.
+ *  backend:
+ *      A value indicating the format of the disk.
+ *  mode:
+ *      A value indicating the I/O mode the disk was opened for.
+ *  workload:
+ *      A value indicating the workload to run.
+ *  opts:
+ *      A pointer to the options the benchmark was run with.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  AXP_VHD_SUCCESS:        Normal successful completion.
+ *  AXP_VHD_OUTOFMEMORY:    Insufficient memory for the workers.
+ *  Any of the return values from the read and write functions.
+ */
+static u32 _AXP_Bench_Run(AXP_VHD_HANDLE handle,
+                          AXP_BENCH_BACKEND backend,
+                          AXP_BENCH_MODE mode,
+                          AXP_BENCH_WORKLOAD workload,
+                          AXP_BENCH_OPTIONS *opts)
+{
+    AXP_BENCH_WORKER workers[AXP_BENCH_MAX_QD];
+    pthread_t threads[AXP_BENCH_MAX_QD];
+    pthread_mutex_t ioMutex = PTHREAD_MUTEX_INITIALIZER;
+    AXP_VHD_CACHE_STATS before, after;
+    char hits[24], misses[24];
+    u64 *latency;
+    u64 start, elapsed;
+    u64 pct[4];
+    double seconds, iops, mbs;
+    u32 queueDepth = (mode == Bench_Sync) ? 1 : opts->queueDepth;
+    u32 total = 0;
+    u32 ii;
+    u32 retVal = AXP_VHD_SUCCESS;
+
+    latency = AXP_Allocate_Block(-(i32) (opts->ops * sizeof(u64)), NULL);
+    if (latency == NULL)
+    {
+        return(AXP_VHD_OUTOFMEMORY);
+    }
+    memset(workers, 0, sizeof(workers));
+    for (ii = 0; ii < queueDepth; ii++)
+    {
+        workers[ii].handle = handle;
+
+        /*
+         * The VHD code does its I/O through a stdio stream, which cannot have
+         * more than one request in progress, so it only gets one at a time
+         * when the cache is not doing the I/O for it.
+         */
+        if ((mode != Bench_Cached) &&
+            ((backend == Bench_FixedVHD) || (backend == Bench_DynamicVHD)))
+        {
+            workers[ii].ioMutex = &ioMutex;
+        }
+        workers[ii].workload = workload;
+        workers[ii].mapped = mode == Bench_Mmap;
+        workers[ii].blkSectors = opts->blkSize / AXP_BENCH_SEC_SIZE;
+        workers[ii].diskBlocks = opts->diskSize / opts->blkSize;
+        workers[ii].first = ii;
+        workers[ii].stride = queueDepth;
+        workers[ii].ops = (opts->ops / queueDepth) +
+                          ((ii < (opts->ops % queueDepth)) ? 1 : 0);
+        workers[ii].seed = (opts->seed * (ii + 1)) | 1;
+        workers[ii].latency = &latency[total];
+        workers[ii].buf = AXP_Allocate_Block(-(i32) opts->blkSize, NULL);
+        if (workers[ii].buf == NULL)
+        {
+            retVal = AXP_VHD_OUTOFMEMORY;
+        }
+        else
+        {
+            memset(workers[ii].buf, 0xa5 + ii, opts->blkSize);
+        }
+        total += workers[ii].ops;
+    }
+
+    /*
+     * Start the clock, start the workers, and wait for them all to finish.
+     */
+    AXP_VHD_CacheGetStats(&before);
+    start = _AXP_Bench_Now();
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        if (queueDepth == 1)
+        {
+            _AXP_Bench_Worker(&workers[0]);
+        }
+        else
+        {
+            for (ii = 0; ii < queueDepth; ii++)
+            {
+                pthread_create(&threads[ii],
+                               NULL,
+                               _AXP_Bench_Worker,
+                               &workers[ii]);
+            }
+            for (ii = 0; ii < queueDepth; ii++)
+            {
+                pthread_join(threads[ii], NULL);
+            }
+        }
+        for (ii = 0; ii < queueDepth; ii++)
+        {
+            if (workers[ii].retVal != AXP_VHD_SUCCESS)
+            {
+                retVal = workers[ii].retVal;
+            }
+        }
+        if ((retVal == AXP_VHD_SUCCESS) &&
+            ((workload == Bench_SeqWrite) || (workload == Bench_RandWrite)))
+        {
+            retVal = AXP_VHD_CacheFlush(handle);
+        }
+    }
+    elapsed = _AXP_Bench_Now() - start;
+    AXP_VHD_CacheGetStats(&after);
+
+    /*
+     * If all the I/Os completed, then sort the latencies, and report the
+     * results.
+     */
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        qsort(latency, total, sizeof(u64), _AXP_Bench_Compare);
+        pct[0] = latency[(total * 50) / 100];
+        pct[1] = latency[(total * 90) / 100];
+        pct[2] = latency[(total * 99) / 100];
+        pct[3] = latency[(total * 999) / 1000];
+        seconds = (double) elapsed / 1.0e9;
+        iops = (double) total / seconds;
+        mbs = (iops * opts->blkSize) / (double) ONE_M;
+        if (mode == Bench_Cached)
+        {
+            snprintf(hits, sizeof(hits), "%llu", after.hits - before.hits);
+            snprintf(misses,
+                     sizeof(misses),
+                     "%llu",
+                     after.misses - before.misses);
+        }
+        else
+        {
+            strcpy(hits, "-");
+            strcpy(misses, "-");
+        }
+        printf("%-5s %-6s %-9s %6u %3u %7u %10.0f %9.2f %8.1f %8.1f %8.1f "
+               "%8.1f %9.1f %8s %8s\n",
+               _backendNames[backend],
+               _modeNames[mode],
+               _workloadNames[workload],
+               opts->blkSize,
+               queueDepth,
+               total,
+               iops,
+               mbs,
+               (double) pct[0] / 1000.0,
+               (double) pct[1] / 1000.0,
+               (double) pct[2] / 1000.0,
+               (double) pct[3] / 1000.0,
+               (double) latency[total - 1] / 1000.0,
+               hits,
+               misses);
+    }
+    for (ii = 0; ii < queueDepth; ii++)
+    {
+        if (workers[ii].buf != NULL)
+        {
+            AXP_Deallocate_Block(workers[ii].buf);
+        }
+    }
+    AXP_Deallocate_Block(latency);
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_Bench_ParseList
+ *  This function is called to parse a comma separated list of names into an
+ *  array of selections.
+ *
+ * Input Parameters:
+ *  list:
+ *      A pointer to the comma separated list of names, or "all".
+ *  names:
+ *      A pointer to the array of valid names.
+ *  count:
+ *      A value indicating the number of valid names.
+ *
+ * Output Parameters:
+ *  selected:
+ *      A pointer to the array to receive which names were in the list.
+ *
+ * Return Values:
+ *  true:   The list was parsed.
+ *  false:  The list contained an unknown name.
+ */
+static bool _AXP_Bench_ParseList(char *list,
+                                 const char **names,
+                                 u32 count,
+                                 bool *selected)
+{
+    char *copy = strdup(list);
+    char *name, *save = NULL;
+    bool retVal = copy != NULL;
+    u32 ii;
+
+    for (ii = 0; ii < count; ii++)
+    {
+        selected[ii] = false;
+    }
+    for (name = (copy != NULL) ? strtok_r(copy, ",", &save) : NULL;
+         ((name != NULL) && (retVal == true));
+         name = strtok_r(NULL, ",", &save))
+    {
+        retVal = false;
+        for (ii = 0; ii < count; ii++)
+        {
+            if ((strcmp(name, "all") == 0) || (strcmp(name, names[ii]) == 0))
+            {
+                selected[ii] = true;
+                retVal = true;
+            }
+        }
+    }
+    free(copy);
+
+    /*
+     * Return the outcome of this call back to the caller.
+     */
+    return(retVal);
+}
+
+/*
+ * _AXP_Bench_Usage
+ *  This function is called to display how to run the benchmark.
+ *
+ * Input Parameters:
+ *  program:
+ *      A pointer to the name the benchmark was run as.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  None.
+ */
+static void _AXP_Bench_Usage(char *program)
+{
+    printf("Usage: %s [-b backends] [-m modes] [-w workloads] [-s blockSize]\n"
+           "       [-q queueDepth] [-n operations] [-S diskMB] [-c cacheMB]\n"
+           "       [-r seed] [-d directory] [-k]\n\n"
+           "  -b  fvhd,dvhd,vhdx,raw,ssd or all (default all)\n"
+           "  -m  sync,async,cached,mmap or all (default all)\n"
+           "  -w  seqread,seqwrite,randread,randwrite or all (default all)\n"
+           "  -s  bytes per I/O, a multiple of %d (default %d)\n"
+           "  -q  requests outstanding for async, cached and mmap "
+           "(default %d, max %d)\n"
+           "  -n  I/Os per run (default %d)\n"
+           "  -S  disk size in MB (default %d)\n"
+           "  -c  cache size in MB for cached mode (default %d)\n"
+           "  -r  seed for the random workloads\n"
+           "  -d  directory for the temporary disks (default $TMPDIR or "
+           "/tmp)\n"
+           "  -k  keep the temporary disks\n",
+           program,
+           AXP_BENCH_SEC_SIZE,
+           AXP_BENCH_DEF_BLOCK,
+           AXP_BENCH_DEF_QD,
+           AXP_BENCH_MAX_QD,
+           AXP_BENCH_DEF_OPS,
+           AXP_BENCH_DEF_DISK_MB,
+           AXP_BENCH_DEF_CACHE_MB);
+
+    /*
+     * Return back to the caller.
+     */
+    return;
+}
+
+/*
+ * main
+ *  This is the main function for the benchmark.
+ *
+ * Input Parameters:
+ *  argc:
+ *      A value indicating the number of arguments.
+ *  argv:
+ *      An array of pointers to the arguments.
+ *
+ * Output Parameters:
+ *  None.
+ *
+ * Return Values:
+ *  0:  All the selected runs either completed or are not supported by the
+ *      disk format.
+ *  1:  A run failed, or the arguments were not valid.
+ */
+int main(int argc, char **argv)
+{
+    AXP_BENCH_OPTIONS opts;
+    AXP_VHD_HANDLE handle;
+    char path[AXP_BENCH_MAX_FILENAME];
+    int backend, mode, workload;
+    int opt;
+    int exitCode = 0;
+    u32 retVal;
+
+    memset(&opts, 0, sizeof(opts));
+    _AXP_Bench_ParseList("all", _backendNames, Bench_Backends, opts.backends);
+    _AXP_Bench_ParseList("all", _modeNames, Bench_Modes, opts.modes);
+    _AXP_Bench_ParseList("all",
+                         _workloadNames,
+                         Bench_Workloads,
+                         opts.workloads);
+    opts.blkSize = AXP_BENCH_DEF_BLOCK;
+    opts.queueDepth = AXP_BENCH_DEF_QD;
+    opts.ops = AXP_BENCH_DEF_OPS;
+    opts.diskSize = (u64) AXP_BENCH_DEF_DISK_MB * ONE_M;
+    opts.cacheSize = (u64) AXP_BENCH_DEF_CACHE_MB * ONE_M;
+    opts.seed = 0x2545f4914f6cdd1dull;
+    opts.directory = getenv("TMPDIR");
+    if (opts.directory == NULL)
+    {
+        opts.directory = "/tmp";
+    }
+    while ((opt = getopt(argc, argv, "b:m:w:s:q:n:S:c:r:d:kh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                if (_AXP_Bench_ParseList(optarg,
+                                         _backendNames,
+                                         Bench_Backends,
+                                         opts.backends) == false)
+                {
+                    exitCode = 1;
+                }
+                break;
+
+            case 'm':
+                if (_AXP_Bench_ParseList(optarg,
+                                         _modeNames,
+                                         Bench_Modes,
+                                         opts.modes) == false)
+                {
+                    exitCode = 1;
+                }
+                break;
+
+            case 'w':
+                if (_AXP_Bench_ParseList(optarg,
+                                         _workloadNames,
+                                         Bench_Workloads,
+                                         opts.workloads) == false)
+                {
+                    exitCode = 1;
+                }
+                break;
+
+            case 's':
+                opts.blkSize = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'q':
+                opts.queueDepth = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'n':
+                opts.ops = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'S':
+                opts.diskSize = strtoull(optarg, NULL, 0) * ONE_M;
+                break;
+
+            case 'c':
+                opts.cacheSize = strtoull(optarg, NULL, 0) * ONE_M;
+                break;
+
+            case 'r':
+                opts.seed = strtoull(optarg, NULL, 0) | 1;
+                break;
+
+            case 'd':
+                opts.directory = optarg;
+                break;
+
+            case 'k':
+                opts.keep = true;
+                break;
+
+            default:
+                exitCode = 1;
+                break;
+        }
+    }
+    if ((exitCode != 0) ||
+        (opts.blkSize == 0) ||
+        ((opts.blkSize % AXP_BENCH_SEC_SIZE) != 0) ||
+        (opts.blkSize > AXP_BENCH_FILL_SIZE) ||
+        (opts.queueDepth == 0) ||
+        (opts.queueDepth > AXP_BENCH_MAX_QD) ||
+        (opts.ops < opts.queueDepth) ||
+        ((opts.diskSize % AXP_BENCH_FILL_SIZE) != 0) ||
+        (opts.diskSize < opts.blkSize))
+    {
+        _AXP_Bench_Usage(argv[0]);
+        return(1);
+    }
+
+    printf("%-5s %-6s %-9s %6s %3s %7s %10s %9s %8s %8s %8s %8s %9s %8s %8s\n",
+           "disk", "mode", "workload", "bs", "qd", "ops", "IOPS", "MB/s",
+           "p50us", "p90us", "p99us", "p99.9us", "maxus", "hits", "misses");
+    for (backend = 0; backend < Bench_Backends; backend++)
+    {
+        if (opts.backends[backend] == false)
+        {
+            continue;
+        }
+        snprintf(path,
+                 sizeof(path),
+                 "%s/AXP_Disk_Bench_%d_%s.%s",
+                 opts.directory,
+                 (int) getpid(),
+                 _backendNames[backend],
+                 _backendExt[backend]);
+        remove(path);
+
+        /*
+         * Create the disk, and write all of it once, before any of the runs.
+         */
+        retVal = _AXP_Bench_CreateDisk(backend, path, opts.diskSize);
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            retVal = _AXP_Bench_OpenDisk(backend,
+                                         Bench_Sync,
+                                         path,
+                                         0,
+                                         &handle);
+            if (retVal == AXP_VHD_SUCCESS)
+            {
+                retVal = _AXP_Bench_Fill(handle, opts.diskSize);
+                AXP_VHD_CloseHandle(handle);
+            }
+        }
+        if ((retVal == AXP_VHD_CALL_NOT_IMPL) ||
+            (retVal == AXP_VHD_NOT_SUPPORTED))
+        {
+            printf("%-5s not supported by this disk format (%u)\n",
+                   _backendNames[backend],
+                   retVal);
+        }
+        else if (retVal != AXP_VHD_SUCCESS)
+        {
+            printf("%-5s failed to create and fill %s (%u)\n",
+                   _backendNames[backend],
+                   path,
+                   retVal);
+            exitCode = 1;
+        }
+
+        /*
+         * Run each selected workload in each selected mode, each against a
+         * freshly opened disk.
+         */
+        for (mode = 0;
+             ((mode < Bench_Modes) && (retVal == AXP_VHD_SUCCESS));
+             mode++)
+        {
+            for (workload = 0;
+                 ((workload < Bench_Workloads) &&
+                  (opts.modes[mode] == true));
+                 workload++)
+            {
+                if (opts.workloads[workload] == false)
+                {
+                    continue;
+                }
+                retVal = _AXP_Bench_OpenDisk(backend,
+                                             mode,
+                                             path,
+                                             opts.cacheSize,
+                                             &handle);
+                if (retVal == AXP_VHD_SUCCESS)
+                {
+                    retVal = _AXP_Bench_Run(handle,
+                                            backend,
+                                            mode,
+                                            workload,
+                                            &opts);
+                    AXP_VHD_CloseHandle(handle);
+                }
+                if ((retVal == AXP_VHD_CALL_NOT_IMPL) ||
+                    (retVal == AXP_VHD_NOT_SUPPORTED) ||
+                    (retVal == AXP_VHD_INV_HANDLE))
+                {
+                    printf("%-5s %-6s %-9s not supported (%u)\n",
+                           _backendNames[backend],
+                           _modeNames[mode],
+                           _workloadNames[workload],
+                           retVal);
+                    retVal = AXP_VHD_SUCCESS;
+                }
+                else if (retVal != AXP_VHD_SUCCESS)
+                {
+                    printf("%-5s %-6s %-9s failed (%u)\n",
+                           _backendNames[backend],
+                           _modeNames[mode],
+                           _workloadNames[workload],
+                           retVal);
+                    exitCode = 1;
+                    retVal = AXP_VHD_SUCCESS;
+                }
+            }
+        }
+        if (opts.keep == false)
+        {
+            remove(path);
+        }
+    }
+    AXP_VHD_CacheInit(0, 0, 0);
+
+    /*
+     * Return the outcome back to the shell.
+     */
+    return(exitCode);
+}
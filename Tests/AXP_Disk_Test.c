@@ -25,8 +25,27 @@
  *
  *  V01.001 09-Jun-2019 Jonathan D. Belanger
  *  Updated to use new directory structure format and clean-up formatting.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test to write to an SSD, close it, reopen it, and read back what
+ *  was written.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test of the host block cache using a RAW disk.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test of a snapshot overlay on top of a dynamic VHD.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test of reading a RAW disk opened with OPEN_MAPPED_IO, both
+ *  through the mapping and with a read.
+ *
+ *  V01.006 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test that an SSD with a truncated backing store file is not
+ *  opened.
  */
 #include "Devices/VirtualDisks/AXP_VirtualDisk.h"
+#include "Devices/VirtualDisks/AXP_VHD_Cache.h"
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Trace.h"
 #include "Devices/VirtualDisks/AXP_VHD_Utility.h"
@@ -209,7 +228,22 @@ int main(void)
     AXP_VHD_STORAGE_TYPE storageType;
     AXP_VHD_HANDLE handle;
     char *diskName = "RZ1CD-CS.vhdx";
+    char *ssdName = "RZ1CD-CS.ssd";
+    char *rawName = "RZ1CD-CS.raw";
+    char *vhdName = "RZ1CD-CS.vhd";
+    char *ovlName = "RZ1CD-CS-1.vhd";
+    char ovlPath[AXP_MAX_FILENAME_LEN];
+    AXP_VHD_HANDLE overlay;
+    u8 ovlBuf[8 * AXP_SSD_SEC_DEF];
+    bool passed;
+    AXP_VHD_CACHE_STATS stats;
+    FILE *fp;
+    u64 lba;
     char fullPath[AXP_MAX_FILENAME_LEN];
+    u8 outBuf[8 * AXP_SSD_SEC_DEF];
+    u8 inBuf[8 * AXP_SSD_SEC_DEF];
+    u8 *mapped;
+    u32 sectors;
 #if 0
     char *modelNumber = "ST34501WC";
     char *serialNumber = "LG564729";
@@ -280,6 +314,380 @@ int main(void)
         printf("\t...Failed...\n");
     }
 
+    /*
+     * Create an SSD, write some sectors that span a page boundary, close it,
+     * and then reopen it and make sure the sectors were saved.
+     */
+    createParam.ver_1.maxSize = 4 * ONE_M;
+    storageType.deviceID = STORAGE_TYPE_DEV_SSD;
+    printf("Test %d: Create an SSD disk in %s with the name of %s of "
+           "%llu bytes in size, write, reopen and read back...\n",
+           ++ii,
+           AXP_TEST_DATA_FILES"/VHDTests",
+           ssdName,
+           createParam.ver_1.maxSize);
+    sprintf(fullPath, "%s/VHDTests/%s", AXP_TEST_DATA_FILES, ssdName);
+    for (crcCalc = 0; crcCalc < sizeof(outBuf); crcCalc++)
+    {
+        outBuf[crcCalc] = (u8) (crcCalc * 7);
+    }
+    retVal = AXP_VHD_Create(&storageType,
+                            fullPath,
+                            ACCESS_NONE,
+                            NULL,
+                            CREATE_NONE,
+                            0,
+                            &createParam,
+                            NULL,
+                            &handle);
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        sectors = 8;
+        retVal = AXP_VHD_WriteSectors(handle, 5, &sectors, outBuf);
+        AXP_VHD_CloseHandle(handle);
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = AXP_VHD_Open(&storageType,
+                              fullPath,
+                              ACCESS_ALL,
+                              OPEN_NO_PARENTS,
+                              NULL,
+                              &handle);
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        sectors = 8;
+        retVal = AXP_VHD_ReadSectors(handle, 5, &sectors, inBuf);
+        AXP_VHD_CloseHandle(handle);
+    }
+    if ((retVal == AXP_VHD_SUCCESS) &&
+        (memcmp(inBuf, outBuf, sizeof(inBuf)) == 0))
+    {
+        printf("\t...Succeeded...\n");
+    }
+    else
+    {
+        printf("\t...Failed...\n");
+    }
+    remove(fullPath);
+
+    /*
+     * Size the block cache, then write some sectors that are not aligned to a
+     * cache block to a RAW disk, read the whole disk sequentially, close it,
+     * and then reopen it and make sure the sectors were written back.
+     */
+    printf("Test %d: Cache a RAW disk in %s with the name of %s of "
+           "%u bytes in size, write, read sequentially, reopen and read "
+           "back...\n",
+           ++ii,
+           AXP_TEST_DATA_FILES"/VHDTests",
+           rawName,
+           ONE_M);
+    sprintf(fullPath, "%s/VHDTests/%s", AXP_TEST_DATA_FILES, rawName);
+    fp = fopen(fullPath, "wb");
+    if (fp != NULL)
+    {
+        fseek(fp, ONE_M - 1, SEEK_SET);
+        fputc(0, fp);
+        fclose(fp);
+    }
+    storageType.deviceID = STORAGE_TYPE_DEV_RAW;
+    AXP_VHD_CacheInit(256 * ONE_K, 64 * ONE_K, 8);
+    retVal = AXP_VHD_Open(&storageType,
+                          fullPath,
+                          ACCESS_ALL,
+                          OPEN_NO_PARENTS,
+                          NULL,
+                          &handle);
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        sectors = 8;
+        retVal = AXP_VHD_WriteSectors(handle, 5, &sectors, outBuf);
+        for (lba = 0;
+             ((lba < (ONE_M / AXP_SSD_SEC_DEF)) && (retVal == AXP_VHD_SUCCESS));
+             lba += 8)
+        {
+            sectors = 8;
+            retVal = AXP_VHD_ReadSectors(handle, lba, &sectors, inBuf);
+        }
+        AXP_VHD_CloseHandle(handle);
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = AXP_VHD_Open(&storageType,
+                              fullPath,
+                              ACCESS_ALL,
+                              OPEN_NO_PARENTS,
+                              NULL,
+                              &handle);
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        sectors = 8;
+        retVal = AXP_VHD_ReadSectors(handle, 5, &sectors, inBuf);
+        AXP_VHD_CloseHandle(handle);
+    }
+    AXP_VHD_CacheGetStats(&stats);
+    if ((retVal == AXP_VHD_SUCCESS) &&
+        (memcmp(inBuf, outBuf, sizeof(inBuf)) == 0) &&
+        (stats.hits > 0) &&
+        (stats.readAheadHits > 0) &&
+        (stats.writeBacks > 0) &&
+        (stats.dirty == 0))
+    {
+        printf("\t...Succeeded...\n");
+    }
+    else
+    {
+        printf("\t...Failed...\n");
+    }
+    printf("\t\thits=%llu, misses=%llu, read-ahead=%llu/%llu, "
+           "write-backs=%llu, evictions=%llu\n",
+           stats.hits,
+           stats.misses,
+           stats.readAheadHits,
+           stats.readAheads,
+           stats.writeBacks,
+           stats.evictions);
+    remove(fullPath);
+
+    /*
+     * Create a dynamic VHD and write to it, then create an overlay on top of
+     * it and write to a different block in the overlay.  The overlay should
+     * see what was written to the VHD, the VHD should not see what was
+     * written to the overlay, and the VHD can no longer be written.  Then
+     * reopen the overlay, which opens the VHD from the parent locator, and
+     * make sure it still sees both.
+     */
+    createParam.ver_1.maxSize = 4 * ONE_M;
+    storageType.deviceID = STORAGE_TYPE_DEV_VHD;
+    printf("Test %d: Create a dynamic VHD disk in %s with the name of %s of "
+           "%llu bytes in size, and an overlay on top of it named %s...\n",
+           ++ii,
+           AXP_TEST_DATA_FILES"/VHDTests",
+           vhdName,
+           createParam.ver_1.maxSize,
+           ovlName);
+    sprintf(fullPath, "%s/VHDTests/%s", AXP_TEST_DATA_FILES, vhdName);
+    sprintf(ovlPath, "%s/VHDTests/%s", AXP_TEST_DATA_FILES, ovlName);
+    for (crcCalc = 0; crcCalc < sizeof(ovlBuf); crcCalc++)
+    {
+        ovlBuf[crcCalc] = (u8) ~outBuf[crcCalc];
+    }
+    passed = false;
+    retVal = AXP_VHD_Create(&storageType,
+                            fullPath,
+                            ACCESS_NONE,
+                            NULL,
+                            CREATE_NONE,
+                            0,
+                            &createParam,
+                            NULL,
+                            &handle);
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        sectors = 8;
+        retVal = AXP_VHD_WriteSectors(handle, 5, &sectors, outBuf);
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            retVal = AXP_VHD_CreateOverlay(handle, ovlPath, &overlay);
+        }
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            sectors = 8;
+            retVal = AXP_VHD_WriteSectors(overlay, 4099, &sectors, ovlBuf);
+        }
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            sectors = 8;
+            retVal = AXP_VHD_ReadSectors(overlay, 5, &sectors, inBuf);
+            passed = memcmp(inBuf, outBuf, sizeof(inBuf)) == 0;
+        }
+        if ((retVal == AXP_VHD_SUCCESS) && (passed == true))
+        {
+            sectors = 8;
+            retVal = AXP_VHD_ReadSectors(handle, 4099, &sectors, inBuf);
+            for (crcCalc = 0; crcCalc < sizeof(inBuf); crcCalc++)
+            {
+                passed = passed && (inBuf[crcCalc] == 0);
+            }
+            sectors = 8;
+            passed = passed &&
+                     (AXP_VHD_WriteSectors(handle, 5, &sectors, outBuf) ==
+                      AXP_VHD_FILE_READ_ONLY);
+            AXP_VHD_CloseHandle(overlay);
+        }
+        if ((retVal == AXP_VHD_SUCCESS) && (passed == true))
+        {
+            retVal = AXP_VHD_Open(&storageType,
+                                  ovlPath,
+                                  ACCESS_ALL,
+                                  OPEN_NONE,
+                                  NULL,
+                                  &overlay);
+        }
+        if ((retVal == AXP_VHD_SUCCESS) && (passed == true))
+        {
+            sectors = 8;
+            retVal = AXP_VHD_ReadSectors(overlay, 4099, &sectors, inBuf);
+            passed = memcmp(inBuf, ovlBuf, sizeof(inBuf)) == 0;
+            sectors = 8;
+            retVal = AXP_VHD_ReadSectors(overlay, 5, &sectors, inBuf);
+            passed = passed && (memcmp(inBuf, outBuf, sizeof(inBuf)) == 0);
+            AXP_VHD_CloseHandle(overlay);
+        }
+        AXP_VHD_CloseHandle(handle);
+    }
+    if ((retVal == AXP_VHD_SUCCESS) && (passed == true))
+    {
+        printf("\t...Succeeded...\n");
+    }
+    else
+    {
+        printf("\t...Failed...\n");
+    }
+    remove(ovlPath);
+    remove(fullPath);
+
+    /*
+     * Write some sectors to a RAW disk, close it, and then reopen it with
+     * mapped I/O.  Give the host an access hint, and make sure the sectors
+     * can be read both directly from the mapping and with a read, and that
+     * the mapping cannot be used past the end of the disk.
+     */
+    printf("Test %d: Map a RAW disk in %s with the name of %s of %u bytes in "
+           "size, write, reopen mapped and read back...\n",
+           ++ii,
+           AXP_TEST_DATA_FILES"/VHDTests",
+           rawName,
+           ONE_M);
+    sprintf(fullPath, "%s/VHDTests/%s", AXP_TEST_DATA_FILES, rawName);
+    for (crcCalc = 0; crcCalc < sizeof(outBuf); crcCalc++)
+    {
+        outBuf[crcCalc] = (u8) ((crcCalc * 13) + 1);
+    }
+    passed = false;
+    fp = fopen(fullPath, "wb");
+    if (fp != NULL)
+    {
+        fseek(fp, ONE_M - 1, SEEK_SET);
+        fputc(0, fp);
+        fclose(fp);
+    }
+    storageType.deviceID = STORAGE_TYPE_DEV_RAW;
+    retVal = AXP_VHD_Open(&storageType,
+                          fullPath,
+                          ACCESS_ALL,
+                          OPEN_NO_PARENTS,
+                          NULL,
+                          &handle);
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        sectors = 8;
+        retVal = AXP_VHD_WriteSectors(handle, 5, &sectors, outBuf);
+        AXP_VHD_CloseHandle(handle);
+    }
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        retVal = AXP_VHD_Open(&storageType,
+                              fullPath,
+                              ACCESS_ALL,
+                              OPEN_MAPPED_IO,
+                              NULL,
+                              &handle);
+        if (retVal == AXP_VHD_SUCCESS)
+        {
+            retVal = AXP_VHD_SetAccessHint(handle,
+                                           0,
+                                           ONE_M / AXP_SSD_SEC_DEF,
+                                           ACCESS_HINT_SEQUENTIAL);
+            if (retVal == AXP_VHD_SUCCESS)
+            {
+                retVal = AXP_VHD_GetMappedSectors(handle, 5, 8, &mapped);
+            }
+            if (retVal == AXP_VHD_SUCCESS)
+            {
+                passed = memcmp(mapped, outBuf, sizeof(outBuf)) == 0;
+                sectors = 8;
+                retVal = AXP_VHD_ReadSectors(handle, 5, &sectors, inBuf);
+                passed = passed &&
+                         (sectors == 8) &&
+                         (memcmp(inBuf, outBuf, sizeof(inBuf)) == 0);
+            }
+            if (retVal == AXP_VHD_SUCCESS)
+            {
+                lba = (ONE_M / AXP_SSD_SEC_DEF) - 4;
+                passed = passed &&
+                         (AXP_VHD_GetMappedSectors(handle,
+                                                   lba,
+                                                   8,
+                                                   &mapped) ==
+                          AXP_VHD_INV_PARAM) &&
+                         (mapped == NULL);
+            }
+            AXP_VHD_CloseHandle(handle);
+        }
+    }
+    if ((retVal == AXP_VHD_SUCCESS) && (passed == true))
+    {
+        printf("\t...Succeeded...\n");
+    }
+    else
+    {
+        printf("\t...Failed...\n");
+    }
+    remove(fullPath);
+
+    /*
+     * Create an SSD, close it, and then cut its backing store file short.  It
+     * should no longer be possible to open it.
+     */
+    createParam.ver_1.maxSize = 4 * ONE_M;
+    storageType.deviceID = STORAGE_TYPE_DEV_SSD;
+    printf("Test %d: Create an SSD disk in %s with the name of %s of "
+           "%llu bytes in size, truncate it, and fail to reopen it...\n",
+           ++ii,
+           AXP_TEST_DATA_FILES"/VHDTests",
+           ssdName,
+           createParam.ver_1.maxSize);
+    sprintf(fullPath, "%s/VHDTests/%s", AXP_TEST_DATA_FILES, ssdName);
+    retVal = AXP_VHD_Create(&storageType,
+                            fullPath,
+                            ACCESS_NONE,
+                            NULL,
+                            CREATE_NONE,
+                            0,
+                            &createParam,
+                            NULL,
+                            &handle);
+    if (retVal == AXP_VHD_SUCCESS)
+    {
+        AXP_VHD_CloseHandle(handle);
+        if (truncate(fullPath, 2 * ONE_M) == 0)
+        {
+            retVal = AXP_VHD_Open(&storageType,
+                                  fullPath,
+                                  ACCESS_ALL,
+                                  OPEN_NO_PARENTS,
+                                  NULL,
+                                  &handle);
+            if (retVal == AXP_VHD_SUCCESS)
+            {
+                AXP_VHD_CloseHandle(handle);
+            }
+        }
+    }
+    if (retVal == AXP_VHD_FILE_CORRUPT)
+    {
+        printf("\t...Succeeded...\n");
+    }
+    else
+    {
+        printf("\t...Failed...\n");
+    }
+    remove(fullPath);
+
     /*
      * Return back to the caller.
      */
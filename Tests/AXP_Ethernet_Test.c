@@ -0,0 +1,582 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains the code to test the Ethernet packet path, using a
+ *  loopback pair so that no network interface or privileges are needed.
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test of the 21143 descriptor rings and interrupt mitigation.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  The 21143s are on a Pchip's PCI bus, and DMA through it.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_Configure.h"
+#include "CommonUtilities/AXP_Trace.h"
+#include "CommonUtilities/AXP_Blocks.h"
+#include "Devices/Ethernet/AXP_Ethernet.h"
+#include "Devices/Ethernet/AXP_21143.h"
+#include "Motherboard/Pchip/AXP_21274_Pchip.h"
+#include "Motherboard/AXP_21274_InitRoutines.h"
+
+#define TEST_FRAMES	10000
+
+/*
+ * Guest memory layout for the 21143 test.
+ */
+#define TEST_NIC_FRAMES	4000
+#define TEST_MEM_SIZE	(1024 * 1024)
+#define TEST_RING	32
+#define TEST_BUF_LEN	1536
+#define TEST_TX_RING	0x01000
+#define TEST_RX_RING	0x02000
+#define TEST_SETUP_RING	0x03000
+#define TEST_SETUP	0x04000
+#define TEST_TX_BUF	0x10000
+#define TEST_RX_BUF	0x40000
+
+static AXP_21274_PCHIP p;
+
+/*
+ * Test_Frame
+ *  Fill a transmit buffer with a frame from one end of the pair to the other,
+ *  carrying a sequence number.
+ */
+void Test_Frame(AXP_ETH_FRAME *frame,
+                AXP_Ethernet_Handle *from,
+                AXP_Ethernet_Handle *to,
+                u32 seq)
+{
+    memcpy(&frame->data[0], to->macAddr, AXP_MAC_ADDR_LEN);
+    memcpy(&frame->data[AXP_MAC_ADDR_LEN], from->macAddr, AXP_MAC_ADDR_LEN);
+    frame->data[12] = 0x60;
+    frame->data[13] = 0x06;
+    memcpy(&frame->data[14], &seq, sizeof(seq));
+    frame->len = 60 + (seq % 1400);
+    return;
+}
+
+/*
+ * Test_Receive
+ *  Wait for the next frame to be received, and check it is the one expected.
+ */
+bool Test_Receive(AXP_Ethernet_Handle *eth,
+                  AXP_Ethernet_Handle *from,
+                  u32 seq)
+{
+    AXP_ETH_FRAME *frame = NULL;
+    u32 rcvSeq = ~seq;
+    int ii;
+    bool retVal;
+
+    for (ii = 0; ((ii < 200000) && (frame == NULL)); ii++)
+    {
+        frame = AXP_EthernetRxGet(eth);
+        if (frame == NULL)
+        {
+            usleep(10);
+        }
+    }
+    retVal = frame != NULL;
+    if (retVal == true)
+    {
+        memcpy(&rcvSeq, &frame->data[14], sizeof(rcvSeq));
+        retVal = (rcvSeq == seq) &&
+                 (frame->len == (60 + (seq % 1400))) &&
+                 (memcmp(&frame->data[0],
+                         eth->macAddr,
+                         AXP_MAC_ADDR_LEN) == 0) &&
+                 (memcmp(&frame->data[AXP_MAC_ADDR_LEN],
+                         from->macAddr,
+                         AXP_MAC_ADDR_LEN) == 0);
+        AXP_EthernetRxPut(eth, frame);
+    }
+    if (retVal == false)
+    {
+        printf("    Frame %u was not received correctly\n", seq);
+    }
+    return(retVal);
+}
+
+/*
+ * test_pair
+ *  Send frames both ways across a loopback pair, one at a time, and then in
+ *  batches that fill the queues, and time it.
+ */
+bool test_pair(void)
+{
+    AXP_Ethernet_Handle *a, *b;
+    AXP_ETH_FRAME *frame;
+    struct timespec start, end;
+    double secs;
+    u32 seq, sent, rcvd;
+    bool retVal = true;
+
+    printf("...Opening both ends of loopback pair 0...\n");
+    a = AXP_EthernetOpen("pair:0", 0);
+    b = AXP_EthernetOpen("pair:0", 1);
+    retVal = (a != NULL) &&
+             (b != NULL) &&
+             (AXP_EthernetOpen("pair:99", 2) == NULL);
+
+    /*
+     * One frame at a time, alternating direction.
+     */
+    if (retVal == true)
+    {
+        printf("...Sending frames one at a time in both directions...\n");
+    }
+    for (seq = 0; ((seq < 100) && (retVal == true)); seq++)
+    {
+        frame = AXP_EthernetTxGet(a);
+        retVal = frame != NULL;
+        if (retVal == true)
+        {
+            Test_Frame(frame, a, b, seq);
+            AXP_EthernetTxPut(a, frame);
+            retVal = Test_Receive(b, a, seq);
+        }
+        frame = (retVal == true) ? AXP_EthernetTxGet(b) : NULL;
+        retVal = frame != NULL;
+        if (retVal == true)
+        {
+            Test_Frame(frame, b, a, seq);
+            AXP_EthernetTxPut(b, frame);
+            retVal = Test_Receive(a, b, seq);
+        }
+    }
+
+    /*
+     * Keep as many frames in flight as there are buffers, and make sure they
+     * all arrive in order.
+     */
+    if (retVal == true)
+    {
+        printf("...Streaming %d frames from one end to the other...\n",
+               TEST_FRAMES);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sent = rcvd = 0;
+        while ((rcvd < TEST_FRAMES) && (retVal == true))
+        {
+            while ((sent < TEST_FRAMES) &&
+                   ((frame = AXP_EthernetTxGet(a)) != NULL))
+            {
+                Test_Frame(frame, a, b, sent++);
+                AXP_EthernetTxPut(a, frame);
+            }
+            retVal = Test_Receive(b, a, rcvd++);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        secs = (end.tv_sec - start.tv_sec) +
+               ((end.tv_nsec - start.tv_nsec) / 1000000000.0);
+        if (retVal == true)
+        {
+            printf("    %d frames in %.3f seconds (%.0f frames/sec)\n",
+                   TEST_FRAMES,
+                   secs,
+                   TEST_FRAMES / secs);
+        }
+        for (sent = 0;
+             ((sent < 1000) && (a->txFrames < (TEST_FRAMES + 100)));
+             sent++)
+        {
+            usleep(1000);
+        }
+        retVal = retVal &&
+                 (a->txFrames == (TEST_FRAMES + 100)) &&
+                 (b->rxFrames == (TEST_FRAMES + 100)) &&
+                 (b->rxDropped == 0);
+    }
+    if (a != NULL)
+    {
+        AXP_EthernetClose(a);
+    }
+    if (b != NULL)
+    {
+        AXP_EthernetClose(b);
+    }
+    return(retVal);
+}
+
+/*
+ * Test_Desc
+ *  Write a descriptor into guest memory, giving it to the 21143 last.
+ */
+void Test_Desc(u8 *mem, u64 addr, u32 des0, u32 des1, u32 des2, u32 des3)
+{
+    u32 *desc = (u32 *) &mem[addr];
+
+    desc[1] = des1;
+    desc[2] = des2;
+    desc[3] = des3;
+    __atomic_store_n(&desc[0], des0, __ATOMIC_RELEASE);
+    return;
+}
+
+/*
+ * Test_Interrupt
+ *  Count the times the interrupt line of a 21143 goes up.
+ */
+void Test_Interrupt(void *arg, bool level)
+{
+    if (level == true)
+    {
+        __atomic_add_fetch((u32 *) arg, 1, __ATOMIC_SEQ_CST);
+    }
+    return;
+}
+
+/*
+ * Test_DMA
+ *  DMA through the Pchip the 21143s are on.
+ */
+bool Test_DMA(void *arg, u64 addr, u8 *buf, u32 len, bool write)
+{
+    return(AXP_21274_PchipDMA((AXP_21274_PCHIP *) arg, addr, buf, len, write));
+}
+
+/*
+ * test_21143
+ *  Connect 2 21143s through a loopback pair.  The receiver is set up with a
+ *  setup frame that has its own address in it, and interrupt mitigation.  The
+ *  sender sends frames from its transmit ring, some of which are not
+ *  addressed to the receiver, and the receiver's ring is emptied as the
+ *  frames arrive.  The frames have to arrive intact and in order, and the
+ *  receiver has to take fewer interrupts than the frames it received.  Both
+ *  21143s are on the PCI bus of a Pchip, with guest memory mapped straight
+ *  through a direct mapped window at PCI address 0.
+ */
+bool test_21143(void)
+{
+    AXP_21143 *a, *b;
+    u8 *mem;
+    u8 *data;
+    u8 other[AXP_MAC_ADDR_LEN] = {0x08, 0x00, 0x2b, 0x00, 0x00, 0x99};
+    u32 aInts = 0, bInts = 0;
+    u32 sent = 0, rcvd = 0, expect = 0;
+    u32 txIdx = 0, rxIdx = 0;
+    u32 *desc;
+    u64 *arrays[1];
+    u32 len, ii, jj;
+    bool retVal = true;
+
+    mem = calloc(1, TEST_MEM_SIZE);
+    arrays[0] = (u64 *) mem;
+    pthread_mutex_init(&p.mutex, NULL);
+    pthread_mutex_init(&p.tlbMutex, NULL);
+    pthread_mutex_init(&p.pciMutex, NULL);
+    pthread_cond_init(&p.cond, NULL);
+    pthread_cond_init(&p.space, NULL);
+    AXP_21274_PchipInit(&p, 0, arrays, 1, TEST_MEM_SIZE);
+    p.wsba0.addr = 0;			/* PCI 0 */
+    p.wsba0.sg = AXP_SG_DISABLE;
+    p.wsba0.ena = AXP_ENA_ENABLE;
+    p.wsm0.am = 0;			/* 1MB */
+    p.tba0.addr = 0;
+    pthread_create(&p.threadID, NULL, AXP_21274_PchipMain, &p);
+    printf("...Creating two 21143s on loopback pair 5...\n");
+    a = AXP_21143_Init("pair:5", 0, Test_DMA, &p,
+                       Test_Interrupt, &aInts, 0);
+    b = AXP_21143_Init("pair:5", 1, Test_DMA, &p,
+                       Test_Interrupt, &bInts,
+                       (4 << AXP_21143_NRP_SHIFT) | (1 << AXP_21143_RT_SHIFT));
+    retVal = (mem != NULL) && (a != NULL) && (b != NULL) &&
+             AXP_21274_PCIRegister(&p, &a->pci, 0) &&
+             AXP_21274_PCIRegister(&p, &b->pci, 1);
+    if (retVal == true)
+    {
+        retVal = ((AXP_21143_ReadConfig(a, AXP_21143_CFID) ==
+                   ((AXP_21143_DEVICE << 16) | AXP_21143_VENDOR))) &&
+                 (AXP_21143_ReadCSR(b, AXP_21143_CSR11 << 3) ==
+                  ((4 << AXP_21143_NRP_SHIFT) | (1 << AXP_21143_RT_SHIFT)));
+        AXP_21143_WriteConfig(a, AXP_21143_CBIO, 0xffffffff);
+        retVal = retVal &&
+                 (AXP_21143_ReadConfig(a, AXP_21143_CBIO) == 0xffffff81);
+    }
+
+    /*
+     * Give the receiver its receive ring, and a setup frame with its own
+     * address and the broadcast address.
+     */
+    if (retVal == true)
+    {
+        printf("...Loading the receiver's address filter...\n");
+        for (ii = 0; ii < TEST_RING; ii++)
+        {
+            Test_Desc(mem,
+                      TEST_RX_RING + (ii * AXP_21143_DESC_LEN),
+                      AXP_21143_OWN,
+                      ((ii == (TEST_RING - 1)) ? AXP_21143_ER : 0) |
+                      TEST_BUF_LEN,
+                      TEST_RX_BUF + (ii * TEST_BUF_LEN),
+                      0);
+        }
+        for (ii = 0; ii < AXP_21143_PERFECT; ii++)
+        {
+            for (jj = 0; jj < AXP_MAC_ADDR_LEN; jj++)
+            {
+                mem[TEST_SETUP + (((ii * 3) + (jj / 2)) * 4) + (jj % 2)] =
+                    (ii == 0) ? b->eth->macAddr[jj] : 0xff;
+            }
+        }
+        Test_Desc(mem, TEST_SETUP_RING, AXP_21143_OWN,
+                  AXP_21143_TDES1_SET | AXP_21143_ER | AXP_21143_SETUP_LEN,
+                  TEST_SETUP, 0);
+        AXP_21143_WriteCSR(b, AXP_21143_CSR3 << 3, TEST_RX_RING);
+        AXP_21143_WriteCSR(b, AXP_21143_CSR4 << 3, TEST_SETUP_RING);
+        AXP_21143_WriteCSR(b, AXP_21143_CSR7 << 3,
+                           AXP_21143_NIS | AXP_21143_RI);
+        AXP_21143_WriteCSR(b, AXP_21143_CSR6 << 3,
+                           AXP_21143_SR | AXP_21143_ST);
+        desc = (u32 *) &mem[TEST_SETUP_RING];
+        for (ii = 0;
+             ((ii < 1000) &&
+              ((__atomic_load_n(desc, __ATOMIC_ACQUIRE) &
+                AXP_21143_OWN) != 0));
+             ii++)
+        {
+            usleep(1000);
+        }
+        retVal = (*desc & AXP_21143_OWN) == 0;
+    }
+
+    /*
+     * Stream frames from the sender to the receiver.  Every 8th one is sent
+     * to another address, and should be filtered out.
+     */
+    if (retVal == true)
+    {
+        printf("...Streaming %d frames through the descriptor rings...\n",
+               TEST_NIC_FRAMES);
+        AXP_21143_WriteCSR(a, AXP_21143_CSR4 << 3, TEST_TX_RING);
+        AXP_21143_WriteCSR(a, AXP_21143_CSR6 << 3, AXP_21143_ST);
+        for (ii = 0;
+             ((rcvd < ((TEST_NIC_FRAMES * 7) / 8)) &&
+              (ii < 1000000) &&
+              (retVal == true));
+             ii++)
+        {
+            while (sent < TEST_NIC_FRAMES)
+            {
+                desc = (u32 *) &mem[TEST_TX_RING +
+                                    (txIdx * AXP_21143_DESC_LEN)];
+                if ((__atomic_load_n(desc, __ATOMIC_ACQUIRE) &
+                     AXP_21143_OWN) != 0)
+                {
+                    break;
+                }
+                data = &mem[TEST_TX_BUF + (txIdx * TEST_BUF_LEN)];
+                memcpy(&data[0],
+                       ((sent % 8) == 7) ? other : b->eth->macAddr,
+                       AXP_MAC_ADDR_LEN);
+                memcpy(&data[6], a->eth->macAddr, AXP_MAC_ADDR_LEN);
+                data[12] = 0x60;
+                data[13] = 0x06;
+                memcpy(&data[14], &sent, sizeof(sent));
+                len = 60 + (sent % 1400);
+                Test_Desc(mem,
+                          TEST_TX_RING + (txIdx * AXP_21143_DESC_LEN),
+                          AXP_21143_OWN,
+                          AXP_21143_TDES1_IC | AXP_21143_TDES1_FS |
+                          AXP_21143_TDES1_LS |
+                          ((txIdx == (TEST_RING - 1)) ? AXP_21143_ER : 0) |
+                          len,
+                          TEST_TX_BUF + (txIdx * TEST_BUF_LEN),
+                          0);
+                txIdx = (txIdx + 1) % TEST_RING;
+                sent++;
+                AXP_21143_WriteCSR(a, AXP_21143_CSR1 << 3, 1);
+            }
+            if (b->irq == true)
+            {
+                AXP_21143_WriteCSR(b, AXP_21143_CSR5 << 3,
+                                   AXP_21143_RI | AXP_21143_NIS);
+            }
+            desc = (u32 *) &mem[TEST_RX_RING + (rxIdx * AXP_21143_DESC_LEN)];
+            if ((__atomic_load_n(desc, __ATOMIC_ACQUIRE) &
+                 AXP_21143_OWN) != 0)
+            {
+                sched_yield();
+                continue;
+            }
+            if ((expect % 8) == 7)
+            {
+                expect++;
+            }
+            data = &mem[TEST_RX_BUF + (rxIdx * TEST_BUF_LEN)];
+            len = 60 + (expect % 1400);
+            retVal = ((desc[0] &
+                       (AXP_21143_RDES0_FS | AXP_21143_RDES0_LS |
+                        AXP_21143_ES)) ==
+                      (AXP_21143_RDES0_FS | AXP_21143_RDES0_LS)) &&
+                     ((desc[0] >> AXP_21143_RDES0_FL_SHIFT) ==
+                      (len + AXP_21143_CRC_LEN)) &&
+                     (memcmp(&data[0], b->eth->macAddr, 6) == 0) &&
+                     (memcmp(&data[14], &expect, sizeof(expect)) == 0);
+            if (retVal == false)
+            {
+                printf("    Frame %u received wrongly (RDES0 0x%08x)\n",
+                       expect,
+                       desc[0]);
+            }
+            Test_Desc(mem,
+                      TEST_RX_RING + (rxIdx * AXP_21143_DESC_LEN),
+                      AXP_21143_OWN,
+                      ((rxIdx == (TEST_RING - 1)) ? AXP_21143_ER : 0) |
+                      TEST_BUF_LEN,
+                      TEST_RX_BUF + (rxIdx * TEST_BUF_LEN),
+                      0);
+            AXP_21143_WriteCSR(b, AXP_21143_CSR2 << 3, 1);
+            rxIdx = (rxIdx + 1) % TEST_RING;
+            rcvd++;
+            expect++;
+        }
+        printf("    %u frames received, %u receive interrupts taken\n",
+               rcvd,
+               bInts);
+        retVal = retVal &&
+                 (rcvd == ((TEST_NIC_FRAMES * 7) / 8)) &&
+                 (bInts > 1) &&
+                 (bInts < rcvd);
+    }
+
+    /*
+     * The receive timer reports the last of the frames, and the interrupt goes
+     * away when it is cleared.  The sender has run out of descriptors.
+     */
+    if (retVal == true)
+    {
+        usleep(10000);
+        AXP_21143_WriteCSR(b, AXP_21143_CSR5 << 3,
+                           AXP_21143_RI | AXP_21143_NIS);
+        retVal = (b->irq == false) &&
+                 (b->rxCount == 0) &&
+                 (((AXP_21143_ReadCSR(a, AXP_21143_CSR5 << 3) >>
+                    AXP_21143_TS_SHIFT) & AXP_21143_STATE_MASK) ==
+                  AXP_21143_TX_SUSPENDED) &&
+                 (aInts == 0);
+    }
+    if (a != NULL)
+    {
+        AXP_21143_Close(a);
+    }
+    if (b != NULL)
+    {
+        AXP_21143_Close(b);
+    }
+    AXP_21274_PchipStop(&p);
+    free(mem);
+    return(retVal);
+}
+
+/*
+ * test_host
+ *  Try to open the host backends.  These need privileges, so if they cannot be
+ *  opened, they are only reported on.  A frame sent on the loopback interface
+ *  through a packet socket should be seen coming back in through its ring.
+ */
+bool test_host(void)
+{
+    AXP_Ethernet_Handle *eth;
+    AXP_ETH_FRAME *frame;
+    char *names[] = {"packet:lo", "tap:axptest0"};
+    u32 seq = 0x5a5a5a5a;
+    u32 rcvSeq;
+    int ii, jj;
+    bool retVal = true;
+
+    for (ii = 0; ((ii < 2) && (retVal == true)); ii++)
+    {
+        eth = AXP_EthernetOpen(names[ii], 0);
+        if (eth != NULL)
+        {
+            printf("...Opened %s\n", names[ii]);
+            if (eth->backend == AXP_ETH_PACKET)
+            {
+                frame = AXP_EthernetTxGet(eth);
+                Test_Frame(frame, eth, eth, seq);
+                AXP_EthernetTxPut(eth, frame);
+                retVal = false;
+                for (jj = 0; ((jj < 1000) && (retVal == false)); jj++)
+                {
+                    frame = AXP_EthernetRxGet(eth);
+                    if (frame != NULL)
+                    {
+                        memcpy(&rcvSeq, &frame->data[14], sizeof(rcvSeq));
+                        retVal = (frame->data[12] == 0x60) &&
+                                 (frame->data[13] == 0x06) &&
+                                 (rcvSeq == seq);
+                        AXP_EthernetRxPut(eth, frame);
+                    }
+                    else
+                    {
+                        usleep(1000);
+                    }
+                }
+                printf("    The frame sent was %s\n",
+                       retVal ? "received" : "not received");
+            }
+            AXP_EthernetClose(eth);
+        }
+        else
+        {
+            printf("...Unable to open %s (not tested)\n", names[ii]);
+        }
+    }
+    return(retVal);
+}
+
+int main(void)
+{
+    bool retVal = true;
+
+    printf("\nDECaxp Ethernet Testing...\n");
+    if (AXP_TraceInit() == true)
+    {
+        printf("\nTesting a loopback pair...\n");
+        retVal = test_pair();
+        if (retVal == true)
+        {
+            printf("\nTesting the 21143...\n");
+            retVal = test_21143();
+        }
+        if (retVal == true)
+        {
+            printf("\nTesting the host backends...\n");
+            retVal = test_host();
+        }
+    }
+    else
+    {
+        retVal = false;
+    }
+    if (retVal == true)
+    {
+        printf("All Tests Successful!\n");
+    }
+    else
+    {
+        printf("At Least One Test Failed.\n");
+    }
+    return(0);
+}
@@ -25,11 +25,27 @@
  *
  *  V01.001 09-Jun-2019 Jonathan D. Belanger
  *  Did some code clean-up and reformatting.
+ *
+ *  V01.002 19-Oct-2026 Jonathan D. Belanger
+ *  The server is now tested on a loopback port with two clients connected,
+ *  rather than waiting forever for a connection.
+ *
+ *  V01.003 19-Oct-2026 Jonathan D. Belanger
+ *  Added a run of data, with a CR NUL in it, to test the receive fast path.
+ *
+ *  V01.004 19-Oct-2026 Jonathan D. Belanger
+ *  Added output sent a byte at a time, and a prompt, to test that coalesced
+ *  output is sent at the end of a line, a prompt, and after the flush delay.
+ *
+ *  V01.005 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test of the console port rings, and of a console port connected to
+ *  the TELNET server.
  */
 #include "CommonUtilities/AXP_Utility.h"
 #include "CommonUtilities/AXP_Configure.h"
 #include "CommonUtilities/AXP_Trace.h"
 #include "Devices/Console/AXP_Telnet.h"
+#include "Devices/Console/AXP_Console.h"
 
 extern AXP_StateMachine TN_Option_SM[AXP_OPT_MAX_ACTION][AXP_OPT_MAX_STATE];
 extern AXP_StateMachine TN_Receive_SM[AXP_ACT_MAX][AXP_RCV_MAX_STATE];
@@ -634,6 +650,294 @@ bool test_options_StateMachine(void)
     return(retVal);
 }
 
+/*
+ * These are used to test the TELNET server.  The input function records what
+ * the server hands to the console from the read-write session.
+ */
+static u8 testInput[64];
+static volatile u32 testInputLen = 0;
+
+void Test_Input(u8 *buf, u32 bufLen)
+{
+    if ((testInputLen + bufLen) <= sizeof(testInput))
+    {
+        memcpy(&testInput[testInputLen], buf, bufLen);
+        testInputLen += bufLen;
+    }
+    return;
+}
+
+void *Test_Server(void *arg)
+{
+    AXP_Telnet_Server(0, true);
+    return(NULL);
+}
+
+int Test_Connect(u16 port)
+{
+    struct sockaddr_in name;
+    struct timeval timeout = {.tv_sec = 2, .tv_usec = 0};
+    u8 cmd[3] = {IAC, DO, TELOPT_SGA};
+    int sock;
+
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock >= 0)
+    {
+        memset(&name, 0, sizeof(name));
+        name.sin_family = AF_INET;
+        name.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        name.sin_port = htons(port);
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if ((connect(sock, (struct sockaddr *) &name, sizeof(name)) < 0) ||
+            (send(sock, cmd, sizeof(cmd), 0) != sizeof(cmd)))
+        {
+            close(sock);
+            sock = -1;
+        }
+    }
+    return(sock);
+}
+
+bool Test_Expect(int sock, char *expected)
+{
+    u8 buf[AXP_TELNET_MSG_LEN];
+    ssize_t len;
+    size_t total = 0;
+    size_t expLen = strlen(expected);
+    size_t ii;
+    bool retVal = false;
+
+    while ((retVal == false) &&
+           (total < sizeof(buf)) &&
+           ((len = recv(sock, &buf[total], sizeof(buf) - total, 0)) > 0))
+    {
+        total += len;
+        for (ii = 0; ((ii + expLen) <= total) && (retVal == false); ii++)
+        {
+            retVal = memcmp(&buf[ii], expected, expLen) == 0;
+        }
+    }
+    return(retVal);
+}
+
+void Test_Wait(u32 inputLen)
+{
+    int ii;
+
+    for (ii = 0; ((ii < 200) && (testInputLen < inputLen)); ii++)
+    {
+        usleep(10000);
+    }
+    return;
+}
+
+/*
+ * These are used to test the console ports.  The interrupt function records
+ * the last state of the interrupt line, and how many times it was asserted.
+ */
+static volatile bool testIntLevel = false;
+static volatile u32 testIntCount = 0;
+
+void Test_Interrupt(void *arg, bool level)
+{
+    if ((level == true) && (testIntLevel == false))
+    {
+        testIntCount++;
+    }
+    testIntLevel = level;
+    return;
+}
+
+bool test_console(int sock)
+{
+    static AXP_CONSOLE_RING ring;
+    AXP_CONSOLE_PORT *port = NULL;
+    u8 in[3000], out[3000];
+    char *msg = "Console\n";
+    u32 ii;
+    bool retVal = true;
+
+    /*
+     * Move enough through a ring that it wraps, and make sure it does not take
+     * more than it can hold.
+     */
+    printf("...Testing the console port rings...\n");
+    for (ii = 0; ii < sizeof(in); ii++)
+    {
+        in[ii] = (u8) (ii * 7);
+    }
+    for (ii = 0; ((ii < 2) && (retVal == true)); ii++)
+    {
+        retVal = (AXP_Console_Put(&ring, in, sizeof(in)) == sizeof(in)) &&
+                 (AXP_Console_Get(&ring, out, sizeof(out)) == sizeof(out)) &&
+                 (memcmp(in, out, sizeof(in)) == 0);
+    }
+    retVal = retVal &&
+             (AXP_Console_Put(&ring, in, sizeof(in)) == sizeof(in)) &&
+             (AXP_Console_Put(&ring, in, sizeof(in)) ==
+              (AXP_CONSOLE_RING_LEN - sizeof(in))) &&
+             (AXP_Console_Get(&ring, out, 1) == 1) &&
+             (AXP_Console_Put(&ring, in, 2) == 1);
+
+    /*
+     * Connect COM1 to the server.  What is written to the transmit holding
+     * register should get to the client.
+     */
+    if (retVal == true)
+    {
+        printf("...Writing to COM1...\n");
+        AXP_Console_Init(Test_Interrupt, NULL);
+        port = AXP_Console_Port(AXP_CONSOLE_COM1 + AXP_UART_LSR);
+        retVal = (port != NULL) &&
+                 (AXP_Console_Port(AXP_CONSOLE_COM1 + AXP_CONSOLE_REGS) ==
+                  NULL) &&
+                 ((AXP_Console_ReadPort(port, AXP_UART_LSR) &
+                   AXP_UART_LSR_THRE) != 0);
+        for (ii = 0; ((ii < strlen(msg)) && (retVal == true)); ii++)
+        {
+            AXP_Console_WritePort(port, AXP_UART_THR, (u8) msg[ii]);
+        }
+        retVal = retVal && Test_Expect(sock, msg);
+    }
+
+    /*
+     * What the client sends should get to the receive buffer register, with
+     * the interrupt raised until it has all been read.
+     */
+    if (retVal == true)
+    {
+        printf("...Reading from COM1...\n");
+        AXP_Console_WritePort(port, AXP_UART_IER, AXP_UART_IER_RDA);
+        retVal = (testIntLevel == false) && (send(sock, "xy", 2, 0) == 2);
+        for (ii = 0; ((ii < 200) && (testIntLevel == false)); ii++)
+        {
+            usleep(10000);
+        }
+        usleep(10000);
+        retVal = retVal &&
+                 (testIntLevel == true) &&
+                 (testIntCount == 1) &&
+                 (AXP_Console_ReadPort(port, AXP_UART_IIR) ==
+                  AXP_UART_IIR_RDA) &&
+                 (AXP_Console_ReadPort(port, AXP_UART_LSR) &
+                  AXP_UART_LSR_DR) &&
+                 (AXP_Console_ReadPort(port, AXP_UART_RBR) == 'x') &&
+                 (testIntLevel == true) &&
+                 (AXP_Console_ReadPort(port, AXP_UART_RBR) == 'y') &&
+                 (testIntLevel == false) &&
+                 ((AXP_Console_ReadPort(port, AXP_UART_LSR) &
+                   AXP_UART_LSR_DR) == 0);
+    }
+    AXP_Telnet_SetOutput(NULL);
+    return(retVal);
+}
+
+bool test_server(void)
+{
+    pthread_t server;
+    u16 port = 0;
+    int rw, ro;
+    int ii;
+    bool retVal = true;
+
+    AXP_Telnet_SetInput(Test_Input);
+    pthread_create(&server, NULL, Test_Server, NULL);
+    for (ii = 0; ((ii < 200) && (port == 0)); ii++)
+    {
+        usleep(10000);
+        port = AXP_Telnet_Port();
+    }
+
+    /*
+     * Connect two clients.  They should both get our options offered, and
+     * both get the console output.
+     */
+    printf("...Connecting two clients to the server on port %u...\n", port);
+    rw = Test_Connect(port);
+    ro = Test_Connect(port);
+    retVal = (port != 0) && (rw >= 0) && (ro >= 0);
+    if (retVal == true)
+    {
+        usleep(100000);
+        AXP_Telnet_Output((u8 *) "Hello", 5);
+        retVal = Test_Expect(rw, "Hello") && Test_Expect(ro, "Hello");
+    }
+
+    /*
+     * Output sent a byte at a time should all be sent at the end of the line,
+     * and a prompt sent without waiting for the end of a line.
+     */
+    if (retVal == true)
+    {
+        printf("...Sending a line a byte at a time, and a prompt...\n");
+        for (ii = 0; ii < 10; ii++)
+        {
+            AXP_Telnet_Output((u8 *) &"0123456789"[ii], 1);
+        }
+        AXP_Telnet_Output((u8 *) "\n", 1);
+        retVal = Test_Expect(rw, "0123456789\n") &&
+                 Test_Expect(ro, "0123456789\n");
+        AXP_Telnet_Output((u8 *) "P00>>> ", 7);
+        retVal = retVal &&
+                 Test_Expect(rw, "P00>>> ") &&
+                 Test_Expect(ro, "P00>>> ");
+    }
+
+    /*
+     * Only what the first client sends should get to the console, until it
+     * goes away.
+     */
+    if (retVal == true)
+    {
+        printf("...Sending input from the read-write and read-only "
+               "clients...\n");
+        retVal = (send(ro, "r", 1, 0) == 1) && (send(rw, "w", 1, 0) == 1);
+        Test_Wait(1);
+        usleep(100000);
+        retVal = retVal && (testInputLen == 1) && (testInput[0] == 'w');
+    }
+
+    /*
+     * A run of data with a CR NUL in the middle of it should get to the
+     * console without the NUL.
+     */
+    if (retVal == true)
+    {
+        printf("...Sending a run of data from the read-write client...\n");
+        retVal = send(rw, "ab\r\0cd", 6, 0) == 6;
+        Test_Wait(6);
+        retVal = retVal &&
+                 (testInputLen == 6) &&
+                 (memcmp(testInput, "wab\rcd", 6) == 0);
+    }
+    if (retVal == true)
+    {
+        printf("...Closing the read-write client...\n");
+        close(rw);
+        rw = -1;
+        usleep(100000);
+        retVal = send(ro, "o", 1, 0) == 1;
+        Test_Wait(7);
+        retVal = retVal && (testInputLen == 7) && (testInput[6] == 'o');
+    }
+    if (retVal == true)
+    {
+        retVal = test_console(ro);
+    }
+    if (rw >= 0)
+    {
+        close(rw);
+    }
+    if (ro >= 0)
+    {
+        close(ro);
+    }
+    AXP_Telnet_Shutdown();
+    pthread_join(server, NULL);
+    AXP_Telnet_SetInput(NULL);
+    return(retVal);
+}
+
 int main(void)
 {
     bool retVal = true;
@@ -646,7 +950,7 @@ int main(void)
         if (retVal == true)
         {
             printf("\nTesting Telnet Server...\n");
-            AXP_Telnet_Main();
+            retVal = test_server();
         }
     }
     else
@@ -24,6 +24,9 @@
  *  V01.000        10-Jun-2017    Jonathan D. Belanger
  *  Initially written.
  *
+ *  V01.001        19-Oct-2026    Jonathan D. Belanger
+ *  The Icache block now holds a line and set prediction per fetch block.
+ *
  */
 
 /*
@@ -230,7 +233,7 @@ int main()
     PRINT_SIZE(AXP_VA_SPE0, 8, passed);
     PRINT_SIZE(AXP_VA_SPE, 8, passed);
     PRINT_SIZE(AXP_DCACHE_BLK, 64, passed);
-    PRINT_SIZE(AXP_ICACHE_BLK, 72, passed);
+    PRINT_SIZE(AXP_ICACHE_BLK, 80, passed);
     PRINT_SIZE(AXP_CACHE_IDX, 8, passed);
     PRINT_SIZE(AXP_VA_FIELDS, 8, passed);
     PRINT_SIZE(AXP_VA, 8, passed);
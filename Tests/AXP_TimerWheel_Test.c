@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) Jonathan D. Belanger 2026.
+ * All Rights Reserved.
+ *
+ * This software is furnished under a license and may be used and copied only
+ * in accordance with the terms of such license and with the inclusion of the
+ * above copyright notice.  This software or any other copies thereof may not
+ * be provided or otherwise made available to any other person.  No title to
+ * and ownership of the software is hereby transferred.
+ *
+ * The information in this software is subject to change without notice and
+ * should not be construed as a commitment by the author or co-authors.
+ *
+ * The author and any co-authors assume no responsibility for the use or
+ * reliability of this software.
+ *
+ * Description:
+ *
+ *  This module contains the code to test the event timer wheel.
+ *
+ * Revision History:
+ *
+ *  V01.000 19-Oct-2026 Jonathan D. Belanger
+ *  Initially written.
+ *
+ *  V01.001 19-Oct-2026 Jonathan D. Belanger
+ *  Added a test of virtual time.
+ */
+#include "CommonUtilities/AXP_Utility.h"
+#include "CommonUtilities/AXP_TimerWheel.h"
+
+#define TEST_MSEC	1000000ll
+
+/*
+ * The order the one-shot timers were called in, and the calls to the
+ * periodic timers.
+ */
+static char order[8];
+static u32 orderIdx = 0;
+static u32 calls[2];
+static u32 counts[2];
+static u64 firedAt;
+
+/*
+ * Test_Order
+ *  Record the order the one-shot timers are called in.
+ */
+void Test_Order(void *arg, u32 count)
+{
+    u32 idx = __atomic_fetch_add(&orderIdx, 1, __ATOMIC_SEQ_CST);
+
+    if (idx < sizeof(order))
+    {
+        order[idx] = *(char *) arg;
+    }
+    firedAt = AXP_TimerNow();
+    return;
+}
+
+/*
+ * Test_Periodic
+ *  Count the calls to a periodic timer, and the expiries they cover.
+ */
+void Test_Periodic(void *arg, u32 count)
+{
+    u32 which = *(u32 *) arg;
+
+    __atomic_add_fetch(&calls[which], 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&counts[which], count, __ATOMIC_SEQ_CST);
+    return;
+}
+
+/*
+ * test_order
+ *  Timers that expire together are called in the order they were started,
+ *  after those that expire sooner, and a stopped timer is not called.
+ */
+bool test_order(void)
+{
+    static char names[] = "ABCDE";
+    AXP_TIMER timers[5];
+    int ii;
+
+    for (ii = 0; ii < 5; ii++)
+    {
+        AXP_TimerInit(&timers[ii], Test_Order, &names[ii], false);
+    }
+    AXP_TimerStart(&timers[0], 5 * TEST_MSEC, 0);
+    AXP_TimerStart(&timers[1], 5 * TEST_MSEC, 0);
+    AXP_TimerStart(&timers[2], 5 * TEST_MSEC, 0);
+    AXP_TimerStart(&timers[3], 2 * TEST_MSEC, 0);
+    AXP_TimerStart(&timers[4], 3 * TEST_MSEC, 0);
+    AXP_TimerStop(&timers[4]);
+    usleep(50000);
+    printf("    Called in the order %.*s\n", (int) orderIdx, order);
+    return((orderIdx == 4) && (memcmp(order, "DABC", 4) == 0));
+}
+
+/*
+ * test_far
+ *  A timer further out than the first level of the wheel is moved down and
+ *  still fires on time.
+ */
+bool test_far(void)
+{
+    static char name = 'F';
+    AXP_TIMER timer;
+    u64 start, late;
+
+    orderIdx = 0;
+    AXP_TimerInit(&timer, Test_Order, &name, false);
+    start = AXP_TimerNow();
+    AXP_TimerStart(&timer, 2500 * TEST_MSEC, 0);
+    sleep(3);
+    late = firedAt - (start + (2500 * TEST_MSEC));
+    printf("    Fired %llu microseconds late\n", late / 1000);
+    return((orderIdx == 1) && (late < (5 * TEST_MSEC)));
+}
+
+/*
+ * test_periodic
+ *  A 1ms periodic timer is called about 100 times in 100ms.  A coalescing one
+ *  is only called once until it is acknowledged, and then gets a count of
+ *  everything missed.
+ */
+bool test_periodic(void)
+{
+    static u32 which[2] = {0, 1};
+    AXP_TIMER timers[2];
+    bool retVal;
+
+    AXP_TimerInit(&timers[0], Test_Periodic, &which[0], false);
+    AXP_TimerInit(&timers[1], Test_Periodic, &which[1], true);
+    AXP_TimerStart(&timers[0], TEST_MSEC, TEST_MSEC);
+    AXP_TimerStart(&timers[1], TEST_MSEC, TEST_MSEC);
+    usleep(100000);
+    printf("    Periodic: %u calls, coalescing: %u calls\n",
+           calls[0],
+           calls[1]);
+    retVal = (calls[0] >= 90) && (calls[0] <= 110) && (calls[1] == 1);
+    AXP_TimerAck(&timers[1]);
+    usleep(5000);
+    AXP_TimerStop(&timers[0]);
+    AXP_TimerStop(&timers[1]);
+    printf("    After acknowledging: %u calls covering %u expiries\n",
+           calls[1],
+           counts[1]);
+    retVal = retVal &&
+             (calls[1] == 2) &&
+             (counts[1] >= 95) &&
+             (counts[0] >= calls[0]);
+    return(retVal);
+}
+
+/*
+ * test_virtual
+ *  In virtual time, the clock only moves on as instructions are retired, and
+ *  a timer fires when enough have been.  When the CPU is idle, the clock skips
+ *  straight to the next timer, an hour away, and the time of day with it.
+ *  This has to be the last test, as virtual time cannot be turned off.
+ */
+bool test_virtual(void)
+{
+    static char name = 'V';
+    AXP_TIMER timer;
+    u64 start, skipped;
+    time_t tod;
+    bool retVal;
+    int ii;
+
+    orderIdx = 0;
+    AXP_TimerInit(&timer, Test_Order, &name, false);
+    AXP_TimerVirtual(1, 10);
+    start = AXP_TimerNow();
+    tod = AXP_TimerTime();
+    AXP_TimerStart(&timer, TEST_MSEC, 0);
+    usleep(20000);
+    retVal = (AXP_TimerNow() == start) && (orderIdx == 0);
+    for (ii = 0; ii < 99; ii++)
+    {
+        AXP_TimerRetire(1000);
+    }
+    usleep(20000);
+    retVal = retVal && (orderIdx == 0);
+    AXP_TimerRetire(10000);
+    usleep(20000);
+    printf("    Fired after %llu virtual microseconds\n",
+           (firedAt - start) / 1000);
+    retVal = retVal && (orderIdx == 1) && (firedAt >= (start + TEST_MSEC));
+    AXP_TimerStart(&timer, 3600 * AXP_TIMER_NSEC, 0);
+    AXP_TimerIdle(true);
+    for (ii = 0; ((ii < 100) && (orderIdx < 2)); ii++)
+    {
+        usleep(10000);
+    }
+    AXP_TimerIdle(false);
+    skipped = AXP_TimerNow() - start;
+    printf("    Idle skipped %llu virtual seconds in %d milliseconds\n",
+           skipped / AXP_TIMER_NSEC,
+           ii * 10);
+    retVal = retVal &&
+             (orderIdx == 2) &&
+             (skipped >= (3600 * AXP_TIMER_NSEC)) &&
+             ((AXP_TimerTime() - tod) >= 3600);
+    return(retVal);
+}
+
+int main(void)
+{
+    bool retVal;
+
+    printf("\nDECaxp Timer Wheel Testing...\n");
+    printf("\nTesting the order timers are called in...\n");
+    retVal = test_order();
+    if (retVal == true)
+    {
+        printf("\nTesting periodic timers...\n");
+        retVal = test_periodic();
+    }
+    if (retVal == true)
+    {
+        printf("\nTesting a timer on a higher level of the wheel...\n");
+        retVal = test_far();
+    }
+    if (retVal == true)
+    {
+        printf("\nTesting virtual time...\n");
+        retVal = test_virtual();
+    }
+    if (retVal == true)
+    {
+        printf("All Tests Successful!\n");
+    }
+    else
+    {
+        printf("At Least One Test Failed.\n");
+    }
+    return(0);
+}